@@ -83,6 +83,25 @@ macro( marble_add_test TEST_NAME )
     endif( BUILD_MARBLE_TESTS )
 endmacro( marble_add_test TEST_NAME )
 
+macro( marble_add_benchmark BENCHMARK_NAME )
+    if( BUILD_MARBLE_BENCHMARKS )
+        set( ${BENCHMARK_NAME}_SRCS ${BENCHMARK_NAME}.cpp ${ARGN} )
+        qt_generate_moc( ${BENCHMARK_NAME}.cpp ${CMAKE_CURRENT_BINARY_DIR}/${BENCHMARK_NAME}.moc )
+        include_directories( ${CMAKE_CURRENT_BINARY_DIR} )
+        set( ${BENCHMARK_NAME}_SRCS ${CMAKE_CURRENT_BINARY_DIR}/${BENCHMARK_NAME}.moc ${${BENCHMARK_NAME}_SRCS} )
+
+        add_executable( ${BENCHMARK_NAME} ${${BENCHMARK_NAME}_SRCS} )
+        target_link_libraries(${BENCHMARK_NAME}
+            marblewidget
+            Qt5::Test
+        )
+
+        # not added to ctest, benchmarks are run by hand
+        set_target_properties( ${BENCHMARK_NAME} PROPERTIES
+                               COMPILE_FLAGS "-DDATA_PATH=\"\\\"${DATA_PATH}\\\"\" -DPLUGIN_PATH=\"\\\"${PLUGIN_PATH}\\\"\"" )
+    endif( BUILD_MARBLE_BENCHMARKS )
+endmacro( marble_add_benchmark BENCHMARK_NAME )
+
 macro( marble_add_project_resources resources )
   add_custom_target( ${PROJECT_NAME}_Resources ALL SOURCES ${ARGN} )
 endmacro()
@@ -0,0 +1,90 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_BILINEARINTERPOLATION_P_H
+#define MARBLE_BILINEARINTERPOLATION_P_H
+
+#include <QColor>
+
+namespace Marble
+{
+
+/**
+ * Bilinear interpolation of the color at the subpixel position @p x, @p y
+ * of an image of @p width times @p height pixels, whose pixels are read by
+ * @p source.pixel( int x, int y ).  @p topLeftValue is the pixel at the
+ * position truncated to integers, which the caller often knows already.
+ *
+ * This is the scalar code of StackedTile::pixelF().  BilinearSampler uses
+ * it next to the image borders, and its SIMD kernels reproduce it bit by
+ * bit, so the order of the floating point operations must not change.
+ */
+template<class PixelSource>
+inline QRgb bilinearPixel( const PixelSource &source, int width, int height, qreal x, qreal y, QRgb topLeftValue )
+{
+    const int iX = (int)(x);
+    const int iY = (int)(y);
+
+    const qreal fY = y - iY;
+
+    // Interpolation in y-direction
+    if ( iY + 1 < height ) {
+        const QRgb bottomLeftValue = source.pixel( iX, iY + 1 );
+
+        // blending the color values of the top left and bottom left point
+        const qreal ml_red   = ( 1.0 - fY ) * qRed  ( topLeftValue  ) + fY * qRed  ( bottomLeftValue  );
+        const qreal ml_green = ( 1.0 - fY ) * qGreen( topLeftValue  ) + fY * qGreen( bottomLeftValue  );
+        const qreal ml_blue  = ( 1.0 - fY ) * qBlue ( topLeftValue  ) + fY * qBlue ( bottomLeftValue  );
+
+        // Interpolation in x-direction
+        if ( iX + 1 < width ) {
+            const qreal fX = x - iX;
+
+            const QRgb topRightValue    = source.pixel( iX + 1, iY );
+            const QRgb bottomRightValue = source.pixel( iX + 1, iY + 1 );
+
+            // blending the color values of the top right and bottom right point
+            const qreal mr_red   = ( 1.0 - fY ) * qRed  ( topRightValue ) + fY * qRed  ( bottomRightValue );
+            const qreal mr_green = ( 1.0 - fY ) * qGreen( topRightValue ) + fY * qGreen( bottomRightValue );
+            const qreal mr_blue  = ( 1.0 - fY ) * qBlue ( topRightValue ) + fY * qBlue ( bottomRightValue );
+
+            // blending the color values of the resulting middle left
+            // and middle right points
+            const int mm_red   = (int)( ( 1.0 - fX ) * ml_red   + fX * mr_red   );
+            const int mm_green = (int)( ( 1.0 - fX ) * ml_green + fX * mr_green );
+            const int mm_blue  = (int)( ( 1.0 - fX ) * ml_blue  + fX * mr_blue  );
+
+            return qRgb( mm_red, mm_green, mm_blue );
+        }
+
+        return qRgb( ml_red, ml_green, ml_blue );
+    }
+
+    // Interpolation in x-direction
+    if ( iX + 1 < width ) {
+        const qreal fX = x - iX;
+
+        if ( fX == 0.0 )
+            return topLeftValue;
+
+        const QRgb topRightValue = source.pixel( iX + 1, iY );
+
+        // blending the color values of the top left and top right point
+        const int tm_red   = (int)( ( 1.0 - fX ) * qRed  ( topLeftValue ) + fX * qRed  ( topRightValue ) );
+        const int tm_green = (int)( ( 1.0 - fX ) * qGreen( topLeftValue ) + fX * qGreen( topRightValue ) );
+        const int tm_blue  = (int)( ( 1.0 - fX ) * qBlue ( topLeftValue ) + fX * qBlue ( topRightValue ) );
+
+        return qRgb( tm_red, tm_green, tm_blue );
+    }
+
+    return topLeftValue;
+}
+
+}
+
+#endif
@@ -0,0 +1,424 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "BilinearSampler.h"
+
+#include <QImage>
+
+#include "BilinearInterpolation_p.h"
+#include "MarbleDebug.h"
+
+// The SIMD kernels work on double precision lanes and therefore assume
+// that qreal is double, which is the case unless Qt was configured otherwise.
+#if !defined(QT_COORD_TYPE) && ( defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) )
+#  define MARBLE_BILINEAR_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(MARBLE_BILINEAR_SSE2) && defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+// The AVX2 kernel is compiled for the AVX2 target only and is picked at
+// runtime, so the library itself doesn't need to be built with -mavx2.
+#  define MARBLE_BILINEAR_AVX2
+#  define MARBLE_TARGET_AVX2 __attribute__((target("avx2")))
+#  include <immintrin.h>
+#endif
+
+#if !defined(QT_COORD_TYPE) && defined(__aarch64__) && defined(__ARM_NEON)
+// Only AArch64 NEON has double precision lanes, which are needed to
+// reproduce the results of the scalar code bit by bit.
+#  define MARBLE_BILINEAR_NEON
+#  include <arm_neon.h>
+#endif
+
+namespace Marble
+{
+
+namespace
+{
+
+struct Image32
+{
+    explicit Image32( const QImage &image ) :
+        bits( image.constBits() ),
+        bytesPerLine( image.bytesPerLine() ),
+        width( image.width() ),
+        height( image.height() )
+    {}
+
+    QRgb pixel( int x, int y ) const
+    {
+        return reinterpret_cast<const QRgb *>( bits + y * bytesPerLine )[x];
+    }
+
+    bool isInterior( int x, int y ) const
+    {
+        return x >= 0 && y >= 0 && x + 1 < width && y + 1 < height;
+    }
+
+    const uchar *const bits;
+    const int bytesPerLine;
+    const int width;
+    const int height;
+};
+
+void sampleRowScalar( const Image32 &image, const qreal *x, const qreal *y, int count, QRgb *result )
+{
+    for ( int i = 0; i < count; ++i ) {
+        const QRgb topLeftValue = image.pixel( (int)( x[i] ), (int)( y[i] ) );
+        result[i] = bilinearPixel( image, image.width, image.height, x[i], y[i], topLeftValue );
+    }
+}
+
+#ifdef MARBLE_BILINEAR_SSE2
+
+// Blends one color channel of two pixels.
+template<int Shift>
+inline __m128i blendChannelSse2( __m128i topLeft, __m128i topRight, __m128i bottomLeft, __m128i bottomRight,
+                                 __m128d fX, __m128d gX, __m128d fY, __m128d gY )
+{
+    const __m128i mask = _mm_set1_epi32( 0xff );
+    const __m128d tl = _mm_cvtepi32_pd( _mm_and_si128( _mm_srli_epi32( topLeft, Shift ), mask ) );
+    const __m128d tr = _mm_cvtepi32_pd( _mm_and_si128( _mm_srli_epi32( topRight, Shift ), mask ) );
+    const __m128d bl = _mm_cvtepi32_pd( _mm_and_si128( _mm_srli_epi32( bottomLeft, Shift ), mask ) );
+    const __m128d br = _mm_cvtepi32_pd( _mm_and_si128( _mm_srli_epi32( bottomRight, Shift ), mask ) );
+
+    const __m128d left  = _mm_add_pd( _mm_mul_pd( gY, tl ), _mm_mul_pd( fY, bl ) );
+    const __m128d right = _mm_add_pd( _mm_mul_pd( gY, tr ), _mm_mul_pd( fY, br ) );
+    const __m128d value = _mm_add_pd( _mm_mul_pd( gX, left ), _mm_mul_pd( fX, right ) );
+
+    return _mm_slli_epi32( _mm_and_si128( _mm_cvttpd_epi32( value ), mask ), Shift );
+}
+
+// Samples two interior pixels.
+inline void samplePairSse2( const Image32 &image, const qreal *x, const qreal *y, QRgb *result )
+{
+    const __m128d one = _mm_set1_pd( 1.0 );
+
+    const __m128d xs = _mm_loadu_pd( x );
+    const __m128d ys = _mm_loadu_pd( y );
+    const __m128i ix = _mm_cvttpd_epi32( xs );
+    const __m128i iy = _mm_cvttpd_epi32( ys );
+
+    const __m128d fX = _mm_sub_pd( xs, _mm_cvtepi32_pd( ix ) );
+    const __m128d fY = _mm_sub_pd( ys, _mm_cvtepi32_pd( iy ) );
+    const __m128d gX = _mm_sub_pd( one, fX );
+    const __m128d gY = _mm_sub_pd( one, fY );
+
+    // SSE2 has no gather, so the texels are fetched one by one.
+    const int x0 = (int)( x[0] );
+    const int y0 = (int)( y[0] );
+    const int x1 = (int)( x[1] );
+    const int y1 = (int)( y[1] );
+
+    const __m128i topLeft     = _mm_set_epi32( 0, 0, image.pixel( x1,     y1     ), image.pixel( x0,     y0     ) );
+    const __m128i topRight    = _mm_set_epi32( 0, 0, image.pixel( x1 + 1, y1     ), image.pixel( x0 + 1, y0     ) );
+    const __m128i bottomLeft  = _mm_set_epi32( 0, 0, image.pixel( x1,     y1 + 1 ), image.pixel( x0,     y0 + 1 ) );
+    const __m128i bottomRight = _mm_set_epi32( 0, 0, image.pixel( x1 + 1, y1 + 1 ), image.pixel( x0 + 1, y0 + 1 ) );
+
+    __m128i rgb = _mm_set1_epi32( (int)0xff000000 );
+    rgb = _mm_or_si128( rgb, blendChannelSse2<16>( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+    rgb = _mm_or_si128( rgb, blendChannelSse2<8> ( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+    rgb = _mm_or_si128( rgb, blendChannelSse2<0> ( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+
+    _mm_storel_epi64( reinterpret_cast<__m128i *>( result ), rgb );
+}
+
+void sampleRowSse2( const Image32 &image, const qreal *x, const qreal *y, int count, QRgb *result )
+{
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        bool interior = true;
+        for ( int k = i; k < i + 4; ++k ) {
+            interior = interior && image.isInterior( (int)( x[k] ), (int)( y[k] ) );
+        }
+
+        if ( !interior ) {
+            sampleRowScalar( image, x + i, y + i, 4, result + i );
+            continue;
+        }
+
+        samplePairSse2( image, x + i,     y + i,     result + i     );
+        samplePairSse2( image, x + i + 2, y + i + 2, result + i + 2 );
+    }
+
+    sampleRowScalar( image, x + i, y + i, count - i, result + i );
+}
+
+#endif
+
+#ifdef MARBLE_BILINEAR_AVX2
+
+// Blends one color channel of four pixels.
+template<int Shift>
+MARBLE_TARGET_AVX2
+inline __m128i blendChannelAvx2( __m128i topLeft, __m128i topRight, __m128i bottomLeft, __m128i bottomRight,
+                                 __m256d fX, __m256d gX, __m256d fY, __m256d gY )
+{
+    const __m128i mask = _mm_set1_epi32( 0xff );
+    const __m256d tl = _mm256_cvtepi32_pd( _mm_and_si128( _mm_srli_epi32( topLeft, Shift ), mask ) );
+    const __m256d tr = _mm256_cvtepi32_pd( _mm_and_si128( _mm_srli_epi32( topRight, Shift ), mask ) );
+    const __m256d bl = _mm256_cvtepi32_pd( _mm_and_si128( _mm_srli_epi32( bottomLeft, Shift ), mask ) );
+    const __m256d br = _mm256_cvtepi32_pd( _mm_and_si128( _mm_srli_epi32( bottomRight, Shift ), mask ) );
+
+    // Multiplications and additions are kept separate on purpose: a fused
+    // multiply-add would round differently than the scalar code.
+    const __m256d left  = _mm256_add_pd( _mm256_mul_pd( gY, tl ), _mm256_mul_pd( fY, bl ) );
+    const __m256d right = _mm256_add_pd( _mm256_mul_pd( gY, tr ), _mm256_mul_pd( fY, br ) );
+    const __m256d value = _mm256_add_pd( _mm256_mul_pd( gX, left ), _mm256_mul_pd( fX, right ) );
+
+    return _mm_slli_epi32( _mm_and_si128( _mm256_cvttpd_epi32( value ), mask ), Shift );
+}
+
+MARBLE_TARGET_AVX2
+void sampleRowAvx2( const Image32 &image, const qreal *x, const qreal *y, int count, QRgb *result )
+{
+    const int *const base = reinterpret_cast<const int *>( image.bits );
+    const __m128i stride = _mm_set1_epi32( image.bytesPerLine / 4 );
+    const __m128i minusOne = _mm_set1_epi32( -1 );
+    const __m128i lastX = _mm_set1_epi32( image.width - 1 );
+    const __m128i lastY = _mm_set1_epi32( image.height - 1 );
+    const __m128i alpha = _mm_set1_epi32( (int)0xff000000 );
+    const __m256d one = _mm256_set1_pd( 1.0 );
+
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        const __m256d xs = _mm256_loadu_pd( x + i );
+        const __m256d ys = _mm256_loadu_pd( y + i );
+        const __m128i ix = _mm256_cvttpd_epi32( xs );
+        const __m128i iy = _mm256_cvttpd_epi32( ys );
+
+        const __m128i interior = _mm_and_si128(
+                    _mm_and_si128( _mm_cmpgt_epi32( ix, minusOne ), _mm_cmplt_epi32( ix, lastX ) ),
+                    _mm_and_si128( _mm_cmpgt_epi32( iy, minusOne ), _mm_cmplt_epi32( iy, lastY ) ) );
+
+        if ( _mm_movemask_epi8( interior ) != 0xffff ) {
+            sampleRowScalar( image, x + i, y + i, 4, result + i );
+            continue;
+        }
+
+        const __m256d fX = _mm256_sub_pd( xs, _mm256_cvtepi32_pd( ix ) );
+        const __m256d fY = _mm256_sub_pd( ys, _mm256_cvtepi32_pd( iy ) );
+        const __m256d gX = _mm256_sub_pd( one, fX );
+        const __m256d gY = _mm256_sub_pd( one, fY );
+
+        const __m128i topIndex    = _mm_add_epi32( _mm_mullo_epi32( iy, stride ), ix );
+        const __m128i bottomIndex = _mm_add_epi32( topIndex, stride );
+
+        const __m128i topLeft     = _mm_i32gather_epi32( base,     topIndex,    4 );
+        const __m128i topRight    = _mm_i32gather_epi32( base + 1, topIndex,    4 );
+        const __m128i bottomLeft  = _mm_i32gather_epi32( base,     bottomIndex, 4 );
+        const __m128i bottomRight = _mm_i32gather_epi32( base + 1, bottomIndex, 4 );
+
+        __m128i rgb = alpha;
+        rgb = _mm_or_si128( rgb, blendChannelAvx2<16>( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+        rgb = _mm_or_si128( rgb, blendChannelAvx2<8> ( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+        rgb = _mm_or_si128( rgb, blendChannelAvx2<0> ( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( result + i ), rgb );
+    }
+
+    sampleRowScalar( image, x + i, y + i, count - i, result + i );
+}
+
+bool cpuSupportsAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+}
+
+#endif
+
+#ifdef MARBLE_BILINEAR_NEON
+
+// Blends one color channel of two pixels.
+template<int Shift>
+inline uint32x2_t blendChannelNeon( uint32x2_t topLeft, uint32x2_t topRight, uint32x2_t bottomLeft, uint32x2_t bottomRight,
+                                    float64x2_t fX, float64x2_t gX, float64x2_t fY, float64x2_t gY )
+{
+    const uint32x2_t mask = vdup_n_u32( 0xff );
+    const float64x2_t tl = vcvtq_f64_u64( vmovl_u32( vand_u32( vshr_n_u32( topLeft, Shift ), mask ) ) );
+    const float64x2_t tr = vcvtq_f64_u64( vmovl_u32( vand_u32( vshr_n_u32( topRight, Shift ), mask ) ) );
+    const float64x2_t bl = vcvtq_f64_u64( vmovl_u32( vand_u32( vshr_n_u32( bottomLeft, Shift ), mask ) ) );
+    const float64x2_t br = vcvtq_f64_u64( vmovl_u32( vand_u32( vshr_n_u32( bottomRight, Shift ), mask ) ) );
+
+    const float64x2_t left  = vaddq_f64( vmulq_f64( gY, tl ), vmulq_f64( fY, bl ) );
+    const float64x2_t right = vaddq_f64( vmulq_f64( gY, tr ), vmulq_f64( fY, br ) );
+    const float64x2_t value = vaddq_f64( vmulq_f64( gX, left ), vmulq_f64( fX, right ) );
+
+    return vshl_n_u32( vand_u32( vmovn_u64( vcvtq_u64_f64( value ) ), mask ), Shift );
+}
+
+// Samples two interior pixels.
+inline void samplePairNeon( const Image32 &image, const qreal *x, const qreal *y, QRgb *result )
+{
+    const float64x2_t one = vdupq_n_f64( 1.0 );
+
+    const float64x2_t xs = vld1q_f64( x );
+    const float64x2_t ys = vld1q_f64( y );
+
+    const int x0 = (int)( x[0] );
+    const int y0 = (int)( y[0] );
+    const int x1 = (int)( x[1] );
+    const int y1 = (int)( y[1] );
+
+    const float64x2_t fX = vsubq_f64( xs, vcombine_f64( vdup_n_f64( x0 ), vdup_n_f64( x1 ) ) );
+    const float64x2_t fY = vsubq_f64( ys, vcombine_f64( vdup_n_f64( y0 ), vdup_n_f64( y1 ) ) );
+    const float64x2_t gX = vsubq_f64( one, fX );
+    const float64x2_t gY = vsubq_f64( one, fY );
+
+    const uint32_t tl[2] = { image.pixel( x0,     y0     ), image.pixel( x1,     y1     ) };
+    const uint32_t tr[2] = { image.pixel( x0 + 1, y0     ), image.pixel( x1 + 1, y1     ) };
+    const uint32_t bl[2] = { image.pixel( x0,     y0 + 1 ), image.pixel( x1,     y1 + 1 ) };
+    const uint32_t br[2] = { image.pixel( x0 + 1, y0 + 1 ), image.pixel( x1 + 1, y1 + 1 ) };
+
+    const uint32x2_t topLeft     = vld1_u32( tl );
+    const uint32x2_t topRight    = vld1_u32( tr );
+    const uint32x2_t bottomLeft  = vld1_u32( bl );
+    const uint32x2_t bottomRight = vld1_u32( br );
+
+    uint32x2_t rgb = vdup_n_u32( 0xff000000 );
+    rgb = vorr_u32( rgb, blendChannelNeon<16>( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+    rgb = vorr_u32( rgb, blendChannelNeon<8> ( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+    rgb = vorr_u32( rgb, blendChannelNeon<0> ( topLeft, topRight, bottomLeft, bottomRight, fX, gX, fY, gY ) );
+
+    vst1_u32( result, rgb );
+}
+
+void sampleRowNeon( const Image32 &image, const qreal *x, const qreal *y, int count, QRgb *result )
+{
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        bool interior = true;
+        for ( int k = i; k < i + 4; ++k ) {
+            interior = interior && image.isInterior( (int)( x[k] ), (int)( y[k] ) );
+        }
+
+        if ( !interior ) {
+            sampleRowScalar( image, x + i, y + i, 4, result + i );
+            continue;
+        }
+
+        samplePairNeon( image, x + i,     y + i,     result + i     );
+        samplePairNeon( image, x + i + 2, y + i + 2, result + i + 2 );
+    }
+
+    sampleRowScalar( image, x + i, y + i, count - i, result + i );
+}
+
+#endif
+
+BilinearSampler::Implementation detectBestImplementation()
+{
+#ifdef MARBLE_BILINEAR_AVX2
+    if ( cpuSupportsAvx2() ) {
+        return BilinearSampler::Avx2;
+    }
+#endif
+#ifdef MARBLE_BILINEAR_SSE2
+    return BilinearSampler::Sse2;
+#elif defined(MARBLE_BILINEAR_NEON)
+    return BilinearSampler::Neon;
+#else
+    return BilinearSampler::Scalar;
+#endif
+}
+
+BilinearSampler::Implementation &currentImplementation()
+{
+    static BilinearSampler::Implementation implementation = BilinearSampler::bestImplementation();
+    return implementation;
+}
+
+}
+
+bool BilinearSampler::isSupported( Implementation implementation )
+{
+    switch ( implementation ) {
+    case Scalar:
+        return true;
+    case Sse2:
+#ifdef MARBLE_BILINEAR_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case Avx2:
+#ifdef MARBLE_BILINEAR_AVX2
+        return cpuSupportsAvx2();
+#else
+        return false;
+#endif
+    case Neon:
+#ifdef MARBLE_BILINEAR_NEON
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+BilinearSampler::Implementation BilinearSampler::bestImplementation()
+{
+    static const Implementation best = detectBestImplementation();
+    return best;
+}
+
+BilinearSampler::Implementation BilinearSampler::implementation()
+{
+    return currentImplementation();
+}
+
+bool BilinearSampler::setImplementation( Implementation implementation )
+{
+    if ( !isSupported( implementation ) ) {
+        mDebug() << "Bilinear sampler implementation" << implementation << "is not supported on this CPU";
+        return false;
+    }
+
+    currentImplementation() = implementation;
+    return true;
+}
+
+void BilinearSampler::sample( const QImage &image, const qreal *x, const qreal *y, int count, QRgb *result )
+{
+    sample( currentImplementation(), image, x, y, count, result );
+}
+
+void BilinearSampler::sample( Implementation implementation,
+                              const QImage &image, const qreal *x, const qreal *y, int count, QRgb *result )
+{
+    Q_ASSERT( image.depth() == 32 );
+    Q_ASSERT( isSupported( implementation ) );
+
+    const Image32 image32( image );
+
+    switch ( implementation ) {
+#ifdef MARBLE_BILINEAR_AVX2
+    case Avx2:
+        sampleRowAvx2( image32, x, y, count, result );
+        return;
+#endif
+#ifdef MARBLE_BILINEAR_SSE2
+    case Sse2:
+        sampleRowSse2( image32, x, y, count, result );
+        return;
+#endif
+#ifdef MARBLE_BILINEAR_NEON
+    case Neon:
+        sampleRowNeon( image32, x, y, count, result );
+        return;
+#endif
+    default:
+        sampleRowScalar( image32, x, y, count, result );
+        return;
+    }
+}
+
+}
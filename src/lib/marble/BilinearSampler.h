@@ -0,0 +1,82 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_BILINEARSAMPLER_H
+#define MARBLE_BILINEARSAMPLER_H
+
+#include "marble_export.h"
+
+#include <QColor>
+
+class QImage;
+
+namespace Marble
+{
+
+/**
+ * @short Bilinear sampling of many subpixel positions of a 32 bit image at once.
+ *
+ * The sampler computes exactly the same color values as
+ * StackedTile::pixelF() does for 32 bit images, but processes
+ * several positions per iteration using SIMD instructions when the
+ * CPU supports them.  The implementation is chosen at runtime, the
+ * scalar implementation is always available as a fallback.
+ *
+ * Positions next to the right or bottom image border are handled by the
+ * scalar code, so callers may pass any position inside the image.
+ */
+class MARBLE_EXPORT BilinearSampler
+{
+public:
+    enum Implementation {
+        Scalar,
+        Sse2,
+        Avx2,
+        Neon
+    };
+
+    /**
+     * Returns whether @p implementation was compiled in and is supported by the CPU.
+     */
+    static bool isSupported( Implementation implementation );
+
+    /**
+     * Returns the fastest implementation supported by the CPU.
+     */
+    static Implementation bestImplementation();
+
+    /**
+     * Returns the implementation used by sample().
+     */
+    static Implementation implementation();
+
+    /**
+     * Overrides the implementation used by sample(), e.g. for benchmarking.
+     * Returns false and keeps the current implementation if @p implementation
+     * is not supported.
+     */
+    static bool setImplementation( Implementation implementation );
+
+    /**
+     * Samples @p image at the @p count positions given by @p x and @p y and
+     * writes the interpolated colors to @p result.
+     *
+     * @p image must have a depth of 32 bits.
+     */
+    static void sample( const QImage &image, const qreal *x, const qreal *y, int count, QRgb *result );
+
+    /**
+     * Same as above, using the given @p implementation, which must be supported.
+     */
+    static void sample( Implementation implementation,
+                        const QImage &image, const qreal *x, const qreal *y, int count, QRgb *result );
+};
+
+}
+
+#endif
@@ -14,55 +14,81 @@
 
 // Qt
 #include <QtGlobal>
-#include <QFile>
 #include <QDirIterator>
 #include <QDataStream>
+#include <QMap>
+#include <QPair>
+#include <QSaveFile>
+#include <QVector>
+
+// Std
+#include <algorithm>
 
 using namespace Marble;
 
+// Journal records, each one starts with the operation
+static const char JournalInsert = 'I'; // key, last access, size
+static const char JournalRemove = 'R'; // key
+
+// Time cache hits are collected before they go to the journal
+static const qint64 accessJournalInterval = 5000; // ms
+
 static QString indexFileName( const QString &cacheDirectory )
 {
     return cacheDirectory + QLatin1String("/cache_index.idx");
 }
 
-DiscCache::DiscCache( const QString &cacheDirectory )
-    : m_CacheDirectory( cacheDirectory ),
-      m_CacheLimit( 300 * 1024 * 1024 ),
-      m_CurrentCacheSize( 0 )
+static QString journalFileName( const QString &cacheDirectory )
 {
-    Q_ASSERT( !m_CacheDirectory.isEmpty() && "Passed empty cache directory!" );
+    return cacheDirectory + QLatin1String("/cache_index.journal");
+}
 
-    QFile file( indexFileName( m_CacheDirectory ) );
+static QByteArray insertRecord( const QString &key, const QDateTime &lastAccess, quint64 size )
+{
+    QByteArray record;
+    QDataStream s( &record, QIODevice::WriteOnly );
+    s.setVersion( 8 );
+    s << qint8( JournalInsert ) << key << lastAccess << size;
 
-    if ( file.exists() ) {
-        if ( file.open( QIODevice::ReadOnly ) ) {
-            QDataStream s( &file );
-            s.setVersion( 8 );
+    return record;
+}
 
-            s >> m_CacheLimit;
-            s >> m_CurrentCacheSize;
-            s >> m_Entries;
+static QByteArray removeRecord( const QString &key )
+{
+    QByteArray record;
+    QDataStream s( &record, QIODevice::WriteOnly );
+    s.setVersion( 8 );
+    s << qint8( JournalRemove ) << key;
 
-        } else {
-            qWarning( "Unable to open cache directory %s", qPrintable( m_CacheDirectory ) );
-        }
-    }
+    return record;
 }
 
-DiscCache::~DiscCache()
+static bool olderThan( const QPair<QDateTime, QString> &a, const QPair<QDateTime, QString> &b )
 {
-    QFile file( indexFileName( m_CacheDirectory ) );
+    return a.first < b.first;
+}
 
-    if ( file.open( QIODevice::WriteOnly ) ) {
-        QDataStream s( &file );
-        s.setVersion( 8 );
+DiscCache::DiscCache( const QString &cacheDirectory )
+    : m_CacheDirectory( cacheDirectory ),
+      m_CacheLimit( 300 * 1024 * 1024 ),
+      m_CurrentCacheSize( 0 ),
+      m_Oldest( 0 ),
+      m_Newest( 0 ),
+      m_Journal( journalFileName( cacheDirectory ) ),
+      m_JournalRecords( 0 )
+{
+    Q_ASSERT( !m_CacheDirectory.isEmpty() && "Passed empty cache directory!" );
 
-        s << m_CacheLimit;
-        s << m_CurrentCacheSize;
-        s << m_Entries;
-    }
+    m_AccessTimer.start();
+    readIndex();
+    replayJournal();
+}
+
+DiscCache::~DiscCache()
+{
+    writeIndex();
 
-    file.close();
+    qDeleteAll( m_Entries );
 }
 
 quint64 DiscCache::cacheLimit() const
@@ -72,23 +98,31 @@ quint64 DiscCache::cacheLimit() const
 
 void DiscCache::clear()
 {
-    QDirIterator it( m_CacheDirectory );
+    const QString indexFile = indexFileName( m_CacheDirectory );
+    const QString journalFile = journalFileName( m_CacheDirectory );
+
+    QDirIterator it( m_CacheDirectory, QDir::Files );
 
     // Remove all files from cache directory
     while ( it.hasNext() ) {
-        it.next();
+        const QString filePath = it.next();
 
-        if ( it.fileName() == indexFileName( m_CacheDirectory ) ) // skip index file
+        if ( filePath == indexFile || filePath == journalFile ) // skip index files
             continue;
 
-        QFile::remove( it.fileName() );
+        QFile::remove( filePath );
     }
 
     // Delete entries
+    qDeleteAll( m_Entries );
     m_Entries.clear();
+    m_Oldest = 0;
+    m_Newest = 0;
 
     // Reset current cache size
     m_CurrentCacheSize = 0;
+
+    writeIndex();
 }
 
 bool DiscCache::exists( const QString &key ) const
@@ -99,7 +133,8 @@ bool DiscCache::exists( const QString &key ) const
 bool DiscCache::find( const QString &key, QByteArray &data )
 {
     // Return error if we don't know this key
-    if ( !m_Entries.contains( key ) )
+    Entry *const entry = m_Entries.value( key, 0 );
+    if ( !entry )
         return false;
 
     // If we can open the file, load all data and update access timestamp
@@ -107,7 +142,16 @@ bool DiscCache::find( const QString &key, QByteArray &data )
     if ( file.open( QIODevice::ReadOnly ) ) {
         data = file.readAll();
 
-        m_Entries[ key ].first = QDateTime::currentDateTime();
+        entry->lastAccess = QDateTime::currentDateTime();
+        unlink( entry );
+        linkAsMostRecent( entry );
+
+        // Losing the latest accesses in a crash only affects which tiles get
+        // evicted first, so they don't need a write on each hit.
+        m_AccessedKeys.insert( key );
+        if ( m_AccessTimer.hasExpired( accessJournalInterval ) )
+            appendToJournal( QByteArray(), 0 );
+
         return true;
     }
 
@@ -121,18 +165,13 @@ bool DiscCache::insert( const QString &key, const QByteArray &data )
     if ( !file.open( QIODevice::WriteOnly ) )
         return false;
 
-    // If we overwrite an existing entry, subtract the size first
-    if ( m_Entries.contains( key ) )
-        m_CurrentCacheSize -= m_Entries.value( key ).second;
-
     // Store the data on disc
     file.write( data );
 
     // Create/Overwrite with a new entry
-    m_Entries.insert( key, QPair<QDateTime, quint64>(QDateTime::currentDateTime(), data.length()) );
-
-    // Add the size of the new entry
-    m_CurrentCacheSize += data.length();
+    const QDateTime now = QDateTime::currentDateTime();
+    addEntry( key, now, data.length() );
+    appendToJournal( insertRecord( key, now, data.length() ) );
 
     cleanup();
 
@@ -142,19 +181,18 @@ bool DiscCache::insert( const QString &key, const QByteArray &data )
 void DiscCache::remove( const QString &key )
 {
     // Do nothing if we don't know the key
-    if ( !m_Entries.contains( key ) )
+    Entry *const entry = m_Entries.value( key, 0 );
+    if ( !entry )
         return;
 
     // If we can't remove the file we don't remove
     // the entry to prevent inconsistency
-    if ( !QFile::remove( keyToFileName( key ) ) )
+    const QString fileName = keyToFileName( key );
+    if ( !QFile::remove( fileName ) && QFile::exists( fileName ) )
         return;
 
-    // Subtract from current size
-    m_CurrentCacheSize -= m_Entries.value( key ).second;
-
-    // Finally remove entry
-    m_Entries.remove( key );
+    removeEntry( entry );
+    appendToJournal( removeRecord( key ) );
 }
 
 void DiscCache::setCacheLimit( quint64 n )
@@ -164,6 +202,16 @@ void DiscCache::setCacheLimit( quint64 n )
     cleanup();
 }
 
+int DiscCache::count() const
+{
+    return m_Entries.size();
+}
+
+quint64 DiscCache::size() const
+{
+    return m_CurrentCacheSize;
+}
+
 QString DiscCache::keyToFileName( const QString &key ) const
 {
     QString fileName( key );
@@ -175,26 +223,251 @@ QString DiscCache::keyToFileName( const QString &key ) const
 void DiscCache::cleanup()
 {
     // Calculate 5% of our current cache limit
-    quint64 fivePercent = quint64( m_CacheLimit * 0.05 );
+    const quint64 fivePercent = quint64( m_CacheLimit * 0.05 );
 
-    while ( m_CurrentCacheSize > (m_CacheLimit - fivePercent) ) {
-        QDateTime oldestDate( QDateTime::currentDateTime() );
-        QString oldestKey;
+    if ( m_CurrentCacheSize <= m_CacheLimit - fivePercent )
+        return;
+
+    // Evict the least recently used entries in one go until we are 5% below the
+    // limit, so we don't have to do this again on each of the next inserts.
+    // Their records go to the journal in a single write.
+    QByteArray records;
+    int recordCount = 0;
+    Entry *entry = m_Oldest;
+    while ( entry && m_CurrentCacheSize > m_CacheLimit - fivePercent ) {
+        Entry *const next = entry->next;
+
+        const QString fileName = keyToFileName( entry->key );
+        if ( QFile::remove( fileName ) || !QFile::exists( fileName ) ) {
+            records += removeRecord( entry->key );
+            ++recordCount;
+            removeEntry( entry );
+        }
 
-        QMapIterator<QString, QPair<QDateTime, quint64> > it( m_Entries );
-        while ( it.hasNext() ) {
-            it.next();
+        entry = next;
+    }
+
+    if ( recordCount > 0 )
+        appendToJournal( records, recordCount );
+}
+
+DiscCache::Entry *DiscCache::addEntry( const QString &key, const QDateTime &lastAccess, quint64 size )
+{
+    Entry *entry = m_Entries.value( key, 0 );
+
+    if ( entry ) {
+        // If we overwrite an existing entry, subtract the size first
+        m_CurrentCacheSize -= entry->size;
+        unlink( entry );
+    } else {
+        entry = new Entry;
+        entry->key = key;
+        m_Entries.insert( key, entry );
+    }
+
+    entry->lastAccess = lastAccess;
+    entry->size = size;
+    linkAsMostRecent( entry );
+
+    // Add the size of the new entry
+    m_CurrentCacheSize += size;
+
+    return entry;
+}
+
+void DiscCache::removeEntry( Entry *entry )
+{
+    // Subtract from current size
+    m_CurrentCacheSize -= entry->size;
+
+    unlink( entry );
+    m_Entries.remove( entry->key );
+    delete entry;
+}
 
-            if ( it.value().first < oldestDate ) {
-                oldestDate = it.value().first;
-                oldestKey = it.key();
+void DiscCache::unlink( Entry *entry )
+{
+    if ( entry->previous ) {
+        entry->previous->next = entry->next;
+    } else {
+        m_Oldest = entry->next;
+    }
+
+    if ( entry->next ) {
+        entry->next->previous = entry->previous;
+    } else {
+        m_Newest = entry->previous;
+    }
+
+    entry->previous = 0;
+    entry->next = 0;
+}
+
+void DiscCache::linkAsMostRecent( Entry *entry )
+{
+    entry->previous = m_Newest;
+    entry->next = 0;
+
+    if ( m_Newest ) {
+        m_Newest->next = entry;
+    } else {
+        m_Oldest = entry;
+    }
+
+    m_Newest = entry;
+}
+
+void DiscCache::readIndex()
+{
+    QFile file( indexFileName( m_CacheDirectory ) );
+
+    if ( !file.exists() )
+        return;
+
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        qWarning( "Unable to open cache directory %s", qPrintable( m_CacheDirectory ) );
+        return;
+    }
+
+    QDataStream s( &file );
+    s.setVersion( 8 );
+
+    quint64 currentCacheSize;
+    QMap<QString, QPair<QDateTime, quint64> > entries;
+    s >> m_CacheLimit;
+    s >> currentCacheSize;
+    s >> entries;
+
+    // The snapshot doesn't store the access order, so restore it from the timestamps
+    QVector<QPair<QDateTime, QString> > byAge;
+    byAge.reserve( entries.size() );
+    QMap<QString, QPair<QDateTime, quint64> >::const_iterator it = entries.constBegin();
+    QMap<QString, QPair<QDateTime, quint64> >::const_iterator const end = entries.constEnd();
+    for (; it != end; ++it ) {
+        byAge.append( qMakePair( it.value().first, it.key() ) );
+    }
+    std::stable_sort( byAge.begin(), byAge.end(), olderThan );
+
+    m_Entries.reserve( byAge.size() );
+    for ( const QPair<QDateTime, QString> &item: byAge ) {
+        addEntry( item.second, item.first, entries.value( item.second ).second );
+    }
+}
+
+void DiscCache::replayJournal()
+{
+    if ( !m_Journal.exists() )
+        return;
+
+    if ( !m_Journal.open( QIODevice::ReadOnly ) ) {
+        qWarning( "Unable to read cache journal in %s", qPrintable( m_CacheDirectory ) );
+        return;
+    }
+
+    QDataStream s( &m_Journal );
+    s.setVersion( 8 );
+
+    while ( !s.atEnd() ) {
+        qint8 operation;
+        QString key;
+        s >> operation >> key;
+
+        if ( operation == JournalInsert ) {
+            QDateTime lastAccess;
+            quint64 size;
+            s >> lastAccess >> size;
+            if ( s.status() != QDataStream::Ok )
+                break;
+            addEntry( key, lastAccess, size );
+        } else if ( operation == JournalRemove ) {
+            if ( s.status() != QDataStream::Ok )
+                break;
+            Entry *const entry = m_Entries.value( key, 0 );
+            if ( entry ) {
+                removeEntry( entry );
             }
+        } else {
+            // the last record got truncated by a crash
+            break;
         }
+    }
 
-        if ( !oldestKey.isEmpty() ) {
-            // We found the oldest key, so using remove() to
-            // remove it from cache
-            remove( oldestKey );
-        }
+    m_Journal.close();
+
+    // Fold the journal into a fresh snapshot, this also gets rid of a
+    // truncated record which would otherwise corrupt the next appends.
+    writeIndex();
+}
+
+void DiscCache::writeIndex()
+{
+    QMap<QString, QPair<QDateTime, quint64> > entries;
+    for ( const Entry *entry = m_Oldest; entry; entry = entry->next ) {
+        entries.insert( entry->key, qMakePair( entry->lastAccess, entry->size ) );
+    }
+
+    // The snapshot replaces the old one only once it is complete, so a crash
+    // while writing it leaves the old snapshot and the journal in place.
+    QSaveFile file( indexFileName( m_CacheDirectory ) );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return;
+
+    QDataStream s( &file );
+    s.setVersion( 8 );
+
+    s << m_CacheLimit;
+    s << m_CurrentCacheSize;
+    s << entries;
+
+    if ( s.status() != QDataStream::Ok || !file.commit() )
+        return;
+
+    // Only drop the journal once the snapshot is in place
+    m_Journal.close();
+    m_Journal.remove();
+    m_JournalRecords = 0;
+
+    // the snapshot holds the access times already
+    m_AccessedKeys.clear();
+    m_AccessTimer.restart();
+}
+
+void DiscCache::appendToJournal( const QByteArray &records, int recordCount )
+{
+    if ( !m_Journal.isOpen() && !m_Journal.open( QIODevice::WriteOnly | QIODevice::Append ) )
+        return;
+
+    // The collected cache hits go first, so the journal keeps the access order.
+    // Since any other record writes them, they are the most recent entries.
+    int accessed = 0;
+    for ( const QString &key: m_AccessedKeys ) {
+        if ( m_Entries.contains( key ) )
+            ++accessed;
     }
+
+    QVector<const Entry *> entries;
+    entries.reserve( accessed );
+    for ( const Entry *entry = m_Newest; entry && entries.size() < accessed; entry = entry->previous ) {
+        if ( m_AccessedKeys.contains( entry->key ) )
+            entries.append( entry );
+    }
+
+    QByteArray data;
+    for ( int i = entries.size() - 1; i >= 0; --i ) {
+        data += insertRecord( entries[i]->key, entries[i]->lastAccess, entries[i]->size );
+    }
+    m_JournalRecords += entries.size();
+    m_AccessedKeys.clear();
+    m_AccessTimer.restart();
+
+    data += records;
+    m_JournalRecords += recordCount;
+
+    m_Journal.write( data );
+    m_Journal.flush();
+
+    // Keep the journal from growing without bounds, e.g. by endless panning
+    // around in a cache that is already full.
+    if ( m_JournalRecords > qMax( 10000, 2 * m_Entries.size() ) )
+        writeIndex();
 }
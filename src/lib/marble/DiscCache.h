@@ -12,16 +12,34 @@
 #define MARBLE_DISCCACHE_H
 
 #include <QDateTime>
-#include <QMap>
-#include <QPair>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QSet>
 #include <QString>
 
+#include "marble_export.h"
+
 class QByteArray;
 
 namespace Marble
 {
 
-class DiscCache
+/**
+ * @short A size limited cache of files on disc with least recently used eviction.
+ *
+ * The entries are kept in a hash for lookups and in an intrusive list
+ * ordered by last access for eviction, so both are O(1).  Once the cache
+ * grows over its limit, the least recently used entries are removed until
+ * it is 5% below the limit again.
+ *
+ * The index is written to disc as a snapshot in the destructor.  Every
+ * change in between is appended to a journal which is replayed on startup,
+ * so the index survives a crash.  Cache hits only change the access order,
+ * they are collected and appended at most every few seconds instead of
+ * writing to the journal on each lookup.
+ */
+class MARBLE_EXPORT DiscCache
 {
     public:
         explicit DiscCache( const QString &cacheDirectory );
@@ -35,16 +53,57 @@ class DiscCache
         void remove( const QString &key );
         void setCacheLimit( quint64 n );
 
+        /**
+         * Returns the number of entries in the cache.
+         */
+        int count() const;
+
+        /**
+         * Returns the accumulated size of all entries in bytes.
+         */
+        quint64 size() const;
+
     private:
+        Q_DISABLE_COPY( DiscCache )
+
+        struct Entry
+        {
+            QString key;
+            QDateTime lastAccess;
+            quint64 size;
+            Entry *previous;
+            Entry *next;
+        };
+
         QString keyToFileName( const QString& ) const;
         void cleanup();
 
+        Entry *addEntry( const QString &key, const QDateTime &lastAccess, quint64 size );
+        void removeEntry( Entry *entry );
+        void unlink( Entry *entry );
+        void linkAsMostRecent( Entry *entry );
+
+        void readIndex();
+        void replayJournal();
+        void writeIndex();
+        void appendToJournal( const QByteArray &records, int recordCount = 1 );
+
         QString m_CacheDirectory;
         quint64 m_CacheLimit;
         quint64 m_CurrentCacheSize;
 
-        typedef QPair<QDateTime, quint64> Entry;
-        QMap<QString, Entry> m_Entries;
+        QHash<QString, Entry *> m_Entries;
+
+        // least recently used entry first
+        Entry *m_Oldest;
+        Entry *m_Newest;
+
+        QFile m_Journal;
+        int m_JournalRecords;
+
+        // keys found since the last accesses went to the journal
+        QSet<QString> m_AccessedKeys;
+        QElapsedTimer m_AccessTimer;
 };
 
 }
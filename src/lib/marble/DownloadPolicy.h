@@ -20,11 +20,12 @@
 #include <QStringList>
 
 #include "MarbleGlobal.h"
+#include "marble_export.h"
 
 namespace Marble
 {
 
-class DownloadPolicyKey
+class MARBLE_EXPORT DownloadPolicyKey
 {
     friend bool operator==( DownloadPolicyKey const & lhs, DownloadPolicyKey const & rhs );
 
@@ -52,7 +53,7 @@ inline bool operator==( const DownloadPolicyKey & lhs, const DownloadPolicyKey &
 }
 
 
-class DownloadPolicy
+class MARBLE_EXPORT DownloadPolicy
 {
     friend bool operator==( const DownloadPolicy & lhs, const DownloadPolicy & rhs );
 
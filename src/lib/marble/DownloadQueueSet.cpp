@@ -15,7 +15,10 @@
 
 #include "DownloadQueueSet.h"
 
+#include <algorithm>
+
 #include "MarbleDebug.h"
+#include "MarbleMath.h"
 
 #include "HttpJob.h"
 
@@ -79,6 +82,35 @@ void DownloadQueueSet::addJob( HttpJob * const job )
     mDebug() << "addJob: new job queue size:" << m_jobs.count();
     emit jobAdded();
     emit progressChanged( m_activeJobs.size(), m_jobs.count() );
+    requeueHiddenJobs();
+    activateJobs();
+}
+
+bool DownloadQueueSet::mergeJob( const QUrl& sourceUrl, const QString& destinationFileName,
+                                 const QString& id )
+{
+    HttpJob * const queuedJob = m_jobs.find( sourceUrl );
+    if ( queuedJob ) {
+        queuedJob->addMergedRequest( destinationFileName, id );
+        m_jobs.raise( queuedJob );
+        return true;
+    }
+
+    QList<HttpJob*>::const_iterator pos = m_activeJobs.constBegin();
+    QList<HttpJob*>::const_iterator const end = m_activeJobs.constEnd();
+    for (; pos != end; ++pos ) {
+        if ( (*pos)->sourceUrl() == sourceUrl ) {
+            (*pos)->addMergedRequest( destinationFileName, id );
+            return true;
+        }
+    }
+    return false;
+}
+
+void DownloadQueueSet::setVisibleArea( const GeoDataLatLonBox& visibleArea )
+{
+    m_jobs.setVisibleArea( visibleArea );
+    requeueHiddenJobs();
     activateJobs();
 }
 
@@ -116,7 +148,10 @@ void DownloadQueueSet::purgeJobs()
 
     // cancel all current jobs
     while( !m_activeJobs.isEmpty() ) {
-        deactivateJob( m_activeJobs.first() );
+        HttpJob * const job = m_activeJobs.first();
+        job->abort();
+        deactivateJob( job );
+        job->deleteLater();
     }
 
     emit progressChanged( m_activeJobs.size(), m_jobs.count() );
@@ -129,6 +164,10 @@ void DownloadQueueSet::finishJob( HttpJob * job, const QByteArray& data )
     deactivateJob( job );
     emit jobRemoved();
     emit jobFinished( data, job->destinationFileName(), job->initiatorId() );
+    QList<QPair<QString, QString> > const mergedRequests = job->mergedRequests();
+    for ( const QPair<QString, QString> &request: mergedRequests ) {
+        emit jobFinished( data, request.first, request.second );
+    }
     job->deleteLater();
     activateJobs();
 }
@@ -140,7 +179,12 @@ void DownloadQueueSet::redirectJob( HttpJob * job, const QUrl& newSourceUrl )
     deactivateJob( job );
     emit jobRemoved();
     emit jobRedirected( newSourceUrl, job->destinationFileName(), job->initiatorId(),
-                        job->downloadUsage() );
+                        job->downloadUsage(), job->tileArea(), job->zoomLevel() );
+    QList<QPair<QString, QString> > const mergedRequests = job->mergedRequests();
+    for ( const QPair<QString, QString> &request: mergedRequests ) {
+        emit jobRedirected( newSourceUrl, request.first, request.second,
+                            job->downloadUsage(), job->tileArea(), job->zoomLevel() );
+    }
     job->deleteLater();
 }
 
@@ -206,6 +250,32 @@ void DownloadQueueSet::deactivateJob( HttpJob * const job )
     emit progressChanged( m_activeJobs.size(), m_jobs.count() );
 }
 
+/**
+   Frees the connections used for tiles which left the visible area as long
+   as tiles in the visible area wait for one.
+ */
+void DownloadQueueSet::requeueHiddenJobs()
+{
+    QList<HttpJob*> const activeJobs = m_activeJobs;
+    for ( HttpJob * const job: activeJobs ) {
+        if ( m_jobs.visibleCount() <= m_downloadPolicy.maximumConnections() - m_activeJobs.count() ) {
+            break;
+        }
+        if ( !m_jobs.isVisible( job ) ) {
+            mDebug() << "Requeuing" << job->destinationFileName() << "which left the visible area";
+            requeueJob( job );
+        }
+    }
+}
+
+void DownloadQueueSet::requeueJob( HttpJob * const job )
+{
+    job->abort();
+    deactivateJob( job );
+    m_jobs.push( job );
+    emit progressChanged( m_activeJobs.size(), m_jobs.count() );
+}
+
 bool DownloadQueueSet::jobIsActive( QString const & destinationFileName ) const
 {
     QList<HttpJob*>::const_iterator pos = m_activeJobs.constBegin();
@@ -243,36 +313,145 @@ bool DownloadQueueSet::jobIsBlackListed( const QUrl& sourceUrl ) const
 }
 
 
-inline bool DownloadQueueSet::JobStack::contains( const QString& destinationFileName ) const
+DownloadQueueSet::JobQueue::JobQueue()
+    : m_centerLon( 0.0 ),
+      m_centerLat( 0.0 ),
+      m_serial( 0 ),
+      m_visibleCount( 0 )
+{
+}
+
+inline bool DownloadQueueSet::JobQueue::contains( const QString& destinationFileName ) const
 {
     return m_jobsContent.contains( destinationFileName );
 }
 
-inline int DownloadQueueSet::JobStack::count() const
+inline HttpJob * DownloadQueueSet::JobQueue::find( const QUrl& sourceUrl ) const
 {
-    return m_jobs.count();
+    return m_jobsBySourceUrl.value( sourceUrl.toString() );
 }
 
-inline bool DownloadQueueSet::JobStack::isEmpty() const
+inline int DownloadQueueSet::JobQueue::count() const
 {
-    return m_jobs.isEmpty();
+    return m_heap.count();
 }
 
-inline HttpJob * DownloadQueueSet::JobStack::pop()
+inline bool DownloadQueueSet::JobQueue::isEmpty() const
 {
-    HttpJob * const job = m_jobs.pop();
-    bool const removed = m_jobsContent.remove( job->destinationFileName() );
+    return m_heap.isEmpty();
+}
+
+inline int DownloadQueueSet::JobQueue::visibleCount() const
+{
+    return m_visibleCount;
+}
+
+bool DownloadQueueSet::JobQueue::isVisible( const HttpJob * job ) const
+{
+    // bulk downloads don't depend on what is shown
+    if ( job->downloadUsage() != DownloadBrowse || m_visibleArea.isEmpty() ) {
+        return true;
+    }
+
+    GeoDataLatLonBox const tileArea = job->tileArea();
+    return tileArea.isEmpty() || m_visibleArea.intersects( tileArea );
+}
+
+HttpJob * DownloadQueueSet::JobQueue::pop()
+{
+    std::pop_heap( m_heap.begin(), m_heap.end(), isLessUrgent );
+    Entry const top = m_heap.takeLast();
+    m_visibleCount -= top.visible ? 1 : 0;
+    m_jobsBySourceUrl.remove( top.job->sourceUrl().toString() );
+    bool const removed = m_jobsContent.remove( top.job->destinationFileName() );
     Q_UNUSED( removed ); // for Q_ASSERT in release mode
     Q_ASSERT( removed );
-    return job;
+    return top.job;
 }
 
-inline void DownloadQueueSet::JobStack::push( HttpJob * const job )
+void DownloadQueueSet::JobQueue::push( HttpJob * const job )
 {
-    m_jobs.push( job );
+    Entry const jobEntry = entry( job, ++m_serial );
+    m_heap.append( jobEntry );
+    std::push_heap( m_heap.begin(), m_heap.end(), isLessUrgent );
+    m_visibleCount += jobEntry.visible ? 1 : 0;
+    m_jobsBySourceUrl.insert( job->sourceUrl().toString(), job );
     m_jobsContent.insert( job->destinationFileName() );
 }
 
+void DownloadQueueSet::JobQueue::raise( HttpJob * const job )
+{
+    QVector<Entry>::iterator pos = m_heap.begin();
+    QVector<Entry>::iterator const end = m_heap.end();
+    for (; pos != end; ++pos ) {
+        if ( pos->job == job ) {
+            pos->serial = ++m_serial;
+            break;
+        }
+    }
+    std::make_heap( m_heap.begin(), m_heap.end(), isLessUrgent );
+}
+
+void DownloadQueueSet::JobQueue::setVisibleArea( const GeoDataLatLonBox& visibleArea )
+{
+    if ( visibleArea == m_visibleArea ) {
+        return;
+    }
+
+    m_visibleArea = visibleArea;
+    GeoDataCoordinates const center = visibleArea.center();
+    m_centerLon = center.longitude();
+    m_centerLat = center.latitude();
+    rebuild();
+}
+
+DownloadQueueSet::JobQueue::Entry DownloadQueueSet::JobQueue::entry( HttpJob * const job, quint64 serial ) const
+{
+    Entry result;
+    result.job = job;
+    result.usageRank = job->downloadUsage() == DownloadBrowse ? 0 : 1;
+    result.visible = isVisible( job );
+    result.zoomLevel = job->zoomLevel();
+    result.distance = 0.0;
+    result.serial = serial;
+
+    GeoDataLatLonBox const tileArea = job->tileArea();
+    if ( job->downloadUsage() == DownloadBrowse && !m_visibleArea.isEmpty() && !tileArea.isEmpty() ) {
+        GeoDataCoordinates const tileCenter = tileArea.center();
+        result.distance = distanceSphere( tileCenter.longitude(), tileCenter.latitude(),
+                                          m_centerLon, m_centerLat );
+    }
+    return result;
+}
+
+void DownloadQueueSet::JobQueue::rebuild()
+{
+    m_visibleCount = 0;
+    QVector<Entry>::iterator pos = m_heap.begin();
+    QVector<Entry>::iterator const end = m_heap.end();
+    for (; pos != end; ++pos ) {
+        *pos = entry( pos->job, pos->serial );
+        m_visibleCount += pos->visible ? 1 : 0;
+    }
+    std::make_heap( m_heap.begin(), m_heap.end(), isLessUrgent );
+}
+
+bool DownloadQueueSet::JobQueue::isLessUrgent( const Entry& lhs, const Entry& rhs )
+{
+    if ( lhs.usageRank != rhs.usageRank ) {
+        return lhs.usageRank > rhs.usageRank;
+    }
+    if ( lhs.visible != rhs.visible ) {
+        return !lhs.visible;
+    }
+    if ( lhs.zoomLevel != rhs.zoomLevel ) {
+        return lhs.zoomLevel > rhs.zoomLevel;
+    }
+    if ( lhs.distance != rhs.distance ) {
+        return lhs.distance > rhs.distance;
+    }
+    return lhs.serial < rhs.serial;
+}
 
 }
 
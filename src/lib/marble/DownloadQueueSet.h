@@ -16,13 +16,15 @@
 #ifndef MARBLE_DOWNLOADQUEUESET_H
 #define MARBLE_DOWNLOADQUEUESET_H
 
+#include <QHash>
 #include <QList>
 #include <QQueue>
 #include <QObject>
 #include <QSet>
-#include <QStack>
+#include <QVector>
 
 #include "DownloadPolicy.h"
+#include "GeoDataLatLonBox.h"
 
 class QUrl;
 
@@ -35,8 +37,10 @@ class HttpJob;
    Life of a HttpJob
    =================
    - Job is added to the QueueSet (by calling addJob() )
-     the HttpJob is put into the m_jobQueue where it waits for "activation"
+     the HttpJob is put into the m_jobs queue where it waits for "activation"
      signal jobAdded is emitted
+     (a request for the source url of a queued or active job is merged into
+      that job by mergeJob() instead)
    - Job is activated
      Job is moved from m_jobQueue to m_activeJobs and signals of the job
      are connected to slots (local or HttpDownloadManager)
@@ -58,6 +62,11 @@ class HttpJob;
       Job is removed from m_activeJobs, disconnected and destroyed
       signal jobRemoved is emitted
 
+   4) The tile of the job is outside of the visible area (see setVisibleArea() )
+      while tiles in the visible area are waiting for a connection
+      Job is aborted, removed from m_activeJobs, disconnected and put
+      back into m_jobs
+
    so we can conclude following rules:
    - Job is only connected to signals when in "active" state
 
@@ -86,6 +95,20 @@ class DownloadQueueSet: public QObject
                        const QString& destinationFileName ) const;
     void addJob( HttpJob * const job );
 
+    /**
+     * Merges a request into a queued or active job for the same source url.
+     * A queued job is ranked as if it was just added.
+     * @return false if there is no such job
+     */
+    bool mergeJob( const QUrl& sourceUrl, const QString& destinationFileName,
+                   const QString& id );
+
+    /**
+     * Ranks the jobs by the visible area and puts active jobs for tiles
+     * outside of it back into the queue if tiles inside are waiting.
+     */
+    void setVisibleArea( const GeoDataLatLonBox& visibleArea );
+
     void activateJobs();
     void retryJobs();
     void purgeJobs();
@@ -97,7 +120,8 @@ class DownloadQueueSet: public QObject
     void jobFinished( const QByteArray& data, const QString& destinationFileName,
                       const QString& id );
     void jobRedirected( const QUrl& newSourceUrl, const QString& destinationFileName,
-                        const QString& id, DownloadUsage );
+                        const QString& id, DownloadUsage,
+                        const GeoDataLatLonBox& tileArea, int zoomLevel );
     void progressChanged( int active, int queued );
 
  private Q_SLOTS:
@@ -108,6 +132,8 @@ class DownloadQueueSet: public QObject
  private:
     void activateJob( HttpJob * const job );
     void deactivateJob( HttpJob * const job );
+    void requeueHiddenJobs();
+    void requeueJob( HttpJob * const job );
     bool jobIsActive( const QString& destinationFileName ) const;
     bool jobIsQueued( const QString& destinationFileName ) const;
     bool jobIsWaitingForRetry( const QString& destinationFileName ) const;
@@ -117,20 +143,50 @@ class DownloadQueueSet: public QObject
 
     /** This is the first stage a job enters, from this queue it will get
      *  into the activatedJobs container.
+     *
+     *  Jobs are taken out by priority: browsing before bulk downloads, tiles
+     *  in the visible area before the others, lower zoom levels first, then
+     *  the tiles closer to the center of the visible area and finally the job
+     *  added last, as the plain stack did before.
      */
-    class JobStack
+    class JobQueue
     {
     public:
+        JobQueue();
         bool contains( const QString& destinationFileName ) const;
+        HttpJob * find( const QUrl& sourceUrl ) const;
         int count() const;
         bool isEmpty() const;
+        int visibleCount() const;
+        bool isVisible( const HttpJob * job ) const;
         HttpJob * pop();
         void push( HttpJob * const );
+        void raise( HttpJob * const );
+        void setVisibleArea( const GeoDataLatLonBox& visibleArea );
     private:
-        QStack<HttpJob*> m_jobs;
+        struct Entry
+        {
+            HttpJob *job;
+            int usageRank;
+            bool visible;
+            int zoomLevel;
+            qreal distance;
+            quint64 serial;
+        };
+        Entry entry( HttpJob * const job, quint64 serial ) const;
+        void rebuild();
+        static bool isLessUrgent( const Entry& lhs, const Entry& rhs );
+
+        QVector<Entry> m_heap;
+        QHash<QString, HttpJob*> m_jobsBySourceUrl;
         QSet<QString> m_jobsContent;
+        GeoDataLatLonBox m_visibleArea;
+        qreal m_centerLon;
+        qreal m_centerLat;
+        quint64 m_serial;
+        int m_visibleCount;
     };
-    JobStack m_jobs;
+    JobQueue m_jobs;
 
     /// Contains the jobs which are currently being downloaded.
     QList<HttpJob*> m_activeJobs;
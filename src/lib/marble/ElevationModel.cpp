@@ -9,6 +9,8 @@
 //
 
 #include "ElevationModel.h"
+#include "GeoDataCoordinates.h"
+#include "GeoDataLineString.h"
 #include "GeoSceneHead.h"
 #include "GeoSceneLayer.h"
 #include "GeoSceneMap.h"
@@ -25,21 +27,69 @@
 
 #include <QCache>
 #include <QImage>
+#include <QMutex>
+#include <QThread>
+#include <QtConcurrentMap>
 #include <qmath.h>
 
+#include <algorithm>
+
 namespace Marble
 {
 
+namespace {
+    // a decoded tile stores the 16 valid bits of each pixel, so no data is -32768
+    qint16 const noDataSample = qint16( invalidElevationData );
+
+    // below this, spreading the samples over threads costs more than it saves
+    int const minimumSamplesPerThread = 4096;
+}
+
+class ElevationModelPrivate;
+
+/**
+ * Keeps the last few decoded tiles at hand for sampling, so that looking up
+ * the neighbouring pixels doesn't go through the shared tile cache.
+ */
+class ElevationTileSampler
+{
+public:
+    explicit ElevationTileSampler( ElevationModelPrivate *model );
+
+    const qint16 *tile( int tileX, int tileY );
+
+private:
+    enum { Slots = 4 };
+
+    ElevationModelPrivate *const m_model;
+    int m_keys[Slots];
+    QVector<qint16> m_tiles[Slots];
+    int m_next;
+};
+
 class ElevationModelPrivate
 {
 public:
+    struct Sample
+    {
+        qreal textureX;
+        qreal textureY;
+        int tileKey;
+        int index;
+    };
+
     ElevationModelPrivate( ElevationModel *_q, HttpDownloadManager *downloadManager, PluginManager* pluginManager )
         : q( _q ),
           m_tileLoader( downloadManager, pluginManager ),
           m_textureLayer( 0 ),
-          m_srtmTheme(0)
+          m_srtmTheme( 0 ),
+          m_tileLevel( 0 ),
+          m_tileWidth( 0 ),
+          m_tileHeight( 0 ),
+          m_numTilesX( 0 ),
+          m_numTilesY( 0 )
     {
-        m_cache.setMaxCost( 10 ); //keep 10 tiles in memory (~17MB)
+        m_cache.setMaxCost( 20 ); //keep 20 decoded tiles in memory (~17MB)
 
         m_srtmTheme = MapThemeManager::loadMapTheme( "earth/srtm2/srtm2.dgml" );
         if ( !m_srtmTheme ) {
@@ -58,6 +108,17 @@ public:
 
         m_textureLayer = dynamic_cast<GeoSceneTextureTileDataset*>( sceneLayer->datasets().first() );
         Q_ASSERT( m_textureLayer );
+
+        m_tileLevel = TileLoader::maximumTileLevel( *m_textureLayer );
+        Q_ASSERT( m_tileLevel == 9 );
+
+        m_tileWidth = m_textureLayer->tileSize().width();
+        m_tileHeight = m_textureLayer->tileSize().height();
+
+        m_numTilesX = TileLoaderHelper::levelToColumn( m_textureLayer->levelZeroColumns(), m_tileLevel );
+        m_numTilesY = TileLoaderHelper::levelToRow( m_textureLayer->levelZeroRows(), m_tileLevel );
+        Q_ASSERT( m_numTilesX > 0 );
+        Q_ASSERT( m_numTilesY > 0 );
     }
 
     ~ElevationModelPrivate()
@@ -67,56 +128,125 @@ public:
 
     void tileCompleted( const TileId & tileId, const QImage &image )
     {
-        m_cache.insert( tileId, new QImage( image ) );
+        const QVector<qint16> samples = decodeTile( image );
+        {
+            QMutexLocker locker( &m_cacheMutex );
+            m_cache.insert( tileId, new QVector<qint16>( samples ) );
+        }
         emit q->updateAvailable();
     }
 
+    void textureCoordinates( qreal lon, qreal lat, qreal &textureX, qreal &textureY ) const
+    {
+        textureX = 180 + lon;
+        textureX *= m_numTilesX * m_tileWidth / 360;
+
+        textureY = 90 - lat;
+        textureY *= m_numTilesY * m_tileHeight / 180;
+    }
+
+    int tileKey( qreal textureX, qreal textureY ) const
+    {
+        const int x = static_cast<int>( textureX );
+        const int y = static_cast<int>( textureY );
+        const int tileX = ( x % ( m_numTilesX * m_tileWidth ) ) / m_tileWidth;
+        const int tileY = ( y % ( m_numTilesY * m_tileHeight ) ) / m_tileHeight;
+        return tileY * m_numTilesX + tileX;
+    }
+
+    QVector<qint16> decodeTile( const QImage &tileImage ) const;
+    QVector<qint16> tile( int tileX, int tileY );
+    qreal height( qreal textureX, qreal textureY, ElevationTileSampler &sampler ) const;
+    void sampleHeights( const QVector<Sample> &samples, int begin, int end, qreal *heights );
+
+    template<typename Iterator>
+    QVector<qreal> heights( Iterator begin, Iterator end, ElevationModel::QueryMode mode );
+
 public:
     ElevationModel *q;
 
     TileLoader m_tileLoader;
     const GeoSceneTextureTileDataset *m_textureLayer;
-    QCache<TileId, const QImage> m_cache;
+    QMutex m_cacheMutex;
+    QCache<TileId, const QVector<qint16> > m_cache;
     GeoSceneDocument *m_srtmTheme;
+
+    int m_tileLevel;
+    int m_tileWidth;
+    int m_tileHeight;
+    int m_numTilesX;
+    int m_numTilesY;
 };
 
-ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent ) :
-    QObject( parent ),
-    d( new ElevationModelPrivate( this, downloadManager, pluginManager ) )
+ElevationTileSampler::ElevationTileSampler( ElevationModelPrivate *model ) :
+    m_model( model ),
+    m_next( 0 )
 {
-    connect( &d->m_tileLoader, SIGNAL(tileCompleted(TileId,QImage)),
-             this, SLOT(tileCompleted(TileId,QImage)) );
+    for ( int i = 0; i < Slots; ++i ) {
+        m_keys[i] = -1;
+    }
 }
 
-ElevationModel::~ElevationModel()
+const qint16 *ElevationTileSampler::tile( int tileX, int tileY )
 {
-    delete d;
-}
+    const int key = tileY * m_model->m_numTilesX + tileX;
+    for ( int i = 0; i < Slots; ++i ) {
+        if ( m_keys[i] == key ) {
+            return m_tiles[i].constData();
+        }
+    }
 
+    const int slot = m_next;
+    m_next = ( m_next + 1 ) % Slots;
+    m_keys[slot] = key;
+    m_tiles[slot] = m_model->tile( tileX, tileY );
+    return m_tiles[slot].constData();
+}
 
-qreal ElevationModel::height( qreal lon, qreal lat ) const
+QVector<qint16> ElevationModelPrivate::decodeTile( const QImage &tileImage ) const
 {
-    if ( !d->m_textureLayer ) {
-        return invalidElevationData;
+    QVector<qint16> samples( m_tileWidth * m_tileHeight, noDataSample );
+    if ( tileImage.width() != m_tileWidth || tileImage.height() != m_tileHeight ) {
+        mDebug() << "Elevation tile of unexpected size" << tileImage.size();
+        return samples;
     }
 
-    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
-    Q_ASSERT( tileZoomLevel == 9 );
+    // same values as QImage::pixel(), which returns unpremultiplied ARGB
+    const bool isArgb = tileImage.format() == QImage::Format_RGB32 || tileImage.format() == QImage::Format_ARGB32;
+    const QImage image = isArgb ? tileImage : tileImage.convertToFormat( QImage::Format_ARGB32 );
 
-    const int width = d->m_textureLayer->tileSize().width();
-    const int height = d->m_textureLayer->tileSize().height();
+    qint16 *sample = samples.data();
+    for ( int y = 0; y < m_tileHeight; ++y ) {
+        const QRgb *line = reinterpret_cast<const QRgb *>( image.constScanLine( y ) );
+        for ( int x = 0; x < m_tileWidth; ++x ) {
+            *sample++ = qint16( line[x] & 0xffff ); // 16 valid bits of a signed type
+        }
+    }
 
-    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
-    const int numTilesY = TileLoaderHelper::levelToRow( d->m_textureLayer->levelZeroRows(), tileZoomLevel );
-    Q_ASSERT( numTilesX > 0 );
-    Q_ASSERT( numTilesY > 0 );
+    return samples;
+}
 
-    qreal textureX = 180 + lon;
-    textureX *= numTilesX * width / 360;
+QVector<qint16> ElevationModelPrivate::tile( int tileX, int tileY )
+{
+    const TileId id( 0, m_tileLevel, tileX, tileY );
+    {
+        QMutexLocker locker( &m_cacheMutex );
+        const QVector<qint16> *samples = m_cache.object( id );
+        if ( samples ) {
+            return *samples;
+        }
+    }
+
+    // loading and decoding doesn't need the lock, so other threads keep sampling meanwhile
+    const QVector<qint16> samples = decodeTile( m_tileLoader.loadTileImage( m_textureLayer, id, DownloadBrowse ) );
 
-    qreal textureY = 90 - lat;
-    textureY *= numTilesY * height / 180;
+    QMutexLocker locker( &m_cacheMutex );
+    m_cache.insert( id, new QVector<qint16>( samples ) );
+    return samples;
+}
 
+qreal ElevationModelPrivate::height( qreal textureX, qreal textureY, ElevationTileSampler &sampler ) const
+{
     qreal ret = 0;
     bool hasHeight = false;
     qreal noData = 0;
@@ -125,36 +255,19 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
         const int x = static_cast<int>( textureX + ( i % 2 ) );
         const int y = static_cast<int>( textureY + ( i / 2 ) );
 
-        //mDebug() << "x" << x << ( x / width );
-        //mDebug() << "y" << y << ( y / height );
-
-        const TileId id( 0, tileZoomLevel, ( x % ( numTilesX * width ) ) / width, ( y % ( numTilesY * height ) ) / height );
-        //mDebug() << "LAT" << lat << "LON" << lon << "tile" << ( x % ( numTilesX * width ) ) / width << ( y % ( numTilesY * height ) ) / height;
-
-        const QImage *image = d->m_cache[id];
-        if ( image == 0 ) {
-            image = new QImage( d->m_tileLoader.loadTileImage( d->m_textureLayer, id, DownloadBrowse ) );
-            d->m_cache.insert( id, image );
-        }
-        Q_ASSERT( image );
-        Q_ASSERT( !image->isNull() );
-        Q_ASSERT( width == image->width() );
-        Q_ASSERT( height == image->height() );
+        const qint16 *tile = sampler.tile( ( x % ( m_numTilesX * m_tileWidth ) ) / m_tileWidth,
+                                           ( y % ( m_numTilesY * m_tileHeight ) ) / m_tileHeight );
 
         const qreal dx = ( textureX > ( qreal )x ) ? textureX - ( qreal )x : ( qreal )x - textureX;
         const qreal dy = ( textureY > ( qreal )y ) ? textureY - ( qreal )y : ( qreal )y - textureY;
 
         Q_ASSERT( 0 <= dx && dx <= 1 );
         Q_ASSERT( 0 <= dy && dy <= 1 );
-        unsigned int pixel = image->pixel( x % width, y % height ) & 0xffff; // 16 valid bits
-        short int elevation = (short int) pixel; // and signed type, so just cast it
-        //mDebug() << "(1-dx)" << (1-dx) << "(1-dy)" << (1-dy);
-        if ( pixel != invalidElevationData ) { //no data?
-            //mDebug() << "got at x" << x % width << "y" << y % height << "a height of" << pixel << "** RGB" << qRed(pixel) << qGreen(pixel) << qBlue(pixel);
+        const qint16 elevation = tile[( y % m_tileHeight ) * m_tileWidth + x % m_tileWidth];
+        if ( elevation != noDataSample ) {
             ret += ( qreal )elevation * ( 1 - dx ) * ( 1 - dy );
             hasHeight = true;
         } else {
-            //mDebug() << "no data at" <<  x % width << "y" << y % height;
             noData += ( 1 - dx ) * ( 1 - dy );
         }
     }
@@ -163,26 +276,117 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
         ret = invalidElevationData; //no data
     } else {
         if ( noData ) {
-            //mDebug() << "NO DATA" << noData;
             ret += ( ret / ( 1 - noData ) ) * noData;
         }
     }
 
-    //mDebug() << ">>>" << lat << lon << "returning an elevation of" << ret;
     return ret;
 }
 
+void ElevationModelPrivate::sampleHeights( const QVector<Sample> &samples, int begin, int end, qreal *heights )
+{
+    ElevationTileSampler sampler( this );
+    for ( int i = begin; i < end; ++i ) {
+        const Sample &sample = samples[i];
+        heights[sample.index] = height( sample.textureX, sample.textureY, sampler );
+    }
+}
+
+template<typename Iterator>
+QVector<qreal> ElevationModelPrivate::heights( Iterator begin, Iterator end, ElevationModel::QueryMode mode )
+{
+    const int count = std::distance( begin, end );
+    QVector<qreal> result( count, invalidElevationData );
+    if ( !m_textureLayer || count == 0 ) {
+        return result;
+    }
+
+    QVector<Sample> samples( count );
+    int index = 0;
+    for ( Iterator iter = begin; iter != end; ++iter, ++index ) {
+        Sample &sample = samples[index];
+        textureCoordinates( iter->longitude( GeoDataCoordinates::Degree ), iter->latitude( GeoDataCoordinates::Degree ),
+                            sample.textureX, sample.textureY );
+        sample.tileKey = tileKey( sample.textureX, sample.textureY );
+        sample.index = index;
+    }
+
+    // visit the samples tile by tile, so each tile is fetched once while its samples are taken
+    std::stable_sort( samples.begin(), samples.end(), []( const Sample &a, const Sample &b ) {
+        return a.tileKey < b.tileKey;
+    } );
+
+    qreal *const heights = result.data();
+    const int threads = QThread::idealThreadCount();
+    if ( mode == ElevationModel::Sequential || threads < 2 || count < 2 * minimumSamplesPerThread ) {
+        sampleHeights( samples, 0, count, heights );
+        return result;
+    }
+
+    // chunks end at tile boundaries, so no two threads decode the same tile for its own samples
+    const int chunkSize = qMax( minimumSamplesPerThread, count / ( 4 * threads ) );
+    QVector<QPair<int, int> > chunks;
+    for ( int chunkBegin = 0; chunkBegin < count; ) {
+        int chunkEnd = qMin( count, chunkBegin + chunkSize );
+        while ( chunkEnd < count && samples[chunkEnd].tileKey == samples[chunkEnd - 1].tileKey ) {
+            ++chunkEnd;
+        }
+        chunks << qMakePair( chunkBegin, chunkEnd );
+        chunkBegin = chunkEnd;
+    }
+
+    QtConcurrent::blockingMap( chunks, [this, &samples, heights]( const QPair<int, int> &chunk ) {
+        sampleHeights( samples, chunk.first, chunk.second, heights );
+    } );
+
+    return result;
+}
+
+ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent ) :
+    QObject( parent ),
+    d( new ElevationModelPrivate( this, downloadManager, pluginManager ) )
+{
+    connect( &d->m_tileLoader, SIGNAL(tileCompleted(TileId,QImage)),
+             this, SLOT(tileCompleted(TileId,QImage)) );
+}
+
+ElevationModel::~ElevationModel()
+{
+    delete d;
+}
+
+
+qreal ElevationModel::height( qreal lon, qreal lat ) const
+{
+    if ( !d->m_textureLayer ) {
+        return invalidElevationData;
+    }
+
+    qreal textureX;
+    qreal textureY;
+    d->textureCoordinates( lon, lat, textureX, textureY );
+
+    ElevationTileSampler sampler( d );
+    return d->height( textureX, textureY, sampler );
+}
+
+QVector<qreal> ElevationModel::heights( const QVector<GeoDataCoordinates> &coordinates, QueryMode mode ) const
+{
+    return d->heights( coordinates.constBegin(), coordinates.constEnd(), mode );
+}
+
+QVector<qreal> ElevationModel::heights( const GeoDataLineString &lineString, QueryMode mode ) const
+{
+    return d->heights( lineString.constBegin(), lineString.constEnd(), mode );
+}
+
 QVector<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const
 {
     if ( !d->m_textureLayer ) {
         return QVector<GeoDataCoordinates>();
     }
 
-    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
-    const int width = d->m_textureLayer->tileSize().width();
-    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
-
-    qreal distPerPixel = ( qreal )360 / ( width * numTilesX );
+    qreal distPerPixel = ( qreal )360 / ( d->m_tileWidth * d->m_numTilesX );
     //mDebug() << "heightProfile" << fromLat << fromLon << toLat << toLon << "distPerPixel" << distPerPixel;
 
     qreal lat = fromLat;
@@ -193,13 +397,10 @@ QVector<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal
     //mDebug() << "fromLon" << fromLon << "fromLat" << fromLat;
     //mDebug() << "diff lon" << ( fromLon - toLon ) << "diff lat" << ( fromLat - toLat );
     //mDebug() << "dirLon" << QString::number(dirLon) << "dirLat" << QString::number(dirLat) << "k" << k;
-    QVector<GeoDataCoordinates> ret;
+    QVector<GeoDataCoordinates> profile;
     while ( lat*dirLat <= toLat*dirLat && lon*dirLon <= toLon * dirLon ) {
         //mDebug() << lat << lon;
-        qreal h = height( lon, lat );
-        if ( h < 32000 ) {
-            ret << GeoDataCoordinates( lon, lat, h, GeoDataCoordinates::Degree );
-        }
+        profile << GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
         if ( k < 0.5 ) {
             //mDebug() << "lon(x) += distPerPixel";
             lat += distPerPixel * k * dirLat;
@@ -210,6 +411,16 @@ QVector<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal
             lon += distPerPixel / k * dirLon;
         }
     }
+
+    const QVector<qreal> heights = this->heights( profile );
+    QVector<GeoDataCoordinates> ret;
+    for ( int i = 0; i < profile.size(); ++i ) {
+        if ( heights[i] < 32000 ) {
+            GeoDataCoordinates coordinates = profile[i];
+            coordinates.setAltitude( heights[i] );
+            ret << coordinates;
+        }
+    }
     //mDebug() << ret;
     return ret;
 }
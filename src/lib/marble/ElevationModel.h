@@ -15,12 +15,14 @@
 #include "marble_export.h"
 
 #include <QObject>
+#include <QVector>
 
 class QImage;
 
 namespace Marble
 {
 class GeoDataCoordinates;
+class GeoDataLineString;
 
 namespace {
     unsigned int const invalidElevationData = 32768;
@@ -35,10 +37,25 @@ class MARBLE_EXPORT ElevationModel : public QObject
 {
     Q_OBJECT
 public:
+    enum QueryMode {
+        Sequential, ///< samples all coordinates in the calling thread
+        Threaded    ///< spreads long coordinate lists over the global thread pool
+    };
+
     explicit ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent = 0 );
     ~ElevationModel() override;
 
     qreal height( qreal lon, qreal lat ) const;
+
+    /**
+     * Returns the heights of all @p coordinates at once, invalidElevationData
+     * where no data is available. The samples are visited tile by tile, so each
+     * elevation tile is decoded at most once per call. The result is the same as
+     * calling height() for every coordinate.
+     **/
+    QVector<qreal> heights( const QVector<GeoDataCoordinates> &coordinates, QueryMode mode = Sequential ) const;
+    QVector<qreal> heights( const GeoDataLineString &lineString, QueryMode mode = Sequential ) const;
+
     QVector<GeoDataCoordinates> heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const;
 
 Q_SIGNALS:
@@ -16,12 +16,10 @@
 // posix
 #include <cmath>
 
-// Qt
-#include <QRunnable>
-
 // Marble
 #include "GeoPainter.h"
 #include "MarbleDebug.h"
+#include "ScanlineRenderScheduler.h"
 #include "ScanlineTextureMapperContext.h"
 #include "StackedTileLoader.h"
 #include "TextureColorizer.h"
@@ -29,31 +27,23 @@
 
 using namespace Marble;
 
-class EquirectScanlineTextureMapper::RenderJob : public QRunnable
+class EquirectScanlineTextureMapper::RenderJob : public ScanlineRenderScheduler::Job
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewportParams, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality );
 
-    void run() override;
+    void renderBlock( ScanlineTextureMapperContext &context, int yPaintedTop, int yPaintedBottom ) override;
 
 private:
-    StackedTileLoader *const m_tileLoader;
-    const int m_tileLevel;
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    const int m_yPaintedTop;
-    const int m_yPaintedBottom;
 };
 
-EquirectScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
-    : m_tileLoader( tileLoader ),
-      m_tileLevel( tileLevel ),
-      m_canvasImage( canvasImage ),
+EquirectScanlineTextureMapper::RenderJob::RenderJob( QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality )
+    : m_canvasImage( canvasImage ),
       m_viewport( viewport ),
-      m_mapQuality( mapQuality ),
-      m_yPaintedTop( yTop ),
-      m_yPaintedBottom( yBottom )
+      m_mapQuality( mapQuality )
 {
 }
 
@@ -62,7 +52,8 @@ EquirectScanlineTextureMapper::EquirectScanlineTextureMapper( StackedTileLoader
     : TextureMapperInterface(),
       m_tileLoader( tileLoader ),
       m_radius( 0 ),
-      m_oldYPaintedTop( 0 )
+      m_oldYPaintedTop( 0 ),
+      m_scheduler( &m_threadPool )
 {
 }
 
@@ -128,14 +119,8 @@ void EquirectScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     if (yPaintedBottom < 0)             yPaintedBottom = 0;
     if (yPaintedBottom > imageHeight) yPaintedBottom = imageHeight;
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = ( yPaintedBottom - yPaintedTop ) / numThreads;
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yPaintedTop +  i      * yStep;
-        const int yEnd   = yPaintedTop + (i + 1) * yStep;
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
+    RenderJob job( &m_canvasImage, viewport, mapQuality );
+    m_scheduler.start( &job, m_tileLoader, tileZoomLevel, yPaintedTop, yPaintedBottom );
 
     // Remove unused lines
     const int clearStart = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? yPaintedBottom : 0;
@@ -148,14 +133,14 @@ void EquirectScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
         *(it) = 0;
     }
 
-    m_threadPool.waitForDone();
+    m_scheduler.waitForDone();
 
     m_oldYPaintedTop = yPaintedTop;
 
     m_tileLoader->cleanupTilehash();
 }
 
-void EquirectScanlineTextureMapper::RenderJob::run()
+void EquirectScanlineTextureMapper::RenderJob::renderBlock( ScanlineTextureMapperContext &context, int yPaintedTop, int yPaintedBottom )
 {
     // Scanline based algorithm to do texture mapping
 
@@ -189,14 +174,9 @@ void EquirectScanlineTextureMapper::RenderJob::run()
     const int maxInterpolationPointX = n * (int)( imageWidth / n - 1 ) + 1;
 
 
-    // initialize needed variables that are modified during texture mapping:
-
-    ScanlineTextureMapperContext context( m_tileLoader, m_tileLevel );
-
-
     // Scanline based algorithm to do texture mapping
 
-    for ( int y = m_yPaintedTop; y < m_yPaintedBottom; ++y ) {
+    for ( int y = yPaintedTop; y < yPaintedBottom; ++y ) {
 
         QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) );
 
@@ -240,7 +220,7 @@ void EquirectScanlineTextureMapper::RenderJob::run()
         }
 
         // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yPaintedBottom ) { 
+        if ( interlaced && y + 1 < yPaintedBottom ) { 
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
@@ -251,3 +231,8 @@ void EquirectScanlineTextureMapper::RenderJob::run()
         }
     }
 }
+
+QString EquirectScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.statistics().toString();
+}
@@ -15,6 +15,7 @@
 
 
 #include "TextureMapperInterface.h"
+#include "ScanlineRenderScheduler.h"
 
 #include "MarbleGlobal.h"
 
@@ -37,6 +38,8 @@ class EquirectScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer ) override;
 
+    QString runtimeTrace() const override;
+
  private:
     void mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
 
@@ -48,6 +51,7 @@ class EquirectScanlineTextureMapper : public TextureMapperInterface
     QImage m_canvasImage;
     int    m_oldYPaintedTop;
     QThreadPool m_threadPool;
+    ScanlineRenderScheduler m_scheduler;
 };
 
 }
@@ -12,7 +12,10 @@
 
 #include <QBuffer>
 #include <QDataStream>
+#include <QElapsedTimer>
+#include <QEventLoop>
 #include <QFile>
+#include <QMutex>
 #include <QThread>
 
 #include "GeoDataParser.h"
@@ -30,6 +33,7 @@
 #include "MarbleDirs.h"
 #include "MarbleDebug.h"
 #include "MarbleModel.h"
+#include "ParsedDocumentCache.h"
 #include "ParsingRunnerManager.h"
 
 namespace Marble
@@ -41,7 +45,7 @@ public:
     FileLoaderPrivate( FileLoader* parent, const PluginManager *pluginManager, bool recenter,
                        const QString& file, const QString& property, const GeoDataStyle::Ptr &style, DocumentRole role, int renderOrder )
         : q( parent),
-          m_runner( pluginManager ),
+          m_pluginManager( pluginManager ),
           m_recenter( recenter ),
           m_filepath ( file ),
           m_property( property ),
@@ -49,7 +53,8 @@ public:
           m_documentRole ( role ),
           m_styleMap( new GeoDataStyleMap ),
           m_document( 0 ),
-          m_renderOrder( renderOrder )
+          m_renderOrder( renderOrder ),
+          m_loadingTime( 0 )
     {
         if( m_style ) {
             m_styleMap->setId(QStringLiteral("default-map"));
@@ -60,13 +65,15 @@ public:
     FileLoaderPrivate( FileLoader* parent, const PluginManager *pluginManager,
                        const QString& contents, const QString& file, DocumentRole role )
         : q( parent ),
-          m_runner( pluginManager ),
+          m_pluginManager( pluginManager ),
           m_recenter( false ),
           m_filepath ( file ),
           m_contents ( contents ),
           m_documentRole ( role ),
           m_styleMap( 0 ),
-          m_document( 0 )
+          m_document( 0 ),
+          m_renderOrder( 0 ),
+          m_loadingTime( 0 )
     {
     }
 
@@ -80,10 +87,12 @@ public:
     static int spacePopIdx( qint64 population );
     static int areaPopIdx( qreal area );
 
-    void documentParsed( GeoDataDocument *doc, const QString& error);
+    void documentParsed( const QString &sourceFile, GeoDataDocument *doc, const QString& error );
+    void parseFile( const QString &sourceFile );
+    QByteArray snapshotVariant() const;
 
     FileLoader *q;
-    ParsingRunnerManager m_runner;
+    const PluginManager *const m_pluginManager;
     bool m_recenter;
     QString m_filepath;
     QString m_contents;
@@ -94,6 +103,7 @@ public:
     GeoDataDocument *m_document;
     QString m_error;
     int m_renderOrder;
+    qint64 m_loadingTime;
 };
 
 FileLoader::FileLoader( QObject* parent, const PluginManager *pluginManager, bool recenter, const QString& file,
@@ -130,8 +140,16 @@ QString FileLoader::error() const
     return d->m_error;
 }
 
+qint64 FileLoader::loadingTime() const
+{
+    return d->m_loadingTime;
+}
+
 void FileLoader::run()
 {
+    QElapsedTimer timer;
+    timer.start();
+
     if ( d->m_contents.isEmpty() ) {
         QString defaultSourceName;
 
@@ -164,12 +182,22 @@ void FileLoader::run()
         }
 
         if ( QFile::exists( defaultSourceName ) ) {
-            mDebug() << "No recent Default Placemark Cache File available!";
+            // map data doesn't change between runs, so it is loaded from a snapshot
+            // of the document created the first time the file was parsed
+            GeoDataDocument *document = 0;
+            if ( d->m_documentRole == MapDocument ) {
+                document = ParsedDocumentCache().load( defaultSourceName, d->snapshotVariant() );
+            }
 
-            // use runners: pnt, gpx, osm
-            connect( &d->m_runner, SIGNAL(parsingFinished(GeoDataDocument*,QString)),
-                    this, SLOT(documentParsed(GeoDataDocument*,QString)) );
-            d->m_runner.parseFile( defaultSourceName, d->m_documentRole );
+            if ( document ) {
+                mDebug() << "loaded snapshot of" << defaultSourceName;
+                d->m_document = document;
+                document->setProperty( d->m_property );
+                document->setDocumentRole( d->m_documentRole );
+                emit newGeoDataDocumentAdded( d->m_document );
+            } else {
+                d->parseFile( defaultSourceName );
+            }
         }
         else {
             mDebug() << "No Default Placemark Source File for " << name;
@@ -185,25 +213,25 @@ void FileLoader::run()
 
         if ( !parser.read( &buffer ) ) {
             qWarning( "Could not import kml buffer!" );
-            emit loaderFinished( this );
-            return;
-        }
-
-        GeoDocument* document = parser.releaseDocument();
-        Q_ASSERT( document );
+        } else {
+            GeoDocument* document = parser.releaseDocument();
+            Q_ASSERT( document );
 
-        d->m_document = static_cast<GeoDataDocument*>( document );
-        d->m_document->setProperty( d->m_property );
-        d->m_document->setDocumentRole( d->m_documentRole );
-        d->createFilterProperties( d->m_document );
-        buffer.close();
+            d->m_document = static_cast<GeoDataDocument*>( document );
+            d->m_document->setProperty( d->m_property );
+            d->m_document->setDocumentRole( d->m_documentRole );
+            d->createFilterProperties( d->m_document );
 
-        mDebug() << "newGeoDataDocumentAdded" << d->m_filepath;
+            mDebug() << "newGeoDataDocumentAdded" << d->m_filepath;
 
-        emit newGeoDataDocumentAdded( d->m_document );
-        emit loaderFinished( this );
+            emit newGeoDataDocumentAdded( d->m_document );
+        }
+        buffer.close();
     }
 
+    // every loader reports back exactly once, also when there was nothing to load
+    d->m_loadingTime = timer.elapsed();
+    emit loaderFinished( this );
 }
 
 bool FileLoader::recenter() const
@@ -211,7 +239,51 @@ bool FileLoader::recenter() const
     return d->m_recenter;
 }
 
-void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& error )
+void FileLoaderPrivate::parseFile( const QString &sourceFile )
+{
+    // use runners: pnt, gpx, osm
+    // The results are collected in this thread, so that the snapshot of the
+    // document is written here rather than in the main thread.
+    ParsingRunnerManager runner( m_pluginManager );
+    QEventLoop localEventLoop;
+    QMutex mutex;
+    GeoDataDocument *document = 0;
+    QString error;
+    typedef void ( ParsingRunnerManager::*ParsingFinished )( GeoDataDocument *, const QString & );
+    QObject::connect( &runner, static_cast<ParsingFinished>( &ParsingRunnerManager::parsingFinished ),
+                      &localEventLoop, [&]( GeoDataDocument *result, const QString &message ) {
+        QMutexLocker locker( &mutex );
+        if ( result && !document ) {
+            document = result;
+        } else {
+            delete result;
+        }
+        if ( error.isEmpty() ) {
+            error = message;
+        }
+    }, Qt::DirectConnection );
+    QObject::connect( &runner, SIGNAL(parsingFinished()),
+                      &localEventLoop, SLOT(quit()), Qt::QueuedConnection );
+
+    runner.parseFile( sourceFile, m_documentRole );
+    localEventLoop.exec();
+
+    documentParsed( sourceFile, document, document ? QString() : error );
+}
+
+QByteArray FileLoaderPrivate::snapshotVariant() const
+{
+    // everything besides the source file that goes into the document
+    QByteArray variant;
+    QDataStream stream( &variant, QIODevice::WriteOnly );
+    stream << m_property << int( m_documentRole ) << m_renderOrder;
+    if ( m_style ) {
+        m_style->pack( stream );
+    }
+    return variant;
+}
+
+void FileLoaderPrivate::documentParsed( const QString &sourceFile, GeoDataDocument* doc, const QString& error )
 {
     m_error = error;
     if ( doc ) {
@@ -232,9 +304,13 @@ void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& err
         }
 
         createFilterProperties( doc );
+
+        if ( m_documentRole == MapDocument ) {
+            ParsedDocumentCache().save( sourceFile, snapshotVariant(), *doc );
+        }
+
         emit q->newGeoDataDocumentAdded( m_document );
     }
-    emit q->loaderFinished( q );
 }
 
 void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
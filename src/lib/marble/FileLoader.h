@@ -38,13 +38,17 @@ class FileLoader : public QThread
         GeoDataDocument *document();
         QString error() const;
 
+        /**
+         * Returns how long loading took in milliseconds, including the post-processing
+         * of the document. Valid once loaderFinished() was emitted.
+         */
+        qint64 loadingTime() const;
+
     Q_SIGNALS:
         void loaderFinished( FileLoader* );
         void newGeoDataDocumentAdded( GeoDataDocument* );
 
 private:
-        Q_PRIVATE_SLOT ( d, void documentParsed( GeoDataDocument *, QString) )
-
         friend class FileLoaderPrivate;
 
         FileLoaderPrivate *d;
@@ -13,6 +13,7 @@
 
 #include <QFileInfo>
 #include <QTime>
+#include <QTimer>
 #include <QMessageBox>
 
 #include "FileLoader.h"
@@ -37,8 +38,14 @@ public:
     FileManagerPrivate( GeoDataTreeModel *treeModel, const PluginManager *pluginManager, FileManager* parent ) :
         q( parent ),
         m_treeModel( treeModel ),
-        m_pluginManager( pluginManager )
+        m_pluginManager( pluginManager ),
+        m_loadedFiles( 0 ),
+        m_totalFiles( 0 )
     {
+        // documents finishing close to each other go into the tree model together
+        m_batchTimer.setSingleShot( true );
+        m_batchTimer.setInterval( 100 );
+        QObject::connect( &m_batchTimer, SIGNAL(timeout()), q, SLOT(addPendingDocuments()) );
     }
 
     ~FileManagerPrivate()
@@ -48,17 +55,32 @@ public:
                 loader->wait();
             }
         }
+        for ( const PendingDocument &pending: m_pendingDocuments ) {
+            delete pending.document;
+        }
     }
 
     void appendLoader( FileLoader *loader );
     void closeFile( const QString &key );
     void cleanupLoader( FileLoader *loader );
+    void addPendingDocuments();
+
+    struct PendingDocument
+    {
+        QString path;
+        GeoDataDocument *document;
+        bool recenter;
+    };
 
     FileManager *const q;
     GeoDataTreeModel *const m_treeModel;
     const PluginManager *const m_pluginManager;
 
     QList<FileLoader*> m_loaderList;
+    QVector<PendingDocument> m_pendingDocuments;
+    QTimer m_batchTimer;
+    int m_loadedFiles;
+    int m_totalFiles;
     QHash < QString, GeoDataDocument* > m_fileItemHash;
     GeoDataLatLonBox m_latLonBox;
     QTime m_timer;
@@ -88,9 +110,16 @@ void FileManager::addFile( const QString& filepath, const QString& property, con
             return;  // currently loading
     }
 
+    for ( const FileManagerPrivate::PendingDocument &pending: d->m_pendingDocuments ) {
+        if ( pending.path == filepath )
+            return;  // loaded, but not added yet
+    }
+
     mDebug() << "adding container:" << filepath;
-    mDebug() << "Starting placemark loading timer";
-    d->m_timer.start();
+    if ( d->m_totalFiles == 0 ) {
+        mDebug() << "Starting placemark loading timer";
+        d->m_timer.start();
+    }
     FileLoader* loader = new FileLoader( this, d->m_pluginManager, recenter, filepath, property, style, role, renderOrder );
     d->appendLoader( loader );
 }
@@ -107,6 +136,7 @@ void FileManagerPrivate::appendLoader( FileLoader *loader )
              q, SLOT(cleanupLoader(FileLoader*)) );
 
     m_loaderList.append( loader );
+    ++m_totalFiles;
     loader->start();
 }
 
@@ -117,7 +147,18 @@ void FileManager::removeFile( const QString& key )
             disconnect( loader, 0, this, 0 );
             loader->wait();
             d->m_loaderList.removeAll( loader );
+            --d->m_totalFiles;
             delete loader->document();
+            // a queued loaderFinished() may still be on its way to cleanupLoader()
+            loader->deleteLater();
+            return;
+        }
+    }
+
+    for ( int i = 0; i < d->m_pendingDocuments.size(); ++i ) {
+        if ( d->m_pendingDocuments[i].path == key ) {
+            delete d->m_pendingDocuments[i].document;
+            d->m_pendingDocuments.remove( i );
             return;
         }
     }
@@ -175,38 +216,79 @@ GeoDataDocument * FileManager::at( const QString &key )
 
 int FileManager::pendingFiles() const
 {
-    return d->m_loaderList.size();
+    return d->m_loaderList.size() + d->m_pendingDocuments.size();
 }
 
 void FileManagerPrivate::cleanupLoader( FileLoader* loader )
 {
+    if ( !m_loaderList.contains( loader ) ) {
+        // removed with removeFile() after it had finished already
+        return;
+    }
+
+    // loaderFinished() is emitted by the loader thread right before it ends
+    loader->wait();
     GeoDataDocument *doc = loader->document();
     m_loaderList.removeAll( loader );
-    if ( loader->isFinished() ) {
-        if ( doc ) {
-            if ( doc->name().isEmpty() && !doc->fileName().isEmpty() )
-            {
-                QFileInfo file( doc->fileName() );
-                doc->setName( file.baseName() );
-            }
-            m_treeModel->addDocument( doc );
-            m_fileItemHash.insert( loader->path(), doc );
-            emit q->fileAdded( loader->path() );
-            if( loader->recenter() ) {
-                m_latLonBox |= doc->latLonAltBox();
+
+    ++m_loadedFiles;
+    mDebug() << "Loaded" << loader->path() << "in" << loader->loadingTime() << "ms";
+    emit q->fileLoaded( loader->path(), loader->loadingTime() );
+    emit q->loadingProgress( m_loadedFiles, m_totalFiles );
+
+    if ( doc ) {
+        if ( doc->name().isEmpty() && !doc->fileName().isEmpty() )
+        {
+            QFileInfo file( doc->fileName() );
+            doc->setName( file.baseName() );
+        }
+        const PendingDocument pending = { loader->path(), doc, loader->recenter() };
+        m_pendingDocuments.append( pending );
+    }
+    const QString error = loader->error();
+    delete loader;
+
+    if ( m_loaderList.isEmpty() ) {
+        m_batchTimer.stop();
+        addPendingDocuments();
+    } else if ( !m_batchTimer.isActive() ) {
+        m_batchTimer.start();
+    }
+
+    if ( !error.isEmpty() ) {
+        QMessageBox errorBox;
+        errorBox.setWindowTitle( QObject::tr("File Parsing Error"));
+        errorBox.setText( error );
+        errorBox.setIcon( QMessageBox::Warning );
+        errorBox.exec();
+        qWarning() << "File Parsing error " << error;
+    }
+}
+
+void FileManagerPrivate::addPendingDocuments()
+{
+    if ( !m_pendingDocuments.isEmpty() ) {
+        // taken first, as the slots connected to fileAdded() may add further files
+        const QVector<PendingDocument> pendingDocuments = m_pendingDocuments;
+        m_pendingDocuments.clear();
+
+        QVector<GeoDataDocument *> documents;
+        documents.reserve( pendingDocuments.size() );
+        for ( const PendingDocument &pending: pendingDocuments ) {
+            documents << pending.document;
+            m_fileItemHash.insert( pending.path, pending.document );
+            if ( pending.recenter ) {
+                m_latLonBox |= pending.document->latLonAltBox();
             }
         }
-        if ( !loader->error().isEmpty() ) {
-            QMessageBox errorBox;
-            errorBox.setWindowTitle( QObject::tr("File Parsing Error"));
-            errorBox.setText( loader->error() );
-            errorBox.setIcon( QMessageBox::Warning );
-            errorBox.exec();
-            qWarning() << "File Parsing error " << loader->error();
+        m_treeModel->addDocuments( documents );
+
+        for ( const PendingDocument &pending: pendingDocuments ) {
+            emit q->fileAdded( pending.path );
         }
-        delete loader;
     }
-    if ( m_loaderList.isEmpty()  )
+
+    if ( m_loaderList.isEmpty() && m_pendingDocuments.isEmpty() && m_totalFiles > 0 )
     {
         mDebug() << "Finished loading all placemarks " << m_timer.elapsed();
 
@@ -214,6 +296,8 @@ void FileManagerPrivate::cleanupLoader( FileLoader* loader )
             emit q->centeredDocument( m_latLonBox );
         }
         m_latLonBox.clear();
+        m_loadedFiles = 0;
+        m_totalFiles = 0;
     }
 }
 
@@ -81,9 +81,22 @@ class FileManager : public QObject
     void fileRemoved( const QString &key );
     void centeredDocument( const GeoDataLatLonBox& );
 
+    /**
+     * Emitted for each file once it is loaded, before it is added to the tree model.
+     * @param loadingTime the time parsing or reading its snapshot took, in milliseconds
+     */
+    void fileLoaded( const QString &key, qint64 loadingTime );
+
+    /**
+     * Emitted whenever a file is loaded. @p loadedFiles counts up to @p totalFiles,
+     * the number of files added since the manager was idle the last time.
+     */
+    void loadingProgress( int loadedFiles, int totalFiles );
+
  private:
 
     Q_PRIVATE_SLOT( d, void cleanupLoader( FileLoader *loader ) )
+    Q_PRIVATE_SLOT( d, void addPendingDocuments() )
 
     Q_DISABLE_COPY( FileManager )
 
@@ -13,10 +13,12 @@
 
 #include "StoragePolicy.h"
 
+#include "marble_export.h"
+
 namespace Marble
 {
 
-class FileStoragePolicy : public StoragePolicy
+class MARBLE_EXPORT FileStoragePolicy : public StoragePolicy
 {
     Q_OBJECT
     
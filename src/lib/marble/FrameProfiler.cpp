@@ -0,0 +1,386 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "FrameProfiler.h"
+
+#include "MarbleDebug.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+static const int DefaultFrameCount = 120;
+
+// Bounds the memory taken by frames with lots of small scopes
+static const int MaximumEventsPerFrame = 50000;
+
+static QBasicAtomicInt s_enabled = Q_BASIC_ATOMIC_INITIALIZER( 0 );
+
+class FrameProfilerData
+{
+public:
+    FrameProfilerData();
+
+    void reset( int frameCount );
+    int thread();
+    FrameProfiler::Frame &currentFrame();
+
+    QMutex m_mutex;
+    QElapsedTimer m_timer;
+
+    // Ring buffer of the last frames, m_current being the one painted now
+    QVector<FrameProfiler::Frame> m_frames;
+    int m_current;
+    int m_used;
+    qint64 m_frameNumber;
+
+    QHash<Qt::HANDLE, int> m_threads;
+};
+
+FrameProfilerData::FrameProfilerData() :
+    m_current( 0 ),
+    m_used( 0 ),
+    m_frameNumber( 0 )
+{
+    m_timer.start();
+    reset( DefaultFrameCount );
+}
+
+void FrameProfilerData::reset( int frameCount )
+{
+    const FrameProfiler::Frame empty = { 0, 0, -1, QVector<FrameProfiler::Event>(), 0 };
+    m_frames.fill( empty, frameCount );
+    m_frameNumber = 0;
+    m_current = 0;
+    m_used = 1;
+    // The thread resetting the profiler is the one painting the frames
+    m_threads.clear();
+    thread();
+
+    // Whatever happens before the first frame is recorded into frame 0
+    m_frames[0].start = m_timer.nsecsElapsed();
+}
+
+int FrameProfilerData::thread()
+{
+    const Qt::HANDLE id = QThread::currentThreadId();
+    QHash<Qt::HANDLE, int>::const_iterator it = m_threads.constFind( id );
+    if ( it != m_threads.constEnd() ) {
+        return it.value();
+    }
+    const int index = m_threads.size();
+    m_threads.insert( id, index );
+    return index;
+}
+
+FrameProfiler::Frame &FrameProfilerData::currentFrame()
+{
+    return m_frames[m_current];
+}
+
+Q_GLOBAL_STATIC( FrameProfilerData, s_data )
+
+bool FrameProfiler::isEnabled()
+{
+    return s_enabled.load() != 0;
+}
+
+void FrameProfiler::setEnabled( bool enabled )
+{
+    if ( enabled == isEnabled() ) {
+        return;
+    }
+
+    FrameProfilerData *const data = s_data();
+    QMutexLocker locker( &data->m_mutex );
+    if ( enabled ) {
+        data->reset( data->m_frames.size() );
+    }
+    s_enabled.store( enabled ? 1 : 0 );
+}
+
+int FrameProfiler::frameCount()
+{
+    FrameProfilerData *const data = s_data();
+    QMutexLocker locker( &data->m_mutex );
+    return data->m_frames.size();
+}
+
+void FrameProfiler::setFrameCount( int count )
+{
+    FrameProfilerData *const data = s_data();
+    QMutexLocker locker( &data->m_mutex );
+    data->reset( qMax( 1, count ) );
+}
+
+void FrameProfiler::beginFrame()
+{
+    if ( !isEnabled() ) {
+        return;
+    }
+
+    FrameProfilerData *const data = s_data();
+    QMutexLocker locker( &data->m_mutex );
+    data->m_current = ( data->m_current + 1 ) % data->m_frames.size();
+    data->m_used = qMin( data->m_used + 1, data->m_frames.size() );
+
+    Frame &frame = data->currentFrame();
+    frame.number = ++data->m_frameNumber;
+    frame.start = data->m_timer.nsecsElapsed();
+    frame.duration = -1;
+    frame.events.resize( 0 );
+    frame.droppedEvents = 0;
+}
+
+void FrameProfiler::endFrame()
+{
+    if ( !isEnabled() ) {
+        return;
+    }
+
+    FrameProfilerData *const data = s_data();
+    QMutexLocker locker( &data->m_mutex );
+    Frame &frame = data->currentFrame();
+    frame.duration = data->m_timer.nsecsElapsed() - frame.start;
+}
+
+QVector<FrameProfiler::Frame> FrameProfiler::frames()
+{
+    FrameProfilerData *const data = s_data();
+    QMutexLocker locker( &data->m_mutex );
+
+    QVector<Frame> result;
+    result.reserve( data->m_used );
+    const int size = data->m_frames.size();
+    for ( int i = data->m_used - 1; i >= 0; --i ) {
+        result.append( data->m_frames[( data->m_current - i + size ) % size] );
+    }
+    return result;
+}
+
+QByteArray FrameProfiler::chromeTrace()
+{
+    const QVector<Frame> recorded = frames();
+
+    QJsonArray events;
+    int threadCount = 1;
+    for ( const Frame &frame: recorded ) {
+        if ( frame.number > 0 ) {
+            QJsonObject args;
+            args.insert( QStringLiteral( "frame" ), frame.number );
+            if ( frame.droppedEvents > 0 ) {
+                args.insert( QStringLiteral( "droppedEvents" ), frame.droppedEvents );
+            }
+            QJsonObject event;
+            event.insert( QStringLiteral( "name" ), QStringLiteral( "Frame" ) );
+            event.insert( QStringLiteral( "cat" ), QStringLiteral( "frame" ) );
+            event.insert( QStringLiteral( "ph" ), QStringLiteral( "X" ) );
+            event.insert( QStringLiteral( "ts" ), frame.start / 1000.0 );
+            event.insert( QStringLiteral( "dur" ), qMax<qint64>( 0, frame.duration ) / 1000.0 );
+            event.insert( QStringLiteral( "pid" ), 1 );
+            event.insert( QStringLiteral( "tid" ), 0 );
+            event.insert( QStringLiteral( "args" ), args );
+            events.append( event );
+        }
+
+        for ( const Event &profiled: frame.events ) {
+            QJsonObject args;
+            args.insert( QStringLiteral( "frame" ), frame.number );
+            if ( !profiled.detail.isEmpty() ) {
+                args.insert( QStringLiteral( "detail" ), profiled.detail );
+            }
+            QJsonObject event;
+            event.insert( QStringLiteral( "name" ), QString::fromLatin1( profiled.name ) );
+            event.insert( QStringLiteral( "cat" ), QStringLiteral( "marble" ) );
+            event.insert( QStringLiteral( "ph" ), QStringLiteral( "X" ) );
+            event.insert( QStringLiteral( "ts" ), profiled.start / 1000.0 );
+            event.insert( QStringLiteral( "dur" ), profiled.duration / 1000.0 );
+            event.insert( QStringLiteral( "pid" ), 1 );
+            event.insert( QStringLiteral( "tid" ), profiled.thread );
+            event.insert( QStringLiteral( "args" ), args );
+            events.append( event );
+            threadCount = qMax( threadCount, profiled.thread + 1 );
+        }
+    }
+
+    for ( int i = 0; i < threadCount; ++i ) {
+        QJsonObject args;
+        args.insert( QStringLiteral( "name" ), i == 0 ? QStringLiteral( "Main" ) : QStringLiteral( "Thread %1" ).arg( i ) );
+        QJsonObject event;
+        event.insert( QStringLiteral( "name" ), QStringLiteral( "thread_name" ) );
+        event.insert( QStringLiteral( "ph" ), QStringLiteral( "M" ) );
+        event.insert( QStringLiteral( "pid" ), 1 );
+        event.insert( QStringLiteral( "tid" ), i );
+        event.insert( QStringLiteral( "args" ), args );
+        events.append( event );
+    }
+
+    QJsonObject trace;
+    trace.insert( QStringLiteral( "traceEvents" ), events );
+    trace.insert( QStringLiteral( "displayTimeUnit" ), QStringLiteral( "ns" ) );
+    return QJsonDocument( trace ).toJson( QJsonDocument::Compact );
+}
+
+namespace
+{
+
+struct ScopeSummary
+{
+    QByteArray name;
+    int calls;
+    qint64 total;
+    qint64 minimum;
+    qint64 maximum;
+
+    void add( qint64 duration )
+    {
+        if ( calls == 0 || duration < minimum ) {
+            minimum = duration;
+        }
+        if ( calls == 0 || duration > maximum ) {
+            maximum = duration;
+        }
+        total += duration;
+        ++calls;
+    }
+};
+
+QByteArray milliseconds( qint64 nanoseconds )
+{
+    return QByteArray::number( nanoseconds / 1000000.0, 'f', 3 );
+}
+
+}
+
+QByteArray FrameProfiler::csvSummary()
+{
+    const QVector<Frame> recorded = frames();
+
+    const ScopeSummary empty = { QByteArray(), 0, 0, 0, 0 };
+    ScopeSummary frameSummary = empty;
+    frameSummary.name = "Frame";
+    QHash<QByteArray, ScopeSummary> summaries;
+    for ( const Frame &frame: recorded ) {
+        if ( frame.number > 0 && frame.duration >= 0 ) {
+            frameSummary.add( frame.duration );
+        }
+        for ( const Event &event: frame.events ) {
+            const QByteArray name( event.name );
+            QHash<QByteArray, ScopeSummary>::iterator it = summaries.find( name );
+            if ( it == summaries.end() ) {
+                it = summaries.insert( name, empty );
+                it->name = name;
+            }
+            it->add( event.duration );
+        }
+    }
+
+    QVector<ScopeSummary> sorted;
+    sorted.reserve( summaries.size() + 1 );
+    if ( frameSummary.calls > 0 ) {
+        sorted << frameSummary;
+    }
+    QVector<ScopeSummary> scopes = summaries.values().toVector();
+    std::sort( scopes.begin(), scopes.end(), []( const ScopeSummary &one, const ScopeSummary &two ) {
+        return one.total > two.total;
+    } );
+    sorted << scopes;
+
+    QByteArray csv = "name,calls,total_ms,mean_ms,min_ms,max_ms\n";
+    for ( const ScopeSummary &summary: sorted ) {
+        csv += '"' + summary.name + "\"," + QByteArray::number( summary.calls ) + ','
+                + milliseconds( summary.total ) + ',' + milliseconds( summary.total / summary.calls ) + ','
+                + milliseconds( summary.minimum ) + ',' + milliseconds( summary.maximum ) + '\n';
+    }
+    return csv;
+}
+
+static bool writeFile( const QString &fileName, const QByteArray &contents )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) || file.write( contents ) != contents.size() ) {
+        mDebug() << "Unable to write the frame profile to" << fileName << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool FrameProfiler::writeChromeTrace( const QString &fileName )
+{
+    return writeFile( fileName, chromeTrace() );
+}
+
+bool FrameProfiler::writeCsvSummary( const QString &fileName )
+{
+    return writeFile( fileName, csvSummary() );
+}
+
+qint64 FrameProfiler::now()
+{
+    return s_data()->m_timer.nsecsElapsed();
+}
+
+void FrameProfiler::record( const char *name, const QString &detail, qint64 start, qint64 end )
+{
+    if ( !isEnabled() ) {
+        return;
+    }
+
+    FrameProfilerData *const data = s_data();
+    QMutexLocker locker( &data->m_mutex );
+    Frame &frame = data->currentFrame();
+    if ( frame.events.size() >= MaximumEventsPerFrame ) {
+        ++frame.droppedEvents;
+        return;
+    }
+    const Event event = { name, detail, data->thread(), start, end - start };
+    frame.events.append( event );
+}
+
+FrameProfilerScope::FrameProfilerScope( const char *name, bool measure ) :
+    m_name( name ),
+    m_recording( FrameProfiler::isEnabled() ),
+    m_start( m_recording || measure ? FrameProfiler::now() : -1 )
+{
+}
+
+FrameProfilerScope::~FrameProfilerScope()
+{
+    if ( m_recording ) {
+        FrameProfiler::record( m_name, m_detail, m_start, FrameProfiler::now() );
+    }
+}
+
+bool FrameProfilerScope::isRecording() const
+{
+    return m_recording;
+}
+
+void FrameProfilerScope::setDetail( const QString &detail )
+{
+    m_detail = detail;
+}
+
+qint64 FrameProfilerScope::elapsed() const
+{
+    return m_start < 0 ? 0 : FrameProfiler::now() - m_start;
+}
+
+}
@@ -0,0 +1,154 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_FRAMEPROFILER_H
+#define MARBLE_FRAMEPROFILER_H
+
+#include "marble_export.h"
+
+#include <QString>
+#include <QVector>
+
+class QByteArray;
+
+namespace Marble
+{
+
+/**
+ * @short Records how long the parts of each rendered frame take.
+ *
+ * Code to profile is wrapped into a FrameProfilerScope.  While the profiler
+ * is enabled, every scope leaving records its name, thread, start and
+ * duration in nanoseconds into the current frame.  Scopes of other threads,
+ * like tile loading and parsing, end up in the frame painted meanwhile.
+ *
+ * The last frameCount() frames are kept and can be exported as a Chrome
+ * trace event file (to be opened in chrome://tracing) or as a CSV summary
+ * of the scopes.  While disabled, scopes do not do more than checking
+ * isEnabled().
+ */
+class MARBLE_EXPORT FrameProfiler
+{
+public:
+    struct Event
+    {
+        const char *name;
+        QString detail;
+        int thread;
+        qint64 start;
+        qint64 duration;
+    };
+
+    struct Frame
+    {
+        qint64 number;
+        qint64 start;
+        qint64 duration;
+        QVector<Event> events;
+        int droppedEvents;
+    };
+
+    static bool isEnabled();
+
+    /**
+     * Enables or disables profiling.  Enabling it discards the frames
+     * recorded before.
+     */
+    static void setEnabled( bool enabled );
+
+    /**
+     * The number of frames kept, 120 by default.
+     */
+    static int frameCount();
+    static void setFrameCount( int count );
+
+    /**
+     * Marks the beginning and the end of a frame painted in the main thread.
+     */
+    static void beginFrame();
+    static void endFrame();
+
+    /**
+     * Returns the recorded frames, the oldest first.
+     */
+    static QVector<Frame> frames();
+
+    /**
+     * Returns the recorded frames in the Chrome trace event format.
+     */
+    static QByteArray chromeTrace();
+
+    /**
+     * Returns the number of calls and the total, mean, minimum and maximum
+     * duration of each scope in the recorded frames as CSV, the most
+     * expensive scopes first.
+     */
+    static QByteArray csvSummary();
+
+    static bool writeChromeTrace( const QString &fileName );
+    static bool writeCsvSummary( const QString &fileName );
+
+    /**
+     * Returns the nanoseconds passed since an arbitrary point in time.
+     */
+    static qint64 now();
+
+private:
+    friend class FrameProfilerScope;
+    static void record( const char *name, const QString &detail, qint64 start, qint64 end );
+};
+
+/**
+ * @short Measures the lifetime of a profiled scope.
+ *
+ * Usage:
+ * @code
+ *   FrameProfilerScope scope( "TextureMapper::mapTexture" );
+ * @endcode
+ *
+ * @p name has to stay valid as long as the profiler is used, usually it is
+ * a string literal.
+ */
+class MARBLE_EXPORT FrameProfilerScope
+{
+public:
+    /**
+     * Starts measuring if the profiler is enabled.  Pass @p measure to
+     * measure the scope for elapsed() in any case.
+     */
+    explicit FrameProfilerScope( const char *name, bool measure = false );
+    ~FrameProfilerScope();
+
+    /**
+     * Returns whether the scope is going to be recorded.
+     */
+    bool isRecording() const;
+
+    /**
+     * Attaches @p detail, like the file name parsed, to the recorded event.
+     */
+    void setDetail( const QString &detail );
+
+    /**
+     * Returns the nanoseconds passed since the scope began, or 0 if it is
+     * not measured.
+     */
+    qint64 elapsed() const;
+
+private:
+    Q_DISABLE_COPY( FrameProfilerScope )
+
+    const char *const m_name;
+    QString m_detail;
+    const bool m_recording;
+    const qint64 m_start;
+};
+
+}
+
+#endif
@@ -16,13 +16,13 @@
 
 // Qt
 #include <qmath.h>
-#include <QRunnable>
 #include <QImage>
 
 // Marble
 #include "GeoPainter.h"
 #include "MarbleDirs.h"
 #include "MarbleDebug.h"
+#include "ScanlineRenderScheduler.h"
 #include "ScanlineTextureMapperContext.h"
 #include "StackedTileLoader.h"
 #include "TextureColorizer.h"
@@ -33,31 +33,23 @@
 
 using namespace Marble;
 
-class GenericScanlineTextureMapper::RenderJob : public QRunnable
+class GenericScanlineTextureMapper::RenderJob : public ScanlineRenderScheduler::Job
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality );
 
-    void run() override;
+    void renderBlock( ScanlineTextureMapperContext &context, int yTop, int yBottom ) override;
 
 private:
-    StackedTileLoader *const m_tileLoader;
-    const int m_tileLevel;
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    const int m_yTop;
-    const int m_yBottom;
 };
 
-GenericScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
-    : m_tileLoader( tileLoader ),
-      m_tileLevel( tileLevel ),
-      m_canvasImage( canvasImage ),
+GenericScanlineTextureMapper::RenderJob::RenderJob( QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality )
+    : m_canvasImage( canvasImage ),
       m_viewport( viewport ),
-      m_mapQuality( mapQuality ),
-      m_yTop( yTop ),
-      m_yBottom( yBottom )
+      m_mapQuality( mapQuality )
 {
 }
 
@@ -67,6 +59,7 @@ GenericScanlineTextureMapper::GenericScanlineTextureMapper( StackedTileLoader *t
     , m_tileLoader( tileLoader )
     , m_radius( 0 )
     , m_threadPool()
+    , m_scheduler( &m_threadPool )
 {
 }
 
@@ -125,21 +118,15 @@ void GenericScanlineTextureMapper::mapTexture( const ViewportParams *viewport, i
     const int yBottom = ( yTop == 0 ) ? imageHeight - skip
                                       : yTop + radius + radius - skip;
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = qCeil(qreal( yBottom - yTop ) / qreal(numThreads));
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yTop +  i      * yStep;
-        const int yEnd   = qMin(yBottom, yTop + (i + 1) * yStep);
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
+    RenderJob job( &m_canvasImage, viewport, mapQuality );
+    m_scheduler.start( &job, m_tileLoader, tileZoomLevel, yTop, yBottom );
 
-    m_threadPool.waitForDone();
+    m_scheduler.waitForDone();
 
     m_tileLoader->cleanupTilehash();
 }
 
-void GenericScanlineTextureMapper::RenderJob::run()
+void GenericScanlineTextureMapper::RenderJob::renderBlock( ScanlineTextureMapperContext &context, int yTop, int yBottom )
 {
     const int imageWidth  = m_canvasImage->width();
     const int imageHeight  = m_canvasImage->height();
@@ -161,13 +148,11 @@ void GenericScanlineTextureMapper::RenderJob::run()
 
     // initialize needed variables that are modified during texture mapping:
 
-    ScanlineTextureMapperContext context( m_tileLoader, m_tileLevel );
-
     qreal clipRadius = radius * m_viewport->currentProjection()->clippingRadius();
 
 
     // Paint the map.
-    for ( int y = m_yTop; y < m_yBottom; ++y ) {
+    for ( int y = yTop; y < yBottom; ++y ) {
 
         // rx is the radius component in x direction
         const int rx = (int)sqrt( (qreal)( clipRadius * clipRadius
@@ -260,7 +245,7 @@ void GenericScanlineTextureMapper::RenderJob::run()
         }
 
         // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yBottom ) {
+        if ( interlaced && y + 1 < yBottom ) {
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
@@ -271,3 +256,8 @@ void GenericScanlineTextureMapper::RenderJob::run()
         }
     }
 }
+
+QString GenericScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.statistics().toString();
+}
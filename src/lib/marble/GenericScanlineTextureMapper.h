@@ -13,6 +13,7 @@
 
 
 #include "TextureMapperInterface.h"
+#include "ScanlineRenderScheduler.h"
 
 #include <QThreadPool>
 #include <QImage>
@@ -36,6 +37,8 @@ class GenericScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer ) override;
 
+    QString runtimeTrace() const override;
+
  private:
     class RenderJob;
 
@@ -45,6 +48,7 @@ class GenericScanlineTextureMapper : public TextureMapperInterface
     int m_radius;
     QImage m_canvasImage;
     QThreadPool m_threadPool;
+    ScanlineRenderScheduler m_scheduler;
 };
 
 }
@@ -855,6 +855,25 @@ int GeoDataTreeModel::addDocument( GeoDataDocument *document )
     return addFeature( d->m_rootDocument, document );
 }
 
+void GeoDataTreeModel::addDocuments( const QVector<GeoDataDocument *> &documents )
+{
+    if ( documents.isEmpty() ) {
+        return;
+    }
+
+    const int first = d->m_rootDocument->size();
+    beginInsertRows( QModelIndex(), first, first + documents.size() - 1 );
+    for ( GeoDataDocument *document: documents ) {
+        d->m_rootDocument->append( document );
+    }
+    d->checkParenting( d->m_rootDocument );
+    endInsertRows();
+
+    for ( GeoDataDocument *document: documents ) {
+        emit added( document );
+    }
+}
+
 bool GeoDataTreeModel::removeFeature( GeoDataContainer *parent, int row )
 {
     if ( row<parent->size() ) {
@@ -14,6 +14,7 @@
 #include "marble_export.h"
 
 #include <QAbstractItemModel>
+#include <QVector>
 
 class QItemSelectionModel;
 
@@ -97,6 +98,12 @@ public Q_SLOTS:
 
     int addDocument( GeoDataDocument *document );
 
+    /**
+     * Appends all @p documents to the root document with a single row insertion,
+     * instead of one insertion per document.
+     */
+    void addDocuments( const QVector<GeoDataDocument *> &documents );
+
     void removeDocument( int index );
 
     void removeDocument( GeoDataDocument* document );
@@ -25,12 +25,44 @@
 #include <QMap>
 #include <QRect>
 
+#include <algorithm>
+
 namespace Marble
 {
 
 class GeoGraphicsScenePrivate
 {
 public:
+    /**
+     * An item in the tile it got sorted into. The box of the item is not
+     * kept here, it changes when the geometry of the item gets merged.
+     */
+    struct Entry {
+        quint64 code; // Morton code of the tile
+        GeoGraphicsItem *item; // 0 for removed items until the level gets compacted
+        int minZoomLevel;
+    };
+
+    /**
+     * The items of all tiles of one level in a single vector sorted by the
+     * Morton code of their tiles. Each quadtree node then is a contiguous
+     * range of it.
+     */
+    struct Level {
+        QVector<Entry> entries;
+        QVector<Entry> pending; // added since the last query, not sorted yet
+        int removed;
+
+        Level() : removed(0) {}
+        void flush();
+    };
+
+    struct Location {
+        GeoGraphicsItem *item;
+        int level;
+        quint64 code;
+    };
+
     GeoGraphicsScene *q;
     explicit GeoGraphicsScenePrivate(GeoGraphicsScene *parent) :
         q(parent)
@@ -42,9 +74,9 @@ public:
         q->clear();
     }
 
-    typedef QHash<const GeoDataFeature*,GeoGraphicsItem*> FeatureItemMap;
-    QHash<TileId, FeatureItemMap> m_tiledItems;
-    QMultiHash<const GeoDataFeature*, TileId> m_features; // multi hash because multi track and multi geometry insert multiple items
+    // Additions and removals are applied in batches by the next query
+    QVector<Level> m_levels;
+    QMultiHash<const GeoDataFeature*, Location> m_features; // multi hash because multi track and multi geometry insert multiple items
 
     // Stores the items which have been clicked;
     QList<GeoGraphicsItem*> m_selectedItems;
@@ -53,8 +85,131 @@ public:
 
     void selectItem( GeoGraphicsItem *item );
     void applyHighlightStyle(GeoGraphicsItem *item, const GeoDataStyle::Ptr &style );
+
+    void collectItems(const QVector<Entry> &entries, const QRect &tiles, const GeoDataLatLonBox &box,
+                      int zoomLevel, int level, int depth, quint32 x, quint32 y,
+                      QList<GeoGraphicsItem*> &result) const;
+
+    static quint64 mortonCode(quint32 x, quint32 y);
+    static quint32 mortonX(quint64 code);
+    static quint32 mortonY(quint64 code);
+    static bool codeLessThan(const Entry &entry, quint64 code);
+    static bool entryLessThan(const Entry &one, const Entry &two);
 };
 
+static quint64 spreadBits(quint32 value)
+{
+    quint64 x = value;
+    x = (x | (x << 16)) & Q_UINT64_C(0x0000FFFF0000FFFF);
+    x = (x | (x << 8)) & Q_UINT64_C(0x00FF00FF00FF00FF);
+    x = (x | (x << 4)) & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+    x = (x | (x << 2)) & Q_UINT64_C(0x3333333333333333);
+    x = (x | (x << 1)) & Q_UINT64_C(0x5555555555555555);
+    return x;
+}
+
+static quint32 compactBits(quint64 x)
+{
+    x &= Q_UINT64_C(0x5555555555555555);
+    x = (x | (x >> 1)) & Q_UINT64_C(0x3333333333333333);
+    x = (x | (x >> 2)) & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+    x = (x | (x >> 4)) & Q_UINT64_C(0x00FF00FF00FF00FF);
+    x = (x | (x >> 8)) & Q_UINT64_C(0x0000FFFF0000FFFF);
+    x = (x | (x >> 16)) & Q_UINT64_C(0x00000000FFFFFFFF);
+    return quint32(x);
+}
+
+quint64 GeoGraphicsScenePrivate::mortonCode(quint32 x, quint32 y)
+{
+    return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+quint32 GeoGraphicsScenePrivate::mortonX(quint64 code)
+{
+    return compactBits(code);
+}
+
+quint32 GeoGraphicsScenePrivate::mortonY(quint64 code)
+{
+    return compactBits(code >> 1);
+}
+
+bool GeoGraphicsScenePrivate::codeLessThan(const Entry &entry, quint64 code)
+{
+    return entry.code < code;
+}
+
+bool GeoGraphicsScenePrivate::entryLessThan(const Entry &one, const Entry &two)
+{
+    return one.code < two.code;
+}
+
+void GeoGraphicsScenePrivate::Level::flush()
+{
+    if (removed > 0) {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [](const Entry &entry) { return entry.item == nullptr; }),
+                      entries.end());
+        removed = 0;
+    }
+
+    if (!pending.isEmpty()) {
+        std::stable_sort(pending.begin(), pending.end(), entryLessThan);
+        auto const count = entries.size();
+        entries << pending;
+        std::inplace_merge(entries.begin(), entries.begin() + count, entries.end(), entryLessThan);
+        pending.clear();
+    }
+}
+
+void GeoGraphicsScenePrivate::collectItems(const QVector<Entry> &entries, const QRect &tiles, const GeoDataLatLonBox &box,
+                                           int zoomLevel, int level, int depth, quint32 x, quint32 y,
+                                           QList<GeoGraphicsItem*> &result) const
+{
+    // The quadtree node (x, y) at depth covers these tiles of the level
+    int const shift = level - depth;
+    qint64 const left = qint64(x) << shift;
+    qint64 const right = ((qint64(x) + 1) << shift) - 1;
+    qint64 const top = qint64(y) << shift;
+    qint64 const bottom = ((qint64(y) + 1) << shift) - 1;
+    if (right < tiles.left() || left > tiles.right() || bottom < tiles.top() || top > tiles.bottom()) {
+        return;
+    }
+
+    quint64 const first = mortonCode(x, y) << (2 * shift);
+    quint64 const last = first + ((quint64(1) << (2 * shift)) - 1);
+    auto const begin = std::lower_bound(entries.constBegin(), entries.constEnd(), first, codeLessThan);
+    if (begin == entries.constEnd() || begin->code > last) {
+        return;
+    }
+
+    bool const isInside = left >= tiles.left() && right <= tiles.right() && top >= tiles.top() && bottom <= tiles.bottom();
+    if (!isInside) {
+        for (quint32 i = 0; i < 4; ++i) {
+            collectItems(entries, tiles, box, zoomLevel, level, depth + 1, 2 * x + (i & 1), 2 * y + (i >> 1), result);
+        }
+        return;
+    }
+
+    // Only items in the tiles along the border may be outside of the box
+    bool const touchesBorder = left == tiles.left() || right == tiles.right() || top == tiles.top() || bottom == tiles.bottom();
+    for (auto iter = begin; iter != entries.constEnd() && iter->code <= last; ++iter) {
+        Entry const & entry = *iter;
+        if (!entry.item || entry.minZoomLevel > zoomLevel || !entry.item->visible()) {
+            continue;
+        }
+        if (touchesBorder) {
+            int const tileX = mortonX(entry.code);
+            int const tileY = mortonY(entry.code);
+            bool const isBorder = tileX == tiles.left() || tileX == tiles.right() || tileY == tiles.top() || tileY == tiles.bottom();
+            if (isBorder && !entry.item->latLonAltBox().intersects(box)) {
+                continue;
+            }
+        }
+        result.push_back(entry.item);
+    }
+}
+
 GeoDataStyle::Ptr GeoGraphicsScenePrivate::highlightStyle( const GeoDataDocument *document,
                                                        const GeoDataStyleMap &styleMap )
 {
@@ -113,6 +268,10 @@ QList< GeoGraphicsItem* > GeoGraphicsScene::items( const GeoDataLatLonBox &box,
     }
 
     QList< GeoGraphicsItem* > result;
+    if (box.isEmpty()) {
+        return result;
+    }
+
     QRect rect;
     qreal north, south, east, west;
     box.boundaries( north, south, east, west );
@@ -129,23 +288,12 @@ QList< GeoGraphicsItem* > GeoGraphicsScene::items( const GeoDataLatLonBox &box,
     TileCoordsPyramid pyramid( 0, zoomLevel );
     pyramid.setBottomLevelCoords( rect );
 
-    for ( int level = pyramid.topLevel(); level <= pyramid.bottomLevel(); ++level ) {
-        QRect const coords = pyramid.coords( level );
-        int x1, y1, x2, y2;
-        coords.getCoords( &x1, &y1, &x2, &y2 );
-        for ( int x = x1; x <= x2; ++x ) {
-            bool const isBorderX = x == x1 || x == x2;
-            for ( int y = y1; y <= y2; ++y ) {
-                bool const isBorder = isBorderX || y == y1 || y == y2;
-                const TileId tileId = TileId( 0, level, x, y );
-                for(GeoGraphicsItem *object: d->m_tiledItems.value( tileId )) {
-                    if (object->minZoomLevel() <= zoomLevel && object->visible()) {
-                        if (!isBorder || object->latLonAltBox().intersects(box)) {
-                            result.push_back(object);
-                        }
-                    }
-                }
-            }
+    int const bottomLevel = qMin(pyramid.bottomLevel(), d->m_levels.size() - 1);
+    for ( int level = pyramid.topLevel(); level <= bottomLevel; ++level ) {
+        GeoGraphicsScenePrivate::Level & tiles = d->m_levels[level];
+        tiles.flush();
+        if (!tiles.entries.isEmpty()) {
+            d->collectItems(tiles.entries, pyramid.coords( level ), box, zoomLevel, level, 0, 0, 0, result);
         }
     }
 
@@ -159,10 +307,8 @@ QList< GeoGraphicsItem* > GeoGraphicsScene::selectedItems() const
 
 void GeoGraphicsScene::resetStyle()
 {
-    for (auto const & items: d->m_tiledItems) {
-        for (auto item: items) {
-            item->resetStyle();
-        }
+    for (auto const & location: d->m_features) {
+        location.item->resetStyle();
     }
     emit repaintNeeded();
 }
@@ -186,40 +332,36 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
      * items to use highlight style
      */
     for( const GeoDataPlacemark *placemark: selectedPlacemarks ) {
-        for (auto tileIter = d->m_features.find(placemark); tileIter != d->m_features.end() && tileIter.key() == placemark; ++tileIter) {
-            auto const & clickedItems = d->m_tiledItems[*tileIter];
-            auto iter = clickedItems.find(placemark);
-            if (iter != clickedItems.end()) {
-                const GeoDataObject *parent = placemark->parent();
-                if ( parent ) {
-                    auto item = *iter;
-                    if ( parent->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
-                        const GeoDataDocument *doc = static_cast<const GeoDataDocument *>(parent);
-                        QString styleUrl = placemark->styleUrl();
-                        styleUrl.remove(QLatin1Char('#'));
-                        if ( !styleUrl.isEmpty() ) {
-                            GeoDataStyleMap const &styleMap = doc->styleMap( styleUrl );
+        for (auto iter = d->m_features.find(placemark); iter != d->m_features.end() && iter.key() == placemark; ++iter) {
+            const GeoDataObject *parent = placemark->parent();
+            if ( parent ) {
+                auto item = iter->item;
+                if ( parent->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
+                    const GeoDataDocument *doc = static_cast<const GeoDataDocument *>(parent);
+                    QString styleUrl = placemark->styleUrl();
+                    styleUrl.remove(QLatin1Char('#'));
+                    if ( !styleUrl.isEmpty() ) {
+                        GeoDataStyleMap const &styleMap = doc->styleMap( styleUrl );
+                        GeoDataStyle::Ptr style = d->highlightStyle( doc, styleMap );
+                        if ( style ) {
+                            d->selectItem( item );
+                            d->applyHighlightStyle( item, style );
+                        }
+                    }
+
+                    /**
+                        * If a placemark is using an inline style instead of a shared
+                        * style ( e.g in case when theme file specifies the colorMap
+                        * attribute ) then highlight it if any of the style maps have a
+                        * highlight styleId
+                        */
+                    else {
+                        for ( const GeoDataStyleMap &styleMap: doc->styleMaps() ) {
                             GeoDataStyle::Ptr style = d->highlightStyle( doc, styleMap );
                             if ( style ) {
                                 d->selectItem( item );
                                 d->applyHighlightStyle( item, style );
-                            }
-                        }
-
-                        /**
-                            * If a placemark is using an inline style instead of a shared
-                            * style ( e.g in case when theme file specifies the colorMap
-                            * attribute ) then highlight it if any of the style maps have a
-                            * highlight styleId
-                            */
-                        else {
-                            for ( const GeoDataStyleMap &styleMap: doc->styleMaps() ) {
-                                GeoDataStyle::Ptr style = d->highlightStyle( doc, styleMap );
-                                if ( style ) {
-                                    d->selectItem( item );
-                                    d->applyHighlightStyle( item, style );
-                                    break;
-                                }
+                                break;
                             }
                         }
                     }
@@ -232,27 +374,44 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
 
 void GeoGraphicsScene::removeItem( const GeoDataFeature* feature )
 {
-    for (auto tileIter = d->m_features.find(feature), end = d->m_features.end(); tileIter != end && tileIter.key() == feature;) {
-        auto & tileList = d->m_tiledItems[*tileIter];
-        auto iter = tileList.find(feature);
-        if (iter != tileList.end()) {
-            auto item = iter.value();
-            tileIter = d->m_features.erase(tileIter);
-            tileList.erase(iter);
-            delete item;
-        } else {
-            ++tileIter;
+    for (auto iter = d->m_features.find(feature); iter != d->m_features.end() && iter.key() == feature;) {
+        GeoGraphicsScenePrivate::Location const location = *iter;
+        GeoGraphicsScenePrivate::Level & tiles = d->m_levels[location.level];
+
+        // Leave a hole in the sorted entries, they get compacted by the next query
+        bool found = false;
+        auto entry = std::lower_bound(tiles.entries.begin(), tiles.entries.end(), location.code,
+                                      GeoGraphicsScenePrivate::codeLessThan);
+        for (; !found && entry != tiles.entries.end() && entry->code == location.code; ++entry) {
+            if (entry->item == location.item) {
+                entry->item = nullptr;
+                ++tiles.removed;
+                found = true;
+            }
         }
+        if (!found) {
+            for (int i = 0; i < tiles.pending.size(); ++i) {
+                if (tiles.pending[i].item == location.item) {
+                    tiles.pending.remove(i);
+                    break;
+                }
+            }
+        }
+
+        d->m_selectedItems.removeOne(location.item);
+        iter = d->m_features.erase(iter);
+        delete location.item;
     }
 }
 
 void GeoGraphicsScene::clear()
 {
-    for(auto const &list: d->m_tiledItems.values()) {
-        qDeleteAll(list.values());
+    for (auto const & location: d->m_features) {
+        delete location.item;
     }
-    d->m_tiledItems.clear();
+    d->m_levels.clear();
     d->m_features.clear();
+    d->m_selectedItems.clear();
 }
 
 void GeoGraphicsScene::addItem( GeoGraphicsItem* item )
@@ -270,10 +429,18 @@ void GeoGraphicsScene::addItem( GeoGraphicsItem* item )
 
     const TileId key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel ); // same as GeoDataCoordinates(east, south, 0), see above
 
-    auto & tileList = d->m_tiledItems[key];
-    auto feature = item->feature();
-    tileList.insert(feature, item);
-    d->m_features.insert(feature, key );
+    if (zoomLevel >= d->m_levels.size()) {
+        d->m_levels.resize(zoomLevel + 1);
+    }
+
+    GeoGraphicsScenePrivate::Entry entry;
+    entry.code = GeoGraphicsScenePrivate::mortonCode(key.x(), key.y());
+    entry.item = item;
+    entry.minZoomLevel = item->minZoomLevel();
+    d->m_levels[zoomLevel].pending << entry;
+
+    GeoGraphicsScenePrivate::Location const location = { item, zoomLevel, entry.code };
+    d->m_features.insert(item->feature(), location);
 }
 
 }
@@ -832,6 +832,20 @@ QRegion GeoPainter::regionFromPolygon ( const GeoDataLinearRing & linearRing,
 
 void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
                                Qt::FillRule fillRule )
+{
+    QVector<QPolygonF*> fillPolygons;
+    QVector<QPolygonF*> outlinePolygons;
+    polygonsFromPolygon( polygon, fillPolygons, outlinePolygons );
+
+    drawPolygons( fillPolygons, outlinePolygons, fillRule );
+
+    qDeleteAll(fillPolygons);
+    qDeleteAll(outlinePolygons);
+}
+
+void GeoPainter::polygonsFromPolygon( const GeoDataPolygon &polygon,
+                                      QVector<QPolygonF*> &fillPolygons,
+                                      QVector<QPolygonF*> &outlinePolygons )
 {
     // If the object is not visible in the viewport return 
     if ( ! d->m_viewport->viewLatLonAltBox().intersects( polygon.outerBoundary().latLonAltBox() ) ||
@@ -842,18 +856,13 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
         // mDebug() << "Polygon doesn't get displayed on the viewport";
         return;
     }
-    // mDebug() << "Drawing Polygon";
 
     QVector<QPolygonF*> outerPolygons;
-    QVector<QPolygonF*> innerPolygons;
     d->m_viewport->screenCoordinates( polygon.outerBoundary(), outerPolygons );
 
-    QPen const currentPen = pen();
-
-    bool const hasInnerBoundaries = !polygon.innerBoundaries().isEmpty();
     bool innerBoundariesOnScreen = false;
 
-    if ( hasInnerBoundaries ) {
+    if ( !polygon.innerBoundaries().isEmpty() ) {
         QVector<GeoDataLinearRing> const & innerBoundaries = polygon.innerBoundaries();
 
         const GeoDataLatLonAltBox & viewLatLonAltBox = d->m_viewport->viewLatLonAltBox();
@@ -867,43 +876,43 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
 
         if (innerBoundariesOnScreen) {
             // Create the inner screen polygons
+            QVector<QPolygonF*> innerPolygons;
             for( const GeoDataLinearRing& itInnerBoundary: innerBoundaries ) {
-                QVector<QPolygonF*> innerPolygonsPerBoundary;
-
-                d->m_viewport->screenCoordinates( itInnerBoundary, innerPolygonsPerBoundary );
-
-                for( QPolygonF* innerPolygonPerBoundary: innerPolygonsPerBoundary ) {
-                    innerPolygons << innerPolygonPerBoundary;
-                }
-            }
-
-            setPen(Qt::NoPen);
-            QVector<QPolygonF*> fillPolygons = createFillPolygons( outerPolygons,
-                                                                   innerPolygons );
-
-            for( const QPolygonF* fillPolygon: fillPolygons ) {
-                ClipPainter::drawPolygon(*fillPolygon, fillRule);
+                d->m_viewport->screenCoordinates( itInnerBoundary, innerPolygons );
             }
 
-            setPen(currentPen);
+            fillPolygons << createFillPolygons( outerPolygons, innerPolygons );
+            outlinePolygons << outerPolygons << innerPolygons;
+        }
+    }
 
-            for( const QPolygonF* outerPolygon: outerPolygons ) {
-                ClipPainter::drawPolyline( *outerPolygon );
-            }
-            for( const QPolygonF* innerPolygon: innerPolygons ) {
-                ClipPainter::drawPolyline( *innerPolygon );
-            }
+    if ( !innerBoundariesOnScreen ) {
+        fillPolygons << outerPolygons;
+    }
+}
 
-            qDeleteAll(fillPolygons);
+void GeoPainter::drawPolygons( const QVector<QPolygonF*> &fillPolygons,
+                               const QVector<QPolygonF*> &outlinePolygons,
+                               Qt::FillRule fillRule )
+{
+    if ( outlinePolygons.isEmpty() ) {
+        for( const QPolygonF* fillPolygon: fillPolygons ) {
+            ClipPainter::drawPolygon( *fillPolygon, fillRule );
         }
+        return;
     }
 
-    if ( !hasInnerBoundaries || !innerBoundariesOnScreen ) {
-        drawPolygon( polygon.outerBoundary(), fillRule );
+    QPen const currentPen = pen();
+
+    setPen(Qt::NoPen);
+    for( const QPolygonF* fillPolygon: fillPolygons ) {
+        ClipPainter::drawPolygon(*fillPolygon, fillRule);
     }
 
-    qDeleteAll(outerPolygons);
-    qDeleteAll(innerPolygons);
+    setPen(currentPen);
+    for( const QPolygonF* outlinePolygon: outlinePolygons ) {
+        ClipPainter::drawPolyline( *outlinePolygon );
+    }
 }
 
 QVector<QPolygonF*> GeoPainter::createFillPolygons( const QVector<QPolygonF*> & outerPolygons,
@@ -432,6 +432,34 @@ class MARBLE_EXPORT GeoPainter : public ClipPainter
                        Qt::FillRule fillRule = Qt::OddEvenFill );
 
 
+/*!
+    \brief Helper method for safe and quick polygon conversion.
+
+    Like polygonsFromLineString() this allows to cache the screen
+    polygons of a \a polygon which is drawn multiple times. The
+    polygons to fill are appended to \a fillPolygons. If the holes
+    of the \a polygon are visible, the screen polygons of its
+    boundaries are appended to \a outlinePolygons, which are stroked
+    separately then. The caller takes ownership of both.
+
+    \see drawPolygons()
+*/
+    void polygonsFromPolygon( const GeoDataPolygon &polygon,
+                              QVector<QPolygonF*> &fillPolygons,
+                              QVector<QPolygonF*> &outlinePolygons );
+
+/*!
+    \brief Draws screen polygons created by polygonsFromPolygon().
+
+    If \a outlinePolygons is empty, the \a fillPolygons are drawn with
+    the current pen and brush. Otherwise they are filled only, and the
+    \a outlinePolygons are drawn using the current pen.
+*/
+    void drawPolygons( const QVector<QPolygonF*> &fillPolygons,
+                       const QVector<QPolygonF*> &outlinePolygons,
+                       Qt::FillRule fillRule = Qt::OddEvenFill );
+
+
     QVector<QPolygonF*> createFillPolygons( const QVector<QPolygonF*> & outerPolygons,
                                             const QVector<QPolygonF*> & innerPolygons ) const;
     
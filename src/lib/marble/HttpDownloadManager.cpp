@@ -19,6 +19,7 @@
 
 #include "DownloadPolicy.h"
 #include "DownloadQueueSet.h"
+#include "GeoDataLatLonBox.h"
 #include "HttpJob.h"
 #include "MarbleDebug.h"
 #include "StoragePolicy.h"
@@ -54,6 +55,7 @@ class Q_DECL_HIDDEN HttpDownloadManager::Private
     QMap<DownloadUsage, DownloadQueueSet *> m_defaultQueueSets;
     StoragePolicy *const m_storagePolicy;
     QNetworkAccessManager m_networkAccessManager;
+    GeoDataLatLonBox m_visibleArea;
     bool m_acceptJobs;
 
 };
@@ -63,6 +65,7 @@ HttpDownloadManager::Private::Private(HttpDownloadManager *parent, StoragePolicy
       m_requeueTimer(),
       m_storagePolicy( policy ),
       m_networkAccessManager(),
+      m_visibleArea(),
       m_acceptJobs( true )
 {
     // setup default download policy and associated queue set
@@ -134,12 +137,39 @@ void HttpDownloadManager::addDownloadPolicy( const DownloadPolicy& policy )
         return;
     DownloadQueueSet * const queueSet = new DownloadQueueSet( policy, this );
     d->connectQueueSet( queueSet );
+    queueSet->setVisibleArea( d->m_visibleArea );
     d->m_queueSets.append( QPair<DownloadPolicyKey, DownloadQueueSet *>
                            ( queueSet->downloadPolicy().key(), queueSet ));
 }
 
+void HttpDownloadManager::setVisibleArea( const GeoDataLatLonBox &visibleArea )
+{
+    if ( visibleArea == d->m_visibleArea ) {
+        return;
+    }
+
+    d->m_visibleArea = visibleArea;
+    QMap<DownloadUsage, DownloadQueueSet *>::iterator pos = d->m_defaultQueueSets.begin();
+    QMap<DownloadUsage, DownloadQueueSet *>::iterator const end = d->m_defaultQueueSets.end();
+    for (; pos != end; ++pos ) {
+        pos.value()->setVisibleArea( visibleArea );
+    }
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet *> >::iterator queueSet = d->m_queueSets.begin();
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet *> >::iterator const queueSetEnd = d->m_queueSets.end();
+    for (; queueSet != queueSetEnd; ++queueSet ) {
+        queueSet->second->setVisibleArea( visibleArea );
+    }
+}
+
 void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFileName,
                                   const QString &id, const DownloadUsage usage )
+{
+    addJob( sourceUrl, destFileName, id, usage, GeoDataLatLonBox(), 0 );
+}
+
+void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFileName,
+                                  const QString &id, const DownloadUsage usage,
+                                  const GeoDataLatLonBox &tileArea, int zoomLevel )
 {
     if ( !d->m_acceptJobs ) {
         mDebug() << Q_FUNC_INFO << "Working offline, not adding job";
@@ -147,10 +177,16 @@ void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFile
     }
 
     DownloadQueueSet * const queueSet = d->findQueues( sourceUrl.host(), usage );
+    if ( queueSet->mergeJob( sourceUrl, destFileName, id ) ) {
+        mDebug() << "merged job " << sourceUrl;
+        return;
+    }
     if ( queueSet->canAcceptJob( sourceUrl, destFileName )) {
         HttpJob * const job = new HttpJob( sourceUrl, destFileName, id, &d->m_networkAccessManager );
         job->setUserAgentPluginId( "QNamNetworkPlugin" );
         job->setDownloadUsage( usage );
+        job->setTileArea( tileArea );
+        job->setZoomLevel( zoomLevel );
         mDebug() << "adding job " << sourceUrl;
         queueSet->addJob( job );
     }
@@ -202,8 +238,8 @@ void HttpDownloadManager::Private::connectQueueSet( DownloadQueueSet * queueSet
     connect( queueSet, SIGNAL(jobFinished(QByteArray,QString,QString)),
              m_downloadManager, SLOT(finishJob(QByteArray,QString,QString)));
     connect( queueSet, SIGNAL(jobRetry()), m_downloadManager, SLOT(startRetryTimer()));
-    connect( queueSet, SIGNAL(jobRedirected(QUrl,QString,QString,DownloadUsage)),
-             m_downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage)));
+    connect( queueSet, SIGNAL(jobRedirected(QUrl,QString,QString,DownloadUsage,GeoDataLatLonBox,int)),
+             m_downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage,GeoDataLatLonBox,int)));
     // relay jobAdded/jobRemoved signals (interesting for progress bar)
     connect( queueSet, SIGNAL(jobAdded()), m_downloadManager, SIGNAL(jobAdded()));
     connect( queueSet, SIGNAL(jobRemoved()), m_downloadManager, SIGNAL(jobRemoved()));
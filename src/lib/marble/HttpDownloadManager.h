@@ -28,6 +28,7 @@ namespace Marble
 {
 
 class DownloadPolicy;
+class GeoDataLatLonBox;
 class StoragePolicy;
 
 /**
@@ -65,6 +66,12 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     void setDownloadEnabled( const bool enable );
     void addDownloadPolicy( const DownloadPolicy& );
 
+    /**
+     * Ranks the queued downloads by the given area and cancels downloads
+     * of tiles outside of it as long as tiles inside wait for a connection.
+     */
+    void setVisibleArea( const GeoDataLatLonBox &visibleArea );
+
     static QByteArray userAgent(const QString &platform, const QString &plugin);
 
  public Q_SLOTS:
@@ -75,6 +82,13 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     void addJob( const QUrl& sourceUrl, const QString& destFilename, const QString &id,
                  const DownloadUsage usage );
 
+    /**
+     * Adds a new job for a tile covering @p tileArea at @p zoomLevel.
+     * A job for the same source url which was added before is served for both.
+     */
+    void addJob( const QUrl& sourceUrl, const QString& destFilename, const QString &id,
+                 const DownloadUsage usage, const GeoDataLatLonBox &tileArea, int zoomLevel );
+
 
  Q_SIGNALS:
     void downloadComplete( const QString&, const QString& );
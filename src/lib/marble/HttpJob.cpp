@@ -14,6 +14,7 @@
 #include "HttpJob.h"
 
 #include "MarbleDebug.h"
+#include "GeoDataLatLonBox.h"
 #include "HttpDownloadManager.h"
 
 #include <QNetworkAccessManager>
@@ -32,6 +33,9 @@ class Marble::HttpJobPrivate
     QString        m_initiatorId;
     int            m_trialsLeft;
     DownloadUsage  m_downloadUsage;
+    GeoDataLatLonBox m_tileArea;
+    int            m_zoomLevel;
+    QList<QPair<QString, QString> > m_mergedRequests;
     QString m_userAgent;
     QNetworkAccessManager *const m_networkAccessManager;
     QNetworkReply *m_networkReply;
@@ -44,6 +48,9 @@ HttpJobPrivate::HttpJobPrivate( const QUrl & sourceUrl, const QString & destFile
       m_initiatorId( id ),
       m_trialsLeft( 3 ),
       m_downloadUsage( DownloadBrowse ),
+      m_tileArea(),
+      m_zoomLevel( 0 ),
+      m_mergedRequests(),
       // FIXME: remove initialization depending on if empty pluginId
       // results in valid user agent string
       m_userAgent( "unknown" ),
@@ -114,6 +121,53 @@ void HttpJob::setDownloadUsage( const DownloadUsage usage )
     d->m_downloadUsage = usage;
 }
 
+GeoDataLatLonBox HttpJob::tileArea() const
+{
+    return d->m_tileArea;
+}
+
+void HttpJob::setTileArea( const GeoDataLatLonBox &tileArea )
+{
+    d->m_tileArea = tileArea;
+}
+
+int HttpJob::zoomLevel() const
+{
+    return d->m_zoomLevel;
+}
+
+void HttpJob::setZoomLevel( int zoomLevel )
+{
+    d->m_zoomLevel = zoomLevel;
+}
+
+void HttpJob::addMergedRequest( const QString &destinationFileName, const QString &id )
+{
+    const QPair<QString, QString> request( destinationFileName, id );
+    if ( ( destinationFileName != d->m_destinationFileName || id != d->m_initiatorId )
+         && !d->m_mergedRequests.contains( request ) ) {
+        d->m_mergedRequests.append( request );
+    }
+}
+
+QList<QPair<QString, QString> > HttpJob::mergedRequests() const
+{
+    return d->m_mergedRequests;
+}
+
+void HttpJob::abort()
+{
+    if ( !d->m_networkReply ) {
+        return;
+    }
+
+    // disconnect first, QNetworkReply::abort() emits finished() right away
+    d->m_networkReply->disconnect( this );
+    d->m_networkReply->abort();
+    d->m_networkReply->deleteLater();
+    d->m_networkReply = 0;
+}
+
 void HttpJob::setUserAgentPluginId( const QString & pluginId ) const
 {
     d->m_userAgent = pluginId;
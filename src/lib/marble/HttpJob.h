@@ -14,8 +14,10 @@
 #ifndef MARBLE_HTTPJOB_H
 #define MARBLE_HTTPJOB_H
 
+#include <QList>
 #include <QObject>
 #include <QNetworkReply>
+#include <QPair>
 
 #include "MarbleGlobal.h"
 
@@ -28,6 +30,7 @@ class QUrl;
 
 namespace Marble
 {
+class GeoDataLatLonBox;
 class HttpJobPrivate;
 
 class MARBLE_EXPORT HttpJob: public QObject
@@ -52,6 +55,29 @@ class MARBLE_EXPORT HttpJob: public QObject
     DownloadUsage downloadUsage() const;
     void setDownloadUsage( const DownloadUsage );
 
+    /**
+     * The area covered by the downloaded tile, used to rank the job against
+     * the visible area. Jobs without an area count as visible.
+     */
+    GeoDataLatLonBox tileArea() const;
+    void setTileArea( const GeoDataLatLonBox &tileArea );
+
+    int zoomLevel() const;
+    void setZoomLevel( int zoomLevel );
+
+    /**
+     * Adds another request for the source url of this job. When the job is
+     * done, it is reported for the merged requests, too.
+     */
+    void addMergedRequest( const QString &destinationFileName, const QString &id );
+    QList<QPair<QString, QString> > mergedRequests() const;
+
+    /**
+     * Aborts a running download without emitting any signal. The job can
+     * be executed again later.
+     */
+    void abort();
+
     void setUserAgentPluginId( const QString & pluginId ) const;
 
     QByteArray userAgent() const;
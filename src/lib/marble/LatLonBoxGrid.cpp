@@ -0,0 +1,178 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "LatLonBoxGrid.h"
+
+#include "GeoDataLatLonBox.h"
+#include "MarbleGlobal.h"
+
+#include <qmath.h>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+// Boxes covering more cells are not worth distributing over the grid
+static const int MaxCellsPerBox = 256;
+
+// Everything outside of the grid bounds ends up in the border cells
+static int cellIndex( qreal offset, qreal cellSize, int cellCount )
+{
+    const qreal cell = qFloor( offset / cellSize );
+    if ( cell < 0 ) {
+        return 0;
+    }
+    return cell < cellCount ? int( cell ) : cellCount - 1;
+}
+
+LatLonBoxGrid::LatLonBoxGrid() :
+    m_west( -M_PI ),
+    m_south( -M_PI / 2 ),
+    m_cellWidth( 2 * M_PI ),
+    m_cellHeight( M_PI ),
+    m_columns( 1 ),
+    m_rows( 1 ),
+    m_lookup( 0 )
+{
+    m_cellStart.fill( 0, 2 );
+}
+
+void LatLonBoxGrid::build( const GeoDataLatLonBox &bounds, const QVector<GeoDataLatLonBox> &boxes )
+{
+    clear();
+
+    qreal west = bounds.west();
+    qreal east = bounds.east();
+    qreal south = bounds.south();
+    qreal north = bounds.north();
+    if ( bounds.crossesDateLine() || east <= west || north <= south ) {
+        west = -M_PI;
+        east = M_PI;
+        south = -M_PI / 2;
+        north = M_PI / 2;
+    }
+
+    // Aim for a couple of boxes per cell
+    const int side = qBound( 1, int( qSqrt( boxes.size() / 2.0 ) ), 256 );
+    m_west = west;
+    m_south = south;
+    m_columns = side;
+    m_rows = side;
+    m_cellWidth = ( east - west ) / m_columns;
+    m_cellHeight = ( north - south ) / m_rows;
+
+    m_boxes.reserve( boxes.size() );
+    for ( const GeoDataLatLonBox &box: boxes ) {
+        const Box item = { box.west(), box.east(), box.south(), box.north() };
+        m_boxes.append( item );
+    }
+
+    // Count the boxes of each cell first, so all of them fit into one vector
+    QVector<bool> unbounded( m_boxes.size(), false );
+    QVector<int> cellCount( m_columns * m_rows, 0 );
+    for ( int i = 0; i < m_boxes.size(); ++i ) {
+        int left, right, bottom, top;
+        cellRange( m_boxes[i], left, right, bottom, top );
+        if ( boxes[i].crossesDateLine() || ( right - left + 1 ) * ( top - bottom + 1 ) > MaxCellsPerBox ) {
+            unbounded[i] = true;
+            m_unboundedItems.append( i );
+            continue;
+        }
+        for ( int y = bottom; y <= top; ++y ) {
+            for ( int x = left; x <= right; ++x ) {
+                ++cellCount[y * m_columns + x];
+            }
+        }
+    }
+
+    m_cellStart.fill( 0, cellCount.size() + 1 );
+    for ( int i = 0; i < cellCount.size(); ++i ) {
+        m_cellStart[i + 1] = m_cellStart[i] + cellCount[i];
+    }
+
+    m_cellItems.resize( m_cellStart.last() );
+    QVector<int> position = m_cellStart;
+    for ( int i = 0; i < m_boxes.size(); ++i ) {
+        if ( unbounded[i] ) {
+            continue;
+        }
+        int left, right, bottom, top;
+        cellRange( m_boxes[i], left, right, bottom, top );
+        for ( int y = bottom; y <= top; ++y ) {
+            for ( int x = left; x <= right; ++x ) {
+                m_cellItems[position[y * m_columns + x]++] = i;
+            }
+        }
+    }
+
+    m_visited.fill( 0, m_boxes.size() );
+}
+
+void LatLonBoxGrid::clear()
+{
+    m_boxes.clear();
+    m_cellStart.fill( 0, m_columns * m_rows + 1 );
+    m_cellItems.clear();
+    m_unboundedItems.clear();
+    m_visited.clear();
+    m_lookup = 0;
+}
+
+int LatLonBoxGrid::size() const
+{
+    return m_boxes.size();
+}
+
+QVector<int> LatLonBoxGrid::candidates( const GeoDataLatLonBox &area ) const
+{
+    Q_ASSERT( !area.crossesDateLine() );
+
+    QVector<int> result = m_unboundedItems;
+
+    const Box query = { area.west(), area.east(), area.south(), area.north() };
+    int left, right, bottom, top;
+    cellRange( query, left, right, bottom, top );
+
+    if ( ++m_lookup == 0 ) {
+        m_visited.fill( 0 );
+        m_lookup = 1;
+    }
+
+    for ( int y = bottom; y <= top; ++y ) {
+        for ( int x = left; x <= right; ++x ) {
+            const int cell = y * m_columns + x;
+            for ( int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i ) {
+                const int index = m_cellItems[i];
+                if ( m_visited[index] == m_lookup ) {
+                    continue;
+                }
+                m_visited[index] = m_lookup;
+
+                const Box &box = m_boxes[index];
+                if ( box.west <= query.east && query.west <= box.east
+                     && box.south <= query.north && query.south <= box.north ) {
+                    result.append( index );
+                }
+            }
+        }
+    }
+
+    std::sort( result.begin(), result.end() );
+    return result;
+}
+
+void LatLonBoxGrid::cellRange( const Box &box, int &left, int &right, int &bottom, int &top ) const
+{
+    left = cellIndex( box.west - m_west, m_cellWidth, m_columns );
+    right = cellIndex( box.east - m_west, m_cellWidth, m_columns );
+    bottom = cellIndex( box.south - m_south, m_cellHeight, m_rows );
+    top = cellIndex( box.north - m_south, m_cellHeight, m_rows );
+}
+
+}
@@ -0,0 +1,89 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_LATLONBOXGRID_H
+#define MARBLE_LATLONBOXGRID_H
+
+#include "marble_export.h"
+
+#include <QVector>
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+
+/**
+ * @short A uniform grid over bounding boxes for fast area lookups.
+ *
+ * The grid is built once for a list of boxes and then answers which of
+ * them intersect a given area by looking at the grid cells the area
+ * covers only.  Boxes which cross the date line or would cover too many
+ * cells are kept in a separate list and returned for every lookup.
+ *
+ * Lookups reuse internal scratch space, so a grid must not be queried
+ * from several threads at the same time.
+ */
+class MARBLE_EXPORT LatLonBoxGrid
+{
+public:
+    LatLonBoxGrid();
+
+    /**
+     * Indexes @p boxes.  The grid is laid over @p bounds, which should be
+     * the area the boxes are usually queried in.  Boxes outside of it are
+     * still found, just less efficiently.
+     */
+    void build( const GeoDataLatLonBox &bounds, const QVector<GeoDataLatLonBox> &boxes );
+
+    void clear();
+
+    /**
+     * Returns the number of boxes indexed.
+     */
+    int size() const;
+
+    /**
+     * Returns the indices of all boxes which may intersect @p area in
+     * ascending order.  @p area must not cross the date line.
+     */
+    QVector<int> candidates( const GeoDataLatLonBox &area ) const;
+
+private:
+    struct Box
+    {
+        qreal west;
+        qreal east;
+        qreal south;
+        qreal north;
+    };
+
+    void cellRange( const Box &box, int &left, int &right, int &bottom, int &top ) const;
+
+    QVector<Box> m_boxes;
+
+    qreal m_west;
+    qreal m_south;
+    qreal m_cellWidth;
+    qreal m_cellHeight;
+    int m_columns;
+    int m_rows;
+
+    // The box indices of cell i are m_cellItems[m_cellStart[i]..m_cellStart[i+1])
+    QVector<int> m_cellStart;
+    QVector<int> m_cellItems;
+    QVector<int> m_unboundedItems;
+
+    // Marks boxes already returned by the current lookup
+    mutable QVector<quint32> m_visited;
+    mutable quint32 m_lookup;
+};
+
+}
+
+#endif
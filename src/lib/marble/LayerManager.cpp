@@ -18,13 +18,12 @@
 #include "MarbleDebug.h"
 #include "AbstractDataPlugin.h"
 #include "AbstractDataPluginItem.h"
+#include "FrameProfiler.h"
 #include "GeoPainter.h"
 #include "RenderPlugin.h"
 #include "LayerInterface.h"
 #include "RenderState.h"
 
-#include <QTime>
-
 namespace Marble
 {
 
@@ -36,6 +35,8 @@ class Q_DECL_HIDDEN LayerManager::Private
 
     void updateVisibility( bool visible, const QString &nameId );
 
+    static const char *layerName( const LayerInterface *layer );
+
     LayerManager *const q;
 
     QList<RenderPlugin *> m_renderPlugins;
@@ -56,6 +57,13 @@ LayerManager::Private::Private(LayerManager *parent) :
 {
 }
 
+const char *LayerManager::Private::layerName( const LayerInterface *layer )
+{
+    // Class names of layers stay valid for the profiler, unlike their run time traces
+    const QObject *object = dynamic_cast<const QObject *>( layer );
+    return object ? object->metaObject()->className() : "LayerInterface";
+}
+
 LayerManager::Private::~Private()
 {
 }
@@ -123,7 +131,7 @@ QList<AbstractDataPluginItem *> LayerManager::whichItemAt( const QPoint& curpos
 void LayerManager::renderLayers( GeoPainter *painter, ViewportParams *viewport )
 {
     d->m_renderState = RenderState(QStringLiteral("Marble"));
-    const QTime totalTime = QTime::currentTime();
+    const FrameProfilerScope totalScope( "LayerManager::renderLayers", d->m_showRuntimeTrace );
 
     QStringList renderPositions;
 
@@ -175,19 +183,23 @@ void LayerManager::renderLayers( GeoPainter *painter, ViewportParams *viewport )
         } );
 
         // render the layers of the current renderPosition
-        QTime timer;
         for( auto *layer: layers ) {
-            timer.start();
+            FrameProfilerScope scope( Private::layerName( layer ), d->m_showRuntimeTrace );
             layer->render( painter, viewport, renderPosition, 0 );
             d->m_renderState.addChild( layer->renderState() );
-            traceList.append( QString("%2 ms %3").arg( timer.elapsed(),3 ).arg( layer->runtimeTrace() ) );
+            if ( scope.isRecording() || d->m_showRuntimeTrace ) {
+                const qint64 elapsed = scope.elapsed();
+                const QString trace = layer->runtimeTrace();
+                scope.setDetail( trace );
+                traceList.append( QString( "%1 ms %2" ).arg( elapsed / 1000000.0, 6, 'f', 2 ).arg( trace ) );
+            }
         }
     }
 
     if ( d->m_showRuntimeTrace ) {
-        const int totalElapsed = totalTime.elapsed();
+        const qreal totalElapsed = totalScope.elapsed() / 1000000.0;
         const int fps = 1000.0/totalElapsed;
-        traceList.append( QString( "Total: %1 ms (%2 fps)" ).arg( totalElapsed, 3 ).arg( fps ) );
+        traceList.append( QString( "Total: %1 ms (%2 fps)" ).arg( totalElapsed, 6, 'f', 2 ).arg( fps ) );
 
         painter->save();
         painter->setBackgroundMode( Qt::OpaqueMode );
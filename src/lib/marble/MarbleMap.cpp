@@ -36,6 +36,7 @@
 #include "AbstractFloatItem.h"
 #include "DgmlAuxillaryDictionary.h"
 #include "FileManager.h"
+#include "FrameProfiler.h"
 #include "GeoDataTreeModel.h"
 #include "GeoPainter.h"
 #include "GeoSceneDocument.h"
@@ -50,8 +51,10 @@
 #include "GeoSceneVectorTileDataset.h"
 #include "GeoSceneTextureTileDataset.h"
 #include "GeoSceneZoom.h"
+#include "HttpDownloadManager.h"
 #include "GeoDataDocument.h"
 #include "GeoDataFeature.h"
+#include "GeoDataLatLonAltBox.h"
 #include "GeoDataStyle.h"
 #include "GeoDataStyleMap.h"
 #include "LayerManager.h"
@@ -191,6 +194,9 @@ MarbleMapPrivate::MarbleMapPrivate( MarbleMap *parent, MarbleModel *model ) :
 
     QObject::connect( m_model, SIGNAL(themeChanged(QString)),
                       parent, SLOT(updateMapTheme()) );
+    // tiles loaded in the background read the texture datasets of the theme
+    QObject::connect( m_model, SIGNAL(themeAboutToChange()),
+                      &m_textureLayer, SLOT(cancelPendingLoads()) );
     QObject::connect( m_model->fileManager(), SIGNAL(fileAdded(QString)),
                       parent, SLOT(setDocument(QString)) );
 
@@ -722,6 +728,11 @@ quint64 MarbleMap::volatileTileCacheLimit() const
     return d->m_textureLayer.volatileCacheLimit();
 }
 
+bool MarbleMap::asynchronousTileLoading() const
+{
+    return d->m_textureLayer.asynchronousTileLoading();
+}
+
 
 void MarbleMap::rotateBy(qreal deltaLon, qreal deltaLat)
 {
@@ -851,9 +862,13 @@ void MarbleMap::paint( GeoPainter &painter, const QRect &dirtyRect )
         return;
     }
 
+    FrameProfiler::beginFrame();
     QTime t;
     t.start();
 
+    // rank the tile downloads the layers trigger by what is shown now
+    d->m_model->downloadManager()->setVisibleArea( d->m_viewport.viewLatLonAltBox() );
+
     RenderStatus const oldRenderStatus = d->m_renderState.status();
     d->m_layerManager.renderLayers( &painter, &d->m_viewport );
     d->m_renderState = d->m_layerManager.renderState();
@@ -872,6 +887,7 @@ void MarbleMap::paint( GeoPainter &painter, const QRect &dirtyRect )
 
     const qreal fps = 1000.0 / (qreal)( t.elapsed() );
     emit framesPerSecond( fps );
+    FrameProfiler::endFrame();
 }
 
 void MarbleMap::customPaint( GeoPainter *painter )
@@ -1258,6 +1274,16 @@ bool MarbleMap::showRuntimeTrace() const
     return d->m_layerManager.showRuntimeTrace();
 }
 
+void MarbleMap::setFrameProfilerEnabled( bool enabled )
+{
+    FrameProfiler::setEnabled( enabled );
+}
+
+bool MarbleMap::isFrameProfilerEnabled() const
+{
+    return FrameProfiler::isEnabled();
+}
+
 void MarbleMap::setShowDebugPolygons( bool visible)
 {
     if (visible != d->m_showDebugPolygons) {
@@ -1337,6 +1363,11 @@ void MarbleMap::setVolatileTileCacheLimit( quint64 kilobytes )
     d->m_textureLayer.setVolatileCacheLimit( kilobytes );
 }
 
+void MarbleMap::setAsynchronousTileLoading( bool asynchronous )
+{
+    d->m_textureLayer.setAsynchronousTileLoading( asynchronous );
+}
+
 AngleUnit MarbleMap::defaultAngleUnit() const
 {
     if ( GeoDataCoordinates::defaultNotation() == GeoDataCoordinates::Decimal ) {
@@ -368,6 +368,12 @@ class MARBLE_EXPORT MarbleMap : public QObject
      */
     quint64 volatileTileCacheLimit() const;
 
+    /**
+     * @brief  Returns whether missing texture tiles are loaded in the background.
+     * @see setAsynchronousTileLoading()
+     */
+    bool asynchronousTileLoading() const;
+
     /**
      * @brief Returns a list of all RenderPlugins in the model, this includes float items
      * @return the list of RenderPlugins
@@ -642,6 +648,14 @@ class MARBLE_EXPORT MarbleMap : public QObject
 
     bool showRuntimeTrace() const;
 
+    /**
+     * @brief Set whether the rendering of frames gets profiled
+     * @param enabled  whether to record the frames into the FrameProfiler
+     */
+    void setFrameProfilerEnabled( bool enabled );
+
+    bool isFrameProfilerEnabled() const;
+
     /**
      * @brief Set whether to enter the debug mode for
      * polygon node drawing
@@ -686,6 +700,13 @@ class MARBLE_EXPORT MarbleMap : public QObject
      */
     void setVolatileTileCacheLimit( quint64 kiloBytes );
 
+    /**
+     * @brief  Load missing texture tiles in the background.
+     * @param  asynchronous If true, a missing tile is shown as an upscaled part of a
+     *         lower resolution tile until the tile has been loaded by a worker thread.
+     */
+    void setAsynchronousTileLoading( bool asynchronous );
+
     void setDefaultAngleUnit( AngleUnit angleUnit );
 
     void setDefaultFont( const QFont& font );
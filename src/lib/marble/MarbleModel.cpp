@@ -51,12 +51,14 @@
 #include "DgmlAuxillaryDictionary.h"
 #include "MarbleClock.h"
 #include "FileStoragePolicy.h"
+#include "MbTilesStoragePolicy.h"
 #include "FileStorageWatcher.h"
 #include "PositionTracking.h"
 #include "HttpDownloadManager.h"
 #include "MarbleDirs.h"
 #include "FileManager.h"
 #include "GeoDataTreeModel.h"
+#include "PlacemarkNameIndex.h"
 #include "PlacemarkPositionProviderPlugin.h"
 #include "Planet.h"
 #include "PlanetFactory.h"
@@ -86,11 +88,13 @@ class MarbleModelPrivate
           m_homeZoom( 1050 ),
           m_mapTheme( 0 ),
           m_storagePolicy( MarbleDirs::localPath() ),
-          m_downloadManager( &m_storagePolicy ),
+          m_tileStoragePolicy( &m_storagePolicy, MarbleDirs::localPath() ),
+          m_downloadManager( &m_tileStoragePolicy ),
           m_storageWatcher( MarbleDirs::localPath() ),
           m_treeModel(),
           m_descendantProxy(),
           m_placemarkProxyModel(),
+          m_placemarkNameIndex( &m_placemarkProxyModel ),
           m_placemarkSelectionModel( 0 ),
           m_fileManager( &m_treeModel, &m_pluginManager ),
           m_positionTracking( &m_treeModel ),
@@ -161,6 +165,7 @@ class MarbleModelPrivate
     GeoSceneDocument        *m_mapTheme;
 
     FileStoragePolicy        m_storagePolicy;
+    MbTilesStoragePolicy     m_tileStoragePolicy;
     HttpDownloadManager      m_downloadManager;
 
     // Cache related
@@ -170,6 +175,7 @@ class MarbleModelPrivate
     GeoDataTreeModel         m_treeModel;
     KDescendantsProxyModel   m_descendantProxy;
     QSortFilterProxyModel    m_placemarkProxyModel;
+    PlacemarkNameIndex       m_placemarkNameIndex;
     QSortFilterProxyModel    m_groundOverlayProxyModel;
 
     // Selection handling
@@ -196,9 +202,9 @@ MarbleModel::MarbleModel( QObject *parent )
       d( new MarbleModelPrivate() )
 {
     // connect the StoragePolicy used by the download manager to the FileStorageWatcher
-    connect( &d->m_storagePolicy, SIGNAL(cleared()),
+    connect( &d->m_tileStoragePolicy, SIGNAL(cleared()),
              &d->m_storageWatcher, SLOT(resetCurrentSize()) );
-    connect( &d->m_storagePolicy, SIGNAL(sizeChanged(qint64)),
+    connect( &d->m_tileStoragePolicy, SIGNAL(sizeChanged(qint64)),
              &d->m_storageWatcher, SLOT(addToCurrentSize(qint64)) );
 
     connect( &d->m_fileManager, SIGNAL(fileAdded(QString)),
@@ -302,6 +308,9 @@ void MarbleModel::setMapTheme( GeoSceneDocument *document )
         }
     }
 
+    if ( d->m_mapTheme ) {
+        emit themeAboutToChange();
+    }
     delete d->m_mapTheme;
     d->m_mapTheme = mapTheme;
 
@@ -551,6 +560,11 @@ const QAbstractItemModel *MarbleModel::placemarkModel() const
     return &d->m_placemarkProxyModel;
 }
 
+const PlacemarkNameIndex *MarbleModel::placemarkNameIndex() const
+{
+    return &d->m_placemarkNameIndex;
+}
+
 QAbstractItemModel *MarbleModel::groundOverlayModel()
 {
     return &d->m_groundOverlayProxyModel;
@@ -618,7 +632,7 @@ quint64 MarbleModel::persistentTileCacheLimit() const
 
 void MarbleModel::clearPersistentTileCache()
 {
-    d->m_storagePolicy.clearCache();
+    d->m_tileStoragePolicy.clearCache();
 
     // Now create base tiles again if needed
     if ( d->m_mapTheme->map()->hasTextureLayers() || d->m_mapTheme->map()->hasVectorLayers() ) {
@@ -45,6 +45,7 @@ namespace Marble
 class GeoDataPlacemark;
 class GeoPainter;
 class MeasureTool;
+class PlacemarkNameIndex;
 class PositionTracking;
 class HttpDownloadManager;
 class MarbleModelPrivate;
@@ -118,6 +119,11 @@ class MARBLE_EXPORT MarbleModel : public QObject
     QAbstractItemModel *placemarkModel();
     const QAbstractItemModel *placemarkModel() const;
 
+    /**
+     * @brief Return the index over the names of the placemarks in placemarkModel()
+     */
+    const PlacemarkNameIndex *placemarkNameIndex() const;
+
     QItemSelectionModel *placemarkSelectionModel();
 
     /**
@@ -314,6 +320,12 @@ class MARBLE_EXPORT MarbleModel : public QObject
      */
     void themeChanged( const QString &mapTheme );
 
+    /**
+     * @brief Signal that the current map theme is about to be deleted
+     * because another one is set.
+     */
+    void themeAboutToChange();
+
     void workOfflineChanged();
 
     /**
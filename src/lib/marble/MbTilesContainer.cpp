@@ -0,0 +1,466 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MbTilesContainer.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QThread>
+#include <QThreadStorage>
+#include <QVariant>
+
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+
+namespace Marble
+{
+
+class MbTilesContainer::Connection
+{
+public:
+    Connection( const QString &fileName, const QString &connectionName, bool readOnly );
+    ~Connection();
+
+    bool isOpen() const;
+
+    QSqlDatabase database() const;
+
+    /// SELECT tile_data for zoom level, column and row
+    QSqlQuery m_selectTile;
+
+    /// SELECT EXISTS for zoom level, column and row
+    QSqlQuery m_hasTile;
+
+private:
+    const QString m_connectionName;
+    bool m_isOpen;
+};
+
+MbTilesContainer::Connection::Connection( const QString &fileName, const QString &connectionName, bool readOnly ) :
+    m_connectionName( connectionName ),
+    m_isOpen( false )
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase( QStringLiteral( "QSQLITE" ), m_connectionName );
+    database.setDatabaseName( fileName );
+
+    // Another thread may be committing, wait for it instead of failing right away
+    QString options = QStringLiteral( "QSQLITE_BUSY_TIMEOUT=5000" );
+    if ( readOnly ) {
+        options += QLatin1String( ";QSQLITE_OPEN_READONLY" );
+    }
+    database.setConnectOptions( options );
+
+    if ( !database.open() ) {
+        mDebug() << "Unable to open MBTiles container" << fileName << database.lastError().text();
+        return;
+    }
+
+    m_selectTile = QSqlQuery( database );
+    m_selectTile.prepare( QStringLiteral( "SELECT tile_data FROM tiles"
+                                          " WHERE zoom_level=? AND tile_column=? AND tile_row=?" ) );
+
+    m_hasTile = QSqlQuery( database );
+    m_hasTile.prepare( QStringLiteral( "SELECT EXISTS(SELECT 1 FROM tiles"
+                                       " WHERE zoom_level=? AND tile_column=? AND tile_row=?)" ) );
+
+    m_isOpen = true;
+}
+
+MbTilesContainer::Connection::~Connection()
+{
+    // All queries must be gone before the connection can be removed
+    m_selectTile = QSqlQuery();
+    m_hasTile = QSqlQuery();
+
+    {
+        QSqlDatabase database = QSqlDatabase::database( m_connectionName, false );
+        database.close();
+    }
+    QSqlDatabase::removeDatabase( m_connectionName );
+}
+
+bool MbTilesContainer::Connection::isOpen() const
+{
+    return m_isOpen;
+}
+
+QSqlDatabase MbTilesContainer::Connection::database() const
+{
+    return QSqlDatabase::database( m_connectionName, false );
+}
+
+MbTilesContainer *MbTilesContainer::container( const QString &fileName )
+{
+    static QMutex mutex;
+    static QHash<QString, MbTilesContainer *> containers;
+
+    const QString absoluteFileName = QFileInfo( fileName ).absoluteFilePath();
+
+    QMutexLocker locker( &mutex );
+
+    MbTilesContainer *container = containers.value( absoluteFileName, 0 );
+    if ( !container ) {
+        // Containers live until the application exits, the per thread
+        // connections refer to them.
+        container = new MbTilesContainer( absoluteFileName );
+        containers.insert( absoluteFileName, container );
+    }
+
+    return container;
+}
+
+bool MbTilesContainer::splitTileFileName( const QString &tileFileName, QString &containerFileName,
+                                          int &zoomLevel, int &x, int &y )
+{
+    const QString marker = QStringLiteral( ".mbtiles/" );
+    const int index = tileFileName.lastIndexOf( marker, -1, Qt::CaseInsensitive );
+    if ( index < 0 ) {
+        return false;
+    }
+
+    const QStringList components = tileFileName.mid( index + marker.size() ).split( QLatin1Char( '/' ) );
+    if ( components.size() != 3 ) {
+        return false;
+    }
+
+    bool zoomLevelOk = false;
+    bool xOk = false;
+    bool yOk = false;
+    zoomLevel = components[0].toInt( &zoomLevelOk );
+    x = components[1].toInt( &xOk );
+    y = components[2].section( QLatin1Char( '.' ), 0, 0 ).toInt( &yOk );
+    if ( !zoomLevelOk || !xOk || !yOk ) {
+        return false;
+    }
+
+    containerFileName = tileFileName.left( index + marker.size() - 1 );
+    return true;
+}
+
+QVector<MbTilesContainer *> MbTilesContainer::containers( const QString &containerFileName )
+{
+    QVector<MbTilesContainer *> result;
+
+    if ( QFileInfo( containerFileName ).isAbsolute() ) {
+        result << container( containerFileName );
+    } else {
+        result << container( MarbleDirs::localPath() + QLatin1Char( '/' ) + containerFileName );
+        result << container( MarbleDirs::systemPath() + QLatin1Char( '/' ) + containerFileName );
+    }
+
+    return result;
+}
+
+bool MbTilesContainer::findTile( const QString &tileFileName )
+{
+    QString containerFileName;
+    int zoomLevel, x, y;
+    if ( !splitTileFileName( tileFileName, containerFileName, zoomLevel, x, y ) ) {
+        return false;
+    }
+
+    for ( const MbTilesContainer *container: containers( containerFileName ) ) {
+        if ( container->hasTile( zoomLevel, x, y ) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QByteArray MbTilesContainer::findTileData( const QString &tileFileName )
+{
+    QString containerFileName;
+    int zoomLevel, x, y;
+    if ( !splitTileFileName( tileFileName, containerFileName, zoomLevel, x, y ) ) {
+        return QByteArray();
+    }
+
+    for ( const MbTilesContainer *container: containers( containerFileName ) ) {
+        const QByteArray data = container->tileData( zoomLevel, x, y );
+        if ( !data.isEmpty() ) {
+            return data;
+        }
+    }
+
+    return QByteArray();
+}
+
+MbTilesContainer::MbTilesContainer( const QString &fileName ) :
+    m_fileName( fileName ),
+    m_connectionPrefix( QStringLiteral( "MbTilesContainer_%1_" ).arg( quintptr( this ) ) ),
+    m_exists( QFile::exists( fileName ) )
+{
+}
+
+QString MbTilesContainer::fileName() const
+{
+    return m_fileName;
+}
+
+bool MbTilesContainer::exists() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_exists || !m_pendingTiles.isEmpty();
+}
+
+bool MbTilesContainer::hasTile( int zoomLevel, int x, int y ) const
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        if ( m_pendingTiles.contains( tileKey( zoomLevel, x, y ) ) ) {
+            return true;
+        }
+        if ( !m_exists ) {
+            return false;
+        }
+    }
+
+    Connection *const connection = this->connection();
+    if ( !connection ) {
+        return false;
+    }
+
+    QSqlQuery &query = connection->m_hasTile;
+    query.bindValue( 0, zoomLevel );
+    query.bindValue( 1, x );
+    query.bindValue( 2, y );
+    const bool result = query.exec() && query.next() && query.value( 0 ).toBool();
+    query.finish();
+
+    return result;
+}
+
+QByteArray MbTilesContainer::tileData( int zoomLevel, int x, int y ) const
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        const QHash<quint64, QByteArray>::const_iterator pending = m_pendingTiles.constFind( tileKey( zoomLevel, x, y ) );
+        if ( pending != m_pendingTiles.constEnd() ) {
+            return pending.value();
+        }
+        if ( !m_exists ) {
+            return QByteArray();
+        }
+    }
+
+    Connection *const connection = this->connection();
+    if ( !connection ) {
+        return QByteArray();
+    }
+
+    QSqlQuery &query = connection->m_selectTile;
+    query.bindValue( 0, zoomLevel );
+    query.bindValue( 1, x );
+    query.bindValue( 2, y );
+    QByteArray result;
+    if ( query.exec() && query.next() ) {
+        result = query.value( 0 ).toByteArray();
+    }
+    query.finish();
+
+    return result;
+}
+
+int MbTilesContainer::maximumZoomLevel() const
+{
+    int result = -1;
+
+    {
+        QMutexLocker locker( &m_mutex );
+        for ( QHash<quint64, QByteArray>::const_iterator it = m_pendingTiles.constBegin(); it != m_pendingTiles.constEnd(); ++it ) {
+            result = qMax<int>( result, it.key() >> 56 );
+        }
+        if ( !m_exists ) {
+            return result;
+        }
+    }
+
+    Connection *const connection = this->connection();
+    if ( !connection ) {
+        return result;
+    }
+
+    QSqlQuery query( connection->database() );
+    if ( query.exec( QStringLiteral( "SELECT MAX(zoom_level) FROM tiles" ) ) && query.next() && !query.isNull( 0 ) ) {
+        result = qMax( result, query.value( 0 ).toInt() );
+    }
+
+    return result;
+}
+
+void MbTilesContainer::insertTile( int zoomLevel, int x, int y, const QByteArray &data )
+{
+    QMutexLocker locker( &m_mutex );
+    m_pendingTiles.insert( tileKey( zoomLevel, x, y ), data );
+}
+
+int MbTilesContainer::pendingTileCount() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_pendingTiles.size();
+}
+
+bool MbTilesContainer::commit()
+{
+    QHash<quint64, QByteArray> tiles;
+    bool exists;
+    {
+        QMutexLocker locker( &m_mutex );
+        tiles = m_pendingTiles;
+        exists = m_exists;
+    }
+
+    if ( tiles.isEmpty() ) {
+        return true;
+    }
+
+    if ( !exists ) {
+        QDir::root().mkpath( QFileInfo( m_fileName ).absolutePath() );
+    }
+
+    Connection *const connection = this->connection( true );
+    if ( !connection ) {
+        QMutexLocker locker( &m_mutex );
+        m_errorMsg = m_fileName + QLatin1String( ": unable to open the MBTiles container" );
+        return false;
+    }
+
+    QSqlDatabase database = connection->database();
+
+    if ( !exists ) {
+        QSqlQuery schema( database );
+        schema.exec( QStringLiteral( "PRAGMA application_id = 0x4d504258" ) ); // MBTiles tileset
+        schema.exec( QStringLiteral( "CREATE TABLE IF NOT EXISTS tiles (zoom_level integer, tile_column integer, tile_row integer, tile_data blob)" ) );
+        schema.exec( QStringLiteral( "CREATE UNIQUE INDEX IF NOT EXISTS tile_index ON tiles(zoom_level, tile_column, tile_row)" ) );
+        schema.exec( QStringLiteral( "CREATE TABLE IF NOT EXISTS metadata (name text, value text)" ) );
+    }
+
+    database.transaction();
+
+    QSqlQuery insert( database );
+    insert.prepare( QStringLiteral( "INSERT OR REPLACE INTO tiles"
+                                    " (zoom_level, tile_column, tile_row, tile_data)"
+                                    " VALUES (?, ?, ?, ?)" ) );
+
+    bool success = true;
+    for ( QHash<quint64, QByteArray>::const_iterator it = tiles.constBegin(); success && it != tiles.constEnd(); ++it ) {
+        const quint64 key = it.key();
+        insert.bindValue( 0, int( key >> 56 ) );
+        insert.bindValue( 1, int( ( key >> 28 ) & 0xfffffff ) );
+        insert.bindValue( 2, int( key & 0xfffffff ) );
+        insert.bindValue( 3, it.value() );
+        success = insert.exec();
+    }
+
+    if ( !success || !database.commit() ) {
+        const QString error = insert.lastError().isValid() ? insert.lastError().text() : database.lastError().text();
+        database.rollback();
+
+        QMutexLocker locker( &m_mutex );
+        m_errorMsg = m_fileName + QLatin1String( ": " ) + error;
+        qCritical() << "Failed to store tiles in" << m_errorMsg;
+        return false;
+    }
+
+    QMutexLocker locker( &m_mutex );
+    m_exists = true;
+
+    // Tiles replaced while we were writing stay pending
+    for ( QHash<quint64, QByteArray>::const_iterator it = tiles.constBegin(); it != tiles.constEnd(); ++it ) {
+        QHash<quint64, QByteArray>::iterator pending = m_pendingTiles.find( it.key() );
+        if ( pending != m_pendingTiles.end() && pending.value() == it.value() ) {
+            m_pendingTiles.erase( pending );
+        }
+    }
+
+    return true;
+}
+
+bool MbTilesContainer::removeTiles( int minimumZoomLevel )
+{
+    bool exists;
+    {
+        QMutexLocker locker( &m_mutex );
+        for ( QHash<quint64, QByteArray>::iterator it = m_pendingTiles.begin(); it != m_pendingTiles.end(); ) {
+            if ( int( it.key() >> 56 ) >= minimumZoomLevel ) {
+                it = m_pendingTiles.erase( it );
+            } else {
+                ++it;
+            }
+        }
+        exists = m_exists;
+    }
+
+    if ( !exists ) {
+        return true;
+    }
+
+    Connection *const connection = this->connection( true );
+    if ( !connection ) {
+        QMutexLocker locker( &m_mutex );
+        m_errorMsg = m_fileName + QLatin1String( ": unable to open the MBTiles container" );
+        return false;
+    }
+
+    QSqlQuery remove( connection->database() );
+    remove.prepare( QStringLiteral( "DELETE FROM tiles WHERE zoom_level>=?" ) );
+    remove.bindValue( 0, minimumZoomLevel );
+    if ( !remove.exec() ) {
+        QMutexLocker locker( &m_mutex );
+        m_errorMsg = m_fileName + QLatin1String( ": " ) + remove.lastError().text();
+        qCritical() << "Failed to remove tiles from" << m_errorMsg;
+        return false;
+    }
+
+    return true;
+}
+
+QString MbTilesContainer::lastErrorMessage() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_errorMsg;
+}
+
+MbTilesContainer::Connection *MbTilesContainer::connection( bool forWriting ) const
+{
+    static QThreadStorage<QHash<const MbTilesContainer *, QSharedPointer<Connection> > > connections;
+
+    QHash<const MbTilesContainer *, QSharedPointer<Connection> > &threadConnections = connections.localData();
+    QSharedPointer<Connection> connection = threadConnections.value( this );
+
+    // A read only connection opened before the file was created by this
+    // process or failed to open is replaced for writing.
+    if ( forWriting && connection && !connection->isOpen() ) {
+        threadConnections.remove( this );
+        connection.clear();
+    }
+
+    if ( !connection ) {
+        const QString connectionName = m_connectionPrefix + QString::number( quintptr( QThread::currentThreadId() ) );
+        const bool readOnly = !forWriting && QFile::exists( m_fileName ) && !QFileInfo( m_fileName ).isWritable();
+        connection = QSharedPointer<Connection>( new Connection( m_fileName, connectionName, readOnly ) );
+        threadConnections.insert( this, connection );
+    }
+
+    return connection->isOpen() ? connection.data() : 0;
+}
+
+quint64 MbTilesContainer::tileKey( int zoomLevel, int x, int y )
+{
+    return ( quint64( zoomLevel ) << 56 ) | ( quint64( x ) << 28 ) | quint64( y );
+}
+
+}
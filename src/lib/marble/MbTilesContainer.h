@@ -0,0 +1,142 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_MBTILESCONTAINER_H
+#define MARBLE_MBTILESCONTAINER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+/**
+ * @short Tiles stored in a single MBTiles (SQLite) file.
+ *
+ * There is one container object per file, shared by all users in the
+ * process.  Each thread reading from a container gets its own database
+ * connection with prepared statements, as Qt's SQL connections must not be
+ * shared between threads.
+ *
+ * Tiles passed to insertTile() are kept in memory until commit() writes
+ * all of them in one transaction.  Pending tiles are already visible to
+ * hasTile() and tileData().
+ *
+ * The tile rows are stored with the y axis running from top to bottom,
+ * like tools/mbtile-import writes them.
+ */
+class MARBLE_EXPORT MbTilesContainer
+{
+public:
+    /**
+     * Returns the container for the MBTiles file @p fileName.  The file
+     * does not need to exist yet, it gets created by the first commit().
+     */
+    static MbTilesContainer *container( const QString &fileName );
+
+    /**
+     * Splits a tile file name of the form "<path>.mbtiles/<z>/<x>/<y>.<suffix>"
+     * as created by GeoSceneTileDataset::relativeTileFileName() for themes
+     * stored in a container.  Returns false for ordinary file names.
+     */
+    static bool splitTileFileName( const QString &tileFileName, QString &containerFileName,
+                                   int &zoomLevel, int &x, int &y );
+
+    /**
+     * Returns the containers a container file name relative to the data
+     * directories refers to, the one in the local directory first.  An
+     * absolute file name refers to a single container.
+     */
+    static QVector<MbTilesContainer *> containers( const QString &containerFileName );
+
+    /**
+     * Returns whether the tile with the given relative file name (see
+     * splitTileFileName()) is stored in the local or the system container.
+     */
+    static bool findTile( const QString &tileFileName );
+
+    /**
+     * Returns the data of the tile with the given relative file name, taken
+     * from the local container if it is stored there, otherwise from the
+     * system container.
+     */
+    static QByteArray findTileData( const QString &tileFileName );
+
+    QString fileName() const;
+
+    /**
+     * Returns whether the container file exists or tiles are pending.
+     */
+    bool exists() const;
+
+    bool hasTile( int zoomLevel, int x, int y ) const;
+
+    /**
+     * Returns the data of the given tile or an empty byte array if the
+     * container doesn't hold it.
+     */
+    QByteArray tileData( int zoomLevel, int x, int y ) const;
+
+    /**
+     * Returns the highest zoom level of the tiles stored, or -1.
+     */
+    int maximumZoomLevel() const;
+
+    /**
+     * Queues the tile for insertion, replacing a stored tile with the same
+     * coordinates.
+     */
+    void insertTile( int zoomLevel, int x, int y, const QByteArray &data );
+
+    int pendingTileCount() const;
+
+    /**
+     * Writes all pending tiles to the file in one transaction.
+     */
+    bool commit();
+
+    /**
+     * Removes the pending and the stored tiles with a zoom level of at
+     * least @p minimumZoomLevel.  The file itself is kept.
+     */
+    bool removeTiles( int minimumZoomLevel = 0 );
+
+    QString lastErrorMessage() const;
+
+private:
+    Q_DISABLE_COPY( MbTilesContainer )
+
+    class Connection;
+
+    explicit MbTilesContainer( const QString &fileName );
+
+    /**
+     * Returns the connection of the calling thread, or 0 if the file
+     * cannot be opened.
+     */
+    Connection *connection( bool forWriting = false ) const;
+
+    static quint64 tileKey( int zoomLevel, int x, int y );
+
+    const QString m_fileName;
+    const QString m_connectionPrefix;
+
+    mutable QMutex m_mutex;
+    bool m_exists;
+    QHash<quint64, QByteArray> m_pendingTiles;
+    QString m_errorMsg;
+};
+
+}
+
+#endif
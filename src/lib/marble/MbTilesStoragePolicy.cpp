@@ -0,0 +1,131 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MbTilesStoragePolicy.h"
+
+#include <QDirIterator>
+#include <QFileInfo>
+
+#include "MarbleGlobal.h"
+#include "MbTilesContainer.h"
+
+namespace Marble
+{
+
+// Tiles written per transaction at most
+static const int maximumPendingTiles = 100;
+
+// Time after the last download until the pending tiles get written
+static const int commitInterval = 2000; // ms
+
+MbTilesStoragePolicy::MbTilesStoragePolicy( StoragePolicy *fallback, const QString &dataDirectory, QObject *parent )
+    : StoragePolicy( parent ),
+      m_fallback( fallback ),
+      m_dataDirectory( dataDirectory )
+{
+    Q_ASSERT( m_fallback );
+
+    connect( m_fallback, SIGNAL(cleared()),
+             this,       SIGNAL(cleared()) );
+    connect( m_fallback, SIGNAL(sizeChanged(qint64)),
+             this,       SIGNAL(sizeChanged(qint64)) );
+
+    m_commitTimer.setSingleShot( true );
+    m_commitTimer.setInterval( commitInterval );
+    connect( &m_commitTimer, SIGNAL(timeout()),
+             this,           SLOT(commit()) );
+}
+
+MbTilesStoragePolicy::~MbTilesStoragePolicy()
+{
+    commit();
+}
+
+bool MbTilesStoragePolicy::fileExists( const QString &fileName ) const
+{
+    QString containerFileName;
+    int zoomLevel, x, y;
+    if ( !MbTilesContainer::splitTileFileName( fileName, containerFileName, zoomLevel, x, y ) ) {
+        return m_fallback->fileExists( fileName );
+    }
+
+    return container( containerFileName )->hasTile( zoomLevel, x, y );
+}
+
+bool MbTilesStoragePolicy::updateFile( const QString &fileName, const QByteArray &data )
+{
+    QString containerFileName;
+    int zoomLevel, x, y;
+    if ( !MbTilesContainer::splitTileFileName( fileName, containerFileName, zoomLevel, x, y ) ) {
+        return m_fallback->updateFile( fileName, data );
+    }
+
+    MbTilesContainer *const container = this->container( containerFileName );
+    container->insertTile( zoomLevel, x, y, data );
+    m_dirtyContainers.insert( container );
+    emit sizeChanged( data.size() );
+
+    if ( container->pendingTileCount() >= maximumPendingTiles ) {
+        commit();
+    } else {
+        // restarted by each download, so a burst of tiles ends up in one transaction
+        m_commitTimer.start();
+    }
+
+    return true;
+}
+
+void MbTilesStoragePolicy::clearCache()
+{
+    // containers with pending tiles only don't have a file yet
+    QSet<MbTilesContainer *> containers = m_dirtyContainers;
+
+    QDirIterator it( m_dataDirectory + QLatin1String( "/maps" ), QStringList() << QStringLiteral( "*.mbtiles" ),
+                     QDir::Files | QDir::NoSymLinks, QDirIterator::Subdirectories );
+    while ( it.hasNext() ) {
+        containers.insert( MbTilesContainer::container( it.next() ) );
+    }
+
+    for ( MbTilesContainer *container: containers ) {
+        if ( !container->removeTiles( maxBaseTileLevel + 1 ) ) {
+            m_errorMsg = container->lastErrorMessage();
+        }
+    }
+
+    // emits cleared()
+    m_fallback->clearCache();
+}
+
+QString MbTilesStoragePolicy::lastErrorMessage() const
+{
+    return m_errorMsg.isEmpty() ? m_fallback->lastErrorMessage() : m_errorMsg;
+}
+
+void MbTilesStoragePolicy::commit()
+{
+    m_commitTimer.stop();
+
+    for ( MbTilesContainer *container: m_dirtyContainers ) {
+        if ( !container->commit() ) {
+            m_errorMsg = container->lastErrorMessage();
+        }
+    }
+
+    m_dirtyContainers.clear();
+}
+
+MbTilesContainer *MbTilesStoragePolicy::container( const QString &containerFileName ) const
+{
+    const QFileInfo fileInfo( containerFileName );
+    return MbTilesContainer::container( fileInfo.isAbsolute() ? containerFileName
+                                                              : m_dataDirectory + QLatin1Char( '/' ) + containerFileName );
+}
+
+}
+
+#include "moc_MbTilesStoragePolicy.cpp"
@@ -0,0 +1,81 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_MBTILESSTORAGEPOLICY_H
+#define MARBLE_MBTILESSTORAGEPOLICY_H
+
+#include "StoragePolicy.h"
+
+#include "marble_export.h"
+
+#include <QSet>
+#include <QTimer>
+
+namespace Marble
+{
+
+class MbTilesContainer;
+
+/**
+ * @short Stores downloaded tiles of container themes in their MBTiles file.
+ *
+ * File names pointing into an MBTiles container, as created for map themes
+ * with a tile container in their DGML, are queued in the container and
+ * written in batches: once enough tiles are pending or shortly after the
+ * last download.  All other files are passed on to the fallback policy.
+ */
+class MARBLE_EXPORT MbTilesStoragePolicy : public StoragePolicy
+{
+    Q_OBJECT
+
+    public:
+        /**
+         * Creates a new MBTiles storage policy.
+         *
+         * @param fallback      The policy storing files outside of containers.
+         * @param dataDirectory The directory relative container file names refer to.
+         */
+        explicit MbTilesStoragePolicy( StoragePolicy *fallback, const QString &dataDirectory, QObject *parent = 0 );
+
+        /**
+         * Writes all pending tiles.
+         */
+        ~MbTilesStoragePolicy() override;
+
+        bool fileExists( const QString &fileName ) const override;
+
+        bool updateFile( const QString &fileName, const QByteArray &data ) override;
+
+        /**
+         * Removes the downloaded tiles from the containers in the maps
+         * directory below the data directory and clears the cache of the
+         * fallback policy.  Like the fallback policy, the base tile levels
+         * are kept.
+         */
+        void clearCache() override;
+
+        QString lastErrorMessage() const override;
+
+    private Q_SLOTS:
+        void commit();
+
+    private:
+        Q_DISABLE_COPY( MbTilesStoragePolicy )
+
+        MbTilesContainer *container( const QString &containerFileName ) const;
+
+        StoragePolicy *const m_fallback;
+        const QString m_dataDirectory;
+        QSet<MbTilesContainer *> m_dirtyContainers;
+        QTimer m_commitTimer;
+        QString m_errorMsg;
+};
+
+}
+
+#endif
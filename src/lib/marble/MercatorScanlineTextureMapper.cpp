@@ -17,12 +17,10 @@
 // posix
 #include <cmath>
 
-// Qt
-#include <QRunnable>
-
 // Marble
 #include "GeoPainter.h"
 #include "MarbleDebug.h"
+#include "ScanlineRenderScheduler.h"
 #include "ScanlineTextureMapperContext.h"
 #include "StackedTileLoader.h"
 #include "TextureColorizer.h"
@@ -32,31 +30,23 @@
 
 using namespace Marble;
 
-class MercatorScanlineTextureMapper::RenderJob : public QRunnable
+class MercatorScanlineTextureMapper::RenderJob : public ScanlineRenderScheduler::Job
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality );
 
-    void run() override;
+    void renderBlock( ScanlineTextureMapperContext &context, int yPaintedTop, int yPaintedBottom ) override;
 
 private:
-    StackedTileLoader *const m_tileLoader;
-    const int m_tileLevel;
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    const int m_yPaintedTop;
-    const int m_yPaintedBottom;
 };
 
-MercatorScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
-    : m_tileLoader( tileLoader ),
-      m_tileLevel( tileLevel ),
-      m_canvasImage( canvasImage ),
+MercatorScanlineTextureMapper::RenderJob::RenderJob( QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality )
+    : m_canvasImage( canvasImage ),
       m_viewport( viewport ),
-      m_mapQuality( mapQuality ),
-      m_yPaintedTop( yTop ),
-      m_yPaintedBottom( yBottom )
+      m_mapQuality( mapQuality )
 {
 }
 
@@ -64,7 +54,8 @@ MercatorScanlineTextureMapper::MercatorScanlineTextureMapper( StackedTileLoader
     : TextureMapperInterface(),
       m_tileLoader( tileLoader ),
       m_radius( 0 ),
-      m_oldYPaintedTop( 0 )
+      m_oldYPaintedTop( 0 ),
+      m_scheduler( &m_threadPool )
 {
 }
 
@@ -127,14 +118,8 @@ void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     yPaintedTop = qBound(0, yPaintedTop, imageHeight);
     yPaintedBottom = qBound(0, yPaintedBottom, imageHeight);
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = ( yPaintedBottom - yPaintedTop ) / numThreads;
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yPaintedTop +  i      * yStep;
-        const int yEnd   = yPaintedTop + (i + 1) * yStep;
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
+    RenderJob job( &m_canvasImage, viewport, mapQuality );
+    m_scheduler.start( &job, m_tileLoader, tileZoomLevel, yPaintedTop, yPaintedBottom );
 
     // Remove unused lines
     const int clearStart = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? yPaintedBottom : 0;
@@ -147,7 +132,7 @@ void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
         *(it) = 0;
     }
 
-    m_threadPool.waitForDone();
+    m_scheduler.waitForDone();
 
     m_oldYPaintedTop = yPaintedTop;
 
@@ -155,7 +140,7 @@ void MercatorScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
 }
 
 
-void MercatorScanlineTextureMapper::RenderJob::run()
+void MercatorScanlineTextureMapper::RenderJob::renderBlock( ScanlineTextureMapperContext &context, int yPaintedTop, int yPaintedBottom )
 {
     // Scanline based algorithm to do texture mapping
 
@@ -187,14 +172,9 @@ void MercatorScanlineTextureMapper::RenderJob::run()
     const int maxInterpolationPointX = n * (int)( imageWidth / n - 1 ) + 1;
 
 
-    // initialize needed variables that are modified during texture mapping:
-
-    ScanlineTextureMapperContext context( m_tileLoader, m_tileLevel );
-
-
     // Scanline based algorithm to do texture mapping
 
-    for ( int y = m_yPaintedTop; y < m_yPaintedBottom; ++y ) {
+    for ( int y = yPaintedTop; y < yPaintedBottom; ++y ) {
 
         QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) );
 
@@ -238,7 +218,7 @@ void MercatorScanlineTextureMapper::RenderJob::run()
         }
 
         // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yPaintedBottom ) { 
+        if ( interlaced && y + 1 < yPaintedBottom ) { 
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
@@ -249,3 +229,8 @@ void MercatorScanlineTextureMapper::RenderJob::run()
         }
     }
 }
+
+QString MercatorScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.statistics().toString();
+}
@@ -15,6 +15,7 @@
 
 
 #include "TextureMapperInterface.h"
+#include "ScanlineRenderScheduler.h"
 
 #include "MarbleGlobal.h"
 
@@ -38,6 +39,8 @@ class MercatorScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer ) override;
 
+    QString runtimeTrace() const override;
+
  private:
     void mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
 
@@ -49,6 +52,7 @@ class MercatorScanlineTextureMapper : public TextureMapperInterface
     QImage m_canvasImage;
     int    m_oldYPaintedTop;
     QThreadPool m_threadPool;
+    ScanlineRenderScheduler m_scheduler;
 };
 
 }
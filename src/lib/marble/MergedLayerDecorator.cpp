@@ -20,7 +20,6 @@
 
 #include "blendings/Blending.h"
 #include "blendings/BlendingFactory.h"
-#include "SunLocator.h"
 #include "MarbleMath.h"
 #include "MarbleDebug.h"
 #include "GeoDataGroundOverlay.h"
@@ -42,21 +41,17 @@ using namespace Marble;
 class Q_DECL_HIDDEN MergedLayerDecorator::Private
 {
 public:
-    Private( TileLoader *tileLoader, const SunLocator *sunLocator );
-
-    static int maxDivisor( int maximum, int fullLength );
+    explicit Private( TileLoader *tileLoader );
 
     StackedTile *createTile( const QVector<QSharedPointer<TextureTile> > &tiles ) const;
 
     void renderGroundOverlays( QImage *tileImage, const QVector<QSharedPointer<TextureTile> > &tiles ) const;
-    void paintSunShading( QImage *tileImage, const TileId &id ) const;
     void paintTileId( QImage *tileImage, const TileId &id ) const;
 
     void detectMaxTileLevel();
     QVector<const GeoSceneTextureTileDataset *> findRelevantTextureLayers( const TileId &stackedTileId ) const;
 
     TileLoader *const m_tileLoader;
-    const SunLocator *const m_sunLocator;
     BlendingFactory m_blendingFactory;
     QVector<const GeoSceneTextureTileDataset *> m_textureLayers;
     QList<const GeoDataGroundOverlay *> m_groundOverlays;
@@ -64,29 +59,23 @@ public:
     QString m_themeId;
     int m_levelZeroColumns;
     int m_levelZeroRows;
-    bool m_showSunShading;
-    bool m_showCityLights;
     bool m_showTileId;
 };
 
-MergedLayerDecorator::Private::Private( TileLoader *tileLoader, const SunLocator *sunLocator ) :
+MergedLayerDecorator::Private::Private( TileLoader *tileLoader ) :
     m_tileLoader( tileLoader ),
-    m_sunLocator( sunLocator ),
-    m_blendingFactory( sunLocator ),
+    m_blendingFactory(),
     m_textureLayers(),
     m_maxTileLevel( 0 ),
     m_themeId(),
     m_levelZeroColumns( 0 ),
     m_levelZeroRows( 0 ),
-    m_showSunShading( false ),
-    m_showCityLights( false ),
     m_showTileId( false )
 {
 }
 
-MergedLayerDecorator::MergedLayerDecorator( TileLoader * const tileLoader,
-                                            const SunLocator* sunLocator )
-    : d( new Private( tileLoader, sunLocator ) )
+MergedLayerDecorator::MergedLayerDecorator( TileLoader * const tileLoader )
+    : d( new Private( tileLoader ) )
 {
 }
 
@@ -101,7 +90,6 @@ void MergedLayerDecorator::setTextureLayers( const QVector<const GeoSceneTexture
         const GeoSceneTileDataset *const firstTexture = textureLayers.at( 0 );
         d->m_levelZeroColumns = firstTexture->levelZeroColumns();
         d->m_levelZeroRows = firstTexture->levelZeroRows();
-        d->m_blendingFactory.setLevelZeroLayout( d->m_levelZeroColumns, d->m_levelZeroRows );
         d->m_themeId = QLatin1String("maps/") + firstTexture->sourceDir();
     }
 
@@ -170,7 +158,7 @@ StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPoi
 
     // if there are more than one active texture layers, we have to convert the
     // result tile into QImage::Format_ARGB32_Premultiplied to make blending possible
-    const bool withConversion = tiles.count() > 1 || m_showSunShading || m_showTileId || !m_groundOverlays.isEmpty();
+    const bool withConversion = tiles.count() > 1 || m_showTileId || !m_groundOverlays.isEmpty();
     for ( const QSharedPointer<TextureTile> &tile: tiles ) {
 
         // Image blending. If there are several images in the same tile (like clouds
@@ -199,10 +187,6 @@ StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPoi
 
     renderGroundOverlays( &resultImage, tiles );
 
-    if ( m_showSunShading && !m_showCityLights ) {
-        paintSunShading( &resultImage, id );
-    }
-
     if ( m_showTileId ) {
         paintTileId( &resultImage, id );
     }
@@ -395,112 +379,11 @@ void MergedLayerDecorator::downloadStackedTile( const TileId &id, DownloadUsage
     }
 }
 
-void MergedLayerDecorator::setShowSunShading( bool show )
-{
-    d->m_showSunShading = show;
-}
-
-bool MergedLayerDecorator::showSunShading() const
-{
-    return d->m_showSunShading;
-}
-
-void MergedLayerDecorator::setShowCityLights( bool show )
-{
-    d->m_showCityLights = show;
-}
-
-bool MergedLayerDecorator::showCityLights() const
-{
-    return d->m_showCityLights;
-}
-
 void MergedLayerDecorator::setShowTileId( bool visible )
 {
     d->m_showTileId = visible;
 }
 
-void MergedLayerDecorator::Private::paintSunShading( QImage *tileImage, const TileId &id ) const
-{
-    if ( tileImage->depth() != 32 )
-        return;
-
-    // TODO add support for 8-bit maps?
-    // add sun shading
-    const qreal  global_width  = tileImage->width()
-            * TileLoaderHelper::levelToColumn( m_levelZeroColumns, id.zoomLevel() );
-    const qreal  global_height = tileImage->height()
-            * TileLoaderHelper::levelToRow( m_levelZeroRows, id.zoomLevel() );
-    const qreal lon_scale = 2*M_PI / global_width;
-    const qreal lat_scale = -M_PI / global_height;
-    const int tileHeight = tileImage->height();
-    const int tileWidth = tileImage->width();
-
-    // First we determine the supporting point interval for the interpolation.
-    const int n = maxDivisor( 30, tileWidth );
-    const int ipRight = n * (int)( tileWidth / n );
-
-    for ( int cur_y = 0; cur_y < tileHeight; ++cur_y ) {
-        const qreal lat = lat_scale * ( id.y() * tileHeight + cur_y ) - 0.5*M_PI;
-        const qreal a = sin( (lat+DEG2RAD * m_sunLocator->getLat() )/2.0 );
-        const qreal c = cos(lat)*cos( -DEG2RAD * m_sunLocator->getLat() );
-
-        QRgb* scanline = (QRgb*)tileImage->scanLine( cur_y );
-
-        qreal lastShade = -10.0;
-
-        int cur_x = 0;
-
-        while ( cur_x < tileWidth ) {
-
-            const bool interpolate = ( cur_x != 0 && cur_x < ipRight && cur_x + n < tileWidth );
-
-            qreal shade = 0;
-
-            if ( interpolate ) {
-                const int check = cur_x + n;
-                const qreal checklon   = lon_scale * ( id.x() * tileWidth + check );
-                shade = m_sunLocator->shading( checklon, a, c );
-
-                // if the shading didn't change across the interpolation
-                // interval move on and don't change anything.
-                if ( shade == lastShade && shade == 1.0 ) {
-                    scanline += n;
-                    cur_x += n;
-                    continue;
-                }
-                if ( shade == lastShade && shade == 0.0 ) {
-                    for ( int t = 0; t < n; ++t ) {
-                        m_sunLocator->shadePixel( *scanline, shade );
-                        ++scanline;
-                    }
-                    cur_x += n;
-                    continue;
-                }
-                for ( int t = 0; t < n ; ++t ) {
-                    const qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
-                    shade = m_sunLocator->shading( lon, a, c );
-                    m_sunLocator->shadePixel( *scanline, shade );
-                    ++scanline;
-                    ++cur_x;
-                }
-            }
-
-            else {
-                // Make sure we don't exceed the image memory
-                if ( cur_x < tileWidth ) {
-                    const qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
-                    shade = m_sunLocator->shading( lon, a, c );
-                    m_sunLocator->shadePixel( *scanline, shade );
-                    ++scanline;
-                    ++cur_x;
-                }
-            }
-            lastShade = shade;
-        }
-    }
-}
-
 void MergedLayerDecorator::Private::paintTileId( QImage *tileImage, const TileId &id ) const
 {
     QString filename = QString( "%1_%2.jpg" )
@@ -598,25 +481,3 @@ QVector<const GeoSceneTextureTileDataset *> MergedLayerDecorator::Private::findR
 
     return result;
 }
-
-// TODO: This should likely go into a math class in the future ...
-
-int MergedLayerDecorator::Private::maxDivisor( int maximum, int fullLength )
-{
-    // Find the optimal interpolation interval n for the
-    // current image canvas width
-    int best = 2;
-
-    int  nEvalMin = fullLength;
-    for ( int it = 1; it <= maximum; ++it ) {
-        // The optimum is the interval which results in the least amount
-        // supporting points taking into account the rest which can't
-        // get used for interpolation.
-        int nEval = fullLength / it + fullLength % it;
-        if ( nEval < nEvalMin ) {
-            nEvalMin = nEval;
-            best = it;
-        }
-    }
-    return best;
-}
@@ -31,17 +31,16 @@ namespace Marble
 class GeoDataGroundOverlay;
 class GeoSceneAbstractTileProjection;
 class GeoSceneTextureTileDataset;
-class SunLocator;
 class StackedTile;
 class Tile;
 class TileId;
 class TileLoader;
 class RenderState;
 
-class MergedLayerDecorator
+class MARBLE_EXPORT MergedLayerDecorator
 {
  public:
-    MergedLayerDecorator( TileLoader * const tileLoader, const SunLocator* sunLocator );
+    explicit MergedLayerDecorator( TileLoader * const tileLoader );
     virtual ~MergedLayerDecorator();
 
     void setTextureLayers( const QVector<const GeoSceneTextureTileDataset *> &textureLayers );
@@ -69,12 +68,6 @@ class MergedLayerDecorator
 
     void downloadStackedTile( const TileId &id, DownloadUsage usage );
 
-    void setShowSunShading( bool show );
-    bool showSunShading() const;
-
-    void setShowCityLights( bool show );
-    bool showCityLights() const;
-
     void setShowTileId(bool show);
 
     RenderState renderState( const TileId &stackedTileId ) const;
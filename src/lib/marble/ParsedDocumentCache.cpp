@@ -0,0 +1,262 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ParsedDocumentCache.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+#include "MarbleGlobal.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace Marble
+{
+
+class ParsedDocumentCachePrivate
+{
+public:
+    explicit ParsedDocumentCachePrivate( const QString &directory );
+
+    static bool isSupported( const GeoDataContainer *container );
+    static bool isSupported( const GeoDataFeature *feature );
+    static bool isSupported( const GeoDataGeometry *geometry );
+
+    // "MBDC", followed by the version of the format of the snapshots. Increase the
+    // version whenever the pack() implementation of any GeoData class changes.
+    // The snapshots also carry the version of the library that wrote them, as the
+    // format version cannot be relied upon to follow every change in development.
+    static const quint32 s_magic = 0x4d424443;
+    static const quint32 s_formatVersion = 1;
+    static const int s_streamVersion = QDataStream::Qt_5_2;
+
+    QString m_directory;
+};
+
+ParsedDocumentCachePrivate::ParsedDocumentCachePrivate( const QString &directory ) :
+    m_directory( directory )
+{
+    if ( m_directory.isEmpty() ) {
+        m_directory = MarbleDirs::localPath() + QLatin1String( "/cache/documents" );
+    }
+}
+
+bool ParsedDocumentCachePrivate::isSupported( const GeoDataContainer *container )
+{
+    if ( !isSupported( static_cast<const GeoDataFeature *>( container ) ) ) {
+        return false;
+    }
+
+    QVector<GeoDataFeature*>::ConstIterator i = container->constBegin();
+    QVector<GeoDataFeature*>::ConstIterator const end = container->constEnd();
+    for (; i != end; ++i ) {
+        switch ( ( *i )->featureId() ) {
+        case GeoDataDocumentId:
+        case GeoDataFolderId:
+            if ( !isSupported( static_cast<const GeoDataContainer *>( *i ) ) ) {
+                return false;
+            }
+            break;
+        case GeoDataPlacemarkId: {
+            const GeoDataPlacemark *placemark = static_cast<const GeoDataPlacemark *>( *i );
+            if ( !isSupported( placemark ) || placemark->hasOsmData() ) {
+                return false;
+            }
+            const GeoDataGeometry *geometry = placemark->geometry();
+            if ( geometry && !isSupported( geometry ) ) {
+                return false;
+            }
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ParsedDocumentCachePrivate::isSupported( const GeoDataFeature *feature )
+{
+    // GeoDataFeature::pack() only stores the plain data values of the extended data
+    const GeoDataExtendedData &extendedData = feature->extendedData();
+    return extendedData.schemaDataList().isEmpty() && !extendedData.hasSimpleArrayData();
+}
+
+bool ParsedDocumentCachePrivate::isSupported( const GeoDataGeometry *geometry )
+{
+    switch ( geometry->geometryId() ) {
+    case GeoDataPointId:
+    case GeoDataLineStringId:
+    case GeoDataLinearRingId:
+    case GeoDataPolygonId:
+        return true;
+    case GeoDataMultiGeometryId: {
+        const GeoDataMultiGeometry *multiGeometry = static_cast<const GeoDataMultiGeometry *>( geometry );
+        QVector<GeoDataGeometry*>::ConstIterator i = multiGeometry->constBegin();
+        QVector<GeoDataGeometry*>::ConstIterator const end = multiGeometry->constEnd();
+        for (; i != end; ++i ) {
+            if ( !isSupported( *i ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+ParsedDocumentCache::ParsedDocumentCache( const QString &directory ) :
+    d( new ParsedDocumentCachePrivate( directory ) )
+{
+}
+
+ParsedDocumentCache::~ParsedDocumentCache()
+{
+    delete d;
+}
+
+QString ParsedDocumentCache::directory() const
+{
+    return d->m_directory;
+}
+
+QString ParsedDocumentCache::snapshotPath( const QString &sourceFile, const QByteArray &variant ) const
+{
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    hash.addData( QFileInfo( sourceFile ).absoluteFilePath().toUtf8() );
+    hash.addData( variant );
+    return d->m_directory + QLatin1Char( '/' ) + QString::fromLatin1( hash.result().toHex() ) + QLatin1String( ".snapshot" );
+}
+
+GeoDataDocument *ParsedDocumentCache::load( const QString &sourceFile, const QByteArray &variant ) const
+{
+    const QFileInfo source( sourceFile );
+    if ( !source.exists() ) {
+        return 0;
+    }
+
+    QFile file( snapshotPath( sourceFile, variant ) );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return 0;
+    }
+
+    // the snapshot is read straight from the mapped file, only falling back to
+    // reading it into memory where mapping is not possible
+    QByteArray data;
+    const uchar *mapped = file.map( 0, file.size() );
+    if ( mapped ) {
+        data = QByteArray::fromRawData( reinterpret_cast<const char *>( mapped ), file.size() );
+    } else {
+        data = file.readAll();
+    }
+
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+    QDataStream stream( &buffer );
+    stream.setVersion( ParsedDocumentCachePrivate::s_streamVersion );
+
+    quint32 magic;
+    quint32 formatVersion;
+    QString libraryVersion;
+    QString path;
+    qint64 lastModified;
+    qint64 size;
+    QByteArray snapshotVariant;
+    stream >> magic >> formatVersion;
+    if ( stream.status() != QDataStream::Ok
+         || magic != ParsedDocumentCachePrivate::s_magic
+         || formatVersion != ParsedDocumentCachePrivate::s_formatVersion ) {
+        return 0;
+    }
+
+    stream >> libraryVersion;
+    if ( stream.status() != QDataStream::Ok || libraryVersion != MARBLE_VERSION_STRING ) {
+        mDebug() << "Ignoring snapshot of" << sourceFile << "written by Marble" << libraryVersion;
+        return 0;
+    }
+
+    stream >> path >> lastModified >> size >> snapshotVariant;
+    if ( stream.status() != QDataStream::Ok
+         || path != source.absoluteFilePath()
+         || lastModified != source.lastModified().toMSecsSinceEpoch()
+         || size != source.size()
+         || snapshotVariant != variant ) {
+        mDebug() << "Ignoring outdated snapshot of" << sourceFile;
+        return 0;
+    }
+
+    // The whole document is unpacked at once. Its features are owned GeoData
+    // objects that the tree model, the scene and the search index walk right
+    // after loading, so unpacking them on demand would not defer any work.
+    GeoDataDocument *document = new GeoDataDocument;
+    document->unpack( stream );
+    if ( stream.status() != QDataStream::Ok || !buffer.atEnd() ) {
+        mDebug() << "Ignoring corrupt snapshot of" << sourceFile;
+        delete document;
+        return 0;
+    }
+
+    document->setFileName( sourceFile );
+    return document;
+}
+
+bool ParsedDocumentCache::save( const QString &sourceFile, const QByteArray &variant, const GeoDataDocument &document ) const
+{
+    const QFileInfo source( sourceFile );
+    if ( !source.exists() || !isSupported( document ) ) {
+        return false;
+    }
+
+    if ( !QDir().mkpath( d->m_directory ) ) {
+        return false;
+    }
+
+    // written to a temporary file first, so readers never see half a snapshot
+    QSaveFile file( snapshotPath( sourceFile, variant ) );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        return false;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( ParsedDocumentCachePrivate::s_streamVersion );
+    stream << ParsedDocumentCachePrivate::s_magic << ParsedDocumentCachePrivate::s_formatVersion;
+    stream << MARBLE_VERSION_STRING;
+    stream << source.absoluteFilePath() << source.lastModified().toMSecsSinceEpoch() << source.size() << variant;
+    document.pack( stream );
+
+    if ( stream.status() != QDataStream::Ok ) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+void ParsedDocumentCache::remove( const QString &sourceFile, const QByteArray &variant ) const
+{
+    QFile::remove( snapshotPath( sourceFile, variant ) );
+}
+
+bool ParsedDocumentCache::isSupported( const GeoDataDocument &document )
+{
+    return ParsedDocumentCachePrivate::isSupported( &document );
+}
+
+}
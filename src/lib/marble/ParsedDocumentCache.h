@@ -0,0 +1,89 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PARSEDDOCUMENTCACHE_H
+#define MARBLE_PARSEDDOCUMENTCACHE_H
+
+#include "marble_export.h"
+
+#include <QByteArray>
+#include <QString>
+
+namespace Marble
+{
+
+class GeoDataDocument;
+class ParsedDocumentCachePrivate;
+
+/**
+ * @brief The ParsedDocumentCache class keeps binary snapshots of parsed documents
+ *
+ * A snapshot is the packed form of a GeoDataDocument, stored together with the
+ * path, modification time and size of the file it was parsed from. Loading it
+ * maps the snapshot file and unpacks the complete document in one go, which is
+ * much faster than parsing the source file again. Nothing is unpacked lazily.
+ * Snapshots whose source file changed, that were written by a different format
+ * version or Marble version, or for a different @p variant are ignored.
+ *
+ * The variant is an opaque key for everything besides the source file that
+ * influenced the document, e.g. the style FileLoader applied to it.
+ *
+ * Only documents built from documents, folders and placemarks with point, line,
+ * polygon and multi geometries can be stored, see isSupported(). Neither OSM data
+ * nor KML schema data and simple array data are stored, so documents carrying
+ * them are not supported either.
+ */
+class MARBLE_EXPORT ParsedDocumentCache
+{
+public:
+    /**
+     * @brief Creates a cache storing its snapshots in @p directory, which
+     * defaults to cache/documents/ in the local Marble data directory.
+     */
+    explicit ParsedDocumentCache( const QString &directory = QString() );
+
+    ~ParsedDocumentCache();
+
+    QString directory() const;
+
+    /**
+     * @brief Returns the path of the snapshot of @p sourceFile
+     */
+    QString snapshotPath( const QString &sourceFile, const QByteArray &variant ) const;
+
+    /**
+     * @brief Returns the document stored for @p sourceFile, or 0 if there is no
+     * up to date snapshot of it. The caller takes ownership of the document.
+     */
+    GeoDataDocument *load( const QString &sourceFile, const QByteArray &variant ) const;
+
+    /**
+     * @brief Stores a snapshot of @p document, which was parsed from @p sourceFile.
+     * @return false if the document is not supported or could not be written
+     */
+    bool save( const QString &sourceFile, const QByteArray &variant, const GeoDataDocument &document ) const;
+
+    /**
+     * @brief Removes the snapshot of @p sourceFile, if any
+     */
+    void remove( const QString &sourceFile, const QByteArray &variant ) const;
+
+    /**
+     * @brief Returns whether @p document can be stored without losing any features
+     */
+    static bool isSupported( const GeoDataDocument &document );
+
+private:
+    Q_DISABLE_COPY( ParsedDocumentCache )
+
+    ParsedDocumentCachePrivate *const d;
+};
+
+}
+
+#endif
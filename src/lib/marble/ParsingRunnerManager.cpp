@@ -20,6 +20,7 @@
 
 #include <QFileInfo>
 #include <QList>
+#include <QThread>
 #include <QThreadPool>
 #include <QTimer>
 #include <QMutex>
@@ -29,6 +30,22 @@ namespace Marble
 
 class MarbleModel;
 
+/**
+ * Parsing gets a pool of its own, sized to the machine, so that the files of a map
+ * theme are parsed side by side and don't queue up behind other users of the
+ * global pool, like tile loading or search.
+ */
+class ParsingThreadPool : public QThreadPool
+{
+public:
+    ParsingThreadPool()
+    {
+        setMaxThreadCount( qMax( 2, QThread::idealThreadCount() ) );
+    }
+};
+
+Q_GLOBAL_STATIC( ParsingThreadPool, s_parsingThreadPool )
+
 class Q_DECL_HIDDEN ParsingRunnerManager::Private
 {
 public:
@@ -73,9 +90,6 @@ ParsingRunnerManager::ParsingRunnerManager( const PluginManager *pluginManager,
     QObject( parent ),
     d( new Private( this, pluginManager ) )
 {
-    if ( QThreadPool::globalInstance()->maxThreadCount() < 4 ) {
-        QThreadPool::globalInstance()->setMaxThreadCount( 4 );
-    }
 }
 
 ParsingRunnerManager::~ParsingRunnerManager()
@@ -98,7 +112,7 @@ void ParsingRunnerManager::parseFile( const QString &fileName, DocumentRole role
             connect( task, SIGNAL(finished()), this, SLOT(cleanupParsingTask()) );
             mDebug() << "parse task " << plugin->nameId() << " " << (quintptr)task;
             ++d->m_parsingTasks;
-            QThreadPool::globalInstance()->start( task );
+            s_parsingThreadPool()->start( task );
         }
     }
 
@@ -0,0 +1,489 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PlacemarkNameIndex.h"
+
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTypes.h"
+#include "MarbleDebug.h"
+#include "MarbleGlobal.h"
+#include "MarblePlacemarkModel.h"
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QPair>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QTime>
+
+#include <qmath.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace Marble
+{
+
+// One degree cells
+static const int GridColumns = 360;
+static const int GridRows = 180;
+
+// Areas covering more cells are looked up by name first
+static const int MaxCellsPerLookup = 4096;
+
+// Dice coefficient of the trigrams for a fuzzy match
+static const qreal MinSimilarity = 0.5;
+
+class Q_DECL_HIDDEN PlacemarkNameIndex::Private
+{
+public:
+    struct Entry
+    {
+        QString key;
+        const GeoDataPlacemark *placemark;
+
+        bool operator<( const Entry &other ) const
+        {
+            const int order = key.compare( other.key );
+            return order < 0 || ( order == 0 && std::less<const GeoDataPlacemark*>()( placemark, other.placemark ) );
+        }
+    };
+
+    struct Item
+    {
+        QString key;
+        qreal longitude;
+        qreal latitude;
+        int cell;
+        int trigrams;
+    };
+
+    explicit Private( QAbstractItemModel *model );
+
+    QVector<const GeoDataPlacemark*> placemarks( int first, int last ) const;
+    void add( const QVector<const GeoDataPlacemark*> &placemarks );
+    void remove( const QVector<const GeoDataPlacemark*> &placemarks );
+    void clear();
+
+    QVector<const GeoDataPlacemark*> prefixMatches( const QString &key, const GeoDataLatLonBox &preferred ) const;
+    QVector<const GeoDataPlacemark*> fuzzyMatches( const QString &key, const GeoDataLatLonBox &preferred ) const;
+
+    static int cell( qreal longitude, qreal latitude );
+    static QVector<int> cells( const GeoDataLatLonBox &box );
+    static bool contains( const GeoDataLatLonBox &box, const Item &item );
+    static QVector<quint64> trigrams( const QString &key );
+
+    QAbstractItemModel *const m_model;
+
+    // Guards all of the below. Written in the thread of the model, read by the search runners.
+    mutable QReadWriteLock m_lock;
+
+    // Sorted by key, so that all keys starting with a prefix are in one range
+    QVector<Entry> m_entries;
+    QHash<const GeoDataPlacemark*, Item> m_items;
+    QHash<int, QVector<const GeoDataPlacemark*> > m_cells;
+    QHash<quint64, QVector<const GeoDataPlacemark*> > m_trigrams;
+};
+
+PlacemarkNameIndex::Private::Private( QAbstractItemModel *model ) :
+    m_model( model )
+{
+    // nothing to do
+}
+
+QVector<const GeoDataPlacemark*> PlacemarkNameIndex::Private::placemarks( int first, int last ) const
+{
+    QVector<const GeoDataPlacemark*> result;
+    result.reserve( last - first + 1 );
+    for ( int row = first; row <= last; ++row ) {
+        const QVariant data = m_model->index( row, 0 ).data( MarblePlacemarkModel::ObjectPointerRole );
+        const GeoDataObject *object = qvariant_cast<GeoDataObject*>( data );
+        if ( object && object->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+            result << static_cast<const GeoDataPlacemark*>( object );
+        }
+    }
+    return result;
+}
+
+void PlacemarkNameIndex::Private::add( const QVector<const GeoDataPlacemark*> &placemarks )
+{
+    QVector<Entry> entries;
+    entries.reserve( placemarks.size() );
+    for ( const GeoDataPlacemark *placemark: placemarks ) {
+        if ( m_items.contains( placemark ) ) {
+            continue;
+        }
+
+        // Placemarks without a name can't be found anyway
+        const QString key = fold( placemark->name() );
+        if ( key.isEmpty() ) {
+            continue;
+        }
+
+        const GeoDataCoordinates coordinates = placemark->coordinate();
+        const QVector<quint64> keyTrigrams = trigrams( key );
+        Item item;
+        item.key = key;
+        item.longitude = coordinates.longitude();
+        item.latitude = coordinates.latitude();
+        item.cell = cell( item.longitude, item.latitude );
+        item.trigrams = keyTrigrams.size();
+        m_items.insert( placemark, item );
+
+        m_cells[item.cell] << placemark;
+        for ( quint64 trigram: keyTrigrams ) {
+            m_trigrams[trigram] << placemark;
+        }
+        entries << Entry{ key, placemark };
+    }
+
+    // Merging the sorted new entries is linear, unlike inserting them one by one
+    std::sort( entries.begin(), entries.end() );
+    const int middle = m_entries.size();
+    m_entries += entries;
+    std::inplace_merge( m_entries.begin(), m_entries.begin() + middle, m_entries.end() );
+}
+
+void PlacemarkNameIndex::Private::remove( const QVector<const GeoDataPlacemark*> &placemarks )
+{
+    QSet<const GeoDataPlacemark*> removed;
+    QSet<int> cells;
+    QSet<quint64> keyTrigrams;
+    for ( const GeoDataPlacemark *placemark: placemarks ) {
+        const QHash<const GeoDataPlacemark*, Item>::iterator item = m_items.find( placemark );
+        if ( item == m_items.end() ) {
+            continue;
+        }
+        removed << placemark;
+        cells << item->cell;
+        for ( quint64 trigram: trigrams( item->key ) ) {
+            keyTrigrams << trigram;
+        }
+        m_items.erase( item );
+    }
+
+    if ( removed.isEmpty() ) {
+        return;
+    }
+
+    // One pass over each affected list for all placemarks removed at once
+    const auto isRemoved = [&removed]( const GeoDataPlacemark *placemark ) {
+        return removed.contains( placemark );
+    };
+    m_entries.erase( std::remove_if( m_entries.begin(), m_entries.end(), [&isRemoved]( const Entry &entry ) {
+        return isRemoved( entry.placemark );
+    } ), m_entries.end() );
+
+    for ( int cell: cells ) {
+        QVector<const GeoDataPlacemark*> &list = m_cells[cell];
+        list.erase( std::remove_if( list.begin(), list.end(), isRemoved ), list.end() );
+        if ( list.isEmpty() ) {
+            m_cells.remove( cell );
+        }
+    }
+
+    for ( quint64 trigram: keyTrigrams ) {
+        QVector<const GeoDataPlacemark*> &list = m_trigrams[trigram];
+        list.erase( std::remove_if( list.begin(), list.end(), isRemoved ), list.end() );
+        if ( list.isEmpty() ) {
+            m_trigrams.remove( trigram );
+        }
+    }
+}
+
+void PlacemarkNameIndex::Private::clear()
+{
+    m_entries.clear();
+    m_items.clear();
+    m_cells.clear();
+    m_trigrams.clear();
+}
+
+QVector<const GeoDataPlacemark*> PlacemarkNameIndex::Private::prefixMatches( const QString &key, const GeoDataLatLonBox &preferred ) const
+{
+    typedef QVector<Entry>::const_iterator Iterator;
+    const Iterator begin = std::lower_bound( m_entries.constBegin(), m_entries.constEnd(), key,
+                                             []( const Entry &entry, const QString &prefix ) {
+        return entry.key.leftRef( prefix.size() ).compare( prefix ) < 0;
+    } );
+    const Iterator end = std::upper_bound( begin, m_entries.constEnd(), key,
+                                           []( const QString &prefix, const Entry &entry ) {
+        return entry.key.leftRef( prefix.size() ).compare( prefix ) > 0;
+    } );
+
+    QVector<const GeoDataPlacemark*> result;
+    if ( preferred.isEmpty() ) {
+        result.reserve( end - begin );
+        for ( Iterator entry = begin; entry != end; ++entry ) {
+            result << entry->placemark;
+        }
+        return result;
+    }
+
+    // Short prefixes match many names, but only a few of them lie in a small area.
+    // Check the names of the placemarks in the area then.
+    const QVector<int> areaCells = cells( preferred );
+    int areaCount = 0;
+    if ( areaCells.size() <= MaxCellsPerLookup ) {
+        for ( int cell: areaCells ) {
+            areaCount += m_cells.value( cell ).size();
+        }
+    }
+
+    if ( areaCells.size() <= MaxCellsPerLookup && areaCount < end - begin ) {
+        QVector<Entry> entries;
+        for ( int cell: areaCells ) {
+            for ( const GeoDataPlacemark *placemark: m_cells.value( cell ) ) {
+                const Item &item = m_items.find( placemark ).value();
+                if ( item.key.startsWith( key ) && contains( preferred, item ) ) {
+                    entries << Entry{ item.key, placemark };
+                }
+            }
+        }
+        std::sort( entries.begin(), entries.end() );
+        result.reserve( entries.size() );
+        for ( const Entry &entry: entries ) {
+            result << entry.placemark;
+        }
+    } else {
+        for ( Iterator entry = begin; entry != end; ++entry ) {
+            if ( contains( preferred, m_items.find( entry->placemark ).value() ) ) {
+                result << entry->placemark;
+            }
+        }
+    }
+
+    return result;
+}
+
+QVector<const GeoDataPlacemark*> PlacemarkNameIndex::Private::fuzzyMatches( const QString &key, const GeoDataLatLonBox &preferred ) const
+{
+    const QVector<quint64> keyTrigrams = trigrams( key );
+    QHash<const GeoDataPlacemark*, int> shared;
+    for ( quint64 trigram: keyTrigrams ) {
+        for ( const GeoDataPlacemark *placemark: m_trigrams.value( trigram ) ) {
+            ++shared[placemark];
+        }
+    }
+
+    QVector<QPair<qreal, Entry> > matches;
+    for ( QHash<const GeoDataPlacemark*, int>::const_iterator iter = shared.constBegin(); iter != shared.constEnd(); ++iter ) {
+        const Item &item = m_items.find( iter.key() ).value();
+        const qreal similarity = 2.0 * iter.value() / ( keyTrigrams.size() + item.trigrams );
+        if ( similarity >= MinSimilarity && ( preferred.isEmpty() || contains( preferred, item ) ) ) {
+            matches << qMakePair( -similarity, Entry{ item.key, iter.key() } );
+        }
+    }
+
+    // Most similar first
+    std::sort( matches.begin(), matches.end() );
+    QVector<const GeoDataPlacemark*> result;
+    result.reserve( matches.size() );
+    for ( const auto &match: matches ) {
+        result << match.second.placemark;
+    }
+    return result;
+}
+
+int PlacemarkNameIndex::Private::cell( qreal longitude, qreal latitude )
+{
+    const int column = qBound( 0, int( qFloor( ( longitude + M_PI ) * RAD2DEG ) ), GridColumns - 1 );
+    const int row = qBound( 0, int( qFloor( ( latitude + M_PI / 2 ) * RAD2DEG ) ), GridRows - 1 );
+    return row * GridColumns + column;
+}
+
+QVector<int> PlacemarkNameIndex::Private::cells( const GeoDataLatLonBox &box )
+{
+    const int west = cell( box.west(), 0.0 ) % GridColumns;
+    const int east = cell( box.east(), 0.0 ) % GridColumns;
+    const int south = cell( 0.0, box.south() ) / GridColumns;
+    const int north = cell( 0.0, box.north() ) / GridColumns;
+
+    QVector<int> columns;
+    if ( box.crossesDateLine() ) {
+        for ( int column = west; column < GridColumns; ++column ) {
+            columns << column;
+        }
+        for ( int column = 0; column <= east; ++column ) {
+            columns << column;
+        }
+    } else {
+        for ( int column = west; column <= east; ++column ) {
+            columns << column;
+        }
+    }
+
+    QVector<int> result;
+    result.reserve( columns.size() * ( north - south + 1 ) );
+    for ( int row = south; row <= north; ++row ) {
+        for ( int column: columns ) {
+            result << row * GridColumns + column;
+        }
+    }
+    return result;
+}
+
+bool PlacemarkNameIndex::Private::contains( const GeoDataLatLonBox &box, const Item &item )
+{
+    if ( item.latitude < box.south() || item.latitude > box.north() ) {
+        return false;
+    }
+
+    if ( box.crossesDateLine() ) {
+        return item.longitude >= box.west() || item.longitude <= box.east();
+    }
+    return item.longitude >= box.west() && item.longitude <= box.east();
+}
+
+QVector<quint64> PlacemarkNameIndex::Private::trigrams( const QString &key )
+{
+    // Padded, so that the start and the end of a name weigh more than its middle
+    const QString padded = QLatin1String( "  " ) + key + QLatin1Char( ' ' );
+    QVector<quint64> result;
+    result.reserve( padded.size() - 2 );
+    for ( int i = 0; i + 2 < padded.size(); ++i ) {
+        result << ( quint64( padded.at( i ).unicode() ) << 32 | quint64( padded.at( i + 1 ).unicode() ) << 16 | padded.at( i + 2 ).unicode() );
+    }
+    std::sort( result.begin(), result.end() );
+    result.erase( std::unique( result.begin(), result.end() ), result.end() );
+    return result;
+}
+
+PlacemarkNameIndex::PlacemarkNameIndex( QAbstractItemModel *model, QObject *parent ) :
+    QObject( parent ),
+    d( new Private( model ) )
+{
+    connect( model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             this, SLOT(addRows(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+             this, SLOT(removeRows(QModelIndex,int,int)) );
+    connect( model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             this, SLOT(updateRows(QModelIndex,QModelIndex)) );
+    connect( model, SIGNAL(modelAboutToBeReset()),
+             this, SLOT(clear()) );
+    connect( model, SIGNAL(modelReset()),
+             this, SLOT(rebuild()) );
+
+    rebuild();
+}
+
+PlacemarkNameIndex::~PlacemarkNameIndex()
+{
+    delete d;
+}
+
+int PlacemarkNameIndex::size() const
+{
+    QReadLocker locker( &d->m_lock );
+    return d->m_entries.size();
+}
+
+QVector<GeoDataPlacemark*> PlacemarkNameIndex::find( const QString &term, const GeoDataLatLonBox &preferred, MatchMode mode ) const
+{
+    QVector<GeoDataPlacemark*> result;
+    const QString key = fold( term.trimmed() );
+    if ( key.isEmpty() ) {
+        return result;
+    }
+
+    QReadLocker locker( &d->m_lock );
+    const QVector<const GeoDataPlacemark*> matches = mode == PrefixMatch ? d->prefixMatches( key, preferred )
+                                                                         : d->fuzzyMatches( key, preferred );
+    result.reserve( matches.size() );
+    for ( const GeoDataPlacemark *placemark: matches ) {
+        result << new GeoDataPlacemark( *placemark );
+    }
+    return result;
+}
+
+QString PlacemarkNameIndex::fold( const QString &name )
+{
+    const QString decomposed = name.toCaseFolded().normalized( QString::NormalizationForm_D );
+    QString result;
+    result.reserve( decomposed.size() );
+    for ( const QChar &character: decomposed ) {
+        switch ( character.unicode() ) {
+        case 0x00DF: // sharp s
+            result += QLatin1String( "ss" );
+            break;
+        case 0x00F8: // o with stroke
+            result += QLatin1Char( 'o' );
+            break;
+        case 0x0111: // d with stroke
+            result += QLatin1Char( 'd' );
+            break;
+        case 0x0142: // l with stroke
+            result += QLatin1Char( 'l' );
+            break;
+        default:
+            if ( character.category() != QChar::Mark_NonSpacing ) {
+                result += character;
+            }
+        }
+    }
+    return result;
+}
+
+void PlacemarkNameIndex::addRows( const QModelIndex &parent, int first, int last )
+{
+    if ( parent.isValid() ) {
+        return;
+    }
+
+    const QVector<const GeoDataPlacemark*> placemarks = d->placemarks( first, last );
+    QWriteLocker locker( &d->m_lock );
+    d->add( placemarks );
+}
+
+void PlacemarkNameIndex::removeRows( const QModelIndex &parent, int first, int last )
+{
+    if ( parent.isValid() ) {
+        return;
+    }
+
+    const QVector<const GeoDataPlacemark*> placemarks = d->placemarks( first, last );
+    QWriteLocker locker( &d->m_lock );
+    d->remove( placemarks );
+}
+
+void PlacemarkNameIndex::updateRows( const QModelIndex &topLeft, const QModelIndex &bottomRight )
+{
+    if ( topLeft.parent().isValid() ) {
+        return;
+    }
+
+    // The name or the position may have changed
+    const QVector<const GeoDataPlacemark*> placemarks = d->placemarks( topLeft.row(), bottomRight.row() );
+    QWriteLocker locker( &d->m_lock );
+    d->remove( placemarks );
+    d->add( placemarks );
+}
+
+void PlacemarkNameIndex::clear()
+{
+    QWriteLocker locker( &d->m_lock );
+    d->clear();
+}
+
+void PlacemarkNameIndex::rebuild()
+{
+    QTime t;
+    t.start();
+
+    const QVector<const GeoDataPlacemark*> placemarks = d->placemarks( 0, d->m_model->rowCount() - 1 );
+    QWriteLocker locker( &d->m_lock );
+    d->clear();
+    d->add( placemarks );
+
+    mDebug() << "Indexed the names of" << d->m_entries.size() << "placemarks in" << t.elapsed() << "ms";
+}
+
+}
+
+#include "moc_PlacemarkNameIndex.cpp"
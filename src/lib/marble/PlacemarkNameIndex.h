@@ -0,0 +1,90 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PLACEMARKNAMEINDEX_H
+#define MARBLE_PLACEMARKNAMEINDEX_H
+
+#include "marble_export.h"
+
+#include <QObject>
+#include <QVector>
+
+class QAbstractItemModel;
+class QModelIndex;
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+class GeoDataPlacemark;
+
+/**
+ * @short An index over the names of the placemarks in a placemark model.
+ *
+ * Names are folded to lower case without diacritics and kept in a sorted
+ * array for prefix lookups and in trigram lists for fuzzy lookups.  A grid
+ * of one degree cells narrows lookups down to an area.  The index follows
+ * the rows inserted into and removed from the model.
+ *
+ * Lookups may run in any thread, while the model has to be changed in the
+ * thread the index lives in.
+ */
+class MARBLE_EXPORT PlacemarkNameIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum MatchMode {
+        PrefixMatch,    ///< Names starting with the search term
+        FuzzyMatch      ///< Names sharing most of their trigrams with the search term
+    };
+
+    /**
+     * Indexes the placemarks of @p model, which have to be available in its
+     * MarblePlacemarkModel::ObjectPointerRole.
+     */
+    explicit PlacemarkNameIndex( QAbstractItemModel *model, QObject *parent = 0 );
+
+    ~PlacemarkNameIndex() override;
+
+    /**
+     * Returns the number of named placemarks indexed.
+     */
+    int size() const;
+
+    /**
+     * Returns copies of the placemarks matching @p term.  If @p preferred is
+     * not empty, only placemarks within it are returned.  Prefix matches are
+     * ordered by name, fuzzy ones by similarity.  The copies are made before
+     * the placemarks can be removed from the model, the caller takes
+     * ownership of them.
+     */
+    QVector<GeoDataPlacemark*> find( const QString &term, const GeoDataLatLonBox &preferred, MatchMode mode = PrefixMatch ) const;
+
+    /**
+     * Returns @p name the way it is indexed: case folded, decomposed and
+     * without combining diacritical marks.
+     */
+    static QString fold( const QString &name );
+
+private Q_SLOTS:
+    void addRows( const QModelIndex &parent, int first, int last );
+    void removeRows( const QModelIndex &parent, int first, int last );
+    void updateRows( const QModelIndex &topLeft, const QModelIndex &bottomRight );
+    void clear();
+    void rebuild();
+
+private:
+    Q_DISABLE_COPY( PlacemarkNameIndex )
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif
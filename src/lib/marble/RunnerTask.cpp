@@ -11,6 +11,7 @@
 
 #include "RunnerTask.h"
 
+#include "FrameProfiler.h"
 #include "MarbleDebug.h"
 #include "ParsingRunner.h"
 #include "ParsingRunnerManager.h"
@@ -92,7 +93,14 @@ ParsingTask::ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager,
 void ParsingTask::run()
 {
     QString error;
-    GeoDataDocument* document = m_runner->parseFile( m_fileName, m_role, error );
+    GeoDataDocument* document;
+    {
+        FrameProfilerScope scope( "ParsingRunner::parseFile" );
+        if ( scope.isRecording() ) {
+            scope.setDetail( m_fileName );
+        }
+        document = m_runner->parseFile( m_fileName, m_role, error );
+    }
     emit parsed(document, error);
     m_runner->deleteLater();
     emit finished();
@@ -0,0 +1,356 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ScanlineRenderScheduler.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include "ScanlineTextureMapperContext.h"
+
+namespace Marble
+{
+
+/**
+ * The blocks not yet rendered by one worker, [begin, end) in block indices.
+ */
+class BlockQueue
+{
+public:
+    BlockQueue() :
+        m_begin( 0 ),
+        m_end( 0 )
+    {}
+
+    void reset( int begin, int end )
+    {
+        QMutexLocker locker( &m_mutex );
+        m_begin = begin;
+        m_end = end;
+    }
+
+    /// Takes the lowest block from the queue, which is used by the owner.
+    bool takeFirst( int &block )
+    {
+        QMutexLocker locker( &m_mutex );
+        if ( m_begin >= m_end ) {
+            return false;
+        }
+        block = m_begin++;
+        return true;
+    }
+
+    /// Takes the upper half of the remaining blocks, which is used by thieves.
+    bool stealUpperHalf( int &begin, int &end )
+    {
+        QMutexLocker locker( &m_mutex );
+        const int remaining = m_end - m_begin;
+        if ( remaining <= 0 ) {
+            return false;
+        }
+        end = m_end;
+        begin = m_end - ( remaining + 1 ) / 2;
+        m_end = begin;
+        return true;
+    }
+
+    int size()
+    {
+        QMutexLocker locker( &m_mutex );
+        return m_end - m_begin;
+    }
+
+private:
+    QMutex m_mutex;
+    int m_begin;
+    int m_end;
+};
+
+class ScanlineRenderScheduler::Private
+{
+public:
+    class Worker;
+
+    Private( QThreadPool *threadPool ) :
+        m_threadPool( threadPool ),
+        m_job( 0 ),
+        m_tileLoader( 0 ),
+        m_tileLevel( 0 ),
+        m_yTop( 0 ),
+        m_yBottom( 0 ),
+        m_fixedBlockHeight( 0 ),
+        m_running( false )
+    {}
+
+    ~Private()
+    {
+        qDeleteAll( m_queues );
+    }
+
+    int chooseBlockHeight( int rowCount, int workerCount ) const;
+
+    bool nextBlock( int workerIndex, int &block, bool &stolen );
+
+    void renderWorker( int workerIndex );
+
+    QThreadPool *const m_threadPool;
+    QList<BlockQueue *> m_queues;
+
+    Job *m_job;
+    StackedTileLoader *m_tileLoader;
+    int m_tileLevel;
+    int m_yTop;
+    int m_yBottom;
+    int m_fixedBlockHeight;
+    bool m_running;
+
+    QElapsedTimer m_frameTimer;
+    QVector<int> m_stealsPerWorker;
+    Statistics m_current;
+    Statistics m_statistics;
+};
+
+class ScanlineRenderScheduler::Private::Worker : public QRunnable
+{
+public:
+    Worker( ScanlineRenderScheduler::Private *scheduler, int workerIndex ) :
+        m_scheduler( scheduler ),
+        m_workerIndex( workerIndex )
+    {}
+
+    void run() override
+    {
+        m_scheduler->renderWorker( m_workerIndex );
+    }
+
+private:
+    ScanlineRenderScheduler::Private *const m_scheduler;
+    const int m_workerIndex;
+};
+
+int ScanlineRenderScheduler::Private::chooseBlockHeight( int rowCount, int workerCount ) const
+{
+    int blockHeight = m_fixedBlockHeight;
+
+    if ( blockHeight <= 0 ) {
+        // Aim at about eight blocks per worker so there is something left to
+        // steal at the end, but don't go below a few scanlines per block since
+        // every block costs a lock and a cold start of the tile lookup.
+        blockHeight = qBound( 4, rowCount / ( 8 * workerCount ), 32 );
+    }
+
+    // Interlaced rendering copies every even scanline into the next one,
+    // so a block must never start at an odd offset.
+    return qMax( 2, blockHeight & ~1 );
+}
+
+bool ScanlineRenderScheduler::Private::nextBlock( int workerIndex, int &block, bool &stolen )
+{
+    BlockQueue *const ownQueue = m_queues[workerIndex];
+    stolen = false;
+
+    if ( ownQueue->takeFirst( block ) ) {
+        return true;
+    }
+
+    forever {
+        // Pick the worker with the most remaining blocks as the victim.
+        int victim = -1;
+        int victimSize = 0;
+        for ( int i = 0; i < m_queues.size(); ++i ) {
+            if ( i == workerIndex ) {
+                continue;
+            }
+            const int size = m_queues[i]->size();
+            if ( size > victimSize ) {
+                victim = i;
+                victimSize = size;
+            }
+        }
+
+        if ( victim < 0 ) {
+            return false;
+        }
+
+        int begin;
+        int end;
+        if ( m_queues[victim]->stealUpperHalf( begin, end ) ) {
+            ownQueue->reset( begin + 1, end );
+            block = begin;
+            stolen = true;
+            return true;
+        }
+
+        // The victim ran dry in the meantime, look for another one.
+    }
+}
+
+void ScanlineRenderScheduler::Private::renderWorker( int workerIndex )
+{
+    ScanlineTextureMapperContext context( m_tileLoader, m_tileLevel );
+    QElapsedTimer timer;
+    timer.start();
+
+    const int blockHeight = m_current.blockHeight;
+    int blocks = 0;
+    int steals = 0;
+    int block;
+    bool stolen;
+    while ( nextBlock( workerIndex, block, stolen ) ) {
+        const int yStart = m_yTop + block * blockHeight;
+        const int yEnd = qMin( m_yBottom, yStart + blockHeight );
+        m_job->renderBlock( context, yStart, yEnd );
+        ++blocks;
+        if ( stolen ) {
+            ++steals;
+        }
+    }
+
+    // Each worker only writes its own slot, the results are read after
+    // QThreadPool::waitForDone() returned.
+    m_current.blocksPerWorker[workerIndex] = blocks;
+    m_current.busyNsecsPerWorker[workerIndex] = timer.nsecsElapsed();
+    m_stealsPerWorker[workerIndex] = steals;
+}
+
+ScanlineRenderScheduler::Job::~Job()
+{
+}
+
+ScanlineRenderScheduler::Statistics::Statistics() :
+    blockCount( 0 ),
+    blockHeight( 0 ),
+    stealCount( 0 ),
+    elapsedNsecs( 0 )
+{
+}
+
+qreal ScanlineRenderScheduler::Statistics::imbalance() const
+{
+    if ( busyNsecsPerWorker.isEmpty() ) {
+        return 1.0;
+    }
+
+    qint64 total = 0;
+    qint64 maximum = 0;
+    for ( qint64 busy: busyNsecsPerWorker ) {
+        total += busy;
+        maximum = qMax( maximum, busy );
+    }
+
+    if ( total == 0 ) {
+        return 1.0;
+    }
+
+    const qreal mean = qreal( total ) / busyNsecsPerWorker.size();
+    return maximum / mean;
+}
+
+QString ScanlineRenderScheduler::Statistics::toString() const
+{
+    return QStringLiteral( "Scanlines: %1 ms, %2 blocks of %3 on %4 threads, %5 steals, imbalance %6" )
+            .arg( elapsedNsecs / 1000000.0, 0, 'f', 2 )
+            .arg( blockCount )
+            .arg( blockHeight )
+            .arg( busyNsecsPerWorker.size() )
+            .arg( stealCount )
+            .arg( imbalance(), 0, 'f', 2 );
+}
+
+ScanlineRenderScheduler::ScanlineRenderScheduler( QThreadPool *threadPool ) :
+    d( new Private( threadPool ) )
+{
+}
+
+ScanlineRenderScheduler::~ScanlineRenderScheduler()
+{
+    waitForDone();
+    delete d;
+}
+
+void ScanlineRenderScheduler::start( Job *job, StackedTileLoader *tileLoader, int tileLevel, int yTop, int yBottom )
+{
+    Q_ASSERT( !d->m_running );
+
+    const int workerCount = qMax( 1, d->m_threadPool->maxThreadCount() );
+    const int rowCount = qMax( 0, yBottom - yTop );
+    const int blockHeight = d->chooseBlockHeight( rowCount, workerCount );
+    const int blockCount = ( rowCount + blockHeight - 1 ) / blockHeight;
+
+    d->m_job = job;
+    d->m_tileLoader = tileLoader;
+    d->m_tileLevel = tileLevel;
+    d->m_yTop = yTop;
+    d->m_yBottom = yBottom;
+
+    d->m_current = Statistics();
+    d->m_current.blockCount = blockCount;
+    d->m_current.blockHeight = blockHeight;
+    d->m_current.blocksPerWorker.fill( 0, workerCount );
+    d->m_current.busyNsecsPerWorker.fill( 0, workerCount );
+    d->m_stealsPerWorker.fill( 0, workerCount );
+
+    while ( d->m_queues.size() < workerCount ) {
+        d->m_queues.append( new BlockQueue );
+    }
+    while ( d->m_queues.size() > workerCount ) {
+        delete d->m_queues.takeLast();
+    }
+
+    // Hand out contiguous runs of blocks first, stealing only kicks in
+    // for the workers that are done early.
+    for ( int i = 0; i < workerCount; ++i ) {
+        const int begin = ( blockCount * i ) / workerCount;
+        const int end = ( blockCount * ( i + 1 ) ) / workerCount;
+        d->m_queues[i]->reset( begin, end );
+    }
+
+    d->m_running = true;
+    d->m_frameTimer.start();
+
+    for ( int i = 0; i < workerCount; ++i ) {
+        d->m_threadPool->start( new Private::Worker( d, i ) );
+    }
+}
+
+void ScanlineRenderScheduler::waitForDone()
+{
+    if ( !d->m_running ) {
+        return;
+    }
+
+    d->m_threadPool->waitForDone();
+    d->m_running = false;
+
+    d->m_current.elapsedNsecs = d->m_frameTimer.nsecsElapsed();
+    for ( int steals: d->m_stealsPerWorker ) {
+        d->m_current.stealCount += steals;
+    }
+    d->m_statistics = d->m_current;
+    d->m_job = 0;
+}
+
+void ScanlineRenderScheduler::setBlockHeight( int blockHeight )
+{
+    d->m_fixedBlockHeight = qMax( 0, blockHeight );
+}
+
+int ScanlineRenderScheduler::blockHeight() const
+{
+    return d->m_fixedBlockHeight;
+}
+
+const ScanlineRenderScheduler::Statistics &ScanlineRenderScheduler::statistics() const
+{
+    return d->m_statistics;
+}
+
+}
@@ -0,0 +1,124 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SCANLINERENDERSCHEDULER_H
+#define MARBLE_SCANLINERENDERSCHEDULER_H
+
+#include <QVector>
+#include <QString>
+#include <QtGlobal>
+
+#include "marble_export.h"
+
+class QThreadPool;
+
+namespace Marble
+{
+
+class ScanlineTextureMapperContext;
+class StackedTileLoader;
+
+/**
+ * @short Distributes the scanlines of a canvas over a pool of workers.
+ *
+ * The canvas range [yTop, yBottom) is cut into small blocks of scanlines.
+ * Each worker starts with a contiguous run of blocks, so neighbouring
+ * scanlines (and thus the same tiles) stay on the same core.  Once a worker
+ * runs out of blocks it steals the upper half of the remaining run of the
+ * most loaded worker.  This keeps all cores busy until the end of the frame
+ * even though the rows near the poles or in space are much cheaper than the
+ * rows in the middle of the globe.
+ *
+ * Every worker keeps a single ScanlineTextureMapperContext for the whole
+ * frame, so the tile lookups cached in the context survive block borders.
+ */
+class MARBLE_EXPORT ScanlineRenderScheduler
+{
+public:
+    /**
+     * A job renders a block of scanlines using the context of the calling worker.
+     */
+    class MARBLE_EXPORT Job
+    {
+    public:
+        virtual ~Job();
+
+        virtual void renderBlock( ScanlineTextureMapperContext &context, int yTop, int yBottom ) = 0;
+    };
+
+    /**
+     * Load balance figures of the last rendered frame.
+     */
+    struct Statistics
+    {
+        Statistics();
+
+        /// number of scanline blocks of the frame
+        int blockCount;
+
+        /// number of scanlines per block
+        int blockHeight;
+
+        /// number of times an idle worker stole blocks from another one
+        int stealCount;
+
+        /// wall clock time of the frame in nanoseconds
+        qint64 elapsedNsecs;
+
+        /// number of blocks rendered by each worker
+        QVector<int> blocksPerWorker;
+
+        /// time in nanoseconds each worker spent rendering blocks
+        QVector<qint64> busyNsecsPerWorker;
+
+        /**
+         * Returns the ratio of the busiest worker's time to the mean time of
+         * all workers.  A value of 1.0 means perfect balance.
+         */
+        qreal imbalance() const;
+
+        QString toString() const;
+    };
+
+    explicit ScanlineRenderScheduler( QThreadPool *threadPool );
+    ~ScanlineRenderScheduler();
+
+    /**
+     * Starts rendering the scanlines [yTop, yBottom) with @p job.
+     * The call returns immediately; use waitForDone() before touching
+     * the canvas or deleting the job.  The block borders are always
+     * located at an even distance from @p yTop, so interlaced rendering
+     * which duplicates every second line keeps working.
+     */
+    void start( Job *job, StackedTileLoader *tileLoader, int tileLevel, int yTop, int yBottom );
+
+    void waitForDone();
+
+    /**
+     * Overrides the automatically chosen block height.  Pass 0 to
+     * return to the automatic choice.
+     */
+    void setBlockHeight( int blockHeight );
+
+    int blockHeight() const;
+
+    /**
+     * Returns the statistics of the last completed frame.
+     */
+    const Statistics &statistics() const;
+
+private:
+    Q_DISABLE_COPY( ScanlineRenderScheduler )
+
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif
@@ -168,11 +168,24 @@ void ScanlineTextureMapperContext::pixelValueApproxF( const qreal lon, const qre
 
         const bool alwaysCheckTileRange =
                 isOutOfTileRangeF( itLon, itLat, itStepLon, itStepLat, n );
-        
+
+        if ( !alwaysCheckTileRange ) {
+            // The whole run stays on the current tile, so sample all of its
+            // pixels in one go and let the tile use its vectorized path.
+            Q_ASSERT( n <= MaxInterpolationStep );
+            qreal posXs[MaxInterpolationStep];
+            qreal posYs[MaxInterpolationStep];
+            for ( int j = 1; j < n; ++j ) {
+                posXs[j - 1] = itLon + itStepLon * j;
+                posYs[j - 1] = itLat + itStepLat * j;
+            }
+            m_tile->pixelsF( posXs, posYs, n - 1, scanLine );
+        }
+
         for ( int j=1; j < n; ++j ) {
             qreal posX = itLon + itStepLon * j;
             qreal posY = itLat + itStepLat * j;
-            if ( alwaysCheckTileRange )
+            if ( alwaysCheckTileRange ) {
                 if ( posX >= tileWidth
                     || posX < 0.0
                     || posY >= tileHeight
@@ -186,7 +199,8 @@ void ScanlineTextureMapperContext::pixelValueApproxF( const qreal lon, const qre
                     oldPosX = -1;
                 }
 
-            *scanLine = m_tile->pixelF( posX, posY );
+                *scanLine = m_tile->pixelF( posX, posY );
+            }
 
             // Just perform bilinear interpolation if there's a color change compared to the 
             // last pixel that was evaluated. This speeds up things greatly for maps like OSM
@@ -404,7 +418,7 @@ int ScanlineTextureMapperContext::interpolationStep( const ViewportParams *viewp
 
     int nBest = 2;
     int nEvalMin = width - 1;
-    for ( int it = 1; it < 48; ++it ) {
+    for ( int it = 1; it < MaxInterpolationStep; ++it ) {
         int nEval = ( width - 1 ) / it + ( width - 1 ) % it;
         if ( nEval < nEvalMin ) {
             nEvalMin = nEval;
@@ -42,6 +42,9 @@ public:
     void pixelValueApprox( const qreal lon, const qreal lat,
                            QRgb *scanLine, const int n );
 
+    /// upper bound (exclusive) of interpolationStep()
+    enum { MaxInterpolationStep = 48 };
+
     static int interpolationStep( const ViewportParams *viewport, MapQuality mapQuality );
 
     static QImage::Format optimalCanvasImageFormat( const ViewportParams *viewport );
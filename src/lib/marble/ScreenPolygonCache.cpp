@@ -0,0 +1,136 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ScreenPolygonCache.h"
+
+#include "AbstractProjection.h"
+#include "ViewportParams.h"
+
+#include <QPolygonF>
+
+namespace Marble
+{
+
+// Cylindrical projections repeat the map horizontally if it does not span
+// the whole viewport.  The number of repeats changes while panning, so
+// polygons are only moved along as long as there are none.
+static bool repeatsX( const ViewportParams *viewport )
+{
+    qreal xWest, xEast, y;
+    viewport->screenCoordinates( -M_PI, 0.0, xWest, y );
+    viewport->screenCoordinates( +M_PI, 0.0, xEast, y );
+    return xWest > 0 || xEast < viewport->width() - 1;
+}
+
+ScreenPolygonCache::ScreenPolygonCache() :
+    m_valid( false ),
+    m_repeatsX( true ),
+    m_projection( Spherical ),
+    m_radius( 0 )
+{
+}
+
+ScreenPolygonCache::~ScreenPolygonCache()
+{
+    qDeleteAll( m_polygons );
+    qDeleteAll( m_outlines );
+}
+
+bool ScreenPolygonCache::update( const ViewportParams *viewport, bool *moved )
+{
+    if ( moved ) {
+        *moved = false;
+    }
+
+    if ( m_valid
+         && m_projection == viewport->projection()
+         && m_radius == viewport->radius()
+         && m_size == viewport->size() ) {
+        if ( m_planetAxis == viewport->planetAxis() ) {
+            return true;
+        }
+
+        // Panning a cylindrical projection is a translation on screen.  Polygons
+        // of geometries outside of the previous view are missing though.
+        if ( viewport->currentProjection()->surfaceType() == AbstractProjection::Cylindrical
+             && !m_repeatsX && !repeatsX( viewport )
+             && ( !m_polygons.isEmpty() || !m_outlines.isEmpty() ) ) {
+            qreal x, y;
+            viewport->screenCoordinates( 0.0, 0.0, x, y );
+            translate( x - m_origin.x(), y - m_origin.y() );
+            m_origin = QPointF( x, y );
+            m_planetAxis = viewport->planetAxis();
+            if ( moved ) {
+                *moved = true;
+            }
+            return true;
+        }
+    }
+
+    clear();
+    return false;
+}
+
+void ScreenPolygonCache::setViewport( const ViewportParams *viewport )
+{
+    m_valid = true;
+    m_projection = viewport->projection();
+    m_radius = viewport->radius();
+    m_size = viewport->size();
+    m_planetAxis = viewport->planetAxis();
+
+    if ( viewport->currentProjection()->surfaceType() == AbstractProjection::Cylindrical ) {
+        m_repeatsX = repeatsX( viewport );
+        qreal x, y;
+        viewport->screenCoordinates( 0.0, 0.0, x, y );
+        m_origin = QPointF( x, y );
+    } else {
+        m_repeatsX = true;
+    }
+}
+
+void ScreenPolygonCache::clear()
+{
+    qDeleteAll( m_polygons );
+    m_polygons.clear();
+    qDeleteAll( m_outlines );
+    m_outlines.clear();
+    m_valid = false;
+}
+
+QVector<QPolygonF *> &ScreenPolygonCache::polygons()
+{
+    return m_polygons;
+}
+
+const QVector<QPolygonF *> &ScreenPolygonCache::polygons() const
+{
+    return m_polygons;
+}
+
+QVector<QPolygonF *> &ScreenPolygonCache::outlines()
+{
+    return m_outlines;
+}
+
+const QVector<QPolygonF *> &ScreenPolygonCache::outlines() const
+{
+    return m_outlines;
+}
+
+void ScreenPolygonCache::translate( qreal dx, qreal dy )
+{
+    for ( QPolygonF *polygon: m_polygons ) {
+        polygon->translate( dx, dy );
+    }
+    for ( QPolygonF *polygon: m_outlines ) {
+        polygon->translate( dx, dy );
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SCREENPOLYGONCACHE_H
+#define MARBLE_SCREENPOLYGONCACHE_H
+
+#include "MarbleGlobal.h"
+#include "Quaternion.h"
+#include "marble_export.h"
+
+#include <QPointF>
+#include <QSize>
+#include <QVector>
+
+class QPolygonF;
+
+namespace Marble
+{
+
+class ViewportParams;
+
+/**
+ * @short Keeps the screen polygons of a geometry from one frame to the next.
+ *
+ * Projecting a geometry into screen polygons is the most expensive part of
+ * painting it.  Graphics items keep their projected polygons here and only
+ * project again once the viewport changed in a way the polygons cannot
+ * follow: Repaints of an unchanged viewport reuse them as they are, and
+ * pans of a cylindrical projection just move them along.
+ *
+ * The polygons are owned by the cache.
+ */
+class MARBLE_EXPORT ScreenPolygonCache
+{
+public:
+    ScreenPolygonCache();
+    ~ScreenPolygonCache();
+
+    /**
+     * Brings the polygons up to date with @p viewport if possible.
+     *
+     * Returns false if the polygons have to be projected again.  They are
+     * cleared in that case; fill them and call setViewport() afterwards.
+     * If the polygons were moved, @p moved is set to true.
+     */
+    bool update( const ViewportParams *viewport, bool *moved = 0 );
+
+    /**
+     * Records @p viewport as the one the polygons were projected for.
+     */
+    void setViewport( const ViewportParams *viewport );
+
+    /**
+     * Deletes the polygons and forgets about the viewport.
+     */
+    void clear();
+
+    QVector<QPolygonF *> &polygons();
+    const QVector<QPolygonF *> &polygons() const;
+
+    /**
+     * Polygons only drawn as lines, like the outlines of polygons with
+     * holes whose fill polygons are in polygons().
+     */
+    QVector<QPolygonF *> &outlines();
+    const QVector<QPolygonF *> &outlines() const;
+
+private:
+    Q_DISABLE_COPY( ScreenPolygonCache )
+
+    void translate( qreal dx, qreal dy );
+
+    QVector<QPolygonF *> m_polygons;
+    QVector<QPolygonF *> m_outlines;
+
+    bool m_valid;
+    bool m_repeatsX;
+    Projection m_projection;
+    int m_radius;
+    QSize m_size;
+    Quaternion m_planetAxis;
+    // Screen position of the null meridian on the equator
+    QPointF m_origin;
+};
+
+}
+
+#endif
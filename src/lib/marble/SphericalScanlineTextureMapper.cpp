@@ -15,13 +15,13 @@
 #include <cmath>
 
 #include <qmath.h>
-#include <QRunnable>
 
 #include "MarbleGlobal.h"
 #include "GeoPainter.h"
 #include "GeoDataPolygon.h"
 #include "MarbleDebug.h"
 #include "Quaternion.h"
+#include "ScanlineRenderScheduler.h"
 #include "ScanlineTextureMapperContext.h"
 #include "StackedTileLoader.h"
 #include "StackedTile.h"
@@ -32,31 +32,23 @@
 
 using namespace Marble;
 
-class SphericalScanlineTextureMapper::RenderJob : public QRunnable
+class SphericalScanlineTextureMapper::RenderJob : public ScanlineRenderScheduler::Job
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality );
 
-    void run() override;
+    void renderBlock( ScanlineTextureMapperContext &context, int yTop, int yBottom ) override;
 
 private:
-    StackedTileLoader *const m_tileLoader;
-    const int m_tileLevel;
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    int const m_yTop;
-    int const m_yBottom;
 };
 
-SphericalScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
-    : m_tileLoader( tileLoader ),
-      m_tileLevel( tileLevel ),
-      m_canvasImage( canvasImage ),
+SphericalScanlineTextureMapper::RenderJob::RenderJob( QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality )
+    : m_canvasImage( canvasImage ),
       m_viewport( viewport ),
-      m_mapQuality( mapQuality ),
-      m_yTop( yTop ),
-      m_yBottom( yBottom )
+      m_mapQuality( mapQuality )
 {
 }
 
@@ -65,6 +57,7 @@ SphericalScanlineTextureMapper::SphericalScanlineTextureMapper( StackedTileLoade
     , m_tileLoader( tileLoader )
     , m_radius( 0 )
     , m_threadPool()
+    , m_scheduler( &m_threadPool )
 {
 }
 
@@ -125,21 +118,14 @@ void SphericalScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     const int yBottom = ( yTop == 0 ) ? imageHeight - skip
                                       : yTop + radius + radius - skip;
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = qCeil(qreal( yBottom - yTop ) / qreal(numThreads));
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yTop +  i      * yStep;
-        const int yEnd   = qMin(yBottom, yTop + (i + 1) * yStep);
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
-
-    m_threadPool.waitForDone();
+    RenderJob job( &m_canvasImage, viewport, mapQuality );
+    m_scheduler.start( &job, m_tileLoader, tileZoomLevel, yTop, yBottom );
+    m_scheduler.waitForDone();
 
     m_tileLoader->cleanupTilehash();
 }
 
-void SphericalScanlineTextureMapper::RenderJob::run()
+void SphericalScanlineTextureMapper::RenderJob::renderBlock( ScanlineTextureMapperContext &context, int yTop, int yBottom )
 {
     const int imageHeight = m_canvasImage->height();
     const int imageWidth  = m_canvasImage->width();
@@ -166,12 +152,11 @@ void SphericalScanlineTextureMapper::RenderJob::run()
 
     // initialize needed variables that are modified during texture mapping:
 
-    ScanlineTextureMapperContext context( m_tileLoader, m_tileLevel );
     qreal  lon = 0.0;
     qreal  lat = 0.0;
 
     // Scanline based algorithm to texture map a sphere
-    for ( int y = m_yTop; y < m_yBottom ; ++y ) {
+    for ( int y = yTop; y < yBottom ; ++y ) {
 
         // Evaluate coordinates for the 3D position vector of the current pixel
         const qreal qy = inverseRadius * (qreal)( imageHeight / 2 - y );
@@ -286,7 +271,7 @@ void SphericalScanlineTextureMapper::RenderJob::run()
         }
 
         // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yBottom ) { 
+        if ( interlaced && y + 1 < yBottom ) { 
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
@@ -297,3 +282,8 @@ void SphericalScanlineTextureMapper::RenderJob::run()
         }
     }
 }
+
+QString SphericalScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.statistics().toString();
+}
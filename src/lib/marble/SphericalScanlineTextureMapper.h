@@ -14,6 +14,7 @@
 
 
 #include "TextureMapperInterface.h"
+#include "ScanlineRenderScheduler.h"
 
 #include "MarbleGlobal.h"
 
@@ -47,6 +48,8 @@ class SphericalScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer ) override;
 
+    QString runtimeTrace() const override;
+
  private:
     void mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
 
@@ -56,6 +59,7 @@ class SphericalScanlineTextureMapper : public TextureMapperInterface
     int m_radius;
     QImage m_canvasImage;
     QThreadPool m_threadPool;
+    ScanlineRenderScheduler m_scheduler;
 };
 
 }
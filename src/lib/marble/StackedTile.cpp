@@ -13,6 +13,8 @@
 
 #include "StackedTile.h"
 
+#include "BilinearInterpolation_p.h"
+#include "BilinearSampler.h"
 #include "MarbleDebug.h"
 #include "TextureTile.h"
 
@@ -99,117 +101,8 @@ uint StackedTile::pixel( int x, int y ) const
 
 uint StackedTile::pixelF( qreal x, qreal y, const QRgb& topLeftValue ) const
 {
-    // Bilinear interpolation to determine the color of a subpixel 
-
-    int iX = (int)(x);
-    int iY = (int)(y);
-
-    qreal fY = y - iY;
-
-    // Interpolation in y-direction
-    if ( ( iY + 1 ) < m_resultImage.height() ) {
-
-        QRgb bottomLeftValue  =  pixel( iX, iY + 1 );
-// #define CHEAPHIGH
-#ifdef CHEAPHIGH
-        QRgb leftValue;
-        if ( fY < 0.33 )
-            leftValue = topLeftValue;
-        else if ( fY < 0.66 ) 
-            leftValue = (((bottomLeftValue ^ topLeftValue) & 0xfefefefeUL) >> 1)
-                            + (bottomLeftValue & topLeftValue);
-        else 
-            leftValue = bottomLeftValue;
-#else
-        // blending the color values of the top left and bottom left point
-        qreal ml_red   = ( 1.0 - fY ) * qRed  ( topLeftValue  ) + fY * qRed  ( bottomLeftValue  );
-        qreal ml_green = ( 1.0 - fY ) * qGreen( topLeftValue  ) + fY * qGreen( bottomLeftValue  );
-        qreal ml_blue  = ( 1.0 - fY ) * qBlue ( topLeftValue  ) + fY * qBlue ( bottomLeftValue  );
-#endif
-        // Interpolation in x-direction
-        if ( iX + 1 < m_resultImage.width() ) {
-
-            qreal fX = x - iX;
-
-            QRgb topRightValue    =  pixel( iX + 1, iY );
-            QRgb bottomRightValue =  pixel( iX + 1, iY + 1 );
-
-#ifdef CHEAPHIGH
-            QRgb rightValue;
-            if ( fY < 0.33 )
-                rightValue = topRightValue;
-            else if ( fY < 0.66 )
-                rightValue = (((bottomRightValue ^ topRightValue) & 0xfefefefeUL) >> 1)
-                                + (bottomRightValue & topRightValue);
-            else
-                rightValue = bottomRightValue;
-
-            QRgb averageValue;
-            if ( fX < 0.33 )
-                averageValue = leftValue;
-            else if ( fX < 0.66 )
-                averageValue = (((leftValue ^ rightValue) & 0xfefefefeUL) >> 1)
-                                + (leftValue & rightValue);
-            else
-                averageValue = rightValue;
-
-            return averageValue;
-#else
-            // blending the color values of the top right and bottom right point
-            qreal mr_red   = ( 1.0 - fY ) * qRed  ( topRightValue ) + fY * qRed  ( bottomRightValue );
-            qreal mr_green = ( 1.0 - fY ) * qGreen( topRightValue ) + fY * qGreen( bottomRightValue );
-            qreal mr_blue  = ( 1.0 - fY ) * qBlue ( topRightValue ) + fY * qBlue ( bottomRightValue );
-    
-            // blending the color values of the resulting middle left 
-            // and middle right points
-            int mm_red   = (int)( ( 1.0 - fX ) * ml_red   + fX * mr_red   );
-            int mm_green = (int)( ( 1.0 - fX ) * ml_green + fX * mr_green );
-            int mm_blue  = (int)( ( 1.0 - fX ) * ml_blue  + fX * mr_blue  );
-    
-            return qRgb( mm_red, mm_green, mm_blue );
-#endif
-        }
-        else {
-#ifdef CHEAPHIGH
-            return leftValue;
-#else
-            return qRgb( ml_red, ml_green, ml_blue );
-#endif
-        }
-    }
-    else {
-        // Interpolation in x-direction
-        if ( iX + 1 < m_resultImage.width() ) {
-
-            qreal fX = x - iX;
-
-            if ( fX == 0.0 ) 
-                return topLeftValue;
-
-            QRgb topRightValue    =  pixel( iX + 1, iY );
-#ifdef CHEAPHIGH
-            QRgb topValue;
-            if ( fX < 0.33 )
-                topValue = topLeftValue;
-            else if ( fX < 0.66 )
-                topValue = (((topLeftValue ^ topRightValue) & 0xfefefefeUL) >> 1)
-                                + (topLeftValue & topRightValue);
-            else
-                topValue = topRightValue;
-
-            return topValue;
-#else
-            // blending the color values of the top left and top right point
-            int tm_red   = (int)( ( 1.0 - fX ) * qRed  ( topLeftValue ) + fX * qRed  ( topRightValue ) );
-            int tm_green = (int)( ( 1.0 - fX ) * qGreen( topLeftValue ) + fX * qGreen( topRightValue ) );
-            int tm_blue  = (int)( ( 1.0 - fX ) * qBlue ( topLeftValue ) + fX * qBlue ( topRightValue ) );
-
-            return qRgb( tm_red, tm_green, tm_blue );
-#endif
-        }
-    }
-
-    return topLeftValue;
+    // Bilinear interpolation to determine the color of a subpixel
+    return bilinearPixel( *this, m_resultImage.width(), m_resultImage.height(), x, y, topLeftValue );
 }
 
 int StackedTile::calcByteCount( const QImage &resultImage, const QVector<QSharedPointer<TextureTile> > &tiles )
@@ -244,6 +137,18 @@ uint StackedTile::pixelF( qreal x, qreal y ) const
     return pixelF( x, y, topLeftValue );
 }
 
+void StackedTile::pixelsF( const qreal *x, const qreal *y, int count, QRgb *result ) const
+{
+    if ( m_depth == 32 ) {
+        BilinearSampler::sample( m_resultImage, x, y, count, result );
+        return;
+    }
+
+    for ( int i = 0; i < count; ++i ) {
+        result[i] = pixelF( x[i], y[i] );
+    }
+}
+
 int StackedTile::depth() const
 {
     return m_depth;
@@ -19,6 +19,7 @@
 #include <QImage>
 
 #include "Tile.h"
+#include "marble_export.h"
 
 namespace Marble
 {
@@ -52,7 +53,7 @@ class TextureTile;
     the very same projection.
 */
 
-class StackedTile : public Tile
+class MARBLE_EXPORT StackedTile : public Tile
 {
  public:
     explicit StackedTile( TileId const &id, QImage const &resultImage, QVector<QSharedPointer<TextureTile> > const &tiles );
@@ -98,6 +99,14 @@ class StackedTile : public Tile
     // This method passes the top left pixel (if known already) for better performance
     uint pixelF( qreal x, qreal y, const QRgb& pixel ) const; 
 
+/*!
+    \brief Returns the color values of the result tile at several floating point positions.
+
+    Writes the same values as calling pixelF( x[i], y[i] ) for each of the
+    @p count positions, but uses a vectorized implementation for 32 bit images.
+*/
+    void pixelsF( const qreal *x, const qreal *y, int count, QRgb *result ) const;
+
  private:
     Q_DISABLE_COPY( StackedTile )
 
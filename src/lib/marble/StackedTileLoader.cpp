@@ -33,8 +33,14 @@
 
 #include <QCache>
 #include <QHash>
+#include <QMutex>
 #include <QReadWriteLock>
 #include <QImage>
+#include <QRect>
+#include <QRunnable>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
 
 
 namespace Marble
@@ -43,26 +49,282 @@ namespace Marble
 class StackedTileLoaderPrivate
 {
 public:
-    explicit StackedTileLoaderPrivate( MergedLayerDecorator *mergedLayerDecorator )
-        : m_layerDecorator( mergedLayerDecorator )
+    class LoadJob;
+
+    struct LoadedTile
+    {
+        TileId id;
+        StackedTile *tile;
+        int generation;
+    };
+
+    explicit StackedTileLoaderPrivate( MergedLayerDecorator *mergedLayerDecorator, StackedTileLoader *parent )
+        : q( parent ),
+          m_layerDecorator( mergedLayerDecorator ),
+          m_asynchronous( false ),
+          m_generation( 0 ),
+          m_deliveryScheduled( false ),
+          m_lastVisibleLevel( -1 )
     {
         m_tileCache.setMaxCost( 20000 * 1024 ); // Cache size measured in bytes
+
+        // Leave most cores to the texture mappers
+        m_threadPool.setMaxThreadCount( qBound( 1, QThread::idealThreadCount() / 2, 4 ) );
     }
 
+    StackedTile *createPlaceholder( const TileId &stackedTileId );
+
+    void queueLoad( const TileId &stackedTileId );
+
+    void prefetchAhead();
+
+    void deliverLoadedTiles();
+
+    void cancelPendingLoads();
+
+    StackedTileLoader *const q;
     MergedLayerDecorator *const m_layerDecorator;
     QHash <TileId, StackedTile*>  m_tilesOnDisplay;
     QCache <TileId, StackedTile>  m_tileCache;
     QReadWriteLock m_cacheLock;
+
+    bool m_asynchronous;
+    QThreadPool m_threadPool;
+    int m_generation;
+
+    // tiles on display which are upscaled parts of an ancestor tile
+    QSet<TileId> m_placeholders;
+    // tiles queued for or being loaded on the thread pool
+    QSet<TileId> m_pendingTiles;
+    // pending tiles which got updated while being loaded
+    QSet<TileId> m_outdatedTiles;
+
+    QMutex m_loadedTilesMutex;
+    QList<LoadedTile> m_loadedTiles;
+    bool m_deliveryScheduled;
+
+    int m_lastVisibleLevel;
+    QRect m_lastVisibleRect;
+};
+
+class StackedTileLoaderPrivate::LoadJob : public QRunnable
+{
+public:
+    LoadJob( StackedTileLoaderPrivate *loader, const TileId &stackedTileId, int generation )
+        : m_loader( loader ),
+          m_stackedTileId( stackedTileId ),
+          m_generation( generation )
+    {}
+
+    void run() override
+    {
+        StackedTile *const tile = m_loader->m_layerDecorator->loadTile( m_stackedTileId );
+        Q_ASSERT( tile );
+
+        QMutexLocker locker( &m_loader->m_loadedTilesMutex );
+        const LoadedTile loadedTile = { m_stackedTileId, tile, m_generation };
+        m_loader->m_loadedTiles.append( loadedTile );
+
+        // hand all tiles finished until the event loop runs over at once
+        if ( !m_loader->m_deliveryScheduled ) {
+            m_loader->m_deliveryScheduled = true;
+            QMetaObject::invokeMethod( m_loader->q, "deliverLoadedTiles", Qt::QueuedConnection );
+        }
+    }
+
+private:
+    StackedTileLoaderPrivate *const m_loader;
+    const TileId m_stackedTileId;
+    const int m_generation;
 };
 
+StackedTile *StackedTileLoaderPrivate::createPlaceholder( const TileId &stackedTileId )
+{
+    // Look for the closest ancestor we have in memory and cut the part
+    // covering the requested tile out of it.
+    for ( int levelUp = 1; levelUp <= stackedTileId.zoomLevel(); ++levelUp ) {
+        const TileId ancestorId( 0, stackedTileId.zoomLevel() - levelUp,
+                                 stackedTileId.x() >> levelUp, stackedTileId.y() >> levelUp );
+
+        const StackedTile *ancestor = m_tilesOnDisplay.value( ancestorId, 0 );
+        if ( !ancestor ) {
+            ancestor = m_tileCache.object( ancestorId );
+        }
+        if ( !ancestor || m_placeholders.contains( ancestorId ) ) {
+            continue;
+        }
+
+        const QImage *const ancestorImage = ancestor->resultImage();
+        const int width = ancestorImage->width() >> levelUp;
+        const int height = ancestorImage->height() >> levelUp;
+        if ( width < 1 || height < 1 ) {
+            return 0;
+        }
+
+        const int mask = ( 1 << levelUp ) - 1;
+        const QRect rect( ( stackedTileId.x() & mask ) * width, ( stackedTileId.y() & mask ) * height,
+                          width, height );
+        const QImage image = ancestorImage->copy( rect ).scaled( ancestorImage->size(),
+                                                                 Qt::IgnoreAspectRatio,
+                                                                 Qt::FastTransformation );
+
+        return new StackedTile( stackedTileId, image, ancestor->tiles() );
+    }
+
+    return 0;
+}
+
+void StackedTileLoaderPrivate::queueLoad( const TileId &stackedTileId )
+{
+    if ( m_pendingTiles.contains( stackedTileId ) ) {
+        return;
+    }
+
+    m_pendingTiles.insert( stackedTileId );
+    m_threadPool.start( new LoadJob( this, stackedTileId, m_generation ) );
+}
+
+void StackedTileLoaderPrivate::prefetchAhead()
+{
+    // Bounding rect of the tiles used during the last frame at the
+    // highest zoom level.
+    int level = -1;
+    QRect visibleRect;
+    QHash<TileId, StackedTile*>::const_iterator it = m_tilesOnDisplay.constBegin();
+    QHash<TileId, StackedTile*>::const_iterator const end = m_tilesOnDisplay.constEnd();
+    for (; it != end; ++it ) {
+        const TileId &id = it.key();
+        if ( id.zoomLevel() > level ) {
+            level = id.zoomLevel();
+            visibleRect = QRect();
+        }
+        if ( id.zoomLevel() == level ) {
+            visibleRect |= QRect( id.x(), id.y(), 1, 1 );
+        }
+    }
+
+    if ( level != m_lastVisibleLevel || visibleRect == m_lastVisibleRect ) {
+        m_lastVisibleLevel = level;
+        m_lastVisibleRect = visibleRect;
+        return;
+    }
+
+    const QPoint shift = visibleRect.center() - m_lastVisibleRect.center();
+    m_lastVisibleLevel = level;
+    m_lastVisibleRect = visibleRect;
+
+    const int columns = m_layerDecorator->tileColumnCount( level );
+    const int rows = m_layerDecorator->tileRowCount( level );
+
+    QVector<TileId> ring;
+
+    // A rect spanning (almost) all columns is most likely wrapped
+    // around the date line, so there is nothing to the left or right.
+    if ( shift.x() != 0 && visibleRect.width() < columns - 1 ) {
+        const int x = shift.x() > 0 ? visibleRect.right() + 1 : visibleRect.left() - 1;
+        for ( int y = qMax( 0, visibleRect.top() - 1 ); y <= qMin( rows - 1, visibleRect.bottom() + 1 ); ++y ) {
+            ring.append( TileId( 0, level, ( x + columns ) % columns, y ) );
+        }
+    }
+
+    if ( shift.y() != 0 ) {
+        const int y = shift.y() > 0 ? visibleRect.bottom() + 1 : visibleRect.top() - 1;
+        if ( y >= 0 && y < rows ) {
+            for ( int x = visibleRect.left() - 1; x <= visibleRect.right() + 1; ++x ) {
+                ring.append( TileId( 0, level, ( x + columns ) % columns, y ) );
+            }
+        }
+    }
+
+    for ( const TileId &id: ring ) {
+        if ( !m_tilesOnDisplay.contains( id ) && !m_tileCache.contains( id ) ) {
+            queueLoad( id );
+        }
+    }
+}
+
+void StackedTileLoaderPrivate::deliverLoadedTiles()
+{
+    QList<LoadedTile> loadedTiles;
+    {
+        QMutexLocker locker( &m_loadedTilesMutex );
+        loadedTiles.swap( m_loadedTiles );
+        m_deliveryScheduled = false;
+    }
+
+    bool replacedPlaceholder = false;
+
+    for ( const LoadedTile &loadedTile: loadedTiles ) {
+        const TileId &id = loadedTile.id;
+        StackedTile *tile = loadedTile.tile;
+
+        if ( loadedTile.generation != m_generation ) {
+            // finished after clear(), the layers may have changed since
+            delete tile;
+            continue;
+        }
+
+        m_pendingTiles.remove( id );
+
+        if ( m_outdatedTiles.remove( id ) ) {
+            // a newer image arrived while the tile was loading
+            delete tile;
+            queueLoad( id );
+            continue;
+        }
+
+        StackedTile *const displayedTile = m_tilesOnDisplay.value( id, 0 );
+        if ( displayedTile ) {
+            if ( !m_placeholders.remove( id ) ) {
+                // loaded synchronously in the meantime
+                delete tile;
+                continue;
+            }
+
+            tile->setUsed( displayedTile->used() );
+            m_tilesOnDisplay[ id ] = tile;
+            delete displayedTile;
+
+            replacedPlaceholder = true;
+            emit q->tileLoaded( id );
+        } else if ( !m_tileCache.contains( id ) ) {
+            // prefetched tile
+            m_tileCache.insert( id, tile, tile->byteCount() );
+        } else {
+            delete tile;
+        }
+    }
+
+    if ( replacedPlaceholder ) {
+        emit q->repaintNeeded();
+    }
+}
+
+void StackedTileLoaderPrivate::cancelPendingLoads()
+{
+    ++m_generation;
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+
+    QMutexLocker locker( &m_loadedTilesMutex );
+    for ( const LoadedTile &loadedTile: m_loadedTiles ) {
+        delete loadedTile.tile;
+    }
+    m_loadedTiles.clear();
+
+    m_pendingTiles.clear();
+    m_outdatedTiles.clear();
+}
+
 StackedTileLoader::StackedTileLoader( MergedLayerDecorator *mergedLayerDecorator, QObject *parent )
     : QObject( parent ),
-      d( new StackedTileLoaderPrivate( mergedLayerDecorator ) )
+      d( new StackedTileLoaderPrivate( mergedLayerDecorator, this ) )
 {
 }
 
 StackedTileLoader::~StackedTileLoader()
 {
+    d->cancelPendingLoads();
     qDeleteAll( d->m_tilesOnDisplay );
     delete d;
 }
@@ -106,6 +368,13 @@ void StackedTileLoader::cleanupTilehash()
     while ( it.hasNext() ) {
         it.next();
         if ( !it.value()->used() ) {
+            if ( d->m_placeholders.remove( it.key() ) ) {
+                // placeholders are cheap to recreate and must not end up in the cache
+                delete it.value();
+                d->m_tilesOnDisplay.remove( it.key() );
+                continue;
+            }
+
             // If insert call result is false then the cache is too small to store the tile
             // but the item will get deleted nevertheless and the pointer we have
             // doesn't get set to zero (so don't delete it in this case or it will crash!)
@@ -113,6 +382,10 @@ void StackedTileLoader::cleanupTilehash()
             d->m_tilesOnDisplay.remove( it.key() );
         }
     }
+
+    if ( d->m_asynchronous ) {
+        d->prefetchAhead();
+    }
 }
 
 const StackedTile* StackedTileLoader::loadTile( TileId const & stackedTileId )
@@ -150,6 +423,21 @@ const StackedTile* StackedTileLoader::loadTile( TileId const & stackedTileId )
     // tile (valid) has not been found in hash or cache, so load it from disk
     // and place it in the hash from where it will get transferred to the cache
 
+    if ( d->m_asynchronous ) {
+        stackedTile = d->createPlaceholder( stackedTileId );
+        if ( stackedTile ) {
+            mDebug() << "load tile in the background:" << stackedTileId;
+
+            stackedTile->setUsed( true );
+            d->m_tilesOnDisplay[ stackedTileId ] = stackedTile;
+            d->m_placeholders.insert( stackedTileId );
+            d->queueLoad( stackedTileId );
+            d->m_cacheLock.unlock();
+
+            return stackedTile;
+        }
+    }
+
     mDebug() << "load tile from disk:" << stackedTileId;
 
     stackedTile = d->m_layerDecorator->loadTile( stackedTileId );
@@ -179,6 +467,16 @@ int StackedTileLoader::tileCount() const
     return d->m_tileCache.count() + d->m_tilesOnDisplay.count();
 }
 
+void StackedTileLoader::setAsynchronous( bool asynchronous )
+{
+    d->m_asynchronous = asynchronous;
+}
+
+bool StackedTileLoader::isAsynchronous() const
+{
+    return d->m_asynchronous;
+}
+
 void StackedTileLoader::setVolatileCacheLimit( quint64 kiloBytes )
 {
     mDebug() << QString("Setting tile cache to %1 kilobytes.").arg( kiloBytes );
@@ -189,6 +487,12 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
 {
     const TileId stackedTileId( 0, tileId.zoomLevel(), tileId.x(), tileId.y() );
 
+    if ( d->m_pendingTiles.contains( stackedTileId ) ) {
+        // the tile being loaded may still contain the old image, load it once more
+        d->m_outdatedTiles.insert( stackedTileId );
+        return;
+    }
+
     StackedTile * displayedTile = d->m_tilesOnDisplay.take( stackedTileId );
     if ( displayedTile ) {
         Q_ASSERT( !d->m_tileCache.contains( stackedTileId ) );
@@ -217,10 +521,18 @@ RenderState StackedTileLoader::renderState() const
     return renderState;
 }
 
+void StackedTileLoader::cancelPendingLoads()
+{
+    d->cancelPendingLoads();
+}
+
 void StackedTileLoader::clear()
 {
+    d->cancelPendingLoads();
+
     qDeleteAll( d->m_tilesOnDisplay );
     d->m_tilesOnDisplay.clear();
+    d->m_placeholders.clear();
     d->m_tileCache.clear(); // clear the tile cache in physical memory
 
     emit cleared();
@@ -56,7 +56,7 @@ class StackedTileLoaderPrivate;
  * @author Torsten Rahn <rahn@kde.org>
  **/
 
-class StackedTileLoader : public QObject
+class MARBLE_EXPORT StackedTileLoader : public QObject
 {
     Q_OBJECT
 
@@ -104,6 +104,23 @@ class StackedTileLoader : public QObject
          */
         quint64 volatileCacheLimit() const;
 
+        /**
+         * @brief Switches between synchronous and asynchronous tile loading.
+         *
+         * In synchronous mode (the default) loadTile() decodes and blends a
+         * missing tile on the calling render thread.  In asynchronous mode a
+         * missing tile is replaced by an upscaled part of the best cached
+         * ancestor tile, and the real tile is loaded on a pool of worker
+         * threads.  Once it is ready it replaces the placeholder, tileLoaded()
+         * and repaintNeeded() are emitted.  The tiles just outside the visible
+         * area in the current pan direction are prefetched into the cache.
+         *
+         * A tile without any cached ancestor is still loaded synchronously.
+         */
+        void setAsynchronous( bool asynchronous );
+
+        bool isAsynchronous() const;
+
         /**
          * @brief Reloads the tiles that are currently displayed.
          */
@@ -127,6 +144,15 @@ class StackedTileLoader : public QObject
          */
         void clear();
 
+        /**
+         * @brief Cancels the tiles queued for asynchronous loading and waits
+         * for the ones being loaded.
+         *
+         * The worker threads read the merged layer decorator, so this has to
+         * be called before the decorator is changed.
+         */
+        void cancelPendingLoads();
+
         /**
          */
         void updateTile(TileId const & tileId, QImage const &tileImage );
@@ -137,9 +163,17 @@ class StackedTileLoader : public QObject
         void tileLoaded( TileId const &tileId );
         void cleared();
 
+        /**
+         * Emitted in asynchronous mode once tiles shown as placeholders
+         * have been replaced by the real tiles.
+         */
+        void repaintNeeded();
+
     private:
         Q_DISABLE_COPY( StackedTileLoader )
 
+        Q_PRIVATE_SLOT( d, void deliverLoadedTiles() )
+
         friend class StackedTileLoaderPrivate;
         StackedTileLoaderPrivate* const d;
 };
@@ -15,13 +15,15 @@
 
 #include <QObject>
 
+#include "marble_export.h"
+
 class QByteArray;
 class QString;
 
 namespace Marble
 {
 
-class StoragePolicy : public QObject
+class MARBLE_EXPORT StoragePolicy : public QObject
 {
     Q_OBJECT
     
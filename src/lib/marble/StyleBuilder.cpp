@@ -15,6 +15,7 @@
 
 #include "MarbleDirs.h"
 #include "OsmPlacemarkData.h"
+#include "OsmStringTable.h"
 #include "OsmcSymbol.h"
 #include "GeoDataTypes.h"
 #include "GeoDataGeometry.h"
@@ -110,12 +111,18 @@ public:
      * @brief s_visualCategories contains osm tag mappings to GeoDataVisualCategories
      */
     static QHash<OsmTag, GeoDataPlacemark::GeoDataVisualCategory> s_visualCategories;
+
+    /**
+     * @brief s_visualCategoryIds contains the mappings of s_visualCategories by their OsmStringTable ids
+     */
+    static QHash<QPair<int, int>, GeoDataPlacemark::GeoDataVisualCategory> s_visualCategoryIds;
     static int s_defaultMinZoomLevels[GeoDataPlacemark::LastIndex];
     static bool s_defaultMinZoomLevelsInitialized;
     static QHash<GeoDataPlacemark::GeoDataVisualCategory, qint64> s_popularities;
 };
 
 QHash<StyleBuilder::OsmTag, GeoDataPlacemark::GeoDataVisualCategory> StyleBuilder::Private::s_visualCategories;
+QHash<QPair<int, int>, GeoDataPlacemark::GeoDataVisualCategory> StyleBuilder::Private::s_visualCategoryIds;
 int StyleBuilder::Private::s_defaultMinZoomLevels[GeoDataPlacemark::LastIndex];
 bool StyleBuilder::Private::s_defaultMinZoomLevelsInitialized = false;
 QHash<GeoDataPlacemark::GeoDataVisualCategory, qint64> StyleBuilder::Private::s_popularities;
@@ -308,13 +315,15 @@ GeoDataStyle::ConstPtr StyleBuilder::Private::createPlacemarkStyle(const StylePa
     OsmPlacemarkData const & osmData = placemark->osmData();
     auto const visualCategory = placemark->visualCategory();
     if (visualCategory == GeoDataPlacemark::Building) {
-        auto const tagMap = osmTagMapping();
-        auto const & osmData = placemark->osmData();
-        auto const buildingTag = QStringLiteral("building");
+        initializeOsmVisualCategories();
+        static const int buildingKey = OsmStringTable::intern(QStringLiteral("building"));
         for (auto iter = osmData.tagsBegin(), end = osmData.tagsEnd(); iter != end; ++iter) {
-            auto const osmTag = StyleBuilder::OsmTag(iter.key(), iter.value());
-            if (iter.key() != buildingTag && tagMap.contains(osmTag)) {
-                return m_buildingStyles.value(tagMap.value(osmTag), m_defaultStyle[visualCategory]);
+            if (iter.keyId() == buildingKey) {
+                continue;
+            }
+            auto const category = s_visualCategoryIds.constFind(qMakePair(iter.keyId(), iter.valueId()));
+            if (category != s_visualCategoryIds.constEnd()) {
+                return m_buildingStyles.value(category.value(), m_defaultStyle[visualCategory]);
             }
         }
     }
@@ -1687,6 +1696,11 @@ void StyleBuilder::Private::initializeOsmVisualCategories()
     for (const auto &tag: buildingTags()) {
         s_visualCategories[tag]                                 = GeoDataPlacemark::Building;
     }
+
+    for (auto iter = s_visualCategories.constBegin(), end = s_visualCategories.constEnd(); iter != end; ++iter) {
+        auto const tag = qMakePair(OsmStringTable::intern(iter.key().first), OsmStringTable::intern(iter.key().second));
+        s_visualCategoryIds[tag] = iter.value();
+    }
 }
 
 void StyleBuilder::Private::initializeMinimumZoomLevels()
@@ -2902,39 +2916,106 @@ QSet<StyleBuilder::OsmTag> StyleBuilder::buildingTags()
     return osmBuildingTags;
 }
 
+namespace {
+
+/// The OsmStringTable ids of the tags determineVisualCategory() looks at
+class VisualCategoryTags
+{
+public:
+    VisualCategoryTags();
+
+    static int id(const QString &string) { return OsmStringTable::intern(string); }
+
+    const int yes;
+    const int building;
+    const int historic;
+    const int castle;
+    const int castleType;
+    const int kremlin;
+    const int natural;
+    const int glacier;
+    const int glacierType;
+    const int shelf;
+    const int highway;
+    const int railway;
+    const int crossing;
+    const int levelCrossing;
+    const int crossingRef;
+    const int pisteType;
+    const int capital;
+    const int adminLevel;
+    const int nationalLevel;
+
+    QSet<int> ignoredKeys;
+    QSet<QPair<int, int> > ignoredTags;
+};
+
+VisualCategoryTags::VisualCategoryTags() :
+    yes(id(QStringLiteral("yes"))),
+    building(id(QStringLiteral("building"))),
+    historic(id(QStringLiteral("historic"))),
+    castle(id(QStringLiteral("castle"))),
+    castleType(id(QStringLiteral("castle_type"))),
+    kremlin(id(QStringLiteral("kremlin"))),
+    natural(id(QStringLiteral("natural"))),
+    glacier(id(QStringLiteral("glacier"))),
+    glacierType(id(QStringLiteral("glacier:type"))),
+    shelf(id(QStringLiteral("shelf"))),
+    highway(id(QStringLiteral("highway"))),
+    railway(id(QStringLiteral("railway"))),
+    crossing(id(QStringLiteral("crossing"))),
+    levelCrossing(id(QStringLiteral("level_crossing"))),
+    crossingRef(id(QStringLiteral("crossing_ref"))),
+    pisteType(id(QStringLiteral("piste:type"))),
+    capital(id(QStringLiteral("capital"))),
+    adminLevel(id(QStringLiteral("admin_level"))),
+    // National capitals have admin_level=2
+    // More at http://wiki.openstreetmap.org/wiki/Key:capital#Using_relations_for_capitals
+    nationalLevel(id(QStringLiteral("2")))
+{
+    ignoredKeys << id(QStringLiteral("area:highway"))           // Not supported yet
+                << id(QStringLiteral("closed:highway"))
+                << id(QStringLiteral("abandoned:highway"))
+                << id(QStringLiteral("abandoned:natural"))
+                << id(QStringLiteral("abandoned:building"))
+                << id(QStringLiteral("abandoned:leisure"))
+                << id(QStringLiteral("disused:highway"));
+
+    int const boundary = id(QStringLiteral("boundary"));
+    ignoredTags << qMakePair(boundary, id(QStringLiteral("protected_area")))  // Not relevant for the default map
+                << qMakePair(boundary, id(QStringLiteral("postal_code")))
+                << qMakePair(boundary, id(QStringLiteral("aerial_views")))    // Created by OSM editor(s) application for digitalization
+                << qMakePair(highway, id(QStringLiteral("razed")))
+                << qMakePair(id(QStringLiteral("piste:abandoned")), yes);
+}
+
+}
+
 GeoDataPlacemark::GeoDataVisualCategory StyleBuilder::determineVisualCategory(const OsmPlacemarkData &osmData)
 {
-    QString const yes(QStringLiteral("yes"));
-    if (osmData.containsTagKey(QStringLiteral("area:highway")) ||              // Not supported yet
-        osmData.containsTag(QStringLiteral("boundary"), QStringLiteral("protected_area")) ||   // Not relevant for the default map
-        osmData.containsTag(QStringLiteral("boundary"), QStringLiteral("postal_code")) ||
-        osmData.containsTag(QStringLiteral("boundary"), QStringLiteral("aerial_views")) ||     // Created by OSM editor(s) application for digitalization
-        osmData.containsTagKey(QStringLiteral("closed:highway")) ||
-        osmData.containsTagKey(QStringLiteral("abandoned:highway")) ||
-        osmData.containsTagKey(QStringLiteral("abandoned:natural")) ||
-        osmData.containsTagKey(QStringLiteral("abandoned:building")) ||
-        osmData.containsTagKey(QStringLiteral("abandoned:leisure")) ||
-        osmData.containsTagKey(QStringLiteral("disused:highway")) ||
-        osmData.containsTag(QStringLiteral("highway"), QStringLiteral("razed")) ||
-        osmData.containsTag(QStringLiteral("piste:abandoned"), yes)) {
-        return GeoDataPlacemark::None;
+    static const VisualCategoryTags tags;
+
+    for (auto iter = osmData.tagsBegin(), end = osmData.tagsEnd(); iter != end; ++iter) {
+        if (tags.ignoredKeys.contains(iter.keyId()) || tags.ignoredTags.contains(qMakePair(iter.keyId(), iter.valueId()))) {
+            return GeoDataPlacemark::None;
+        }
     }
 
-    if (osmData.containsTag(QStringLiteral("building"), yes)) {
+    if (osmData.containsTag(tags.building, tags.yes)) {
         return GeoDataPlacemark::Building;
     }
 
-    if (osmData.containsTag(QStringLiteral("historic"), QStringLiteral("castle")) && osmData.containsTag(QStringLiteral("castle_type"), QStringLiteral("kremlin"))) {
+    if (osmData.containsTag(tags.historic, tags.castle) && osmData.containsTag(tags.castleType, tags.kremlin)) {
         return GeoDataPlacemark::None;
     }
 
-    if (osmData.containsTag(QStringLiteral("natural"), QStringLiteral("glacier")) && osmData.containsTag(QStringLiteral("glacier:type"), QStringLiteral("shelf"))) {
+    if (osmData.containsTag(tags.natural, tags.glacier) && osmData.containsTag(tags.glacierType, tags.shelf)) {
         return GeoDataPlacemark::NaturalIceShelf;
     }
 
-    if (osmData.containsTag(QStringLiteral("highway"), QStringLiteral("crossing"))) {
-        QStringList const crossings = osmData.tagValue(QStringLiteral("crossing")).split(';');
-        QString const crossingRef = osmData.tagValue(QStringLiteral("crossing_ref"));
+    if (osmData.containsTag(tags.highway, tags.crossing)) {
+        QStringList const crossings = osmData.tagValue(tags.crossing).split(';');
+        QString const crossingRef = osmData.tagValue(tags.crossingRef);
         if (crossingRef == QStringLiteral("zebra") ||
             crossingRef == QStringLiteral("tiger") ||
             crossings.contains(QStringLiteral("zebra")) ||
@@ -2950,43 +3031,37 @@ GeoDataPlacemark::GeoDataVisualCategory StyleBuilder::determineVisualCategory(co
             return GeoDataPlacemark::CrossingIsland;
         }
     }
-    if (osmData.containsTag(QStringLiteral("railway"), QStringLiteral("crossing")) ||
-        osmData.containsTag(QStringLiteral("railway"), QStringLiteral("level_crossing"))) {
+    if (osmData.containsTag(tags.railway, tags.crossing) ||
+        osmData.containsTag(tags.railway, tags.levelCrossing)) {
         return GeoDataPlacemark::CrossingRailway;
     }
 
     Private::initializeOsmVisualCategories();
 
-    auto const pisteType = osmData.tagValue(QStringLiteral("piste:type"));
-    if (!pisteType.isEmpty()) {
-        auto const tag = OsmTag(QStringLiteral("piste:type"), pisteType);
-        auto category = Private::s_visualCategories.value(tag, GeoDataPlacemark::None);
+    auto const pisteType = osmData.findTag(tags.pisteType);
+    if (pisteType != osmData.tagsEnd()) {
+        auto const tag = qMakePair(tags.pisteType, pisteType.valueId());
+        auto category = Private::s_visualCategoryIds.value(tag, GeoDataPlacemark::None);
         if (category != GeoDataPlacemark::None) {
             return category;
         }
     }
 
-    QString const capital(QStringLiteral("capital"));
-    QString const admin_level(QStringLiteral("admin_level"));
-    // National capitals have admin_level=2
-    // More at http://wiki.openstreetmap.org/wiki/Key:capital#Using_relations_for_capitals
-    QString const national_level(QStringLiteral("2"));
-
     for (auto iter = osmData.tagsBegin(), end = osmData.tagsEnd(); iter != end; ++iter) {
-        const auto tag = OsmTag(iter.key(), iter.value());
-        GeoDataPlacemark::GeoDataVisualCategory category = Private::s_visualCategories.value(tag, GeoDataPlacemark::None);
+        const auto tag = qMakePair(iter.keyId(), iter.valueId());
+        GeoDataPlacemark::GeoDataVisualCategory category = Private::s_visualCategoryIds.value(tag, GeoDataPlacemark::None);
         if (category != GeoDataPlacemark::None) {
-            if (category == GeoDataPlacemark::PlaceCity && osmData.containsTag(admin_level, national_level)) {
+            if (category == GeoDataPlacemark::PlaceCity && osmData.containsTag(tags.adminLevel, tags.nationalLevel)) {
                 category = GeoDataPlacemark::PlaceCityNationalCapital;
-            } else if (category == GeoDataPlacemark::PlaceCity && osmData.containsTag(capital, yes)) {
+            } else if (category == GeoDataPlacemark::PlaceCity && osmData.containsTag(tags.capital, tags.yes)) {
                 category = GeoDataPlacemark::PlaceCityCapital;
-            } else if (category == GeoDataPlacemark::PlaceTown && osmData.containsTag(admin_level, national_level)) {
+            } else if (category == GeoDataPlacemark::PlaceTown && osmData.containsTag(tags.adminLevel, tags.nationalLevel)) {
                 category = GeoDataPlacemark::PlaceTownNationalCapital;
-            } else if (category == GeoDataPlacemark::PlaceTown && osmData.containsTag(capital, yes)) {
+            } else if (category == GeoDataPlacemark::PlaceTown && osmData.containsTag(tags.capital, tags.yes)) {
                 category = GeoDataPlacemark::PlaceTownCapital;
-            } else if (category == GeoDataPlacemark::PlaceVillage && osmData.containsTag(admin_level, national_level)) {
+            } else if (category == GeoDataPlacemark::PlaceVillage && osmData.containsTag(tags.adminLevel, tags.nationalLevel)) {
                 category = GeoDataPlacemark::PlaceVillageNationalCapital;
-            } else if (category == GeoDataPlacemark::PlaceVillage && osmData.containsTag(capital, yes)) {
+            } else if (category == GeoDataPlacemark::PlaceVillage && osmData.containsTag(tags.capital, tags.yes)) {
                 category = GeoDataPlacemark::PlaceVillageCapital;
             }
         }
@@ -46,6 +46,12 @@ class MARBLE_EXPORT SunLocator : public QObject
     qreal getLon() const;
     qreal getLat() const;
 
+    /**
+     * Returns the width of the twilight zone in terms of the haversine of
+     * the angular distance to the subsolar point, 0.0 for a sharp terminator.
+     */
+    qreal twilightZone() const;
+
  public Q_SLOTS:
     void update();
 
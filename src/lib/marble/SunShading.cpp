@@ -0,0 +1,482 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "SunShading.h"
+
+#include "GeoDataCoordinates.h"
+#include "MarbleGlobal.h"
+#include "Quaternion.h"
+#include "ViewportParams.h"
+
+#include <QImage>
+#include <QSize>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Marble
+{
+
+namespace
+{
+
+struct UnitVector
+{
+    float x;
+    float y;
+    float z;
+
+    // pixels in space have no position on the planet
+    bool isValid() const { return !std::isnan( x ); }
+};
+
+UnitVector unitVector( qreal lon, qreal lat )
+{
+    const qreal cosLat = cos( lat );
+    const UnitVector result = { float( cosLat * cos( lon ) ), float( cosLat * sin( lon ) ), float( sin( lat ) ) };
+    return result;
+}
+
+const UnitVector Space = { std::numeric_limits<float>::quiet_NaN(), 0, 0 };
+
+// Pixels in space stay as they are, like the ones in bright daylight
+const float SpaceDot = 2.0;
+
+// The kinds of blocks in SunShading::Private::m_edgeBlocks, besides the
+// offsets of the blocks whose pixels have their own positions
+const int InterpolatedBlock = -1;
+const int SpaceBlock = -2;
+const int PixelBlock = -3;
+
+// How far the center of an interpolated block may be off the direction of its
+// corners.  The default twilight zone of 0.1 takes 0.1 / 128 per step of the
+// weight, so this keeps the interpolated weights within about half a step.
+const float MaxCenterDeviation = 0.0004f;
+
+// 0.35 and 0.65 of 256, the darkening of SunLocator::shadePixel()
+const int NightFactor = 90;
+const int DayFactor = 166;
+
+inline QRgb darken( QRgb pixel, int factor )
+{
+    const quint32 redBlue = ( ( pixel & 0x00ff00ff ) * factor >> 8 ) & 0x00ff00ff;
+    const quint32 green = ( ( pixel & 0x0000ff00 ) * factor >> 8 ) & 0x0000ff00;
+    return ( pixel & 0xff000000 ) | redBlue | green;
+}
+
+// Returns day * weight + night * ( 256 - weight ), weight being 0..256
+inline QRgb interpolate( QRgb day, int weight, QRgb night )
+{
+    const int nightWeight = 256 - weight;
+    const quint32 redBlue = ( ( day & 0x00ff00ff ) * weight + ( night & 0x00ff00ff ) * nightWeight ) >> 8;
+    const quint32 alphaGreen = ( ( day >> 8 ) & 0x00ff00ff ) * weight + ( ( night >> 8 ) & 0x00ff00ff ) * nightWeight;
+    return ( redBlue & 0x00ff00ff ) | ( alphaGreen & 0xff00ff00 );
+}
+
+}
+
+class Q_DECL_HIDDEN SunShading::Private
+{
+public:
+    Private();
+
+    bool isValid( const ViewportParams *viewport ) const;
+    void update( const ViewportParams *viewport );
+    int validCorners( int column, int row ) const;
+    int blockKind( const ViewportParams *viewport, int column, int row ) const;
+    bool isLinear( const ViewportParams *viewport, int column, int row ) const;
+    bool hasPlanetAround( int column, int row ) const;
+    void updateGridDots();
+
+    float dot( const UnitVector &vector ) const;
+    float dot( int x, int y ) const;
+    void lineDots( int y, int width, float *dots ) const;
+    void lineWeights( const float *dots, int width, int *weights ) const;
+    void shadeBlockRow( int blockRow, QImage *canvas, const QImage *nightCanvas ) const;
+
+    // The viewport the pixel positions were computed for
+    bool m_valid;
+    Projection m_projection;
+    int m_radius;
+    QSize m_size;
+    Quaternion m_planetAxis;
+
+    int m_blockColumns;
+    int m_blockRows;
+
+    // The positions of the block corners, ( m_blockColumns + 1 ) * ( m_blockRows + 1 )
+    QVector<UnitVector> m_grid;
+    QVector<float> m_gridDots;
+
+    // Per block the offset of its pixel positions in m_edgeVectors, or
+    // InterpolatedBlock if the block is interpolated from its corners, or
+    // SpaceBlock if it shows no part of the planet
+    QVector<int> m_edgeBlocks;
+    QVector<UnitVector> m_edgeVectors;
+
+    UnitVector m_sun;
+    qreal m_twilightZone;
+};
+
+SunShading::Private::Private() :
+    m_valid( false ),
+    m_projection( Spherical ),
+    m_radius( 0 ),
+    m_blockColumns( 0 ),
+    m_blockRows( 0 ),
+    m_sun( unitVector( 0, 0 ) ),
+    m_twilightZone( 0.0 )
+{
+}
+
+bool SunShading::Private::isValid( const ViewportParams *viewport ) const
+{
+    return m_valid
+        && m_projection == viewport->projection()
+        && m_radius == viewport->radius()
+        && m_size == viewport->size()
+        && m_planetAxis == viewport->planetAxis();
+}
+
+void SunShading::Private::update( const ViewportParams *viewport )
+{
+    m_projection = viewport->projection();
+    m_radius = viewport->radius();
+    m_size = viewport->size();
+    m_planetAxis = viewport->planetAxis();
+    m_valid = true;
+
+    m_blockColumns = ( m_size.width() + BlockSize - 1 ) / BlockSize;
+    m_blockRows = ( m_size.height() + BlockSize - 1 ) / BlockSize;
+
+    const int gridColumns = m_blockColumns + 1;
+    m_grid.resize( gridColumns * ( m_blockRows + 1 ) );
+    for ( int row = 0; row <= m_blockRows; ++row ) {
+        for ( int column = 0; column <= m_blockColumns; ++column ) {
+            qreal lon;
+            qreal lat;
+            const bool onPlanet = viewport->geoCoordinates( column * BlockSize, row * BlockSize, lon, lat, GeoDataCoordinates::Radian );
+            m_grid[row * gridColumns + column] = onPlanet ? unitVector( lon, lat ) : Space;
+        }
+    }
+
+    // Blocks are interpolated from their corners where the positions are close
+    // to linear, and get the positions of all of their pixels elsewhere
+    const int blockCount = m_blockColumns * m_blockRows;
+    m_edgeBlocks.resize( blockCount );
+    QVector<int> limbBlocks;
+    for ( int row = 0; row < m_blockRows; ++row ) {
+        for ( int column = 0; column < m_blockColumns; ++column ) {
+            const int kind = blockKind( viewport, column, row );
+            m_edgeBlocks[row * m_blockColumns + column] = kind;
+            if ( kind == PixelBlock && validCorners( column, row ) < 4 ) {
+                limbBlocks << row * m_blockColumns + column;
+            }
+        }
+    }
+
+    // The positions change fastest next to the limb, where a block may still
+    // bend more than its center tells
+    for ( int block: limbBlocks ) {
+        const int row = block / m_blockColumns;
+        const int column = block % m_blockColumns;
+        for ( int neighborRow = qMax( 0, row - 1 ); neighborRow <= qMin( m_blockRows - 1, row + 1 ); ++neighborRow ) {
+            for ( int neighborColumn = qMax( 0, column - 1 ); neighborColumn <= qMin( m_blockColumns - 1, column + 1 ); ++neighborColumn ) {
+                int &kind = m_edgeBlocks[neighborRow * m_blockColumns + neighborColumn];
+                if ( kind == InterpolatedBlock ) {
+                    kind = PixelBlock;
+                }
+            }
+        }
+    }
+
+    m_edgeVectors.resize( 0 );
+    for ( int block = 0; block < blockCount; ++block ) {
+        if ( m_edgeBlocks[block] != PixelBlock ) {
+            continue;
+        }
+
+        m_edgeBlocks[block] = m_edgeVectors.size();
+        const int x0 = ( block % m_blockColumns ) * BlockSize;
+        const int y0 = ( block / m_blockColumns ) * BlockSize;
+        for ( int y = y0; y < y0 + BlockSize; ++y ) {
+            for ( int x = x0; x < x0 + BlockSize; ++x ) {
+                qreal lon;
+                qreal lat;
+                const bool onPlanet = viewport->geoCoordinates( x, y, lon, lat, GeoDataCoordinates::Radian );
+                m_edgeVectors.append( onPlanet ? unitVector( lon, lat ) : Space );
+            }
+        }
+    }
+}
+
+int SunShading::Private::validCorners( int column, int row ) const
+{
+    const int gridColumns = m_blockColumns + 1;
+    const int corner = row * gridColumns + column;
+    return int( m_grid[corner].isValid() ) + int( m_grid[corner + 1].isValid() )
+         + int( m_grid[corner + gridColumns].isValid() ) + int( m_grid[corner + gridColumns + 1].isValid() );
+}
+
+int SunShading::Private::blockKind( const ViewportParams *viewport, int column, int row ) const
+{
+    const int corners = validCorners( column, row );
+    if ( corners == 4 ) {
+        return isLinear( viewport, column, row ) ? InterpolatedBlock : PixelBlock;
+    }
+
+    if ( corners == 0 && !hasPlanetAround( column, row ) ) {
+        return SpaceBlock;
+    }
+
+    // The block crosses the limb
+    return PixelBlock;
+}
+
+bool SunShading::Private::isLinear( const ViewportParams *viewport, int column, int row ) const
+{
+    qreal lon;
+    qreal lat;
+    if ( !viewport->geoCoordinates( column * BlockSize + BlockSize / 2, row * BlockSize + BlockSize / 2,
+                                    lon, lat, GeoDataCoordinates::Radian ) ) {
+        return false;
+    }
+    const UnitVector center = unitVector( lon, lat );
+
+    // The interpolated dots are those of the mean of the corners, which is a
+    // bit shorter than a unit vector.  Only its direction counts, as the
+    // dots are close to 0 in the twilight zone.
+    const int gridColumns = m_blockColumns + 1;
+    const UnitVector *const corners[] = {
+        &m_grid[row * gridColumns + column], &m_grid[row * gridColumns + column + 1],
+        &m_grid[( row + 1 ) * gridColumns + column], &m_grid[( row + 1 ) * gridColumns + column + 1]
+    };
+    float x = 0;
+    float y = 0;
+    float z = 0;
+    for ( const UnitVector *corner: corners ) {
+        x += corner->x;
+        y += corner->y;
+        z += corner->z;
+    }
+    const float length = std::sqrt( x * x + y * y + z * z );
+    const float dx = x / length - center.x;
+    const float dy = y / length - center.y;
+    const float dz = z / length - center.z;
+
+    return dx * dx + dy * dy + dz * dz <= MaxCenterDeviation * MaxCenterDeviation;
+}
+
+bool SunShading::Private::hasPlanetAround( int column, int row ) const
+{
+    // The map is convex in all projections.  It may still reach into a block
+    // without covering any of its corners, but then it covers a corner of a
+    // neighboring block.
+    const int gridColumns = m_blockColumns + 1;
+    for ( int gridRow = qMax( 0, row - 1 ); gridRow <= qMin( m_blockRows, row + 2 ); ++gridRow ) {
+        for ( int gridColumn = qMax( 0, column - 1 ); gridColumn <= qMin( m_blockColumns, column + 2 ); ++gridColumn ) {
+            if ( m_grid[gridRow * gridColumns + gridColumn].isValid() ) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void SunShading::Private::updateGridDots()
+{
+    m_gridDots.resize( m_grid.size() );
+    for ( int i = 0; i < m_grid.size(); ++i ) {
+        m_gridDots[i] = dot( m_grid[i] );
+    }
+}
+
+float SunShading::Private::dot( const UnitVector &vector ) const
+{
+    if ( !vector.isValid() ) {
+        return SpaceDot;
+    }
+    return vector.x * m_sun.x + vector.y * m_sun.y + vector.z * m_sun.z;
+}
+
+float SunShading::Private::dot( int x, int y ) const
+{
+    const int column = x / BlockSize;
+    const int row = y / BlockSize;
+    const int offset = m_edgeBlocks[row * m_blockColumns + column];
+    if ( offset >= 0 ) {
+        return dot( m_edgeVectors[offset + ( y % BlockSize ) * BlockSize + x % BlockSize] );
+    }
+    if ( offset == SpaceBlock ) {
+        return SpaceDot;
+    }
+
+    const int gridColumns = m_blockColumns + 1;
+    const float *const top = m_gridDots.constData() + row * gridColumns + column;
+    const float *const bottom = top + gridColumns;
+    const float fy = float( y % BlockSize ) / BlockSize;
+    const float fx = float( x % BlockSize ) / BlockSize;
+    const float left = top[0] + ( bottom[0] - top[0] ) * fy;
+    const float right = top[1] + ( bottom[1] - top[1] ) * fy;
+    return left + ( right - left ) * fx;
+}
+
+void SunShading::Private::lineDots( int y, int width, float *dots ) const
+{
+    const int row = y / BlockSize;
+    const int yInBlock = y % BlockSize;
+    const float fy = float( yInBlock ) / BlockSize;
+    const int gridColumns = m_blockColumns + 1;
+    const float *const top = m_gridDots.constData() + row * gridColumns;
+    const float *const bottom = top + gridColumns;
+    const int *const edgeBlocks = m_edgeBlocks.constData() + row * m_blockColumns;
+
+    for ( int column = 0; column < m_blockColumns; ++column ) {
+        const int x0 = column * BlockSize;
+        const int count = qMin<int>( BlockSize, width - x0 );
+        float *const blockDots = dots + x0;
+
+        const int offset = edgeBlocks[column];
+        if ( offset >= 0 ) {
+            const UnitVector *const vectors = m_edgeVectors.constData() + offset + yInBlock * BlockSize;
+            for ( int i = 0; i < count; ++i ) {
+                blockDots[i] = dot( vectors[i] );
+            }
+            continue;
+        }
+        if ( offset == SpaceBlock ) {
+            std::fill( blockDots, blockDots + count, SpaceDot );
+            continue;
+        }
+
+        const float left = top[column] + ( bottom[column] - top[column] ) * fy;
+        const float right = top[column + 1] + ( bottom[column + 1] - top[column + 1] ) * fy;
+        const float step = ( right - left ) / BlockSize;
+        for ( int i = 0; i < count; ++i ) {
+            blockDots[i] = left + step * i;
+        }
+    }
+}
+
+void SunShading::Private::lineWeights( const float *dots, int width, int *weights ) const
+{
+    // The brightness 0..1 of SunLocator::shading() in terms of the cosine of
+    // the angle to the subsolar point, scaled to 0..256
+    if ( m_twilightZone <= 0.0 ) {
+        for ( int x = 0; x < width; ++x ) {
+            weights[x] = dots[x] >= 0.0f ? 256 : 0;
+        }
+        return;
+    }
+
+    const float scale = 128.0f / m_twilightZone;
+    for ( int x = 0; x < width; ++x ) {
+        const float weight = ( dots[x] + float( m_twilightZone ) ) * scale;
+        weights[x] = int( qBound( 0.0f, weight, 256.0f ) );
+    }
+}
+
+void SunShading::Private::shadeBlockRow( int blockRow, QImage *canvas, const QImage *nightCanvas ) const
+{
+    const int width = canvas->width();
+    QVector<float> dots( width );
+    QVector<int> weights( width );
+
+    const int yEnd = qMin( canvas->height(), ( blockRow + 1 ) * BlockSize );
+    for ( int y = blockRow * BlockSize; y < yEnd; ++y ) {
+        lineDots( y, width, dots.data() );
+        lineWeights( dots.constData(), width, weights.data() );
+
+        QRgb *const line = reinterpret_cast<QRgb *>( canvas->scanLine( y ) );
+        if ( nightCanvas ) {
+            const QRgb *const nightLine = reinterpret_cast<const QRgb *>( nightCanvas->constScanLine( y ) );
+            for ( int x = 0; x < width; ++x ) {
+                const int weight = weights[x];
+                if ( weight < 256 ) {
+                    line[x] = interpolate( line[x], weight, nightLine[x] );
+                }
+            }
+        } else {
+            for ( int x = 0; x < width; ++x ) {
+                const int weight = weights[x];
+                if ( weight < 256 ) {
+                    line[x] = darken( line[x], NightFactor + ( DayFactor * weight >> 8 ) );
+                }
+            }
+        }
+    }
+}
+
+SunShading::SunShading() :
+    d( new Private )
+{
+}
+
+SunShading::~SunShading()
+{
+    delete d;
+}
+
+void SunShading::setSunPosition( qreal lon, qreal lat )
+{
+    d->m_sun = unitVector( lon, lat );
+}
+
+void SunShading::setTwilightZone( qreal twilightZone )
+{
+    d->m_twilightZone = twilightZone;
+}
+
+void SunShading::shade( QImage *canvas, const QImage *nightCanvas, const ViewportParams *viewport )
+{
+    Q_ASSERT( canvas->size() == viewport->size() );
+    Q_ASSERT( canvas->depth() == 32 );
+    Q_ASSERT( !nightCanvas || ( nightCanvas->size() == canvas->size() && nightCanvas->depth() == 32 ) );
+
+    if ( !d->isValid( viewport ) ) {
+        d->update( viewport );
+    }
+    d->updateGridDots();
+
+    // detach before the scanlines get shared among the threads
+    canvas->bits();
+
+    QVector<int> blockRows( d->m_blockRows );
+    for ( int i = 0; i < blockRows.size(); ++i ) {
+        blockRows[i] = i;
+    }
+    const Private *const shading = d;
+    QtConcurrent::blockingMap( blockRows, [shading, canvas, nightCanvas]( const int &blockRow ) {
+        shading->shadeBlockRow( blockRow, canvas, nightCanvas );
+    } );
+}
+
+qreal SunShading::brightness( int x, int y ) const
+{
+    Q_ASSERT( d->m_valid );
+    Q_ASSERT( x >= 0 && x < d->m_size.width() && y >= 0 && y < d->m_size.height() );
+
+    const float dot = d->dot( x, y );
+    int weight;
+    d->lineWeights( &dot, 1, &weight );
+    return weight / 256.0;
+}
+
+void SunShading::clear()
+{
+    d->m_valid = false;
+    d->m_grid.clear();
+    d->m_gridDots.clear();
+    d->m_edgeBlocks.clear();
+    d->m_edgeVectors.clear();
+}
+
+}
@@ -0,0 +1,84 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SUNSHADING_H
+#define MARBLE_SUNSHADING_H
+
+#include "marble_export.h"
+
+#include <QtGlobal>
+
+class QImage;
+
+namespace Marble
+{
+
+class ViewportParams;
+
+/**
+ * @short Shades the day and night side of a texture mapped canvas.
+ *
+ * The shading is applied to the canvas after texture mapping, so the
+ * texture tiles stay valid while the sun moves.
+ *
+ * The positions on the planet of the canvas pixels are kept as unit
+ * vectors from one frame to the next: On a grid of BlockSize pixels, whose
+ * blocks are interpolated where the positions are close to linear, and per
+ * pixel for the blocks crossing the edge of the map, their neighbors and the
+ * blocks bending too much.  Blocks showing just space are skipped.  The
+ * positions are only computed again once the viewport changed, so moving the
+ * sun just means another dot product per pixel.  The canvas is shaded in
+ * blocks of scanlines on the global thread pool.
+ */
+class MARBLE_EXPORT SunShading
+{
+public:
+    enum { BlockSize = 8 };
+
+    SunShading();
+    ~SunShading();
+
+    /**
+     * Sets the subsolar point, in radians.
+     */
+    void setSunPosition( qreal lon, qreal lat );
+
+    /**
+     * Sets the width of the twilight zone, see SunLocator::twilightZone().
+     */
+    void setTwilightZone( qreal twilightZone );
+
+    /**
+     * Shades @p canvas, the map as seen in @p viewport.  The night side is
+     * darkened, or replaced by the pixels of @p nightCanvas if one is
+     * passed.  Both canvases have the size of the viewport and 32 bit
+     * premultiplied pixels.
+     */
+    void shade( QImage *canvas, const QImage *nightCanvas, const ViewportParams *viewport );
+
+    /**
+     * Returns the brightness at the pixel (@p x, @p y) of the last shaded
+     * canvas: 1.0 on the day side, 0.0 on the night side.
+     */
+    qreal brightness( int x, int y ) const;
+
+    /**
+     * Frees the pixel positions, e.g. while shading is turned off.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY( SunShading )
+
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif
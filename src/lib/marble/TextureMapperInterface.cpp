@@ -27,3 +27,8 @@ void TextureMapperInterface::setRepaintNeeded()
 {
     m_repaintNeeded = true;
 }
+
+QString TextureMapperInterface::runtimeTrace() const
+{
+    return QString();
+}
@@ -12,6 +12,8 @@
 #ifndef MARBLE_TEXTUREMAPPERINTERFACE_H
 #define MARBLE_TEXTUREMAPPERINTERFACE_H
 
+#include <QString>
+
 class QRect;
 
 namespace Marble
@@ -36,6 +38,12 @@ public:
 
     void setRepaintNeeded();
 
+    /**
+     * Returns a short description of the last texture mapping run,
+     * e.g. timing and load balance figures, or an empty string.
+     */
+    virtual QString runtimeTrace() const;
+
 protected:
     bool m_repaintNeeded;
 };
@@ -23,6 +23,7 @@ License along with this library. If not, see <http://www.gnu.org/licenses/>.
 #include <QImage>
 
 #include "Tile.h"
+#include "marble_export.h"
 
 namespace Marble
 {
@@ -54,7 +55,7 @@ class TileId;
     expiration time which will trigger a reload of the tile data.
 */
 
-class TextureTile : public Tile
+class MARBLE_EXPORT TextureTile : public Tile
 {
  public:
     TextureTile(TileId const & tileId, QImage const & image, const Blending * blending );
@@ -21,7 +21,9 @@
 #include "TileLoader.h"
 
 #include <QDateTime>
+#include <QDir>
 #include <QFileInfo>
+#include <QTemporaryFile>
 #include <QMetaType>
 #include <QImage>
 #include <QUrl>
@@ -31,11 +33,15 @@
 #include "GeoSceneTypes.h"
 #include "GeoSceneVectorTileDataset.h"
 #include "GeoDataDocument.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoSceneAbstractTileProjection.h"
+#include "FrameProfiler.h"
 #include "HttpDownloadManager.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
 #include "TileId.h"
 #include "TileLoaderHelper.h"
+#include "MbTilesContainer.h"
 #include "ParseRunnerPlugin.h"
 #include "ParsingRunner.h"
 
@@ -48,8 +54,9 @@ TileLoader::TileLoader(HttpDownloadManager * const downloadManager, const Plugin
     m_pluginManager(pluginManager)
 {
     qRegisterMetaType<DownloadUsage>( "DownloadUsage" );
-    connect( this, SIGNAL(downloadTile(QUrl,QString,QString,DownloadUsage)),
-             downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage)));
+    qRegisterMetaType<GeoDataLatLonBox>( "GeoDataLatLonBox" );
+    connect( this, SIGNAL(downloadTile(QUrl,QString,QString,DownloadUsage,GeoDataLatLonBox,int)),
+             downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage,GeoDataLatLonBox,int)));
     connect( downloadManager, SIGNAL(downloadComplete(QString,QString)),
              SLOT(updateTile(QString,QString)));
     connect( downloadManager, SIGNAL(downloadComplete(QByteArray,QString)),
@@ -66,8 +73,7 @@ TileLoader::~TileLoader()
 //     - if expired: create TextureTile, state is set to Expired by default, trigger dl,
 QImage TileLoader::loadTileImage( GeoSceneTextureTileDataset const *textureLayer, TileId const & tileId, DownloadUsage const usage )
 {
-    QString const fileName = tileFileName( textureLayer, tileId );
-
+    const FrameProfilerScope scope( "TileLoader::loadTileImage" );
     TileStatus status = tileStatus( textureLayer, tileId );
     if ( status != Missing ) {
         // check if an update should be triggered
@@ -80,7 +86,7 @@ QImage TileLoader::loadTileImage( GeoSceneTextureTileDataset const *textureLayer
             triggerDownload( textureLayer, tileId, usage );
         }
 
-        QImage const image( fileName );
+        QImage const image = loadImage( textureLayer, tileId );
         if ( !image.isNull() ) {
             // file is there, so create and return a tile object in any case
             return image;
@@ -101,6 +107,7 @@ QImage TileLoader::loadTileImage( GeoSceneTextureTileDataset const *textureLayer
 
 GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneVectorTileDataset const *textureLayer, TileId const & tileId, DownloadUsage const usage )
 {
+    const FrameProfilerScope scope( "TileLoader::loadTileVectorData" );
     // FIXME: textureLayer->fileFormat() could be used in the future for use just that parser, instead of all available parsers
 
     QString const fileName = tileFileName( textureLayer, tileId );
@@ -118,7 +125,12 @@ GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneVectorTileDataset const
         }
 
         QFile file ( fileName );
-        if ( file.exists() ) {
+        if ( !textureLayer->container().isEmpty() ) {
+            GeoDataDocument* document = openVectorData( MbTilesContainer::findTileData( fileName ), fileName );
+            if (document) {
+                return document;
+            }
+        } else if ( file.exists() ) {
 
             // File is ready, so parse and return the vector data in any case
             GeoDataDocument* document = openVectorFile(fileName);
@@ -153,6 +165,14 @@ int TileLoader::maximumTileLevel( GeoSceneTileDataset const & tileData )
         return tileData.maximumTileLevel();
     }
 
+    if ( !tileData.container().isEmpty() ) {
+        int maximumTileLevel = -1;
+        for ( const MbTilesContainer *container: MbTilesContainer::containers( tileData.containerFileName() ) ) {
+            maximumTileLevel = qMax( maximumTileLevel, container->maximumZoomLevel() );
+        }
+        return maximumTileLevel + 1;
+    }
+
     int maximumTileLevel = -1;
     const QFileInfo themeStr( tileData.themeStr() );
     const QString tilepath = themeStr.isAbsolute() ? themeStr.absoluteFilePath() : MarbleDirs::path( tileData.themeStr() );
@@ -187,8 +207,12 @@ bool TileLoader::baseTilesAvailable( GeoSceneTileDataset const & tileData )
     for ( int column = 0; result && column < levelZeroColumns; ++column ) {
         for ( int row = 0; result && row < levelZeroRows; ++row ) {
             const TileId id( 0, 0, column, row );
-            const QString tilepath = tileFileName( &tileData, id );
-            result &= QFile::exists( tilepath );
+            if ( !tileData.container().isEmpty() ) {
+                result &= MbTilesContainer::findTile( tileData.relativeTileFileName( id ) );
+            } else {
+                const QString tilepath = tileFileName( &tileData, id );
+                result &= QFile::exists( tilepath );
+            }
             if (!result) {
                 mDebug() << "Base tile " << tileData.relativeTileFileName( id ) << " is missing for source dir " << tileData.sourceDir();
             }
@@ -200,6 +224,11 @@ bool TileLoader::baseTilesAvailable( GeoSceneTileDataset const & tileData )
 
 TileLoader::TileStatus TileLoader::tileStatus( GeoSceneTileDataset const *tileData, const TileId &tileId )
 {
+    if ( !tileData->container().isEmpty() ) {
+        // Containers don't keep a modification time per tile, so stored tiles never expire
+        return MbTilesContainer::findTile( tileData->relativeTileFileName( tileId ) ) ? Available : Missing;
+    }
+
     QString const fileName = tileFileName( tileData, tileId );
     QFileInfo fileInfo( fileName );
     if ( !fileInfo.exists() ) {
@@ -247,7 +276,12 @@ void TileLoader::updateTile(const QString &fileName, const QString &idStr)
 
     TileId const id = TileId( sourceDir, zoomLevel, tileX, tileY );
     if (origin == GeoSceneTypes::GeoSceneVectorTileType) {
-        GeoDataDocument* document = openVectorFile(MarbleDirs::path(fileName));
+        GeoDataDocument* document = 0;
+        if ( MbTilesContainer::findTile( fileName ) ) {
+            document = openVectorData( MbTilesContainer::findTileData( fileName ), fileName );
+        } else {
+            document = openVectorFile(MarbleDirs::path(fileName));
+        }
         if (document) {
             emit tileCompleted(id,  document);
         }
@@ -257,10 +291,25 @@ void TileLoader::updateTile(const QString &fileName, const QString &idStr)
 QString TileLoader::tileFileName( GeoSceneTileDataset const * tileData, TileId const & tileId )
 {
     QString const fileName = tileData->relativeTileFileName( tileId );
+    if ( !tileData->container().isEmpty() ) {
+        // resolved by MbTilesContainer, the path doesn't exist on disk
+        return fileName;
+    }
+
     QFileInfo const dirInfo( fileName );
     return dirInfo.isAbsolute() ? fileName : MarbleDirs::path( fileName );
 }
 
+QImage TileLoader::loadImage( GeoSceneTileDataset const * tileData, TileId const & tileId )
+{
+    if ( !tileData->container().isEmpty() ) {
+        return QImage::fromData( MbTilesContainer::findTileData( tileData->relativeTileFileName( tileId ) ) );
+    }
+
+    QString const fileName = tileFileName( tileData, tileId );
+    return QFile::exists( fileName ) ? QImage( fileName ) : QImage();
+}
+
 void TileLoader::triggerDownload( GeoSceneTileDataset const *tileData, TileId const &id, DownloadUsage const usage )
 {
     if (id.zoomLevel() > 0) {
@@ -274,7 +323,8 @@ void TileLoader::triggerDownload( GeoSceneTileDataset const *tileData, TileId co
     QUrl const sourceUrl = tileData->downloadUrl( id );
     QString const destFileName = tileData->relativeTileFileName( id );
     QString const idStr = QString( "%1:%2:%3:%4:%5" ).arg( tileData->nodeType()).arg( tileData->sourceDir() ).arg( id.zoomLevel() ).arg( id.x() ).arg( id.y() );
-    emit downloadTile( sourceUrl, destFileName, idStr, usage );
+    GeoDataLatLonBox const tileArea = tileData->tileProjection()->geoCoordinates( id );
+    emit downloadTile( sourceUrl, destFileName, idStr, usage, tileArea, id.zoomLevel() );
 }
 
 QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTileDataset * textureData, TileId const & id )
@@ -290,9 +340,8 @@ QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTileDataset * text
 
         TileId const replacementTileId( id.mapThemeIdHash(), level,
                                         id.x() >> deltaLevel, id.y() >> deltaLevel );
-        QString const fileName = tileFileName( textureData, replacementTileId );
-        mDebug() << "TileLoader::scaledLowerLevelTile" << "trying" << fileName;
-        QImage toScale = QFile::exists(fileName) ? QImage(fileName) : QImage();
+        mDebug() << "TileLoader::scaledLowerLevelTile" << "trying" << replacementTileId;
+        QImage toScale = loadImage( textureData, replacementTileId );
 
         if ( level == 0 && toScale.isNull() ) {
             mDebug() << "No level zero tile installed in map theme dir. Falling back to a transparent image for now.";
@@ -331,6 +380,10 @@ GeoDataDocument *TileLoader::openVectorFile(const QString &fileName) const
     for( const ParseRunnerPlugin *plugin: plugins ) {
         QStringList const extensions = plugin->fileExtensions();
         if ( extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
+            FrameProfilerScope scope( "ParsingRunner::parseFile" );
+            if ( scope.isRecording() ) {
+                scope.setDetail( fileName );
+            }
             ParsingRunner* runner = plugin->newRunner();
             QString error;
             GeoDataDocument* document = runner->parseFile(fileName, UserDocument, error);
@@ -346,6 +399,24 @@ GeoDataDocument *TileLoader::openVectorFile(const QString &fileName) const
     return nullptr;
 }
 
+GeoDataDocument *TileLoader::openVectorData( const QByteArray &data, const QString &fileName ) const
+{
+    if ( data.isEmpty() ) {
+        return nullptr;
+    }
+
+    // The parsing runners only read files, hand them a local temporary copy
+    // which keeps the suffix of the tile so the right plugin is chosen.
+    QTemporaryFile file( QDir::tempPath() + QLatin1String( "/marble-tile-XXXXXX." ) + QFileInfo( fileName ).completeSuffix() );
+    if ( !file.open() || file.write( data ) != data.size() ) {
+        mDebug() << "Unable to write temporary file for vector tile" << fileName;
+        return nullptr;
+    }
+    file.close();
+
+    return openVectorFile( file.fileName() );
+}
+
 }
 
 #include "moc_TileLoader.cpp"
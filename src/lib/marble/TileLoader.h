@@ -33,13 +33,14 @@ class QString;
 namespace Marble
 {
 class TileId;
+class GeoDataLatLonBox;
 class HttpDownloadManager;
 class GeoDataDocument;
 class GeoSceneTileDataset;
 class GeoSceneTextureTileDataset;
 class GeoSceneVectorTileDataset;
 
-class TileLoader: public QObject
+class MARBLE_EXPORT TileLoader: public QObject
 {
     Q_OBJECT
 
@@ -79,7 +80,8 @@ class TileLoader: public QObject
 
  Q_SIGNALS:
     void downloadTile( QUrl const & sourceUrl, QString const & destinationFileName,
-                       QString const & id, DownloadUsage );
+                       QString const & id, DownloadUsage,
+                       GeoDataLatLonBox const & tileArea, int zoomLevel );
 
     void tileCompleted( TileId const & tileId, QImage const & tileImage );
 
@@ -88,8 +90,10 @@ class TileLoader: public QObject
  private:
     static QString tileFileName( GeoSceneTileDataset const * tileData, TileId const & );
     void triggerDownload( GeoSceneTileDataset const *tileData, TileId const &, DownloadUsage const );
+    static QImage loadImage( GeoSceneTileDataset const * tileData, TileId const & );
     static QImage scaledLowerLevelTile( GeoSceneTextureTileDataset const * textureData, TileId const & );
     GeoDataDocument* openVectorFile(const QString &filename) const;
+    GeoDataDocument* openVectorData( const QByteArray &data, const QString &fileName ) const;
 
     // For vectorTile parsing
     PluginManager const * m_pluginManager;
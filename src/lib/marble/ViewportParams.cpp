@@ -19,6 +19,7 @@
 #include <QRegion>
 
 #include "MarbleDebug.h"
+#include "FrameProfiler.h"
 #include "GeoDataLatLonAltBox.h"
 #include "SphericalProjection.h"
 #include "EquirectProjection.h"
@@ -403,6 +404,7 @@ bool ViewportParams::screenCoordinates( const GeoDataCoordinates &coordinates,
 bool ViewportParams::screenCoordinates( const GeoDataLineString &lineString,
                         QVector<QPolygonF*> &polygons ) const
 {
+    const FrameProfilerScope scope( "ViewportParams::screenCoordinates" );
     return d->m_currentProjection->screenCoordinates( lineString, this, polygons );
 }
 
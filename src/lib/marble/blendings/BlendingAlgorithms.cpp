@@ -38,6 +38,35 @@ void OverpaintBlending::blend( QImage * const bottom, TextureTile const * const
     painter.drawImage( 0, 0, *top->image() );
 }
 
+// Returns @p image if its 32 bit pixels can be read as they are, a copy converted to @p format otherwise.
+static QImage rgb32Image( QImage const & image, QImage::Format const format )
+{
+    if ( image.format() == format || image.format() == QImage::Format_RGB32 ) {
+        return image;
+    }
+    return image.convertToFormat( format );
+}
+
+// Calls @p blendLine( bottomLine, topLine, width ) for each scanline of the images,
+// which is inlined for the blending at hand rather than dispatched per pixel.
+// pre-conditions:
+// - bottom and top image have the same size
+// - both images have 32 bit pixels
+template<class BlendLine>
+static void blendScanLines( QImage * const bottom, QImage const & top, BlendLine const & blendLine )
+{
+    Q_ASSERT( bottom->size() == top.size() );
+    Q_ASSERT( bottom->depth() == 32 && top.depth() == 32 );
+
+    int const width = bottom->width();
+    int const height = bottom->height();
+    for ( int y = 0; y < height; ++y ) {
+        QRgb * const bottomLine = reinterpret_cast<QRgb *>( bottom->scanLine( y ));
+        QRgb const * const topLine = reinterpret_cast<QRgb const *>( top.constScanLine( y ));
+        blendLine( bottomLine, topLine, width );
+    }
+}
+
 void GrayscaleBlending::blend( QImage * const bottom, TextureTile const * const top ) const
 {
     Q_ASSERT( bottom );
@@ -45,21 +74,48 @@ void GrayscaleBlending::blend( QImage * const bottom, TextureTile const * const
     Q_ASSERT( top->image() );
     Q_ASSERT( bottom->size() == top->image()->size() );
     Q_ASSERT( bottom->format() == QImage::Format_ARGB32_Premultiplied );
-    QImage const topImagePremult = top->image()->convertToFormat( QImage::Format_ARGB32_Premultiplied );
-
-    // Draw a grayscale version of the bottom image
-    int const width = bottom->width();
-    int const height = bottom->height();
+    QImage const topImagePremult = rgb32Image( *top->image(), QImage::Format_ARGB32_Premultiplied );
 
-    for ( int y = 0; y < height; ++y ) {
+    // Draw a grayscale version of the top image
+    blendScanLines( bottom, topImagePremult, []( QRgb * const bottomLine, QRgb const * const topLine, int const width ) {
         for ( int x = 0; x < width; ++x ) {
-            QRgb const topPixel = topImagePremult.pixel( x, y );
-            int const gray = qGray( topPixel );
-            QRgb const grayPixel = qRgb( gray, gray, gray );
-            bottom->setPixel( x, y,grayPixel );
+            int const gray = qGray( topLine[x] );
+            bottomLine[x] = qRgb( gray, gray, gray );
         }
+    } );
+}
+
+IndependentChannelBlending::IndependentChannelBlending()
+    : m_channelTable( 0 )
+{
+}
+
+IndependentChannelBlending::~IndependentChannelBlending()
+{
+    delete[] m_channelTable.load();
+}
+
+quint8 const * IndependentChannelBlending::channelTable() const
+{
+    quint8 * table = m_channelTable.loadAcquire();
+    if ( table ) {
+        return table;
     }
 
+    // Tiles may be blended by several loader threads at once, the first table stored wins.
+    table = new quint8[256 * 256];
+    for ( int bottom = 0; bottom < 256; ++bottom ) {
+        for ( int top = 0; top < 256; ++top ) {
+            qreal const result = blendChannel( bottom / 255.0, top / 255.0 );
+            // also maps NaN (e.g. 0 / 0) to a defined value
+            table[bottom * 256 + top] = int( qBound( qreal( 0.0 ), result, qreal( 1.0 )) * 255.0 );
+        }
+    }
+    if ( !m_channelTable.testAndSetOrdered( 0, table )) {
+        delete[] table;
+        table = m_channelTable.loadAcquire();
+    }
+    return table;
 }
 
 // pre-conditions:
@@ -73,24 +129,17 @@ void IndependentChannelBlending::blend( QImage * const bottom,
     Q_ASSERT( bottom->size() == topImage->size() );
     Q_ASSERT( bottom->format() == QImage::Format_ARGB32_Premultiplied );
 
-    int const width = bottom->width();
-    int const height = bottom->height();
-    QImage const topImagePremult = topImage->convertToFormat( QImage::Format_ARGB32_Premultiplied );
-    for ( int y = 0; y < height; ++y ) {
+    QImage const topImagePremult = rgb32Image( *topImage, QImage::Format_ARGB32_Premultiplied );
+    quint8 const * const table = channelTable();
+    blendScanLines( bottom, topImagePremult, [table]( QRgb * const bottomLine, QRgb const * const topLine, int const width ) {
         for ( int x = 0; x < width; ++x ) {
-            QRgb const bottomPixel = bottom->pixel( x, y );
-            QRgb const topPixel = topImagePremult.pixel( x, y );
-            qreal const resultRed = blendChannel( qRed( bottomPixel ) / 255.0,
-                                                  qRed( topPixel ) / 255.0 );
-            qreal const resultGreen = blendChannel( qGreen( bottomPixel ) / 255.0,
-                                                    qGreen( topPixel ) / 255.0 );
-            qreal const resultBlue = blendChannel( qBlue( bottomPixel ) / 255.0,
-                                                   qBlue( topPixel ) / 255.0 );
-            bottom->setPixel( x, y, qRgb( resultRed * 255.0,
-                                          resultGreen * 255.0,
-                                          resultBlue * 255.0 ));
+            QRgb const bottomPixel = bottomLine[x];
+            QRgb const topPixel = topLine[x];
+            bottomLine[x] = qRgb( table[qRed( bottomPixel ) << 8 | qRed( topPixel )],
+                                  table[qGreen( bottomPixel ) << 8 | qGreen( topPixel )],
+                                  table[qBlue( bottomPixel ) << 8 | qBlue( topPixel )] );
         }
-    }
+    } );
 }
 
 
@@ -325,20 +374,23 @@ void CloudsBlending::blend( QImage * const bottom, TextureTile const * const top
     QImage const * const topImage = top->image();
     Q_ASSERT( topImage );
     Q_ASSERT( bottom->size() == topImage->size() );
-    int const width = bottom->width();
-    int const height = bottom->height();
-    for ( int y = 0; y < height; ++y ) {
+
+    // Only the red channel of the top image is used, as it is, premultiplied or not
+    QImage const topImage32 = topImage->format() == QImage::Format_ARGB32_Premultiplied
+                              ? *topImage
+                              : rgb32Image( *topImage, QImage::Format_ARGB32 );
+    blendScanLines( bottom, topImage32, []( QRgb * const bottomLine, QRgb const * const topLine, int const width ) {
         for ( int x = 0; x < width; ++x ) {
-            qreal const c = qRed( topImage->pixel( x, y )) / 255.0;
-            QRgb const bottomPixel = bottom->pixel( x, y );
+            qreal const c = qRed( topLine[x] ) / 255.0;
+            QRgb const bottomPixel = bottomLine[x];
             int const bottomRed = qRed( bottomPixel );
             int const bottomGreen = qGreen( bottomPixel );
             int const bottomBlue = qBlue( bottomPixel );
-            bottom->setPixel( x, y, qRgb(( int )( bottomRed + ( 255 - bottomRed ) * c ),
-                                         ( int )( bottomGreen + ( 255 - bottomGreen ) * c ),
-                                         ( int )( bottomBlue + ( 255 - bottomBlue ) * c )));
+            bottomLine[x] = qRgb(( int )( bottomRed + ( 255 - bottomRed ) * c ),
+                                 ( int )( bottomGreen + ( 255 - bottomGreen ) * c ),
+                                 ( int )( bottomBlue + ( 255 - bottomBlue ) * c ));
         }
-    }
+    } );
 }
 
 
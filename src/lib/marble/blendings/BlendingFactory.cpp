@@ -17,17 +17,11 @@
 
 #include <QDebug>
 
-#include "blendings/SunLightBlending.h"
 #include "BlendingAlgorithms.h"
 
 namespace Marble
 {
 
-void BlendingFactory::setLevelZeroLayout( int levelZeroColumns, int levelZeroRows )
-{
-    m_sunLightBlending->setLevelZeroLayout( levelZeroColumns, levelZeroRows );
-}
-
 Blending const * BlendingFactory::findBlending( QString const & name ) const
 {
     if ( name.isEmpty() )
@@ -39,8 +33,7 @@ Blending const * BlendingFactory::findBlending( QString const & name ) const
     return result;
 }
 
-BlendingFactory::BlendingFactory( const SunLocator *sunLocator )
-    : m_sunLightBlending( new SunLightBlending( sunLocator ) )
+BlendingFactory::BlendingFactory()
 {
     m_blendings.insert( "OverpaintBlending", new OverpaintBlending );
 
@@ -86,14 +79,13 @@ BlendingFactory::BlendingFactory( const SunLocator *sunLocator )
 
     // Special purpose blendings
     m_blendings.insert( "CloudsBlending", new CloudsBlending );
-    m_blendings.insert( "SunLightBlending", m_sunLightBlending );
+    // night layers are separated from the day ones by TextureLayer and shaded on screen
+    m_blendings.insert( "SunLightBlending", new OverpaintBlending );
     m_blendings.insert( "GrayscaleBlending", new GrayscaleBlending );
 }
 
 BlendingFactory::~BlendingFactory()
 {
-    m_blendings.remove( "SunLightBlending" );
-    delete m_sunLightBlending;
     qDeleteAll( m_blendings );
 }
 
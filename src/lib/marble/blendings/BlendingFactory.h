@@ -18,27 +18,24 @@
 
 #include <QHash>
 
+#include "marble_export.h"
+
 class QString;
 
 namespace Marble
 {
 class Blending;
-class SunLightBlending;
-class SunLocator;
 
-class BlendingFactory
+class MARBLE_EXPORT BlendingFactory
 {
  public:
-    explicit BlendingFactory( const SunLocator *sunLocator );
+    BlendingFactory();
     ~BlendingFactory();
 
-    void setLevelZeroLayout( int levelZeroColumns, int levelZeroRows );
-
     Blending const * findBlending( QString const & name ) const;
 
  private:
     Q_DISABLE_COPY(BlendingFactory)
-    SunLightBlending *const m_sunLightBlending;
     QHash<QString, Blending const *> m_blendings;
 };
 
@@ -119,8 +119,8 @@ void GeoDataBalloonStyle::pack( QDataStream& stream ) const
 {
     GeoDataColorStyle::pack( stream );
 
-    stream << d->m_bgColor.name();
-    stream << d->m_textColor.name();
+    stream << d->m_bgColor;
+    stream << d->m_textColor;
     stream << d->m_text;
 }
 
@@ -122,17 +122,18 @@ void GeoDataColorStyle::pack( QDataStream& stream ) const
     GeoDataObject::pack( stream );
 
     stream << d->m_color;
-    // FIXME: Why is not colorMode saved?
-//    stream << m_colorMode;
+    stream << int( d->m_colorMode );
 }
 
 void GeoDataColorStyle::unpack( QDataStream& stream )
 {
     GeoDataObject::unpack( stream );
 
-    stream >> d->m_color;
-    // FIXME: Why is not colorMode saved?
-    //    stream >> m_colorMode;
+    QColor color;
+    int colorMode;
+    stream >> color >> colorMode;
+    setColor( color );
+    setColorMode( ColorMode( colorMode ) );
 }
 
 QString Marble::GeoDataColorStyle::contrastColor(const QColor &color)
@@ -22,6 +22,7 @@
 #include "GeoDataDocument.h"
 #include "GeoDataLatLonAltBox.h"
 #include "GeoDataGeometry.h"
+#include "GeoDataStyle.h"
 #include "GeoDataNetworkLinkControl.h"
 #include "GeoDataNetworkLink.h"
 #include "GeoDataGroundOverlay.h"
@@ -385,40 +386,47 @@ void GeoDataContainer::pack( QDataStream& stream ) const
 
 void GeoDataContainer::unpack( QDataStream& stream )
 {
-    Q_D(GeoDataContainer);
     GeoDataFeature::unpack( stream );
 
     int count;
     stream >> count;
 
-    for ( int i = 0; i < count; ++i ) {
+    GeoDataStyle::ConstPtr previousStyle;
+    for ( int i = 0; i < count && stream.status() == QDataStream::Ok; ++i ) {
         int featureId;
         stream >> featureId;
+        GeoDataFeature *feature = nullptr;
         switch( featureId ) {
             case GeoDataDocumentId:
-                /* not usable!!!! */ break;
+                feature = new GeoDataDocument;
+                break;
             case GeoDataFolderId:
-                {
-                GeoDataFolder *folder = new GeoDataFolder;
-                folder->unpack( stream );
-                d->m_vector.append( folder );
-                }
+                feature = new GeoDataFolder;
                 break;
             case GeoDataPlacemarkId:
-                {
-                GeoDataPlacemark *placemark = new GeoDataPlacemark;
-                placemark->unpack( stream );
-                d->m_vector.append( placemark );
-                }
-                break;
-            case GeoDataNetworkLinkId:
-                break;
-            case GeoDataScreenOverlayId:
+                feature = new GeoDataPlacemark;
                 break;
-            case GeoDataGroundOverlayId:
-                break;
-            default: break;
+            default:
+                // the other features can't be unpacked, so the rest of the stream is lost
+                mDebug() << "Cannot unpack feature" << featureId;
+                stream.setStatus( QDataStream::ReadCorruptData );
+                return;
         };
+
+        // appended before unpacking, so that style urls find the document
+        append( feature );
+        feature->unpack( stream );
+
+        if ( !feature->styleUrl().isEmpty() ) {
+            feature->setStyleUrl( feature->styleUrl() );
+        } else if ( feature->customStyle() ) {
+            // consecutive features usually share their style, keep one copy of it
+            if ( previousStyle && *previousStyle == *feature->customStyle() ) {
+                feature->setStyle( qSharedPointerConstCast<GeoDataStyle>( previousStyle ) );
+            } else {
+                previousStyle = feature->customStyle();
+            }
+        }
     }
 }
 
@@ -282,32 +282,46 @@ QList<GeoDataSchema> GeoDataDocument::schemas() const
 void GeoDataDocument::pack( QDataStream& stream ) const
 {
     Q_D(const GeoDataDocument);
-    GeoDataContainer::pack( stream );
 
+    // styles go first, so that the style urls of the features can be resolved while unpacking
     stream << d->m_styleHash.size();
-
     for( QMap<QString, GeoDataStyle::Ptr>::const_iterator iterator
           = d->m_styleHash.constBegin();
         iterator != d->m_styleHash.constEnd();
         ++iterator ) {
         iterator.value()->pack( stream );
     }
-}
 
+    stream << d->m_styleMapHash.size();
+    for( QMap<QString, GeoDataStyleMap>::const_iterator iterator
+          = d->m_styleMapHash.constBegin();
+        iterator != d->m_styleMapHash.constEnd();
+        ++iterator ) {
+        iterator.value().pack( stream );
+    }
+
+    GeoDataContainer::pack( stream );
+}
 
 void GeoDataDocument::unpack( QDataStream& stream )
 {
-    Q_D(GeoDataDocument);
-    GeoDataContainer::unpack( stream );
-
     int size = 0;
 
     stream >> size;
-    for( int i = 0; i < size; i++ ) {
-        GeoDataStyle::Ptr style;
+    for( int i = 0; i < size && stream.status() == QDataStream::Ok; i++ ) {
+        GeoDataStyle::Ptr style( new GeoDataStyle );
         style->unpack( stream );
-        d->m_styleHash.insert(style->id(), style);
+        addStyle( style );
+    }
+
+    stream >> size;
+    for( int i = 0; i < size && stream.status() == QDataStream::Ok; i++ ) {
+        GeoDataStyleMap styleMap;
+        styleMap.unpack( stream );
+        addStyleMap( styleMap );
     }
+
+    GeoDataContainer::unpack( stream );
 }
 
 }
@@ -114,6 +114,11 @@ GeoDataSimpleArrayData* GeoDataExtendedData::simpleArrayData( const QString& key
     return d->arrayHash[ key ];
 }
 
+bool GeoDataExtendedData::hasSimpleArrayData() const
+{
+    return !d->arrayHash.isEmpty();
+}
+
 GeoDataSchemaData& GeoDataExtendedData::schemaData( const QString& schemaUrl ) const
 {
     return d->schemaDataHash[ schemaUrl ];
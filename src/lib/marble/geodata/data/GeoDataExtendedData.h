@@ -108,6 +108,11 @@ class GEODATA_EXPORT GeoDataExtendedData : public GeoDataObject
      */
     GeoDataSimpleArrayData* simpleArrayData( const QString& key ) const;
 
+    /**
+     * @brief return whether SimpleArrayData is set for any key
+     */
+    bool hasSimpleArrayData() const;
+
     /**
      * @brief Adds a SchemaData @p schemaData element to schemaDataHash
      */
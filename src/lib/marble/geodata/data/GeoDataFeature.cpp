@@ -529,14 +529,38 @@ void GeoDataFeature::pack( QDataStream& stream ) const
     GeoDataObject::pack( stream );
 
     stream << d->m_name;
-    stream << d->featureExtendedData().m_address;
-    stream << d->featureExtendedData().m_phoneNumber;
-    stream << d->featureExtendedData().m_description;
+    stream << d->m_styleUrl;
     stream << d->m_visible;
-//    stream << d->m_visualCategory;
     stream << d->m_role;
     stream << d->m_popularity;
     stream << d->m_zoomLevel;
+
+    stream << d->m_extendedData.size();
+    for ( auto iter = d->m_extendedData.constBegin(), end = d->m_extendedData.constEnd(); iter != end; ++iter ) {
+        stream << iter.key();
+        iter.value().pack( stream );
+    }
+
+    // a style resolved from the style url is restored from the document instead
+    const bool hasStyle = d->m_style && d->m_styleUrl.isEmpty();
+    stream << hasStyle;
+    if ( hasStyle ) {
+        d->m_style->pack( stream );
+    }
+
+    // most features never touch the rarely used properties, so don't create them here
+    const GeoDataFeatureExtendedData *extendedData = d->m_featureExtendedData;
+    stream << bool( extendedData );
+    if ( extendedData ) {
+        stream << extendedData->m_snippet.text();
+        stream << extendedData->m_snippet.maxLines();
+        stream << extendedData->m_description;
+        stream << extendedData->m_descriptionCDATA;
+        stream << extendedData->m_address;
+        stream << extendedData->m_phoneNumber;
+        extendedData->m_timeSpan.pack( stream );
+        extendedData->m_timeStamp.pack( stream );
+    }
 }
 
 void GeoDataFeature::unpack( QDataStream& stream )
@@ -545,14 +569,46 @@ void GeoDataFeature::unpack( QDataStream& stream )
     GeoDataObject::unpack( stream );
 
     stream >> d->m_name;
-    stream >> d->featureExtendedData().m_address;
-    stream >> d->featureExtendedData().m_phoneNumber;
-    stream >> d->featureExtendedData().m_description;
+    stream >> d->m_styleUrl;
     stream >> d->m_visible;
-//    stream >> (int)d->m_visualCategory;
     stream >> d->m_role;
     stream >> d->m_popularity;
     stream >> d->m_zoomLevel;
+
+    int dataCount;
+    stream >> dataCount;
+    for ( int i = 0; i < dataCount && stream.status() == QDataStream::Ok; ++i ) {
+        QString name;
+        stream >> name;
+        GeoDataData data;
+        data.unpack( stream );
+        data.setName( name );
+        d->m_extendedData.addValue( data );
+    }
+
+    bool hasStyle;
+    stream >> hasStyle;
+    if ( hasStyle ) {
+        GeoDataStyle::Ptr style( new GeoDataStyle );
+        style->unpack( stream );
+        setStyle( style );
+    }
+
+    bool hasExtendedData;
+    stream >> hasExtendedData;
+    if ( hasExtendedData ) {
+        GeoDataFeatureExtendedData &extendedData = d->featureExtendedData();
+        QString snippet;
+        int maxLines;
+        stream >> snippet >> maxLines;
+        extendedData.m_snippet = GeoDataSnippet( snippet, maxLines );
+        stream >> extendedData.m_description;
+        stream >> extendedData.m_descriptionCDATA;
+        stream >> extendedData.m_address;
+        stream >> extendedData.m_phoneNumber;
+        extendedData.m_timeSpan.unpack( stream );
+        extendedData.m_timeStamp.unpack( stream );
+    }
 }
 
 }
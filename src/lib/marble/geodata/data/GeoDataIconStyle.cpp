@@ -298,7 +298,12 @@ void GeoDataIconStyle::pack( QDataStream& stream ) const
     GeoDataColorStyle::pack( stream );
 
     stream << d->m_scale;
-    stream << d->m_icon;
+    stream << d->m_iconPath;
+    // icons given by a path are loaded from there again
+    stream << ( d->m_iconPath.isEmpty() ? d->m_icon : QImage() );
+    stream << d->m_size;
+    stream << int( d->m_aspectRatioMode );
+    stream << d->m_heading;
     d->m_hotSpot.pack( stream );
 }
 
@@ -307,7 +312,13 @@ void GeoDataIconStyle::unpack( QDataStream& stream )
     GeoDataColorStyle::unpack( stream );
 
     stream >> d->m_scale;
+    stream >> d->m_iconPath;
     stream >> d->m_icon;
+    stream >> d->m_size;
+    int aspectRatioMode;
+    stream >> aspectRatioMode;
+    d->m_aspectRatioMode = Qt::AspectRatioMode( aspectRatioMode );
+    stream >> d->m_heading;
     d->m_hotSpot.unpack( stream );
 }
 
@@ -286,13 +286,13 @@ void GeoDataLineStringPrivate::optimize (GeoDataLineString& lineString) const
 bool GeoDataLineString::isEmpty() const
 {
     Q_D(const GeoDataLineString);
-    return d->m_vector.isEmpty();
+    return d->m_isPacked ? d->m_packed.isEmpty() : d->m_vector.isEmpty();
 }
 
 int GeoDataLineString::size() const
 {
     Q_D(const GeoDataLineString);
-    return d->m_vector.size();
+    return d->m_isPacked ? d->m_packed.size() : d->m_vector.size();
 }
 
 GeoDataCoordinates& GeoDataLineString::at( int pos )
@@ -300,6 +300,7 @@ GeoDataCoordinates& GeoDataLineString::at( int pos )
     detach();
 
     Q_D(GeoDataLineString);
+    d->unpackCoordinates();
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
     return d->m_vector[pos];
@@ -308,6 +309,7 @@ GeoDataCoordinates& GeoDataLineString::at( int pos )
 const GeoDataCoordinates& GeoDataLineString::at( int pos ) const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.at(pos);
 }
 
@@ -316,6 +318,7 @@ GeoDataCoordinates& GeoDataLineString::operator[]( int pos )
     detach();
 
     Q_D(GeoDataLineString);
+    d->unpackCoordinates();
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
     return d->m_vector[pos];
@@ -325,6 +328,7 @@ GeoDataLineString GeoDataLineString::mid(int pos, int length) const
 {
     GeoDataLineString substring;
     auto d = substring.d_func();
+    d_func()->unpackCoordinates();
     d->m_vector = d_func()->m_vector.mid(pos, length);
     d->m_dirtyBox = true;
     d->m_dirtyRange = true;
@@ -336,6 +340,7 @@ GeoDataLineString GeoDataLineString::mid(int pos, int length) const
 const GeoDataCoordinates& GeoDataLineString::operator[]( int pos ) const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector[pos];
 }
 
@@ -344,6 +349,7 @@ GeoDataCoordinates& GeoDataLineString::last()
     detach();
 
     Q_D(GeoDataLineString);
+    d->unpackCoordinates();
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
     return d->m_vector.last();
@@ -354,18 +360,21 @@ GeoDataCoordinates& GeoDataLineString::first()
     detach();
 
     Q_D(GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.first();
 }
 
 const GeoDataCoordinates& GeoDataLineString::last() const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.last();
 }
 
 const GeoDataCoordinates& GeoDataLineString::first() const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.first();
 }
 
@@ -374,12 +383,14 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::begin()
     detach();
 
     Q_D(GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.begin();
 }
 
 QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::begin() const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.constBegin();
 }
 
@@ -388,24 +399,28 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::end()
     detach();
 
     Q_D(GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.end();
 }
 
 QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::end() const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.constEnd();
 }
 
 QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::constBegin() const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.constBegin();
 }
 
 QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::constEnd() const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
     return d->m_vector.constEnd();
 }
 
@@ -418,6 +433,7 @@ void GeoDataLineString::insert( int index, const GeoDataCoordinates& value )
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->unpackCoordinates();
     d->m_vector.insert( index, value );
 }
 
@@ -430,12 +446,14 @@ void GeoDataLineString::append ( const GeoDataCoordinates& value )
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->unpackCoordinates();
     d->m_vector.append( value );
 }
 
 void GeoDataLineString::reserve(int size)
 {
     Q_D(GeoDataLineString);
+    d->unpackCoordinates();
     d->m_vector.reserve(size);
 }
 
@@ -448,6 +466,7 @@ void GeoDataLineString::append(const QVector<GeoDataCoordinates>& values)
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->unpackCoordinates();
 
 #if QT_VERSION >= 0x050500
     d->m_vector.append(values);
@@ -468,6 +487,7 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataCoordinates& va
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->unpackCoordinates();
     d->m_vector.append( value );
     return *this;
 }
@@ -481,6 +501,7 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataLineString& val
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->unpackCoordinates();
 
     QVector<GeoDataCoordinates>::const_iterator itCoords = value.constBegin();
     QVector<GeoDataCoordinates>::const_iterator itEnd = value.constEnd();
@@ -503,6 +524,8 @@ bool GeoDataLineString::operator==( const GeoDataLineString &other ) const
 
     Q_D(const GeoDataLineString);
     const GeoDataLineStringPrivate* other_d = other.d_func();
+    d->unpackCoordinates();
+    other_d->unpackCoordinates();
 
     QVector<GeoDataCoordinates>::const_iterator itCoords = d->m_vector.constBegin();
     QVector<GeoDataCoordinates>::const_iterator otherItCoords = other_d->m_vector.constBegin();
@@ -535,6 +558,8 @@ void GeoDataLineString::clear()
     d->m_dirtyBox = true;
 
     d->m_vector.clear();
+    d->m_packed.clear();
+    d->m_isPacked = false;
 }
 
 bool GeoDataLineString::isClosed() const
@@ -606,6 +631,7 @@ GeoDataLineString GeoDataLineString::toNormalized() const
 
     // FIXME: Think about how we can avoid unnecessary copies
     //        if the linestring stays the same.
+    d->unpackCoordinates();
     QVector<GeoDataCoordinates>::const_iterator end = d->m_vector.constEnd();
     for( QVector<GeoDataCoordinates>::const_iterator itCoords
           = d->m_vector.constBegin();
@@ -649,6 +675,7 @@ QVector<GeoDataLineString*> GeoDataLineString::toDateLineCorrected() const
 
     QVector<GeoDataLineString*> lineStrings;
 
+    d->unpackCoordinates();
     d->toDateLineCorrected(*this, lineStrings);
 
     return lineStrings;
@@ -657,6 +684,7 @@ QVector<GeoDataLineString*> GeoDataLineString::toDateLineCorrected() const
 GeoDataLineString GeoDataLineString::toPoleCorrected() const
 {
     Q_D(const GeoDataLineString);
+    d->unpackCoordinates();
 
     if( isClosed() ) {
         GeoDataLinearRing poleCorrected;
@@ -843,6 +871,7 @@ const GeoDataLatLonAltBox& GeoDataLineString::latLonAltBox() const
     // is TRUE.
     // DO NOT REMOVE THIS CONSTRUCT OR MARBLE WILL BE SLOW.
     if (d->m_dirtyBox) {
+        d->unpackCoordinates();
         d->m_latLonAltBox = GeoDataLatLonAltBox::fromLineString(*this);
         d->m_dirtyBox = false;
     }
@@ -858,9 +887,19 @@ qreal GeoDataLineString::length( qreal planetRadius, int offset ) const
 
     Q_D(const GeoDataLineString);
     qreal length = 0.0;
-    QVector<GeoDataCoordinates> const & vector = d->m_vector;
     int const start = qMax(offset+1, 1);
-    int const end = d->m_vector.size();
+    int const end = size();
+    if ( d->m_isPacked ) {
+        const qreal *lon = d->m_packed.longitudes();
+        const qreal *lat = d->m_packed.latitudes();
+        for( int i=start; i<end; ++i )
+        {
+            length += distanceSphere( lon[i-1], lat[i-1], lon[i], lat[i] );
+        }
+        return planetRadius * length;
+    }
+
+    QVector<GeoDataCoordinates> const & vector = d->m_vector;
     for( int i=start; i<end; ++i )
     {
         length += distanceSphere( vector[i-1], vector[i] );
@@ -878,6 +917,7 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->unpackCoordinates();
     return d->m_vector.erase( pos );
 }
 
@@ -891,6 +931,7 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->unpackCoordinates();
     return d->m_vector.erase( begin, end );
 }
 
@@ -901,6 +942,7 @@ void GeoDataLineString::remove ( int i )
     Q_D(GeoDataLineString);
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    d->unpackCoordinates();
     d->m_vector.remove( i );
 }
 
@@ -919,6 +961,44 @@ GeoDataLineString GeoDataLineString::optimized () const
     }
 }
 
+void GeoDataLineString::setPacked( bool packed )
+{
+    if ( packed == isPacked() ) {
+        return;
+    }
+
+    detach();
+
+    Q_D(GeoDataLineString);
+    if ( !packed ) {
+        d->unpackCoordinates();
+        return;
+    }
+
+    // The bounding box is calculated from the GeoDataCoordinates
+    // and stays valid as long as the line string is packed.
+    latLonAltBox();
+    delete d->m_rangeCorrected;
+    d->m_rangeCorrected = 0;
+    d->m_dirtyRange = true;
+
+    d->m_packed = GeoDataPackedCoordinates( d->m_vector );
+    d->m_vector = QVector<GeoDataCoordinates>();
+    d->m_isPacked = true;
+}
+
+bool GeoDataLineString::isPacked() const
+{
+    Q_D(const GeoDataLineString);
+    return d->m_isPacked;
+}
+
+GeoDataPackedCoordinates GeoDataLineString::packedCoordinates() const
+{
+    Q_D(const GeoDataLineString);
+    return d->m_isPacked ? d->m_packed : GeoDataPackedCoordinates( d->m_vector );
+}
+
 void GeoDataLineString::pack( QDataStream& stream ) const
 {
     Q_D(const GeoDataLineString);
@@ -928,13 +1008,12 @@ void GeoDataLineString::pack( QDataStream& stream ) const
     stream << size();
     stream << (qint32)(d->m_tessellationFlags);
 
+    d->unpackCoordinates();
     for( QVector<GeoDataCoordinates>::const_iterator iterator
           = d->m_vector.constBegin();
          iterator != d->m_vector.constEnd();
          ++iterator ) {
-        mDebug() << "innerRing: size" << d->m_vector.size();
-        GeoDataCoordinates coord = ( *iterator );
-        coord.pack( stream );
+        iterator->pack( stream );
     }
 
 }
@@ -954,9 +1033,10 @@ void GeoDataLineString::unpack( QDataStream& stream )
 
     d->m_tessellationFlags = (TessellationFlags)(tessellationFlags);
 
+    d->unpackCoordinates();
     d->m_vector.reserve(d->m_vector.size() + size);
 
-    for(qint32 i = 0; i < size; i++ ) {
+    for(qint32 i = 0; i < size && stream.status() == QDataStream::Ok; i++ ) {
         GeoDataCoordinates coord;
         coord.unpack( stream );
         d->m_vector.append( coord );
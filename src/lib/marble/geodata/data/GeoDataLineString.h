@@ -26,6 +26,7 @@ namespace Marble
 {
 class GeoDataCoordinates;
 class GeoDataLineStringPrivate;
+class GeoDataPackedCoordinates;
 
 /*!
     \class GeoDataLineString
@@ -384,6 +385,32 @@ class GEODATA_EXPORT GeoDataLineString : public GeoDataGeometry
     */
     GeoDataLineString optimized() const;
 
+/*!
+    \brief Stores the nodes as contiguous arrays instead of GeoDataCoordinates objects.
+
+    A packed LineString takes a fraction of the memory, and the projections
+    map its nodes in one pass over the arrays.  The API stays the same, but
+    handing out nodes by reference or by iterator, as well as any
+    modification, unpacks the LineString again.  Unpacking from const
+    methods is not thread-safe, like the bounding box cache.
+
+    \see packedCoordinates()
+*/
+    void setPacked( bool packed );
+
+/*!
+    \brief Returns whether the nodes are stored as contiguous arrays.
+*/
+    bool isPacked() const;
+
+/*!
+    \brief Returns the nodes as contiguous arrays.
+
+    The arrays are shared with a packed LineString, and copied from the
+    nodes of an unpacked one.
+*/
+    GeoDataPackedCoordinates packedCoordinates() const;
+
     // Serialization
 /*!
     \brief Serialize the LineString to a stream.
@@ -13,6 +13,7 @@
 
 #include "GeoDataGeometry_p.h"
 
+#include "GeoDataPackedCoordinates.h"
 #include "GeoDataTypes.h"
 
 namespace Marble
@@ -27,14 +28,16 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
            m_dirtyBox( true ),
            m_tessellationFlags( f ),
            m_previousResolution( -1 ),
-           m_level( -1 )
+           m_level( -1 ),
+           m_isPacked( false )
     {
     }
 
     GeoDataLineStringPrivate()
          : m_rangeCorrected( 0 ),
            m_dirtyRange( true ),
-           m_dirtyBox( true )
+           m_dirtyBox( true ),
+           m_isPacked( false )
     {
     }
 
@@ -47,6 +50,8 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
     {
         GeoDataGeometryPrivate::operator=( other );
         m_vector = other.m_vector;
+        m_packed = other.m_packed;
+        m_isPacked = other.m_isPacked;
         m_rangeCorrected = 0;
         m_dirtyRange = true;
         m_dirtyBox = other.m_dirtyBox;
@@ -81,6 +86,20 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
     qreal resolutionForLevel(int level) const;
     void optimize(GeoDataLineString& lineString) const;
 
+    /**
+     * Moves packed nodes back into m_vector, before they are handed out
+     * by reference or modified.  m_vector is not mutable, so that the
+     * const methods keep using its non-detaching accessors.
+     */
+    void unpackCoordinates() const
+    {
+        if ( m_isPacked ) {
+            const_cast<GeoDataLineStringPrivate *>( this )->m_vector = m_packed.toVector();
+            m_packed.clear();
+            m_isPacked = false;
+        }
+    }
+
     QVector<GeoDataCoordinates> m_vector;
 
     mutable GeoDataLineString*  m_rangeCorrected;
@@ -93,6 +112,10 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
     mutable qreal  m_previousResolution;
     mutable quint8 m_level;
 
+    // the nodes while the line string is packed, m_vector is empty then
+    mutable GeoDataPackedCoordinates m_packed;
+    mutable bool m_isPacked;
+
 };
 
 } // namespace Marble
@@ -224,12 +224,11 @@ void GeoDataListStyle::unpack( QDataStream& stream )
     int count;
     stream >> count;
 
-    int featureId;
-    stream >> featureId;
-
-    GeoDataItemIcon *itemIcon = new GeoDataItemIcon;
-    itemIcon->unpack( stream );
-    d->m_vector.append( itemIcon );
+    for ( int i = 0; i < count && stream.status() == QDataStream::Ok; ++i ) {
+        GeoDataItemIcon *itemIcon = new GeoDataItemIcon;
+        itemIcon->unpack( stream );
+        d->m_vector.append( itemIcon );
+    }
 }
 
 }
@@ -267,7 +267,7 @@ void GeoDataMultiGeometry::unpack( QDataStream& stream )
     
     stream >> size;
     
-    for( int i = 0; i < size; i++ ) {
+    for( int i = 0; i < size && stream.status() == QDataStream::Ok; i++ ) {
         int geometryId;
         stream >> geometryId;
         switch( geometryId ) {
@@ -277,40 +277,42 @@ void GeoDataMultiGeometry::unpack( QDataStream& stream )
                 {
                 GeoDataPoint *point = new GeoDataPoint;
                 point->unpack( stream );
-                d->m_vector.append(point);
+                append(point);
                 }
                 break;
             case GeoDataLineStringId:
                 {
                 GeoDataLineString *lineString = new GeoDataLineString;
                 lineString->unpack( stream );
-                d->m_vector.append(lineString);
+                append(lineString);
                 }
                 break;
             case GeoDataLinearRingId:
                 {
                 GeoDataLinearRing *linearRing = new GeoDataLinearRing;
                 linearRing->unpack( stream );
-                d->m_vector.append(linearRing);
+                append(linearRing);
                 }
                 break;
             case GeoDataPolygonId:
                 {
                 GeoDataPolygon *polygon = new GeoDataPolygon;
                 polygon->unpack( stream );
-                d->m_vector.append(polygon);
+                append(polygon);
                 }
                 break;
             case GeoDataMultiGeometryId:
                 {
                 GeoDataMultiGeometry *multiGeometry = new GeoDataMultiGeometry;
                 multiGeometry->unpack( stream );
-                d->m_vector.append(multiGeometry);
+                append(multiGeometry);
                 }
                 break;
-            case GeoDataModelId:
+            default:
+                // the other geometries can't be unpacked, so the rest of the stream is lost
+                mDebug() << "Cannot unpack geometry" << geometryId;
+                stream.setStatus( QDataStream::ReadCorruptData );
                 break;
-            default: break;
         };
     }
 }
@@ -0,0 +1,117 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+
+#include "GeoDataPackedCoordinates.h"
+
+#include "GeoDataCoordinates.h"
+
+
+namespace Marble
+{
+
+GeoDataPackedCoordinates::GeoDataPackedCoordinates()
+{
+}
+
+GeoDataPackedCoordinates::GeoDataPackedCoordinates( const QVector<GeoDataCoordinates> &coordinates )
+{
+    reserve( coordinates.size() );
+    for ( const GeoDataCoordinates &node: coordinates ) {
+        append( node );
+    }
+}
+
+bool GeoDataPackedCoordinates::isEmpty() const
+{
+    return m_longitudes.isEmpty();
+}
+
+int GeoDataPackedCoordinates::size() const
+{
+    return m_longitudes.size();
+}
+
+void GeoDataPackedCoordinates::reserve( int size )
+{
+    m_longitudes.reserve( size );
+    m_latitudes.reserve( size );
+    m_details.reserve( size );
+}
+
+void GeoDataPackedCoordinates::clear()
+{
+    m_longitudes.clear();
+    m_latitudes.clear();
+    m_altitudes.clear();
+    m_details.clear();
+}
+
+void GeoDataPackedCoordinates::append( const GeoDataCoordinates &coordinates )
+{
+    const qreal altitude = coordinates.altitude();
+    if ( altitude != 0.0 && m_altitudes.isEmpty() ) {
+        m_altitudes.reserve( m_longitudes.capacity() );
+        m_altitudes.fill( 0.0, m_longitudes.size() );
+    }
+
+    qreal lon;
+    qreal lat;
+    coordinates.geoCoordinates( lon, lat );
+    m_longitudes.append( lon );
+    m_latitudes.append( lat );
+    m_details.append( coordinates.detail() );
+    if ( !m_altitudes.isEmpty() ) {
+        m_altitudes.append( altitude );
+    }
+}
+
+GeoDataCoordinates GeoDataPackedCoordinates::at( int pos ) const
+{
+    return GeoDataCoordinates( m_longitudes.at( pos ), m_latitudes.at( pos ),
+                               m_altitudes.isEmpty() ? 0.0 : m_altitudes.at( pos ),
+                               GeoDataCoordinates::Radian, m_details.at( pos ) );
+}
+
+QVector<GeoDataCoordinates> GeoDataPackedCoordinates::toVector() const
+{
+    QVector<GeoDataCoordinates> result;
+    result.reserve( size() );
+    for ( int i = 0; i < size(); ++i ) {
+        result.append( at( i ) );
+    }
+    return result;
+}
+
+const qreal *GeoDataPackedCoordinates::longitudes() const
+{
+    return m_longitudes.constData();
+}
+
+const qreal *GeoDataPackedCoordinates::latitudes() const
+{
+    return m_latitudes.constData();
+}
+
+const qreal *GeoDataPackedCoordinates::altitudes() const
+{
+    return m_altitudes.isEmpty() ? 0 : m_altitudes.constData();
+}
+
+const quint8 *GeoDataPackedCoordinates::details() const
+{
+    return m_details.constData();
+}
+
+qint64 GeoDataPackedCoordinates::memoryUsage() const
+{
+    return qint64( m_longitudes.capacity() + m_latitudes.capacity() + m_altitudes.capacity() ) * sizeof( qreal )
+           + m_details.capacity() * sizeof( quint8 );
+}
+
+}
@@ -0,0 +1,86 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+
+#ifndef MARBLE_GEODATAPACKEDCOORDINATES_H
+#define MARBLE_GEODATAPACKEDCOORDINATES_H
+
+
+#include "geodata_export.h"
+
+#include <QVector>
+
+
+namespace Marble
+{
+
+class GeoDataCoordinates;
+
+/*!
+    \class GeoDataPackedCoordinates
+    \brief Nodes of a line string stored as contiguous arrays.
+
+    Each node takes the longitude and the latitude in radians, and one byte for
+    the detail level.  Altitudes are only stored once a node has a non-zero
+    altitude, so altitudes() is 0 for line strings on the ground.
+
+    The arrays are implicitly shared and can be passed on to
+    AbstractProjection::screenCoordinates() as they are.
+
+    \see GeoDataLineString::setPacked()
+*/
+class GEODATA_EXPORT GeoDataPackedCoordinates
+{
+ public:
+    GeoDataPackedCoordinates();
+
+    explicit GeoDataPackedCoordinates( const QVector<GeoDataCoordinates> &coordinates );
+
+    bool isEmpty() const;
+
+    int size() const;
+
+    void reserve( int size );
+
+    void clear();
+
+    void append( const GeoDataCoordinates &coordinates );
+
+    /*!
+        \brief Returns the node at @p pos as a new GeoDataCoordinates object.
+    */
+    GeoDataCoordinates at( int pos ) const;
+
+    QVector<GeoDataCoordinates> toVector() const;
+
+    const qreal *longitudes() const;
+
+    const qreal *latitudes() const;
+
+    /*!
+        \brief Returns the altitudes in meters, or 0 if all nodes are on the ground.
+    */
+    const qreal *altitudes() const;
+
+    const quint8 *details() const;
+
+    /*!
+        \brief Returns the heap memory taken by the arrays, in bytes.
+    */
+    qint64 memoryUsage() const;
+
+ private:
+    QVector<qreal> m_longitudes;
+    QVector<qreal> m_latitudes;
+    QVector<qreal> m_altitudes;
+    QVector<quint8> m_details;
+};
+
+}
+
+#endif
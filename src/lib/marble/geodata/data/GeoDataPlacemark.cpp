@@ -811,7 +811,10 @@ void GeoDataPlacemark::pack( QDataStream& stream ) const
 
     stream << d->placemarkExtendedData().m_countrycode;
     stream << d->placemarkExtendedData().m_area;
+    stream << d->placemarkExtendedData().m_state;
+    stream << d->placemarkExtendedData().m_isBalloonVisible;
     stream << d->m_population;
+    stream << int( d->m_visualCategory );
     if (d->m_geometry) {
         stream << d->m_geometry->geometryId();
         d->m_geometry->pack( stream );
@@ -841,9 +844,19 @@ void GeoDataPlacemark::unpack( QDataStream& stream )
     Q_D(GeoDataPlacemark);
     GeoDataFeature::unpack( stream );
 
-    stream >> d->placemarkExtendedData().m_countrycode;
-    stream >> d->placemarkExtendedData().m_area;
+    GeoDataPlacemarkExtendedData extendedData;
+    stream >> extendedData.m_countrycode;
+    stream >> extendedData.m_area;
+    stream >> extendedData.m_state;
+    stream >> extendedData.m_isBalloonVisible;
+    // most placemarks don't have any of them, so don't create them needlessly
+    if ( !( extendedData == GeoDataPlacemarkPrivate::s_nullPlacemarkExtendedData ) || extendedData.m_isBalloonVisible ) {
+        d->placemarkExtendedData() = extendedData;
+    }
     stream >> d->m_population;
+    int visualCategory;
+    stream >> visualCategory;
+    d->m_visualCategory = GeoDataVisualCategory( visualCategory );
     int geometryId;
     stream >> geometryId;
     GeoDataGeometry *geometry = nullptr;
@@ -885,9 +898,11 @@ void GeoDataPlacemark::unpack( QDataStream& stream )
             geometry = multiGeometry;
             }
             break;
-        case GeoDataModelId:
+        default:
+            // the other geometries can't be unpacked, so the rest of the stream is lost
+            mDebug() << "Cannot unpack geometry" << geometryId;
+            stream.setStatus( QDataStream::ReadCorruptData );
             break;
-        default: break;
     };
     if (geometry) {
        delete d->m_geometry;
@@ -205,14 +205,13 @@ void GeoDataPolygon::pack( QDataStream& stream ) const
 
     stream << d->inner.size();
     stream << (qint32)(d->m_tessellationFlags);
-   
-    for( QVector<GeoDataLinearRing>::const_iterator iterator 
+    stream << d->m_renderOrder;
+
+    for( QVector<GeoDataLinearRing>::const_iterator iterator
           = d->inner.constBegin();
          iterator != d->inner.constEnd();
          ++iterator ) {
-        mDebug() << "innerRing: size" << d->inner.size();
-        GeoDataLinearRing linearRing = ( *iterator );
-        linearRing.pack( stream );
+        iterator->pack( stream );
     }
 }
 
@@ -231,12 +230,13 @@ void GeoDataPolygon::unpack( QDataStream& stream )
 
     stream >> size;
     stream >> tessellationFlags;
+    stream >> d->m_renderOrder;
 
     d->m_tessellationFlags = (TessellationFlags)(tessellationFlags);
 
     QVector<GeoDataLinearRing> &inner = d->inner;
     inner.reserve(inner.size() + size);
-    for(qint32 i = 0; i < size; i++ ) {
+    for(qint32 i = 0; i < size && stream.status() == QDataStream::Ok; i++ ) {
         GeoDataLinearRing linearRing;
         linearRing.unpack( stream );
         inner.append(linearRing);
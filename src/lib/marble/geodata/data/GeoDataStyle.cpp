@@ -214,8 +214,8 @@ void GeoDataStyle::unpack( QDataStream& stream )
 
     d->m_iconStyle.unpack( stream );
     d->m_labelStyle.unpack( stream );
-    d->m_lineStyle.unpack( stream );
     d->m_polyStyle.unpack( stream );
+    d->m_lineStyle.unpack( stream );
     d->m_balloonStyle.unpack( stream );
     d->m_listStyle.unpack( stream );
 }
@@ -19,9 +19,10 @@
 #include "GeoDataLineString.h"
 #include "GeoDataExtendedData.h"
 
-#include <QMap>
 #include <QDateTime>
 
+#include <algorithm>
+
 namespace Marble {
 
 class GeoDataTrackPrivate : public GeoDataGeometryPrivate
@@ -29,7 +30,11 @@ class GeoDataTrackPrivate : public GeoDataGeometryPrivate
 public:
     GeoDataTrackPrivate()
         : m_lineStringNeedsUpdate( false ),
-          m_interpolate( false )
+          m_interpolate( false ),
+          m_whenOrdered( true ),
+          m_timeIndexNeedsUpdate( false ),
+          m_segment( -1 ),
+          m_segmentEnd( -1 )
     {
     }
 
@@ -41,9 +46,20 @@ public:
         while ( m_when.size() < m_coordinates.size() ) {
             //fill coordinates without time information with null QDateTime
             m_when.append( QDateTime() );
+            m_whenOrdered = false;
         }
     }
 
+    void invalidateTimeIndex()
+    {
+        m_timeIndexNeedsUpdate = true;
+        m_segment = -1;
+    }
+
+    void updateTimeIndex() const;
+    bool appendToTimeIndex( const QDateTime &when, int index );
+    GeoDataCoordinates interpolate( int segment, int segmentEnd, qint64 time ) const;
+
     mutable GeoDataLineString m_lineString;
     mutable bool m_lineStringNeedsUpdate;
 
@@ -52,9 +68,105 @@ public:
     QVector<QDateTime> m_when;
     QVector<GeoDataCoordinates> m_coordinates;
 
+    /**
+     * True if m_when holds valid, non-decreasing times only, so that points
+     * can be inserted by binary search.
+     */
+    bool m_whenOrdered;
+
+    /**
+     * The valid times of the points with coordinates in milliseconds since the epoch,
+     * sorted by time and then by index, and the index of each point.
+     */
+    mutable QVector<qint64> m_times;
+    mutable QVector<int> m_timeIndices;
+    mutable bool m_timeIndexNeedsUpdate;
+
+    /**
+     * The positions in m_times of the segment coordinatesAt() interpolated last,
+     * and the quaternions of its ends.
+     */
+    mutable int m_segment;
+    mutable int m_segmentEnd;
+    mutable Quaternion m_segmentStartQuaternion;
+    mutable Quaternion m_segmentEndQuaternion;
+
     GeoDataExtendedData m_extendedData;
 };
 
+void GeoDataTrackPrivate::updateTimeIndex() const
+{
+    if ( !m_timeIndexNeedsUpdate ) {
+        return;
+    }
+
+    const int size = qMin( m_when.size(), m_coordinates.size() );
+    m_times.clear();
+    m_timeIndices.clear();
+    m_times.reserve( size );
+    m_timeIndices.reserve( size );
+    bool sorted = true;
+    for ( int i = 0; i < size; ++i ) {
+        if ( m_when.at( i ).isValid() ) {
+            const qint64 time = m_when.at( i ).toMSecsSinceEpoch();
+            sorted = sorted && ( m_times.isEmpty() || m_times.last() <= time );
+            m_times.append( time );
+            m_timeIndices.append( i );
+        }
+    }
+
+    if ( !sorted ) {
+        std::stable_sort( m_timeIndices.begin(), m_timeIndices.end(), [this]( int a, int b ) {
+            return m_when.at( a ) < m_when.at( b );
+        } );
+        for ( int i = 0; i < m_timeIndices.size(); ++i ) {
+            m_times[i] = m_when.at( m_timeIndices.at( i ) ).toMSecsSinceEpoch();
+        }
+    }
+
+    m_timeIndexNeedsUpdate = false;
+    m_segment = -1;
+}
+
+bool GeoDataTrackPrivate::appendToTimeIndex( const QDateTime &when, int index )
+{
+    if ( m_timeIndexNeedsUpdate || !when.isValid() ) {
+        return false;
+    }
+
+    const qint64 time = when.toMSecsSinceEpoch();
+    if ( !m_times.isEmpty() && m_times.last() > time ) {
+        return false;
+    }
+
+    m_times.append( time );
+    m_timeIndices.append( index );
+    return true;
+}
+
+GeoDataCoordinates GeoDataTrackPrivate::interpolate( int segment, int segmentEnd, qint64 time ) const
+{
+    const GeoDataCoordinates &previousCoord = m_coordinates.at( m_timeIndices.at( segment ) );
+    const GeoDataCoordinates &nextCoord = m_coordinates.at( m_timeIndices.at( segmentEnd ) );
+    if ( segment != m_segment || segmentEnd != m_segmentEnd ) {
+        m_segment = segment;
+        m_segmentEnd = segmentEnd;
+        m_segmentStartQuaternion = previousCoord.quaternion();
+        m_segmentEndQuaternion = nextCoord.quaternion();
+    }
+
+    const qreal interval = m_times.at( segmentEnd ) - m_times.at( segment );
+    const qreal t = ( time - m_times.at( segment ) ) / interval;
+
+    const Quaternion interpolated = Quaternion::slerp( m_segmentStartQuaternion, m_segmentEndQuaternion, t );
+    qreal lon, lat;
+    interpolated.getSpherical( lon, lat );
+
+    qreal alt = previousCoord.altitude() + ( nextCoord.altitude() - previousCoord.altitude() ) * t;
+
+    return GeoDataCoordinates( lon, lat, alt );
+}
+
 GeoDataTrack::GeoDataTrack() :
     GeoDataGeometry( new GeoDataTrackPrivate() )
 {
@@ -169,57 +281,51 @@ GeoDataCoordinates GeoDataTrack::coordinatesAt( const QDateTime &when ) const
         return GeoDataCoordinates();
     }
 
-    if (d->m_when.contains(when)) {
-        //exact match found
+    if (!when.isValid()) {
+        // only points without time information can match
         const int index = d->m_when.indexOf(when);
-        if (index < d->m_coordinates.size()) {
+        if (index >= 0 && index < d->m_coordinates.size()) {
             return d->m_coordinates.at(index);
         }
+        return GeoDataCoordinates();
     }
 
-    if ( !interpolate() ) {
-        return GeoDataCoordinates();
+    d->updateTimeIndex();
+    const qint64 time = when.toMSecsSinceEpoch();
+
+    // consecutive calls for a playback usually fall into the same segment
+    if ( interpolate() && d->m_segment >= 0 &&
+         d->m_times.at( d->m_segment ) < time && time < d->m_times.at( d->m_segmentEnd ) ) {
+        return d->interpolate( d->m_segment, d->m_segmentEnd, time );
     }
 
-    typedef QMap<QDateTime, GeoDataCoordinates> PointMap;
-    PointMap pointMap;
-    for (int i = 0; i < qMin(d->m_when.size(), d->m_coordinates.size()); ++i) {
-        if (d->m_when.at(i).isValid()) {
-            pointMap[d->m_when.at(i)] = d->m_coordinates.at(i);
-        }
+    const QVector<qint64>::const_iterator begin = d->m_times.constBegin();
+    const QVector<qint64>::const_iterator end = d->m_times.constEnd();
+    const QVector<qint64>::const_iterator match = std::lower_bound( begin, end, time );
+    if ( match != end && *match == time ) {
+        //exact match found
+        return d->m_coordinates.at( d->m_timeIndices.at( match - begin ) );
     }
 
-    QMap<QDateTime, GeoDataCoordinates>::const_iterator nextEntry = const_cast<const PointMap&>(pointMap).upperBound( when );
+    if ( !interpolate() ) {
+        return GeoDataCoordinates();
+    }
 
     // No tracked point happened before "when"
-    if ( nextEntry == pointMap.constBegin() ) {
+    if ( match == begin ) {
         mDebug() << "No tracked point before " << when;
         return GeoDataCoordinates();
     }
 
-    if ( nextEntry == pointMap.constEnd() ) {
+    if ( match == end ) {
         mDebug() << "No track point after" << when;
         return GeoDataCoordinates();
     }
 
-    QMap<QDateTime, GeoDataCoordinates>::const_iterator previousEntry = nextEntry - 1;
-    GeoDataCoordinates previousCoord = previousEntry.value();
-
-    QDateTime previousWhen = previousEntry.key();
-    QDateTime nextWhen = nextEntry.key();
-    GeoDataCoordinates nextCoord = nextEntry.value();
-
-    int interval = previousWhen.msecsTo( nextWhen );
-    int position = previousWhen.msecsTo( when );
-    qreal t = (qreal)position / (qreal)interval;
-
-    const Quaternion interpolated = Quaternion::slerp( previousCoord.quaternion(), nextCoord.quaternion(), t );
-    qreal lon, lat;
-    interpolated.getSpherical( lon, lat );
-
-    qreal alt = previousCoord.altitude() + ( nextCoord.altitude() - previousCoord.altitude() ) * t;
-
-    return GeoDataCoordinates( lon, lat, alt );
+    // of several points at the same time, the last one wins
+    const int segment = match - begin - 1;
+    const int segmentEnd = std::upper_bound( match, end, *match ) - begin - 1;
+    return d->interpolate( segment, segmentEnd, time );
 }
 
 GeoDataCoordinates GeoDataTrack::coordinatesAt( int index ) const
@@ -234,16 +340,41 @@ void GeoDataTrack::addPoint( const QDateTime &when, const GeoDataCoordinates &co
 
     Q_D(GeoDataTrack);
     d->equalizeWhenSize();
-    d->m_lineStringNeedsUpdate = true;
-    int i=0;
-    while (i < d->m_when.size()) {
-        if (d->m_when.at(i) > when) {
-            break;
+    int i = d->m_when.size();
+    if (d->m_whenOrdered && when.isValid()) {
+        // in-order points are appended without a search
+        if (!d->m_when.isEmpty() && d->m_when.last() > when) {
+            i = std::upper_bound(d->m_when.constBegin(), d->m_when.constEnd(), when) - d->m_when.constBegin();
+        }
+    } else {
+        i = 0;
+        while (i < d->m_when.size()) {
+            if (d->m_when.at(i) > when) {
+                break;
+            }
+            ++i;
+        }
+    }
+    d->m_whenOrdered = d->m_whenOrdered && when.isValid();
+
+    if (i == d->m_when.size() && d->m_when.size() == d->m_coordinates.size()) {
+        d->m_when.append(when);
+        d->m_coordinates.append(coord);
+        if (!d->appendToTimeIndex(when, i)) {
+            d->invalidateTimeIndex();
+        }
+        // keep a line string that is in use up to date
+        if (!d->m_lineStringNeedsUpdate && !d->m_lineString.isEmpty()) {
+            d->m_lineString.append(coord);
+        } else {
+            d->m_lineStringNeedsUpdate = true;
         }
-        ++i;
+    } else {
+        d->m_when.insert(i, when );
+        d->m_coordinates.insert(i, coord );
+        d->invalidateTimeIndex();
+        d->m_lineStringNeedsUpdate = true;
     }
-    d->m_when.insert(i, when );
-    d->m_coordinates.insert(i, coord );
 }
 
 void GeoDataTrack::appendCoordinates( const GeoDataCoordinates &coord )
@@ -254,6 +385,7 @@ void GeoDataTrack::appendCoordinates( const GeoDataCoordinates &coord )
     d->equalizeWhenSize();
     d->m_lineStringNeedsUpdate = true;
     d->m_coordinates.append(coord);
+    d->invalidateTimeIndex();
 }
 
 void GeoDataTrack::appendAltitude( qreal altitude )
@@ -266,9 +398,8 @@ void GeoDataTrack::appendAltitude( qreal altitude )
     if (d->m_coordinates.isEmpty()) {
         return;
     }
-    GeoDataCoordinates coordinates = d->m_coordinates.takeLast();
-    coordinates.setAltitude( altitude );
-    d->m_coordinates.append(coordinates);
+    d->m_coordinates.last().setAltitude( altitude );
+    d->invalidateTimeIndex();
 }
 
 void GeoDataTrack::appendWhen( const QDateTime &when )
@@ -276,7 +407,10 @@ void GeoDataTrack::appendWhen( const QDateTime &when )
     detach();
 
     Q_D(GeoDataTrack);
+    d->m_whenOrdered = d->m_whenOrdered && when.isValid() &&
+                       (d->m_when.isEmpty() || d->m_when.last() <= when);
     d->m_when.append(when);
+    d->invalidateTimeIndex();
 }
 
 void GeoDataTrack::clear()
@@ -286,6 +420,8 @@ void GeoDataTrack::clear()
     Q_D(GeoDataTrack);
     d->m_when.clear();
     d->m_coordinates.clear();
+    d->m_whenOrdered = true;
+    d->invalidateTimeIndex();
     d->m_lineStringNeedsUpdate = true;
 }
 
@@ -300,9 +436,15 @@ void GeoDataTrack::removeBefore( const QDateTime &when )
     }
     d->equalizeWhenSize();
 
-    while (!d->m_when.isEmpty() && d->m_when.first() < when) {
-        d->m_when.takeFirst();
-        d->m_coordinates.takeFirst();
+    int count = 0;
+    while (count < d->m_when.size() && d->m_when.at(count) < when) {
+        ++count;
+    }
+    if (count > 0) {
+        d->m_when.remove(0, count);
+        d->m_coordinates.remove(0, count);
+        d->invalidateTimeIndex();
+        d->m_lineStringNeedsUpdate = true;
     }
 }
 
@@ -316,9 +458,15 @@ void GeoDataTrack::removeAfter( const QDateTime &when )
         return;
     }
     d->equalizeWhenSize();
-    while (!d->m_when.isEmpty() && d->m_when.last() > when) {
-        d->m_when.takeLast();
-        d->m_coordinates.takeLast();
+    int size = d->m_when.size();
+    while (size > 0 && d->m_when.at(size - 1) > when) {
+        --size;
+    }
+    if (size < d->m_when.size()) {
+        d->m_when.resize(size);
+        d->m_coordinates.resize(qMin(size, d->m_coordinates.size()));
+        d->invalidateTimeIndex();
+        d->m_lineStringNeedsUpdate = true;
     }
 }
 
@@ -73,25 +73,30 @@ void AbstractGeoPolygonGraphicsItem::paint( GeoPainter* painter, const ViewportP
 
     if (!isValid) return;
 
-    if ( m_polygon ) {
-        bool innerResolved = false;
-
-        for(auto const & ring : m_polygon->innerBoundaries()) {
-            if (viewport->resolves(ring.latLonAltBox(), 4)) {
-               innerResolved = true;
-               break;
+    if (!m_screenPolygons.update(viewport)) {
+        if ( m_polygon ) {
+            bool innerResolved = false;
+
+            for(auto const & ring : m_polygon->innerBoundaries()) {
+                if (viewport->resolves(ring.latLonAltBox(), 4)) {
+                   innerResolved = true;
+                   break;
+                }
             }
-        }
 
-        if (innerResolved) {
-            painter->drawPolygon(*m_polygon);
-        }
-        else {
-            painter->drawPolygon(m_polygon->outerBoundary());
+            if (innerResolved) {
+                painter->polygonsFromPolygon(*m_polygon, m_screenPolygons.polygons(), m_screenPolygons.outlines());
+            }
+            else {
+                painter->polygonsFromLineString(m_polygon->outerBoundary(), m_screenPolygons.polygons());
+            }
+        } else if ( m_ring ) {
+            painter->polygonsFromLineString(*m_ring, m_screenPolygons.polygons());
         }
-    } else if ( m_ring ) {
-        painter->drawPolygon( *m_ring );
+        m_screenPolygons.setViewport(viewport);
     }
+
+    painter->drawPolygons(m_screenPolygons.polygons(), m_screenPolygons.outlines());
 }
 
 bool AbstractGeoPolygonGraphicsItem::contains(const QPoint &screenPosition, const ViewportParams *viewport) const
@@ -12,6 +12,7 @@
 #define MARBLE_ABSTRACTGEOPOLYGONGRAPHICSITEM_H
 
 #include "GeoGraphicsItem.h"
+#include "ScreenPolygonCache.h"
 #include "marble_export.h"
 
 #include <QImage>
@@ -52,6 +53,7 @@ private:
 
     const GeoDataPolygon *const m_polygon;
     const GeoDataLinearRing *const m_ring;
+    ScreenPolygonCache m_screenPolygons;
 };
 
 }
@@ -123,6 +123,11 @@ QPointF BuildingGeoPolygonGraphicsItem::centroid(const QPolygonF &polygon, doubl
     return area != 0 ? centroid / (6.0*area) : polygon.boundingRect().center();
 }
 
+double BuildingGeoPolygonGraphicsItem::buildingHeight() const
+{
+    return m_buildingHeight;
+}
+
 QPointF BuildingGeoPolygonGraphicsItem::buildingOffset(const QPointF &point, const ViewportParams *viewport, bool* isCameraAboveBuilding) const
 {
     qreal const cameraFactor = 0.5 * tan(0.5 * 110 * DEG2RAD);
@@ -161,7 +166,7 @@ double BuildingGeoPolygonGraphicsItem::extractBuildingHeight(const GeoDataPlacem
 
     const OsmPlacemarkData &osmData = placemark.osmData();
 
-    QHash<QString, QString>::const_iterator tagIter;
+    OsmPlacemarkData::TagIterator tagIter;
     if ((tagIter = osmData.findTag(QStringLiteral("height"))) != osmData.tagsEnd()) {
         /** @todo Also parse non-SI units, see https://wiki.openstreetmap.org/wiki/Key:height#Height_of_buildings */
         QString const heightValue = QString(tagIter.value()).remove(QStringLiteral(" meters")).remove(QStringLiteral(" m"));
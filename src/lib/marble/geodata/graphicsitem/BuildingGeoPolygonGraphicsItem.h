@@ -29,6 +29,11 @@ public:
 public:
     void paint(GeoPainter* painter, const ViewportParams *viewport, const QString &layer, int tileZoomLevel) override;
 
+    /**
+     * Returns the height of the building in meters.
+     */
+    double buildingHeight() const;
+
 private:
     struct NamedEntry {
         GeoDataCoordinates point;
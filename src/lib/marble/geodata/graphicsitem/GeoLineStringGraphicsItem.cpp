@@ -55,7 +55,6 @@ GeoLineStringGraphicsItem::GeoLineStringGraphicsItem(const GeoDataPlacemark *pla
 
 GeoLineStringGraphicsItem::~GeoLineStringGraphicsItem()
 {
-    qDeleteAll(m_cachedPolygons);
 }
 
 
@@ -63,6 +62,8 @@ void GeoLineStringGraphicsItem::setLineString( const GeoDataLineString* lineStri
 {
     m_lineString = lineString;
     m_renderLineString = lineString;
+    m_screenPolygons.clear();
+    m_cachedRegion = QRegion();
 }
 
 const GeoDataLineString *GeoLineStringGraphicsItem::lineString() const
@@ -126,6 +127,8 @@ void GeoLineStringGraphicsItem::setMergedLineString(const GeoDataLineString &mer
 {
     m_mergedLineString = mergedLineString;
     m_renderLineString = mergedLineString.isEmpty() ? m_lineString : &m_mergedLineString;
+    m_screenPolygons.clear();
+    m_cachedRegion = QRegion();
 }
 
 const GeoDataLatLonAltBox& GeoLineStringGraphicsItem::latLonAltBox() const
@@ -138,41 +141,50 @@ void GeoLineStringGraphicsItem::paint(GeoPainter* painter, const ViewportParams*
     setRenderContext(RenderContext(tileLevel));
 
     if (layer.endsWith(QLatin1String("/outline"))) {
-        qDeleteAll(m_cachedPolygons);
-        m_cachedPolygons.clear();
-        m_cachedRegion = QRegion();
-        painter->polygonsFromLineString(*m_renderLineString, m_cachedPolygons);
-        if (m_cachedPolygons.empty()) {
+        updateScreenPolygons(painter, viewport);
+        if (m_screenPolygons.polygons().empty()) {
             return;
         }
         if (painter->mapQuality() == HighQuality || painter->mapQuality() == PrintQuality) {
             paintOutline(painter, viewport);
         }
     } else if (layer.endsWith(QLatin1String("/inline"))) {
-        if (m_cachedPolygons.empty()) {
+        if (m_screenPolygons.polygons().empty()) {
             return;
         }
         paintInline(painter, viewport);
     } else if (layer.endsWith(QLatin1String("/label"))) {
-        if (!m_cachedPolygons.empty()) {
+        if (!m_screenPolygons.polygons().empty()) {
             if (m_renderLabel) {
                 paintLabel(painter, viewport);
             }
         }
     } else {
-        qDeleteAll(m_cachedPolygons);
-        m_cachedPolygons.clear();
-        m_cachedRegion = QRegion();
-        painter->polygonsFromLineString(*m_renderLineString, m_cachedPolygons);
-        if (m_cachedPolygons.empty()) {
+        updateScreenPolygons(painter, viewport);
+        if (m_screenPolygons.polygons().empty()) {
             return;
         }
-        for(const QPolygonF* itPolygon: m_cachedPolygons) {
+        for(const QPolygonF* itPolygon: m_screenPolygons.polygons()) {
             painter->drawPolyline(*itPolygon);
         }
     }
 }
 
+void GeoLineStringGraphicsItem::updateScreenPolygons(GeoPainter *painter, const ViewportParams *viewport)
+{
+    bool moved = false;
+    if (m_screenPolygons.update(viewport, &moved)) {
+        if (moved) {
+            m_cachedRegion = QRegion();
+        }
+        return;
+    }
+
+    m_cachedRegion = QRegion();
+    painter->polygonsFromLineString(*m_renderLineString, m_screenPolygons.polygons());
+    m_screenPolygons.setViewport(viewport);
+}
+
 bool GeoLineStringGraphicsItem::contains(const QPoint &screenPosition, const ViewportParams *) const
 {
     if (m_penWidth <= 0.0) {
@@ -181,7 +193,7 @@ bool GeoLineStringGraphicsItem::contains(const QPoint &screenPosition, const Vie
 
     if (m_cachedRegion.isNull()) {
         QPainterPath painterPath;
-        for (auto polygon: m_cachedPolygons) {
+        for (auto polygon: m_screenPolygons.polygons()) {
             painterPath.addPolygon(*polygon);
         }
         QPainterPathStroker stroker;
@@ -260,7 +272,7 @@ void GeoLineStringGraphicsItem::paintInline(GeoPainter* painter, const ViewportP
     if (s_paintInline) {
       m_renderLabel = painter->pen().widthF() >= 6.0f;
       m_penWidth = painter->pen().widthF();
-      for(const QPolygonF* itPolygon: m_cachedPolygons) {
+      for(const QPolygonF* itPolygon: m_screenPolygons.polygons()) {
           painter->drawPolyline(*itPolygon);
       }
     }
@@ -278,7 +290,7 @@ void GeoLineStringGraphicsItem::paintOutline(GeoPainter *painter, const Viewport
     s_previousStyle = style().data();
 
     if (s_paintOutline) {
-        for(const QPolygonF* itPolygon: m_cachedPolygons) {
+        for(const QPolygonF* itPolygon: m_screenPolygons.polygons()) {
             painter->drawPolyline(*itPolygon);
         }
     }
@@ -305,7 +317,7 @@ void GeoLineStringGraphicsItem::paintLabel(GeoPainter *painter, const ViewportPa
         //painter->setBackgroundMode(Qt::OpaqueMode);
 
         const GeoDataLabelStyle& labelStyle = style->labelStyle();
-        painter->drawLabelsForPolygons(m_cachedPolygons, m_name, FollowLine,
+        painter->drawLabelsForPolygons(m_screenPolygons.polygons(), m_name, FollowLine,
                                labelStyle.paintedColor());
     }
 }
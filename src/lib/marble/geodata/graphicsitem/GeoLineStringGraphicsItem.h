@@ -15,6 +15,7 @@
 #include "GeoDataCoordinates.h"
 #include "GeoDataLineString.h"
 #include "MarbleGlobal.h"
+#include "ScreenPolygonCache.h"
 #include "marble_export.h"
 
 #include <QRegion>
@@ -50,6 +51,7 @@ protected:
     void handleRelationUpdate(const QVector<const GeoDataRelation *> &relations) override;
 
 private:
+    void updateScreenPolygons(GeoPainter *painter, const ViewportParams *viewport);
     void paintOutline(GeoPainter *painter, const ViewportParams *viewport) const;
     void paintInline(GeoPainter *painter, const ViewportParams *viewport);
     void paintLabel(GeoPainter *painter, const ViewportParams *viewport) const;
@@ -62,7 +64,7 @@ private:
     const GeoDataLineString *m_lineString;
     const GeoDataLineString *m_renderLineString;
     GeoDataLineString m_mergedLineString;
-    QVector<QPolygonF*> m_cachedPolygons;
+    ScreenPolygonCache m_screenPolygons;
     bool m_renderLabel;
     qreal m_penWidth;
     mutable QRegion m_cachedRegion;
@@ -40,6 +40,7 @@ const char dgmlAttr_colorize[]         = "colorize";
 const char dgmlAttr_colorMap[]         = "colorMap";
 const char dgmlAttr_checkable[]        = "checkable";
 const char dgmlAttr_connect[]          = "connect";
+const char dgmlAttr_container[]        = "container";
 const char dgmlAttr_expire[]           = "expire";
 const char dgmlAttr_feature[]          = "feature";
 const char dgmlAttr_format[]           = "format";
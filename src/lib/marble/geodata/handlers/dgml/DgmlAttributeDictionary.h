@@ -42,6 +42,7 @@ namespace dgml
     extern const char dgmlAttr_colorMap[];
     extern const char dgmlAttr_checkable[];
     extern const char dgmlAttr_connect[];
+    extern const char dgmlAttr_container[];
     extern const char dgmlAttr_expire[];
     extern const char dgmlAttr_feature[];
     extern const char dgmlAttr_format[];
@@ -71,6 +71,12 @@ GeoNode* DgmlStorageLayoutTagHandler::parse(GeoParser& parser) const
     // Attribute maximumTileLevel
     const QString tileLevels = parser.attribute( dgmlAttr_tileLevels ).trimmed();
 
+    // Attribute container, an MBTiles file holding all tiles
+    const QString container = parser.attribute( dgmlAttr_container ).trimmed();
+    if ( !container.isEmpty() && !container.endsWith( QLatin1String( ".mbtiles" ), Qt::CaseInsensitive ) ) {
+        mDebug() << "Ignoring tile container " << container << ", only .mbtiles files are supported.";
+    }
+
     // Checking for parent item
     GeoStackItem parentItem = parser.parentElement();
     if (parentItem.represents(dgmlTag_Texture) || parentItem.represents(dgmlTag_Vectortile)) {
@@ -106,6 +112,9 @@ GeoNode* DgmlStorageLayoutTagHandler::parse(GeoParser& parser) const
         texture->setMinimumTileLevel( minimumTileLevel );
         texture->setMaximumTileLevel( maximumTileLevel );
         texture->setTileLevels( tileLevels );
+        if ( container.endsWith( QLatin1String( ".mbtiles" ), Qt::CaseInsensitive ) ) {
+            texture->setContainer( container );
+        }
         texture->setStorageLayout( storageLayout );
         texture->setServerLayout( serverLayout );
     }
@@ -20,6 +20,7 @@
 #include "DownloadPolicy.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
+#include "MbTilesContainer.h"
 #include "ServerLayout.h"
 #include "TileId.h"
 
@@ -34,6 +35,7 @@ GeoSceneTileDataset::GeoSceneTileDataset( const QString& name )
       m_sourceDir(),
       m_installMap(),
       m_storageLayoutMode(Marble),
+      m_container(),
       m_serverLayout( new MarbleServerLayout( this ) ),
       m_levelZeroColumns( defaultLevelZeroColumns ),
       m_levelZeroRows( defaultLevelZeroRows ),
@@ -90,6 +92,25 @@ void GeoSceneTileDataset::setStorageLayout( const StorageLayout layout )
     m_storageLayoutMode = layout;
 }
 
+QString GeoSceneTileDataset::container() const
+{
+    return m_container;
+}
+
+void GeoSceneTileDataset::setContainer( const QString &container )
+{
+    m_container = container;
+}
+
+QString GeoSceneTileDataset::containerFileName() const
+{
+    if ( m_container.isEmpty() ) {
+        return QString();
+    }
+
+    return themeStr() + QLatin1Char('/') + m_container;
+}
+
 void GeoSceneTileDataset::setServerLayout( const ServerLayout *layout )
 {
     delete m_serverLayout;
@@ -183,10 +204,15 @@ const QSize GeoSceneTileDataset::tileSize() const
     if ( m_tileSize.isEmpty() ) {
         const TileId id( 0, 0, 0, 0 );
         QString const fileName = relativeTileFileName( id );
-        QFileInfo const dirInfo( fileName );
-        QString const path = dirInfo.isAbsolute() ? fileName : MarbleDirs::path( fileName );
 
-        QImage testTile( path );
+        QImage testTile;
+        if ( !m_container.isEmpty() ) {
+            testTile = QImage::fromData( MbTilesContainer::findTileData( fileName ) );
+        } else {
+            QFileInfo const dirInfo( fileName );
+            QString const path = dirInfo.isAbsolute() ? fileName : MarbleDirs::path( fileName );
+            testTile = QImage( path );
+        }
 
         if ( testTile.isNull() ) {
             mDebug() << "Tile size is missing in dgml and no base tile found in " << themeStr();
@@ -277,6 +303,18 @@ QString GeoSceneTileDataset::relativeTileFileName( const TileId &id ) const
 
     QString relFileName;
 
+    if ( !m_container.isEmpty() ) {
+        // Tiles inside a container are always addressed as z/x/y,
+        // see MbTilesContainer::splitTileFileName()
+        const int y = m_storageLayoutMode == GeoSceneTileDataset::TileMapService ? ( 1<<id.zoomLevel() ) - id.y() - 1 : id.y();
+        return QString( "%1/%2/%3/%4.%5" )
+            .arg( containerFileName() )
+            .arg( id.zoomLevel() )
+            .arg( id.x() )
+            .arg( y )
+            .arg( suffix );
+    }
+
     switch ( m_storageLayoutMode ) {
     case GeoSceneTileDataset::Marble:
         relFileName = QString( "%1/%2/%3/%3_%4.%5" )
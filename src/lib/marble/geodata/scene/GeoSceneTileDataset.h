@@ -59,6 +59,20 @@ class GEODATA_EXPORT GeoSceneTileDataset : public GeoSceneAbstractDataset
     StorageLayout storageLayout() const;
     void setStorageLayout( const StorageLayout );
 
+    /**
+     * The name of the MBTiles file inside the theme directory that holds
+     * the tiles, or an empty string if each tile is stored in a file of
+     * its own.
+     */
+    QString container() const;
+    void setContainer( const QString &container );
+
+    /**
+     * The MBTiles file relative to the data directories, empty if the
+     * tiles are not stored in a container.
+     */
+    QString containerFileName() const;
+
     void setServerLayout( const ServerLayout * );
     const ServerLayout *serverLayout() const;
 
@@ -114,6 +128,7 @@ class GEODATA_EXPORT GeoSceneTileDataset : public GeoSceneAbstractDataset
     QString m_sourceDir;
     QString m_installMap;
     StorageLayout m_storageLayoutMode;
+    QString m_container;
     const ServerLayout *m_serverLayout;
     int m_levelZeroColumns;
     int m_levelZeroRows;
@@ -49,6 +49,10 @@ bool DgmlTextureTagWriter::write(const GeoNode *node, GeoWriter& writer) const
         writer.writeAttribute( "levelZeroRows", QString::number( texture->levelZeroRows() ) );
         writer.writeAttribute( "mode", texture->serverLayout()->name() );
     }
+    if ( !texture->container().isEmpty() )
+    {
+        writer.writeAttribute( "container", texture->container() );
+    }
     writer.writeEndElement();
     
     if ( texture->downloadUrls().size() > 0 )
@@ -53,12 +53,17 @@
 #include "AbstractGeoPolygonGraphicsItem.h"
 #include "GeoLineStringGraphicsItem.h"
 #include "GeoDataRelation.h"
+#include "BuildingGeoPolygonGraphicsItem.h"
+#include "LatLonBoxGrid.h"
 
 // Qt
 #include <qmath.h>
 #include <QAbstractItemModel>
 #include <QModelIndex>
 
+#include <algorithm>
+#include <numeric>
+
 namespace Marble
 {
 class GeometryLayerPrivate
@@ -67,16 +72,16 @@ public:
     typedef QVector<GeoLineStringGraphicsItem*> OsmLineStringItems;
     typedef QSet<const GeoDataRelation *> Relations;
     typedef QHash<const GeoDataFeature *, Relations> FeatureRelationHash;
-    typedef QVector<GeoGraphicsItem*> GeoGraphicItems;
-
-    struct PaintFragments {
-        // Three lists for different z values
-        // A z value of 0 is default and used by the majority of items, so sorting
-        // can be avoided for it
-        QVector<GeoGraphicsItem*> negative; // subways
-        QVector<GeoGraphicsItem*> null;     // areas and roads
-        QVector<GeoGraphicsItem*> positive; // buildings
+
+    struct PaintFragment {
+        GeoGraphicsItem *item;
+        // Sort keys, taken when the item enters the cache. Items are painted
+        // by z value (subways below areas and roads below buildings) and
+        // then grouped by style for batch rendering
+        qreal zValue;
+        quintptr style;
     };
+    typedef QVector<PaintFragment> PaintFragments;
 
     explicit GeometryLayerPrivate(const QAbstractItemModel *model, const StyleBuilder *styleBuilder);
 
@@ -88,8 +93,14 @@ public:
     void updateTiledLineStrings(const GeoDataPlacemark *placemark, GeoLineStringGraphicsItem* lineStringItem);
     void updateTiledLineStrings(OsmLineStringItems &lineStringItems);
     void clearCache();
+    void updateCache(const GeoDataLatLonBox &box, int maxZoomLevel);
+    void addToCache(const QVector<GeoGraphicsItem*> &items);
+    void removeFromCache(const QSet<GeoGraphicsItem*> &items);
+    void removeFromCache(const GeoDataFeature *feature);
     bool showRelation(const GeoDataRelation* relation) const;
     void updateRelationVisibility();
+    void updateHitTestIndex();
+    QVector<int> hitTestCandidates(const QPoint &curpos, const ViewportParams *viewport);
 
     const QAbstractItemModel *const m_model;
     const StyleBuilder *const m_styleBuilder;
@@ -102,14 +113,25 @@ public:
     GeoGraphicsItem* m_lastFeatureAt;
 
     bool m_dirty;
-    int m_cachedItemCount;
-    QHash<QString, GeoGraphicItems> m_cachedPaintFragments;
+    // The items in view and what they paint in which layer. The cache is
+    // updated with the items entering and leaving the view only, unless
+    // the tile level changes.
+    QSet<GeoGraphicsItem*> m_cachedItems;
+    int m_cachedTileLevel;
+    QHash<QString, PaintFragments> m_cachedPaintFragments;
     typedef QPair<QString, GeoGraphicsItem*> LayerItem;
     QList<LayerItem> m_cachedDefaultLayer;
     QDateTime m_cachedDateTime;
     GeoDataLatLonBox m_cachedLatLonBox;
     QSet<qint64> m_highlightedRouteRelations;
     bool m_showPublicTransport;
+
+    // The items of m_cachedPaintFragments in the order hit tests visit them:
+    // topmost layer first, and within a layer the item painted last first
+    QVector<GeoGraphicsItem*> m_hitTestItems;
+    QVector<bool> m_hitTestLabels;
+    LatLonBoxGrid m_hitTestGrid;
+    bool m_hitTestIndexDirty;
 };
 
 GeometryLayerPrivate::GeometryLayerPrivate(const QAbstractItemModel *model, const StyleBuilder *styleBuilder) :
@@ -118,8 +140,9 @@ GeometryLayerPrivate::GeometryLayerPrivate(const QAbstractItemModel *model, cons
     m_tileLevel(0),
     m_lastFeatureAt(nullptr),
     m_dirty(true),
-    m_cachedItemCount(0),
-    m_showPublicTransport(false)
+    m_cachedTileLevel(-1),
+    m_showPublicTransport(false),
+    m_hitTestIndexDirty(true)
 {
 }
 
@@ -184,71 +207,19 @@ bool GeometryLayer::render(GeoPainter *painter, ViewportParams *viewport,
     }
 
     if (d->m_dirty) {
-        d->m_dirty = false;
-
         const int maxZoomLevel = qMin(d->m_tileLevel, d->m_styleBuilder->maximumZoomLevel());
-        auto const items = d->m_scene.items(box, maxZoomLevel);;
+        d->updateCache(box, maxZoomLevel);
         d->m_cachedLatLonBox = box;
         d->m_cachedDateTime = now;
-
-        d->m_cachedItemCount = items.size();
-        d->m_cachedDefaultLayer.clear();
-        d->m_cachedPaintFragments.clear();
-        QHash<QString, GeometryLayerPrivate::PaintFragments> paintFragments;
-        QSet<QString> const knownLayers = QSet<QString>::fromList(d->m_styleBuilder->renderOrder());
-        for (GeoGraphicsItem* item: items) {
-            QStringList paintLayers = item->paintLayers();
-            if (paintLayers.isEmpty()) {
-                mDebug() << item << " provides no paint layers, so I force one onto it.";
-                paintLayers << QString();
-            }
-            for (const auto &layer: paintLayers) {
-                if (knownLayers.contains(layer)) {
-                    GeometryLayerPrivate::PaintFragments &fragments = paintFragments[layer];
-                    double const zValue = item->zValue();
-                    // assign subway stations
-                    if (zValue == 0.0) {
-                        fragments.null << item;
-                        // assign areas and streets
-                    } else if (zValue < 0.0) {
-                        fragments.negative << item;
-                        // assign buildings
-                    } else {
-                        fragments.positive << item;
-                    }
-                } else {
-                    // assign symbols
-                    d->m_cachedDefaultLayer << GeometryLayerPrivate::LayerItem(layer, item);
-                    static QSet<QString> missingLayers;
-                    if (!missingLayers.contains(layer)) {
-                        mDebug() << "Missing layer " << layer << ", in render order, will render it on top";
-                        missingLayers << layer;
-                    }
-                }
-            }
-        }
-        // Sort each fragment by z-level
-        for (const QString &layer: d->m_styleBuilder->renderOrder()) {
-            GeometryLayerPrivate::PaintFragments & layerItems = paintFragments[layer];
-            std::sort(layerItems.negative.begin(), layerItems.negative.end(), GeoGraphicsItem::zValueLessThan);
-            // The idea here is that layerItems.null has most items and does not need to be sorted by z-value
-            // since they are all equal (=0). We do sort them by style pointer though for batch rendering
-            std::sort(layerItems.null.begin(), layerItems.null.end(), GeoGraphicsItem::styleLessThan);
-            std::sort(layerItems.positive.begin(), layerItems.positive.end(), GeoGraphicsItem::zValueAndStyleLessThan);
-            auto const count = layerItems.negative.size() + layerItems.null.size() + layerItems.positive.size();
-            d->m_cachedPaintFragments[layer].reserve(count);
-            d->m_cachedPaintFragments[layer] << layerItems.negative;
-            d->m_cachedPaintFragments[layer] << layerItems.null;
-            d->m_cachedPaintFragments[layer] << layerItems.positive;
-        }
+        d->m_dirty = false;
     }
 
     for (const QString &layer: d->m_styleBuilder->renderOrder()) {
-        auto & layerItems = d->m_cachedPaintFragments[layer];
+        auto const & layerItems = d->m_cachedPaintFragments[layer];
         AbstractGeoPolygonGraphicsItem::s_previousStyle = 0;
         GeoLineStringGraphicsItem::s_previousStyle = 0;
-        for (auto item: layerItems) {
-            item->paint(painter, viewport, layer, d->m_tileLevel);
+        for (auto const & fragment: layerItems) {
+            fragment.item->paint(painter, viewport, layer, d->m_tileLevel);
         }
     }
 
@@ -262,7 +233,7 @@ bool GeometryLayer::render(GeoPainter *painter, ViewportParams *viewport,
 
     painter->restore();
     d->m_runtimeTrace = QStringLiteral("Geometries: %1 Zoom: %2")
-                        .arg(d->m_cachedItemCount)
+                        .arg(d->m_cachedItems.size())
                         .arg(d->m_tileLevel);
     return true;
 }
@@ -283,23 +254,128 @@ bool GeometryLayer::hasFeatureAt(const QPoint &curpos, const ViewportParams *vie
         return true;
     }
 
-    auto const renderOrder = d->m_styleBuilder->renderOrder();
-    for (int i = renderOrder.size() - 1; i >= 0; --i) {
-        auto & layerItems = d->m_cachedPaintFragments[renderOrder[i]];
-        for (auto item : layerItems) {
-            if (item->contains(curpos, viewport)) {
-                d->m_lastFeatureAt = item;
-                return true;
-            }
+    for (int index : d->hitTestCandidates(curpos, viewport)) {
+        auto item = d->m_hitTestItems[index];
+        if (item->contains(curpos, viewport)) {
+            d->m_lastFeatureAt = item;
+            return true;
         }
     }
 
     return false;
 }
 
+// Pen widths given in meters are limited to 200 meters by the StyleBuilder
+static const qreal MaximumPhysicalLineWidth = 200.0;
+
+// Hits are detected up to this far off an item, e.g. on wide lines and icons
+static const int PickMargin = 32;
+
+static GeoDataLatLonBox expanded(const GeoDataLatLonBox &box, qreal margin)
+{
+    qreal const maxLatitude = qMax(qAbs(box.north()), qAbs(box.south()));
+    qreal const lonMargin = margin / qMax(0.01, qCos(maxLatitude));
+    return GeoDataLatLonBox(qMin(box.north() + margin, M_PI / 2),
+                            qMax(box.south() - margin, -M_PI / 2),
+                            qMin(box.east() + lonMargin, M_PI),
+                            qMax(box.west() - lonMargin, -M_PI));
+}
+
+/**
+ * Returns the box around the geographic area an item reacts to clicks in.
+ */
+static GeoDataLatLonBox hitTestBox(const GeoGraphicsItem *item)
+{
+    auto const & box = item->latLonAltBox();
+    if (auto building = dynamic_cast<const BuildingGeoPolygonGraphicsItem*>(item)) {
+        // Roofs are shifted away from the footprint, by less than the building height
+        if (!box.crossesDateLine()) {
+            return expanded(box, 2 * building->buildingHeight() / EARTH_RADIUS);
+        }
+    }
+    return box;
+}
+
+/**
+ * Determines a box containing the geographic area around the screen position
+ * @p curpos which items containing it can be in. Returns false if there is no
+ * simple such box, e.g. close to the horizon or the poles.
+ */
+static bool pickArea(const QPoint &curpos, const ViewportParams *viewport, GeoDataLatLonBox &area)
+{
+    qreal west = M_PI;
+    qreal east = -M_PI;
+    qreal south = M_PI / 2;
+    qreal north = -M_PI / 2;
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            qreal lon, lat;
+            if (!viewport->geoCoordinates(curpos.x() + dx * PickMargin, curpos.y() + dy * PickMargin,
+                                          lon, lat, GeoDataCoordinates::Radian)) {
+                return false;
+            }
+            west = qMin(west, lon);
+            east = qMax(east, lon);
+            south = qMin(south, lat);
+            north = qMax(north, lat);
+        }
+    }
+
+    if (east - west > M_PI) {
+        return false; // crosses the date line
+    }
+
+    // The projected pick square is not a rectangle in geographic coordinates,
+    // so leave some room around the corners it was sampled at
+    GeoDataLatLonBox const box(north, south, east, west);
+    qreal const margin = 0.25 * qMax(box.width(), box.height()) + 0.5 * MaximumPhysicalLineWidth / EARTH_RADIUS;
+    area = expanded(box, margin);
+    return area.north() < M_PI / 2 && area.south() > -M_PI / 2
+            && area.east() < M_PI && area.west() > -M_PI;
+}
+
+void GeometryLayerPrivate::updateHitTestIndex()
+{
+    if (!m_hitTestIndexDirty) {
+        return;
+    }
+    m_hitTestIndexDirty = false;
+
+    m_hitTestItems.clear();
+    m_hitTestLabels.clear();
+    QVector<GeoDataLatLonBox> boxes;
+    auto const renderOrder = m_styleBuilder->renderOrder();
+    QString const label = QStringLiteral("/label");
+    for (int i = renderOrder.size() - 1; i >= 0; --i) {
+        auto const & layerItems = m_cachedPaintFragments[renderOrder[i]];
+        bool const isLabel = renderOrder[i].endsWith(label);
+        for (auto j = layerItems.size() - 1; j >= 0; --j) {
+            m_hitTestItems << layerItems[j].item;
+            m_hitTestLabels << isLabel;
+            boxes << hitTestBox(layerItems[j].item);
+        }
+    }
+    m_hitTestGrid.build(m_cachedLatLonBox, boxes);
+}
+
+QVector<int> GeometryLayerPrivate::hitTestCandidates(const QPoint &curpos, const ViewportParams *viewport)
+{
+    updateHitTestIndex();
+
+    GeoDataLatLonBox area;
+    if (pickArea(curpos, viewport, area)) {
+        return m_hitTestGrid.candidates(area);
+    }
+
+    QVector<int> all(m_hitTestItems.size());
+    std::iota(all.begin(), all.end(), 0);
+    return all;
+}
+
 void GeometryLayerPrivate::createGraphicsItems(const GeoDataObject *object, FeatureRelationHash &relations)
 {
-    clearCache();
+    // the new items enter the cache on its next update
+    m_dirty = true;
     if (object->nodeType() == GeoDataTypes::GeoDataDocumentType) {
         auto document = static_cast<const GeoDataDocument*>(object);
         for (auto feature: document->featureList()) {
@@ -370,10 +446,160 @@ void GeometryLayerPrivate::clearCache()
     m_lastFeatureAt = nullptr;
     m_dirty = true;
     m_cachedDateTime = QDateTime();
-    m_cachedItemCount = 0;
+    m_cachedItems.clear();
+    m_cachedTileLevel = -1;
     m_cachedPaintFragments.clear();
     m_cachedDefaultLayer.clear();
     m_cachedLatLonBox = GeoDataLatLonBox();
+    m_hitTestItems.clear();
+    m_hitTestLabels.clear();
+    m_hitTestGrid.clear();
+    m_hitTestIndexDirty = true;
+}
+
+static bool paintFragmentLessThan(const GeometryLayerPrivate::PaintFragment &one,
+                                  const GeometryLayerPrivate::PaintFragment &two)
+{
+    if (one.zValue == two.zValue) {
+        return one.style < two.style;
+    }
+    return one.zValue < two.zValue;
+}
+
+void GeometryLayerPrivate::updateCache(const GeoDataLatLonBox &box, int maxZoomLevel)
+{
+    // The styles and thereby the order of the items depend on the tile level
+    if (m_cachedTileLevel != m_tileLevel) {
+        clearCache();
+        m_cachedTileLevel = m_tileLevel;
+    }
+
+    auto const items = m_scene.items(box, maxZoomLevel);
+    QSet<GeoGraphicsItem*> visibleItems;
+    visibleItems.reserve(items.size());
+    QVector<GeoGraphicsItem*> enteringItems;
+    for (auto item: items) {
+        if (visibleItems.contains(item)) {
+            continue; // boxes crossing the date line are queried in two parts
+        }
+        visibleItems.insert(item);
+        if (!m_cachedItems.contains(item)) {
+            enteringItems << item;
+        }
+    }
+
+    QSet<GeoGraphicsItem*> leavingItems;
+    if (visibleItems.size() - enteringItems.size() < m_cachedItems.size()) {
+        for (auto item: m_cachedItems) {
+            if (!visibleItems.contains(item)) {
+                leavingItems.insert(item);
+            }
+        }
+    }
+
+    m_cachedItems.swap(visibleItems);
+    removeFromCache(leavingItems);
+    addToCache(enteringItems);
+}
+
+void GeometryLayerPrivate::addToCache(const QVector<GeoGraphicsItem*> &items)
+{
+    if (items.isEmpty()) {
+        return;
+    }
+
+    QHash<QString, PaintFragments> newFragments;
+    QSet<QString> const knownLayers = QSet<QString>::fromList(m_styleBuilder->renderOrder());
+    for (GeoGraphicsItem* item: items) {
+        QStringList paintLayers = item->paintLayers();
+        if (paintLayers.isEmpty()) {
+            mDebug() << item << " provides no paint layers, so I force one onto it.";
+            paintLayers << QString();
+        }
+
+        // Line strings pick their style for the tile level they are painted at
+        if (auto lineStringItem = dynamic_cast<GeoLineStringGraphicsItem*>(item)) {
+            lineStringItem->setRenderContext(RenderContext(m_tileLevel));
+        }
+        PaintFragment const fragment = { item, item->zValue(), reinterpret_cast<quintptr>(item->style().data()) };
+
+        for (const auto &layer: paintLayers) {
+            if (knownLayers.contains(layer)) {
+                newFragments[layer] << fragment;
+            } else {
+                // assign symbols
+                m_cachedDefaultLayer << LayerItem(layer, item);
+                static QSet<QString> missingLayers;
+                if (!missingLayers.contains(layer)) {
+                    mDebug() << "Missing layer " << layer << ", in render order, will render it on top";
+                    missingLayers << layer;
+                }
+            }
+        }
+    }
+
+    // Only the new items need sorting, they get merged into the sorted cache
+    for (auto iter = newFragments.begin(); iter != newFragments.end(); ++iter) {
+        PaintFragments & newItems = iter.value();
+        std::sort(newItems.begin(), newItems.end(), paintFragmentLessThan);
+        PaintFragments & layerItems = m_cachedPaintFragments[iter.key()];
+        auto const count = layerItems.size();
+        layerItems << newItems;
+        std::inplace_merge(layerItems.begin(), layerItems.begin() + count, layerItems.end(), paintFragmentLessThan);
+    }
+
+    m_hitTestIndexDirty = true;
+}
+
+void GeometryLayerPrivate::removeFromCache(const QSet<GeoGraphicsItem*> &items)
+{
+    if (items.isEmpty()) {
+        return;
+    }
+
+    for (auto & layerItems: m_cachedPaintFragments) {
+        layerItems.erase(std::remove_if(layerItems.begin(), layerItems.end(),
+                                        [&items](const PaintFragment &fragment) {
+                                            return items.contains(fragment.item);
+                                        }),
+                         layerItems.end());
+    }
+    auto iter = m_cachedDefaultLayer.begin();
+    while (iter != m_cachedDefaultLayer.end()) {
+        iter = items.contains(iter->second) ? m_cachedDefaultLayer.erase(iter) : iter + 1;
+    }
+
+    if (items.contains(m_lastFeatureAt)) {
+        m_lastFeatureAt = nullptr;
+    }
+    m_hitTestIndexDirty = true;
+}
+
+static void collectFeatures(const GeoDataFeature *feature, QSet<const GeoDataFeature*> &features)
+{
+    features.insert(feature);
+    if (feature->nodeType() == GeoDataTypes::GeoDataFolderType
+            || feature->nodeType() == GeoDataTypes::GeoDataDocumentType) {
+        const GeoDataContainer *container = static_cast<const GeoDataContainer*>(feature);
+        for (const GeoDataFeature *child: container->featureList()) {
+            collectFeatures(child, features);
+        }
+    }
+}
+
+void GeometryLayerPrivate::removeFromCache(const GeoDataFeature *feature)
+{
+    QSet<const GeoDataFeature*> features;
+    collectFeatures(feature, features);
+
+    QSet<GeoGraphicsItem*> items;
+    for (auto item: m_cachedItems) {
+        if (features.contains(item->feature())) {
+            items.insert(item);
+        }
+    }
+    m_cachedItems.subtract(items);
+    removeFromCache(items);
 }
 
 inline bool GeometryLayerPrivate::showRelation(const GeoDataRelation *relation) const
@@ -400,6 +626,8 @@ void GeometryLayerPrivate::updateRelationVisibility()
         }
     }
     m_scene.resetStyle();
+    // the cached items are sorted by their old styles
+    clearCache();
 }
 
 void GeometryLayerPrivate::createGraphicsItemFromGeometry(const GeoDataGeometry* object, const GeoDataPlacemark *placemark, const Relations &relations)
@@ -476,7 +704,8 @@ void GeometryLayerPrivate::createGraphicsItemFromOverlay(const GeoDataOverlay *o
 
 void GeometryLayerPrivate::removeGraphicsItems(const GeoDataFeature *feature)
 {
-    clearCache();
+    // merged line strings may change visibility
+    m_dirty = true;
     if (feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType) {
         GeoDataPlacemark const * placemark = static_cast<GeoDataPlacemark const *>(feature);
         if (placemark->isGloballyVisible() &&
@@ -536,6 +765,7 @@ void GeometryLayer::removePlacemarks(const QModelIndex& parent, int first, int l
         const GeoDataObject *object = qvariant_cast<GeoDataObject*>(index.data(MarblePlacemarkModel::ObjectPointerRole));
         const GeoDataFeature *feature = dynamic_cast<const GeoDataFeature*>(object);
         if (feature != 0) {
+            d->removeFromCache(feature);
             d->removeGraphicsItems(feature);
             isRepaintNeeded = true;
         }
@@ -569,22 +799,17 @@ void GeometryLayer::setTileLevel(int tileLevel)
 QVector<const GeoDataFeature*> GeometryLayer::whichFeatureAt(const QPoint &curpos, const ViewportParams *viewport)
 {
     QVector<const GeoDataFeature*> result;
-    auto const renderOrder = d->m_styleBuilder->renderOrder();
-    QString const label = QStringLiteral("/label");
     QSet<GeoGraphicsItem*> checked;
-    for (int i = renderOrder.size()-1; i >= 0; --i) {
-        if (renderOrder[i].endsWith(label)) {
+    for (int index : d->hitTestCandidates(curpos, viewport)) {
+        if (d->m_hitTestLabels[index]) {
             continue;
         }
-        auto & layerItems = d->m_cachedPaintFragments[renderOrder[i]];
-        for (auto j = layerItems.size()-1; j >= 0; --j) {
-            auto const & layerItem = layerItems[j];
-            if (!checked.contains(layerItem)) {
-                if (layerItem->contains(curpos, viewport)) {
-                    result << layerItem->feature();
-                }
-                checked << layerItem;
+        auto const layerItem = d->m_hitTestItems[index];
+        if (!checked.contains(layerItem)) {
+            if (layerItem->contains(curpos, viewport)) {
+                result << layerItem->feature();
             }
+            checked << layerItem;
         }
     }
 
@@ -22,6 +22,7 @@
 #include "MercatorScanlineTextureMapper.h"
 #include "GenericScanlineTextureMapper.h"
 #include "TileScalingTextureMapper.h"
+#include "FrameProfiler.h"
 #include "GeoDataGroundOverlay.h"
 #include "GeoPainter.h"
 #include "GeoSceneGroup.h"
@@ -34,6 +35,7 @@
 #include "StackedTile.h"
 #include "StackedTileLoader.h"
 #include "SunLocator.h"
+#include "SunShading.h"
 #include "TextureColorizer.h"
 #include "TileLoader.h"
 #include "ViewportParams.h"
@@ -53,8 +55,17 @@ public:
              TextureLayer *parent );
 
     void requestDelayedRepaint();
+    void setRepaintNeeded();
     void updateTextureLayers();
     void updateTile( const TileId &tileId, const QImage &tileImage );
+    void updateSunPosition();
+
+    bool isSunShadingShown() const;
+    void renderSunShading( GeoPainter *painter, const ViewportParams *viewport, const QRect &dirtyRect );
+
+    static TextureMapperInterface *createTextureMapper( Projection projection,
+                                                        GeoSceneAbstractTileProjection::Type tileProjectionType,
+                                                        StackedTileLoader *tileLoader );
 
     void addGroundOverlays( const QModelIndex& parent, int first, int last );
     void removeGroundOverlays( const QModelIndex& parent, int first, int last );
@@ -71,9 +82,13 @@ public:
     TileLoader m_loader;
     MergedLayerDecorator m_layerDecorator;
     StackedTileLoader    m_tileLoader;
+    // The night layers, like city lights, shown on the night side by m_sunShading
+    MergedLayerDecorator m_nightLayerDecorator;
+    StackedTileLoader    m_nightTileLoader;
     GeoDataCoordinates m_centerCoordinates;
     int m_tileZoomLevel;
     TextureMapperInterface *m_texmapper;
+    TextureMapperInterface *m_nightTexmapper;
     TextureColorizer *m_texcolorizer;
     QVector<const GeoSceneTextureTileDataset *> m_textures;
     const GeoSceneGroup *m_textureLayerSettings;
@@ -81,6 +96,11 @@ public:
     QSortFilterProxyModel m_groundOverlayModel;
     QList<const GeoDataGroundOverlay *> m_groundOverlayCache;
     QMap<QString, GeoSceneTextureTileDataset *> m_customTextures;
+    bool m_showSunShading;
+    bool m_showCityLights;
+    SunShading m_sunShading;
+    QImage m_dayCanvas;
+    QImage m_nightCanvas;
     // For scheduling repaints
     QTimer           m_repaintTimer;
     RenderState m_renderState;
@@ -94,13 +114,18 @@ TextureLayer::Private::Private( HttpDownloadManager *downloadManager,
     : m_parent( parent )
     , m_sunLocator( sunLocator )
     , m_loader( downloadManager, pluginManager )
-    , m_layerDecorator( &m_loader, sunLocator )
+    , m_layerDecorator( &m_loader )
     , m_tileLoader( &m_layerDecorator )
+    , m_nightLayerDecorator( &m_loader )
+    , m_nightTileLoader( &m_nightLayerDecorator )
     , m_centerCoordinates()
     , m_tileZoomLevel( -1 )
     , m_texmapper( 0 )
+    , m_nightTexmapper( 0 )
     , m_texcolorizer( 0 )
     , m_textureLayerSettings( 0 )
+    , m_showSunShading( false )
+    , m_showCityLights( false )
     , m_repaintTimer()
 {
     m_groundOverlayModel.setSourceModel( groundOverlayModel );
@@ -125,18 +150,27 @@ TextureLayer::Private::Private( HttpDownloadManager *downloadManager,
 
 void TextureLayer::Private::requestDelayedRepaint()
 {
-    if ( m_texmapper ) {
-        m_texmapper->setRepaintNeeded();
-    }
+    setRepaintNeeded();
 
     if ( !m_repaintTimer.isActive() ) {
         m_repaintTimer.start();
     }
 }
 
+void TextureLayer::Private::setRepaintNeeded()
+{
+    if ( m_texmapper ) {
+        m_texmapper->setRepaintNeeded();
+    }
+    if ( m_nightTexmapper ) {
+        m_nightTexmapper->setRepaintNeeded();
+    }
+}
+
 void TextureLayer::Private::updateTextureLayers()
 {
     QVector<GeoSceneTextureTileDataset const *> result;
+    QVector<GeoSceneTextureTileDataset const *> nightLayers;
 
     for ( const GeoSceneTextureTileDataset *candidate: m_textures ) {
         bool enabled = true;
@@ -145,7 +179,16 @@ void TextureLayer::Private::updateTextureLayers()
             enabled |= !propertyExists; // if property doesn't exist, enable texture nevertheless
         }
         if ( enabled ) {
-            result.append( candidate );
+            // Sun light blended layers are not blended into the tiles, but
+            // shown on the night side of the map by the sun shading if city
+            // lights are enabled
+            if ( candidate->blending() == QLatin1String( "SunLightBlending" ) ) {
+                if ( m_showCityLights ) {
+                    nightLayers.append( candidate );
+                }
+            } else {
+                result.append( candidate );
+            }
             mDebug() << "enabling texture" << candidate->name();
         } else {
             mDebug() << "disabling texture" << candidate->name();
@@ -154,9 +197,16 @@ void TextureLayer::Private::updateTextureLayers()
 
     updateGroundOverlays();
 
+    m_tileLoader.cancelPendingLoads();
     m_layerDecorator.setTextureLayers( result );
     m_tileLoader.clear();
 
+    m_nightTileLoader.cancelPendingLoads();
+    m_nightLayerDecorator.setTextureLayers( nightLayers );
+    m_nightTileLoader.clear();
+    delete m_nightTexmapper;
+    m_nightTexmapper = 0;
+
     m_tileZoomLevel = -1;
     m_parent->setNeedsUpdate();
 }
@@ -167,10 +217,98 @@ void TextureLayer::Private::updateTile( const TileId &tileId, const QImage &tile
         return; // keep tiles in cache to improve performance
 
     m_tileLoader.updateTile( tileId, tileImage );
+    m_nightTileLoader.updateTile( tileId, tileImage );
 
     requestDelayedRepaint();
 }
 
+void TextureLayer::Private::updateSunPosition()
+{
+    // The tiles do not depend on the sun, just the shading painted on top of them
+    if ( isSunShadingShown() ) {
+        emit m_parent->repaintNeeded();
+    }
+}
+
+bool TextureLayer::Private::isSunShadingShown() const
+{
+    return m_showSunShading || m_nightLayerDecorator.textureLayersSize() > 0;
+}
+
+void TextureLayer::Private::renderSunShading( GeoPainter *painter, const ViewportParams *viewport, const QRect &dirtyRect )
+{
+    // The texture mappers paint onto canvases of their own here, which get
+    // shaded and then painted
+    if ( m_dayCanvas.size() != viewport->size() ) {
+        m_dayCanvas = QImage( viewport->size(), QImage::Format_ARGB32_Premultiplied );
+    }
+    if ( !viewport->mapCoversViewport() ) {
+        m_dayCanvas.fill( Qt::transparent );
+    }
+    {
+        const FrameProfilerScope scope( "TextureMapper::mapTexture" );
+        GeoPainter canvasPainter( &m_dayCanvas, viewport, painter->mapQuality() );
+        m_texmapper->mapTexture( &canvasPainter, viewport, m_tileZoomLevel, dirtyRect, m_texcolorizer );
+    }
+
+    const QImage *nightCanvas = 0;
+    if ( m_nightLayerDecorator.textureLayersSize() > 0 ) {
+        if ( !m_nightTexmapper ) {
+            m_nightTexmapper = createTextureMapper( viewport->projection(),
+                                                    m_nightLayerDecorator.tileProjection()->type(),
+                                                    &m_nightTileLoader );
+        }
+        if ( m_nightCanvas.size() != viewport->size() ) {
+            m_nightCanvas = QImage( viewport->size(), QImage::Format_ARGB32_Premultiplied );
+        }
+        if ( !viewport->mapCoversViewport() ) {
+            m_nightCanvas.fill( Qt::transparent );
+        }
+
+        const FrameProfilerScope scope( "TextureMapper::mapNightTexture" );
+        const int nightTileZoomLevel = qMin( m_nightLayerDecorator.maximumTileLevel(), m_tileZoomLevel );
+        GeoPainter canvasPainter( &m_nightCanvas, viewport, painter->mapQuality() );
+        m_nightTexmapper->mapTexture( &canvasPainter, viewport, nightTileZoomLevel, dirtyRect, 0 );
+        nightCanvas = &m_nightCanvas;
+    }
+
+    {
+        const FrameProfilerScope scope( "SunShading::shade" );
+        m_sunShading.setSunPosition( m_sunLocator->getLon() * DEG2RAD, m_sunLocator->getLat() * DEG2RAD );
+        m_sunShading.setTwilightZone( m_sunLocator->twilightZone() );
+        m_sunShading.shade( &m_dayCanvas, nightCanvas, viewport );
+    }
+
+    painter->drawImage( dirtyRect, m_dayCanvas, dirtyRect );
+}
+
+TextureMapperInterface *TextureLayer::Private::createTextureMapper( Projection projection,
+                                                                    GeoSceneAbstractTileProjection::Type tileProjectionType,
+                                                                    StackedTileLoader *tileLoader )
+{
+    // FIXME: replace this with an approach based on the factory method pattern.
+    switch( projection ) {
+        case Spherical:
+            return new SphericalScanlineTextureMapper( tileLoader );
+        case Equirectangular:
+            return new EquirectScanlineTextureMapper( tileLoader );
+        case Mercator:
+            if ( tileProjectionType == GeoSceneAbstractTileProjection::Mercator ) {
+                return new TileScalingTextureMapper( tileLoader );
+            } else {
+                return new MercatorScanlineTextureMapper( tileLoader );
+            }
+        case Gnomonic:
+        case Stereographic:
+        case LambertAzimuthal:
+        case AzimuthalEquidistant:
+        case VerticalPerspective:
+            return new GenericScanlineTextureMapper( tileLoader );
+        default:
+            return 0;
+    }
+}
+
 bool TextureLayer::Private::drawOrderLessThan( const GeoDataGroundOverlay* o1, const GeoDataGroundOverlay* o2 )
 {
     return o1->drawOrder() < o2->drawOrder();
@@ -223,6 +361,9 @@ void TextureLayer::Private::resetGroundOverlaysCache()
 
 void TextureLayer::Private::updateGroundOverlays()
 {
+    // tiles being loaded read the overlays of the decorator
+    m_tileLoader.cancelPendingLoads();
+
     if ( !m_texcolorizer ) {
         m_layerDecorator.updateGroundOverlays( m_groundOverlayCache );
     }
@@ -249,6 +390,12 @@ TextureLayer::TextureLayer( HttpDownloadManager *downloadManager,
 {
     connect( &d->m_loader, SIGNAL(tileCompleted(TileId,QImage)),
              this, SLOT(updateTile(TileId,QImage)) );
+    connect( &d->m_tileLoader, SIGNAL(repaintNeeded()),
+             this, SLOT(requestDelayedRepaint()) );
+    connect( &d->m_nightTileLoader, SIGNAL(repaintNeeded()),
+             this, SLOT(requestDelayedRepaint()) );
+    connect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
+             this, SLOT(updateSunPosition()) );
 
     // Repaint timer
     d->m_repaintTimer.setSingleShot( true );
@@ -261,6 +408,7 @@ TextureLayer::~TextureLayer()
 {
     qDeleteAll(d->m_customTextures);
     delete d->m_texmapper;
+    delete d->m_nightTexmapper;
     delete d->m_texcolorizer;
     delete d;
 }
@@ -293,12 +441,12 @@ int TextureLayer::textureLayerCount() const
 
 bool TextureLayer::showSunShading() const
 {
-    return d->m_layerDecorator.showSunShading();
+    return d->m_showSunShading;
 }
 
 bool TextureLayer::showCityLights() const
 {
-    return d->m_layerDecorator.showCityLights();
+    return d->m_showCityLights;
 }
 
 bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
@@ -325,7 +473,7 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
          d->m_centerCoordinates.latitude() != viewport->centerLatitude() ) {
         d->m_centerCoordinates.setLongitude( viewport->centerLongitude() );
         d->m_centerCoordinates.setLatitude( viewport->centerLatitude() );
-        d->m_texmapper->setRepaintNeeded();
+        d->setRepaintNeeded();
     }
 
     // choose the smaller dimension for selecting the tile level, leading to higher-resolution results
@@ -350,7 +498,13 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
     }
 
     const QRect dirtyRect = QRect( QPoint( 0, 0), viewport->size() );
-    d->m_texmapper->mapTexture( painter, viewport, d->m_tileZoomLevel, dirtyRect, d->m_texcolorizer );
+    if ( d->isSunShadingShown() ) {
+        d->renderSunShading( painter, viewport, dirtyRect );
+    } else {
+        const FrameProfilerScope scope( "TextureMapper::mapTexture" );
+        d->m_texmapper->mapTexture( painter, viewport, d->m_tileZoomLevel, dirtyRect, d->m_texcolorizer );
+    }
+    d->m_runtimeTrace += d->m_texmapper->runtimeTrace();
     d->m_renderState.addChild( d->m_tileLoader.renderState() );
     return true;
 }
@@ -369,28 +523,31 @@ void TextureLayer::setShowRelief( bool show )
 
 void TextureLayer::setShowSunShading( bool show )
 {
-    disconnect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
-                this, SLOT(reset()) );
+    d->m_showSunShading = show;
 
-    if ( show ) {
-        connect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
-                 this,       SLOT(reset()) );
+    if ( !d->isSunShadingShown() ) {
+        d->m_sunShading.clear();
+        d->m_dayCanvas = QImage();
+        d->m_nightCanvas = QImage();
     }
 
-    d->m_layerDecorator.setShowSunShading( show );
-
-    reset();
+    setNeedsUpdate();
 }
 
 void TextureLayer::setShowCityLights( bool show )
 {
-    d->m_layerDecorator.setShowCityLights( show );
+    if ( d->m_showCityLights == show ) {
+        return;
+    }
 
-    reset();
+    d->m_showCityLights = show;
+
+    d->updateTextureLayers();
 }
 
 void TextureLayer::setShowTileId( bool show )
 {
+    d->m_tileLoader.cancelPendingLoads();
     d->m_layerDecorator.setShowTileId( show );
 
     reset();
@@ -402,41 +559,18 @@ void TextureLayer::setProjection( Projection projection )
         return;
     }
 
-    // FIXME: replace this with an approach based on the factory method pattern.
     delete d->m_texmapper;
-
-    switch( projection ) {
-        case Spherical:
-            d->m_texmapper = new SphericalScanlineTextureMapper( &d->m_tileLoader );
-            break;
-        case Equirectangular:
-            d->m_texmapper = new EquirectScanlineTextureMapper( &d->m_tileLoader );
-            break;
-        case Mercator:
-            if (d->m_textures.at(0)->tileProjectionType() == GeoSceneAbstractTileProjection::Mercator) {
-                d->m_texmapper = new TileScalingTextureMapper( &d->m_tileLoader );
-            } else {
-                d->m_texmapper = new MercatorScanlineTextureMapper( &d->m_tileLoader );
-            }
-            break;
-        case Gnomonic:
-        case Stereographic:
-        case LambertAzimuthal:
-        case AzimuthalEquidistant:
-        case VerticalPerspective:
-            d->m_texmapper = new GenericScanlineTextureMapper( &d->m_tileLoader );
-            break;
-        default:
-            d->m_texmapper = 0;
-    }
+    d->m_texmapper = Private::createTextureMapper( projection, d->m_textures.at( 0 )->tileProjectionType(), &d->m_tileLoader );
     Q_ASSERT( d->m_texmapper );
+
+    // created for the night layers once they are rendered
+    delete d->m_nightTexmapper;
+    d->m_nightTexmapper = 0;
 }
 
 void TextureLayer::setNeedsUpdate()
 {
-    if ( d->m_texmapper ) {
-        d->m_texmapper->setRepaintNeeded();
-    }
+    d->setRepaintNeeded();
 
     emit repaintNeeded();
 }
@@ -444,11 +578,30 @@ void TextureLayer::setNeedsUpdate()
 void TextureLayer::setVolatileCacheLimit( quint64 kilobytes )
 {
     d->m_tileLoader.setVolatileCacheLimit( kilobytes );
+    d->m_nightTileLoader.setVolatileCacheLimit( kilobytes );
+}
+
+void TextureLayer::setAsynchronousTileLoading( bool asynchronous )
+{
+    d->m_tileLoader.setAsynchronous( asynchronous );
+    d->m_nightTileLoader.setAsynchronous( asynchronous );
+}
+
+bool TextureLayer::asynchronousTileLoading() const
+{
+    return d->m_tileLoader.isAsynchronous();
+}
+
+void TextureLayer::cancelPendingLoads()
+{
+    d->m_tileLoader.cancelPendingLoads();
+    d->m_nightTileLoader.cancelPendingLoads();
 }
 
 void TextureLayer::reset()
 {
     d->m_tileLoader.clear();
+    d->m_nightTileLoader.clear();
     setNeedsUpdate();
 }
 
@@ -460,6 +613,9 @@ void TextureLayer::reload()
         // allows for more connections (in our model), use "DownloadBrowse"
         d->m_layerDecorator.downloadStackedTile( id, DownloadBrowse );
     }
+    for ( const TileId &id: d->m_nightTileLoader.visibleTiles() ) {
+        d->m_nightLayerDecorator.downloadStackedTile( id, DownloadBrowse );
+    }
 }
 
 void TextureLayer::downloadStackedTile( const TileId &stackedTileId )
@@ -579,8 +735,9 @@ void TextureLayer::removeTextureLayer(const QString &key)
         GeoSceneTextureTileDataset *texture = d->m_customTextures.value(key);
         d->m_customTextures.remove(key);
         d->m_textures.remove(d->m_textures.indexOf(texture));
-        delete texture;
+        // the texture is in use until the decorator got the new layers
         d->updateTextureLayers();
+        delete texture;
     }
 }
 
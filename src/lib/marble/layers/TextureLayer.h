@@ -87,6 +87,8 @@ class MARBLE_EXPORT TextureLayer : public QObject, public LayerInterface
 
     quint64 volatileCacheLimit() const;
 
+    bool asynchronousTileLoading() const;
+
     int preferredRadiusCeil( int radius ) const;
     int preferredRadiusFloor( int radius ) const;
 
@@ -119,6 +121,15 @@ public Q_SLOTS:
 
     void setVolatileCacheLimit( quint64 kilobytes );
 
+    void setAsynchronousTileLoading( bool asynchronous );
+
+    /**
+     * @brief Waits for the tiles being loaded asynchronously and drops the queued ones.
+     *
+     * Has to be called before the texture datasets in use are deleted.
+     */
+    void cancelPendingLoads();
+
     void reset();
 
     void reload();
@@ -133,6 +144,7 @@ public Q_SLOTS:
     Q_PRIVATE_SLOT( d, void requestDelayedRepaint() )
     Q_PRIVATE_SLOT( d, void updateTextureLayers() )
     Q_PRIVATE_SLOT( d, void updateTile( const TileId &tileId, const QImage &tileImage ) )
+    Q_PRIVATE_SLOT( d, void updateSunPosition() )
     Q_PRIVATE_SLOT( d, void addGroundOverlays( const QModelIndex& parent, int first, int last ) )
     Q_PRIVATE_SLOT( d, void removeGroundOverlays( const QModelIndex& parent, int first, int last ) )
     Q_PRIVATE_SLOT( d, void resetGroundOverlaysCache() )
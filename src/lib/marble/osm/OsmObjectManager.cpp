@@ -18,9 +18,29 @@
 #include "GeoDataTypes.h"
 #include "osm/OsmPlacemarkData.h"
 
+#include <QThreadStorage>
+
 namespace Marble {
 
-qint64 OsmObjectManager::m_minId = -1;
+QAtomicInteger<qint64> OsmObjectManager::m_minId( -1 );
+
+namespace {
+
+struct LocalIds
+{
+    LocalIds() : active( false ), minId( -1 ) {}
+
+    bool active;
+    qint64 minId;
+};
+
+QThreadStorage<LocalIds> &localIds()
+{
+    static QThreadStorage<LocalIds> storage;
+    return storage;
+}
+
+}
 
 void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
 {
@@ -28,9 +48,9 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
 
     bool isNull = osmData.isNull();
     if ( isNull ) {
-        // The "--m_minId" assignments mean: assigning an id lower( by 1 ) than the current lowest,
-        // and updating the current lowest id.
-        osmData.setId( --m_minId );
+        // nextId() assigns an id lower( by 1 ) than the current lowest,
+        // and updates the current lowest id.
+        osmData.setId( nextId() );
     }
 
     // Assigning osmData to each of the line's nodes ( if they don't already have data )
@@ -41,7 +61,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
 
         for ( ; it != end; ++it ) {
             if (osmData.nodeReference(*it).isNull()) {
-                osmData.nodeReference(*it).setId(--m_minId);
+                osmData.nodeReference(*it).setId(nextId());
             }
         }
     }
@@ -51,7 +71,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
         const GeoDataLinearRing* lineString = static_cast<GeoDataLinearRing*>( placemark->geometry() );
         for (auto it =lineString->constBegin(), end = lineString->constEnd(); it != end; ++it ) {
             if (osmData.nodeReference(*it).isNull()) {
-                osmData.nodeReference(*it).setId(--m_minId);
+                osmData.nodeReference(*it).setId(nextId());
             }
         }
     }
@@ -69,7 +89,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
         // Outer boundary
         OsmPlacemarkData &outerBoundaryData = osmData.memberReference( index );
         if (outerBoundaryData.isNull()) {
-            outerBoundaryData.setId(--m_minId);
+            outerBoundaryData.setId(nextId());
         }
 
         // Outer boundary nodes
@@ -78,7 +98,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
 
         for ( ; it != end; ++it ) {
             if (outerBoundaryData.nodeReference(*it).isNull()) {
-                outerBoundaryData.nodeReference(*it).setId(--m_minId);
+                outerBoundaryData.nodeReference(*it).setId(nextId());
             }
         }
 
@@ -87,7 +107,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
             ++index;
             OsmPlacemarkData &innerRingData = osmData.memberReference( index );
             if (innerRingData.isNull()) {
-                innerRingData.setId(--m_minId);
+                innerRingData.setId(nextId());
             }
 
             // Inner boundary nodes
@@ -96,7 +116,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
 
             for ( ; it != end; ++it ) {
                 if (innerRingData.nodeReference(*it).isNull()) {
-                    innerRingData.nodeReference(*it).setId(--m_minId);
+                    innerRingData.nodeReference(*it).setId(nextId());
                 }
             }
         }
@@ -105,7 +125,40 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
 
 void OsmObjectManager::registerId( qint64 id )
 {
-    m_minId = qMin( id, m_minId );
+    // parsers register their ids from several threads at once
+    qint64 minId = m_minId.load();
+    while ( id < minId && !m_minId.testAndSetOrdered( minId, id, minId ) ) {
+    }
+
+    if ( localIds().hasLocalData() ) {
+        LocalIds &ids = localIds().localData();
+        if ( ids.active && id < ids.minId ) {
+            ids.minId = id;
+        }
+    }
+}
+
+void OsmObjectManager::beginLocalIds()
+{
+    LocalIds &ids = localIds().localData();
+    ids.active = true;
+    ids.minId = -1;
+}
+
+void OsmObjectManager::endLocalIds()
+{
+    localIds().localData().active = false;
+}
+
+qint64 OsmObjectManager::nextId()
+{
+    if ( localIds().hasLocalData() ) {
+        LocalIds &ids = localIds().localData();
+        if ( ids.active ) {
+            return --ids.minId;
+        }
+    }
+    return m_minId.fetchAndAddOrdered( -1 ) - 1;
 }
 
 }
@@ -12,6 +12,7 @@
 #define MARBLE_OSMOBJECTMANAGER_H
 
 #include <marble_export.h>
+#include <QAtomicInteger>
 #include <QtGlobal>
 
 namespace Marble
@@ -36,16 +37,37 @@ public:
 
     /**
      * @brief registerId is used to keep track of the minimum id @see m_minId
+     * While local ids are active, it lowers the minimum local id of the calling
+     * thread as well, so new objects never reuse the ids of the documents loaded.
      */
     static void registerId( qint64 id );
 
+    /**
+     * @brief beginLocalIds makes initializeOsmData() number the objects of the calling
+     * thread on their own, starting again at -1, until endLocalIds() is called.
+     *
+     * Tools writing each document to a file of its own use this to get the same
+     * ids in a document, no matter which documents were created before or in
+     * other threads at the same time.
+     */
+    static void beginLocalIds();
+    static void endLocalIds();
+
+    /**
+     * @brief nextId returns a new negative id, lower than all ids handed out or
+     * registered so far. These are local ids of the calling thread between
+     * beginLocalIds() and endLocalIds().
+     */
+    static qint64 nextId();
+
 private:
+
     /**
      * @brief newly created placemarks are assigned negative unique IDs.
      * In order to assure there are no duplicate IDs, they are assigned the
      * minId - 1 id.
      */
-    static qint64 m_minId;
+    static QAtomicInteger<qint64> m_minId;
 };
 
 }
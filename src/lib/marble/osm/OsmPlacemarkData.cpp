@@ -13,12 +13,38 @@
 
 // Marble
 #include "GeoDataExtendedData.h"
+#include "osm/OsmStringTable.h"
 
 #include <QXmlStreamAttributes>
 
+#include <algorithm>
+
 namespace Marble
 {
 
+namespace
+{
+
+enum ServerAttribute { Oid, Version, Changeset, Uid, Visible, User, Timestamp, Action };
+
+// the tag key ids of the server generated attributes
+int attributeKey( ServerAttribute attribute )
+{
+    static const int keys[] = {
+        OsmStringTable::intern(QStringLiteral("mx:oid")),
+        OsmStringTable::intern(QStringLiteral("mx:version")),
+        OsmStringTable::intern(QStringLiteral("mx:changeset")),
+        OsmStringTable::intern(QStringLiteral("mx:uid")),
+        OsmStringTable::intern(QStringLiteral("mx:visible")),
+        OsmStringTable::intern(QStringLiteral("mx:user")),
+        OsmStringTable::intern(QStringLiteral("mx:timestamp")),
+        OsmStringTable::intern(QStringLiteral("mx:action"))
+    };
+    return keys[attribute];
+}
+
+}
+
 OsmPlacemarkData::OsmPlacemarkData():
     m_id( 0 )
 {
@@ -32,43 +58,43 @@ qint64 OsmPlacemarkData::id() const
 
 qint64 OsmPlacemarkData::oid() const
 {
-    auto const value = m_tags.value(QStringLiteral("mx:oid")).toLong();
+    auto const value = tagValue(attributeKey(Oid)).toLong();
     return value > 0 ? value : m_id;
 }
 
 QString OsmPlacemarkData::changeset() const
 {
-    return m_tags.value(QStringLiteral("mx:changeset"));
+    return tagValue(attributeKey(Changeset));
 }
 
 QString OsmPlacemarkData::version() const
 {
-    return m_tags.value(QStringLiteral("mx:version"));
+    return tagValue(attributeKey(Version));
 }
 
 QString OsmPlacemarkData::uid() const
 {
-    return m_tags.value(QStringLiteral("mx:uid"));
+    return tagValue(attributeKey(Uid));
 }
 
 QString OsmPlacemarkData::isVisible() const
 {
-    return m_tags.value(QStringLiteral("mx:visible"));
+    return tagValue(attributeKey(Visible));
 }
 
 QString OsmPlacemarkData::user() const
 {
-    return m_tags.value(QStringLiteral("mx:user"));
+    return tagValue(attributeKey(User));
 }
 
 QString OsmPlacemarkData::timestamp() const
 {
-    return m_tags.value(QStringLiteral("mx:timestamp"));
+    return tagValue(attributeKey(Timestamp));
 }
 
 QString OsmPlacemarkData::action() const
 {
-    return m_tags.value(QStringLiteral("mx:action"));
+    return tagValue(attributeKey(Action));
 }
 
 void OsmPlacemarkData::setId( qint64 id )
@@ -78,85 +104,181 @@ void OsmPlacemarkData::setId( qint64 id )
 
 void OsmPlacemarkData::setVersion( const QString& version )
 {
-    m_tags[QStringLiteral("mx:version")] = version;
+    addTag(attributeKey(Version), OsmStringTable::intern(version));
 }
 
 void OsmPlacemarkData::setChangeset( const QString& changeset )
 {
-    m_tags[QStringLiteral("mx:changeset")] = changeset;
+    addTag(attributeKey(Changeset), OsmStringTable::intern(changeset));
 }
 
 void OsmPlacemarkData::setUid( const QString& uid )
 {
-    m_tags[QStringLiteral("mx:uid")] = uid;
+    addTag(attributeKey(Uid), OsmStringTable::intern(uid));
 }
 
 void OsmPlacemarkData::setVisible( const QString& visible )
 {
-    m_tags[QStringLiteral("mx:visible")] = visible;
+    addTag(attributeKey(Visible), OsmStringTable::intern(visible));
 }
 
 void OsmPlacemarkData::setUser( const QString& user )
 {
-   m_tags[QStringLiteral("mx:user")] = user;
+   addTag(attributeKey(User), OsmStringTable::intern(user));
 }
 
 void OsmPlacemarkData::setTimestamp( const QString& timestamp )
 {
-    m_tags[QStringLiteral("mx:timestamp")] = timestamp;
+    addTag(attributeKey(Timestamp), OsmStringTable::intern(timestamp));
 }
 
 void OsmPlacemarkData::setAction( const QString& action )
 {
-    m_tags[QStringLiteral("mx:action")] = action;
+    addTag(attributeKey(Action), OsmStringTable::intern(action));
+}
+
+
+
+OsmPlacemarkData::TagIterator::TagIterator() :
+    m_tag( nullptr )
+{
+    // nothing to do
+}
+
+OsmPlacemarkData::TagIterator::TagIterator( const QPair<int, int> *tag ) :
+    m_tag( tag )
+{
+    // nothing to do
 }
 
+const QString &OsmPlacemarkData::TagIterator::key() const
+{
+    return OsmStringTable::string( m_tag->first );
+}
 
+const QString &OsmPlacemarkData::TagIterator::value() const
+{
+    return OsmStringTable::string( m_tag->second );
+}
+
+int OsmPlacemarkData::TagIterator::keyId() const
+{
+    return m_tag->first;
+}
+
+int OsmPlacemarkData::TagIterator::valueId() const
+{
+    return m_tag->second;
+}
+
+OsmPlacemarkData::TagIterator &OsmPlacemarkData::TagIterator::operator++()
+{
+    ++m_tag;
+    return *this;
+}
+
+bool OsmPlacemarkData::TagIterator::operator==( const TagIterator &other ) const
+{
+    return m_tag == other.m_tag;
+}
+
+bool OsmPlacemarkData::TagIterator::operator!=( const TagIterator &other ) const
+{
+    return m_tag != other.m_tag;
+}
+
+const QPair<int, int> *OsmPlacemarkData::lowerBound( int key ) const
+{
+    return std::lower_bound( m_tags.constBegin(), m_tags.constEnd(), key,
+                             []( const QPair<int, int> &tag, int key ) { return tag.first < key; } );
+}
 
 QString OsmPlacemarkData::tagValue( const QString& key ) const
 {
-    return m_tags.value( key );
+    int const id = OsmStringTable::find( key );
+    return id < 0 ? QString() : tagValue( id );
+}
+
+QString OsmPlacemarkData::tagValue( int key ) const
+{
+    auto const iter = findTag( key );
+    return iter == tagsEnd() ? QString() : iter.value();
 }
 
 void OsmPlacemarkData::addTag( const QString& key, const QString& value )
 {
-    m_tags.insert( key, value );
+    addTag( OsmStringTable::intern( key ), OsmStringTable::intern( value ) );
+}
+
+void OsmPlacemarkData::addTag( int key, int value )
+{
+    int const index = lowerBound( key ) - m_tags.constBegin();
+    if ( index < m_tags.size() && m_tags.at( index ).first == key ) {
+        m_tags[index].second = value;
+    } else {
+        m_tags.insert( index, qMakePair( key, value ) );
+    }
 }
 
 void OsmPlacemarkData::removeTag( const QString &key )
 {
-    m_tags.remove( key );
+    auto const iter = findTag( key );
+    if ( iter != tagsEnd() ) {
+        m_tags.remove( iter.m_tag - m_tags.constBegin() );
+    }
 }
 
 bool OsmPlacemarkData::containsTag( const QString &key, const QString &value ) const
 {
-    auto const iter = m_tags.constFind(key);
-    return iter == m_tags.constEnd() ? false : iter.value() == value;
+    int const keyId = OsmStringTable::find( key );
+    int const valueId = OsmStringTable::find( value );
+    return keyId >= 0 && valueId >= 0 && containsTag( keyId, valueId );
 }
 
-bool OsmPlacemarkData::containsTagKey( const QString &key ) const
+bool OsmPlacemarkData::containsTag( int key, int value ) const
 {
-    return m_tags.contains( key );
+    auto const iter = lowerBound( key );
+    return iter != m_tags.constEnd() && iter->first == key && iter->second == value;
 }
 
-QHash<QString, QString>::const_iterator OsmPlacemarkData::findTag(const QString &key) const
+bool OsmPlacemarkData::containsTagKey( const QString &key ) const
 {
-    return m_tags.constFind(key);
+    int const id = OsmStringTable::find( key );
+    return id >= 0 && containsTagKey( id );
 }
 
-QHash< QString, QString >::const_iterator OsmPlacemarkData::tagsBegin() const
+bool OsmPlacemarkData::containsTagKey( int key ) const
 {
-    return m_tags.begin();
+    auto const iter = lowerBound( key );
+    return iter != m_tags.constEnd() && iter->first == key;
 }
 
-QHash< QString, QString >::const_iterator OsmPlacemarkData::tagsEnd() const
+OsmPlacemarkData::TagIterator OsmPlacemarkData::findTag(const QString &key) const
 {
-    return m_tags.constEnd();
+    int const id = OsmStringTable::find( key );
+    return id < 0 ? tagsEnd() : findTag( id );
 }
 
+OsmPlacemarkData::TagIterator OsmPlacemarkData::findTag( int key ) const
+{
+    auto const iter = lowerBound( key );
+    return iter != m_tags.constEnd() && iter->first == key ? TagIterator( iter ) : tagsEnd();
+}
 
+OsmPlacemarkData::TagIterator OsmPlacemarkData::tagsBegin() const
+{
+    return TagIterator( m_tags.constBegin() );
+}
 
+OsmPlacemarkData::TagIterator OsmPlacemarkData::tagsEnd() const
+{
+    return TagIterator( m_tags.constEnd() );
+}
 
+int OsmPlacemarkData::tagCount() const
+{
+    return m_tags.size();
+}
 
 OsmPlacemarkData &OsmPlacemarkData::nodeReference( const GeoDataCoordinates &coordinates )
 {
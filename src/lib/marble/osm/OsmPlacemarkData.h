@@ -14,7 +14,9 @@
 // Qt
 #include <QHash>
 #include <QMetaType>
+#include <QPair>
 #include <QString>
+#include <QVector>
 
 // Marble
 #include "GeoDataCoordinates.h"
@@ -29,7 +31,7 @@ namespace Marble
 /**
  * This class is used to encapsulate the osm data fields kept within a placemark's extendedData.
  * It stores OSM server generated data: id, version, changeset, uid, visible, user, timestamp;
- * It also stores a hash map of <tags> ( key-value mappings ) and a hash map of component osm
+ * It also stores a sorted list of interned <tags> ( key-value mappings ) and a hash map of component osm
  * placemarks @see m_nodeReferences @see m_memberReferences
  *
  * The usual workflow with osmData goes as follows:
@@ -74,11 +76,37 @@ public:
     void setAction( const QString& action );
 
 
+    /**
+     * @brief TagIterator iterates over the tags in the order of their key ids.
+     * Keys and values are interned in the OsmStringTable.
+     */
+    class MARBLE_EXPORT TagIterator
+    {
+    public:
+        TagIterator();
+
+        const QString &key() const;
+        const QString &value() const;
+        int keyId() const;
+        int valueId() const;
+
+        TagIterator &operator++();
+        bool operator==( const TagIterator &other ) const;
+        bool operator!=( const TagIterator &other ) const;
+
+    private:
+        friend class OsmPlacemarkData;
+        explicit TagIterator( const QPair<int, int> *tag );
+
+        const QPair<int, int> *m_tag;
+    };
+
     /**
      * @brief tagValue returns the value of the tag that has @p key as key
      * or an empty qstring if there is no such tag
      */
     QString tagValue( const QString &key ) const;
+    QString tagValue( int key ) const;
 
     /**
      * @brief addTag this function inserts a string key=value mapping,
@@ -86,35 +114,41 @@ public:
      * element
      */
     void addTag( const QString& key, const QString& value );
+    void addTag( int key, int value );
 
     /**
-     * @brief removeTag removes the tag from the tag hash
+     * @brief removeTag removes the tag from the tag list
      */
     void removeTag( const QString& key );
 
     /**
-     * @brief containsTag returns true if the tag hash contains an entry with
+     * @brief containsTag returns true if the tag list contains an entry with
      * the @p key as key and @p value as value
      */
     bool containsTag( const QString& key, const QString& value ) const;
+    bool containsTag( int key, int value ) const;
 
     /**
-     * @brief containsTagKey returns true if the tag hash contains an entry with
+     * @brief containsTagKey returns true if the tag list contains an entry with
      * the @p key as key
      */
     bool containsTagKey( const QString& key ) const;
+    bool containsTagKey( int key ) const;
 
     /**
-     * @brief tagValue returns a pointer to the tag that has @p key as key
+     * @brief findTag returns an iterator to the tag that has @p key as key
      * or the end iterator if there is no such tag
      */
-    QHash<QString, QString>::const_iterator findTag(const QString &key) const;
+    TagIterator findTag( const QString &key ) const;
+    TagIterator findTag( int key ) const;
 
     /**
-     * @brief iterators for the tags hash.
+     * @brief iterators for the tags.
      */
-    QHash< QString, QString >::const_iterator tagsBegin() const;
-    QHash< QString, QString >::const_iterator tagsEnd() const;
+    TagIterator tagsBegin() const;
+    TagIterator tagsEnd() const;
+
+    int tagCount() const;
 
 
     /**
@@ -200,8 +234,15 @@ public:
     static OsmPlacemarkData fromParserAttributes( const QXmlStreamAttributes &attributes );
 
 private:
+    const QPair<int, int> *lowerBound( int key ) const;
+
     qint64 m_id;
-    QHash<QString, QString> m_tags;
+
+    /**
+     * @brief m_tags holds the ( key, value ) ids of the tags in the OsmStringTable,
+     * sorted by key id
+     */
+    QVector<QPair<int, int> > m_tags;
 
     /**
      * @brief m_ndRefs is used to store a way's component nodes
@@ -0,0 +1,115 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "osm/OsmStringTable.h"
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QHash>
+#include <QReadWriteLock>
+
+namespace Marble
+{
+
+class OsmStringTableData
+{
+public:
+    OsmStringTableData();
+    ~OsmStringTableData();
+
+    // Strings live in fixed size chunks that never move, so references
+    // returned by OsmStringTable::string() stay valid while the table grows.
+    // The chunk slots are reserved up front and only ever filled, so that
+    // string() can read them without taking the lock.
+    enum { ChunkBits = 14, ChunkSize = 1 << ChunkBits, MaxChunks = 1 << 14 };
+
+    const QString &at( int id ) const;
+
+    QReadWriteLock m_lock;
+    QHash<QString, int> m_ids;
+    QAtomicPointer<QString> m_chunks[MaxChunks];
+    QAtomicInt m_size;
+};
+
+OsmStringTableData::OsmStringTableData() :
+    m_size( 0 )
+{
+    m_chunks[0].storeRelease( new QString[ChunkSize] );
+    m_ids.insert( QString(), 0 );
+    m_size.storeRelease( 1 );
+}
+
+OsmStringTableData::~OsmStringTableData()
+{
+    for ( int i = 0; i < MaxChunks; ++i ) {
+        delete[] m_chunks[i].load();
+    }
+}
+
+const QString &OsmStringTableData::at( int id ) const
+{
+    // the id was handed out by intern() after its string was stored
+    return m_chunks[id >> ChunkBits].loadAcquire()[id & ( ChunkSize - 1 )];
+}
+
+Q_GLOBAL_STATIC( OsmStringTableData, s_table )
+
+int OsmStringTable::intern( const QString &string )
+{
+    OsmStringTableData *const table = s_table();
+    {
+        QReadLocker locker( &table->m_lock );
+        auto const iter = table->m_ids.constFind( string );
+        if ( iter != table->m_ids.constEnd() ) {
+            return iter.value();
+        }
+    }
+
+    QWriteLocker locker( &table->m_lock );
+    auto const iter = table->m_ids.constFind( string );
+    if ( iter != table->m_ids.constEnd() ) {
+        return iter.value();
+    }
+
+    int const id = table->m_size.load();
+    int const chunk = id >> OsmStringTableData::ChunkBits;
+    if ( chunk >= OsmStringTableData::MaxChunks ) {
+        qFatal( "OsmStringTable: too many distinct strings" );
+    }
+    QString *entries = table->m_chunks[chunk].load();
+    if ( !entries ) {
+        entries = new QString[OsmStringTableData::ChunkSize];
+        table->m_chunks[chunk].storeRelease( entries );
+    }
+    QString &entry = entries[id & ( OsmStringTableData::ChunkSize - 1 )];
+    entry = string;
+    table->m_ids.insert( entry, id );
+    table->m_size.storeRelease( id + 1 );
+    return id;
+}
+
+int OsmStringTable::find( const QString &string )
+{
+    OsmStringTableData *const table = s_table();
+    QReadLocker locker( &table->m_lock );
+    return table->m_ids.value( string, -1 );
+}
+
+const QString &OsmStringTable::string( int id )
+{
+    OsmStringTableData *const table = s_table();
+    Q_ASSERT( id >= 0 && id < table->m_size.loadAcquire() );
+    return table->at( id );
+}
+
+int OsmStringTable::size()
+{
+    return s_table()->m_size.loadAcquire();
+}
+
+}
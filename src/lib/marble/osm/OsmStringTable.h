@@ -0,0 +1,53 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_OSMSTRINGTABLE_H
+#define MARBLE_OSMSTRINGTABLE_H
+
+#include <marble_export.h>
+
+#include <QString>
+
+namespace Marble
+{
+
+/**
+ * @brief The OsmStringTable class interns the keys and values of OSM tags
+ * process-wide, so that each distinct string is stored once and tags can be
+ * compared by their integer ids.
+ *
+ * Ids are stable for the lifetime of the process and strings are never
+ * released. The empty string always has the id 0. All functions are thread-safe.
+ */
+class MARBLE_EXPORT OsmStringTable
+{
+public:
+    /**
+     * @brief intern returns the id of @p string, adding it to the table if needed
+     */
+    static int intern( const QString &string );
+
+    /**
+     * @brief find returns the id of @p string, or -1 if it has never been interned
+     */
+    static int find( const QString &string );
+
+    /**
+     * @brief string returns the string with the given @p id
+     */
+    static const QString &string( int id );
+
+    /**
+     * @brief size returns the number of strings in the table
+     */
+    static int size();
+};
+
+}
+
+#endif
@@ -174,6 +174,18 @@ bool AbstractProjection::screenCoordinates( const GeoDataCoordinates &geopoint,
     return screenCoordinates( geopoint, viewport, x, y, globeHidesPoint );
 }
 
+void AbstractProjection::screenCoordinates( int count, const qreal *lon, const qreal *lat, const qreal *alt,
+                                            const ViewportParams *viewport,
+                                            qreal *x, qreal *y, bool *globeHidesPoint ) const
+{
+    // one object for all points, set() only allocates on the first call
+    GeoDataCoordinates geopoint;
+    for ( int i = 0; i < count; ++i ) {
+        geopoint.set( lon[i], lat[i], alt ? alt[i] : 0.0 );
+        screenCoordinates( geopoint, viewport, x[i], y[i], globeHidesPoint[i] );
+    }
+}
+
 GeoDataLatLonAltBox AbstractProjection::latLonAltBox( const QRect& screenRect,
                                                       const ViewportParams *viewport ) const
 {
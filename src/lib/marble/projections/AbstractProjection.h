@@ -227,6 +227,27 @@ class MARBLE_EXPORT AbstractProjection
                             const ViewportParams *viewport,
                             QVector<QPolygonF*> &polygons ) const = 0;
 
+    /**
+     * @brief Get the screen coordinates of many points in one pass.
+     *
+     * The arrays of GeoDataPackedCoordinates can be passed as they are.
+     *
+     * @param count  the number of points
+     * @param lon    the longitudes of the points in radians
+     * @param lat    the latitudes of the points in radians
+     * @param alt    the altitudes of the points in meters, or 0 for points on the ground
+     * @param viewport the viewport parameters
+     * @param x      the x coordinates of the pixels are returned through this array
+     * @param y      the y coordinates of the pixels are returned through this array
+     * @param globeHidesPoint  whether each point gets hidden on the far side of the
+     *                         earth; x and y are undefined for hidden points
+     *
+     * @see ViewportParams
+     */
+    virtual void screenCoordinates( int count, const qreal *lon, const qreal *lat, const qreal *alt,
+                                    const ViewportParams *viewport,
+                                    qreal *x, qreal *y, bool *globeHidesPoint ) const;
+
     /**
      * @brief Get the earth coordinates corresponding to a pixel in the map.
      * @param x      the x coordinate of the pixel
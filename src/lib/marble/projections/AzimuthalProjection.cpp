@@ -18,6 +18,7 @@
 #include "GeoDataLineString.h"
 #include "GeoDataCoordinates.h"
 #include "GeoDataLatLonAltBox.h"
+#include "GeoDataPackedCoordinates.h"
 #include "ViewportParams.h"
 
 #include <QPainterPath>
@@ -338,6 +339,9 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
     bool const tessellate = lineString.tessellate();
     const bool noFilter = f.testFlag(PreventNodeFiltering);
 
+    if ( lineString.isPacked() && !tessellate ) {
+        return packedLineStringToPolygon( lineString, viewport, polygons );
+    }
 
     qreal x = 0;
     qreal y = 0;
@@ -531,6 +535,133 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
     return polygons.isEmpty();
 }
 
+bool AzimuthalProjectionPrivate::packedLineStringToPolygon( const GeoDataLineString &lineString,
+                                                            const ViewportParams *viewport,
+                                                            QVector<QPolygonF *> &polygons ) const
+{
+    Q_Q( const AzimuthalProjection );
+
+    const GeoDataPackedCoordinates coordinates = lineString.packedCoordinates();
+    const int count = coordinates.size();
+    if ( count == 0 ) {
+        return true;
+    }
+
+    const qreal *lon = coordinates.longitudes();
+    const qreal *lat = coordinates.latitudes();
+    const quint8 *detail = coordinates.details();
+
+    QVector<qreal> x( count );
+    QVector<qreal> y( count );
+    QVector<bool> globeHidesPoint( count );
+    q->screenCoordinates( count, lon, lat, coordinates.altitudes(), viewport,
+                          x.data(), y.data(), globeHidesPoint.data() );
+
+    const TessellationFlags f = lineString.tessellationFlags();
+    const bool noFilter = f.testFlag(PreventNodeFiltering);
+    const bool isClosed = lineString.isClosed();
+    const bool isLong = count > 10;
+    const qreal angularResolution = viewport->angularResolution();
+    const int maximumDetail = levelForResolution(angularResolution);
+    // The first node of optimized linestrings has a non-zero detail value.
+    const bool hasDetail = detail[0] != 0;
+
+    QPolygonF * polygon = new QPolygonF;
+    polygon->reserve(count);
+    polygons.append( polygon );
+
+    // See lineStringToPolygon() for the horizon crossings. Their
+    // GeoDataCoordinates are only created when the line string crosses.
+    qreal horizonX = -1.0;
+    qreal horizonY = -1.0;
+    GeoDataCoordinates horizonCoords;
+    bool horizonPair = false;
+    GeoDataCoordinates horizonDisappearCoords;
+    bool horizonOrphan = false;
+    GeoDataCoordinates horizonOrphanCoords;
+
+    int previous = 0;
+    bool previousGlobeHidesPoint = false;
+
+    // Linear rings end with the first node again.
+    const int end = isClosed ? count + 1 : count;
+    for ( int node = 0; node < end; ++node ) {
+        const bool processingLastNode = node == count;
+        const int i = processingLastNode ? 0 : node;
+
+        // Optimization for line strings with a big amount of nodes,
+        // see ViewportParams::resolves()
+        bool skipNode = (hasDetail ? detail[i] > maximumDetail
+                : node != 0 && isLong && !processingLastNode &&
+                fabs( lon[i] - lon[previous] ) + fabs( lat[i] - lat[previous] ) <= angularResolution );
+
+        if ( skipNode && !noFilter ) {
+            continue;
+        }
+
+        if ( node == 0 ) {
+            previousGlobeHidesPoint = globeHidesPoint[i];
+        }
+
+        const bool isAtHorizon = ( globeHidesPoint[i] || previousGlobeHidesPoint ) &&
+                                 ( globeHidesPoint[i] != previousGlobeHidesPoint );
+
+        if ( isAtHorizon ) {
+            horizonCoords = findHorizon( coordinates.at( previous ), coordinates.at( i ), viewport, f );
+
+            if ( isClosed ) {
+                if ( horizonPair ) {
+                    horizonToPolygon( viewport, horizonDisappearCoords, horizonCoords, polygons.last() );
+                    horizonPair = false;
+                }
+                else {
+                    if ( globeHidesPoint[i] ) {
+                        horizonDisappearCoords = horizonCoords;
+                        horizonPair = true;
+                    }
+                    else {
+                        horizonOrphanCoords = horizonCoords;
+                        horizonOrphan = true;
+                    }
+                }
+            }
+
+            q->screenCoordinates( horizonCoords, viewport, horizonX, horizonY );
+
+            if ( previousGlobeHidesPoint ) {
+                *polygons.last() << QPointF( horizonX, horizonY );
+            }
+        }
+
+        if ( !globeHidesPoint[i] ) {
+            *polygons.last() << QPointF( x[i], y[i] );
+        }
+        else {
+            if ( !previousGlobeHidesPoint && isAtHorizon ) {
+                *polygons.last() << QPointF( horizonX, horizonY );
+            }
+
+            if ( !previousGlobeHidesPoint && !isClosed ) {
+                polygons.append( new QPolygonF );
+            }
+        }
+
+        previousGlobeHidesPoint = globeHidesPoint[i];
+        previous = i;
+    }
+
+    if ( horizonOrphan && isClosed ) {
+        horizonToPolygon( viewport, horizonCoords, horizonOrphanCoords, polygons.last() );
+    }
+
+    if ( polygons.last()->size() <= 1 ){
+        delete polygons.last();
+        polygons.pop_back(); // Clean up "unused" empty polygon instances
+    }
+
+    return polygons.isEmpty();
+}
+
 void AzimuthalProjectionPrivate::horizonToPolygon( const ViewportParams *viewport,
                                            const GeoDataCoordinates & disappearCoords,
                                            const GeoDataCoordinates & reappearCoords,
@@ -79,6 +79,12 @@ public:
                               const ViewportParams *viewport,
                               QVector<QPolygonF*> &polygons ) const;
 
+    // The untessellated case of lineStringToPolygon() on the arrays of
+    // a packed line string, which are projected in one pass.
+    bool packedLineStringToPolygon( const GeoDataLineString &lineString,
+                                    const ViewportParams *viewport,
+                                    QVector<QPolygonF*> &polygons ) const;
+
     void horizonToPolygon( const ViewportParams *viewport,
                            const GeoDataCoordinates & disappearCoords,
                            const GeoDataCoordinates & reappearCoords,
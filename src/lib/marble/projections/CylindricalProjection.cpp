@@ -20,6 +20,7 @@
 #include "GeoDataLineString.h"
 #include "GeoDataCoordinates.h"
 #include "GeoDataLatLonAltBox.h"
+#include "GeoDataPackedCoordinates.h"
 #include "ViewportParams.h"
 
 #include <QPainterPath>
@@ -247,10 +248,18 @@ int CylindricalProjectionPrivate::crossDateLine( const GeoDataCoordinates & aCoo
                                                  int mirrorCount,
                                                  qreal repeatDistance )
 {
-    qreal aLon = aCoord.longitude();
-    qreal aSign = aLon > 0 ? 1 : -1;
+    return crossDateLine( aCoord.longitude(), bCoord.longitude(), bx, by, polygons, mirrorCount, repeatDistance );
+}
 
-    qreal bLon = bCoord.longitude();
+int CylindricalProjectionPrivate::crossDateLine( qreal aLon,
+                                                 qreal bLon,
+                                                 qreal bx,
+                                                 qreal by,
+                                                 QVector<QPolygonF*> &polygons,
+                                                 int mirrorCount,
+                                                 qreal repeatDistance )
+{
+    qreal aSign = aLon > 0 ? 1 : -1;
     qreal bSign = bLon > 0 ? 1 : -1;
 
     qreal delta = 0;
@@ -272,6 +281,12 @@ bool CylindricalProjectionPrivate::lineStringToPolygon( const GeoDataLineString
     bool const tessellate = lineString.tessellate();
     const bool noFilter = f.testFlag(PreventNodeFiltering);
 
+    bool isStraight = lineString.latLonAltBox().height() == 0 || lineString.latLonAltBox().width() == 0;
+
+    if ( lineString.isPacked() && ( !tessellate || isStraight ) ) {
+        return packedLineStringToPolygon( lineString, viewport, polygons );
+    }
+
     qreal x = 0;
     qreal y = 0;
 
@@ -304,8 +319,6 @@ bool CylindricalProjectionPrivate::lineStringToPolygon( const GeoDataLineString
     // The first node of optimized linestrings has a non-zero detail value.
     const bool hasDetail = itBegin->detail() != 0;
 
-    bool isStraight = lineString.latLonAltBox().height() == 0 || lineString.latLonAltBox().width() == 0;
-
     Q_Q( const CylindricalProjection );
     bool const isClosed = lineString.isClosed();
     while ( itCoords != itEnd )
@@ -390,6 +403,66 @@ bool CylindricalProjectionPrivate::lineStringToPolygon( const GeoDataLineString
     return polygons.isEmpty();
 }
 
+bool CylindricalProjectionPrivate::packedLineStringToPolygon( const GeoDataLineString &lineString,
+                                                             const ViewportParams *viewport,
+                                                             QVector<QPolygonF *> &polygons ) const
+{
+    Q_Q( const CylindricalProjection );
+
+    const GeoDataPackedCoordinates coordinates = lineString.packedCoordinates();
+    const int count = coordinates.size();
+    if ( count == 0 ) {
+        return true;
+    }
+
+    const qreal *lon = coordinates.longitudes();
+    const qreal *lat = coordinates.latitudes();
+    const quint8 *detail = coordinates.details();
+
+    QVector<qreal> x( count );
+    QVector<qreal> y( count );
+    QVector<bool> globeHidesPoint( count );
+    q->screenCoordinates( count, lon, lat, coordinates.altitudes(), viewport,
+                          x.data(), y.data(), globeHidesPoint.data() );
+
+    const bool noFilter = lineString.tessellationFlags().testFlag(PreventNodeFiltering);
+    const bool isLong = count > 10;
+    const qreal angularResolution = viewport->angularResolution();
+    const int maximumDetail = levelForResolution(angularResolution);
+    // The first node of optimized linestrings has a non-zero detail value.
+    const bool hasDetail = detail[0] != 0;
+    const qreal distance = repeatDistance( viewport );
+
+    QPolygonF * polygon = new QPolygonF;
+    polygon->reserve(count);
+    polygons.append( polygon );
+
+    int mirrorCount = 0;
+    int previous = 0;
+
+    // Linear rings end with the first node again.
+    const int end = lineString.isClosed() ? count + 1 : count;
+    for ( int node = 0; node < end; ++node ) {
+        const bool processingLastNode = node == count;
+        const int i = processingLastNode ? 0 : node;
+
+        // Optimization for line strings with a big amount of nodes,
+        // see ViewportParams::resolves()
+        bool skipNode = (hasDetail ? detail[i] > maximumDetail
+                : isLong && !processingLastNode && node != 0 &&
+                fabs( lon[i] - lon[previous] ) + fabs( lat[i] - lat[previous] ) <= angularResolution );
+
+        if ( !skipNode || noFilter) {
+            mirrorCount = crossDateLine( lon[previous], lon[i], x[i], y[i], polygons, mirrorCount, distance );
+            previous = i;
+        }
+    }
+
+    repeatPolygons( viewport, polygons );
+
+    return polygons.isEmpty();
+}
+
 void CylindricalProjectionPrivate::translatePolygons( const QVector<QPolygonF *> &polygons,
                                                       QVector<QPolygonF *> &translatedPolygons,
                                                       qreal xOffset )
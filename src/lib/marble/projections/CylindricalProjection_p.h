@@ -58,10 +58,24 @@ class CylindricalProjectionPrivate : public AbstractProjectionPrivate
                               int mirrorCount = 0,
                               qreal repeatDistance = 0 );
 
+    static int crossDateLine( qreal aLon,
+                              qreal bLon,
+                              qreal bx,
+                              qreal by,
+                              QVector<QPolygonF*> &polygons,
+                              int mirrorCount = 0,
+                              qreal repeatDistance = 0 );
+
     bool lineStringToPolygon( const GeoDataLineString &lineString,
                               const ViewportParams *viewport,
                               QVector<QPolygonF*> &polygons ) const;
 
+    // The untessellated case of lineStringToPolygon() on the arrays of
+    // a packed line string, which are projected in one pass.
+    bool packedLineStringToPolygon( const GeoDataLineString &lineString,
+                                    const ViewportParams *viewport,
+                                    QVector<QPolygonF*> &polygons ) const;
+
     static void translatePolygons( const QVector<QPolygonF *> &polygons,
                                    QVector<QPolygonF *> &translatedPolygons,
                                    qreal xOffset );
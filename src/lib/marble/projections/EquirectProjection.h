@@ -84,6 +84,10 @@ class EquirectProjection : public CylindricalProjection
                             const QSizeF& size,
                             bool &globeHidesPoint ) const override;
 
+    void screenCoordinates( int count, const qreal *lon, const qreal *lat, const qreal *alt,
+                            const ViewportParams *viewport,
+                            qreal *x, qreal *y, bool *globeHidesPoint ) const override;
+
     using CylindricalProjection::screenCoordinates;
 
     /**
@@ -165,6 +165,27 @@ bool MercatorProjection::screenCoordinates( const GeoDataCoordinates &coordinate
 }
 
 
+void MercatorProjection::screenCoordinates( int count, const qreal *lon, const qreal *lat, const qreal *alt,
+                                            const ViewportParams *viewport,
+                                            qreal *x, qreal *y, bool *globeHidesPoint ) const
+{
+    Q_UNUSED( alt );
+
+    const qreal rad2Pixel = 2 * viewport->radius() / M_PI;
+    const qreal halfWidth = (qreal)(viewport->width()) / 2;
+    const qreal halfHeight = (qreal)(viewport->height()) / 2;
+    const qreal centerLon = viewport->centerLongitude();
+    const qreal centerLatInv = gdInv( viewport->centerLatitude() );
+    const qreal minLatitude = minLat();
+    const qreal maxLatitude = maxLat();
+
+    for ( int i = 0; i < count; ++i ) {
+        x[i] = halfWidth + rad2Pixel * ( lon[i] - centerLon );
+        y[i] = halfHeight - rad2Pixel * ( gdInv( qBound( minLatitude, lat[i], maxLatitude ) ) - centerLatInv );
+        globeHidesPoint[i] = false;
+    }
+}
+
 bool MercatorProjection::geoCoordinates( const int x, const int y,
                                          const ViewportParams *viewport,
                                          qreal& lon, qreal& lat,
@@ -83,6 +83,10 @@ class MercatorProjection : public CylindricalProjection
                             const QSizeF& size,
                             bool &globeHidesPoint ) const override;
 
+    void screenCoordinates( int count, const qreal *lon, const qreal *lat, const qreal *alt,
+                            const ViewportParams *viewport,
+                            qreal *x, qreal *y, bool *globeHidesPoint ) const override;
+
     using CylindricalProjection::screenCoordinates;
 
    /**
@@ -154,6 +154,45 @@ bool SphericalProjection::screenCoordinates( const GeoDataCoordinates &coordinat
 }
 
 
+void SphericalProjection::screenCoordinates( int count, const qreal *lon, const qreal *lat, const qreal *alt,
+                                             const ViewportParams *viewport,
+                                             qreal *x, qreal *y, bool *globeHidesPoint ) const
+{
+    // The rotation of Quaternion::rotateAroundAxis() on the vectors of
+    // Quaternion::fromSpherical(), without creating GeoDataCoordinates.
+    const matrix &m = viewport->planetAxisMatrix();
+
+    const qreal radius = viewport->radius();
+    const qreal halfWidth = qreal( viewport->width() ) / 2;
+    const qreal halfHeight = qreal( viewport->height() ) / 2;
+
+    for ( int i = 0; i < count; ++i ) {
+        const qreal cosLat = cos( lat[i] );
+        const qreal vx = cosLat * sin( lon[i] );
+        const qreal vy = sin( lat[i] );
+        const qreal vz = cosLat * cos( lon[i] );
+
+        const qreal qx = m[0][0] * vx + m[1][0] * vy + m[2][0] * vz;
+        const qreal qy = m[0][1] * vx + m[1][1] * vy + m[2][1] * vz;
+        const qreal qz = m[0][2] * vx + m[1][2] * vy + m[2][2] * vz;
+
+        const qreal altitude = alt ? alt[i] : 0.0;
+        const qreal pixelAltitude = radius / EARTH_RADIUS * ( altitude + EARTH_RADIUS );
+        x[i] = halfWidth + pixelAltitude * qx;
+        y[i] = halfHeight - pixelAltitude * qy;
+
+        if ( altitude < 10000 ) {
+            globeHidesPoint[i] = qz < 0;
+        }
+        else {
+            const qreal earthCenteredX = pixelAltitude * qx;
+            const qreal earthCenteredY = pixelAltitude * qy;
+            globeHidesPoint[i] = qz < 0
+                                 && earthCenteredX * earthCenteredX + earthCenteredY * earthCenteredY < radius * radius;
+        }
+    }
+}
+
 bool SphericalProjection::geoCoordinates( const int x, const int y,
                                           const ViewportParams *viewport,
                                           qreal& lon, qreal& lat,
@@ -81,6 +81,10 @@ class SphericalProjection : public AzimuthalProjection
                             const QSizeF& size,
                             bool &globeHidesPoint ) const override;
 
+    void screenCoordinates( int count, const qreal *lon, const qreal *lat, const qreal *alt,
+                            const ViewportParams *viewport,
+                            qreal *x, qreal *y, bool *globeHidesPoint ) const override;
+
     using AbstractProjection::screenCoordinates;
 
     /**
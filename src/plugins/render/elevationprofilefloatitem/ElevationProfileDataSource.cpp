@@ -43,9 +43,9 @@ QVector<QPointF> ElevationProfileDataSource::calculateElevationData(const GeoDat
     QVector<QPointF> result;
     qreal distance = 0;
 
-    //GeoDataLineString path;
+    const QVector<qreal> elevations = getElevations( lineString );
     for ( int i = 0; i < lineString.size(); i++ ) {
-        const qreal ele = getElevation( lineString[i] );
+        const qreal ele = elevations[i];
 
         if ( i ) {
             distance += EARTH_RADIUS * distanceSphere( lineString[i-1], lineString[i] );
@@ -108,9 +108,14 @@ bool ElevationProfileTrackDataSource::isDataAvailable() const
     return !m_trackHash.isEmpty();
 }
 
-qreal ElevationProfileTrackDataSource::getElevation(const GeoDataCoordinates &coordinates) const
+QVector<qreal> ElevationProfileTrackDataSource::getElevations(const GeoDataLineString &lineString) const
 {
-    return coordinates.altitude();
+    QVector<qreal> result;
+    result.reserve(lineString.size());
+    for (const GeoDataCoordinates &coordinates: lineString) {
+        result << coordinates.altitude();
+    }
+    return result;
 }
 
 void ElevationProfileTrackDataSource::handleObjectAdded(GeoDataObject *object)
@@ -236,12 +241,10 @@ bool ElevationProfileRouteDataSource::isDataAvailable() const
     return m_routingModel && m_routingModel->rowCount() > 0;
 }
 
-qreal ElevationProfileRouteDataSource::getElevation(const GeoDataCoordinates &coordinates) const
+QVector<qreal> ElevationProfileRouteDataSource::getElevations(const GeoDataLineString &lineString) const
 {
-    const qreal lat = coordinates.latitude ( GeoDataCoordinates::Degree );
-    const qreal lon = coordinates.longitude( GeoDataCoordinates::Degree );
-    qreal ele = m_elevationModel->height( lon, lat );
-    return ele;
+    // routes can span thousands of kilometers, so sample them in parallel
+    return m_elevationModel->heights( lineString, ElevationModel::Threaded );
 }
 // end of impl of ElevationProfileRouteDataSource
 
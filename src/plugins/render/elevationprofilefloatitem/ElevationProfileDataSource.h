@@ -19,12 +19,12 @@
 #include <QList>
 #include <QPointF>
 #include <QStringList>
+#include <QVector>
 
 namespace Marble
 {
 
 class ElevationModel;
-class GeoDataCoordinates;
 class GeoDataLineString;
 class GeoDataObject;
 class GeoDataTrack;
@@ -53,7 +53,7 @@ Q_SIGNALS:
 
 protected:
     QVector<QPointF> calculateElevationData(const GeoDataLineString &lineString) const;
-    virtual qreal getElevation(const GeoDataCoordinates &coordinates) const = 0;
+    virtual QVector<qreal> getElevations(const GeoDataLineString &lineString) const = 0;
 };
 
 /**
@@ -78,7 +78,7 @@ public Q_SLOTS:
     void requestUpdate() override;
 
 protected:
-    qreal getElevation(const GeoDataCoordinates &coordinates) const override;
+    QVector<qreal> getElevations(const GeoDataLineString &lineString) const override;
 
 private Q_SLOTS:
     void handleObjectAdded( GeoDataObject *object );
@@ -107,7 +107,7 @@ public Q_SLOTS:
     void requestUpdate() override;
 
 protected:
-    qreal getElevation(const GeoDataCoordinates &coordinates) const override;
+    QVector<qreal> getElevations(const GeoDataLineString &lineString) const override;
 
 private:
     const RoutingModel *const m_routingModel;
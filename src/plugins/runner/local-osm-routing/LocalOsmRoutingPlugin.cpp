@@ -0,0 +1,116 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "LocalOsmRoutingPlugin.h"
+#include "LocalOsmRoutingRunner.h"
+#include "MarbleDirs.h"
+
+#include <QDir>
+
+namespace Marble
+{
+
+LocalOsmRoutingPlugin::LocalOsmRoutingPlugin( QObject *parent ) :
+    RoutingRunnerPlugin( parent )
+{
+    setSupportedCelestialBodies(QStringList(QStringLiteral("earth")));
+    setCanWorkOffline( true );
+
+    QStringList const baseDirs = QStringList() << MarbleDirs::systemPath() << MarbleDirs::localPath();
+    for ( const QString &baseDir: baseDirs ) {
+        m_graphDirectories << baseDir + QLatin1String("/maps/earth/local-osm-routing/");
+    }
+}
+
+QString LocalOsmRoutingPlugin::name() const
+{
+    return tr( "Local OSM Routing" );
+}
+
+QString LocalOsmRoutingPlugin::guiString() const
+{
+    return tr( "Offline OpenStreetMap Routing" );
+}
+
+QString LocalOsmRoutingPlugin::nameId() const
+{
+    return QStringLiteral("local-osm-routing");
+}
+
+QString LocalOsmRoutingPlugin::version() const
+{
+    return QStringLiteral("1.0");
+}
+
+QString LocalOsmRoutingPlugin::description() const
+{
+    return tr( "Calculates routes in offline OpenStreetMap routing graphs." );
+}
+
+QString LocalOsmRoutingPlugin::copyrightYears() const
+{
+    return QStringLiteral("2026");
+}
+
+QVector<PluginAuthor> LocalOsmRoutingPlugin::pluginAuthors() const
+{
+    return QVector<PluginAuthor>()
+            << PluginAuthor(QStringLiteral("The Marble Project"), QStringLiteral("marble-devel@kde.org"));
+}
+
+RoutingRunner *LocalOsmRoutingPlugin::newRunner() const
+{
+    return new LocalOsmRoutingRunner( m_graphDirectories );
+}
+
+bool LocalOsmRoutingPlugin::supportsTemplate( RoutingProfilesModel::ProfileTemplate profileTemplate ) const
+{
+    return
+        (profileTemplate == RoutingProfilesModel::CarFastestTemplate) ||
+        (profileTemplate == RoutingProfilesModel::BicycleTemplate)    ||
+        (profileTemplate == RoutingProfilesModel::PedestrianTemplate);
+}
+
+QHash< QString, QVariant > LocalOsmRoutingPlugin::templateSettings( RoutingProfilesModel::ProfileTemplate profileTemplate ) const
+{
+    QHash<QString, QVariant> result;
+    switch ( profileTemplate ) {
+        case RoutingProfilesModel::CarFastestTemplate:
+            result.insert(QStringLiteral("transport"), QStringLiteral("motorcar"));
+            break;
+        case RoutingProfilesModel::CarShortestTemplate:
+        case RoutingProfilesModel::CarEcologicalTemplate:
+            break;
+        case RoutingProfilesModel::BicycleTemplate:
+            result.insert(QStringLiteral("transport"), QStringLiteral("bicycle"));
+            break;
+        case RoutingProfilesModel::PedestrianTemplate:
+            result.insert(QStringLiteral("transport"), QStringLiteral("pedestrian"));
+            break;
+        case RoutingProfilesModel::LastTemplate:
+            Q_ASSERT( false );
+            break;
+    }
+    return result;
+}
+
+bool LocalOsmRoutingPlugin::canWork() const
+{
+    // graphs may be added later on, the runner looks for them on each request
+    for ( const QString &directory: m_graphDirectories ) {
+        if ( !QDir( directory ).entryList( QStringList() << "*.ch", QDir::Files ).isEmpty() ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
+
+#include "moc_LocalOsmRoutingPlugin.cpp"
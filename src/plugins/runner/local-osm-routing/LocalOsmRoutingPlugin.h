@@ -0,0 +1,60 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_LOCALOSMROUTINGPLUGIN_H
+#define MARBLE_LOCALOSMROUTINGPLUGIN_H
+
+#include "RoutingRunnerPlugin.h"
+
+#include <QStringList>
+
+namespace Marble
+{
+
+/**
+ * Routes in-process on routing graphs of OSM data, which are created by the
+ * osm-routing-graph tool in the maps/earth/local-osm-routing/ directories.
+ */
+class LocalOsmRoutingPlugin : public RoutingRunnerPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "org.kde.marble.LocalOsmRoutingPlugin")
+    Q_INTERFACES( Marble::RoutingRunnerPlugin )
+
+public:
+    explicit LocalOsmRoutingPlugin( QObject *parent = 0 );
+
+    QString name() const override;
+
+    QString guiString() const override;
+
+    QString nameId() const override;
+
+    QString version() const override;
+
+    QString description() const override;
+
+    QString copyrightYears() const override;
+
+    QVector<PluginAuthor> pluginAuthors() const override;
+
+    RoutingRunner *newRunner() const override;
+
+    bool supportsTemplate( RoutingProfilesModel::ProfileTemplate profileTemplate ) const override;
+
+    QHash< QString, QVariant > templateSettings( RoutingProfilesModel::ProfileTemplate profileTemplate ) const override;
+
+    bool canWork() const override;
+
+private:
+    QStringList m_graphDirectories;
+};
+
+}
+
+#endif
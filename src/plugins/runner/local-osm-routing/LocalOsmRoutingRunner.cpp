@@ -0,0 +1,186 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "LocalOsmRoutingRunner.h"
+
+#include "GeoDataData.h"
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDebug.h"
+#include "MarbleGlobal.h"
+#include "routing/RouteRequest.h"
+#include "routing/instructions/InstructionTransformation.h"
+
+#include <QDir>
+#include <QTime>
+
+namespace Marble
+{
+
+LocalOsmRoutingRunner::LocalOsmRoutingRunner( const QStringList &graphDirectories, QObject *parent ) :
+    RoutingRunner( parent ),
+    m_graphDirectories( graphDirectories )
+{
+    // nothing to do
+}
+
+LocalOsmRoutingRunner::~LocalOsmRoutingRunner()
+{
+    // nothing to do
+}
+
+void LocalOsmRoutingRunner::retrieveRoute( const RouteRequest *route )
+{
+    RoutingProfile::TransportType transportType = route->routingProfile().transportType();
+    const QHash<QString, QVariant> settings = route->routingProfile().pluginSettings()[QStringLiteral( "local-osm-routing" )];
+    const QString transport = settings.value( QStringLiteral( "transport" ) ).toString();
+    for ( int i = RoutingProfile::Motorcar; i <= RoutingProfile::Pedestrian; ++i ) {
+        if ( transport == RoutingGraph::transportName( RoutingProfile::TransportType( i ) ) ) {
+            transportType = RoutingProfile::TransportType( i );
+        }
+    }
+
+    QVector<GeoDataCoordinates> waypoints;
+    for ( int i = 0; i < route->size(); ++i ) {
+        waypoints << route->at( i );
+    }
+
+    const QSharedPointer<const RoutingGraph> graph = this->graph( transportType, waypoints );
+    if ( !graph || waypoints.size() < 2 ) {
+        emit routeCalculated( 0 );
+        return;
+    }
+
+    QVector<RoutingGraph::Segment> segments;
+    quint32 previous = graph->nearestNode( waypoints.first() );
+    for ( int i = 1; i < waypoints.size(); ++i ) {
+        const quint32 node = graph->nearestNode( waypoints[i] );
+        const QVector<RoutingGraph::Segment> leg = graph->route( previous, node );
+        if ( leg.isEmpty() && node != previous ) {
+            mDebug() << "No route to waypoint" << i << "for" << RoutingGraph::transportName( transportType );
+            emit routeCalculated( 0 );
+            return;
+        }
+
+        segments += leg;
+        previous = node;
+    }
+
+    emit routeCalculated( segments.isEmpty() ? 0 : createDocument( *graph, segments ) );
+}
+
+QSharedPointer<const RoutingGraph> LocalOsmRoutingRunner::graph( RoutingProfile::TransportType transportType, const QVector<GeoDataCoordinates> &waypoints ) const
+{
+    QSharedPointer<const RoutingGraph> result;
+    qreal resultArea = 0.0;
+    for ( const QString &directory: m_graphDirectories ) {
+        const QFileInfoList files = QDir( directory ).entryInfoList( QStringList() << "*.ch", QDir::Files );
+        for ( const QFileInfo &file: files ) {
+            const QSharedPointer<const RoutingGraph> graph = RoutingGraph::open( file.absoluteFilePath() );
+            if ( !graph || graph->transportType() != transportType ) {
+                continue;
+            }
+
+            // waypoints a little outside of the roads, like on the coast, are still accepted
+            const GeoDataLatLonBox bounds = graph->bounds().scaled( 1.1, 1.1 );
+            bool containsWaypoints = true;
+            for ( const GeoDataCoordinates &waypoint: waypoints ) {
+                containsWaypoints = containsWaypoints && bounds.contains( waypoint );
+            }
+
+            const qreal area = bounds.width() * bounds.height();
+            if ( containsWaypoints && ( !result || area < resultArea ) ) {
+                result = graph;
+                resultArea = area;
+            }
+        }
+    }
+
+    return result;
+}
+
+GeoDataDocument *LocalOsmRoutingRunner::createDocument( const RoutingGraph &graph, const QVector<RoutingGraph::Segment> &segments ) const
+{
+    GeoDataLineString *routeWaypoints = new GeoDataLineString;
+    routeWaypoints->append( graph.coordinates( segments.first().from ) );
+    quint32 weight = 0;
+    for ( const RoutingGraph::Segment &segment: segments ) {
+        routeWaypoints->append( graph.coordinates( segment.to ) );
+        weight += segment.weight;
+    }
+
+    // each point has the road leaving it. A junction reached on a roundabout counts as an exit passed,
+    // the exit taken is counted as well before the road leaving the roundabout starts there
+    RoutingWaypoints waypoints;
+    quint32 remaining = weight;
+    for ( int i = 0; i <= segments.size(); ++i ) {
+        if ( i > 0 ) {
+            remaining -= segments[i - 1].weight;
+        }
+
+        const bool last = i == segments.size();
+        const quint32 node = last ? segments.last().to : segments[i].from;
+        const quint32 way = segments[last ? i - 1 : i].way;
+        const GeoDataCoordinates position = graph.coordinates( node );
+        const RoutingPoint point( position.longitude( GeoDataCoordinates::Degree ), position.latitude( GeoDataCoordinates::Degree ) );
+        const bool junction = graph.degree( node ) > 2;
+        if ( i > 0 && junction && graph.isRoundabout( segments[i - 1].way ) ) {
+            const quint32 roundabout = segments[i - 1].way;
+            waypoints << RoutingWaypoint( point, RoutingWaypoint::Roundabout, QString(), graph.roadType( roundabout ),
+                                          remaining / 10, graph.roadName( roundabout ) );
+            if ( graph.isRoundabout( way ) ) {
+                continue;
+            }
+        }
+
+        waypoints << RoutingWaypoint( point, junction ? RoutingWaypoint::Other : RoutingWaypoint::None, QString(),
+                                      graph.roadType( way ), remaining / 10, graph.roadName( way ) );
+    }
+
+    GeoDataDocument *result = new GeoDataDocument;
+    GeoDataPlacemark *routePlacemark = new GeoDataPlacemark;
+    routePlacemark->setName( QStringLiteral( "Route" ) );
+    routePlacemark->setGeometry( routeWaypoints );
+
+    const QTime duration = QTime( 0, 0 ).addSecs( weight / 10 );
+    const qreal length = routeWaypoints->length( EARTH_RADIUS );
+    routePlacemark->setExtendedData( routeData( length, duration ) );
+    result->setName( nameString( "OSM", length, duration ) );
+    result->append( routePlacemark );
+
+    const RoutingInstructions directions = InstructionTransformation::process( waypoints );
+    for ( const RoutingInstruction &direction: directions ) {
+        GeoDataPlacemark *placemark = new GeoDataPlacemark( direction.instructionText() );
+        GeoDataExtendedData extendedData;
+        GeoDataData turnType;
+        turnType.setName( QStringLiteral( "turnType" ) );
+        turnType.setValue( qVariantFromValue<int>( int( direction.turnType() ) ) );
+        extendedData.addValue( turnType );
+        GeoDataData roadName;
+        roadName.setName( QStringLiteral( "roadName" ) );
+        roadName.setValue( direction.roadName() );
+        extendedData.addValue( roadName );
+        placemark->setExtendedData( extendedData );
+
+        GeoDataLineString *geometry = new GeoDataLineString;
+        for ( const RoutingWaypoint &item: direction.points() ) {
+            geometry->append( GeoDataCoordinates( item.point().lon(), item.point().lat(), 0.0, GeoDataCoordinates::Degree ) );
+        }
+        placemark->setGeometry( geometry );
+        result->append( placemark );
+    }
+
+    return result;
+}
+
+}
+
+#include "moc_LocalOsmRoutingRunner.cpp"
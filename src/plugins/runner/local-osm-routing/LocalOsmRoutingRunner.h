@@ -0,0 +1,43 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_LOCALOSMROUTINGRUNNER_H
+#define MARBLE_LOCALOSMROUTINGRUNNER_H
+
+#include "RoutingRunner.h"
+#include "RoutingGraph.h"
+
+#include <QStringList>
+
+namespace Marble
+{
+
+class GeoDataCoordinates;
+
+class LocalOsmRoutingRunner : public RoutingRunner
+{
+    Q_OBJECT
+public:
+    explicit LocalOsmRoutingRunner( const QStringList &graphDirectories, QObject *parent = 0 );
+
+    ~LocalOsmRoutingRunner() override;
+
+    void retrieveRoute( const RouteRequest *request ) override;
+
+private:
+    /** The graph of the smallest area with all @p waypoints for @p transportType */
+    QSharedPointer<const RoutingGraph> graph( RoutingProfile::TransportType transportType, const QVector<GeoDataCoordinates> &waypoints ) const;
+
+    GeoDataDocument *createDocument( const RoutingGraph &graph, const QVector<RoutingGraph::Segment> &segments ) const;
+
+    QStringList m_graphDirectories;
+};
+
+}
+
+#endif
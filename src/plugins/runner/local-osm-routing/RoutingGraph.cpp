@@ -0,0 +1,396 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "RoutingGraph.h"
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataLatLonBox.h"
+#include "MarbleDebug.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <qmath.h>
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace Marble
+{
+
+const quint32 RoutingGraph::Magic;
+const quint32 RoutingGraph::Version;
+const quint32 RoutingGraph::InvalidNode;
+
+namespace
+{
+
+struct CachedGraph {
+    QDateTime lastModified;
+    qint64 size;
+    QSharedPointer<const RoutingGraph> graph;
+};
+
+struct Label {
+    quint32 weight;
+    quint32 parent;
+    quint32 edge;
+};
+
+// an edge of the contracted graph, followed from one node to the other
+struct Step {
+    quint32 from;
+    quint32 to;
+    quint32 edge;
+};
+
+// weight and node, the lightest first
+typedef QPair<quint32, quint32> QueueItem;
+typedef std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > Queue;
+
+}
+
+RoutingGraph::RoutingGraph() :
+    m_header( 0 ),
+    m_nodes( 0 ),
+    m_edges( 0 ),
+    m_cells( 0 ),
+    m_ways( 0 ),
+    m_names( 0 )
+{
+    // nothing to do
+}
+
+RoutingGraph::~RoutingGraph()
+{
+    // the mapping is removed when the file is closed
+}
+
+QSharedPointer<const RoutingGraph> RoutingGraph::open( const QString &fileName )
+{
+    static QMutex mutex;
+    static QHash<QString, CachedGraph> graphs;
+
+    const QFileInfo info( fileName );
+    QMutexLocker locker( &mutex );
+    CachedGraph &cached = graphs[info.absoluteFilePath()];
+    if ( cached.lastModified != info.lastModified() || cached.size != info.size() ) {
+        // graphs still in use keep the mapping of the former file
+        QSharedPointer<RoutingGraph> graph( new RoutingGraph );
+        cached.graph = graph->load( fileName ) ? graph : QSharedPointer<RoutingGraph>();
+        cached.lastModified = info.lastModified();
+        cached.size = info.size();
+    }
+
+    return cached.graph;
+}
+
+bool RoutingGraph::load( const QString &fileName )
+{
+    m_header = 0;
+    m_file.close();
+    m_file.setFileName( fileName );
+    if ( !m_file.open( QIODevice::ReadOnly ) ) {
+        mDebug() << "Cannot open routing graph" << fileName;
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    const uchar *data = size >= qint64( sizeof( Header ) ) ? m_file.map( 0, size ) : 0;
+    if ( !data ) {
+        mDebug() << "Cannot map routing graph" << fileName;
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header*>( data );
+    if ( header->magic != Magic || header->version != Version || header->transportType > RoutingProfile::Pedestrian ) {
+        mDebug() << "Unsupported routing graph" << fileName;
+        return false;
+    }
+
+    const qint64 cellCount = qint64( header->cellColumns ) * header->cellRows;
+    const qint64 nodes = sizeof( Header );
+    const qint64 edges = nodes + ( qint64( header->nodeCount ) + 1 ) * sizeof( Node );
+    const qint64 cells = edges + qint64( header->edgeCount ) * sizeof( Edge );
+    const qint64 ways = cells + ( cellCount + 1 ) * sizeof( quint32 );
+    const qint64 names = ways + qint64( header->wayCount ) * sizeof( Way );
+    if ( names + header->nameSize != size ) {
+        mDebug() << "Truncated routing graph" << fileName;
+        return false;
+    }
+
+    m_nodes = reinterpret_cast<const Node*>( data + nodes );
+    m_edges = reinterpret_cast<const Edge*>( data + edges );
+    m_cells = reinterpret_cast<const quint32*>( data + cells );
+    m_ways = reinterpret_cast<const Way*>( data + ways );
+    m_names = reinterpret_cast<const char*>( data + names );
+    if ( m_nodes[header->nodeCount].firstEdge != header->edgeCount || m_cells[cellCount] != header->nodeCount ) {
+        mDebug() << "Inconsistent routing graph" << fileName;
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+RoutingProfile::TransportType RoutingGraph::transportType() const
+{
+    return RoutingProfile::TransportType( m_header->transportType );
+}
+
+GeoDataLatLonBox RoutingGraph::bounds() const
+{
+    return GeoDataLatLonBox( m_header->north * 1e-7, m_header->south * 1e-7,
+                             m_header->east * 1e-7, m_header->west * 1e-7, GeoDataCoordinates::Degree );
+}
+
+int RoutingGraph::nodeCount() const
+{
+    return m_header->nodeCount;
+}
+
+quint32 RoutingGraph::nearestNode( const GeoDataCoordinates &position ) const
+{
+    const qreal lon = position.longitude( GeoDataCoordinates::Degree ) * 1e7;
+    const qreal lat = position.latitude( GeoDataCoordinates::Degree ) * 1e7;
+    // longitude differences scaled to latitude differences of the same length
+    const qreal scale = qMax<qreal>( 0.01, qCos( position.latitude() ) );
+
+    const qint64 cellSize = m_header->cellSize;
+    const qint64 columns = m_header->cellColumns;
+    const qint64 rows = m_header->cellRows;
+    const qint64 column = qFloor( ( lon - m_header->west ) / cellSize );
+    const qint64 row = qFloor( ( lat - m_header->south ) / cellSize );
+    const qint64 maxRing = qMax( qAbs( column ) + columns, qAbs( row ) + rows );
+
+    // rings of cells around the position, until the cells left are farther away than the nearest node
+    quint32 nearest = InvalidNode;
+    qreal nearestDistance = std::numeric_limits<qreal>::max();
+    for ( qint64 ring = 0; ring <= maxRing; ++ring ) {
+        for ( qint64 y = qMax<qint64>( 0, row - ring ); y <= qMin( rows - 1, row + ring ); ++y ) {
+            const qint64 step = y == row - ring || y == row + ring ? 1 : 2 * ring;
+            for ( qint64 x = column - ring; x <= column + ring; x += step ) {
+                if ( x < 0 || x >= columns ) {
+                    continue;
+                }
+
+                const qint64 cell = y * columns + x;
+                for ( quint32 node = m_cells[cell], end = m_cells[cell + 1]; node < end; ++node ) {
+                    const qreal dx = ( m_nodes[node].lon - lon ) * scale;
+                    const qreal dy = m_nodes[node].lat - lat;
+                    const qreal distance = dx * dx + dy * dy;
+                    if ( distance < nearestDistance ) {
+                        nearestDistance = distance;
+                        nearest = node;
+                    }
+                }
+            }
+        }
+
+        const qreal bound = ring * cellSize * scale;
+        if ( nearest != InvalidNode && nearestDistance <= bound * bound ) {
+            break;
+        }
+    }
+
+    return nearest;
+}
+
+QVector<RoutingGraph::Segment> RoutingGraph::route( quint32 source, quint32 target ) const
+{
+    QVector<Segment> segments;
+    if ( source == target || source >= m_header->nodeCount || target >= m_header->nodeCount ) {
+        return segments;
+    }
+
+    // the forward search follows the edges from the source, the backward one those to the target
+    const quint32 directions[2] = { Forward, Backward };
+    QHash<quint32, Label> labels[2];
+    Queue queues[2];
+    const Label sourceLabel = { 0, InvalidNode, 0 };
+    labels[0].insert( source, sourceLabel );
+    queues[0].push( QueueItem( 0, source ) );
+    const Label targetLabel = { 0, InvalidNode, 0 };
+    labels[1].insert( target, targetLabel );
+    queues[1].push( QueueItem( 0, target ) );
+
+    quint32 best = std::numeric_limits<quint32>::max();
+    quint32 meeting = InvalidNode;
+    forever {
+        // a search is done when it cannot lead to a faster route anymore
+        for ( int i = 0; i < 2; ++i ) {
+            if ( !queues[i].empty() && queues[i].top().first >= best ) {
+                queues[i] = Queue();
+            }
+        }
+        if ( queues[0].empty() && queues[1].empty() ) {
+            break;
+        }
+
+        const int i = queues[1].empty() || ( !queues[0].empty() && queues[0].top().first <= queues[1].top().first ) ? 0 : 1;
+        const QueueItem item = queues[i].top();
+        queues[i].pop();
+        const quint32 node = item.second;
+        if ( item.first > labels[i].value( node ).weight ) {
+            continue;
+        }
+
+        const auto other = labels[1 - i].constFind( node );
+        if ( other != labels[1 - i].constEnd() && item.first + other->weight < best ) {
+            best = item.first + other->weight;
+            meeting = node;
+        }
+
+        for ( quint32 edge = m_nodes[node].firstEdge, end = m_nodes[node + 1].firstEdge; edge < end; ++edge ) {
+            const Edge &current = m_edges[edge];
+            if ( !( current.flags & directions[i] ) ) {
+                continue;
+            }
+
+            const quint32 weight = item.first + current.weight;
+            const auto label = labels[i].find( current.target );
+            if ( label == labels[i].end() || weight < label->weight ) {
+                const Label reached = { weight, node, edge };
+                labels[i].insert( current.target, reached );
+                queues[i].push( QueueItem( weight, current.target ) );
+            }
+        }
+    }
+
+    if ( meeting == InvalidNode ) {
+        return segments;
+    }
+
+    QVector<Step> forwardPath;
+    for ( quint32 node = meeting; node != source; ) {
+        const Label label = labels[0].value( node );
+        const Step step = { label.parent, node, label.edge };
+        forwardPath << step;
+        node = label.parent;
+    }
+    for ( int i = forwardPath.size() - 1; i >= 0; --i ) {
+        unpack( forwardPath[i].from, forwardPath[i].to, forwardPath[i].edge, segments );
+    }
+
+    for ( quint32 node = meeting; node != target; ) {
+        const Label label = labels[1].value( node );
+        unpack( node, label.parent, label.edge, segments );
+        node = label.parent;
+    }
+
+    return segments;
+}
+
+void RoutingGraph::unpack( quint32 from, quint32 to, quint32 edge, QVector<Segment> &segments ) const
+{
+    QVector<Step> stack;
+    const Step first = { from, to, edge };
+    stack << first;
+    while ( !stack.isEmpty() ) {
+        const Step step = stack.takeLast();
+        const Edge &current = m_edges[step.edge];
+        if ( !( current.flags & Shortcut ) ) {
+            const Segment segment = { step.from, step.to, current.data, current.weight };
+            segments << segment;
+            continue;
+        }
+
+        // the middle node keeps both edges the shortcut replaced
+        const quint32 middle = current.data;
+        bool found = false;
+        for ( quint32 i = m_nodes[middle].firstEdge, end = m_nodes[middle + 1].firstEdge; i < end && !found; ++i ) {
+            const Edge &toMiddle = m_edges[i];
+            if ( toMiddle.target == step.from && ( toMiddle.flags & Backward ) && toMiddle.weight < current.weight ) {
+                const quint32 fromMiddle = findEdge( middle, step.to, Forward, current.weight - toMiddle.weight );
+                if ( fromMiddle != InvalidNode ) {
+                    const Step second = { middle, step.to, fromMiddle };
+                    const Step first = { step.from, middle, i };
+                    stack << second << first;
+                    found = true;
+                }
+            }
+        }
+
+        if ( !found ) {
+            mDebug() << "Cannot unpack shortcut from" << step.from << "to" << step.to << "in" << m_file.fileName();
+        }
+    }
+}
+
+quint32 RoutingGraph::findEdge( quint32 node, quint32 target, quint32 flag, quint32 weight ) const
+{
+    for ( quint32 edge = m_nodes[node].firstEdge, end = m_nodes[node + 1].firstEdge; edge < end; ++edge ) {
+        const Edge &current = m_edges[edge];
+        if ( current.target == target && ( current.flags & flag ) && current.weight == weight ) {
+            return edge;
+        }
+    }
+
+    return InvalidNode;
+}
+
+GeoDataCoordinates RoutingGraph::coordinates( quint32 node ) const
+{
+    return GeoDataCoordinates( m_nodes[node].lon * 1e-7, m_nodes[node].lat * 1e-7, 0.0, GeoDataCoordinates::Degree );
+}
+
+int RoutingGraph::degree( quint32 node ) const
+{
+    return m_nodes[node].degree;
+}
+
+QString RoutingGraph::roadName( quint32 way ) const
+{
+    return QString::fromUtf8( m_names + m_ways[way].nameOffset, m_ways[way].nameSize );
+}
+
+QString RoutingGraph::roadType( quint32 way ) const
+{
+    if ( isRoundabout( way ) ) {
+        return QStringLiteral( "roundabout" );
+    }
+
+    return roadTypes().value( m_ways[way].roadType );
+}
+
+bool RoutingGraph::isRoundabout( quint32 way ) const
+{
+    return m_ways[way].flags & Roundabout;
+}
+
+const QStringList &RoutingGraph::roadTypes()
+{
+    static const QStringList types = QStringList()
+            << "motorway" << "motorway_link" << "trunk" << "trunk_link"
+            << "primary" << "primary_link" << "secondary" << "secondary_link"
+            << "tertiary" << "tertiary_link" << "unclassified" << "residential"
+            << "living_street" << "service" << "road" << "track"
+            << "cycleway" << "path" << "footway" << "pedestrian"
+            << "steps" << "bridleway";
+    return types;
+}
+
+QString RoutingGraph::transportName( RoutingProfile::TransportType transportType )
+{
+    switch ( transportType ) {
+    case RoutingProfile::Motorcar:
+        return QStringLiteral( "motorcar" );
+    case RoutingProfile::Bicycle:
+        return QStringLiteral( "bicycle" );
+    case RoutingProfile::Pedestrian:
+        return QStringLiteral( "pedestrian" );
+    }
+
+    return QString();
+}
+
+}
@@ -0,0 +1,167 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_ROUTINGGRAPH_H
+#define MARBLE_ROUTINGGRAPH_H
+
+#include "routing/RoutingProfile.h"
+
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Marble
+{
+
+class GeoDataCoordinates;
+class GeoDataLatLonBox;
+
+/**
+ * A routing graph preprocessed with contraction hierarchies, memory mapped
+ * from a file written by RoutingGraphBuilder.
+ *
+ * The file starts with a Header, followed by the nodes, their edges, the
+ * offsets of the nodes in each grid cell, the ways and their names.  Nodes
+ * are sorted by grid cell for nearest node lookups.  Each node only keeps
+ * the edges to nodes contracted after it, so that routes are searched from
+ * both ends upwards until the searches meet, and shortcuts are unpacked into
+ * the edges they were contracted from.
+ *
+ * The graph is not changed after loading, routes may be searched in any
+ * thread.
+ */
+class RoutingGraph
+{
+public:
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 transportType;
+        quint32 nodeCount;
+        quint32 edgeCount;
+        quint32 wayCount;
+        quint32 nameSize;
+        quint32 cellColumns;
+        quint32 cellRows;
+        qint32 cellSize;        ///< in 1e-7 degree
+        qint32 west;            ///< in 1e-7 degree, like the bounds below
+        qint32 south;
+        qint32 east;
+        qint32 north;
+    };
+
+    struct Node {
+        qint32 lon;             ///< in 1e-7 degree
+        qint32 lat;
+        quint32 firstEdge;      ///< the edges of a node end at the first edge of the next one
+        quint32 degree;         ///< number of neighbours before contraction
+    };
+
+    enum EdgeFlag {
+        Forward = 0x1,          ///< the edge leads from the node to the target
+        Backward = 0x2,         ///< the edge leads from the target to the node
+        Shortcut = 0x4          ///< data is the middle node instead of the way
+    };
+
+    struct Edge {
+        quint32 target;
+        quint32 weight;         ///< in deciseconds
+        quint32 data;
+        quint32 flags;
+    };
+
+    enum WayFlag {
+        Roundabout = 0x1
+    };
+
+    struct Way {
+        quint32 nameOffset;
+        quint16 nameSize;
+        quint8 roadType;
+        quint8 flags;
+    };
+
+    /** An edge of the graph before contraction, as a part of a route */
+    struct Segment {
+        quint32 from;
+        quint32 to;
+        quint32 way;
+        quint32 weight;
+    };
+
+    static const quint32 Magic = 0x4843524d;   // "MRCH"
+    static const quint32 Version = 1;
+    static const quint32 InvalidNode = 0xffffffff;
+
+    RoutingGraph();
+
+    ~RoutingGraph();
+
+    /**
+     * Returns the graph in @p fileName, which is loaded once and shared by
+     * all callers until the file changes.  Returns a null pointer if the
+     * file is no routing graph.
+     */
+    static QSharedPointer<const RoutingGraph> open( const QString &fileName );
+
+    bool load( const QString &fileName );
+
+    RoutingProfile::TransportType transportType() const;
+
+    GeoDataLatLonBox bounds() const;
+
+    int nodeCount() const;
+
+    /** The node nearest to @p position, InvalidNode if the graph is empty */
+    quint32 nearestNode( const GeoDataCoordinates &position ) const;
+
+    /**
+     * The fastest route from @p source to @p target.  Returns an empty
+     * route if the nodes are the same or not connected.
+     */
+    QVector<Segment> route( quint32 source, quint32 target ) const;
+
+    GeoDataCoordinates coordinates( quint32 node ) const;
+
+    /** Number of roads meeting at the node, the node is a junction if more than two */
+    int degree( quint32 node ) const;
+
+    QString roadName( quint32 way ) const;
+
+    /** The highway tag of the way, or "roundabout" */
+    QString roadType( quint32 way ) const;
+
+    bool isRoundabout( quint32 way ) const;
+
+    /** The highway tags which are stored as road types, in their order */
+    static const QStringList &roadTypes();
+
+    /** The name of @p transportType in the file names of graphs */
+    static QString transportName( RoutingProfile::TransportType transportType );
+
+private:
+    void unpack( quint32 from, quint32 to, quint32 edge, QVector<Segment> &segments ) const;
+
+    quint32 findEdge( quint32 node, quint32 target, quint32 flag, quint32 weight ) const;
+
+    QFile m_file;
+    const Header *m_header;
+    const Node *m_nodes;
+    const Edge *m_edges;
+    const quint32 *m_cells;
+    const Way *m_ways;
+    const char *m_names;
+
+    Q_DISABLE_COPY( RoutingGraph )
+};
+
+}
+
+#endif
@@ -0,0 +1,690 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "RoutingGraphBuilder.h"
+
+#include "RoutingGraph.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTypes.h"
+#include "MarbleDebug.h"
+#include "MarbleGlobal.h"
+#include "MarbleMath.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QHash>
+#include <QPair>
+#include <QSaveFile>
+#include <QVector>
+#include <qmath.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+namespace Marble
+{
+
+namespace
+{
+
+// in km/h for each of RoutingGraph::roadTypes(), 0 where the transport type is not allowed by default
+const int motorcarSpeeds[] = { 110, 60, 90, 50, 70, 50, 60, 45, 50, 40, 40, 30, 10, 15, 30, 10, 0, 0, 0, 0, 0, 0 };
+const int bicycleSpeeds[] = { 0, 0, 0, 0, 16, 16, 17, 17, 18, 18, 18, 18, 10, 15, 16, 12, 18, 12, 0, 0, 0, 0 };
+const int pedestrianSpeeds[] = { 0, 0, 0, 0, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 3, 5 };
+
+/**
+ * Contracts the nodes of a graph one after the other, starting with those
+ * whose contraction adds the fewest shortcuts.  A shortcut replaces the
+ * edges through the contracted node unless a local search finds a path
+ * around it which is not longer.
+ */
+class Contractor
+{
+public:
+    explicit Contractor( int nodeCount );
+
+    /** Adds an edge, parallel edges are reduced to the lightest one */
+    void addEdge( quint32 from, quint32 to, quint32 weight, quint32 data, bool shortcut );
+
+    /** Contracts all nodes and returns the edges of each node to the nodes contracted later */
+    QVector<QVector<RoutingGraph::Edge> > contract();
+
+private:
+    struct Arc {
+        quint32 node;
+        quint32 weight;
+        quint32 data;
+        bool shortcut;
+    };
+
+    struct Candidate {
+        quint32 from;
+        quint32 to;
+        quint32 weight;
+    };
+
+    typedef QPair<quint32, quint32> QueueItem;
+    typedef std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > Queue;
+
+    // settled nodes after which witness searches give up and add the shortcut
+    static const int SimulationLimit = 100;
+    static const int ContractionLimit = 1000;
+
+    int priority( quint32 node );
+
+    void findShortcuts( quint32 node, int settleLimit, QVector<Candidate> &shortcuts );
+
+    void witnessSearch( quint32 source, quint32 excluded, quint32 maxWeight, int settleLimit );
+
+    static void removeArcs( QVector<Arc> &arcs, quint32 node );
+
+    static void merge( QVector<RoutingGraph::Edge> &edges );
+
+    QVector<QVector<Arc> > m_out;
+    QVector<QVector<Arc> > m_in;
+    QVector<int> m_deletedNeighbours;
+    QVector<quint32> m_distances;
+    QVector<quint32> m_touched;
+};
+
+const quint32 Infinity = std::numeric_limits<quint32>::max();
+
+Contractor::Contractor( int nodeCount ) :
+    m_out( nodeCount ),
+    m_in( nodeCount ),
+    m_deletedNeighbours( nodeCount, 0 ),
+    m_distances( nodeCount, Infinity )
+{
+    // nothing to do
+}
+
+void Contractor::addEdge( quint32 from, quint32 to, quint32 weight, quint32 data, bool shortcut )
+{
+    if ( from == to ) {
+        return;
+    }
+
+    for ( Arc &arc: m_out[from] ) {
+        if ( arc.node == to ) {
+            if ( weight < arc.weight ) {
+                arc.weight = weight;
+                arc.data = data;
+                arc.shortcut = shortcut;
+                for ( Arc &reverse: m_in[to] ) {
+                    if ( reverse.node == from ) {
+                        reverse.weight = weight;
+                        reverse.data = data;
+                        reverse.shortcut = shortcut;
+                    }
+                }
+            }
+            return;
+        }
+    }
+
+    const Arc out = { to, weight, data, shortcut };
+    m_out[from] << out;
+    const Arc in = { from, weight, data, shortcut };
+    m_in[to] << in;
+}
+
+QVector<QVector<RoutingGraph::Edge> > Contractor::contract()
+{
+    const int nodeCount = m_out.size();
+    QVector<QVector<RoutingGraph::Edge> > result( nodeCount );
+    QVector<bool> contracted( nodeCount, false );
+    QVector<Candidate> shortcuts;
+
+    // the priorities are updated lazily: a node is contracted when its current priority is still the lowest
+    typedef QPair<int, quint32> PriorityItem;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem> > queue;
+    for ( int node = 0; node < nodeCount; ++node ) {
+        queue.push( PriorityItem( priority( node ), node ) );
+    }
+
+    while ( !queue.empty() ) {
+        const quint32 node = queue.top().second;
+        queue.pop();
+        if ( contracted[node] ) {
+            continue;
+        }
+
+        const int current = priority( node );
+        if ( !queue.empty() && current > queue.top().first ) {
+            queue.push( PriorityItem( current, node ) );
+            continue;
+        }
+
+        findShortcuts( node, ContractionLimit, shortcuts );
+
+        QVector<RoutingGraph::Edge> &edges = result[node];
+        QVector<quint32> neighbours;
+        for ( const Arc &arc: m_out[node] ) {
+            const RoutingGraph::Edge edge = { arc.node, arc.weight, arc.data, quint32( RoutingGraph::Forward | ( arc.shortcut ? RoutingGraph::Shortcut : 0 ) ) };
+            edges << edge;
+            removeArcs( m_in[arc.node], node );
+            neighbours << arc.node;
+        }
+        for ( const Arc &arc: m_in[node] ) {
+            const RoutingGraph::Edge edge = { arc.node, arc.weight, arc.data, quint32( RoutingGraph::Backward | ( arc.shortcut ? RoutingGraph::Shortcut : 0 ) ) };
+            edges << edge;
+            removeArcs( m_out[arc.node], node );
+            neighbours << arc.node;
+        }
+        merge( edges );
+
+        std::sort( neighbours.begin(), neighbours.end() );
+        neighbours.erase( std::unique( neighbours.begin(), neighbours.end() ), neighbours.end() );
+        for ( quint32 neighbour: neighbours ) {
+            ++m_deletedNeighbours[neighbour];
+        }
+
+        m_out[node] = QVector<Arc>();
+        m_in[node] = QVector<Arc>();
+        contracted[node] = true;
+
+        for ( const Candidate &shortcut: shortcuts ) {
+            addEdge( shortcut.from, shortcut.to, shortcut.weight, node, true );
+        }
+    }
+
+    return result;
+}
+
+int Contractor::priority( quint32 node )
+{
+    QVector<Candidate> shortcuts;
+    findShortcuts( node, SimulationLimit, shortcuts );
+    const int removed = m_out[node].size() + m_in[node].size();
+    return 2 * ( shortcuts.size() - removed ) + m_deletedNeighbours[node];
+}
+
+void Contractor::findShortcuts( quint32 node, int settleLimit, QVector<Candidate> &shortcuts )
+{
+    shortcuts.clear();
+    for ( const Arc &in: m_in[node] ) {
+        quint32 maxWeight = 0;
+        for ( const Arc &out: m_out[node] ) {
+            if ( out.node != in.node ) {
+                maxWeight = qMax( maxWeight, in.weight + out.weight );
+            }
+        }
+        if ( maxWeight == 0 ) {
+            continue;
+        }
+
+        witnessSearch( in.node, node, maxWeight, settleLimit );
+        for ( const Arc &out: m_out[node] ) {
+            if ( out.node != in.node && m_distances[out.node] > in.weight + out.weight ) {
+                const Candidate shortcut = { in.node, out.node, in.weight + out.weight };
+                shortcuts << shortcut;
+            }
+        }
+
+        for ( quint32 touched: m_touched ) {
+            m_distances[touched] = Infinity;
+        }
+        m_touched.clear();
+    }
+}
+
+void Contractor::witnessSearch( quint32 source, quint32 excluded, quint32 maxWeight, int settleLimit )
+{
+    Queue queue;
+    m_distances[source] = 0;
+    m_touched << source;
+    queue.push( QueueItem( 0, source ) );
+    int settled = 0;
+    while ( !queue.empty() ) {
+        const QueueItem item = queue.top();
+        queue.pop();
+        if ( item.first > m_distances[item.second] ) {
+            continue;
+        }
+        if ( item.first > maxWeight || ++settled > settleLimit ) {
+            break;
+        }
+
+        for ( const Arc &arc: m_out[item.second] ) {
+            if ( arc.node == excluded ) {
+                continue;
+            }
+
+            const quint32 distance = item.first + arc.weight;
+            if ( distance < m_distances[arc.node] ) {
+                if ( m_distances[arc.node] == Infinity ) {
+                    m_touched << arc.node;
+                }
+                m_distances[arc.node] = distance;
+                queue.push( QueueItem( distance, arc.node ) );
+            }
+        }
+    }
+}
+
+void Contractor::removeArcs( QVector<Arc> &arcs, quint32 node )
+{
+    arcs.erase( std::remove_if( arcs.begin(), arcs.end(), [node]( const Arc &arc ) {
+        return arc.node == node;
+    } ), arcs.end() );
+}
+
+void Contractor::merge( QVector<RoutingGraph::Edge> &edges )
+{
+    // an edge in both directions is kept once with both flags
+    const auto key = []( const RoutingGraph::Edge &edge ) {
+        return std::make_tuple( edge.target, edge.weight, edge.data, edge.flags & RoutingGraph::Shortcut );
+    };
+    std::sort( edges.begin(), edges.end(), [&key]( const RoutingGraph::Edge &a, const RoutingGraph::Edge &b ) {
+        return key( a ) < key( b );
+    } );
+
+    int size = 0;
+    for ( int i = 0; i < edges.size(); ++i ) {
+        if ( size > 0 && key( edges[size - 1] ) == key( edges[i] ) ) {
+            edges[size - 1].flags |= edges[i].flags;
+        } else {
+            edges[size++] = edges[i];
+        }
+    }
+    edges.resize( size );
+}
+
+}
+
+class RoutingGraphBuilder::Private
+{
+public:
+    struct Position {
+        qint32 lon;
+        qint32 lat;
+    };
+
+    struct Edge {
+        quint32 from;
+        quint32 to;
+        quint32 weight;
+        quint32 way;
+    };
+
+    enum Direction {
+        BothDirections,
+        ForwardDirection,
+        BackwardDirection
+    };
+
+    // parts of the graph with fewer nodes are not connected to its main part
+    static const int MinimumComponentSize = 1000;
+    static const int NodesPerCell = 8;
+    static const qint64 MinimumCellSize = 1000;
+    static const qint64 MaximumCells = 1 << 24;
+
+    explicit Private( RoutingProfile::TransportType transportType );
+
+    void addWay( const GeoDataPlacemark *placemark );
+
+    qreal speed( const OsmPlacemarkData &osmData, int roadType ) const;
+
+    Direction direction( const OsmPlacemarkData &osmData, const QString &highway ) const;
+
+    quint32 node( const GeoDataCoordinates &coordinates, const OsmPlacemarkData &osmData );
+
+    quint32 way( const QString &name, int roadType, bool roundabout );
+
+    QVector<quint32> connectedNodes() const;
+
+    RoutingProfile::TransportType m_transportType;
+    QHash<qint64, quint32> m_nodeIds;
+    QHash<GeoDataCoordinates, quint32> m_anonymousNodes;
+    QVector<Position> m_positions;
+    QVector<Edge> m_edges;
+    QVector<RoutingGraph::Way> m_ways;
+    QByteArray m_names;
+    QHash<QString, quint32> m_nameOffsets;
+};
+
+const int RoutingGraphBuilder::Private::MinimumComponentSize;
+const int RoutingGraphBuilder::Private::NodesPerCell;
+const qint64 RoutingGraphBuilder::Private::MinimumCellSize;
+const qint64 RoutingGraphBuilder::Private::MaximumCells;
+
+RoutingGraphBuilder::Private::Private( RoutingProfile::TransportType transportType ) :
+    m_transportType( transportType )
+{
+    Q_ASSERT( sizeof( motorcarSpeeds ) / sizeof( int ) == uint( RoutingGraph::roadTypes().size() ) );
+    Q_ASSERT( sizeof( bicycleSpeeds ) / sizeof( int ) == uint( RoutingGraph::roadTypes().size() ) );
+    Q_ASSERT( sizeof( pedestrianSpeeds ) / sizeof( int ) == uint( RoutingGraph::roadTypes().size() ) );
+}
+
+void RoutingGraphBuilder::Private::addWay( const GeoDataPlacemark *placemark )
+{
+    if ( !placemark->geometry() || placemark->geometry()->nodeType() != GeoDataTypes::GeoDataLineStringType ) {
+        return;
+    }
+
+    const OsmPlacemarkData &osmData = placemark->osmData();
+    const QString highway = osmData.tagValue( QStringLiteral( "highway" ) );
+    const int roadType = RoutingGraph::roadTypes().indexOf( highway );
+    if ( roadType < 0 ) {
+        return;
+    }
+
+    const qreal metersPerDecisecond = speed( osmData, roadType ) / 36.0;
+    if ( metersPerDecisecond <= 0.0 ) {
+        return;
+    }
+
+    const Direction oneway = direction( osmData, highway );
+    const bool roundabout = osmData.tagValue( QStringLiteral( "junction" ) ) == QLatin1String( "roundabout" );
+    const quint32 way = this->way( placemark->name(), roadType, roundabout );
+
+    const GeoDataLineString *lineString = static_cast<const GeoDataLineString*>( placemark->geometry() );
+    quint32 previous = RoutingGraph::InvalidNode;
+    for ( int i = 0; i < lineString->size(); ++i ) {
+        const quint32 current = node( lineString->at( i ), osmData );
+        if ( previous != RoutingGraph::InvalidNode && previous != current ) {
+            const qreal distance = EARTH_RADIUS * distanceSphere( lineString->at( i - 1 ), lineString->at( i ) );
+            const quint32 weight = qMax( 1, qRound( distance / metersPerDecisecond ) );
+            if ( oneway != BackwardDirection ) {
+                const Edge edge = { previous, current, weight, way };
+                m_edges << edge;
+            }
+            if ( oneway != ForwardDirection ) {
+                const Edge edge = { current, previous, weight, way };
+                m_edges << edge;
+            }
+        }
+        previous = current;
+    }
+}
+
+qreal RoutingGraphBuilder::Private::speed( const OsmPlacemarkData &osmData, int roadType ) const
+{
+    QStringList keys;
+    qreal speed = 0.0;
+    qreal permittedSpeed = 0.0;
+    switch ( m_transportType ) {
+    case RoutingProfile::Motorcar:
+        keys << "motorcar" << "motor_vehicle" << "vehicle";
+        speed = motorcarSpeeds[roadType];
+        permittedSpeed = 20.0;
+        break;
+    case RoutingProfile::Bicycle:
+        keys << "bicycle" << "vehicle";
+        speed = bicycleSpeeds[roadType];
+        permittedSpeed = 10.0;
+        break;
+    case RoutingProfile::Pedestrian:
+        keys << "foot";
+        speed = pedestrianSpeeds[roadType];
+        permittedSpeed = 5.0;
+        break;
+    }
+    keys << "access";
+
+    // the most specific access tag decides, roads closed by default are only opened for the transport type itself
+    static const QStringList denied = QStringList() << "no" << "private" << "agricultural" << "forestry";
+    static const QStringList permitted = QStringList() << "yes" << "designated" << "permissive" << "destination" << "customers";
+    for ( const QString &key: keys ) {
+        const QString value = osmData.tagValue( key );
+        if ( denied.contains( value ) ) {
+            return 0.0;
+        }
+        if ( permitted.contains( value ) ) {
+            if ( speed <= 0.0 && key != QLatin1String( "access" ) ) {
+                speed = permittedSpeed;
+            }
+            break;
+        }
+    }
+
+    if ( m_transportType == RoutingProfile::Motorcar && speed > 0.0 ) {
+        const QString maxspeed = osmData.tagValue( QStringLiteral( "maxspeed" ) );
+        bool ok = false;
+        qreal limit = maxspeed.section( QLatin1Char( ' ' ), 0, 0 ).toDouble( &ok );
+        if ( ok && limit > 0.0 ) {
+            if ( maxspeed.endsWith( QLatin1String( "mph" ) ) ) {
+                limit *= 1.609344;
+            }
+            speed = limit;
+        }
+    }
+
+    return speed;
+}
+
+RoutingGraphBuilder::Private::Direction RoutingGraphBuilder::Private::direction( const OsmPlacemarkData &osmData, const QString &highway ) const
+{
+    if ( m_transportType == RoutingProfile::Pedestrian ) {
+        return BothDirections;
+    }
+    if ( m_transportType == RoutingProfile::Bicycle && osmData.tagValue( QStringLiteral( "oneway:bicycle" ) ) == QLatin1String( "no" ) ) {
+        return BothDirections;
+    }
+
+    const QString oneway = osmData.tagValue( QStringLiteral( "oneway" ) );
+    if ( oneway == QLatin1String( "yes" ) || oneway == QLatin1String( "true" ) || oneway == QLatin1String( "1" ) ) {
+        return ForwardDirection;
+    }
+    if ( oneway == QLatin1String( "-1" ) || oneway == QLatin1String( "reverse" ) ) {
+        return BackwardDirection;
+    }
+
+    const bool impliedOneway = osmData.tagValue( QStringLiteral( "junction" ) ) == QLatin1String( "roundabout" ) ||
+                               highway == QLatin1String( "motorway" ) || highway == QLatin1String( "motorway_link" );
+    return oneway.isEmpty() && impliedOneway ? ForwardDirection : BothDirections;
+}
+
+quint32 RoutingGraphBuilder::Private::node( const GeoDataCoordinates &coordinates, const OsmPlacemarkData &osmData )
+{
+    // nodes are shared by ways through their id, or their position if the document has no ids
+    const qint64 id = osmData.containsNodeReference( coordinates ) ? osmData.nodeReference( coordinates ).id() : 0;
+    const quint32 known = id != 0 ? m_nodeIds.value( id, RoutingGraph::InvalidNode )
+                                  : m_anonymousNodes.value( coordinates, RoutingGraph::InvalidNode );
+    if ( known != RoutingGraph::InvalidNode ) {
+        return known;
+    }
+
+    const quint32 node = m_positions.size();
+    const Position position = { qint32( qRound( coordinates.longitude( GeoDataCoordinates::Degree ) * 1e7 ) ),
+                                qint32( qRound( coordinates.latitude( GeoDataCoordinates::Degree ) * 1e7 ) ) };
+    m_positions << position;
+    if ( id != 0 ) {
+        m_nodeIds.insert( id, node );
+    } else {
+        m_anonymousNodes.insert( coordinates, node );
+    }
+    return node;
+}
+
+quint32 RoutingGraphBuilder::Private::way( const QString &name, int roadType, bool roundabout )
+{
+    const QByteArray utf8 = name.toUtf8().left( std::numeric_limits<quint16>::max() );
+    auto offset = m_nameOffsets.constFind( name );
+    if ( offset == m_nameOffsets.constEnd() ) {
+        offset = m_nameOffsets.insert( name, m_names.size() );
+        m_names += utf8;
+    }
+
+    const RoutingGraph::Way way = { offset.value(), quint16( utf8.size() ), quint8( roadType ), quint8( roundabout ? RoutingGraph::Roundabout : 0 ) };
+    m_ways << way;
+    return m_ways.size() - 1;
+}
+
+QVector<quint32> RoutingGraphBuilder::Private::connectedNodes() const
+{
+    QVector<quint32> parents( m_positions.size() );
+    std::iota( parents.begin(), parents.end(), 0 );
+    const auto find = [&parents]( quint32 node ) {
+        while ( parents[node] != node ) {
+            parents[node] = parents[parents[node]];
+            node = parents[node];
+        }
+        return node;
+    };
+    for ( const Edge &edge: m_edges ) {
+        parents[find( edge.from )] = find( edge.to );
+    }
+
+    QVector<int> sizes( m_positions.size(), 0 );
+    int largest = 0;
+    for ( int node = 0; node < m_positions.size(); ++node ) {
+        largest = qMax( largest, ++sizes[find( node )] );
+    }
+
+    const int minimumSize = qMin( largest, int( MinimumComponentSize ) );
+    QVector<quint32> result;
+    for ( int node = 0; node < m_positions.size(); ++node ) {
+        if ( sizes[find( node )] >= minimumSize ) {
+            result << node;
+        }
+    }
+    return result;
+}
+
+RoutingGraphBuilder::RoutingGraphBuilder( RoutingProfile::TransportType transportType ) :
+    d( new Private( transportType ) )
+{
+    // nothing to do
+}
+
+RoutingGraphBuilder::~RoutingGraphBuilder()
+{
+    delete d;
+}
+
+void RoutingGraphBuilder::addDocument( const GeoDataDocument *document )
+{
+    for ( const GeoDataPlacemark *placemark: document->placemarkList() ) {
+        d->addWay( placemark );
+    }
+}
+
+int RoutingGraphBuilder::nodeCount() const
+{
+    return d->m_positions.size();
+}
+
+int RoutingGraphBuilder::edgeCount() const
+{
+    return d->m_edges.size();
+}
+
+bool RoutingGraphBuilder::write( const QString &fileName ) const
+{
+    QVector<quint32> nodes = d->connectedNodes();
+    if ( nodes.isEmpty() ) {
+        mDebug() << "No roads for" << RoutingGraph::transportName( d->m_transportType ) << "to write to" << fileName;
+        return false;
+    }
+
+    RoutingGraph::Header header = RoutingGraph::Header();
+    header.magic = RoutingGraph::Magic;
+    header.version = RoutingGraph::Version;
+    header.transportType = d->m_transportType;
+    header.west = header.south = std::numeric_limits<qint32>::max();
+    header.east = header.north = std::numeric_limits<qint32>::min();
+    for ( quint32 node: nodes ) {
+        const Private::Position &position = d->m_positions[node];
+        header.west = qMin( header.west, position.lon );
+        header.east = qMax( header.east, position.lon );
+        header.south = qMin( header.south, position.lat );
+        header.north = qMax( header.north, position.lat );
+    }
+
+    // a grid of square cells with a few nodes each on average
+    const qint64 width = qint64( header.east ) - header.west + 1;
+    const qint64 height = qint64( header.north ) - header.south + 1;
+    const qreal cellArea = qreal( width ) * height * Private::NodesPerCell / nodes.size();
+    qint64 cellSize = qMax( Private::MinimumCellSize, qint64( qCeil( qSqrt( cellArea ) ) ) );
+    while ( ( width / cellSize + 1 ) * ( height / cellSize + 1 ) > Private::MaximumCells ) {
+        cellSize *= 2;
+    }
+    header.cellSize = cellSize;
+    header.cellColumns = width / cellSize + 1;
+    header.cellRows = height / cellSize + 1;
+    const auto cell = [&]( quint32 node ) {
+        const Private::Position &position = d->m_positions[node];
+        return ( qint64( position.lat ) - header.south ) / cellSize * header.cellColumns + ( qint64( position.lon ) - header.west ) / cellSize;
+    };
+
+    // nodes are numbered in the order of their cells
+    std::sort( nodes.begin(), nodes.end(), [&cell]( quint32 a, quint32 b ) {
+        return cell( a ) < cell( b ) || ( cell( a ) == cell( b ) && a < b );
+    } );
+    QVector<quint32> index( d->m_positions.size(), RoutingGraph::InvalidNode );
+    for ( int i = 0; i < nodes.size(); ++i ) {
+        index[nodes[i]] = i;
+    }
+
+    QVector<quint32> cells( header.cellColumns * header.cellRows + 1, 0 );
+    for ( quint32 node: nodes ) {
+        ++cells[cell( node ) + 1];
+    }
+    std::partial_sum( cells.begin(), cells.end(), cells.begin() );
+
+    Contractor contractor( nodes.size() );
+    QVector<quint64> neighbours;
+    for ( const Private::Edge &edge: d->m_edges ) {
+        const quint32 from = index[edge.from];
+        const quint32 to = index[edge.to];
+        if ( from != RoutingGraph::InvalidNode && to != RoutingGraph::InvalidNode ) {
+            contractor.addEdge( from, to, edge.weight, edge.way, false );
+            neighbours << ( quint64( qMin( from, to ) ) << 32 | qMax( from, to ) );
+        }
+    }
+
+    std::sort( neighbours.begin(), neighbours.end() );
+    neighbours.erase( std::unique( neighbours.begin(), neighbours.end() ), neighbours.end() );
+    QVector<RoutingGraph::Node> graphNodes( nodes.size() + 1 );
+    for ( int i = 0; i < nodes.size(); ++i ) {
+        graphNodes[i].lon = d->m_positions[nodes[i]].lon;
+        graphNodes[i].lat = d->m_positions[nodes[i]].lat;
+        graphNodes[i].degree = 0;
+    }
+    for ( quint64 pair: neighbours ) {
+        ++graphNodes[pair >> 32].degree;
+        ++graphNodes[pair & 0xffffffff].degree;
+    }
+
+    const QVector<QVector<RoutingGraph::Edge> > contracted = contractor.contract();
+    QVector<RoutingGraph::Edge> edges;
+    for ( int i = 0; i < contracted.size(); ++i ) {
+        graphNodes[i].firstEdge = edges.size();
+        edges += contracted[i];
+    }
+    graphNodes.last().firstEdge = edges.size();
+
+    header.nodeCount = nodes.size();
+    header.edgeCount = edges.size();
+    header.wayCount = d->m_ways.size();
+    header.nameSize = d->m_names.size();
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "Cannot write routing graph" << fileName << file.errorString();
+        return false;
+    }
+
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    file.write( reinterpret_cast<const char*>( graphNodes.constData() ), graphNodes.size() * sizeof( RoutingGraph::Node ) );
+    file.write( reinterpret_cast<const char*>( edges.constData() ), edges.size() * sizeof( RoutingGraph::Edge ) );
+    file.write( reinterpret_cast<const char*>( cells.constData() ), cells.size() * sizeof( quint32 ) );
+    file.write( reinterpret_cast<const char*>( d->m_ways.constData() ), d->m_ways.size() * sizeof( RoutingGraph::Way ) );
+    file.write( d->m_names );
+    return file.commit();
+}
+
+}
@@ -0,0 +1,55 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_ROUTINGGRAPHBUILDER_H
+#define MARBLE_ROUTINGGRAPHBUILDER_H
+
+#include "routing/RoutingProfile.h"
+
+#include <QString>
+
+namespace Marble
+{
+
+class GeoDataDocument;
+
+/**
+ * Builds the routing graph of one transport type from the highways of OSM
+ * documents as created by the OSM parser, with travel times from the road
+ * type, maxspeed, access and oneway tags.  The graph is preprocessed with
+ * contraction hierarchies when it is written, see RoutingGraph for the file.
+ */
+class RoutingGraphBuilder
+{
+public:
+    explicit RoutingGraphBuilder( RoutingProfile::TransportType transportType );
+
+    ~RoutingGraphBuilder();
+
+    /** Adds the highways of @p document the transport type may use */
+    void addDocument( const GeoDataDocument *document );
+
+    int nodeCount() const;
+
+    int edgeCount() const;
+
+    /**
+     * Contracts the graph and writes it to @p fileName.  Nodes in parts of
+     * the graph not connected to its main part are left out.
+     */
+    bool write( const QString &fileName ) const;
+
+private:
+    Q_DISABLE_COPY( RoutingGraphBuilder )
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif
@@ -29,6 +29,7 @@ DatabaseQuery::DatabaseQuery( const MarbleModel* model, const QString &searchTer
         m_resultFormat = DistanceFormat;
     } else if ( !preferred.isEmpty() ) {
         m_position = preferred.center();
+        m_preferred = preferred;
         m_resultFormat = AddressFormat;
     } else {
         m_resultFormat = AddressFormat;
@@ -217,4 +218,9 @@ GeoDataCoordinates DatabaseQuery::position() const
     return m_position;
 }
 
+GeoDataLatLonBox DatabaseQuery::preferred() const
+{
+    return m_preferred;
+}
+
 }
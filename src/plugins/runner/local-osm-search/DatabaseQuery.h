@@ -13,6 +13,7 @@
 #define MARBLE_DATABASEQUERY_H
 
 #include "GeoDataCoordinates.h"
+#include "GeoDataLatLonBox.h"
 #include "OsmPlacemark.h"
 
 #include <QString>
@@ -20,7 +21,6 @@
 namespace Marble {
 
 class MarbleModel;
-class GeoDataLatLonBox;
 
 /**
   * Parse result of a user's search term
@@ -57,6 +57,9 @@ public:
 
     GeoDataCoordinates position() const;
 
+    /** The region results close to position() are searched in first, may be empty */
+    GeoDataLatLonBox preferred() const;
+
 private:
     bool isPointOfInterest( const QString &category );
 
@@ -71,6 +74,8 @@ private:
 
     GeoDataCoordinates m_position;
 
+    GeoDataLatLonBox m_preferred;
+
     OsmPlacemark::OsmCategory m_category;
 };
 
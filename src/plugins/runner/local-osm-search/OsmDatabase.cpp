@@ -20,6 +20,12 @@
 #include "PositionTracking.h"
 
 #include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadStorage>
 #include <QTime>
 
 #include <QSqlDatabase>
@@ -65,6 +71,116 @@ private:
     const DatabaseQuery *const m_currentQuery;
 };
 
+/// Results returned by a search at most
+const int maxResults = 50;
+
+}
+
+class OsmDatabase::Connection
+{
+public:
+    Connection( const QString &fileName, const QString &connectionName );
+    ~Connection();
+
+    bool isOpen() const;
+
+    /** Whether the database file changed since the connection was opened */
+    bool isOutdated() const;
+
+    QString fileName() const;
+
+    /** The names have a trigram full text index in table namesFts */
+    bool hasNameIndex() const;
+
+    /** The placemarks have an R*-tree in table placemarksRtree */
+    bool hasSpatialIndex() const;
+
+    /** Returns the query for @p statement, which is only prepared when used the first time */
+    QSqlQuery &query( const QString &statement );
+
+private:
+    const QString m_fileName;
+    const QString m_connectionName;
+    const QDateTime m_lastModified;
+    bool m_isOpen;
+    bool m_hasNameIndex;
+    bool m_hasSpatialIndex;
+    QHash<QString, QSqlQuery> m_queries;
+};
+
+OsmDatabase::Connection::Connection( const QString &fileName, const QString &connectionName ) :
+    m_fileName( fileName ),
+    m_connectionName( connectionName ),
+    m_lastModified( QFileInfo( fileName ).lastModified() ),
+    m_isOpen( false ),
+    m_hasNameIndex( false ),
+    m_hasSpatialIndex( false )
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase( QStringLiteral( "QSQLITE" ), m_connectionName );
+    database.setDatabaseName( fileName );
+    database.setConnectOptions( QStringLiteral( "QSQLITE_OPEN_READONLY" ) );
+    if ( !database.open() ) {
+        qWarning() << "Failed to connect to database" << fileName << database.lastError().text();
+        return;
+    }
+
+    // Databases written by older versions of osm-addresses or by an SQLite without FTS5 and
+    // R*-tree support lack the indexes, and so does the SQLite we read them with, possibly
+    QSqlQuery check( database );
+    m_hasNameIndex = check.exec( QStringLiteral( "SELECT rowid FROM namesFts LIMIT 1" ) );
+    m_hasSpatialIndex = check.exec( QStringLiteral( "SELECT id FROM placemarksRtree LIMIT 1" ) );
+    m_isOpen = true;
+}
+
+OsmDatabase::Connection::~Connection()
+{
+    // All queries must be gone before the connection can be removed
+    m_queries.clear();
+
+    {
+        QSqlDatabase database = QSqlDatabase::database( m_connectionName, false );
+        database.close();
+    }
+    QSqlDatabase::removeDatabase( m_connectionName );
+}
+
+bool OsmDatabase::Connection::isOpen() const
+{
+    return m_isOpen;
+}
+
+bool OsmDatabase::Connection::isOutdated() const
+{
+    return QFileInfo( m_fileName ).lastModified() != m_lastModified;
+}
+
+QString OsmDatabase::Connection::fileName() const
+{
+    return m_fileName;
+}
+
+bool OsmDatabase::Connection::hasNameIndex() const
+{
+    return m_hasNameIndex;
+}
+
+bool OsmDatabase::Connection::hasSpatialIndex() const
+{
+    return m_hasSpatialIndex;
+}
+
+QSqlQuery &OsmDatabase::Connection::query( const QString &statement )
+{
+    QHash<QString, QSqlQuery>::iterator iter = m_queries.find( statement );
+    if ( iter == m_queries.end() ) {
+        QSqlQuery query( QSqlDatabase::database( m_connectionName, false ) );
+        query.setForwardOnly( true );
+        if ( !query.prepare( statement ) ) {
+            qWarning() << query.lastError() << "in" << m_fileName << "with query" << statement;
+        }
+        iter = m_queries.insert( statement, query );
+    }
+    return iter.value();
 }
 
 OsmDatabase::OsmDatabase( const QStringList &databaseFiles ) :
@@ -78,141 +194,256 @@ QVector<OsmPlacemark> OsmDatabase::find( const DatabaseQuery &userQuery )
         return QVector<OsmPlacemark>();
     }
 
-    QSqlDatabase database = QSqlDatabase::addDatabase( "QSQLITE", QString( "marble/local-osm-search-%1" ).arg( reinterpret_cast<size_t>( this ) ) );
-
     QVector<OsmPlacemark> result;
     QTime timer;
     timer.start();
     for( const QString &databaseFile: m_databaseFiles ) {
-        database.setDatabaseName( databaseFile );
-        if ( !database.open() ) {
-            qWarning() << "Failed to connect to database" << databaseFile;
+        Connection *const connection = OsmDatabase::connection( databaseFile );
+        if ( connection ) {
+            /** @todo: sort/filter results from several databases */
+            result << find( connection, userQuery );
         }
+    }
 
-        QString regionRestriction;
-        if ( !userQuery.region().isEmpty() ) {
-            QTime regionTimer;
-            regionTimer.start();
-            // Nested set model to support region hierarchies, see http://en.wikipedia.org/wiki/Nested_set_model
-            const QString regionsQueryString = QLatin1String("SELECT lft, rgt FROM regions WHERE name LIKE '%") + userQuery.region() + QLatin1String("%';");
-            QSqlQuery regionsQuery( regionsQueryString, database );
-            if ( regionsQuery.lastError().isValid() ) {
-                qWarning() << regionsQuery.lastError() << "in" << databaseFile << "with query" << regionsQuery.lastQuery();
-            }
-            regionRestriction = " AND (";
-            int regionCount = 0;
-            while ( regionsQuery.next() ) {
-                if ( regionCount > 0 ) {
-                    regionRestriction += QLatin1String(" OR ");
-                }
-                regionRestriction += QLatin1String(" (regions.lft >= ") + regionsQuery.value( 0 ).toString() +
-                                     QLatin1String(" AND regions.lft <= ") + regionsQuery.value( 1 ).toString() + QLatin1Char(')');
-                regionCount++;
-            }
-            regionRestriction += QLatin1Char(')');
+    mDebug() << "Offline OSM search query took" << timer.elapsed() << "ms for" << result.count() << "results.";
+
+    std::sort( result.begin(), result.end() );
+    makeUnique( result );
+
+    if ( userQuery.position().isValid() ) {
+        const PlacemarkSmallerDistance placemarkSmallerDistance( userQuery.position() );
+        std::sort( result.begin(), result.end(), placemarkSmallerDistance );
+    } else {
+        const PlacemarkHigherScore placemarkHigherScore( &userQuery );
+        std::sort( result.begin(), result.end(), placemarkHigherScore );
+    }
+
+    if ( result.size() > maxResults ) {
+        result.remove( maxResults, result.size()-maxResults );
+    }
+
+    return result;
+}
+
+OsmDatabase::Connection *OsmDatabase::connection( const QString &databaseFile )
+{
+    // Connections can only be used in the thread that opened them
+    static QThreadStorage<QHash<QString, QSharedPointer<Connection> > > connections;
 
-            mDebug() << Q_FUNC_INFO << "region query in" << databaseFile << "with query" << regionsQueryString
-                     << "took" << regionTimer.elapsed() << "ms for" << regionCount << "results";
+    QHash<QString, QSharedPointer<Connection> > &threadConnections = connections.localData();
+    QSharedPointer<Connection> connection = threadConnections.value( databaseFile );
+
+    // A database regenerated by osm-addresses has to be opened again
+    if ( connection && connection->isOutdated() ) {
+        threadConnections.remove( databaseFile );
+        connection.clear();
+    }
+
+    if ( !connection ) {
+        const QString connectionName = QLatin1String( "marble/local-osm-search-" ) +
+                QString::number( quintptr( QThread::currentThreadId() ) ) + QLatin1Char( '/' ) + databaseFile;
+        connection = QSharedPointer<Connection>( new Connection( databaseFile, connectionName ) );
+        threadConnections.insert( databaseFile, connection );
+    }
+
+    return connection->isOpen() ? connection.data() : 0;
+}
+
+QVector<OsmPlacemark> OsmDatabase::find( Connection *connection, const DatabaseQuery &userQuery )
+{
+    // The regions are looked up once, the placemark statements only compare with their ranges
+    RegionRanges regions;
+    if ( !userQuery.region().isEmpty() && !regionRanges( connection, userQuery.region(), regions ) ) {
+        return QVector<OsmPlacemark>();
+    }
+
+    const GeoDataCoordinates position = userQuery.position();
+    if ( userQuery.queryType() != DatabaseQuery::CategorySearch || !position.isValid() || !connection->hasSpatialIndex() ) {
+        return find( connection, userQuery, regions, GeoDataLatLonBox() );
+    }
+
+    // Categories match a large part of the database. Sorting all of it by distance
+    // is slow, so search close to the position first and widen the area until
+    // there are enough results.
+    GeoDataLatLonBox bounds = userQuery.preferred();
+    if ( bounds.isEmpty() ) {
+        const qreal radius = 10.0 * KM2METER / EARTH_RADIUS;
+        bounds = GeoDataLatLonBox( position.latitude() + radius, position.latitude() - radius,
+                                   position.longitude() + radius, position.longitude() - radius );
+    }
 
-            if ( regionCount == 0 ) {
-                continue;
+    const qreal latitude = position.latitude( GeoDataCoordinates::Degree );
+    const qreal longitude = position.longitude( GeoDataCoordinates::Degree );
+    const qreal lonScale = cos( position.latitude() );
+    for ( int i = 0; i < 4 && !bounds.crossesDateLine(); ++i ) {
+        const QVector<OsmPlacemark> result = find( connection, userQuery, regions, bounds );
+        if ( result.size() >= maxResults ) {
+            // Done unless a placemark outside of the area could be closer than the farthest one found
+            const OsmPlacemark &farthest = result.last();
+            const qreal border = qMin( qMin( bounds.north( GeoDataCoordinates::Degree ) - latitude,
+                                             latitude - bounds.south( GeoDataCoordinates::Degree ) ),
+                                       lonScale * qMin( bounds.east( GeoDataCoordinates::Degree ) - longitude,
+                                                        longitude - bounds.west( GeoDataCoordinates::Degree ) ) );
+            const qreal deltaLat = farthest.latitude() - latitude;
+            const qreal deltaLon = lonScale * ( farthest.longitude() - longitude );
+            if ( deltaLat * deltaLat + deltaLon * deltaLon <= border * border ) {
+                return result;
             }
         }
+        bounds = bounds.scaled( 4.0, 4.0 );
+    }
 
-        QString queryString;
-
-        queryString = " SELECT regions.name,"
-                " places.name, places.number,"
-                " places.category, places.lon, places.lat"
-                " FROM regions, places";
-
-        if ( userQuery.queryType() == DatabaseQuery::CategorySearch ) {
-            queryString += QLatin1String(" WHERE regions.id = places.region");
-            if( userQuery.category() == OsmPlacemark::UnknownCategory ) {
-                // search for all pois which are not street nor address
-                queryString += QLatin1String(" AND places.category <> 0 AND places.category <> 6");
-            } else {
-                // search for specific category
-                queryString += QLatin1String(" AND places.category = %1");
-                queryString = queryString.arg( (qint32) userQuery.category() );
-            }
-            if ( userQuery.position().isValid() && userQuery.region().isEmpty() ) {
-                // sort by distance
-                queryString += QLatin1String(" ORDER BY ((places.lat-%1)*(places.lat-%1)+(places.lon-%2)*(places.lon-%2))");
-                GeoDataCoordinates position = userQuery.position();
-                queryString = queryString.arg( position.latitude( GeoDataCoordinates::Degree ), 0, 'f', 8 )
-                        .arg( position.longitude( GeoDataCoordinates::Degree ), 0, 'f', 8 );
-            } else {
-                queryString += regionRestriction;
-            }
-        } else if ( userQuery.queryType() == DatabaseQuery::BroadSearch ) {
-            queryString += QLatin1String(" WHERE regions.id = places.region"
-                    " AND places.name ") + wildcardQuery(userQuery.searchTerm());
+    return find( connection, userQuery, regions, GeoDataLatLonBox() );
+}
+
+QVector<OsmPlacemark> OsmDatabase::find( Connection *connection, const DatabaseQuery &userQuery,
+                                         const RegionRanges &regions, const GeoDataLatLonBox &bounds )
+{
+    // Statements only differ in their structure, all values are bound. That way
+    // each of them is prepared once per connection.
+    QStringList conditions;
+    QVariantList values;
+
+    if ( userQuery.queryType() == DatabaseQuery::CategorySearch ) {
+        if( userQuery.category() == OsmPlacemark::UnknownCategory ) {
+            // search for all pois which are not street nor address
+            conditions << QStringLiteral( "placemarks.category <> 0 AND placemarks.category <> 6" );
         } else {
-            queryString += QLatin1String(" WHERE regions.id = places.region"
-                    "   AND places.name ") + wildcardQuery(userQuery.street());
-            if ( !userQuery.houseNumber().isEmpty() ) {
-                queryString += QLatin1String(" AND places.number ") + wildcardQuery(userQuery.houseNumber());
-            } else {
-                queryString += QLatin1String(" AND places.number IS NULL");
-            }
-            queryString += regionRestriction;
+            // search for specific category
+            conditions << QStringLiteral( "placemarks.category = ?" );
+            values << qint32( userQuery.category() );
+        }
+    } else if ( userQuery.queryType() == DatabaseQuery::BroadSearch ) {
+        conditions << nameRestriction( connection, userQuery.searchTerm(), values );
+    } else {
+        conditions << nameRestriction( connection, userQuery.street(), values );
+        if ( userQuery.houseNumber().isEmpty() ) {
+            conditions << QStringLiteral( "placemarks.number IS NULL" );
+        } else if ( userQuery.houseNumber().contains( QLatin1Char( '*' ) ) ) {
+            conditions << QStringLiteral( "placemarks.number LIKE ?" );
+            values << likePattern( userQuery.houseNumber() );
+        } else {
+            conditions << QStringLiteral( "placemarks.number = ?" );
+            values << userQuery.houseNumber();
         }
+    }
 
-        queryString += QLatin1String(" LIMIT 50;");
+    if ( !regions.isEmpty() ) {
+        QStringList regionRestriction;
+        for ( const QPair<int, int> &range: regions ) {
+            regionRestriction << QStringLiteral( "regions.lft BETWEEN ? AND ?" );
+            values << range.first << range.second;
+        }
+        conditions << QLatin1Char( '(' ) + regionRestriction.join( QStringLiteral( " OR " ) ) + QLatin1Char( ')' );
+    }
 
-        /** @todo: sort/filter results from several databases */
+    if ( !bounds.isEmpty() ) {
+        QString spatialRestriction = QStringLiteral( "placemarks.rowid IN (SELECT id FROM placemarksRtree"
+                                                     " WHERE minLat <= ? AND maxLat >= ?" );
+        spatialRestriction += bounds.crossesDateLine() ? QLatin1String( " AND (minLon <= ? OR maxLon >= ?))" )
+                                                       : QLatin1String( " AND minLon <= ? AND maxLon >= ?)" );
+        conditions << spatialRestriction;
+        values << bounds.north( GeoDataCoordinates::Degree ) << bounds.south( GeoDataCoordinates::Degree );
+        values << bounds.east( GeoDataCoordinates::Degree ) << bounds.west( GeoDataCoordinates::Degree );
+    }
 
-        QSqlQuery query( database );
-        query.setForwardOnly( true );
-        QTime queryTimer;
-        queryTimer.start();
-        if ( !query.exec( queryString ) ) {
-            qWarning() << query.lastError() << "in" << databaseFile << "with query" << query.lastQuery();
-            continue;
-        }
+    QString statement = QStringLiteral( "SELECT regions.name,"
+                                        " names.name, placemarks.number,"
+                                        " placemarks.category, placemarks.lon, placemarks.lat"
+                                        " FROM placemarks"
+                                        " INNER JOIN names ON names.id = placemarks.nameId"
+                                        " INNER JOIN regions ON regions.id = placemarks.regionId"
+                                        " WHERE " ) + conditions.join( QStringLiteral( " AND " ) );
+
+    const GeoDataCoordinates position = userQuery.position();
+    if ( position.isValid() ) {
+        // nearest first, so that the limit drops the results farthest away. Degrees of
+        // longitude get shorter towards the poles.
+        statement += QLatin1String( " ORDER BY ((placemarks.lat-?)*(placemarks.lat-?)+(placemarks.lon-?)*(placemarks.lon-?)*?)" );
+        const qreal latitude = position.latitude( GeoDataCoordinates::Degree );
+        const qreal longitude = position.longitude( GeoDataCoordinates::Degree );
+        const qreal lonScale = cos( position.latitude() );
+        values << latitude << latitude << longitude << longitude << lonScale * lonScale;
+    }
 
-        int resultCount = 0;
-        while ( query.next() ) {
-            OsmPlacemark placemark;
-            if ( userQuery.resultFormat() == DatabaseQuery::DistanceFormat ) {
-                GeoDataCoordinates coordinates( query.value(4).toFloat(), query.value(5).toFloat(), 0.0, GeoDataCoordinates::Degree );
-                placemark.setAdditionalInformation( formatDistance( coordinates, userQuery.position() ) );
-            } else {
-                placemark.setAdditionalInformation( query.value( 0 ).toString() );
-            }
-            placemark.setName( query.value(1).toString() );
-            placemark.setHouseNumber( query.value(2).toString() );
-            placemark.setCategory( (OsmPlacemark::OsmCategory) query.value(3).toInt() );
-            placemark.setLongitude( query.value(4).toFloat() );
-            placemark.setLatitude( query.value(5).toFloat() );
-
-            result.push_back( placemark );
-            resultCount++;
+    statement += QStringLiteral( " LIMIT %1" ).arg( maxResults );
+
+    QSqlQuery &query = connection->query( statement );
+    for ( int i = 0; i < values.size(); ++i ) {
+        query.bindValue( i, values.at( i ) );
+    }
+
+    QVector<OsmPlacemark> result;
+    QTime queryTimer;
+    queryTimer.start();
+    if ( !query.exec() ) {
+        qWarning() << query.lastError() << "in" << connection->fileName() << "with query" << statement;
+        return result;
+    }
+
+    while ( query.next() ) {
+        OsmPlacemark placemark;
+        if ( userQuery.resultFormat() == DatabaseQuery::DistanceFormat ) {
+            GeoDataCoordinates coordinates( query.value(4).toFloat(), query.value(5).toFloat(), 0.0, GeoDataCoordinates::Degree );
+            placemark.setAdditionalInformation( formatDistance( coordinates, userQuery.position() ) );
+        } else {
+            placemark.setAdditionalInformation( query.value( 0 ).toString() );
         }
+        placemark.setName( query.value(1).toString() );
+        placemark.setHouseNumber( query.value(2).toString() );
+        placemark.setCategory( (OsmPlacemark::OsmCategory) query.value(3).toInt() );
+        placemark.setLongitude( query.value(4).toFloat() );
+        placemark.setLatitude( query.value(5).toFloat() );
 
-        mDebug() << Q_FUNC_INFO << "query in" << databaseFile << "with query" << queryString
-                 << "took" << queryTimer.elapsed() << "ms for" << resultCount << "results";
+        result.push_back( placemark );
     }
 
-    mDebug() << "Offline OSM search query took" << timer.elapsed() << "ms for" << result.count() << "results.";
+    // Keeps the statement prepared, but releases its read lock on the database
+    query.finish();
 
-    std::sort( result.begin(), result.end() );
-    makeUnique( result );
+    mDebug() << Q_FUNC_INFO << "query in" << connection->fileName() << "with query" << statement << values
+             << "took" << queryTimer.elapsed() << "ms for" << result.size() << "results";
 
-    if ( userQuery.position().isValid() ) {
-        const PlacemarkSmallerDistance placemarkSmallerDistance( userQuery.position() );
-        std::sort( result.begin(), result.end(), placemarkSmallerDistance );
-    } else {
-        const PlacemarkHigherScore placemarkHigherScore( &userQuery );
-        std::sort( result.begin(), result.end(), placemarkHigherScore );
+    return result;
+}
+
+bool OsmDatabase::regionRanges( Connection *connection, const QString &region, RegionRanges &ranges )
+{
+    // Nested set model to support region hierarchies, see http://en.wikipedia.org/wiki/Nested_set_model
+    const QString statement = QStringLiteral( "SELECT lft, rgt FROM regions WHERE name LIKE ? ORDER BY lft" );
+    QSqlQuery &query = connection->query( statement );
+    query.bindValue( 0, QString( QLatin1Char( '%' ) + region + QLatin1Char( '%' ) ) );
+    if ( !query.exec() ) {
+        qWarning() << query.lastError() << "in" << connection->fileName() << "with query" << statement;
+        return false;
     }
 
-    if ( result.size() > 50 ) {
-        result.remove( 50, result.size()-50 );
+    while ( query.next() ) {
+        const int lft = query.value( 0 ).toInt();
+        const int rgt = query.value( 1 ).toInt();
+        // regions inside of an earlier match are covered by its range already
+        if ( ranges.isEmpty() || lft > ranges.last().second ) {
+            ranges << qMakePair( lft, rgt );
+        }
     }
+    query.finish();
 
-    return result;
+    return !ranges.isEmpty();
+}
+
+QString OsmDatabase::nameRestriction( const Connection *connection, const QString &term, QVariantList &values )
+{
+    if ( !term.contains( QLatin1Char( '*' ) ) ) {
+        values << term;
+        return QStringLiteral( "names.name = ?" );
+    }
+
+    values << likePattern( term );
+    if ( connection->hasNameIndex() ) {
+        // The trigram index answers LIKE patterns without scanning all names
+        return QStringLiteral( "names.id IN (SELECT rowid FROM namesFts WHERE name LIKE ?)" );
+    }
+    return QStringLiteral( "names.name LIKE ?" );
 }
 
 void OsmDatabase::makeUnique( QVector<OsmPlacemark> &placemarks )
@@ -293,14 +524,10 @@ qreal OsmDatabase::bearing( const GeoDataCoordinates &a, const GeoDataCoordinate
                        cos( lat1 ) * sin( lat2 ) - sin( lat1 ) * cos( lat2 ) * cos ( delta ) ), 2 * M_PI );
 }
 
-QString OsmDatabase::wildcardQuery( const QString &term )
+QString OsmDatabase::likePattern( const QString &term )
 {
     QString result = term;
-    if (term.contains(QLatin1Char('*'))) {
-        return QLatin1String(" LIKE '") + result.replace(QLatin1Char('*'), QLatin1Char('%')) + QLatin1Char('\'');
-    } else {
-        return QLatin1String(" = '") + result + QLatin1Char('\'');
-    }
+    return result.replace( QLatin1Char( '*' ), QLatin1Char( '%' ) );
 }
 
 }
@@ -14,14 +14,26 @@
 
 #include "OsmPlacemark.h"
 
+#include <QPair>
 #include <QString>
 #include <QStringList>
+#include <QVariantList>
+#include <QVector>
 
 namespace Marble {
 
 class DatabaseQuery;
 class GeoDataCoordinates;
-
+class GeoDataLatLonBox;
+
+/**
+ * Read access to the address databases written by the osm-addresses tool.
+ *
+ * Each thread keeps its connections to the database files open, together with the
+ * statements prepared for them. Names are looked up in the full text index and
+ * placemarks near the query position in the R*-tree of the database, if the
+ * database has them. Older databases are searched without.
+ */
 class OsmDatabase
 {
 public:
@@ -33,7 +45,23 @@ public:
     QVector<OsmPlacemark> find( const DatabaseQuery &userQuery );
 
 private:
-    static QString wildcardQuery( const QString &term );
+    class Connection;
+
+    /** Nested set ranges (lft, rgt) of regions */
+    typedef QVector<QPair<int, int> > RegionRanges;
+
+    static Connection *connection( const QString &databaseFile );
+
+    static QVector<OsmPlacemark> find( Connection *connection, const DatabaseQuery &userQuery );
+
+    static QVector<OsmPlacemark> find( Connection *connection, const DatabaseQuery &userQuery,
+                                       const RegionRanges &regions, const GeoDataLatLonBox &bounds );
+
+    static bool regionRanges( Connection *connection, const QString &region, RegionRanges &ranges );
+
+    static QString nameRestriction( const Connection *connection, const QString &term, QVariantList &values );
+
+    static QString likePattern( const QString &term );
 
     static void makeUnique( QVector<OsmPlacemark> &placemarks );
 
@@ -12,17 +12,13 @@
 #include "LocalDatabaseRunner.h"
 
 #include "MarbleModel.h"
-#include "MarblePlacemarkModel.h"
+#include "PlacemarkNameIndex.h"
 #include "GeoDataPlacemark.h"
-#include "GeoDataCoordinates.h"
-#include "GeoDataLatLonAltBox.h"
+#include "GeoDataLatLonBox.h"
 
-#include "MarbleDebug.h"
 #include <QString>
 #include <QVector>
 
-#include <QtDebug>
-
 namespace Marble
 {
 
@@ -41,27 +37,11 @@ void LocalDatabaseRunner::search( const QString &searchTerm, const GeoDataLatLon
     QVector<GeoDataPlacemark*> vector;
 
     if (model()) {
-        const QAbstractItemModel * placemarkModel = model()->placemarkModel();
-
-        if (placemarkModel) {
-            QModelIndexList resultList;
-            QModelIndex firstIndex = placemarkModel->index( 0, 0 );
-            resultList = placemarkModel->match( firstIndex,
-                                    Qt::DisplayRole, searchTerm, -1,
-                                    Qt::MatchStartsWith );
-
-            bool const searchEverywhere = preferred.isEmpty();
-            for ( const QModelIndex& index: resultList ) {
-                if( !index.isValid() ) {
-                    mDebug() << "invalid index!!!";
-                    continue;
-                }
-                GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>( index.data( MarblePlacemarkModel::ObjectPointerRole )));
-                if ( placemark &&
-                     ( searchEverywhere || preferred.contains( placemark->coordinate() ) ) ) {
-                    vector.append( new GeoDataPlacemark( *placemark ));
-                }
-            }
+        const PlacemarkNameIndex *index = model()->placemarkNameIndex();
+        vector = index->find( searchTerm, preferred );
+        if ( vector.isEmpty() ) {
+            // No name starts like that, maybe it is misspelled
+            vector = index->find( searchTerm, preferred, PlacemarkNameIndex::FuzzyMatch );
         }
     }
 
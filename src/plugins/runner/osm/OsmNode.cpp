@@ -20,6 +20,8 @@
 
 #include <QXmlStreamAttributes>
 
+#include <algorithm>
+
 namespace Marble {
 
 void OsmNode::parseCoordinates(const QXmlStreamAttributes &attributes)
@@ -48,7 +50,7 @@ GeoDataPlacemark *OsmNode::create() const
     coordinates.setAltitude(m_osmData.tagValue("ele").toDouble());
     placemark->setCoordinate(coordinates);
 
-    QHash<QString, QString>::const_iterator tagIter;
+    OsmPlacemarkData::TagIterator tagIter;
     if ((category == GeoDataPlacemark::TransportCarShare || category == GeoDataPlacemark::MoneyAtm)
             && (tagIter = m_osmData.findTag(QStringLiteral("operator"))) != m_osmData.tagsEnd()) {
         placemark->setName(tagIter.value());
@@ -117,4 +119,105 @@ const OsmPlacemarkData &OsmNode::osmData() const
     return m_osmData;
 }
 
+OsmNodes::OsmNodes() :
+    m_sorted(true)
+{
+}
+
+void OsmNodes::reserve(int size)
+{
+    m_ids.reserve(size);
+    m_nodes.reserve(size);
+}
+
+OsmNode &OsmNodes::insert(qint64 id)
+{
+    if (!m_ids.isEmpty()) {
+        if (m_ids.last() == id) {
+            return m_nodes.last();
+        }
+        m_sorted = m_sorted && m_ids.last() < id;
+    }
+
+    m_ids.append(id);
+    m_nodes.append(OsmNode());
+    return m_nodes.last();
+}
+
+void OsmNodes::sort()
+{
+    if (m_sorted) {
+        return;
+    }
+
+    QVector<int> order(m_ids.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_ids[a] < m_ids[b];
+    });
+
+    QVector<qint64> ids;
+    QVector<OsmNode> nodes;
+    ids.reserve(m_ids.size());
+    nodes.reserve(m_nodes.size());
+    for (int index: order) {
+        // of several nodes with the same id, the one added last wins
+        if (!ids.isEmpty() && ids.last() == m_ids[index]) {
+            nodes.last() = m_nodes[index];
+        } else {
+            ids.append(m_ids[index]);
+            nodes.append(m_nodes[index]);
+        }
+    }
+
+    m_ids.swap(ids);
+    m_nodes.swap(nodes);
+    m_sorted = true;
+}
+
+int OsmNodes::indexOf(qint64 id) const
+{
+    Q_ASSERT(m_sorted);
+    auto const iter = std::lower_bound(m_ids.constBegin(), m_ids.constEnd(), id);
+    if (iter == m_ids.constEnd() || *iter != id) {
+        return -1;
+    }
+    return iter - m_ids.constBegin();
+}
+
+bool OsmNodes::contains(qint64 id) const
+{
+    return indexOf(id) >= 0;
+}
+
+const OsmNode *OsmNodes::find(qint64 id) const
+{
+    int const index = indexOf(id);
+    return index < 0 ? nullptr : &m_nodes.at(index);
+}
+
+const OsmNode &OsmNodes::operator[](qint64 id) const
+{
+    static const OsmNode emptyNode;
+    const OsmNode *node = find(id);
+    return node ? *node : emptyNode;
+}
+
+int OsmNodes::size() const
+{
+    return m_nodes.size();
+}
+
+OsmNodes::const_iterator OsmNodes::begin() const
+{
+    return m_nodes.constBegin();
+}
+
+OsmNodes::const_iterator OsmNodes::end() const
+{
+    return m_nodes.constEnd();
+}
+
 }
@@ -15,6 +15,7 @@
 #include <GeoDataPlacemark.h>
 
 #include <QString>
+#include <QVector>
 
 class QXmlStreamAttributes;
 
@@ -40,7 +41,44 @@ private:
     GeoDataCoordinates m_coordinates;
 };
 
-typedef QHash<qint64,OsmNode> OsmNodes;
+/**
+ * Nodes stored in two arrays sorted by id. Parsers add nodes with insert() in
+ * file order and call sort() once done, lookups are binary searches.
+ */
+class OsmNodes
+{
+public:
+    typedef QVector<OsmNode>::const_iterator const_iterator;
+
+    OsmNodes();
+
+    void reserve(int size);
+
+    /**
+     * Adds a node with the given id, or returns the node added last if it has
+     * the same id. A node added again with an earlier id replaces the former one
+     * in sort().
+     */
+    OsmNode & insert(qint64 id);
+
+    void sort();
+
+    // Lookups, valid after sort()
+    bool contains(qint64 id) const;
+    const OsmNode * find(qint64 id) const;
+    const OsmNode & operator[](qint64 id) const;
+
+    int size() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+
+private:
+    int indexOf(qint64 id) const;
+
+    QVector<qint64> m_ids;
+    QVector<OsmNode> m_nodes;
+    bool m_sorted;
+};
 
 }
 
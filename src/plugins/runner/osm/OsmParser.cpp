@@ -13,7 +13,9 @@
 
 #include "OsmParser.h"
 #include "OsmElementDictionary.h"
+#include "OsmPbfReader.h"
 #include "osm/OsmObjectManager.h"
+#include "osm/OsmStringTable.h"
 #include "GeoDataDocument.h"
 #include "GeoDataPoint.h"
 #include "GeoDataTypes.h"
@@ -39,6 +41,8 @@ GeoDataDocument *OsmParser::parse(const QString &filename, QString &error)
 
     if (fileInfo.completeSuffix() == QLatin1String("o5m")) {
         return parseO5m(filename, error);
+    } else if (fileInfo.completeSuffix() == QLatin1String("osm.pbf")) {
+        return parsePbf(filename, error);
     } else {
         return parseXml(filename, error);
     }
@@ -50,8 +54,6 @@ GeoDataDocument* OsmParser::parseO5m(const QString &filename, QString &error)
     O5mreaderDataset data;
     O5mreaderIterateRet outerState, innerState;
     char *key, *value;
-    // share string data on the heap at least for this file
-    QSet<QString> stringPool;
 
     OsmNodes nodes;
     OsmWays ways;
@@ -68,14 +70,12 @@ GeoDataDocument* OsmParser::parseO5m(const QString &filename, QString &error)
         switch (data.type) {
         case O5MREADER_DS_NODE:
         {
-            OsmNode& node = nodes[data.id];
+            OsmNode& node = nodes.insert(data.id);
             node.osmData().setId(data.id);
             node.setCoordinates(GeoDataCoordinates(data.lon*1.0e-7, data.lat*1.0e-7,
                                                    0.0, GeoDataCoordinates::Degree));
             while ((innerState = o5mreader_iterateTags(reader, &key, &value)) == O5MREADER_ITERATE_RET_NEXT) {
-                const QString keyString = *stringPool.insert(QString::fromUtf8(key));
-                const QString valueString = *stringPool.insert(QString::fromUtf8(value));
-                node.osmData().addTag(keyString, valueString);
+                node.osmData().addTag(QString::fromUtf8(key), QString::fromUtf8(value));
             }
         }
             break;
@@ -88,9 +88,7 @@ GeoDataDocument* OsmParser::parseO5m(const QString &filename, QString &error)
                 way.addReference(nodeId);
             }
             while ((innerState = o5mreader_iterateTags(reader, &key, &value)) == O5MREADER_ITERATE_RET_NEXT) {
-                const QString keyString = *stringPool.insert(QString::fromUtf8(key));
-                const QString valueString = *stringPool.insert(QString::fromUtf8(value));
-                way.osmData().addTag(keyString, valueString);
+                way.osmData().addTag(QString::fromUtf8(key), QString::fromUtf8(value));
             }
         }
             break;
@@ -102,13 +100,11 @@ GeoDataDocument* OsmParser::parseO5m(const QString &filename, QString &error)
             uint8_t type;
             uint64_t refId;
             while ((innerState = o5mreader_iterateRefs(reader, &refId, &type, &role)) == O5MREADER_ITERATE_RET_NEXT) {
-                const QString roleString = *stringPool.insert(QString::fromUtf8(role));
+                const QString &roleString = OsmStringTable::string(OsmStringTable::intern(QString::fromUtf8(role)));
                 relation.addMember(refId, roleString, relationTypes[type]);
             }
             while ((innerState = o5mreader_iterateTags(reader, &key, &value)) == O5MREADER_ITERATE_RET_NEXT) {
-                const QString keyString = *stringPool.insert(QString::fromUtf8(key));
-                const QString valueString = *stringPool.insert(QString::fromUtf8(value));
-                relation.osmData().addTag(keyString, valueString);
+                relation.osmData().addTag(QString::fromUtf8(key), QString::fromUtf8(value));
             }
         }
             break;
@@ -121,6 +117,18 @@ GeoDataDocument* OsmParser::parseO5m(const QString &filename, QString &error)
     return createDocument(nodes, ways, relations);
 }
 
+GeoDataDocument* OsmParser::parsePbf(const QString &filename, QString &error)
+{
+    OsmNodes nodes;
+    OsmWays ways;
+    OsmRelations relations;
+    if (!OsmPbfReader::read(filename, nodes, ways, relations, error)) {
+        return nullptr;
+    }
+
+    return createDocument(nodes, ways, relations);
+}
+
 GeoDataDocument* OsmParser::parseXml(const QString &filename, QString &error)
 {
     QXmlStreamReader parser;
@@ -150,8 +158,6 @@ GeoDataDocument* OsmParser::parseXml(const QString &filename, QString &error)
     OsmPlacemarkData* osmData(0);
     QString parentTag;
     qint64 parentId(0);
-    // share string data on the heap at least for this file
-    QSet<QString> stringPool;
 
     OsmNodes m_nodes;
     OsmWays m_ways;
@@ -169,9 +175,10 @@ GeoDataDocument* OsmParser::parseXml(const QString &filename, QString &error)
             parentId = parser.attributes().value(QLatin1String("id")).toLongLong();
 
             if (tagName == osm::osmTag_node) {
-                m_nodes[parentId].osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
-                m_nodes[parentId].parseCoordinates(parser.attributes());
-                osmData = &m_nodes[parentId].osmData();
+                OsmNode &node = m_nodes.insert(parentId);
+                node.osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
+                node.parseCoordinates(parser.attributes());
+                osmData = &node.osmData();
             } else if (tagName == osm::osmTag_way) {
                 m_ways[parentId].osmData() = OsmPlacemarkData::fromParserAttributes(parser.attributes());
                 osmData = &m_ways[parentId].osmData();
@@ -182,9 +189,7 @@ GeoDataDocument* OsmParser::parseXml(const QString &filename, QString &error)
             }
         } else if (osmData && tagName == osm::osmTag_tag) {
             const QXmlStreamAttributes &attributes = parser.attributes();
-            const QString keyString = *stringPool.insert(attributes.value(QLatin1String("k")).toString());
-            const QString valueString = *stringPool.insert(attributes.value(QLatin1String("v")).toString());
-            osmData->addTag(keyString, valueString);
+            osmData->addTag(attributes.value(QLatin1String("k")).toString(), attributes.value(QLatin1String("v")).toString());
         } else if (tagName == osm::osmTag_nd && parentTag == osm::osmTag_way) {
             m_ways[parentId].addReference(parser.attributes().value(QLatin1String("ref")).toLongLong());
         } else if (tagName == osm::osmTag_member && parentTag == osm::osmTag_relation) {
@@ -212,6 +217,8 @@ GeoDataDocument *OsmParser::createDocument(OsmNodes &nodes, OsmWays &ways, OsmRe
     backgroundStyle->setId(QStringLiteral("background"));
     document->addStyle( backgroundStyle );
 
+    nodes.sort();
+
     QSet<qint64> usedNodes, usedWays;
     for(auto const &relation: relations) {
         relation.createMultipolygon(document, ways, nodes, usedNodes, usedWays);
@@ -229,13 +236,12 @@ GeoDataDocument *OsmParser::createDocument(OsmNodes &nodes, OsmWays &ways, OsmRe
         }
     }
 
-    for(auto id: usedNodes) {
-        if (nodes[id].osmData().isEmpty()) {
-            nodes.remove(id);
+    for(auto const &node: nodes) {
+        // nodes only used for ways and relations
+        if (node.osmData().isEmpty() && usedNodes.contains(node.osmData().id())) {
+            continue;
         }
-    }
 
-    for(auto const &node: nodes) {
         auto placemark = node.create();
         if (placemark) {
             document->append(placemark);
@@ -0,0 +1,591 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "OsmPbfReader.h"
+
+#include "osm/OsmStringTable.h"
+
+#include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtEndian>
+
+namespace Marble {
+
+namespace {
+
+// Limits set by the format, see fileformat.proto
+const int maximumBlobHeaderSize = 64 * 1024;
+const int maximumBlobSize = 32 * 1024 * 1024;
+
+/**
+ * Decoder of the protocol buffers wire format, just enough for the messages
+ * of fileformat.proto and osmformat.proto.
+ */
+class ProtobufReader
+{
+public:
+    ProtobufReader(const char *data = nullptr, int size = 0) :
+        m_pos(data),
+        m_end(data + size),
+        m_tag(0),
+        m_value(0),
+        m_data(nullptr),
+        m_size(0),
+        m_error(false)
+    {
+    }
+
+    // Moves to the next field, false at the end of the message or on errors
+    bool next()
+    {
+        if (m_error || m_pos >= m_end) {
+            return false;
+        }
+
+        quint64 const key = readVarint();
+        m_tag = key >> 3;
+        m_data = nullptr;
+        m_size = 0;
+        switch (key & 0x7) {
+        case 0: // varint
+            m_value = readVarint();
+            break;
+        case 1: // 64 bit
+            skip(8);
+            break;
+        case 2: { // length delimited
+            quint64 const size = readVarint();
+            if (size > quint64(m_end - m_pos)) {
+                m_error = true;
+                break;
+            }
+            m_data = m_pos;
+            m_size = size;
+            m_pos += size;
+            break;
+        }
+        case 5: // 32 bit
+            skip(4);
+            break;
+        default: // groups are deprecated and not used by the format
+            m_error = true;
+        }
+        return !m_error;
+    }
+
+    quint32 tag() const { return m_tag; }
+    quint64 value() const { return m_value; }
+    qint64 signedValue() const { return zigzag(m_value); }
+    ProtobufReader message() const { return ProtobufReader(m_data, m_size); }
+    QByteArray bytes() const { return QByteArray(m_data, m_size); }
+    QString string() const { return QString::fromUtf8(m_data, m_size); }
+    bool hasError() const { return m_error; }
+
+    // Appends the values of a packed or of a single repeated varint field
+    void appendValues(QVector<quint64> &values)
+    {
+        if (!m_data) {
+            values.append(m_value);
+            return;
+        }
+
+        ProtobufReader packed(m_data, m_size);
+        while (packed.m_pos < packed.m_end && !packed.m_error) {
+            values.append(packed.readVarint());
+        }
+        m_error = m_error || packed.m_error;
+    }
+
+    static qint64 zigzag(quint64 value)
+    {
+        return qint64(value >> 1) ^ -qint64(value & 1);
+    }
+
+private:
+    quint64 readVarint()
+    {
+        quint64 result = 0;
+        for (int shift = 0; shift < 64 && m_pos < m_end; shift += 7) {
+            quint8 const byte = *m_pos++;
+            result |= quint64(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return result;
+            }
+        }
+        m_error = true;
+        return 0;
+    }
+
+    void skip(int size)
+    {
+        if (m_end - m_pos < size) {
+            m_error = true;
+        } else {
+            m_pos += size;
+        }
+    }
+
+    const char *m_pos;
+    const char *m_end;
+    quint32 m_tag;
+    quint64 m_value;
+    const char *m_data;
+    int m_size;
+    bool m_error;
+};
+
+/// The entities of one OSMData blob, in the order of the file
+struct PbfBlock
+{
+    QVector<qint64> nodeIds;
+    QVector<OsmNode> nodes;
+    QVector<OsmWay> ways;
+    QVector<OsmRelation> relations;
+    QString error;
+};
+
+class PrimitiveBlockDecoder
+{
+public:
+    explicit PrimitiveBlockDecoder(PbfBlock &block) :
+        m_block(block),
+        m_granularity(100),
+        m_latOffset(0),
+        m_lonOffset(0)
+    {
+    }
+
+    bool decode(const QByteArray &data);
+
+private:
+    bool addTags(OsmPlacemarkData &osmData, const QVector<quint64> &keys, const QVector<quint64> &values) const;
+    GeoDataCoordinates coordinates(qint64 lon, qint64 lat) const;
+    bool decodeNode(ProtobufReader reader);
+    bool decodeDenseNodes(ProtobufReader reader);
+    bool decodeWay(ProtobufReader reader);
+    bool decodeRelation(ProtobufReader reader);
+
+    PbfBlock &m_block;
+    QVector<int> m_strings; // ids in the OsmStringTable
+    qint64 m_granularity;
+    qint64 m_latOffset;
+    qint64 m_lonOffset;
+};
+
+bool PrimitiveBlockDecoder::decode(const QByteArray &data)
+{
+    // the string table and the granularity may follow the groups
+    QVector<ProtobufReader> groups;
+    ProtobufReader reader(data.constData(), data.size());
+    while (reader.next()) {
+        switch (reader.tag()) {
+        case 1: {
+            ProtobufReader stringTable = reader.message();
+            while (stringTable.next()) {
+                if (stringTable.tag() == 1) {
+                    m_strings.append(OsmStringTable::intern(stringTable.string()));
+                }
+            }
+            if (stringTable.hasError()) {
+                return false;
+            }
+            break;
+        }
+        case 2:
+            groups.append(reader.message());
+            break;
+        case 17:
+            m_granularity = reader.value();
+            break;
+        case 19:
+            m_latOffset = qint64(reader.value());
+            break;
+        case 20:
+            m_lonOffset = qint64(reader.value());
+            break;
+        }
+    }
+    if (reader.hasError()) {
+        return false;
+    }
+
+    for (ProtobufReader group: groups) {
+        while (group.next()) {
+            bool ok = true;
+            switch (group.tag()) {
+            case 1:
+                ok = decodeNode(group.message());
+                break;
+            case 2:
+                ok = decodeDenseNodes(group.message());
+                break;
+            case 3:
+                ok = decodeWay(group.message());
+                break;
+            case 4:
+                ok = decodeRelation(group.message());
+                break;
+            } // changesets ignored
+            if (!ok) {
+                return false;
+            }
+        }
+        if (group.hasError()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PrimitiveBlockDecoder::addTags(OsmPlacemarkData &osmData, const QVector<quint64> &keys, const QVector<quint64> &values) const
+{
+    if (keys.size() != values.size()) {
+        return false;
+    }
+    for (int i = 0; i < keys.size(); ++i) {
+        if (keys[i] >= quint64(m_strings.size()) || values[i] >= quint64(m_strings.size())) {
+            return false;
+        }
+        osmData.addTag(m_strings[keys[i]], m_strings[values[i]]);
+    }
+    return true;
+}
+
+GeoDataCoordinates PrimitiveBlockDecoder::coordinates(qint64 lon, qint64 lat) const
+{
+    return GeoDataCoordinates(1.0e-9 * (m_lonOffset + m_granularity * lon),
+                              1.0e-9 * (m_latOffset + m_granularity * lat),
+                              0.0, GeoDataCoordinates::Degree);
+}
+
+bool PrimitiveBlockDecoder::decodeNode(ProtobufReader reader)
+{
+    qint64 id = 0;
+    qint64 lat = 0;
+    qint64 lon = 0;
+    QVector<quint64> keys;
+    QVector<quint64> values;
+    while (reader.next()) {
+        switch (reader.tag()) {
+        case 1: id = reader.signedValue(); break;
+        case 2: reader.appendValues(keys); break;
+        case 3: reader.appendValues(values); break;
+        case 8: lat = reader.signedValue(); break;
+        case 9: lon = reader.signedValue(); break;
+        }
+    }
+
+    OsmNode node;
+    node.osmData().setId(id);
+    node.setCoordinates(coordinates(lon, lat));
+    m_block.nodeIds.append(id);
+    m_block.nodes.append(node);
+    return !reader.hasError() && addTags(m_block.nodes.last().osmData(), keys, values);
+}
+
+bool PrimitiveBlockDecoder::decodeDenseNodes(ProtobufReader reader)
+{
+    QVector<quint64> ids;
+    QVector<quint64> lats;
+    QVector<quint64> lons;
+    QVector<quint64> keysValues;
+    while (reader.next()) {
+        switch (reader.tag()) {
+        case 1: reader.appendValues(ids); break;
+        case 8: reader.appendValues(lats); break;
+        case 9: reader.appendValues(lons); break;
+        case 10: reader.appendValues(keysValues); break;
+        } // dense info ignored
+    }
+    if (reader.hasError() || lats.size() != ids.size() || lons.size() != ids.size()) {
+        return false;
+    }
+
+    m_block.nodeIds.reserve(m_block.nodeIds.size() + ids.size());
+    m_block.nodes.reserve(m_block.nodes.size() + ids.size());
+    qint64 id = 0;
+    qint64 lat = 0;
+    qint64 lon = 0;
+    int keyValue = 0;
+    for (int i = 0; i < ids.size(); ++i) {
+        id += ProtobufReader::zigzag(ids[i]);
+        lat += ProtobufReader::zigzag(lats[i]);
+        lon += ProtobufReader::zigzag(lons[i]);
+
+        m_block.nodeIds.append(id);
+        m_block.nodes.append(OsmNode());
+        OsmNode &node = m_block.nodes.last();
+        node.osmData().setId(id);
+        node.setCoordinates(coordinates(lon, lat));
+
+        // key value pairs of all nodes, each node's terminated by 0
+        while (keyValue < keysValues.size() && keysValues[keyValue] != 0) {
+            if (keyValue + 1 >= keysValues.size()) {
+                return false;
+            }
+            quint64 const key = keysValues[keyValue];
+            quint64 const value = keysValues[keyValue + 1];
+            if (key >= quint64(m_strings.size()) || value >= quint64(m_strings.size())) {
+                return false;
+            }
+            node.osmData().addTag(m_strings[key], m_strings[value]);
+            keyValue += 2;
+        }
+        ++keyValue;
+    }
+    return true;
+}
+
+bool PrimitiveBlockDecoder::decodeWay(ProtobufReader reader)
+{
+    m_block.ways.append(OsmWay());
+    OsmWay &way = m_block.ways.last();
+    QVector<quint64> keys;
+    QVector<quint64> values;
+    QVector<quint64> references;
+    while (reader.next()) {
+        switch (reader.tag()) {
+        case 1: way.osmData().setId(qint64(reader.value())); break;
+        case 2: reader.appendValues(keys); break;
+        case 3: reader.appendValues(values); break;
+        case 8: reader.appendValues(references); break;
+        }
+    }
+
+    qint64 reference = 0;
+    for (quint64 delta: references) {
+        reference += ProtobufReader::zigzag(delta);
+        way.addReference(reference);
+    }
+    return !reader.hasError() && addTags(way.osmData(), keys, values);
+}
+
+bool PrimitiveBlockDecoder::decodeRelation(ProtobufReader reader)
+{
+    static const QString memberTypes[] = {
+        QStringLiteral("node"),
+        QStringLiteral("way"),
+        QStringLiteral("relation")
+    };
+
+    m_block.relations.append(OsmRelation());
+    OsmRelation &relation = m_block.relations.last();
+    QVector<quint64> keys;
+    QVector<quint64> values;
+    QVector<quint64> roles;
+    QVector<quint64> members;
+    QVector<quint64> types;
+    while (reader.next()) {
+        switch (reader.tag()) {
+        case 1: relation.osmData().setId(qint64(reader.value())); break;
+        case 2: reader.appendValues(keys); break;
+        case 3: reader.appendValues(values); break;
+        case 8: reader.appendValues(roles); break;
+        case 9: reader.appendValues(members); break;
+        case 10: reader.appendValues(types); break;
+        }
+    }
+    if (reader.hasError() || roles.size() != members.size() || types.size() != members.size()) {
+        return false;
+    }
+
+    qint64 member = 0;
+    for (int i = 0; i < members.size(); ++i) {
+        member += ProtobufReader::zigzag(members[i]);
+        if (roles[i] >= quint64(m_strings.size()) || types[i] > 2) {
+            return false;
+        }
+        relation.addMember(member, OsmStringTable::string(m_strings[roles[i]]), memberTypes[types[i]]);
+    }
+    return addTags(relation.osmData(), keys, values);
+}
+
+/// Returns the uncompressed content of a Blob message
+bool inflateBlob(const QByteArray &blob, QByteArray &data, QString &error)
+{
+    quint32 rawSize = 0;
+    ProtobufReader reader(blob.constData(), blob.size());
+    while (reader.next()) {
+        switch (reader.tag()) {
+        case 1:
+            data = reader.bytes();
+            return true;
+        case 2:
+            rawSize = reader.value();
+            break;
+        case 3: {
+            if (rawSize > quint32(maximumBlobSize)) {
+                error = QStringLiteral("Blob exceeds the maximum size");
+                return false;
+            }
+            // qUncompress() takes the zlib stream after the expected size
+            QByteArray compressed(4, 0);
+            qToBigEndian(rawSize, reinterpret_cast<uchar *>(compressed.data()));
+            compressed.append(reader.bytes());
+            data = qUncompress(compressed);
+            if (data.size() != int(rawSize)) {
+                error = QStringLiteral("Cannot inflate blob");
+                return false;
+            }
+            return true;
+        }
+        case 4:
+        case 5:
+        case 6:
+        case 7:
+            error = QStringLiteral("Unsupported blob compression");
+            return false;
+        }
+    }
+    error = QStringLiteral("Invalid blob");
+    return false;
+}
+
+PbfBlock decodeBlob(const QByteArray &blob)
+{
+    PbfBlock result;
+    QByteArray data;
+    if (inflateBlob(blob, data, result.error)) {
+        PrimitiveBlockDecoder decoder(result);
+        if (!decoder.decode(data)) {
+            result.error = QStringLiteral("Invalid primitive block");
+        }
+    }
+    return result;
+}
+
+bool checkHeader(const QByteArray &blob, QString &error)
+{
+    QByteArray data;
+    if (!inflateBlob(blob, data, error)) {
+        return false;
+    }
+
+    ProtobufReader reader(data.constData(), data.size());
+    while (reader.next()) {
+        if (reader.tag() == 4) {
+            QString const feature = reader.string();
+            if (feature != QLatin1String("OsmSchema-V0.6") && feature != QLatin1String("DenseNodes")) {
+                error = QStringLiteral("Unsupported required feature %1").arg(feature);
+                return false;
+            }
+        }
+    }
+    return !reader.hasError();
+}
+
+/// Reads the next blob, returns false at the end of the file or on errors
+bool readBlob(QFile &file, QByteArray &type, QByteArray &blob, QString &error)
+{
+    QByteArray const headerSize = file.read(4);
+    if (headerSize.isEmpty()) {
+        return false;
+    }
+
+    quint32 const size = headerSize.size() == 4 ? qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(headerSize.constData())) : 0;
+    if (size == 0 || size > quint32(maximumBlobHeaderSize)) {
+        error = QStringLiteral("Invalid blob header size");
+        return false;
+    }
+    QByteArray const header = file.read(size);
+    if (header.size() != int(size)) {
+        error = QStringLiteral("Unexpected end of file");
+        return false;
+    }
+
+    type.clear();
+    quint64 dataSize = 0;
+    ProtobufReader reader(header.constData(), header.size());
+    while (reader.next()) {
+        if (reader.tag() == 1) {
+            type = reader.bytes();
+        } else if (reader.tag() == 3) {
+            dataSize = reader.value();
+        }
+    }
+    if (reader.hasError() || dataSize > quint64(maximumBlobSize)) {
+        error = QStringLiteral("Invalid blob header");
+        return false;
+    }
+
+    blob = file.read(dataSize);
+    if (blob.size() != int(dataSize)) {
+        error = QStringLiteral("Unexpected end of file");
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool OsmPbfReader::read(const QString &filename, OsmNodes &nodes, OsmWays &ways, OsmRelations &relations, QString &error)
+{
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly)) {
+        error = QStringLiteral("Cannot open file %1").arg(filename);
+        return false;
+    }
+
+    int const batchSize = 4 * qMax(1, QThread::idealThreadCount());
+    QVector<QByteArray> batch;
+    batch.reserve(batchSize);
+    QByteArray type;
+    QByteArray blob;
+    bool atEnd = false;
+    bool hasHeader = false;
+    while (!atEnd) {
+        while (batch.size() < batchSize) {
+            if (!readBlob(file, type, blob, error)) {
+                if (!error.isEmpty()) {
+                    return false;
+                }
+                atEnd = true;
+                break;
+            }
+
+            if (type == "OSMHeader") {
+                if (!checkHeader(blob, error)) {
+                    return false;
+                }
+                hasHeader = true;
+            } else if (type == "OSMData") {
+                batch.append(blob);
+            } // unknown blob types are to be skipped
+        }
+
+        if (!hasHeader) {
+            error = QStringLiteral("%1 has no OSMHeader blob").arg(filename);
+            return false;
+        }
+
+        QList<PbfBlock> const blocks = QtConcurrent::blockingMapped<QList<PbfBlock> >(batch, decodeBlob);
+        batch.clear();
+
+        for (const PbfBlock &block: blocks) {
+            if (!block.error.isEmpty()) {
+                error = block.error;
+                return false;
+            }
+            for (int i = 0; i < block.nodes.size(); ++i) {
+                nodes.insert(block.nodeIds[i]) = block.nodes[i];
+            }
+            for (const OsmWay &way: block.ways) {
+                ways[way.osmData().id()] = way;
+            }
+            for (const OsmRelation &relation: block.relations) {
+                relations[relation.osmData().id()] = relation;
+            }
+        }
+    }
+
+    nodes.sort();
+    return true;
+}
+
+}
@@ -0,0 +1,35 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_OSMPBFREADER_H
+#define MARBLE_OSMPBFREADER_H
+
+#include "OsmNode.h"
+#include "OsmWay.h"
+#include "OsmRelation.h"
+
+#include <QString>
+
+namespace Marble {
+
+/**
+ * Reads OpenStreetMap PBF files (.osm.pbf) without a protobuf library.
+ *
+ * The blobs are read from the file in batches. Each batch is inflated and
+ * decoded on the global thread pool and merged in file order afterwards, so
+ * the compressed data held in memory is bounded by the batch size.
+ */
+class OsmPbfReader
+{
+public:
+    static bool read(const QString &filename, OsmNodes &nodes, OsmWays &ways, OsmRelations &relations, QString &error);
+};
+
+}
+
+#endif
@@ -16,12 +16,12 @@
 #include <GeoDataStyle.h>
 #include <GeoDataDocument.h>
 #include <osm/OsmObjectManager.h>
+#include <osm/OsmStringTable.h>
 #include <MarbleDirs.h>
 #include <StyleBuilder.h>
 
 namespace Marble {
 
-QSet<StyleBuilder::OsmTag> OsmWay::s_areaTags;
 
 GeoDataPlacemark *OsmWay::create(const OsmNodes &nodes, QSet<qint64> &usedNodes) const
 {
@@ -34,14 +34,13 @@ GeoDataPlacemark *OsmWay::create(const OsmNodes &nodes, QSet<qint64> &usedNodes)
         bool const stripLastNode = m_references.first() == m_references.last();
         for (int i=0, n=m_references.size() - (stripLastNode ? 1 : 0); i<n; ++i) {
             qint64 nodeId = m_references[i];
-            auto const nodeIter = nodes.constFind(nodeId);
-            if (nodeIter == nodes.constEnd()) {
+            OsmNode const * node = nodes.find(nodeId);
+            if (!node) {
                 return nullptr;
             }
 
-            OsmNode const & node = nodeIter.value();
-            osmData.addNodeReference(node.coordinates(), node.osmData());
-            linearRing.append(node.coordinates());
+            osmData.addNodeReference(node->coordinates(), node->osmData());
+            linearRing.append(node->coordinates());
             usedNodes << nodeId;
         }
 
@@ -51,14 +50,13 @@ GeoDataPlacemark *OsmWay::create(const OsmNodes &nodes, QSet<qint64> &usedNodes)
         lineString.reserve(m_references.size());
 
         for(auto nodeId: m_references) {
-            auto const nodeIter = nodes.constFind(nodeId);
-            if (nodeIter == nodes.constEnd()) {
+            OsmNode const * node = nodes.find(nodeId);
+            if (!node) {
                 return nullptr;
             }
 
-            OsmNode const & node = nodeIter.value();
-            osmData.addNodeReference(node.coordinates(), node.osmData());
-            lineString.append(node.coordinates());
+            osmData.addNodeReference(node->coordinates(), node->osmData());
+            lineString.append(node->coordinates());
             usedNodes << nodeId;
         }
 
@@ -110,26 +108,32 @@ bool OsmWay::isArea() const
     // We need to create two separate ways in cases like that to support this.
     // See also https://wiki.openstreetmap.org/wiki/Key:area
 
-    if (m_osmData.containsTag(QStringLiteral("area"), QStringLiteral("yes"))) {
+    static const int area = OsmStringTable::intern(QStringLiteral("area"));
+    static const int yes = OsmStringTable::intern(QStringLiteral("yes"));
+    static const int no = OsmStringTable::intern(QStringLiteral("no"));
+    static const int highway = OsmStringTable::intern(QStringLiteral("highway"));
+    static const int barrier = OsmStringTable::intern(QStringLiteral("barrier"));
+    static const int landuse = OsmStringTable::intern(QStringLiteral("landuse"));
+
+    if (m_osmData.containsTag(area, yes)) {
         return true;
     }
 
     bool const isLinearFeature =
-            m_osmData.containsTag(QStringLiteral("area"), QStringLiteral("no")) ||
-            m_osmData.containsTagKey(QStringLiteral("highway")) ||
-            m_osmData.containsTagKey(QStringLiteral("barrier"));
+            m_osmData.containsTag(area, no) ||
+            m_osmData.containsTagKey(highway) ||
+            m_osmData.containsTagKey(barrier);
     if (isLinearFeature) {
         return false;
     }
 
-    bool const isAreaFeature = m_osmData.containsTagKey(QStringLiteral("landuse"));
+    bool const isAreaFeature = m_osmData.containsTagKey(landuse);
     if (isAreaFeature) {
         return true;
     }
 
     for (auto iter = m_osmData.tagsBegin(), end=m_osmData.tagsEnd(); iter != end; ++iter) {
-        const auto tag = StyleBuilder::OsmTag(iter.key(), iter.value());
-        if (isAreaTag(tag)) {
+        if (isAreaTag(iter.keyId(), iter.valueId())) {
             return true;
         }
     }
@@ -138,55 +142,62 @@ bool OsmWay::isArea() const
     return isImplicitlyClosed;
 }
 
-bool OsmWay::isAreaTag(const StyleBuilder::OsmTag &keyValue)
+bool OsmWay::isAreaTag(int key, int value)
 {
-    if (s_areaTags.isEmpty()) {
+    static const QSet<QPair<int, int> > areaTags = []() {
         // All these tags can be found updated at
         // http://wiki.openstreetmap.org/wiki/Map_Features#Landuse
 
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("water")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("wood")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("beach")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("wetland")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("glacier")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("scrub")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("cliff")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("area"), QStringLiteral("yes")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("waterway"), QStringLiteral("riverbank")));
+        QSet<StyleBuilder::OsmTag> tags;
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("water")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("wood")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("beach")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("wetland")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("glacier")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("scrub")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("natural"), QStringLiteral("cliff")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("area"), QStringLiteral("yes")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("waterway"), QStringLiteral("riverbank")));
 
         for (auto const & tag: StyleBuilder::buildingTags()) {
-            s_areaTags.insert(tag);
+            tags.insert(tag);
         }
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("man_made"), QStringLiteral("bridge")));
-
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("graveyard")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("parking")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("parking_space")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("bicycle_parking")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("college")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("hospital")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("kindergarten")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("school")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("university")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("common")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("garden")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("golf_course")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("marina")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("playground")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("pitch")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("park")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("sports_centre")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("stadium")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("swimming_pool")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("track")));
-
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("military"), QStringLiteral("danger_area")));
-
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("marble_land"), QStringLiteral("landmass")));
-        s_areaTags.insert(StyleBuilder::OsmTag(QStringLiteral("settlement"), QStringLiteral("yes")));
-    }
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("man_made"), QStringLiteral("bridge")));
+
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("graveyard")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("parking")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("parking_space")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("bicycle_parking")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("college")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("hospital")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("kindergarten")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("school")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("amenity"), QStringLiteral("university")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("common")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("garden")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("golf_course")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("marina")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("playground")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("pitch")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("park")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("sports_centre")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("stadium")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("swimming_pool")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("leisure"), QStringLiteral("track")));
+
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("military"), QStringLiteral("danger_area")));
+
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("marble_land"), QStringLiteral("landmass")));
+        tags.insert(StyleBuilder::OsmTag(QStringLiteral("settlement"), QStringLiteral("yes")));
+
+        QSet<QPair<int, int> > result;
+        for (auto const &tag: tags) {
+            result.insert(qMakePair(OsmStringTable::intern(tag.first), OsmStringTable::intern(tag.second)));
+        }
+        return result;
+    }();
 
-    return s_areaTags.contains(keyValue);
+    return areaTags.contains(qMakePair(key, value));
 }
 
 }
@@ -36,12 +36,10 @@ public:
 private:
     bool isArea() const;
 
-    static bool isAreaTag(const StyleBuilder::OsmTag &keyValue);
+    static bool isAreaTag(int key, int value);
 
     OsmPlacemarkData m_osmData;
     QVector<qint64> m_references;
-
-    static QSet<StyleBuilder::OsmTag> s_areaTags;
 };
 
 typedef QHash<qint64,OsmWay> OsmWays;
@@ -26,8 +26,6 @@
 namespace Marble
 {
 
-QSet<QString> O5mWriter::m_blacklistedTags;
-
 bool O5mWriter::write(QIODevice *device, const GeoDataDocument &document)
 {
     if (!device || !device->isWritable()) {
@@ -257,18 +255,18 @@ void O5mWriter::writeVersion(const OsmPlacemarkData &, QDataStream &stream) cons
 
 void O5mWriter::writeTags(const OsmPlacemarkData &osmData, StringTable &stringTable, QDataStream &stream) const
 {
-    if (m_blacklistedTags.isEmpty()) {
-        m_blacklistedTags << QStringLiteral("mx:version");
-        m_blacklistedTags << QStringLiteral("mx:changeset");
-        m_blacklistedTags << QStringLiteral("mx:uid");
-        m_blacklistedTags << QStringLiteral("mx:visible");
-        m_blacklistedTags << QStringLiteral("mx:user");
-        m_blacklistedTags << QStringLiteral("mx:timestamp");
-        m_blacklistedTags << QStringLiteral("mx:action");
-    }
+    // initialized once, also when several threads write tiles at the same time
+    static QSet<QString> const blacklistedTags = QSet<QString>()
+            << QStringLiteral("mx:version")
+            << QStringLiteral("mx:changeset")
+            << QStringLiteral("mx:uid")
+            << QStringLiteral("mx:visible")
+            << QStringLiteral("mx:user")
+            << QStringLiteral("mx:timestamp")
+            << QStringLiteral("mx:action");
 
     for (auto iter=osmData.tagsBegin(), end = osmData.tagsEnd(); iter != end; ++iter) {
-        if (!m_blacklistedTags.contains(iter.key())) {
+        if (!blacklistedTags.contains(iter.key())) {
             writeStringPair(StringPair(iter.key(), iter.value()), stringTable, stream);
         }
     }
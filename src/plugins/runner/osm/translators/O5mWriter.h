@@ -47,8 +47,6 @@ private:
   void writeSigned(qint64 value, QDataStream &stream) const;
   void writeUnsigned(quint32 value, QDataStream &stream) const;
   qint32 deltaTo(double value, double previous) const;
-
-  static QSet<QString> m_blacklistedTags;
 };
 
 }
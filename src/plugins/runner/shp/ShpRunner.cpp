@@ -141,6 +141,7 @@ GeoDataDocument *ShpRunner::parseFile(const QString &fileName, DocumentRole role
                                           shape->padfX[k], shape->padfY[k],
                                           0, GeoDataCoordinates::Degree ) );
                         }
+                        line->setPacked( true );
                         geom->append( line );
                     }
                     placemark->setGeometry( geom );
@@ -153,6 +154,7 @@ GeoDataDocument *ShpRunner::parseFile(const QString &fileName, DocumentRole role
                                       shape->padfX[j], shape->padfY[j],
                                       0, GeoDataCoordinates::Degree ) );
                     }
+                    line->setPacked( true );
                     placemark->setGeometry( line );
                     mDebug() << "arc " << placemark->name() << " " << shape->nParts;
                 }
@@ -175,6 +177,7 @@ GeoDataDocument *ShpRunner::parseFile(const QString &fileName, DocumentRole role
                                          0, GeoDataCoordinates::Degree ) );
                         }
                         isRingClockwise = ring.isClockwise();
+                        ring.setPacked( true );
                         if ( j == 0 || isRingClockwise ) {
                             poly = new GeoDataPolygon;
                             ++polygonCount;
@@ -205,6 +208,7 @@ GeoDataDocument *ShpRunner::parseFile(const QString &fileName, DocumentRole role
                                          shape->padfX[j], shape->padfY[j],
                                          0, GeoDataCoordinates::Degree ) );
                     }
+                    ring.setPacked( true );
                     poly->setOuterBoundary( ring );
                     placemark->setGeometry( poly );
                     mDebug() << "poly " << placemark->name() << " " << shape->nParts;
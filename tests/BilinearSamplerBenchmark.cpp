@@ -0,0 +1,67 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "BilinearSampler.h"
+#include "TestSamplerInput.h"
+
+#include <QImage>
+#include <QTest>
+#include <QVector>
+
+Q_DECLARE_METATYPE( Marble::BilinearSampler::Implementation )
+
+namespace Marble
+{
+
+class BilinearSamplerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkSample_data();
+    void benchmarkSample();
+};
+
+void BilinearSamplerBenchmark::benchmarkSample_data()
+{
+    QTest::addColumn<BilinearSampler::Implementation>( "implementation" );
+
+    QTest::newRow( "Scalar" ) << BilinearSampler::Scalar;
+    QTest::newRow( "SSE2" ) << BilinearSampler::Sse2;
+    QTest::newRow( "AVX2" ) << BilinearSampler::Avx2;
+    QTest::newRow( "NEON" ) << BilinearSampler::Neon;
+}
+
+void BilinearSamplerBenchmark::benchmarkSample()
+{
+    QFETCH( BilinearSampler::Implementation, implementation );
+
+    if ( !BilinearSampler::isSupported( implementation ) ) {
+        QSKIP( "Implementation not supported on this CPU" );
+    }
+
+    qsrand( 42 );
+    const QImage image = TestSamplerInput::randomImage( 675, 675, QImage::Format_RGB32 );
+
+    // one scanline of a full HD canvas
+    const int count = 1920;
+    QVector<qreal> x;
+    QVector<qreal> y;
+    TestSamplerInput::randomPositions( image, count, x, y );
+    QVector<QRgb> result( count );
+
+    QBENCHMARK {
+        BilinearSampler::sample( implementation, image, x.constData(), y.constData(), count, result.data() );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::BilinearSamplerBenchmark )
+
+#include "BilinearSamplerBenchmark.moc"
@@ -0,0 +1,96 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "BilinearSampler.h"
+#include "StackedTile.h"
+#include "TestSamplerInput.h"
+#include "TextureTile.h"
+#include "TileId.h"
+
+#include <QImage>
+#include <QSharedPointer>
+#include <QTest>
+#include <QVector>
+
+Q_DECLARE_METATYPE( Marble::BilinearSampler::Implementation )
+
+namespace Marble
+{
+
+class BilinearSamplerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testBitExactness_data();
+    void testBitExactness();
+};
+
+void BilinearSamplerTest::testBitExactness_data()
+{
+    QTest::addColumn<BilinearSampler::Implementation>( "implementation" );
+    QTest::addColumn<int>( "format" );
+    QTest::addColumn<int>( "size" );
+
+    const QList<QPair<BilinearSampler::Implementation, const char *> > implementations = QList<QPair<BilinearSampler::Implementation, const char *> >()
+            << qMakePair( BilinearSampler::Scalar, "Scalar" )
+            << qMakePair( BilinearSampler::Sse2, "SSE2" )
+            << qMakePair( BilinearSampler::Avx2, "AVX2" )
+            << qMakePair( BilinearSampler::Neon, "NEON" );
+
+    for ( const auto &implementation: implementations ) {
+        for ( int size: QList<int>() << 256 << 675 ) {
+            const QByteArray name = QByteArray( implementation.second ) + ' ' + QByteArray::number( size );
+            QTest::newRow( ( name + " RGB32" ).constData() ) << implementation.first << int( QImage::Format_RGB32 ) << size;
+            QTest::newRow( ( name + " ARGB32" ).constData() ) << implementation.first << int( QImage::Format_ARGB32 ) << size;
+        }
+    }
+}
+
+void BilinearSamplerTest::testBitExactness()
+{
+    QFETCH( BilinearSampler::Implementation, implementation );
+    QFETCH( int, format );
+    QFETCH( int, size );
+
+    if ( !BilinearSampler::isSupported( implementation ) ) {
+        QSKIP( "Implementation not supported on this CPU" );
+    }
+
+    qsrand( size );
+    const QImage image = TestSamplerInput::randomImage( size, size, QImage::Format( format ) );
+
+    // an odd count checks the scalar tail of the kernels
+    const int count = 100003;
+    QVector<qreal> x;
+    QVector<qreal> y;
+    TestSamplerInput::randomPositions( image, count, x, y );
+
+    QVector<QRgb> actual( count );
+    BilinearSampler::sample( implementation, image, x.constData(), y.constData(), count, actual.data() );
+
+    // what the texture mappers sample pixel by pixel
+    const QVector<QSharedPointer<TextureTile> > tiles = QVector<QSharedPointer<TextureTile> >()
+            << QSharedPointer<TextureTile>( new TextureTile( TileId(), image, 0 ) );
+    const StackedTile tile( TileId(), image, tiles );
+
+    for ( int i = 0; i < count; ++i ) {
+        const QRgb expected = tile.pixelF( x[i], y[i] );
+        if ( actual[i] != expected ) {
+            QFAIL( qPrintable( QString( "%1 instead of %2 at %3, %4" ).arg( actual[i], 8, 16, QLatin1Char( '0' ) )
+                                                                    .arg( expected, 8, 16, QLatin1Char( '0' ) )
+                                                                    .arg( x[i] ).arg( y[i] ) ) );
+        }
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::BilinearSamplerTest )
+
+#include "BilinearSamplerTest.moc"
@@ -0,0 +1,96 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "blendings/Blending.h"
+#include "blendings/BlendingFactory.h"
+#include "TextureTile.h"
+#include "TileId.h"
+
+#include <QImage>
+#include <QTest>
+#include <QVector>
+
+namespace Marble
+{
+
+class BlendingAlgorithmsBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkBlending_data();
+    void benchmarkBlending();
+
+private:
+    static QImage image( int size, int seed, QImage::Format format = QImage::Format_ARGB32_Premultiplied );
+};
+
+QImage BlendingAlgorithmsBenchmark::image( int size, int seed, QImage::Format format )
+{
+    QImage result( size, size, QImage::Format_ARGB32_Premultiplied );
+    for ( int y = 0; y < size; ++y ) {
+        for ( int x = 0; x < size; ++x ) {
+            result.setPixel( x, y, qRgb( ( x * 7 + seed ) % 256, ( y * 13 + seed ) % 256, ( x * y + seed ) % 256 ) );
+        }
+    }
+    return result.convertToFormat( format );
+}
+
+void BlendingAlgorithmsBenchmark::benchmarkBlending_data()
+{
+    QTest::addColumn<QString>( "blendingName" );
+    QTest::addColumn<int>( "size" );
+
+    // all blendings of BlendingAlgorithms.h known to BlendingFactory
+    const QStringList names = QStringList()
+        << "OverpaintBlending"
+        << "AllanonBlending" << "ArcusTangentBlending" << "GeometricMeanBlending"
+        << "LinearLightBlending" << "OverlayBlending"
+        << "ColorBurnBlending" << "DarkBlending" << "DarkenBlending" << "DivideBlending"
+        << "GammaDarkBlending" << "LinearBurnBlending" << "MultiplyBlending" << "SubtractiveBlending"
+        << "AdditiveBlending" << "ColorDodgeBlending" << "GammaLightBlending" << "HardLightBlending"
+        << "LightBlending" << "LightenBlending" << "PinLightBlending" << "ScreenBlending"
+        << "SoftLightBlending" << "VividLightBlending"
+        << "BleachBlending" << "DifferenceBlending" << "EquivalenceBlending" << "HalfDifferenceBlending"
+        << "CloudsBlending" << "GrayscaleBlending";
+
+    for ( const QString &name: names ) {
+        for ( int size: QVector<int>() << 256 << 675 ) {
+            QTest::newRow( QString( "%1 %2" ).arg( name ).arg( size ).toLatin1() ) << name << size;
+        }
+    }
+}
+
+void BlendingAlgorithmsBenchmark::benchmarkBlending()
+{
+    QFETCH( QString, blendingName );
+    QFETCH( int, size );
+
+    BlendingFactory factory;
+    const Blending *blending = factory.findBlending( blendingName );
+    QVERIFY( blending );
+
+    const QImage bottom = image( size, 0 );
+    const TextureTile tile( TileId(), image( size, 100, QImage::Format_RGB32 ), blending );
+
+    // warms up lookup tables built on first use
+    QImage result = bottom;
+    blending->blend( &result, &tile );
+
+    QBENCHMARK {
+        // blending into a fresh copy, as MergedLayerDecorator does for each tile
+        result = bottom;
+        blending->blend( &result, &tile );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::BlendingAlgorithmsBenchmark )
+
+#include "BlendingAlgorithmsBenchmark.moc"
@@ -0,0 +1,184 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "blendings/Blending.h"
+#include "blendings/BlendingFactory.h"
+#include "TextureTile.h"
+#include "TileId.h"
+
+#include <QImage>
+#include <QTest>
+#include <qmath.h>
+
+namespace Marble
+{
+
+class BlendingAlgorithmsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testIndependentChannels_data();
+    void testIndependentChannels();
+    void testClouds();
+    void testGrayscale();
+    void testTopImageFormats_data();
+    void testTopImageFormats();
+
+private:
+    static QImage image( int size, int seed, QImage::Format format = QImage::Format_ARGB32_Premultiplied );
+    static QImage blended( const QString &blendingName, const QImage &bottom, const QImage &top );
+
+    // The per pixel loop the blendings used before, with the results clamped to 0..1
+    template<class BlendChannel>
+    static QImage reference( const QImage &bottom, const QImage &top, BlendChannel blendChannel );
+};
+
+QImage BlendingAlgorithmsTest::image( int size, int seed, QImage::Format format )
+{
+    QImage result( size, size, QImage::Format_ARGB32_Premultiplied );
+    for ( int y = 0; y < size; ++y ) {
+        for ( int x = 0; x < size; ++x ) {
+            result.setPixel( x, y, qRgb( ( x * 7 + seed ) % 256, ( y * 13 + seed ) % 256, ( x * y + seed ) % 256 ) );
+        }
+    }
+    return result.convertToFormat( format );
+}
+
+QImage BlendingAlgorithmsTest::blended( const QString &blendingName, const QImage &bottom, const QImage &top )
+{
+    BlendingFactory factory;
+    const Blending *blending = factory.findBlending( blendingName );
+    Q_ASSERT( blending );
+
+    const TextureTile tile( TileId(), top, blending );
+    QImage result = bottom;
+    blending->blend( &result, &tile );
+    return result;
+}
+
+template<class BlendChannel>
+QImage BlendingAlgorithmsTest::reference( const QImage &bottom, const QImage &top, BlendChannel blendChannel )
+{
+    const auto channel = [blendChannel]( int bottomChannel, int topChannel ) {
+        return int( qBound( 0.0, blendChannel( bottomChannel / 255.0, topChannel / 255.0 ), 1.0 ) * 255.0 );
+    };
+
+    QImage result = bottom;
+    for ( int y = 0; y < result.height(); ++y ) {
+        for ( int x = 0; x < result.width(); ++x ) {
+            const QRgb bottomPixel = result.pixel( x, y );
+            const QRgb topPixel = top.pixel( x, y );
+            result.setPixel( x, y, qRgb( channel( qRed( bottomPixel ), qRed( topPixel ) ),
+                                         channel( qGreen( bottomPixel ), qGreen( topPixel ) ),
+                                         channel( qBlue( bottomPixel ), qBlue( topPixel ) ) ) );
+        }
+    }
+    return result;
+}
+
+void BlendingAlgorithmsTest::testIndependentChannels_data()
+{
+    QTest::addColumn<QString>( "blendingName" );
+
+    QTest::newRow( "Allanon" ) << QStringLiteral( "AllanonBlending" );
+    QTest::newRow( "Multiply" ) << QStringLiteral( "MultiplyBlending" );
+    QTest::newRow( "Screen" ) << QStringLiteral( "ScreenBlending" );
+    QTest::newRow( "Darken" ) << QStringLiteral( "DarkenBlending" );
+    QTest::newRow( "GammaDark" ) << QStringLiteral( "GammaDarkBlending" );
+    QTest::newRow( "Divide" ) << QStringLiteral( "DivideBlending" );
+}
+
+void BlendingAlgorithmsTest::testIndependentChannels()
+{
+    QFETCH( QString, blendingName );
+
+    const QImage bottom = image( 64, 0 );
+    const QImage top = image( 64, 100 );
+    const QImage result = blended( blendingName, bottom, top );
+
+    QImage expected;
+    if ( blendingName == QLatin1String( "AllanonBlending" ) ) {
+        expected = reference( bottom, top, []( qreal b, qreal t ) { return ( b + t ) / 2.0; } );
+    } else if ( blendingName == QLatin1String( "MultiplyBlending" ) ) {
+        expected = reference( bottom, top, []( qreal b, qreal t ) { return b * t; } );
+    } else if ( blendingName == QLatin1String( "ScreenBlending" ) ) {
+        expected = reference( bottom, top, []( qreal b, qreal t ) { return 1.0 - ( 1.0 - b ) * ( 1.0 - t ); } );
+    } else if ( blendingName == QLatin1String( "DarkenBlending" ) ) {
+        expected = reference( bottom, top, []( qreal b, qreal t ) { return b > t ? t : b; } );
+    } else if ( blendingName == QLatin1String( "GammaDarkBlending" ) ) {
+        expected = reference( bottom, top, []( qreal b, qreal t ) { return pow( b, 1.0 / t ); } );
+    } else {
+        // exceeds 1 and divides by zero for bright top pixels
+        expected = reference( bottom, top, []( qreal b, qreal t ) { return log1p( b / ( 1.0 - t ) / 8.0 ) / log( 2.0 ); } );
+    }
+
+    QCOMPARE( result, expected );
+}
+
+void BlendingAlgorithmsTest::testClouds()
+{
+    const QImage bottom = image( 64, 0 );
+    const QImage top = image( 64, 50, QImage::Format_RGB32 );
+    const QImage result = blended( QStringLiteral( "CloudsBlending" ), bottom, top );
+
+    for ( int y = 0; y < bottom.height(); ++y ) {
+        for ( int x = 0; x < bottom.width(); ++x ) {
+            const qreal c = qRed( top.pixel( x, y ) ) / 255.0;
+            const QRgb bottomPixel = bottom.pixel( x, y );
+            const QRgb expected = qRgb( int( qRed( bottomPixel ) + ( 255 - qRed( bottomPixel ) ) * c ),
+                                        int( qGreen( bottomPixel ) + ( 255 - qGreen( bottomPixel ) ) * c ),
+                                        int( qBlue( bottomPixel ) + ( 255 - qBlue( bottomPixel ) ) * c ) );
+            QCOMPARE( result.pixel( x, y ), expected );
+        }
+    }
+}
+
+void BlendingAlgorithmsTest::testGrayscale()
+{
+    const QImage bottom = image( 64, 0 );
+    const QImage top = image( 64, 50 );
+    const QImage result = blended( QStringLiteral( "GrayscaleBlending" ), bottom, top );
+
+    for ( int y = 0; y < bottom.height(); ++y ) {
+        for ( int x = 0; x < bottom.width(); ++x ) {
+            const int gray = qGray( top.pixel( x, y ) );
+            QCOMPARE( result.pixel( x, y ), qRgb( gray, gray, gray ) );
+        }
+    }
+}
+
+void BlendingAlgorithmsTest::testTopImageFormats_data()
+{
+    QTest::addColumn<int>( "format" );
+
+    QTest::newRow( "RGB32" ) << int( QImage::Format_RGB32 );
+    QTest::newRow( "ARGB32" ) << int( QImage::Format_ARGB32 );
+    QTest::newRow( "RGB888" ) << int( QImage::Format_RGB888 );
+    QTest::newRow( "Indexed8" ) << int( QImage::Format_Indexed8 );
+}
+
+void BlendingAlgorithmsTest::testTopImageFormats()
+{
+    QFETCH( int, format );
+
+    const QImage bottom = image( 64, 0 );
+    const QImage top = image( 64, 100, QImage::Format( format ) );
+    const QImage premultiplied = top.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+
+    QCOMPARE( blended( QStringLiteral( "MultiplyBlending" ), bottom, top ),
+              blended( QStringLiteral( "MultiplyBlending" ), bottom, premultiplied ) );
+    QCOMPARE( blended( QStringLiteral( "GrayscaleBlending" ), bottom, top ),
+              blended( QStringLiteral( "GrayscaleBlending" ), bottom, premultiplied ) );
+}
+
+}
+
+QTEST_MAIN( Marble::BlendingAlgorithmsTest )
+
+#include "BlendingAlgorithmsTest.moc"
@@ -0,0 +1,57 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "DiscCache.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class DiscCacheBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkInsert();
+};
+
+static QString tileKey( int i )
+{
+    return QStringLiteral( "earth/bluemarble/%1/%2.jpg" ).arg( i / 1000 ).arg( i % 1000 );
+}
+
+void DiscCacheBenchmark::benchmarkInsert()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    DiscCache cache( directory.path() );
+    cache.setCacheLimit( 2 * 1024 * 1024 );
+
+    // small tiles make the cache hold many entries, which used to
+    // make every insert scan all of them for the oldest one
+    const QByteArray data( 64, 'x' );
+
+    QBENCHMARK_ONCE {
+        for ( int i = 0; i < 500000; ++i ) {
+            cache.insert( tileKey( i ), data );
+        }
+    }
+
+    QVERIFY( cache.size() <= cache.cacheLimit() );
+    QVERIFY( cache.exists( tileKey( 499999 ) ) );
+    QVERIFY( !cache.exists( tileKey( 0 ) ) );
+}
+
+}
+
+QTEST_MAIN( Marble::DiscCacheBenchmark )
+
+#include "DiscCacheBenchmark.moc"
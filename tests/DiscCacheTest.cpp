@@ -0,0 +1,194 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "DiscCache.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class DiscCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testLeastRecentlyUsedEviction();
+    void testJournalReplay();
+    void testBatchedAccesses();
+    void testBatchedEviction();
+    void testIndexSnapshot();
+};
+
+static QString tileKey( int i )
+{
+    return QStringLiteral( "earth/bluemarble/%1/%2.jpg" ).arg( i / 1000 ).arg( i % 1000 );
+}
+
+void DiscCacheTest::testLeastRecentlyUsedEviction()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    DiscCache cache( directory.path() );
+    cache.setCacheLimit( 1000 );
+
+    const QByteArray data( 100, 'x' );
+    for ( int i = 0; i < 10; ++i ) {
+        QVERIFY( cache.insert( tileKey( i ), data ) );
+    }
+
+    // the tenth insert crosses 95% of the limit and evicts the oldest entry
+    QVERIFY( !cache.exists( tileKey( 0 ) ) );
+    QCOMPARE( cache.count(), 9 );
+    QCOMPARE( cache.size(), quint64( 900 ) );
+
+    QByteArray found;
+    QVERIFY( cache.find( tileKey( 1 ), found ) );
+    QCOMPARE( found, data );
+
+    // tileKey( 1 ) has just been used, so tileKey( 2 ) is next
+    QVERIFY( cache.insert( tileKey( 10 ), data ) );
+    QVERIFY( cache.exists( tileKey( 1 ) ) );
+    QVERIFY( !cache.exists( tileKey( 2 ) ) );
+    QVERIFY( cache.exists( tileKey( 3 ) ) );
+    QCOMPARE( cache.count(), 9 );
+
+    // replacing an entry must not count it twice
+    QVERIFY( cache.insert( tileKey( 3 ), QByteArray( 50, 'y' ) ) );
+    QCOMPARE( cache.size(), quint64( 850 ) );
+
+    cache.remove( tileKey( 3 ) );
+    QVERIFY( !cache.exists( tileKey( 3 ) ) );
+    QCOMPARE( cache.size(), quint64( 800 ) );
+}
+
+void DiscCacheTest::testJournalReplay()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    DiscCache *cache = new DiscCache( directory.path() );
+
+    const QByteArray data( 10, 'x' );
+    for ( int i = 0; i < 5; ++i ) {
+        QVERIFY( cache->insert( tileKey( i ), data ) );
+    }
+    cache->remove( tileKey( 2 ) );
+
+    {
+        // The first cache is still alive and hasn't written its index yet,
+        // as if the application had crashed.
+        const DiscCache recovered( directory.path() );
+        QCOMPARE( recovered.count(), 4 );
+        QCOMPARE( recovered.size(), quint64( 40 ) );
+        QVERIFY( recovered.exists( tileKey( 0 ) ) );
+        QVERIFY( !recovered.exists( tileKey( 2 ) ) );
+        QVERIFY( recovered.exists( tileKey( 4 ) ) );
+    }
+
+    delete cache;
+}
+
+void DiscCacheTest::testBatchedAccesses()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    DiscCache *cache = new DiscCache( directory.path() );
+
+    const QByteArray data( 100, 'x' );
+    for ( int i = 0; i < 3; ++i ) {
+        QVERIFY( cache->insert( tileKey( i ), data ) );
+    }
+
+    // cache hits don't write to the journal right away
+    QFile journal( directory.path() + QLatin1String( "/cache_index.journal" ) );
+    const qint64 journalSize = journal.size();
+    QVERIFY( journalSize > 0 );
+    QByteArray found;
+    for ( int i = 0; i < 100; ++i ) {
+        QVERIFY( cache->find( tileKey( 0 ), found ) );
+    }
+    QCOMPARE( journal.size(), journalSize );
+
+    // the next change writes them first
+    QVERIFY( cache->insert( tileKey( 3 ), data ) );
+
+    {
+        // as if the application had crashed, tileKey( 0 ) is newer than 1 and 2 now
+        DiscCache recovered( directory.path() );
+        QCOMPARE( recovered.count(), 4 );
+        recovered.setCacheLimit( 300 );
+        QVERIFY( recovered.exists( tileKey( 0 ) ) );
+        QVERIFY( !recovered.exists( tileKey( 1 ) ) );
+        QVERIFY( !recovered.exists( tileKey( 2 ) ) );
+        QVERIFY( recovered.exists( tileKey( 3 ) ) );
+    }
+
+    delete cache;
+}
+
+void DiscCacheTest::testBatchedEviction()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    DiscCache *cache = new DiscCache( directory.path() );
+
+    const QByteArray data( 100, 'x' );
+    for ( int i = 0; i < 20; ++i ) {
+        QVERIFY( cache->insert( tileKey( i ), data ) );
+    }
+
+    // lowering the limit evicts the eleven oldest entries at once
+    cache->setCacheLimit( 1000 );
+    QCOMPARE( cache->count(), 9 );
+
+    {
+        // as if the application had crashed, all of the removals were journaled
+        const DiscCache recovered( directory.path() );
+        QCOMPARE( recovered.count(), 9 );
+        QCOMPARE( recovered.size(), quint64( 900 ) );
+        QVERIFY( !recovered.exists( tileKey( 10 ) ) );
+        QVERIFY( recovered.exists( tileKey( 11 ) ) );
+        QVERIFY( recovered.exists( tileKey( 19 ) ) );
+    }
+
+    delete cache;
+}
+
+void DiscCacheTest::testIndexSnapshot()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    {
+        DiscCache cache( directory.path() );
+        cache.setCacheLimit( 4096 );
+        QVERIFY( cache.insert( tileKey( 0 ), QByteArray( 10, 'x' ) ) );
+        QVERIFY( cache.insert( tileKey( 1 ), QByteArray( 20, 'x' ) ) );
+    }
+
+    DiscCache cache( directory.path() );
+    QCOMPARE( cache.cacheLimit(), quint64( 4096 ) );
+    QCOMPARE( cache.count(), 2 );
+    QCOMPARE( cache.size(), quint64( 30 ) );
+
+    cache.clear();
+    QCOMPARE( cache.count(), 0 );
+    QCOMPARE( cache.size(), quint64( 0 ) );
+    QVERIFY( !QFile::exists( directory.path() + QLatin1Char( '/' ) + tileKey( 0 ).replace( QLatin1Char( '/' ), QLatin1Char( '_' ) ) ) );
+}
+
+}
+
+QTEST_MAIN( Marble::DiscCacheTest )
+
+#include "DiscCacheTest.moc"
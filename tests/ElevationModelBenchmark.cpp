@@ -0,0 +1,87 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ElevationModel.h"
+#include "GeoDataCoordinates.h"
+#include "HttpDownloadManager.h"
+#include "MarbleDirs.h"
+#include "PluginManager.h"
+#include "TestElevationTiles.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class ElevationModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkRoute_data();
+    void benchmarkRoute();
+
+private:
+    QTemporaryDir m_localPath;
+    QVector<GeoDataCoordinates> m_route;
+};
+
+void ElevationModelBenchmark::initTestCase()
+{
+    QVERIFY( m_localPath.isValid() );
+    qputenv( "XDG_DATA_HOME", m_localPath.path().toLocal8Bit() );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    TestElevationTiles tiles;
+    QVERIFY( tiles.init() );
+    m_route = TestElevationTiles::route( 100000 );
+    QVERIFY( tiles.write( m_route ) );
+}
+
+void ElevationModelBenchmark::benchmarkRoute_data()
+{
+    QTest::addColumn<int>( "mode" );
+
+    QTest::newRow( "height" ) << -1;
+    QTest::newRow( "heights" ) << int( ElevationModel::Sequential );
+    QTest::newRow( "heights threaded" ) << int( ElevationModel::Threaded );
+}
+
+void ElevationModelBenchmark::benchmarkRoute()
+{
+    QFETCH( int, mode );
+
+    HttpDownloadManager downloadManager( 0 );
+    downloadManager.setDownloadEnabled( false );
+    PluginManager pluginManager;
+
+    QVector<qreal> heights;
+    QBENCHMARK {
+        // a new model each time, so decoding the tiles is part of the measurement
+        const ElevationModel model( &downloadManager, &pluginManager );
+        if ( mode < 0 ) {
+            heights.clear();
+            heights.reserve( m_route.size() );
+            for ( const GeoDataCoordinates &point: m_route ) {
+                heights << model.height( point.longitude( GeoDataCoordinates::Degree ), point.latitude( GeoDataCoordinates::Degree ) );
+            }
+        } else {
+            heights = model.heights( m_route, ElevationModel::QueryMode( mode ) );
+        }
+    }
+    QCOMPARE( heights.size(), m_route.size() );
+}
+
+}
+
+QTEST_MAIN( Marble::ElevationModelBenchmark )
+
+#include "ElevationModelBenchmark.moc"
@@ -0,0 +1,141 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ElevationModel.h"
+#include "GeoDataCoordinates.h"
+#include "GeoDataLineString.h"
+#include "HttpDownloadManager.h"
+#include "MarbleDirs.h"
+#include "PluginManager.h"
+#include "TestElevationTiles.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class ElevationModelTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testHeight();
+    void testHeights();
+    void testHeightProfile();
+
+private:
+    static qint16 elevation( int x, int y ) { return TestElevationTiles::elevation( x, y ); }
+    GeoDataCoordinates coordinates( qreal textureX, qreal textureY ) const { return m_tiles.coordinates( textureX, textureY ); }
+
+    QTemporaryDir m_localPath;
+    TestElevationTiles m_tiles;
+    int m_pixelX;
+    int m_pixelY;
+    QVector<GeoDataCoordinates> m_route;
+};
+
+void ElevationModelTest::initTestCase()
+{
+    QVERIFY( m_localPath.isValid() );
+    qputenv( "XDG_DATA_HOME", m_localPath.path().toLocal8Bit() );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+    QVERIFY( m_tiles.init() );
+
+    m_route = TestElevationTiles::route( 100000 );
+
+    // a pixel next to the blocks without data, close to the start of the route
+    qreal textureX;
+    qreal textureY;
+    m_tiles.textureCoordinates( m_route.first(), textureX, textureY );
+    m_pixelX = static_cast<int>( textureX ) / 101 * 101;
+    m_pixelY = static_cast<int>( textureY ) / 103 * 103;
+
+    QVector<GeoDataCoordinates> points = m_route;
+    points << coordinates( m_pixelX + 5, m_pixelY + 5 ) << coordinates( m_pixelX + 0.5, m_pixelY + 0.5 );
+    QVERIFY( m_tiles.write( points ) );
+}
+
+void ElevationModelTest::testHeight()
+{
+    HttpDownloadManager downloadManager( 0 );
+    downloadManager.setDownloadEnabled( false );
+    PluginManager pluginManager;
+    const ElevationModel model( &downloadManager, &pluginManager );
+
+    const GeoDataCoordinates pixel = coordinates( m_pixelX + 5, m_pixelY + 5 );
+    const qreal height = model.height( pixel.longitude( GeoDataCoordinates::Degree ), pixel.latitude( GeoDataCoordinates::Degree ) );
+    QVERIFY( qAbs( height - elevation( m_pixelX + 5, m_pixelY + 5 ) ) < 0.01 );
+
+    // between two pixels
+    const GeoDataCoordinates between = coordinates( m_pixelX + 5.5, m_pixelY + 5 );
+    const qreal expected = 0.5 * ( elevation( m_pixelX + 5, m_pixelY + 5 ) + elevation( m_pixelX + 6, m_pixelY + 5 ) );
+    QVERIFY( qAbs( model.height( between.longitude( GeoDataCoordinates::Degree ), between.latitude( GeoDataCoordinates::Degree ) ) - expected ) < 0.01 );
+
+    const GeoDataCoordinates noData = coordinates( m_pixelX + 0.5, m_pixelY + 0.5 );
+    QCOMPARE( model.height( noData.longitude( GeoDataCoordinates::Degree ), noData.latitude( GeoDataCoordinates::Degree ) ), qreal( invalidElevationData ) );
+}
+
+void ElevationModelTest::testHeights()
+{
+    HttpDownloadManager downloadManager( 0 );
+    downloadManager.setDownloadEnabled( false );
+    PluginManager pluginManager;
+    const ElevationModel model( &downloadManager, &pluginManager );
+
+    // in reverse order and with the no data points in between, so the samples need to be sorted by tile
+    QVector<GeoDataCoordinates> points;
+    for ( int i = m_route.size() - 1; i >= 0; i -= 97 ) {
+        points << m_route[i];
+        if ( i % 5 == 0 ) {
+            points << coordinates( m_pixelX + 0.5, m_pixelY + 0.5 );
+        }
+    }
+
+    QVector<qreal> expected;
+    for ( const GeoDataCoordinates &point: points ) {
+        expected << model.height( point.longitude( GeoDataCoordinates::Degree ), point.latitude( GeoDataCoordinates::Degree ) );
+    }
+    QCOMPARE( model.heights( points ), expected );
+    QCOMPARE( model.heights( points, ElevationModel::Threaded ), expected );
+
+    GeoDataLineString lineString;
+    lineString.append( m_route );
+    const QVector<qreal> heights = model.heights( m_route );
+    QCOMPARE( heights.size(), m_route.size() );
+    QCOMPARE( model.heights( m_route, ElevationModel::Threaded ), heights );
+    QCOMPARE( model.heights( lineString, ElevationModel::Threaded ), heights );
+
+    QCOMPARE( model.heights( QVector<GeoDataCoordinates>() ), QVector<qreal>() );
+}
+
+void ElevationModelTest::testHeightProfile()
+{
+    HttpDownloadManager downloadManager( 0 );
+    downloadManager.setDownloadEnabled( false );
+    PluginManager pluginManager;
+    const ElevationModel model( &downloadManager, &pluginManager );
+
+    const GeoDataCoordinates from = m_route.first();
+    const GeoDataCoordinates to = m_route[m_route.size() / 100];
+    const QVector<GeoDataCoordinates> profile = model.heightProfile( from.longitude( GeoDataCoordinates::Degree ), from.latitude( GeoDataCoordinates::Degree ),
+                                                                     to.longitude( GeoDataCoordinates::Degree ), to.latitude( GeoDataCoordinates::Degree ) );
+    QVERIFY( profile.size() > 100 );
+    for ( const GeoDataCoordinates &point: profile ) {
+        const qreal height = model.height( point.longitude( GeoDataCoordinates::Degree ), point.latitude( GeoDataCoordinates::Degree ) );
+        QVERIFY( qAbs( point.altitude() - height ) < 0.01 );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::ElevationModelTest )
+
+#include "ElevationModelTest.moc"
@@ -0,0 +1,38 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "FrameProfiler.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+class FrameProfilerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkDisabledScope();
+};
+
+void FrameProfilerBenchmark::benchmarkDisabledScope()
+{
+    QVERIFY( !FrameProfiler::isEnabled() );
+
+    // what every instrumented function pays while nobody profiles
+    QBENCHMARK {
+        const FrameProfilerScope scope( "ViewportParams::screenCoordinates" );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::FrameProfilerBenchmark )
+
+#include "FrameProfilerBenchmark.moc"
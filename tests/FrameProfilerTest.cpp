@@ -0,0 +1,178 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "FrameProfiler.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+#include <QThread>
+
+namespace Marble
+{
+
+class ProfiledThread : public QThread
+{
+public:
+    void run() override
+    {
+        const FrameProfilerScope scope( "ProfiledThread::run" );
+    }
+};
+
+class FrameProfilerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void cleanup();
+    void testDisabled();
+    void testFrames();
+    void testRingBuffer();
+    void testChromeTrace();
+    void testCsvSummary();
+
+private:
+    static void paintFrame();
+};
+
+void FrameProfilerTest::paintFrame()
+{
+    FrameProfiler::beginFrame();
+    {
+        FrameProfilerScope outer( "Layer" );
+        outer.setDetail( QStringLiteral( "Geometries: 42" ) );
+        const FrameProfilerScope inner( "Projection" );
+    }
+    FrameProfiler::endFrame();
+}
+
+void FrameProfilerTest::cleanup()
+{
+    FrameProfiler::setEnabled( false );
+    FrameProfiler::setFrameCount( 120 );
+}
+
+void FrameProfilerTest::testDisabled()
+{
+    QVERIFY( !FrameProfiler::isEnabled() );
+
+    FrameProfilerScope scope( "Layer" );
+    QVERIFY( !scope.isRecording() );
+    QCOMPARE( scope.elapsed(), qint64( 0 ) );
+
+    // measured for the run time trace without recording
+    const FrameProfilerScope measured( "Layer", true );
+    QVERIFY( !measured.isRecording() );
+    QTest::qSleep( 1 );
+    QVERIFY( measured.elapsed() > 0 );
+}
+
+void FrameProfilerTest::testFrames()
+{
+    FrameProfiler::setEnabled( true );
+    paintFrame();
+    paintFrame();
+
+    const QVector<FrameProfiler::Frame> frames = FrameProfiler::frames();
+    QCOMPARE( frames.size(), 3 );
+    QCOMPARE( frames[0].number, qint64( 0 ) );
+    QVERIFY( frames[0].events.isEmpty() );
+
+    for ( int i = 1; i < frames.size(); ++i ) {
+        const FrameProfiler::Frame &frame = frames[i];
+        QCOMPARE( frame.number, qint64( i ) );
+        QVERIFY( frame.duration >= 0 );
+        QCOMPARE( frame.events.size(), 2 );
+
+        // scopes are recorded when they end, the inner one first
+        const FrameProfiler::Event &inner = frame.events[0];
+        const FrameProfiler::Event &outer = frame.events[1];
+        QCOMPARE( QByteArray( inner.name ), QByteArray( "Projection" ) );
+        QCOMPARE( QByteArray( outer.name ), QByteArray( "Layer" ) );
+        QCOMPARE( outer.detail, QStringLiteral( "Geometries: 42" ) );
+        QCOMPARE( outer.thread, 0 );
+        QVERIFY( outer.start <= inner.start );
+        QVERIFY( inner.start + inner.duration <= outer.start + outer.duration );
+        QVERIFY( frame.start <= outer.start );
+        QVERIFY( outer.start + outer.duration <= frame.start + frame.duration );
+    }
+
+    FrameProfiler::beginFrame();
+    ProfiledThread thread;
+    thread.start();
+    thread.wait();
+    FrameProfiler::endFrame();
+    const FrameProfiler::Frame last = FrameProfiler::frames().last();
+    QCOMPARE( last.events.size(), 1 );
+    QCOMPARE( last.events[0].thread, 1 );
+}
+
+void FrameProfilerTest::testRingBuffer()
+{
+    FrameProfiler::setFrameCount( 5 );
+    FrameProfiler::setEnabled( true );
+    for ( int i = 0; i < 12; ++i ) {
+        paintFrame();
+    }
+
+    const QVector<FrameProfiler::Frame> frames = FrameProfiler::frames();
+    QCOMPARE( frames.size(), 5 );
+    for ( int i = 0; i < frames.size(); ++i ) {
+        QCOMPARE( frames[i].number, qint64( 8 + i ) );
+    }
+
+    // re-enabling starts over
+    FrameProfiler::setEnabled( false );
+    paintFrame();
+    FrameProfiler::setEnabled( true );
+    QCOMPARE( FrameProfiler::frames().size(), 1 );
+}
+
+void FrameProfilerTest::testChromeTrace()
+{
+    FrameProfiler::setEnabled( true );
+    paintFrame();
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson( FrameProfiler::chromeTrace(), &error );
+    QCOMPARE( error.error, QJsonParseError::NoError );
+
+    const QJsonArray events = document.object().value( QStringLiteral( "traceEvents" ) ).toArray();
+    QStringList names;
+    for ( const QJsonValue &value: events ) {
+        const QJsonObject event = value.toObject();
+        if ( event.value( QStringLiteral( "ph" ) ).toString() == QLatin1String( "X" ) ) {
+            names << event.value( QStringLiteral( "name" ) ).toString();
+            QVERIFY( event.value( QStringLiteral( "dur" ) ).toDouble() >= 0 );
+        }
+    }
+    QCOMPARE( names, QStringList() << QStringLiteral( "Frame" ) << QStringLiteral( "Projection" ) << QStringLiteral( "Layer" ) );
+}
+
+void FrameProfilerTest::testCsvSummary()
+{
+    FrameProfiler::setEnabled( true );
+    paintFrame();
+    paintFrame();
+    paintFrame();
+
+    const QList<QByteArray> lines = FrameProfiler::csvSummary().trimmed().split( '\n' );
+    QCOMPARE( lines.size(), 4 );
+    QCOMPARE( lines[0], QByteArray( "name,calls,total_ms,mean_ms,min_ms,max_ms" ) );
+    QVERIFY( lines[1].startsWith( "\"Frame\",3," ) );
+    QVERIFY( lines[2].startsWith( "\"Layer\",3," ) );
+    QVERIFY( lines[3].startsWith( "\"Projection\",3," ) );
+}
+
+}
+
+QTEST_MAIN( Marble::FrameProfilerTest )
+
+#include "FrameProfilerTest.moc"
@@ -0,0 +1,94 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataTrack.h"
+
+#include <QDateTime>
+#include <QTest>
+#include <QVector>
+
+#include <cstdlib>
+
+namespace Marble
+{
+
+class GeoDataTrackBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkAddPoint();
+    void benchmarkCoordinatesAt_data();
+    void benchmarkCoordinatesAt();
+
+private:
+    static GeoDataTrack createTrack( int size );
+};
+
+GeoDataTrack GeoDataTrackBenchmark::createTrack( int size )
+{
+    // one point per second along the equator
+    const QDateTime start( QDate( 2017, 1, 1 ), QTime( 0, 0 ), Qt::UTC );
+    GeoDataTrack track;
+    track.setInterpolate( true );
+    for ( int i = 0; i < size; ++i ) {
+        track.addPoint( start.addSecs( i ), GeoDataCoordinates( -180.0 + i * 1.0e-4, 0.0, 0.0, GeoDataCoordinates::Degree ) );
+    }
+    return track;
+}
+
+void GeoDataTrackBenchmark::benchmarkAddPoint()
+{
+    GeoDataTrack track;
+    QBENCHMARK_ONCE {
+        track = createTrack( 1000000 );
+    }
+    QCOMPARE( track.size(), 1000000 );
+}
+
+void GeoDataTrackBenchmark::benchmarkCoordinatesAt_data()
+{
+    QTest::addColumn<bool>( "playback" );
+
+    QTest::newRow( "playback" ) << true;
+    QTest::newRow( "random" ) << false;
+}
+
+void GeoDataTrackBenchmark::benchmarkCoordinatesAt()
+{
+    QFETCH( bool, playback );
+
+    const int size = 1000000;
+    const GeoDataTrack track = createTrack( size );
+    const QDateTime start = track.firstWhen();
+
+    // 60 frames per second of track time, or times all over the track
+    const int lookups = 100000;
+    QVector<QDateTime> times;
+    times.reserve( lookups );
+    qsrand( 42 );
+    for ( int i = 0; i < lookups; ++i ) {
+        const qint64 msecs = playback ? qint64( i ) * 1000 / 60 : qint64( qrand() ) * qrand() % ( qint64( size - 1 ) * 1000 );
+        times << start.addMSecs( msecs );
+    }
+
+    qreal sum = 0;
+    QBENCHMARK {
+        for ( const QDateTime &time: times ) {
+            sum += track.coordinatesAt( time ).longitude();
+        }
+    }
+    QVERIFY( sum != 0 );
+}
+
+}
+
+QTEST_MAIN( Marble::GeoDataTrackBenchmark )
+
+#include "GeoDataTrackBenchmark.moc"
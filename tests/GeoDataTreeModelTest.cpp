@@ -8,6 +8,7 @@
 // Copyright 2014      Bernhard Beschow <bbeschow@cs.tu-berlin.de>
 //
 
+#include <QSignalSpy>
 #include <QTest>
 
 #include "GeoDataTreeModel.h"
@@ -26,6 +27,7 @@ private Q_SLOTS:
     void defaultConstructor();
     void setRootDocument();
     void addDocument();
+    void addDocuments();
 };
 
 void GeoDataTreeModelTest::defaultConstructor()
@@ -73,6 +75,33 @@ void GeoDataTreeModelTest::addDocument()
     }
 }
 
+void GeoDataTreeModelTest::addDocuments()
+{
+    GeoDataTreeModel model;
+    model.addDocument( new GeoDataDocument );
+
+    qRegisterMetaType<GeoDataObject *>( "GeoDataObject*" );
+    QSignalSpy insertedSpy( &model, SIGNAL(rowsInserted(QModelIndex,int,int)) );
+    QSignalSpy addedSpy( &model, SIGNAL(added(GeoDataObject*)) );
+
+    QVector<GeoDataDocument *> documents;
+    documents << new GeoDataDocument << new GeoDataDocument << new GeoDataDocument;
+    model.addDocuments( documents );
+
+    QCOMPARE( model.rowCount(), 4 );
+    QCOMPARE( insertedSpy.count(), 1 );
+    QCOMPARE( insertedSpy.first().at( 1 ).toInt(), 1 );
+    QCOMPARE( insertedSpy.first().at( 2 ).toInt(), 3 );
+    QCOMPARE( addedSpy.count(), 3 );
+    for ( int i = 0; i < documents.size(); ++i ) {
+        QCOMPARE( model.index( documents[i] ).row(), i + 1 );
+        QVERIFY( documents[i]->parent() == model.rootDocument() );
+    }
+
+    model.addDocuments( QVector<GeoDataDocument *>() );
+    QCOMPARE( insertedSpy.count(), 1 );
+}
+
 }
 
 QTEST_MAIN( Marble::GeoDataTreeModelTest )
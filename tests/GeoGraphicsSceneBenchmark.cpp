@@ -0,0 +1,67 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoGraphicsScene.h"
+#include "TestGraphicsScene.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+class GeoGraphicsSceneBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkItems();
+    void benchmarkTileHashItems();
+
+private:
+    TestCity *m_city;
+};
+
+void GeoGraphicsSceneBenchmark::initTestCase()
+{
+    m_city = new TestCity;
+}
+
+void GeoGraphicsSceneBenchmark::cleanupTestCase()
+{
+    delete m_city;
+}
+
+void GeoGraphicsSceneBenchmark::benchmarkItems()
+{
+    int count = 0;
+    QBENCHMARK {
+        for ( const GeoDataLatLonBox &view: m_city->views() ) {
+            count += m_city->scene()->items( view, 17 ).size();
+        }
+    }
+    QVERIFY( count > 0 );
+}
+
+void GeoGraphicsSceneBenchmark::benchmarkTileHashItems()
+{
+    int count = 0;
+    QBENCHMARK {
+        for ( const GeoDataLatLonBox &view: m_city->views() ) {
+            count += m_city->tileHashScene().items( view, 17 ).size();
+        }
+    }
+    QVERIFY( count > 0 );
+}
+
+}
+
+QTEST_MAIN( Marble::GeoGraphicsSceneBenchmark )
+
+#include "GeoGraphicsSceneBenchmark.moc"
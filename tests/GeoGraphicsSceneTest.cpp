@@ -0,0 +1,122 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoGraphicsScene.h"
+
+#include "GeoDataLatLonAltBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoGraphicsItem.h"
+#include "TestGraphicsScene.h"
+
+#include <QTest>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+class GeoGraphicsSceneTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testItems();
+    void testRemoveItem();
+    void testChangedBox();
+
+private:
+    static QList<GeoGraphicsItem *> sorted( QList<GeoGraphicsItem *> items );
+
+    TestCity *m_city;
+};
+
+QList<GeoGraphicsItem *> GeoGraphicsSceneTest::sorted( QList<GeoGraphicsItem *> items )
+{
+    std::sort( items.begin(), items.end() );
+    return items;
+}
+
+void GeoGraphicsSceneTest::initTestCase()
+{
+    m_city = new TestCity;
+}
+
+void GeoGraphicsSceneTest::cleanupTestCase()
+{
+    delete m_city;
+}
+
+void GeoGraphicsSceneTest::testItems()
+{
+    const GeoGraphicsScene *scene = m_city->scene();
+    for ( int zoomLevel = 10; zoomLevel <= 18; ++zoomLevel ) {
+        for ( const GeoDataLatLonBox &view: m_city->views() ) {
+            QCOMPARE( sorted( scene->items( view, zoomLevel ) ), sorted( m_city->tileHashScene().items( view, zoomLevel ) ) );
+        }
+    }
+
+    // hidden items are left out
+    const GeoDataLatLonBox &view = m_city->views().first();
+    QList<GeoGraphicsItem *> items = sorted( scene->items( view, 17 ) );
+    QVERIFY( !items.isEmpty() );
+    GeoGraphicsItem *const hidden = items.takeFirst();
+    hidden->setVisible( false );
+    QCOMPARE( sorted( scene->items( view, 17 ) ), items );
+    hidden->setVisible( true );
+}
+
+void GeoGraphicsSceneTest::testRemoveItem()
+{
+    GeoGraphicsScene scene;
+    GeoDataPlacemark first;
+    GeoDataPlacemark second;
+    const GeoDataLatLonAltBox box( GeoDataLatLonBox( 52.51, 52.50, 13.41, 13.40, GeoDataCoordinates::Degree ), 0, 0 );
+    const GeoDataLatLonBox view( 52.52, 52.49, 13.42, 13.39, GeoDataCoordinates::Degree );
+
+    GeoGraphicsItem *const firstItem = new BoxGraphicsItem( &first, box );
+    GeoGraphicsItem *const secondItem = new BoxGraphicsItem( &second, box );
+    GeoGraphicsItem *const thirdItem = new BoxGraphicsItem( &second, box );
+    scene.addItem( firstItem );
+    scene.addItem( secondItem );
+    QCOMPARE( sorted( scene.items( view, 17 ) ), sorted( QList<GeoGraphicsItem *>() << firstItem << secondItem ) );
+
+    // removed before and after the next lookup sorted it in
+    scene.addItem( thirdItem );
+    scene.removeItem( &second );
+    QCOMPARE( scene.items( view, 17 ), QList<GeoGraphicsItem *>() << firstItem );
+
+    scene.removeItem( &first );
+    QCOMPARE( scene.items( view, 17 ), QList<GeoGraphicsItem *>() );
+}
+
+void GeoGraphicsSceneTest::testChangedBox()
+{
+    GeoGraphicsScene scene;
+    GeoDataPlacemark placemark;
+    const GeoDataLatLonBox view( 52.52, 52.50, 13.42, 13.40, GeoDataCoordinates::Degree );
+
+    // just west of the view, but in the tile along its west border
+    BoxGraphicsItem *const item = new BoxGraphicsItem( &placemark, GeoDataLatLonAltBox(
+        GeoDataLatLonBox( 52.5101, 52.5100, 13.39995, 13.3999, GeoDataCoordinates::Degree ), 0, 0 ) );
+    item->setMinZoomLevel( 17 );
+    scene.addItem( item );
+    QCOMPARE( scene.items( view, 17 ), QList<GeoGraphicsItem *>() );
+
+    // like a line string merged with its continuation in the neighbouring tile
+    item->setLatLonAltBox( GeoDataLatLonAltBox(
+        GeoDataLatLonBox( 52.5101, 52.5100, 13.4005, 13.3999, GeoDataCoordinates::Degree ), 0, 0 ) );
+    QCOMPARE( scene.items( view, 17 ), QList<GeoGraphicsItem *>() << item );
+}
+
+}
+
+QTEST_MAIN( Marble::GeoGraphicsSceneTest )
+
+#include "GeoGraphicsSceneTest.moc"
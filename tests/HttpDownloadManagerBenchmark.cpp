@@ -0,0 +1,104 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "HttpDownloadManager.h"
+
+#include "GeoDataLatLonBox.h"
+#include "LatencyHttpServer.h"
+
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTest>
+
+namespace Marble
+{
+
+class HttpDownloadManagerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkTimeToCompleteView_data();
+    void benchmarkTimeToCompleteView();
+
+private:
+    static GeoDataLatLonBox tile( qreal lon, qreal lat, qreal size );
+};
+
+GeoDataLatLonBox HttpDownloadManagerBenchmark::tile( qreal lon, qreal lat, qreal size )
+{
+    return GeoDataLatLonBox( lat + size / 2, lat - size / 2, lon + size / 2, lon - size / 2, GeoDataCoordinates::Degree );
+}
+
+void HttpDownloadManagerBenchmark::benchmarkTimeToCompleteView_data()
+{
+    QTest::addColumn<bool>( "trackView" );
+
+    // without a visible area, jobs are taken out newest first as from the former stack
+    QTest::newRow( "stack" ) << false;
+    QTest::newRow( "visible area" ) << true;
+}
+
+void HttpDownloadManagerBenchmark::benchmarkTimeToCompleteView()
+{
+    QFETCH( bool, trackView );
+
+    const int steps = 10;
+    const int latency = 50;
+    LatencyHttpServer server( latency );
+    HttpDownloadManager manager( 0 );
+    QSignalSpy spy( &manager, SIGNAL(downloadComplete(QByteArray,QString)) );
+
+    // a fling along the equator, each frame requests the 4x4 tiles of its view
+    QStringList viewIds;
+    QElapsedTimer timer;
+    for ( int step = 0; step < steps; ++step ) {
+        const qreal centerLon = step * 10.0;
+        if ( trackView ) {
+            manager.setVisibleArea( tile( centerLon, 0, 8 ) );
+        }
+
+        viewIds.clear();
+        for ( int x = 0; x < 4; ++x ) {
+            for ( int y = 0; y < 4; ++y ) {
+                const QString id = QString( "%1-%2-%3" ).arg( step ).arg( x ).arg( y );
+                const qreal lon = centerLon - 3 + 2 * x;
+                const qreal lat = -3 + 2 * y;
+                manager.addJob( server.url( '/' + id ), id, id, DownloadBrowse, tile( lon, lat, 2 ), 8 );
+                viewIds << id;
+            }
+        }
+
+        timer.start();
+        if ( step < steps - 1 ) {
+            QTest::qWait( 16 );
+        }
+    }
+
+    const auto viewComplete = [&spy, &viewIds]() {
+        for ( const QString &id: viewIds ) {
+            bool completed = false;
+            for ( const QList<QVariant> &arguments: spy ) {
+                completed |= arguments.at( 1 ).toString() == id;
+            }
+            if ( !completed ) {
+                return false;
+            }
+        }
+        return true;
+    };
+    QTRY_VERIFY_WITH_TIMEOUT( viewComplete(), 60000 );
+
+    QTest::setBenchmarkResult( timer.elapsed(), QTest::WalltimeMilliseconds );
+}
+
+}
+
+QTEST_MAIN( Marble::HttpDownloadManagerBenchmark )
+
+#include "HttpDownloadManagerBenchmark.moc"
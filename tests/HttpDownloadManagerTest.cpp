@@ -0,0 +1,131 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "HttpDownloadManager.h"
+
+#include "DownloadPolicy.h"
+#include "GeoDataLatLonBox.h"
+#include "LatencyHttpServer.h"
+
+#include <algorithm>
+
+#include <QSignalSpy>
+#include <QTest>
+
+namespace Marble
+{
+
+class HttpDownloadManagerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testMergeJobs();
+    void testPriority();
+    void testHiddenJobs();
+
+private:
+    static GeoDataLatLonBox tile( qreal lon, qreal lat, qreal size = 1.0 );
+    static QStringList completedIds( const QSignalSpy &spy );
+    static void setConnections( HttpDownloadManager *manager, int connections );
+};
+
+GeoDataLatLonBox HttpDownloadManagerTest::tile( qreal lon, qreal lat, qreal size )
+{
+    return GeoDataLatLonBox( lat + size / 2, lat - size / 2, lon + size / 2, lon - size / 2, GeoDataCoordinates::Degree );
+}
+
+QStringList HttpDownloadManagerTest::completedIds( const QSignalSpy &spy )
+{
+    QStringList result;
+    for ( const QList<QVariant> &arguments: spy ) {
+        result << arguments.at( 1 ).toString();
+    }
+    return result;
+}
+
+void HttpDownloadManagerTest::setConnections( HttpDownloadManager *manager, int connections )
+{
+    DownloadPolicy policy( DownloadPolicyKey( "127.0.0.1", DownloadBrowse ) );
+    policy.setMaximumConnections( connections );
+    manager->addDownloadPolicy( policy );
+}
+
+void HttpDownloadManagerTest::testMergeJobs()
+{
+    LatencyHttpServer server( 20 );
+    HttpDownloadManager manager( 0 );
+    QSignalSpy spy( &manager, SIGNAL(downloadComplete(QByteArray,QString)) );
+
+    // the second request is merged into the active job, the fourth into the queued one
+    setConnections( &manager, 1 );
+    manager.addJob( server.url( "/a" ), "a.png", "a1", DownloadBrowse );
+    manager.addJob( server.url( "/a" ), "a.png", "a2", DownloadBrowse );
+    manager.addJob( server.url( "/b" ), "b.png", "b1", DownloadBrowse );
+    manager.addJob( server.url( "/b" ), "b-copy.png", "b2", DownloadBrowse );
+
+    QTRY_COMPARE_WITH_TIMEOUT( spy.count(), 4, 5000 );
+    QTest::qWait( 100 );
+    QCOMPARE( spy.count(), 4 );
+    QCOMPARE( server.requests(), QStringList() << "/a" << "/b" );
+    QCOMPARE( completedIds( spy ), QStringList() << "a1" << "a2" << "b1" << "b2" );
+    QCOMPARE( spy.at( 3 ).at( 0 ).toByteArray(), QByteArray( "/b" ) );
+}
+
+void HttpDownloadManagerTest::testPriority()
+{
+    LatencyHttpServer server( 20 );
+    HttpDownloadManager manager( 0 );
+    QSignalSpy spy( &manager, SIGNAL(downloadComplete(QByteArray,QString)) );
+
+    setConnections( &manager, 1 );
+    manager.setVisibleArea( tile( 0, 0, 20 ) );
+
+    // takes the only connection, the others are queued
+    manager.addJob( server.url( "/busy" ), "busy", "busy", DownloadBrowse, tile( 0, 0 ), 5 );
+    manager.addJob( server.url( "/hidden" ), "hidden", "hidden", DownloadBrowse, tile( 100, 0 ), 5 );
+    manager.addJob( server.url( "/edge" ), "edge", "edge", DownloadBrowse, tile( 8, 8 ), 5 );
+    manager.addJob( server.url( "/center" ), "center", "center", DownloadBrowse, tile( 1, 1 ), 5 );
+    manager.addJob( server.url( "/coarse" ), "coarse", "coarse", DownloadBrowse, tile( 0, 0, 90 ), 3 );
+    manager.addJob( server.url( "/unknown" ), "unknown", "unknown", DownloadBrowse );
+
+    QTRY_COMPARE_WITH_TIMEOUT( spy.count(), 6, 5000 );
+    QCOMPARE( completedIds( spy ), QStringList() << "busy" << "unknown" << "coarse" << "center" << "edge" << "hidden" );
+}
+
+void HttpDownloadManagerTest::testHiddenJobs()
+{
+    LatencyHttpServer server( 200 );
+    HttpDownloadManager manager( 0 );
+    QSignalSpy spy( &manager, SIGNAL(downloadComplete(QByteArray,QString)) );
+
+    setConnections( &manager, 2 );
+    manager.setVisibleArea( tile( 0, 0, 20 ) );
+    manager.addJob( server.url( "/old1" ), "old1", "old1", DownloadBrowse, tile( 0, 0 ), 5 );
+    manager.addJob( server.url( "/old2" ), "old2", "old2", DownloadBrowse, tile( 1, 1 ), 5 );
+    QTRY_COMPARE_WITH_TIMEOUT( server.requests().size(), 2, 5000 );
+
+    // the old tiles leave the view, the new ones take over their connections
+    manager.setVisibleArea( tile( 90, 0, 20 ) );
+    manager.addJob( server.url( "/new1" ), "new1", "new1", DownloadBrowse, tile( 90, 0 ), 5 );
+    manager.addJob( server.url( "/new2" ), "new2", "new2", DownloadBrowse, tile( 91, 1 ), 5 );
+
+    QTRY_COMPARE_WITH_TIMEOUT( spy.count(), 4, 5000 );
+    QStringList ids = completedIds( spy );
+    std::sort( ids.begin(), ids.begin() + 2 );
+    std::sort( ids.begin() + 2, ids.end() );
+    QCOMPARE( ids, QStringList() << "new1" << "new2" << "old1" << "old2" );
+    QCOMPARE( server.requests().count( "/old1" ), 2 );
+    QCOMPARE( server.requests().count( "/old2" ), 2 );
+}
+
+}
+
+QTEST_MAIN( Marble::HttpDownloadManagerTest )
+
+#include "HttpDownloadManagerTest.moc"
@@ -0,0 +1,59 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "LatLonBoxGrid.h"
+#include "TestHitBoxes.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+class LatLonBoxGridBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkCandidates();
+    void benchmarkLinearScan();
+
+private:
+    TestHitBoxes m_boxes;
+};
+
+void LatLonBoxGridBenchmark::benchmarkCandidates()
+{
+    LatLonBoxGrid grid;
+    grid.build( m_boxes.view(), m_boxes.items() );
+
+    int found = 0;
+    QBENCHMARK {
+        for ( const GeoDataLatLonBox &pick: m_boxes.picks() ) {
+            found += grid.candidates( pick ).size();
+        }
+    }
+    QVERIFY( found > 0 );
+}
+
+void LatLonBoxGridBenchmark::benchmarkLinearScan()
+{
+    // What each hover event did before the grid: look at every painted item
+    int found = 0;
+    QBENCHMARK_ONCE {
+        for ( const GeoDataLatLonBox &pick: m_boxes.picks() ) {
+            found += TestHitBoxes::linearScan( m_boxes.items(), pick ).size();
+        }
+    }
+    QVERIFY( found > 0 );
+}
+
+}
+
+QTEST_MAIN( Marble::LatLonBoxGridBenchmark )
+
+#include "LatLonBoxGridBenchmark.moc"
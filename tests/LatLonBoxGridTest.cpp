@@ -0,0 +1,74 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "LatLonBoxGrid.h"
+#include "GeoDataLatLonBox.h"
+#include "TestHitBoxes.h"
+
+#include <QTest>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+class LatLonBoxGridTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testCandidates();
+    void testOutsideOfBounds();
+};
+
+void LatLonBoxGridTest::testCandidates()
+{
+    const TestHitBoxes boxes;
+    LatLonBoxGrid grid;
+    grid.build( boxes.view(), boxes.items() );
+    QCOMPARE( grid.size(), boxes.items().size() );
+
+    for ( const GeoDataLatLonBox &pick: boxes.picks() ) {
+        const QVector<int> candidates = grid.candidates( pick );
+        const QVector<int> expected = TestHitBoxes::linearScan( boxes.items(), pick );
+
+        // Large items may be returned without checking them, but
+        // every intersecting item has to be there and in order
+        QVERIFY( candidates.size() >= expected.size() );
+        QVERIFY( std::is_sorted( candidates.constBegin(), candidates.constEnd() ) );
+        QVERIFY( std::includes( candidates.constBegin(), candidates.constEnd(),
+                                expected.constBegin(), expected.constEnd() ) );
+        QVERIFY( candidates.size() < 200 );
+    }
+}
+
+void LatLonBoxGridTest::testOutsideOfBounds()
+{
+    QVector<GeoDataLatLonBox> boxes;
+    boxes << GeoDataLatLonBox( 10, 0, 10, 0, GeoDataCoordinates::Degree );
+    boxes << GeoDataLatLonBox( 60, 50, 30, 20, GeoDataCoordinates::Degree );    // outside
+    boxes << GeoDataLatLonBox( 10, -10, -170, 170, GeoDataCoordinates::Degree ); // crosses the date line
+    boxes << GeoDataLatLonBox( 5, 4, 5, 4, GeoDataCoordinates::Degree );
+
+    LatLonBoxGrid grid;
+    grid.build( GeoDataLatLonBox( 10, 0, 10, 0, GeoDataCoordinates::Degree ), boxes );
+
+    QCOMPARE( grid.candidates( GeoDataLatLonBox( 56, 55, 26, 25, GeoDataCoordinates::Degree ) ), QVector<int>() << 1 << 2 );
+    QCOMPARE( grid.candidates( GeoDataLatLonBox( 5, 4.5, 4.5, 3, GeoDataCoordinates::Degree ) ), QVector<int>() << 0 << 2 << 3 );
+    QCOMPARE( grid.candidates( GeoDataLatLonBox( -20, -30, 10, 0, GeoDataCoordinates::Degree ) ), QVector<int>() << 2 );
+
+    grid.clear();
+    QCOMPARE( grid.size(), 0 );
+    QCOMPARE( grid.candidates( GeoDataLatLonBox( 5, 4.5, 4.5, 3, GeoDataCoordinates::Degree ) ), QVector<int>() );
+}
+
+}
+
+QTEST_MAIN( Marble::LatLonBoxGridTest )
+
+#include "LatLonBoxGridTest.moc"
@@ -0,0 +1,130 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_LATENCYHTTPSERVER_H
+#define MARBLE_LATENCYHTTPSERVER_H
+
+#include <QHash>
+#include <QPointer>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+
+namespace Marble
+{
+
+// Answers each GET request with its path after a fixed latency,
+// one request after the other per connection.
+class LatencyHttpServer : public QObject
+{
+public:
+    explicit LatencyHttpServer( int latency );
+
+    QUrl url( const QString &path ) const;
+
+    // the requested paths, in the order the requests arrived
+    QStringList requests() const;
+
+private:
+    struct Connection
+    {
+        Connection() : busy( false ) {}
+        QByteArray buffer;
+        QStringList pending;
+        bool busy;
+    };
+
+    void acceptConnections();
+    void readRequests( QTcpSocket *socket );
+    void respondLater( QTcpSocket *socket );
+
+    QTcpServer m_server;
+    const int m_latency;
+    QStringList m_requests;
+    QHash<QTcpSocket *, Connection> m_connections;
+};
+
+inline LatencyHttpServer::LatencyHttpServer( int latency )
+    : m_latency( latency )
+{
+    connect( &m_server, &QTcpServer::newConnection, this, &LatencyHttpServer::acceptConnections );
+    m_server.listen( QHostAddress::LocalHost );
+}
+
+inline QUrl LatencyHttpServer::url( const QString &path ) const
+{
+    return QUrl( QString( "http://127.0.0.1:%1%2" ).arg( m_server.serverPort() ).arg( path ) );
+}
+
+inline QStringList LatencyHttpServer::requests() const
+{
+    return m_requests;
+}
+
+inline void LatencyHttpServer::acceptConnections()
+{
+    while ( QTcpSocket *socket = m_server.nextPendingConnection() ) {
+        m_connections.insert( socket, Connection() );
+        connect( socket, &QTcpSocket::readyRead, this, [this, socket]() { readRequests( socket ); } );
+        connect( socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove( socket );
+            socket->deleteLater();
+        } );
+    }
+}
+
+inline void LatencyHttpServer::readRequests( QTcpSocket *socket )
+{
+    Connection &connection = m_connections[socket];
+    connection.buffer += socket->readAll();
+
+    int end;
+    while ( ( end = connection.buffer.indexOf( "\r\n\r\n" ) ) >= 0 ) {
+        const QByteArray request = connection.buffer.left( end );
+        connection.buffer.remove( 0, end + 4 );
+
+        // "GET /path HTTP/1.1"
+        const QList<QByteArray> requestLine = request.left( request.indexOf( "\r\n" ) ).split( ' ' );
+        const QString path = QString::fromLatin1( requestLine.value( 1 ) );
+        m_requests << path;
+        connection.pending << path;
+    }
+
+    if ( !connection.busy ) {
+        respondLater( socket );
+    }
+}
+
+inline void LatencyHttpServer::respondLater( QTcpSocket *socket )
+{
+    Connection &connection = m_connections[socket];
+    connection.busy = !connection.pending.isEmpty();
+    if ( !connection.busy ) {
+        return;
+    }
+
+    const QPointer<QTcpSocket> guard( socket );
+    QTimer::singleShot( m_latency, this, [this, guard]() {
+        if ( !guard || !m_connections.contains( guard ) ) {
+            return;
+        }
+
+        const QByteArray body = m_connections[guard].pending.takeFirst().toLatin1();
+        guard->write( "HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/plain\r\n"
+                      "Connection: keep-alive\r\n"
+                      "Content-Length: " + QByteArray::number( body.size() ) + "\r\n\r\n" + body );
+        respondLater( guard );
+    } );
+}
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataDocument.h"
+#include "MarbleDirs.h"
+#include "ParsingRunnerManager.h"
+#include "PluginManager.h"
+#include "RoutingRunnerPlugin.h"
+#include "TestRoutingGrid.h"
+
+#include <QDir>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class LocalOsmRoutingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkRoute();
+
+private:
+    QTemporaryDir m_localPath;
+    PluginManager *m_pluginManager;
+    const RoutingRunnerPlugin *m_plugin;
+};
+
+void LocalOsmRoutingBenchmark::initTestCase()
+{
+    QVERIFY( m_localPath.isValid() );
+    qputenv( "XDG_DATA_HOME", m_localPath.path().toLocal8Bit() );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    const QString osmFile = QDir( m_localPath.path() ).filePath( "grid.osm" );
+    QVERIFY( TestRoutingGrid::writeOsm( osmFile ) );
+
+    m_pluginManager = new PluginManager;
+    ParsingRunnerManager manager( m_pluginManager );
+    QScopedPointer<GeoDataDocument> document( manager.openFile( osmFile ) );
+    QVERIFY( document );
+
+    const QString graphDirectory = MarbleDirs::localPath() + QLatin1String( "/maps/earth/local-osm-routing" );
+    QVERIFY( QDir().mkpath( graphDirectory ) );
+    QVERIFY( TestRoutingGrid::writeGraphs( document.data(), graphDirectory ) );
+
+    m_plugin = 0;
+    for ( const RoutingRunnerPlugin *plugin: m_pluginManager->routingRunnerPlugins() ) {
+        if ( plugin->nameId() == QLatin1String( "local-osm-routing" ) ) {
+            m_plugin = plugin;
+        }
+    }
+    QVERIFY( m_plugin );
+    QVERIFY( m_plugin->canWork() );
+}
+
+void LocalOsmRoutingBenchmark::cleanupTestCase()
+{
+    delete m_pluginManager;
+}
+
+void LocalOsmRoutingBenchmark::benchmarkRoute()
+{
+    // corner to corner across the whole grid
+    const GeoDataCoordinates from = TestRoutingGrid::node( 0, 0 );
+    const GeoDataCoordinates to = TestRoutingGrid::node( TestRoutingGrid::Rows - 1, TestRoutingGrid::Columns - 1 );
+    QBENCHMARK {
+        delete TestRoutingGrid::route( m_plugin, RoutingProfile::Motorcar, from, to );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::LocalOsmRoutingBenchmark )
+
+#include "LocalOsmRoutingBenchmark.moc"
@@ -0,0 +1,271 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataData.h"
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDirs.h"
+#include "MarbleGlobal.h"
+#include "MarbleMath.h"
+#include "ParsingRunnerManager.h"
+#include "PluginManager.h"
+#include "RoutingGraph.h"
+#include "RoutingRunner.h"
+#include "RoutingRunnerPlugin.h"
+#include "TestRoutingGrid.h"
+#include "routing/instructions/RoutingInstruction.h"
+
+#include <QDir>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+#include <qmath.h>
+
+namespace Marble
+{
+
+class LocalOsmRoutingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testGridLengths();
+    void testMotorway_data();
+    void testMotorway();
+    void testOneway_data();
+    void testOneway();
+    void testRoundabout_data();
+    void testRoundabout();
+    void testGraphCache();
+
+private:
+    enum { Rows = TestRoutingGrid::Rows, Columns = TestRoutingGrid::Columns };
+
+    static GeoDataCoordinates gridNode( int row, int column );
+    GeoDataDocument *route( RoutingProfile::TransportType transportType, const GeoDataCoordinates &from, const GeoDataCoordinates &to ) const;
+    qreal routeLength( RoutingProfile::TransportType transportType, const GeoDataCoordinates &from, const GeoDataCoordinates &to ) const;
+
+    QTemporaryDir m_localPath;
+    QString m_graphDirectory;
+    PluginManager *m_pluginManager;
+    const RoutingRunnerPlugin *m_plugin;
+    GeoDataCoordinates m_roundaboutArms[4];
+};
+
+GeoDataCoordinates LocalOsmRoutingTest::gridNode( int row, int column )
+{
+    return TestRoutingGrid::node( row, column );
+}
+
+void LocalOsmRoutingTest::initTestCase()
+{
+    QVERIFY( m_localPath.isValid() );
+    qputenv( "XDG_DATA_HOME", m_localPath.path().toLocal8Bit() );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    const QString osmFile = QDir( m_localPath.path() ).filePath( "grid.osm" );
+    QVERIFY( TestRoutingGrid::writeOsm( osmFile ) );
+
+    m_pluginManager = new PluginManager;
+    ParsingRunnerManager manager( m_pluginManager );
+    QScopedPointer<GeoDataDocument> document( manager.openFile( osmFile ) );
+    QVERIFY( document );
+
+    // like the osm-routing-graph tool does
+    m_graphDirectory = MarbleDirs::localPath() + QLatin1String( "/maps/earth/local-osm-routing" );
+    QVERIFY( QDir().mkpath( m_graphDirectory ) );
+    QVERIFY( TestRoutingGrid::writeGraphs( document.data(), m_graphDirectory ) );
+
+    m_plugin = 0;
+    for ( const RoutingRunnerPlugin *plugin: m_pluginManager->routingRunnerPlugins() ) {
+        if ( plugin->nameId() == QLatin1String( "local-osm-routing" ) ) {
+            m_plugin = plugin;
+        }
+    }
+    QVERIFY( m_plugin );
+    QVERIFY( m_plugin->canWork() );
+
+    const GeoDataCoordinates east = gridNode( Rows / 2, Columns - 1 );
+    for ( int i = 1; i < 4; ++i ) {
+        const qreal angle = ( i + 2 ) * M_PI / 2;
+        m_roundaboutArms[i] = GeoDataCoordinates( east.longitude( GeoDataCoordinates::Degree ) + 0.003 + 0.0025 * qCos( angle ),
+                                                  east.latitude( GeoDataCoordinates::Degree ) + 0.0015 * qSin( angle ),
+                                                  0.0, GeoDataCoordinates::Degree );
+    }
+}
+
+void LocalOsmRoutingTest::cleanupTestCase()
+{
+    delete m_pluginManager;
+}
+
+GeoDataDocument *LocalOsmRoutingTest::route( RoutingProfile::TransportType transportType, const GeoDataCoordinates &from, const GeoDataCoordinates &to ) const
+{
+    return TestRoutingGrid::route( m_plugin, transportType, from, to );
+}
+
+qreal LocalOsmRoutingTest::routeLength( RoutingProfile::TransportType transportType, const GeoDataCoordinates &from, const GeoDataCoordinates &to ) const
+{
+    QScopedPointer<GeoDataDocument> document( route( transportType, from, to ) );
+    if ( !document || document->placemarkList().isEmpty() ) {
+        return -1.0;
+    }
+
+    const GeoDataPlacemark *placemark = document->placemarkList().first();
+    if ( placemark->name() != QLatin1String( "Route" ) ) {
+        return -1.0;
+    }
+    return static_cast<const GeoDataLineString*>( placemark->geometry() )->length( EARTH_RADIUS );
+}
+
+void LocalOsmRoutingTest::testGridLengths()
+{
+    // any route along the grid without detours has the manhattan distance
+    quint32 random = 42;
+    const auto next = [&random]( int limit ) {
+        random = random * 1664525 + 1013904223;
+        return int( ( random >> 8 ) % limit );
+    };
+    for ( int i = 0; i < 100; ++i ) {
+        const int fromRow = next( Rows );
+        const int fromColumn = next( Columns );
+        const int toRow = next( Rows );
+        const int toColumn = next( Columns );
+        const GeoDataCoordinates from = gridNode( fromRow, fromColumn );
+        const GeoDataCoordinates to = gridNode( toRow, toColumn );
+        const GeoDataCoordinates corner = gridNode( fromRow, toColumn );
+        const qreal expected = EARTH_RADIUS * ( distanceSphere( from, corner ) + distanceSphere( corner, to ) );
+        const qreal length = routeLength( RoutingProfile::Pedestrian, from, to );
+        if ( from == to ) {
+            QCOMPARE( length, -1.0 );
+        } else {
+            QVERIFY2( qAbs( length - expected ) < 25.0,
+                      qPrintable( QString( "%1 instead of %2 meters" ).arg( length ).arg( expected ) ) );
+        }
+    }
+}
+
+void LocalOsmRoutingTest::testMotorway_data()
+{
+    QTest::addColumn<int>( "transportType" );
+    QTest::addColumn<bool>( "reverse" );
+    QTest::addColumn<qreal>( "minimum" );
+    QTest::addColumn<qreal>( "maximum" );
+
+    QTest::newRow( "motorcar" ) << int( RoutingProfile::Motorcar ) << false << 3000.0 << 3500.0;
+    QTest::newRow( "motorcar reverse" ) << int( RoutingProfile::Motorcar ) << true << 2000.0 << 2200.0;
+    QTest::newRow( "bicycle" ) << int( RoutingProfile::Bicycle ) << false << 2000.0 << 2200.0;
+    QTest::newRow( "pedestrian" ) << int( RoutingProfile::Pedestrian ) << false << 2000.0 << 2200.0;
+}
+
+void LocalOsmRoutingTest::testMotorway()
+{
+    QFETCH( int, transportType );
+    QFETCH( bool, reverse );
+    QFETCH( qreal, minimum );
+    QFETCH( qreal, maximum );
+
+    // the motorway is faster for cars in its direction only, others may not use it
+    const GeoDataCoordinates west = gridNode( 0, 0 );
+    const GeoDataCoordinates east = gridNode( 0, Columns - 1 );
+    const qreal length = routeLength( RoutingProfile::TransportType( transportType ), reverse ? east : west, reverse ? west : east );
+    QVERIFY2( length >= minimum && length <= maximum, qPrintable( QString::number( length ) ) );
+}
+
+void LocalOsmRoutingTest::testOneway_data()
+{
+    QTest::addColumn<int>( "transportType" );
+    QTest::addColumn<bool>( "detour" );
+
+    QTest::newRow( "motorcar" ) << int( RoutingProfile::Motorcar ) << true;
+    QTest::newRow( "bicycle" ) << int( RoutingProfile::Bicycle ) << true;
+    QTest::newRow( "pedestrian" ) << int( RoutingProfile::Pedestrian ) << false;
+}
+
+void LocalOsmRoutingTest::testOneway()
+{
+    QFETCH( int, transportType );
+    QFETCH( bool, detour );
+
+    const GeoDataCoordinates west = gridNode( 5, 0 );
+    const GeoDataCoordinates east = gridNode( 5, Columns - 1 );
+    const qreal direct = EARTH_RADIUS * distanceSphere( west, east );
+    const qreal forward = routeLength( RoutingProfile::TransportType( transportType ), west, east );
+    const qreal backward = routeLength( RoutingProfile::TransportType( transportType ), east, west );
+    QVERIFY( qAbs( forward - direct ) < 10.0 );
+    QCOMPARE( backward - direct > 200.0, detour );
+}
+
+void LocalOsmRoutingTest::testRoundabout_data()
+{
+    QTest::addColumn<int>( "arm" );
+    QTest::addColumn<int>( "turnType" );
+    QTest::addColumn<QString>( "roadName" );
+
+    QTest::newRow( "south" ) << 1 << int( RoutingInstruction::RoundaboutFirstExit ) << "South Street";
+    QTest::newRow( "east" ) << 2 << int( RoutingInstruction::RoundaboutSecondExit ) << "East Street";
+    QTest::newRow( "north" ) << 3 << int( RoutingInstruction::RoundaboutThirdExit ) << "North Street";
+}
+
+void LocalOsmRoutingTest::testRoundabout()
+{
+    QFETCH( int, arm );
+    QFETCH( int, turnType );
+    QFETCH( QString, roadName );
+
+    QScopedPointer<GeoDataDocument> document( route( RoutingProfile::Motorcar, gridNode( Rows / 2, Columns - 2 ), m_roundaboutArms[arm] ) );
+    QVERIFY( document );
+
+    // the route itself, followed by its instructions
+    const QVector<GeoDataPlacemark*> placemarks = document->placemarkList();
+    QVERIFY( placemarks.size() > 2 );
+    QCOMPARE( placemarks.first()->name(), QString( "Route" ) );
+    QVERIFY( placemarks.first()->extendedData().contains( "length" ) );
+
+    QList<int> turnTypes;
+    QStringList roadNames;
+    QStringList instructions;
+    for ( int i = 1; i < placemarks.size(); ++i ) {
+        turnTypes << placemarks[i]->extendedData().value( "turnType" ).value().toInt();
+        roadNames << placemarks[i]->extendedData().value( "roadName" ).value().toString();
+        instructions << placemarks[i]->name();
+    }
+    const int exit = turnTypes.indexOf( turnType );
+    QVERIFY2( exit >= 0, qPrintable( instructions.join( ' ' ) ) );
+    QCOMPARE( roadNames[exit], roadName );
+}
+
+void LocalOsmRoutingTest::testGraphCache()
+{
+    const QString fileName = m_graphDirectory + QLatin1String( "/grid-motorcar.ch" );
+    const QSharedPointer<const RoutingGraph> graph = RoutingGraph::open( fileName );
+    QVERIFY( graph );
+    QCOMPARE( RoutingGraph::open( fileName ), graph );
+    QCOMPARE( graph->transportType(), RoutingProfile::Motorcar );
+
+    // every grid node is its own nearest node
+    for ( int row = 0; row < Rows; ++row ) {
+        for ( int column = 0; column < Columns; ++column ) {
+            const GeoDataCoordinates node = gridNode( row, column );
+            QVERIFY( EARTH_RADIUS * distanceSphere( graph->coordinates( graph->nearestNode( node ) ), node ) < 0.1 );
+        }
+    }
+
+    QVERIFY( !RoutingGraph::open( m_localPath.path() + QLatin1String( "/grid.osm" ) ) );
+}
+
+}
+
+QTEST_MAIN( Marble::LocalOsmRoutingTest )
+
+#include "LocalOsmRoutingTest.moc"
@@ -0,0 +1,113 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDirs.h"
+#include "PluginManager.h"
+#include "SearchRunner.h"
+#include "SearchRunnerPlugin.h"
+#include "TestOsmSearchDatabase.h"
+
+#include <QDir>
+#include <QScopedPointer>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class LocalOsmSearchBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkSearch_data();
+    void benchmarkSearch();
+
+private:
+    QVector<GeoDataPlacemark*> search( const QString &searchTerm, const GeoDataLatLonBox &preferred ) const;
+
+    QTemporaryDir m_localPath;
+    TestOsmSearchDatabase m_database;
+    PluginManager *m_pluginManager;
+    const SearchRunnerPlugin *m_plugin;
+};
+
+void LocalOsmSearchBenchmark::initTestCase()
+{
+    QVERIFY( m_localPath.isValid() );
+    qputenv( "XDG_DATA_HOME", m_localPath.path().toLocal8Bit() );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    const QString placemarks = MarbleDirs::localPath() + QLatin1String( "/maps/earth/placemarks" );
+    QVERIFY( QDir().mkpath( placemarks ) );
+    QVERIFY( m_database.write( placemarks + QLatin1String( "/germany.sqlite" ), "LocalOsmSearchBenchmark" ) );
+
+    // the plugin looks for databases when it is created
+    m_pluginManager = new PluginManager;
+    m_plugin = 0;
+    for ( const SearchRunnerPlugin *plugin: m_pluginManager->searchRunnerPlugins() ) {
+        if ( plugin->nameId() == QLatin1String( "local-osm-search" ) ) {
+            m_plugin = plugin;
+        }
+    }
+    QVERIFY( m_plugin );
+}
+
+void LocalOsmSearchBenchmark::cleanupTestCase()
+{
+    delete m_pluginManager;
+    QSqlDatabase::removeDatabase( "LocalOsmSearchBenchmark" );
+}
+
+QVector<GeoDataPlacemark*> LocalOsmSearchBenchmark::search( const QString &searchTerm, const GeoDataLatLonBox &preferred ) const
+{
+    QScopedPointer<SearchRunner> runner( m_plugin->newRunner() );
+    QVector<GeoDataPlacemark*> result;
+    connect( runner.data(), &SearchRunner::searchFinished, [&result]( const QVector<GeoDataPlacemark*> &placemarks ) {
+        result = placemarks;
+    } );
+    runner->search( searchTerm, preferred );
+    return result;
+}
+
+void LocalOsmSearchBenchmark::benchmarkSearch_data()
+{
+    QTest::addColumn<QString>( "searchTerm" );
+    QTest::addColumn<bool>( "preferred" );
+
+    QTest::newRow( "exact" ) << "Lindenbergweg" << false;
+    QTest::newRow( "wildcard" ) << "Lindenb*" << false;
+    QTest::newRow( "infix wildcard" ) << "*brückst*" << false;
+    QTest::newRow( "address" ) << "Lindenbergweg 12, Deutschland" << false;
+    QTest::newRow( "category" ) << "restaurant" << false;
+    QTest::newRow( "category nearby" ) << "restaurant" << true;
+}
+
+void LocalOsmSearchBenchmark::benchmarkSearch()
+{
+    QFETCH( QString, searchTerm );
+    QFETCH( bool, preferred );
+
+    const GeoDataLatLonBox berlin( 52.57, 52.47, 13.45, 13.35, GeoDataCoordinates::Degree );
+    const GeoDataLatLonBox box = preferred ? berlin : GeoDataLatLonBox();
+    QBENCHMARK {
+        qDeleteAll( search( searchTerm, box ) );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::LocalOsmSearchBenchmark )
+
+#include "LocalOsmSearchBenchmark.moc"
@@ -0,0 +1,194 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDirs.h"
+#include "MarbleMath.h"
+#include "PluginManager.h"
+#include "SearchRunner.h"
+#include "SearchRunnerPlugin.h"
+#include "TestOsmSearchDatabase.h"
+
+#include <QDir>
+#include <QScopedPointer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class LocalOsmSearchTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testSearch_data();
+    void testSearch();
+    void testNearestCategory();
+    void testDatabaseWithoutIndexes();
+
+private:
+    QVector<GeoDataPlacemark*> search( const QString &searchTerm, const GeoDataLatLonBox &preferred = GeoDataLatLonBox() ) const;
+    QStringList searchNames( const QString &searchTerm, const GeoDataLatLonBox &preferred = GeoDataLatLonBox() ) const;
+
+    QTemporaryDir m_localPath;
+    QString m_databaseFile;
+    TestOsmSearchDatabase m_database;
+    PluginManager *m_pluginManager;
+    const SearchRunnerPlugin *m_plugin;
+    GeoDataLatLonBox m_berlin;
+};
+
+void LocalOsmSearchTest::initTestCase()
+{
+    QVERIFY( m_localPath.isValid() );
+    qputenv( "XDG_DATA_HOME", m_localPath.path().toLocal8Bit() );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    const QString placemarks = MarbleDirs::localPath() + QLatin1String( "/maps/earth/placemarks" );
+    QVERIFY( QDir().mkpath( placemarks ) );
+    m_databaseFile = placemarks + QLatin1String( "/germany.sqlite" );
+    QVERIFY( m_database.write( m_databaseFile, "LocalOsmSearchTest" ) );
+
+    // the plugin looks for databases when it is created
+    m_pluginManager = new PluginManager;
+    m_plugin = 0;
+    for ( const SearchRunnerPlugin *plugin: m_pluginManager->searchRunnerPlugins() ) {
+        if ( plugin->nameId() == QLatin1String( "local-osm-search" ) ) {
+            m_plugin = plugin;
+        }
+    }
+    QVERIFY( m_plugin );
+
+    m_berlin = GeoDataLatLonBox( 52.57, 52.47, 13.45, 13.35, GeoDataCoordinates::Degree );
+}
+
+void LocalOsmSearchTest::cleanupTestCase()
+{
+    delete m_pluginManager;
+    QSqlDatabase::removeDatabase( "LocalOsmSearchTest" );
+}
+
+QVector<GeoDataPlacemark*> LocalOsmSearchTest::search( const QString &searchTerm, const GeoDataLatLonBox &preferred ) const
+{
+    QScopedPointer<SearchRunner> runner( m_plugin->newRunner() );
+    QVector<GeoDataPlacemark*> result;
+    connect( runner.data(), &SearchRunner::searchFinished, [&result]( const QVector<GeoDataPlacemark*> &placemarks ) {
+        result = placemarks;
+    } );
+    runner->search( searchTerm, preferred );
+    return result;
+}
+
+QStringList LocalOsmSearchTest::searchNames( const QString &searchTerm, const GeoDataLatLonBox &preferred ) const
+{
+    const QVector<GeoDataPlacemark*> placemarks = search( searchTerm, preferred );
+    QStringList result;
+    for ( const GeoDataPlacemark *placemark: placemarks ) {
+        result << placemark->name();
+    }
+    qDeleteAll( placemarks );
+    return result;
+}
+
+void LocalOsmSearchTest::testSearch_data()
+{
+    QTest::addColumn<QString>( "searchTerm" );
+    QTest::addColumn<QStringList>( "expected" );
+
+    QTest::newRow( "exact" ) << "Hauptstraße"
+                             << ( QStringList() << "Hauptstraße(Bayern)" << "Hauptstraße(Berlin)" << "Hauptstraße 12(Berlin)" );
+    QTest::newRow( "wildcard" ) << "Haupt*"
+                                << ( QStringList() << "Hauptplatz(Bayern)" << "Hauptstraße(Bayern)" << "Hauptstraße(Berlin)" << "Hauptstraße 12(Berlin)" );
+    QTest::newRow( "infix wildcard" ) << "*uptpla*"
+                                      << ( QStringList() << "Hauptplatz(Bayern)" );
+    QTest::newRow( "address" ) << "Hauptstraße 12, Berlin"
+                               << ( QStringList() << "Hauptstraße 12(Berlin)" );
+    QTest::newRow( "address in other region" ) << "Hauptstraße 12, Bayern"
+                                               << QStringList();
+    QTest::newRow( "street in parent region" ) << "Hauptstraße, Deutschland"
+                                               << ( QStringList() << "Hauptstraße(Bayern)" << "Hauptstraße(Berlin)" );
+    QTest::newRow( "unknown" ) << "Nirgendwo"
+                               << QStringList();
+}
+
+void LocalOsmSearchTest::testSearch()
+{
+    QFETCH( QString, searchTerm );
+    QFETCH( QStringList, expected );
+
+    QStringList names = searchNames( searchTerm );
+    names.sort();
+    expected.sort();
+    QCOMPARE( names, expected );
+}
+
+void LocalOsmSearchTest::testNearestCategory()
+{
+    const GeoDataCoordinates center = m_berlin.center();
+    const QVector<GeoDataPlacemark*> placemarks = search( "restaurant", m_berlin );
+    QCOMPARE( placemarks.size(), 50 );
+
+    // The nearest ones of all restaurants, nearest first. The database sorts by an
+    // approximated distance, so the distances only match closely.
+    QVector<qreal> distances;
+    for ( const GeoDataCoordinates &restaurant: m_database.restaurants() ) {
+        distances << distanceSphere( restaurant, center );
+    }
+    std::sort( distances.begin(), distances.end() );
+
+    for ( int i = 0; i < placemarks.size(); ++i ) {
+        QCOMPARE( placemarks[i]->visualCategory(), GeoDataPlacemark::FoodRestaurant );
+        const qreal distance = distanceSphere( placemarks[i]->coordinate(), center );
+        QVERIFY( qAbs( distance - distances[i] ) < 0.005 * distances[i] );
+    }
+    qDeleteAll( placemarks );
+}
+
+void LocalOsmSearchTest::testDatabaseWithoutIndexes()
+{
+    if ( !m_database.hasIndexes() ) {
+        QSKIP( "The database has no indexes anyway" );
+    }
+
+    const QStringList terms = QStringList() << "Hauptstraße" << "Haupt*" << "*uptpla*" << "Lindenb*" << "*brückst*"
+                                            << "Hauptstraße 12, Berlin" << "Lindenbergweg 12, Deutschland";
+    QList<QStringList> expected;
+    for ( const QString &term: terms ) {
+        expected << searchNames( term );
+    }
+    const QStringList nearby = searchNames( "restaurant", m_berlin );
+
+    // Databases written before the indexes existed. The modification time has to
+    // change for the plugin to reopen the database.
+    QTest::qSleep( 1100 );
+    {
+        QSqlDatabase database = QSqlDatabase::database( "LocalOsmSearchTest" );
+        QSqlQuery query( database );
+        QVERIFY( query.exec( "DROP TABLE namesFts" ) );
+        QVERIFY( query.exec( "DROP TABLE placemarksRtree" ) );
+        database.close();
+    }
+
+    for ( int i = 0; i < terms.size(); ++i ) {
+        QCOMPARE( searchNames( terms[i] ), expected[i] );
+    }
+    QCOMPARE( searchNames( "restaurant", m_berlin ), nearby );
+}
+
+}
+
+QTEST_MAIN( Marble::LocalOsmSearchTest )
+
+#include "LocalOsmSearchTest.moc"
@@ -9,6 +9,7 @@
 //
 
 #include "GeoPainter.h"
+#include "GeoSceneTextureTileDataset.h"
 #include "MarbleMap.h"
 #include "MarbleModel.h"
 #include "TestUtils.h"
@@ -66,6 +67,8 @@ class MarbleMapTest : public QObject
     void paint_data();
     void paint();
 
+    void asynchronousTileLoading();
+
  private:
     MarbleModel m_model;
 };
@@ -594,6 +597,68 @@ void MarbleMapTest::paint()
     QThreadPool::globalInstance()->waitForDone();  // wait for all runners to terminate
 }
 
+void MarbleMapTest::asynchronousTileLoading()
+{
+    const auto render = []( MarbleMap &map ) {
+        QImage image( map.size(), QImage::Format_ARGB32_Premultiplied );
+        image.fill( Qt::transparent );
+        GeoPainter painter( &image, map.viewport() );
+        map.paint( painter, QRect() );
+        return image;
+    };
+
+    MarbleMap map;
+    map.setMapThemeId( "earth/srtm/srtm.dgml" );
+    map.setSize( 300, 300 );
+    map.setAsynchronousTileLoading( true );
+    QVERIFY( map.asynchronousTileLoading() );
+
+    // The texture layers change while tiles are loaded in the background,
+    // which has to wait for the loads reading the former layers.
+    QString customTexture;
+    for ( int i = 0; i < 40; ++i ) {
+        map.setRadius( 150 << ( i % 5 ) );
+        map.centerOn( -180.0 + i * 9.0, ( i % 7 ) * 10.0 - 30.0 );
+        render( map );
+
+        if ( i % 3 == 0 ) {
+            map.setShowTileId( i % 2 == 0 );
+        }
+        if ( i % 5 == 1 && customTexture.isEmpty() ) {
+            GeoSceneTextureTileDataset *texture = new GeoSceneTextureTileDataset( "custom" );
+            texture->setSourceDir( "earth/srtm" );
+            texture->setFileFormat( "JPG" );
+            texture->setMaximumTileLevel( 3 );
+            customTexture = map.addTextureLayer( texture );
+            QVERIFY( !customTexture.isEmpty() );
+        } else if ( i % 5 == 3 && !customTexture.isEmpty() ) {
+            map.removeTextureLayer( customTexture );
+            customTexture.clear();
+        }
+        if ( i % 4 == 0 ) {
+            QCoreApplication::processEvents();
+        }
+    }
+
+    if ( !customTexture.isEmpty() ) {
+        map.removeTextureLayer( customTexture );
+    }
+    map.setShowTileId( false );
+    map.setRadius( 600 );
+    map.centerOn( 10.0, 50.0 );
+
+    // once all tiles arrived the map looks like one loaded synchronously
+    MarbleMap reference;
+    reference.setMapThemeId( "earth/srtm/srtm.dgml" );
+    reference.setSize( map.size() );
+    reference.setRadius( 600 );
+    reference.centerOn( 10.0, 50.0 );
+    const QImage expected = render( reference );
+    QTRY_VERIFY_WITH_TIMEOUT( render( map ) == expected, 10000 );
+
+    QThreadPool::globalInstance()->waitForDone();
+}
+
 }
 
 QTEST_MAIN( Marble::MarbleMapTest )
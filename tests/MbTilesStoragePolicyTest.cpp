@@ -0,0 +1,170 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "FileStoragePolicy.h"
+#include "MbTilesContainer.h"
+#include "MbTilesStoragePolicy.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class MbTilesStoragePolicyTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void testStore();
+    void testLookup();
+    void testFallback();
+    void testClearCache();
+
+private:
+    static QString tileFileName( int zoomLevel, int x, int y );
+    QString containerFileName() const;
+
+    QTemporaryDir *m_directory;
+    QString m_dataDirectory;
+};
+
+QString MbTilesStoragePolicyTest::tileFileName( int zoomLevel, int x, int y )
+{
+    return QStringLiteral( "maps/earth/test/tiles.mbtiles/%1/%2/%3.png" ).arg( zoomLevel ).arg( x ).arg( y );
+}
+
+QString MbTilesStoragePolicyTest::containerFileName() const
+{
+    return m_dataDirectory + QLatin1String( "/maps/earth/test/tiles.mbtiles" );
+}
+
+void MbTilesStoragePolicyTest::init()
+{
+    // each test gets containers of its own, they are shared in the process
+    m_directory = new QTemporaryDir;
+    QVERIFY( m_directory->isValid() );
+
+    // FileStoragePolicy only clears data directories
+    m_dataDirectory = m_directory->path() + QLatin1String( "/data" );
+    QVERIFY( QDir().mkpath( m_dataDirectory ) );
+}
+
+void MbTilesStoragePolicyTest::cleanup()
+{
+    delete m_directory;
+}
+
+void MbTilesStoragePolicyTest::testStore()
+{
+    FileStoragePolicy fallback( m_dataDirectory );
+    const QByteArray data( 1000, 'x' );
+
+    {
+        MbTilesStoragePolicy policy( &fallback, m_dataDirectory );
+        QSignalSpy sizeChanged( &policy, SIGNAL(sizeChanged(qint64)) );
+        QVERIFY( !policy.fileExists( tileFileName( 5, 3, 7 ) ) );
+        QVERIFY( policy.updateFile( tileFileName( 5, 3, 7 ), data ) );
+        QCOMPARE( sizeChanged.count(), 1 );
+
+        // pending tiles are visible before they are written
+        QVERIFY( policy.fileExists( tileFileName( 5, 3, 7 ) ) );
+        QVERIFY( !QFile::exists( containerFileName() ) );
+    }
+
+    // the policy writes its pending tiles when it is destroyed
+    QVERIFY( QFile::exists( containerFileName() ) );
+    MbTilesContainer *container = MbTilesContainer::container( containerFileName() );
+    QCOMPARE( container->pendingTileCount(), 0 );
+    QCOMPARE( container->tileData( 5, 3, 7 ), data );
+
+    // no tile file next to the container
+    QVERIFY( !QFile::exists( m_dataDirectory + QLatin1Char( '/' ) + tileFileName( 5, 3, 7 ) ) );
+}
+
+void MbTilesStoragePolicyTest::testLookup()
+{
+    FileStoragePolicy fallback( m_dataDirectory );
+
+    {
+        MbTilesStoragePolicy policy( &fallback, m_dataDirectory );
+        for ( int x = 0; x < 4; ++x ) {
+            QVERIFY( policy.updateFile( tileFileName( 2, x, 1 ), QByteArray( 10 + x, 'x' ) ) );
+        }
+        // a replaced tile is stored once
+        QVERIFY( policy.updateFile( tileFileName( 2, 3, 1 ), QByteArray( 20, 'y' ) ) );
+    }
+
+    MbTilesStoragePolicy policy( &fallback, m_dataDirectory );
+    for ( int x = 0; x < 3; ++x ) {
+        QVERIFY( policy.fileExists( tileFileName( 2, x, 1 ) ) );
+        QCOMPARE( MbTilesContainer::findTileData( containerFileName() + QStringLiteral( "/2/%1/1.png" ).arg( x ) ),
+                  QByteArray( 10 + x, 'x' ) );
+    }
+    QCOMPARE( MbTilesContainer::container( containerFileName() )->tileData( 2, 3, 1 ), QByteArray( 20, 'y' ) );
+    QVERIFY( !policy.fileExists( tileFileName( 2, 1, 2 ) ) );
+    QVERIFY( !policy.fileExists( tileFileName( 3, 1, 1 ) ) );
+    QCOMPARE( MbTilesContainer::container( containerFileName() )->maximumZoomLevel(), 2 );
+}
+
+void MbTilesStoragePolicyTest::testFallback()
+{
+    FileStoragePolicy fallback( m_dataDirectory );
+    MbTilesStoragePolicy policy( &fallback, m_dataDirectory );
+
+    const QString fileName = QStringLiteral( "maps/earth/test/5/3/7.png" );
+    QVERIFY( policy.updateFile( fileName, QByteArray( 10, 'x' ) ) );
+    QVERIFY( policy.fileExists( fileName ) );
+    QVERIFY( QFile::exists( m_dataDirectory + QLatin1Char( '/' ) + fileName ) );
+    QVERIFY( !QFile::exists( containerFileName() ) );
+}
+
+void MbTilesStoragePolicyTest::testClearCache()
+{
+    FileStoragePolicy fallback( m_dataDirectory );
+
+    {
+        MbTilesStoragePolicy policy( &fallback, m_dataDirectory );
+        QVERIFY( policy.updateFile( tileFileName( 3, 1, 1 ), QByteArray( 10, 'x' ) ) );
+        QVERIFY( policy.updateFile( tileFileName( 10, 1, 1 ), QByteArray( 10, 'x' ) ) );
+    }
+
+    MbTilesStoragePolicy policy( &fallback, m_dataDirectory );
+    QSignalSpy cleared( &policy, SIGNAL(cleared()) );
+
+    // a tile still pending is removed as well
+    QVERIFY( policy.updateFile( tileFileName( 11, 1, 1 ), QByteArray( 10, 'x' ) ) );
+    QVERIFY( policy.fileExists( tileFileName( 11, 1, 1 ) ) );
+
+    policy.clearCache();
+    QCOMPARE( cleared.count(), 1 );
+    QVERIFY( policy.lastErrorMessage().isEmpty() );
+
+    // base tile levels are kept like in the file cache
+    QVERIFY( policy.fileExists( tileFileName( 3, 1, 1 ) ) );
+    QVERIFY( !policy.fileExists( tileFileName( 10, 1, 1 ) ) );
+    QVERIFY( !policy.fileExists( tileFileName( 11, 1, 1 ) ) );
+    QCOMPARE( MbTilesContainer::container( containerFileName() )->maximumZoomLevel(), 3 );
+    QVERIFY( QFile::exists( containerFileName() ) );
+
+    // the container takes new tiles after clearing
+    QVERIFY( policy.updateFile( tileFileName( 10, 1, 1 ), QByteArray( 5, 'y' ) ) );
+    QVERIFY( MbTilesContainer::container( containerFileName() )->commit() );
+    QCOMPARE( MbTilesContainer::container( containerFileName() )->tileData( 10, 1, 1 ), QByteArray( 5, 'y' ) );
+}
+
+}
+
+QTEST_MAIN( Marble::MbTilesStoragePolicyTest )
+
+#include "MbTilesStoragePolicyTest.moc"
@@ -0,0 +1,61 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_MEMORYUSAGE_H
+#define MARBLE_MEMORYUSAGE_H
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QString>
+
+namespace Marble
+{
+
+/**
+ * Memory probes for the benchmarks. They read /proc/self, so they only
+ * work on Linux and return -1 elsewhere.
+ */
+namespace MemoryUsage
+{
+
+// a line like "VmRSS:   1234 kB" of /proc/self/status, in bytes
+inline qint64 statusValue( const QString &name )
+{
+    QFile status( "/proc/self/status" );
+    if ( !status.open( QFile::ReadOnly ) ) {
+        return -1;
+    }
+    const QRegularExpression line( QString( "^%1:\\s*(\\d+) kB" ).arg( name ), QRegularExpression::MultilineOption );
+    const QRegularExpressionMatch match = line.match( QString::fromLatin1( status.readAll() ) );
+    return match.hasMatch() ? match.captured( 1 ).toLongLong() * 1024 : -1;
+}
+
+inline qint64 resident()
+{
+    return statusValue( "VmRSS" );
+}
+
+inline qint64 peakResident()
+{
+    return statusValue( "VmHWM" );
+}
+
+// lets peakResident() start over from the current resident set size
+inline void resetPeakResident()
+{
+    QFile clearRefs( "/proc/self/clear_refs" );
+    if ( clearRefs.open( QFile::WriteOnly ) ) {
+        clearRefs.write( "5" );
+    }
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MemoryUsage.h"
+#include "osm/OsmPlacemarkData.h"
+#include "StyleBuilder.h"
+
+#include <QElapsedTimer>
+#include <QTest>
+#include <QVector>
+
+namespace Marble
+{
+
+class OsmPlacemarkDataBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkVisualCategory();
+
+private:
+    static QVector<OsmPlacemarkData> createExtract( int count );
+};
+
+QVector<OsmPlacemarkData> OsmPlacemarkDataBenchmark::createExtract( int count )
+{
+    // roughly the mix of tagged objects in a city extract
+    QVector<OsmPlacemarkData> result;
+    result.reserve( count );
+    for ( int i = 0; i < count; ++i ) {
+        OsmPlacemarkData osmData;
+        osmData.setId( i + 1 );
+        switch ( i % 10 ) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            osmData.addTag( "building", "yes" );
+            osmData.addTag( "addr:housenumber", QString::number( i % 200 ) );
+            osmData.addTag( "addr:street", QString( "Street %1" ).arg( i % 500 ) );
+            break;
+        case 4:
+        case 5:
+            osmData.addTag( "highway", i % 3 ? "residential" : "service" );
+            osmData.addTag( "name", QString( "Street %1" ).arg( i % 500 ) );
+            osmData.addTag( "surface", "asphalt" );
+            break;
+        case 6:
+            osmData.addTag( "amenity", i % 2 ? "restaurant" : "parking" );
+            osmData.addTag( "name", QString( "Place %1" ).arg( i ) );
+            osmData.addTag( "opening_hours", "Mo-Fr 08:00-18:00" );
+            break;
+        case 7:
+            osmData.addTag( "landuse", "grass" );
+            break;
+        case 8:
+            osmData.addTag( "natural", "tree" );
+            osmData.addTag( "leaf_type", "broadleaved" );
+            break;
+        default:
+            osmData.addTag( "barrier", "fence" );
+            osmData.addTag( "source", "survey" );
+            break;
+        }
+        result << osmData;
+    }
+    return result;
+}
+
+void OsmPlacemarkDataBenchmark::benchmarkVisualCategory()
+{
+    const int count = 200000;
+    const qint64 memoryBefore = MemoryUsage::resident();
+    const QVector<OsmPlacemarkData> extract = createExtract( count );
+    const qint64 memoryAfter = MemoryUsage::resident();
+
+    int buildings = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for ( const OsmPlacemarkData &osmData: extract ) {
+        if ( StyleBuilder::determineVisualCategory( osmData ) == GeoDataPlacemark::Building ) {
+            ++buildings;
+        }
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    QCOMPARE( buildings, 4 * count / 10 );
+
+    qDebug() << ( memoryAfter - memoryBefore ) / count << "bytes per object,"
+             << elapsed / count << "ns per visual category";
+    QTest::setBenchmarkResult( elapsed / 1.0e6, QTest::WalltimeMilliseconds );
+}
+
+}
+
+QTEST_MAIN( Marble::OsmPlacemarkDataBenchmark )
+
+#include "OsmPlacemarkDataBenchmark.moc"
@@ -0,0 +1,136 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "osm/OsmPlacemarkData.h"
+#include "osm/OsmStringTable.h"
+#include "StyleBuilder.h"
+
+#include <QSet>
+#include <QTest>
+
+namespace Marble
+{
+
+class OsmPlacemarkDataTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testStringTable();
+    void testTags();
+    void testVisualCategory_data();
+    void testVisualCategory();
+};
+
+void OsmPlacemarkDataTest::testStringTable()
+{
+    QCOMPARE( OsmStringTable::intern( QString() ), 0 );
+    QCOMPARE( OsmStringTable::string( 0 ), QString() );
+
+    const int size = OsmStringTable::size();
+    QCOMPARE( OsmStringTable::find( "OsmPlacemarkDataTest" ), -1 );
+    const int id = OsmStringTable::intern( "OsmPlacemarkDataTest" );
+    QCOMPARE( OsmStringTable::size(), size + 1 );
+    QCOMPARE( OsmStringTable::intern( "OsmPlacemarkDataTest" ), id );
+    QCOMPARE( OsmStringTable::find( "OsmPlacemarkDataTest" ), id );
+
+    // references stay valid while the table grows
+    const QString &string = OsmStringTable::string( id );
+    for ( int i = 0; i < 10000; ++i ) {
+        OsmStringTable::intern( QString( "OsmPlacemarkDataTest %1" ).arg( i ) );
+    }
+    QCOMPARE( string, QString( "OsmPlacemarkDataTest" ) );
+    QCOMPARE( OsmStringTable::string( OsmStringTable::find( "OsmPlacemarkDataTest 9999" ) ), QString( "OsmPlacemarkDataTest 9999" ) );
+}
+
+void OsmPlacemarkDataTest::testTags()
+{
+    OsmPlacemarkData osmData;
+    QVERIFY( osmData.isEmpty() );
+    QVERIFY( osmData.tagsBegin() == osmData.tagsEnd() );
+
+    osmData.addTag( "name", "Foo" );
+    osmData.addTag( "amenity", "cafe" );
+    osmData.addTag( "cuisine", "coffee_shop" );
+    osmData.addTag( "name", "Bar" );
+    QCOMPARE( osmData.tagCount(), 3 );
+    QCOMPARE( osmData.tagValue( "name" ), QString( "Bar" ) );
+    QCOMPARE( osmData.tagValue( "never interned key" ), QString() );
+    QVERIFY( osmData.containsTag( "amenity", "cafe" ) );
+    QVERIFY( !osmData.containsTag( "amenity", "restaurant" ) );
+    QVERIFY( !osmData.containsTag( "amenity", "never interned value" ) );
+    QVERIFY( osmData.containsTagKey( "cuisine" ) );
+    QVERIFY( osmData.containsTag( OsmStringTable::find( "amenity" ), OsmStringTable::find( "cafe" ) ) );
+
+    auto const iter = osmData.findTag( "amenity" );
+    QVERIFY( iter != osmData.tagsEnd() );
+    QCOMPARE( iter.key(), QString( "amenity" ) );
+    QCOMPARE( iter.value(), QString( "cafe" ) );
+    QVERIFY( osmData.findTag( "website" ) == osmData.tagsEnd() );
+
+    // sorted by key id
+    QSet<QString> keys;
+    int lastKey = -1;
+    for ( auto tag = osmData.tagsBegin(), end = osmData.tagsEnd(); tag != end; ++tag ) {
+        QVERIFY( tag.keyId() > lastKey );
+        lastKey = tag.keyId();
+        keys << tag.key();
+    }
+    QCOMPARE( keys, QSet<QString>() << "name" << "amenity" << "cuisine" );
+
+    osmData.removeTag( "cuisine" );
+    osmData.removeTag( "website" );
+    QCOMPARE( osmData.tagCount(), 2 );
+    QVERIFY( !osmData.containsTagKey( "cuisine" ) );
+
+    // copies share the tags until one of them changes
+    OsmPlacemarkData copy = osmData;
+    copy.addTag( "name", "Baz" );
+    QCOMPARE( osmData.tagValue( "name" ), QString( "Bar" ) );
+    QCOMPARE( copy.tagValue( "name" ), QString( "Baz" ) );
+
+    osmData.setVersion( "3" );
+    QCOMPARE( osmData.version(), QString( "3" ) );
+    QCOMPARE( osmData.tagValue( "mx:version" ), QString( "3" ) );
+    QCOMPARE( osmData.oid(), qint64( 0 ) );
+    osmData.addTag( "mx:oid", "42" );
+    QCOMPARE( osmData.oid(), qint64( 42 ) );
+}
+
+void OsmPlacemarkDataTest::testVisualCategory_data()
+{
+    QTest::addColumn<QStringList>( "tags" );
+    QTest::addColumn<int>( "category" );
+
+    QTest::newRow( "none" ) << ( QStringList() << "source" << "survey" ) << int( GeoDataPlacemark::None );
+    QTest::newRow( "building" ) << ( QStringList() << "building" << "yes" << "name" << "Foo" ) << int( GeoDataPlacemark::Building );
+    QTest::newRow( "restaurant" ) << ( QStringList() << "amenity" << "restaurant" ) << int( GeoDataPlacemark::FoodRestaurant );
+    QTest::newRow( "ignored" ) << ( QStringList() << "amenity" << "restaurant" << "disused:highway" << "yes" ) << int( GeoDataPlacemark::None );
+    QTest::newRow( "ignored tag" ) << ( QStringList() << "leisure" << "park" << "boundary" << "protected_area" ) << int( GeoDataPlacemark::None );
+    QTest::newRow( "ice shelf" ) << ( QStringList() << "natural" << "glacier" << "glacier:type" << "shelf" ) << int( GeoDataPlacemark::NaturalIceShelf );
+    QTest::newRow( "zebra" ) << ( QStringList() << "highway" << "crossing" << "crossing" << "traffic_signals;zebra" ) << int( GeoDataPlacemark::CrossingZebra );
+    QTest::newRow( "capital" ) << ( QStringList() << "place" << "city" << "admin_level" << "2" ) << int( GeoDataPlacemark::PlaceCityNationalCapital );
+}
+
+void OsmPlacemarkDataTest::testVisualCategory()
+{
+    QFETCH( QStringList, tags );
+    QFETCH( int, category );
+
+    OsmPlacemarkData osmData;
+    for ( int i = 0; i + 1 < tags.size(); i += 2 ) {
+        osmData.addTag( tags[i], tags[i + 1] );
+    }
+    QCOMPARE( int( StyleBuilder::determineVisualCategory( osmData ) ), category );
+}
+
+}
+
+QTEST_MAIN( Marble::OsmPlacemarkDataTest )
+
+#include "OsmPlacemarkDataTest.moc"
@@ -0,0 +1,92 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataDocument.h"
+#include "GeoDataDocumentWriter.h"
+#include "MarbleDirs.h"
+#include "MemoryUsage.h"
+#include "ParsingRunnerManager.h"
+#include "PluginManager.h"
+#include "TestOsmGrid.h"
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class OsmRunnerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkParse_data();
+    void benchmarkParse();
+
+private:
+    GeoDataDocument *openFile( const QString &fileName );
+
+    PluginManager m_pluginManager;
+    QTemporaryDir m_dir;
+};
+
+void OsmRunnerBenchmark::initTestCase()
+{
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    QVERIFY( m_dir.isValid() );
+    QVERIFY( OsmGrid::writeOsm( m_dir.filePath( "grid.osm" ) ) );
+    QVERIFY( OsmGrid::writePbf( m_dir.filePath( "grid.osm.pbf" ) ) );
+
+    GeoDataDocument *document = openFile( m_dir.filePath( "grid.osm" ) );
+    QVERIFY( document );
+    QVERIFY( GeoDataDocumentWriter::write( m_dir.filePath( "grid.o5m" ), *document ) );
+    delete document;
+}
+
+GeoDataDocument *OsmRunnerBenchmark::openFile( const QString &fileName )
+{
+    ParsingRunnerManager manager( &m_pluginManager );
+    return manager.openFile( fileName );
+}
+
+void OsmRunnerBenchmark::benchmarkParse_data()
+{
+    QTest::addColumn<QString>( "fileName" );
+
+    QTest::newRow( "osm" ) << "grid.osm";
+    QTest::newRow( "o5m" ) << "grid.o5m";
+    QTest::newRow( "osm.pbf" ) << "grid.osm.pbf";
+}
+
+void OsmRunnerBenchmark::benchmarkParse()
+{
+    QFETCH( QString, fileName );
+
+    MemoryUsage::resetPeakResident();
+
+    QElapsedTimer timer;
+    timer.start();
+    GeoDataDocument *document = openFile( m_dir.filePath( fileName ) );
+    const qint64 elapsed = qMax<qint64>( 1, timer.elapsed() );
+    QVERIFY( document );
+    delete document;
+
+    qDebug() << fileName << ( OsmGrid::gridSize * OsmGrid::gridSize * 1000 ) / elapsed << "nodes/s,"
+             << MemoryUsage::peakResident() / 1024 << "KiB peak resident memory";
+    QTest::setBenchmarkResult( elapsed, QTest::WalltimeMilliseconds );
+}
+
+}
+
+QTEST_MAIN( Marble::OsmRunnerBenchmark )
+
+#include "OsmRunnerBenchmark.moc"
@@ -0,0 +1,88 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataDocument.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDirs.h"
+#include "ParsingRunnerManager.h"
+#include "PluginManager.h"
+#include "TestOsmGrid.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+class OsmRunnerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPbf();
+
+private:
+    GeoDataDocument *openFile( const QString &fileName );
+    static QStringList placemarkKeys( const GeoDataDocument *document );
+
+    PluginManager m_pluginManager;
+    QTemporaryDir m_dir;
+};
+
+void OsmRunnerTest::initTestCase()
+{
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    QVERIFY( m_dir.isValid() );
+    QVERIFY( OsmGrid::writeOsm( m_dir.filePath( "grid.osm" ) ) );
+    QVERIFY( OsmGrid::writePbf( m_dir.filePath( "grid.osm.pbf" ) ) );
+}
+
+GeoDataDocument *OsmRunnerTest::openFile( const QString &fileName )
+{
+    ParsingRunnerManager manager( &m_pluginManager );
+    return manager.openFile( fileName );
+}
+
+QStringList OsmRunnerTest::placemarkKeys( const GeoDataDocument *document )
+{
+    QStringList result;
+    for ( const GeoDataPlacemark *placemark: document->placemarkList() ) {
+        const GeoDataCoordinates coordinates = placemark->coordinate();
+        result << QString( "%1|%2|%3" ).arg( placemark->name() )
+                                      .arg( qRound64( coordinates.longitude( GeoDataCoordinates::Degree ) * 1.0e6 ) )
+                                      .arg( qRound64( coordinates.latitude( GeoDataCoordinates::Degree ) * 1.0e6 ) );
+    }
+    std::sort( result.begin(), result.end() );
+    return result;
+}
+
+void OsmRunnerTest::testPbf()
+{
+    GeoDataDocument *osm = openFile( m_dir.filePath( "grid.osm" ) );
+    GeoDataDocument *pbf = openFile( m_dir.filePath( "grid.osm.pbf" ) );
+    QVERIFY( osm );
+    QVERIFY( pbf );
+
+    const QStringList expected = placemarkKeys( osm );
+    QCOMPARE( expected.size(), OsmGrid::gridSize * OsmGrid::gridSize / 50 + OsmGrid::gridSize + 1 );
+    QCOMPARE( placemarkKeys( pbf ), expected );
+
+    delete osm;
+    delete pbf;
+}
+
+}
+
+QTEST_MAIN( Marble::OsmRunnerTest )
+
+#include "OsmRunnerTest.moc"
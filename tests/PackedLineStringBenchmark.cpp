@@ -0,0 +1,135 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataCoordinates_p.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataPackedCoordinates.h"
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+
+#include <QPolygonF>
+#include <QTest>
+#include <qmath.h>
+
+Q_DECLARE_METATYPE( Marble::Projection )
+
+namespace Marble
+{
+
+class PackedLineStringBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkMemory_data();
+    void benchmarkMemory();
+    void benchmarkProjection_data();
+    void benchmarkProjection();
+
+private:
+    static GeoDataLinearRing ring( qreal lon, qreal lat, qreal radius, int nodes );
+
+    // about a million nodes in 2000 coastline and border like rings
+    // spread over the extent of Germany
+    QVector<GeoDataLinearRing> m_country;
+};
+
+GeoDataLinearRing PackedLineStringBenchmark::ring( qreal lon, qreal lat, qreal radius, int nodes )
+{
+    GeoDataLinearRing result;
+    result.reserve( nodes );
+    for ( int i = 0; i < nodes; ++i ) {
+        const qreal angle = 2 * M_PI * i / nodes;
+        const qreal jitter = 1.0 + 0.1 * qSin( 17 * angle );
+        result << GeoDataCoordinates( lon + radius * jitter * qCos( angle ),
+                                      lat + radius * jitter * qSin( angle ),
+                                      0, GeoDataCoordinates::Degree );
+    }
+    return result;
+}
+
+void PackedLineStringBenchmark::initTestCase()
+{
+    m_country.reserve( 2000 );
+    for ( int i = 0; i < 2000; ++i ) {
+        const qreal lon = 5.9 + 9.1 * ( ( i * 7919 ) % 2000 ) / 2000.0;
+        const qreal lat = 47.3 + 7.8 * ( ( i * 104729 ) % 2000 ) / 2000.0;
+        m_country << ring( lon, lat, 0.02 + 0.001 * ( i % 50 ), 500 );
+    }
+}
+
+void PackedLineStringBenchmark::benchmarkMemory_data()
+{
+    QTest::addColumn<bool>( "packed" );
+
+    QTest::newRow( "unpacked" ) << false;
+    QTest::newRow( "packed" ) << true;
+}
+
+void PackedLineStringBenchmark::benchmarkMemory()
+{
+    QFETCH( bool, packed );
+
+    qint64 bytes = 0;
+    for ( GeoDataLinearRing ring: m_country ) {
+        if ( packed ) {
+            ring.setPacked( true );
+            bytes += ring.packedCoordinates().memoryUsage();
+        } else {
+            // without the malloc overhead of each node and the quaternions
+            // that the projections cache in them
+            bytes += ring.size() * qint64( sizeof( GeoDataCoordinates ) + sizeof( GeoDataCoordinatesPrivate ) );
+        }
+    }
+
+    QTest::setBenchmarkResult( bytes, QTest::BytesAllocated );
+}
+
+void PackedLineStringBenchmark::benchmarkProjection_data()
+{
+    QTest::addColumn<Marble::Projection>( "projection" );
+    QTest::addColumn<bool>( "packed" );
+
+    QTest::newRow( "Spherical unpacked" ) << Spherical << false;
+    QTest::newRow( "Spherical packed" ) << Spherical << true;
+    QTest::newRow( "Equirectangular unpacked" ) << Equirectangular << false;
+    QTest::newRow( "Equirectangular packed" ) << Equirectangular << true;
+    QTest::newRow( "Mercator unpacked" ) << Mercator << false;
+    QTest::newRow( "Mercator packed" ) << Mercator << true;
+}
+
+void PackedLineStringBenchmark::benchmarkProjection()
+{
+    QFETCH( Marble::Projection, projection );
+    QFETCH( bool, packed );
+
+    QVector<GeoDataLinearRing> country = m_country;
+    for ( GeoDataLinearRing &ring: country ) {
+        ring.setPacked( packed );
+    }
+
+    // the whole country on a full HD screen
+    const ViewportParams viewport( projection, 10.5 * DEG2RAD, 51.2 * DEG2RAD, 6000, QSize( 1920, 1080 ) );
+
+    QVector<QPolygonF *> polygons;
+    QBENCHMARK {
+        for ( const GeoDataLinearRing &ring: country ) {
+            viewport.screenCoordinates( ring, polygons );
+            qDeleteAll( polygons );
+            polygons.clear();
+        }
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::PackedLineStringBenchmark )
+
+#include "PackedLineStringBenchmark.moc"
@@ -0,0 +1,241 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataLatLonAltBox.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPackedCoordinates.h"
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+#include "projections/AbstractProjection.h"
+
+#include <QPolygonF>
+#include <QTest>
+#include <qmath.h>
+
+Q_DECLARE_METATYPE( Marble::Projection )
+
+namespace Marble
+{
+
+class PackedLineStringTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testAccessors();
+    void testAltitudes();
+    void testCopy();
+    void testScreenCoordinates_data();
+    void testScreenCoordinates();
+    void testPolygons_data();
+    void testPolygons();
+
+private:
+    static GeoDataLinearRing ring( qreal lon, qreal lat, qreal radius, int nodes );
+    static void comparePolygons( const QVector<QPolygonF *> &polygons, const QVector<QPolygonF *> &expected );
+    static void addProjectionRows();
+};
+
+GeoDataLinearRing PackedLineStringTest::ring( qreal lon, qreal lat, qreal radius, int nodes )
+{
+    GeoDataLinearRing result;
+    result.reserve( nodes );
+    for ( int i = 0; i < nodes; ++i ) {
+        const qreal angle = 2 * M_PI * i / nodes;
+        const qreal jitter = 1.0 + 0.1 * qSin( 17 * angle );
+        result << GeoDataCoordinates( lon + radius * jitter * qCos( angle ),
+                                      lat + radius * jitter * qSin( angle ),
+                                      0, GeoDataCoordinates::Degree );
+    }
+    return result;
+}
+
+void PackedLineStringTest::comparePolygons( const QVector<QPolygonF *> &polygons, const QVector<QPolygonF *> &expected )
+{
+    QCOMPARE( polygons.size(), expected.size() );
+    for ( int i = 0; i < polygons.size(); ++i ) {
+        QCOMPARE( polygons[i]->size(), expected[i]->size() );
+        for ( int j = 0; j < polygons[i]->size(); ++j ) {
+            QVERIFY( qAbs( polygons[i]->at( j ).x() - expected[i]->at( j ).x() ) < 1e-6 );
+            QVERIFY( qAbs( polygons[i]->at( j ).y() - expected[i]->at( j ).y() ) < 1e-6 );
+        }
+    }
+}
+
+void PackedLineStringTest::addProjectionRows()
+{
+    QTest::addColumn<Marble::Projection>( "projection" );
+
+    QTest::newRow( "Spherical" ) << Spherical;
+    QTest::newRow( "Equirectangular" ) << Equirectangular;
+    QTest::newRow( "Mercator" ) << Mercator;
+    QTest::newRow( "Gnomonic" ) << Gnomonic;
+}
+
+void PackedLineStringTest::testAccessors()
+{
+    const GeoDataLinearRing unpacked = ring( 10, 50, 1, 100 ).optimized();
+    GeoDataLinearRing packed = unpacked;
+    packed.setPacked( true );
+    QVERIFY( packed.isPacked() );
+    QVERIFY( !unpacked.isPacked() );
+
+    QCOMPARE( packed.size(), unpacked.size() );
+    QVERIFY( !packed.isEmpty() );
+    QCOMPARE( packed.latLonAltBox(), unpacked.latLonAltBox() );
+    QCOMPARE( packed.length( EARTH_RADIUS ), unpacked.length( EARTH_RADIUS ) );
+    QCOMPARE( packed.length( EARTH_RADIUS, 40 ), unpacked.length( EARTH_RADIUS, 40 ) );
+
+    const GeoDataPackedCoordinates coordinates = packed.packedCoordinates();
+    QCOMPARE( coordinates.size(), unpacked.size() );
+    QVERIFY( !coordinates.altitudes() );
+    for ( int i = 0; i < unpacked.size(); ++i ) {
+        QCOMPARE( coordinates.longitudes()[i], unpacked.at( i ).longitude() );
+        QCOMPARE( coordinates.latitudes()[i], unpacked.at( i ).latitude() );
+        QCOMPARE( coordinates.details()[i], unpacked.at( i ).detail() );
+        QCOMPARE( coordinates.at( i ), unpacked.at( i ) );
+    }
+    QVERIFY( packed.isPacked() );
+
+    // nodes handed out by reference need GeoDataCoordinates objects
+    QCOMPARE( packed.at( 42 ), unpacked.at( 42 ) );
+    QVERIFY( !packed.isPacked() );
+    QVERIFY( packed == unpacked );
+
+    packed.setPacked( true );
+    packed.append( GeoDataCoordinates( 12, 52, 0, GeoDataCoordinates::Degree ) );
+    QVERIFY( !packed.isPacked() );
+    QCOMPARE( packed.size(), unpacked.size() + 1 );
+    QVERIFY( packed.latLonAltBox().contains( GeoDataCoordinates( 12, 52, 0, GeoDataCoordinates::Degree ) ) );
+
+    packed.setPacked( true );
+    packed.clear();
+    QVERIFY( !packed.isPacked() );
+    QVERIFY( packed.isEmpty() );
+}
+
+void PackedLineStringTest::testAltitudes()
+{
+    GeoDataPackedCoordinates coordinates;
+    coordinates.append( GeoDataCoordinates( 0.1, 0.2 ) );
+    coordinates.append( GeoDataCoordinates( 0.2, 0.3 ) );
+    QVERIFY( !coordinates.altitudes() );
+
+    coordinates.append( GeoDataCoordinates( 0.3, 0.4, 1000 ) );
+    QVERIFY( coordinates.altitudes() );
+    QCOMPARE( coordinates.altitudes()[0], 0.0 );
+    QCOMPARE( coordinates.altitudes()[1], 0.0 );
+    QCOMPARE( coordinates.altitudes()[2], 1000.0 );
+    QCOMPARE( coordinates.at( 2 ), GeoDataCoordinates( 0.3, 0.4, 1000 ) );
+}
+
+void PackedLineStringTest::testCopy()
+{
+    GeoDataLineString packed = ring( 10, 50, 1, 100 );
+    packed.setPacked( true );
+
+    // copies share the packed nodes until one of them is modified
+    GeoDataLineString copy = packed;
+    QVERIFY( copy.isPacked() );
+    copy.append( GeoDataCoordinates( 12, 52, 0, GeoDataCoordinates::Degree ) );
+    QVERIFY( !copy.isPacked() );
+    QVERIFY( packed.isPacked() );
+    QCOMPARE( packed.size(), 100 );
+    QCOMPARE( copy.size(), 101 );
+}
+
+void PackedLineStringTest::testScreenCoordinates_data()
+{
+    addProjectionRows();
+}
+
+void PackedLineStringTest::testScreenCoordinates()
+{
+    QFETCH( Marble::Projection, projection );
+
+    const ViewportParams viewport( projection, 10 * DEG2RAD, 30 * DEG2RAD, 300, QSize( 800, 600 ) );
+
+    // nodes all over the globe, some of them high up
+    GeoDataPackedCoordinates coordinates;
+    for ( int i = 0; i < 1000; ++i ) {
+        coordinates.append( GeoDataCoordinates( ( i * 37 ) % 360 - 180, ( i * 11 ) % 170 - 85,
+                                                i % 3 == 0 ? 20000.0 * i : 0.0, GeoDataCoordinates::Degree ) );
+    }
+
+    QVector<qreal> x( coordinates.size() );
+    QVector<qreal> y( coordinates.size() );
+    QVector<bool> globeHidesPoint( coordinates.size() );
+    viewport.currentProjection()->screenCoordinates( coordinates.size(), coordinates.longitudes(), coordinates.latitudes(),
+                                                     coordinates.altitudes(), &viewport,
+                                                     x.data(), y.data(), globeHidesPoint.data() );
+
+    int hidden = 0;
+    for ( int i = 0; i < coordinates.size(); ++i ) {
+        qreal expectedX;
+        qreal expectedY;
+        bool expectedGlobeHidesPoint;
+        viewport.screenCoordinates( coordinates.at( i ), expectedX, expectedY, expectedGlobeHidesPoint );
+        QCOMPARE( globeHidesPoint[i], expectedGlobeHidesPoint );
+        if ( !expectedGlobeHidesPoint ) {
+            QVERIFY( qAbs( x[i] - expectedX ) < 1e-6 );
+            QVERIFY( qAbs( y[i] - expectedY ) < 1e-6 );
+        }
+        hidden += globeHidesPoint[i];
+    }
+
+    QCOMPARE( hidden > 0, projection == Spherical || projection == Gnomonic );
+}
+
+void PackedLineStringTest::testPolygons_data()
+{
+    addProjectionRows();
+}
+
+void PackedLineStringTest::testPolygons()
+{
+    QFETCH( Marble::Projection, projection );
+
+    const ViewportParams viewport( projection, 100 * DEG2RAD, 20 * DEG2RAD, 200, QSize( 800, 600 ) );
+
+    // across the date line and beyond the horizon, with and without detail levels
+    QVector<GeoDataLineString> lineStrings;
+    lineStrings << ring( 170, 10, 30, 400 ) << ring( 170, 10, 30, 400 ).optimized() << ring( 100, 20, 2, 300 );
+    GeoDataLineString equator;
+    for ( int i = 0; i < 720; ++i ) {
+        equator << GeoDataCoordinates( i / 2.0 - 180, 5 * qSin( i * DEG2RAD ), 0, GeoDataCoordinates::Degree );
+    }
+    lineStrings << equator << equator.optimized();
+
+    for ( const GeoDataLineString &lineString: lineStrings ) {
+        QVector<GeoDataLineString> rings;
+        rings << lineString << GeoDataLinearRing( lineString );
+        for ( const GeoDataLineString &unpacked: rings ) {
+            GeoDataLineString packed = unpacked;
+            packed.setPacked( true );
+
+            QVector<QPolygonF *> expected;
+            QVector<QPolygonF *> polygons;
+            viewport.screenCoordinates( unpacked, expected );
+            viewport.screenCoordinates( packed, polygons );
+            QVERIFY( packed.isPacked() );
+            QVERIFY( !expected.isEmpty() );
+            comparePolygons( polygons, expected );
+
+            qDeleteAll( expected );
+            qDeleteAll( polygons );
+        }
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::PackedLineStringTest )
+
+#include "PackedLineStringTest.moc"
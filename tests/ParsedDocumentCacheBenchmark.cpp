@@ -0,0 +1,97 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ParsedDocumentCache.h"
+#include "GeoDataDocument.h"
+#include "MarbleDirs.h"
+#include "ParsingRunnerManager.h"
+#include "PluginManager.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class ParsedDocumentCacheBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkLoad_data();
+    void benchmarkLoad();
+
+private:
+    QString copyDataFile( const QString &relativePath ) const;
+
+    QTemporaryDir m_directory;
+    PluginManager m_pluginManager;
+};
+
+QString ParsedDocumentCacheBenchmark::copyDataFile( const QString &relativePath ) const
+{
+    // a copy the snapshots are made of, so the data path stays untouched
+    const QString target = m_directory.path() + QLatin1Char( '/' ) + QString( relativePath ).replace( QLatin1Char( '/' ), QLatin1Char( '_' ) );
+    if ( !QFile::exists( target ) ) {
+        QFile::copy( MarbleDirs::path( relativePath ), target );
+    }
+    return target;
+}
+
+void ParsedDocumentCacheBenchmark::initTestCase()
+{
+    QVERIFY( m_directory.isValid() );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+}
+
+void ParsedDocumentCacheBenchmark::benchmarkLoad_data()
+{
+    QTest::addColumn<QString>( "relativePath" );
+    QTest::addColumn<bool>( "snapshot" );
+
+    QTest::newRow( "cache parse" ) << "placemarks/cityplacemarks.cache" << false;
+    QTest::newRow( "cache snapshot" ) << "placemarks/cityplacemarks.cache" << true;
+    QTest::newRow( "pn2 parse" ) << "naturalearth/ne_50m_land.pn2" << false;
+    QTest::newRow( "pn2 snapshot" ) << "naturalearth/ne_50m_land.pn2" << true;
+}
+
+void ParsedDocumentCacheBenchmark::benchmarkLoad()
+{
+    QFETCH( QString, relativePath );
+    QFETCH( bool, snapshot );
+
+    const QString sourceFile = copyDataFile( relativePath );
+    const ParsedDocumentCache cache( m_directory.path() + QLatin1String( "/benchmark" ) );
+    ParsingRunnerManager runner( &m_pluginManager );
+    if ( snapshot ) {
+        QScopedPointer<GeoDataDocument> document( runner.openFile( sourceFile, MapDocument ) );
+        QVERIFY( document );
+        QVERIFY( cache.save( sourceFile, QByteArray(), *document ) );
+        qDebug() << QFileInfo( cache.snapshotPath( sourceFile, QByteArray() ) ).size() << "bytes in the snapshot,"
+                 << QFileInfo( sourceFile ).size() << "bytes in the source file";
+    }
+
+    int placemarks = 0;
+    QBENCHMARK {
+        QScopedPointer<GeoDataDocument> document( snapshot ? cache.load( sourceFile, QByteArray() )
+                                                           : runner.openFile( sourceFile, MapDocument ) );
+        QVERIFY( document );
+        placemarks = document->placemarkList().size();
+    }
+    QVERIFY( placemarks > 0 );
+}
+
+}
+
+QTEST_MAIN( Marble::ParsedDocumentCacheBenchmark )
+
+#include "ParsedDocumentCacheBenchmark.moc"
@@ -0,0 +1,282 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ParsedDocumentCache.h"
+#include "GeoDataData.h"
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataFolder.h"
+#include "GeoDataLineStyle.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolyStyle.h"
+#include "GeoDataSchemaData.h"
+#include "GeoDataStyle.h"
+#include "GeoDataTrack.h"
+#include "MarbleDirs.h"
+#include "MarbleGlobal.h"
+#include "ParsingRunnerManager.h"
+#include "PluginManager.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class ParsedDocumentCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testRoundTrip_data();
+    void testRoundTrip();
+    void testStyleUrl();
+    void testOutdated();
+    void testUnsupported();
+    void testOsmData();
+
+private:
+    QString copyDataFile( const QString &relativePath ) const;
+    static QByteArray packed( const GeoDataDocument &document );
+
+    QTemporaryDir m_directory;
+    PluginManager m_pluginManager;
+};
+
+QString ParsedDocumentCacheTest::copyDataFile( const QString &relativePath ) const
+{
+    // a copy that the tests can change without touching the data path
+    const QString target = m_directory.path() + QLatin1Char( '/' ) + QString( relativePath ).replace( QLatin1Char( '/' ), QLatin1Char( '_' ) );
+    if ( !QFile::exists( target ) ) {
+        QFile::copy( MarbleDirs::path( relativePath ), target );
+    }
+    return target;
+}
+
+QByteArray ParsedDocumentCacheTest::packed( const GeoDataDocument &document )
+{
+    QByteArray result;
+    QDataStream stream( &result, QIODevice::WriteOnly );
+    document.pack( stream );
+    return result;
+}
+
+void ParsedDocumentCacheTest::initTestCase()
+{
+    QVERIFY( m_directory.isValid() );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+}
+
+void ParsedDocumentCacheTest::testRoundTrip_data()
+{
+    QTest::addColumn<QString>( "relativePath" );
+
+    QTest::newRow( "cache" ) << "placemarks/cityplacemarks.cache";
+    QTest::newRow( "pn2" ) << "naturalearth/ne_50m_land.pn2";
+    QTest::newRow( "pnt" ) << "mwdbii/DATELINE.PNT";
+}
+
+void ParsedDocumentCacheTest::testRoundTrip()
+{
+    QFETCH( QString, relativePath );
+
+    const QString sourceFile = copyDataFile( relativePath );
+    ParsingRunnerManager runner( &m_pluginManager );
+    QScopedPointer<GeoDataDocument> document( runner.openFile( sourceFile, MapDocument ) );
+    QVERIFY( document );
+    QVERIFY( ParsedDocumentCache::isSupported( *document ) );
+
+    const ParsedDocumentCache cache( m_directory.path() + QLatin1String( "/snapshots" ) );
+    QVERIFY( !cache.load( sourceFile, "variant" ) );
+    QVERIFY( cache.save( sourceFile, "variant", *document ) );
+
+    QScopedPointer<GeoDataDocument> snapshot( cache.load( sourceFile, "variant" ) );
+    QVERIFY( snapshot );
+    QCOMPARE( snapshot->fileName(), sourceFile );
+    QCOMPARE( snapshot->size(), document->size() );
+    QCOMPARE( snapshot->placemarkList().size(), document->placemarkList().size() );
+    QCOMPARE( packed( *snapshot ), packed( *document ) );
+
+    cache.remove( sourceFile, "variant" );
+    QVERIFY( !cache.load( sourceFile, "variant" ) );
+}
+
+void ParsedDocumentCacheTest::testStyleUrl()
+{
+    const QString sourceFile = copyDataFile( "mwdbii/DATELINE.PNT" );
+
+    GeoDataDocument document;
+    GeoDataStyle::Ptr style( new GeoDataStyle );
+    style->setId( "line" );
+    style->lineStyle().setColor( Qt::red );
+    style->polyStyle().setFill( false );
+    document.addStyle( style );
+
+    GeoDataFolder *folder = new GeoDataFolder;
+    folder->setName( "Folder" );
+    document.append( folder );
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark( "Styled" );
+    placemark->setStyleUrl( "#line" );
+    placemark->setPopularity( 4711 );
+    placemark->setVisualCategory( GeoDataPlacemark::LargeCity );
+    folder->append( placemark );
+
+    GeoDataStyle::Ptr customStyle( new GeoDataStyle );
+    customStyle->lineStyle().setWidth( 3 );
+    for ( int i = 0; i < 2; ++i ) {
+        GeoDataPlacemark *custom = new GeoDataPlacemark( "Custom" );
+        custom->setStyle( customStyle );
+        document.append( custom );
+    }
+
+    const ParsedDocumentCache cache( m_directory.path() + QLatin1String( "/snapshots" ) );
+    QVERIFY( cache.save( sourceFile, QByteArray(), document ) );
+    QScopedPointer<GeoDataDocument> snapshot( cache.load( sourceFile, QByteArray() ) );
+    QVERIFY( snapshot );
+
+    QCOMPARE( snapshot->size(), 3 );
+    QCOMPARE( snapshot->placemarkList().size(), 2 );
+
+    const GeoDataFolder *snapshotFolder = static_cast<const GeoDataFolder *>( snapshot->child( 0 ) );
+    QCOMPARE( snapshotFolder->name(), QString( "Folder" ) );
+    const GeoDataPlacemark *styled = static_cast<const GeoDataPlacemark *>( snapshotFolder->child( 0 ) );
+    QCOMPARE( styled->styleUrl(), QString( "#line" ) );
+    QCOMPARE( styled->popularity(), qint64( 4711 ) );
+    QCOMPARE( styled->visualCategory(), GeoDataPlacemark::LargeCity );
+    QVERIFY( styled->style() == snapshot->style( "line" ) );
+    QCOMPARE( styled->style()->lineStyle().color(), QColor( Qt::red ) );
+    QVERIFY( !styled->style()->polyStyle().fill() );
+
+    // the custom styles are shared again
+    const GeoDataFeature *first = snapshot->child( 1 );
+    const GeoDataFeature *second = snapshot->child( 2 );
+    QVERIFY( first->customStyle() );
+    QCOMPARE( first->customStyle()->lineStyle().width(), float( 3 ) );
+    QVERIFY( first->customStyle() == second->customStyle() );
+}
+
+void ParsedDocumentCacheTest::testOutdated()
+{
+    const QString sourceFile = copyDataFile( "mwdbii/DATELINE.PNT" );
+    ParsingRunnerManager runner( &m_pluginManager );
+    QScopedPointer<GeoDataDocument> document( runner.openFile( sourceFile, MapDocument ) );
+    QVERIFY( document );
+
+    const ParsedDocumentCache cache( m_directory.path() + QLatin1String( "/snapshots" ) );
+    QVERIFY( cache.save( sourceFile, "variant", *document ) );
+    QVERIFY( !cache.load( sourceFile, "other variant" ) );
+    QScopedPointer<GeoDataDocument> snapshot( cache.load( sourceFile, "variant" ) );
+    QVERIFY( snapshot );
+
+    // a snapshot cut short
+    const QString snapshotPath = cache.snapshotPath( sourceFile, "variant" );
+    QFile snapshotFile( snapshotPath );
+    QVERIFY( snapshotFile.open( QIODevice::ReadWrite ) );
+    const QByteArray data = snapshotFile.readAll();
+    QVERIFY( snapshotFile.resize( data.size() / 2 ) );
+    snapshotFile.close();
+    QVERIFY( !cache.load( sourceFile, "variant" ) );
+
+    // a snapshot with trailing garbage
+    QVERIFY( snapshotFile.open( QIODevice::WriteOnly ) );
+    snapshotFile.write( data + "garbage" );
+    snapshotFile.close();
+    QVERIFY( !cache.load( sourceFile, "variant" ) );
+
+    // a snapshot written by another version of Marble
+    QByteArray version;
+    {
+        QDataStream stream( &version, QIODevice::WriteOnly );
+        stream << MARBLE_VERSION_STRING;
+    }
+    const int versionIndex = data.indexOf( version );
+    QVERIFY( versionIndex > 0 );
+    QByteArray otherVersion = data;
+    otherVersion[versionIndex + version.size() - 1] = otherVersion[versionIndex + version.size() - 1] + 1;
+    QVERIFY( snapshotFile.open( QIODevice::WriteOnly ) );
+    snapshotFile.write( otherVersion );
+    snapshotFile.close();
+    QVERIFY( !cache.load( sourceFile, "variant" ) );
+
+    // a source file that changed after the snapshot was written
+    QVERIFY( cache.save( sourceFile, "variant", *document ) );
+    QScopedPointer<GeoDataDocument> upToDate( cache.load( sourceFile, "variant" ) );
+    QVERIFY( upToDate );
+    QFile source( sourceFile );
+    QVERIFY( source.open( QIODevice::Append ) );
+    source.write( "\n" );
+    source.close();
+    QVERIFY( !cache.load( sourceFile, "variant" ) );
+}
+
+void ParsedDocumentCacheTest::testUnsupported()
+{
+    const QString sourceFile = copyDataFile( "mwdbii/DATELINE.PNT" );
+
+    GeoDataDocument document;
+    GeoDataPlacemark *placemark = new GeoDataPlacemark( "Track" );
+    placemark->setGeometry( new GeoDataTrack );
+    document.append( placemark );
+    QVERIFY( !ParsedDocumentCache::isSupported( document ) );
+
+    // KML schema data is not packed either
+    GeoDataDocument schemaDocument;
+    GeoDataPlacemark *schemaPlacemark = new GeoDataPlacemark( "Schema" );
+    GeoDataSchemaData schemaData;
+    schemaData.setSchemaUrl( "#schema" );
+    schemaPlacemark->extendedData().addSchemaData( schemaData );
+    schemaDocument.append( schemaPlacemark );
+    QVERIFY( !ParsedDocumentCache::isSupported( schemaDocument ) );
+
+    const ParsedDocumentCache cache( m_directory.path() + QLatin1String( "/snapshots" ) );
+    QVERIFY( !cache.save( sourceFile, "unsupported", document ) );
+    QVERIFY( !QFile::exists( cache.snapshotPath( sourceFile, "unsupported" ) ) );
+}
+
+void ParsedDocumentCacheTest::testOsmData()
+{
+    const QString sourceFile = copyDataFile( "mwdbii/DATELINE.PNT" );
+
+    GeoDataDocument document;
+    GeoDataPlacemark *placemark = new GeoDataPlacemark( "Road" );
+    placemark->setCoordinate( 0.1, 0.2 );
+    placemark->extendedData().addValue( GeoDataData( "ref", "B 27" ) );
+    placemark->osmData().setId( 4711 );
+    placemark->osmData().addTag( "highway", "primary" );
+    document.append( placemark );
+
+    // the OSM tags are not packed, so the snapshot would lose them
+    const ParsedDocumentCache cache( m_directory.path() + QLatin1String( "/snapshots" ) );
+    QVERIFY( !ParsedDocumentCache::isSupported( document ) );
+    QVERIFY( !cache.save( sourceFile, "osm", document ) );
+    QVERIFY( !cache.load( sourceFile, "osm" ) );
+
+    // the plain extended data is kept
+    placemark->clearOsmData();
+    QVERIFY( ParsedDocumentCache::isSupported( document ) );
+    QVERIFY( cache.save( sourceFile, "osm", document ) );
+    QScopedPointer<GeoDataDocument> snapshot( cache.load( sourceFile, "osm" ) );
+    QVERIFY( snapshot );
+    QCOMPARE( snapshot->placemarkList().size(), 1 );
+    const GeoDataPlacemark *road = snapshot->placemarkList().first();
+    QCOMPARE( road->name(), QString( "Road" ) );
+    QCOMPARE( road->extendedData().value( "ref" ).value(), QVariant( "B 27" ) );
+    QVERIFY( !road->hasOsmData() );
+}
+
+}
+
+QTEST_MAIN( Marble::ParsedDocumentCacheTest )
+
+#include "ParsedDocumentCacheTest.moc"
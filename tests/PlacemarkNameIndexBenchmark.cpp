@@ -0,0 +1,74 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataLatLonBox.h"
+#include "GeoDataTreeModel.h"
+#include "MarbleModel.h"
+#include "PlacemarkNameIndex.h"
+#include "TestPlacemarkNames.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+class PlacemarkNameIndexBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkFind_data();
+    void benchmarkFind();
+
+private:
+    MarbleModel m_model;
+};
+
+void PlacemarkNameIndexBenchmark::initTestCase()
+{
+    m_model.treeModel()->addDocument( TestPlacemarkNames::largeDocument() );
+}
+
+void PlacemarkNameIndexBenchmark::benchmarkFind_data()
+{
+    QTest::addColumn<QString>( "term" );
+    QTest::addColumn<bool>( "preferred" );
+    QTest::addColumn<bool>( "useScan" );
+
+    QTest::newRow( "scan, short prefix" ) << "S" << false << true;
+    QTest::newRow( "scan, long prefix" ) << "Neu Tomisel" << false << true;
+    QTest::newRow( "index, short prefix" ) << "S" << false << false;
+    QTest::newRow( "index, long prefix" ) << "Neu Tomisel" << false << false;
+    QTest::newRow( "index, short prefix in area" ) << "S" << true << false;
+    QTest::newRow( "index, typo" ) << "Neu Tomisl" << false << false;
+}
+
+void PlacemarkNameIndexBenchmark::benchmarkFind()
+{
+    QFETCH( QString, term );
+    QFETCH( bool, preferred );
+    QFETCH( bool, useScan );
+
+    const PlacemarkNameIndex *index = m_model.placemarkNameIndex();
+    const GeoDataLatLonBox area = preferred ? GeoDataLatLonBox( 55.0, 47.0, 15.0, 6.0, GeoDataCoordinates::Degree ) : GeoDataLatLonBox();
+    const PlacemarkNameIndex::MatchMode mode = term.endsWith( QLatin1String( "isl" ) ) ? PlacemarkNameIndex::FuzzyMatch : PlacemarkNameIndex::PrefixMatch;
+    QBENCHMARK {
+        if ( useScan ) {
+            TestPlacemarkNames::scan( m_model, term );
+        } else {
+            qDeleteAll( index->find( term, area, mode ) );
+        }
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::PlacemarkNameIndexBenchmark )
+
+#include "PlacemarkNameIndexBenchmark.moc"
@@ -0,0 +1,242 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataDocument.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTreeModel.h"
+#include "MarbleModel.h"
+#include "MarblePlacemarkModel.h"
+#include "PlacemarkNameIndex.h"
+#include "TestPlacemarkNames.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+class PlacemarkNameIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testFold_data();
+    void testFold();
+    void testPrefix_data();
+    void testPrefix();
+    void testPreferred();
+    void testFuzzy();
+    void testAddRemove();
+    void testRename();
+    void testAgainstScan_data();
+    void testAgainstScan();
+
+private:
+    static GeoDataPlacemark *placemark( const QString &name, qreal lon, qreal lat );
+    static QStringList names( const QVector<GeoDataPlacemark*> &placemarks );
+
+    MarbleModel m_model;
+    GeoDataDocument *m_cities;
+    GeoDataDocument *m_large;
+    int m_otherPlacemarks;
+};
+
+GeoDataPlacemark *PlacemarkNameIndexTest::placemark( const QString &name, qreal lon, qreal lat )
+{
+    return TestPlacemarkNames::placemark( name, lon, lat );
+}
+
+QStringList PlacemarkNameIndexTest::names( const QVector<GeoDataPlacemark*> &placemarks )
+{
+    QStringList result;
+    for ( const GeoDataPlacemark *placemark: placemarks ) {
+        result << placemark->name();
+    }
+    qDeleteAll( placemarks );
+    return result;
+}
+
+void PlacemarkNameIndexTest::initTestCase()
+{
+    // the model has a few placemarks of its own, like the current position
+    m_otherPlacemarks = m_model.placemarkNameIndex()->size();
+
+    m_cities = new GeoDataDocument;
+    m_cities->append( placemark( "Berlin", 13.40, 52.52 ) );
+    m_cities->append( placemark( "Bern", 7.45, 46.95 ) );
+    m_cities->append( placemark( "Bergen", 5.32, 60.39 ) );
+    m_cities->append( placemark( "Zürich", 8.54, 47.37 ) );
+    m_cities->append( placemark( "Łódź", 19.46, 51.76 ) );
+    m_cities->append( placemark( "São Paulo", -46.63, -23.55 ) );
+    m_cities->append( placemark( "Gießen", 8.68, 50.58 ) );
+    m_cities->append( placemark( "Suva", 178.44, -18.14 ) );
+    m_cities->append( placemark( "Apia", -171.76, -13.83 ) );
+    m_cities->append( placemark( QString(), 0.0, 0.0 ) );
+    m_model.treeModel()->addDocument( m_cities );
+    m_large = 0;
+
+    QCOMPARE( m_model.placemarkNameIndex()->size(), m_otherPlacemarks + 9 );
+}
+
+void PlacemarkNameIndexTest::testFold_data()
+{
+    QTest::addColumn<QString>( "name" );
+    QTest::addColumn<QString>( "expected" );
+
+    QTest::newRow( "case" ) << "BeRLin" << "berlin";
+    QTest::newRow( "umlaut" ) << "Zürich" << "zurich";
+    QTest::newRow( "sharp s" ) << "Gießen" << "giessen";
+    QTest::newRow( "stroke" ) << "Łódź" << "lodz";
+    QTest::newRow( "o with stroke" ) << "Øresund" << "oresund";
+    QTest::newRow( "tilde" ) << "São Paulo" << "sao paulo";
+}
+
+void PlacemarkNameIndexTest::testFold()
+{
+    QFETCH( QString, name );
+    QFETCH( QString, expected );
+
+    QCOMPARE( PlacemarkNameIndex::fold( name ), expected );
+}
+
+void PlacemarkNameIndexTest::testPrefix_data()
+{
+    QTest::addColumn<QString>( "term" );
+    QTest::addColumn<QStringList>( "expected" );
+
+    QTest::newRow( "prefix" ) << "Ber" << ( QStringList() << "Bergen" << "Berlin" << "Bern" );
+    QTest::newRow( "case" ) << "bERL" << ( QStringList() << "Berlin" );
+    QTest::newRow( "whole name" ) << "Bern" << ( QStringList() << "Bern" );
+    QTest::newRow( "without diacritics" ) << "zur" << ( QStringList() << "Zürich" );
+    QTest::newRow( "with diacritics" ) << "Zür" << ( QStringList() << "Zürich" );
+    QTest::newRow( "stroke" ) << "lod" << ( QStringList() << "Łódź" );
+    QTest::newRow( "sharp s" ) << "Giess" << ( QStringList() << "Gießen" );
+    QTest::newRow( "whitespace" ) << " sao p " << ( QStringList() << "São Paulo" );
+    QTest::newRow( "none" ) << "Hamburg" << QStringList();
+    QTest::newRow( "empty" ) << "" << QStringList();
+}
+
+void PlacemarkNameIndexTest::testPrefix()
+{
+    QFETCH( QString, term );
+    QFETCH( QStringList, expected );
+
+    QCOMPARE( names( m_model.placemarkNameIndex()->find( term, GeoDataLatLonBox() ) ), expected );
+}
+
+void PlacemarkNameIndexTest::testPreferred()
+{
+    const PlacemarkNameIndex *index = m_model.placemarkNameIndex();
+
+    const GeoDataLatLonBox europe( 72.0, 35.0, 40.0, -10.0, GeoDataCoordinates::Degree );
+    QCOMPARE( names( index->find( "B", europe ) ), QStringList() << "Bergen" << "Berlin" << "Bern" );
+
+    const GeoDataLatLonBox germany( 55.0, 47.0, 15.0, 6.0, GeoDataCoordinates::Degree );
+    QCOMPARE( names( index->find( "Ber", germany ) ), QStringList() << "Berlin" );
+
+    const GeoDataLatLonBox pacific( 0.0, -30.0, -160.0, 170.0, GeoDataCoordinates::Degree );
+    QVERIFY( pacific.crossesDateLine() );
+    QCOMPARE( names( index->find( "Suva", pacific ) ), QStringList() << "Suva" );
+    QCOMPARE( names( index->find( "Apia", pacific ) ), QStringList() << "Apia" );
+    QCOMPARE( names( index->find( "Bern", pacific ) ), QStringList() );
+}
+
+void PlacemarkNameIndexTest::testFuzzy()
+{
+    const PlacemarkNameIndex *index = m_model.placemarkNameIndex();
+
+    QCOMPARE( names( index->find( "Berln", GeoDataLatLonBox() ) ), QStringList() );
+    const QStringList fuzzy = names( index->find( "Berln", GeoDataLatLonBox(), PlacemarkNameIndex::FuzzyMatch ) );
+    QVERIFY( !fuzzy.isEmpty() );
+    QCOMPARE( fuzzy.first(), QString( "Berlin" ) );
+    QVERIFY( !fuzzy.contains( "Zürich" ) );
+
+    QCOMPARE( names( index->find( "Zurik", GeoDataLatLonBox(), PlacemarkNameIndex::FuzzyMatch ) ).value( 0 ), QString( "Zürich" ) );
+
+    const GeoDataLatLonBox southAmerica( 10.0, -55.0, -35.0, -80.0, GeoDataCoordinates::Degree );
+    QCOMPARE( names( index->find( "Berln", southAmerica, PlacemarkNameIndex::FuzzyMatch ) ), QStringList() );
+}
+
+void PlacemarkNameIndexTest::testAddRemove()
+{
+    const PlacemarkNameIndex *index = m_model.placemarkNameIndex();
+
+    GeoDataDocument *document = new GeoDataDocument;
+    document->append( placemark( "Bremen", 8.80, 53.08 ) );
+    document->append( placemark( "Bergamo", 9.67, 45.70 ) );
+    m_model.treeModel()->addDocument( document );
+    QCOMPARE( index->size(), m_otherPlacemarks + 11 );
+    QCOMPARE( names( index->find( "Br", GeoDataLatLonBox() ) ), QStringList() << "Bremen" );
+    QCOMPARE( names( index->find( "Berg", GeoDataLatLonBox() ) ), QStringList() << "Bergamo" << "Bergen" );
+
+    GeoDataPlacemark *hamburg = placemark( "Hamburg", 9.99, 53.55 );
+    m_model.treeModel()->addFeature( document, hamburg );
+    QCOMPARE( names( index->find( "Ham", GeoDataLatLonBox() ) ), QStringList() << "Hamburg" );
+
+    m_model.treeModel()->removeFeature( hamburg );
+    delete hamburg;
+    QCOMPARE( names( index->find( "Ham", GeoDataLatLonBox() ) ), QStringList() );
+
+    m_model.treeModel()->removeDocument( document );
+    delete document;
+    QCOMPARE( index->size(), m_otherPlacemarks + 9 );
+    QCOMPARE( names( index->find( "Br", GeoDataLatLonBox() ) ), QStringList() );
+    QCOMPARE( names( index->find( "Berg", GeoDataLatLonBox() ) ), QStringList() << "Bergen" );
+    QCOMPARE( names( index->find( "Bergn", GeoDataLatLonBox(), PlacemarkNameIndex::FuzzyMatch ) ).value( 0 ), QString( "Bergen" ) );
+}
+
+void PlacemarkNameIndexTest::testRename()
+{
+    const PlacemarkNameIndex *index = m_model.placemarkNameIndex();
+
+    GeoDataPlacemark *bergen = static_cast<GeoDataPlacemark*>( m_cities->child( 2 ) );
+    bergen->setName( "Bjørgvin" );
+    m_model.treeModel()->updateFeature( bergen );
+
+    QCOMPARE( names( index->find( "Bergen", GeoDataLatLonBox() ) ), QStringList() );
+    QCOMPARE( names( index->find( "bjorg", GeoDataLatLonBox() ) ), QStringList() << "Bjørgvin" );
+
+    bergen->setName( "Bergen" );
+    m_model.treeModel()->updateFeature( bergen );
+    QCOMPARE( names( index->find( "Bergen", GeoDataLatLonBox() ) ), QStringList() << "Bergen" );
+    QCOMPARE( index->size(), m_otherPlacemarks + 9 );
+}
+
+void PlacemarkNameIndexTest::testAgainstScan_data()
+{
+    QTest::addColumn<QString>( "term" );
+
+    QTest::newRow( "word" ) << "Sankt";
+    QTest::newRow( "two words" ) << "Alt Ber";
+    QTest::newRow( "long" ) << "Neu Tomisel";
+    QTest::newRow( "case" ) << "oBER LA";
+}
+
+void PlacemarkNameIndexTest::testAgainstScan()
+{
+    QFETCH( QString, term );
+
+    if ( !m_large ) {
+        m_large = TestPlacemarkNames::largeDocument();
+        m_model.treeModel()->addDocument( m_large );
+    }
+
+    QStringList expected = TestPlacemarkNames::scan( m_model, term );
+    QStringList found = names( m_model.placemarkNameIndex()->find( term, GeoDataLatLonBox() ) );
+    QVERIFY( !expected.isEmpty() );
+    expected.sort();
+    found.sort();
+    QCOMPARE( found, expected );
+}
+
+}
+
+QTEST_MAIN( Marble::PlacemarkNameIndexTest )
+
+#include "PlacemarkNameIndexTest.moc"
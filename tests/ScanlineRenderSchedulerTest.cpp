@@ -0,0 +1,260 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ScanlineRenderScheduler.h"
+
+#include "FileStoragePolicy.h"
+#include "GeoSceneTextureTileDataset.h"
+#include "HttpDownloadManager.h"
+#include "MergedLayerDecorator.h"
+#include "StackedTileLoader.h"
+#include "TileLoader.h"
+
+#include <algorithm>
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSemaphore>
+#include <QSize>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThreadPool>
+#include <QVector>
+
+namespace Marble
+{
+
+typedef QPair<int, int> Block;
+
+/**
+ * Records the blocks rendered by each worker in the order they were dispatched.
+ * The workers are told apart by their contexts, which live for the whole frame.
+ */
+class RecordingJob : public ScanlineRenderScheduler::Job
+{
+public:
+    RecordingJob() :
+        m_heldBlock( -1 ),
+        m_releaseFrom( -1 ),
+        m_released( true )
+    {}
+
+    /// holds the block starting at @p yTop until a block starting at @p releaseFrom or below was rendered
+    void holdBlock( int yTop, int releaseFrom )
+    {
+        m_heldBlock = yTop;
+        m_releaseFrom = releaseFrom;
+        m_released = false;
+    }
+
+    /// whether the held block was released before the timeout
+    bool wasReleased() const
+    {
+        return m_released;
+    }
+
+    void renderBlock( ScanlineTextureMapperContext &context, int yTop, int yBottom ) override
+    {
+        {
+            QMutexLocker locker( &m_mutex );
+            m_blocks[&context] << Block( yTop, yBottom );
+        }
+
+        if ( m_releaseFrom >= 0 && yTop >= m_releaseFrom ) {
+            m_release.release();
+        }
+
+        if ( yTop == m_heldBlock ) {
+            // the timeout only keeps a broken scheduler from hanging the test
+            m_released = m_release.tryAcquire( 1, 5000 );
+        }
+    }
+
+    QList<QVector<Block> > workers() const
+    {
+        return m_blocks.values();
+    }
+
+    /// all blocks sorted by their first scanline
+    QVector<Block> allBlocks() const
+    {
+        QVector<Block> result;
+        for ( const QVector<Block> &blocks: m_blocks ) {
+            result += blocks;
+        }
+        std::sort( result.begin(), result.end() );
+        return result;
+    }
+
+private:
+    QMutex m_mutex;
+    QHash<const ScanlineTextureMapperContext *, QVector<Block> > m_blocks;
+    QSemaphore m_release;
+    int m_heldBlock;
+    int m_releaseFrom;
+    bool m_released;
+};
+
+class ScanlineRenderSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testSingleWorkerOrder();
+    void testEvenBlockBorders();
+    void testStealUpperHalf();
+
+private:
+    static void verifyCoverage( const QVector<Block> &blocks, int yTop, int yBottom, int blockHeight );
+
+    QTemporaryDir m_directory;
+    FileStoragePolicy *m_storagePolicy;
+    HttpDownloadManager *m_downloadManager;
+    TileLoader *m_tileLoader;
+    MergedLayerDecorator *m_layerDecorator;
+    StackedTileLoader *m_stackedTileLoader;
+    GeoSceneTextureTileDataset *m_texture;
+};
+
+void ScanlineRenderSchedulerTest::initTestCase()
+{
+    QVERIFY( m_directory.isValid() );
+
+    // the workers create texture mapper contexts, which need a tile loader with a texture
+    m_storagePolicy = new FileStoragePolicy( m_directory.path() );
+    m_downloadManager = new HttpDownloadManager( m_storagePolicy );
+    m_tileLoader = new TileLoader( m_downloadManager, 0 );
+    m_layerDecorator = new MergedLayerDecorator( m_tileLoader );
+    m_stackedTileLoader = new StackedTileLoader( m_layerDecorator );
+
+    m_texture = new GeoSceneTextureTileDataset( "test" );
+    m_texture->setSourceDir( "earth/test" );
+    m_texture->setTileSize( QSize( 256, 256 ) );
+    m_texture->setLevelZeroColumns( 2 );
+    m_texture->setLevelZeroRows( 1 );
+    m_texture->setMaximumTileLevel( 3 );
+    m_layerDecorator->setTextureLayers( QVector<const GeoSceneTextureTileDataset *>() << m_texture );
+}
+
+void ScanlineRenderSchedulerTest::cleanupTestCase()
+{
+    delete m_stackedTileLoader;
+    delete m_layerDecorator;
+    delete m_texture;
+    delete m_tileLoader;
+    delete m_downloadManager;
+    delete m_storagePolicy;
+}
+
+void ScanlineRenderSchedulerTest::verifyCoverage( const QVector<Block> &blocks, int yTop, int yBottom, int blockHeight )
+{
+    // every scanline is rendered exactly once, in blocks starting at an even distance from yTop
+    int y = yTop;
+    for ( const Block &block: blocks ) {
+        QCOMPARE( block.first, y );
+        QCOMPARE( ( block.first - yTop ) % 2, 0 );
+        QCOMPARE( block.second, qMin( yBottom, block.first + blockHeight ) );
+        y = block.second;
+    }
+    QCOMPARE( y, yBottom );
+}
+
+void ScanlineRenderSchedulerTest::testSingleWorkerOrder()
+{
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount( 1 );
+    ScanlineRenderScheduler scheduler( &threadPool );
+
+    RecordingJob job;
+    scheduler.start( &job, m_stackedTileLoader, 0, 10, 110 );
+    scheduler.waitForDone();
+
+    // a single worker gets all blocks as one run, from top to bottom
+    QCOMPARE( job.workers().size(), 1 );
+    const QVector<Block> blocks = job.workers().first();
+    verifyCoverage( blocks, 10, 110, 12 );
+
+    const ScanlineRenderScheduler::Statistics &statistics = scheduler.statistics();
+    QCOMPARE( statistics.blockHeight, 12 );
+    QCOMPARE( statistics.blockCount, blocks.size() );
+    QCOMPARE( statistics.stealCount, 0 );
+    QCOMPARE( statistics.blocksPerWorker, QVector<int>() << blocks.size() );
+}
+
+void ScanlineRenderSchedulerTest::testEvenBlockBorders()
+{
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount( 4 );
+    ScanlineRenderScheduler scheduler( &threadPool );
+
+    // odd block heights would break interlaced rendering
+    scheduler.setBlockHeight( 3 );
+    QCOMPARE( scheduler.blockHeight(), 3 );
+
+    RecordingJob job;
+    scheduler.start( &job, m_stackedTileLoader, 0, 5, 100 );
+    scheduler.waitForDone();
+    verifyCoverage( job.allBlocks(), 5, 100, 2 );
+
+    const ScanlineRenderScheduler::Statistics &statistics = scheduler.statistics();
+    QCOMPARE( statistics.blockHeight, 2 );
+    QCOMPARE( statistics.blockCount, 48 );
+    QCOMPARE( statistics.blocksPerWorker.size(), 4 );
+    int blocks = 0;
+    for ( int count: statistics.blocksPerWorker ) {
+        blocks += count;
+    }
+    QCOMPARE( blocks, 48 );
+}
+
+void ScanlineRenderSchedulerTest::testStealUpperHalf()
+{
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount( 2 );
+    ScanlineRenderScheduler scheduler( &threadPool );
+    scheduler.setBlockHeight( 4 );
+
+    // 16 blocks, the second worker is stuck in the first block of its run
+    // until the first worker has stolen from the end of the frame
+    RecordingJob job;
+    job.holdBlock( 32, 48 );
+    scheduler.start( &job, m_stackedTileLoader, 0, 0, 64 );
+    scheduler.waitForDone();
+    QVERIFY( job.wasReleased() );
+    verifyCoverage( job.allBlocks(), 0, 64, 4 );
+
+    QVector<Block> first;
+    for ( const QVector<Block> &worker: job.workers() ) {
+        if ( !worker.isEmpty() && worker.first().first == 0 ) {
+            first = worker;
+        }
+    }
+
+    // the first worker renders its own run in order, then steals from the
+    // upper half of the second worker's remaining blocks, the end of the frame
+    QVERIFY( first.size() > 8 );
+    for ( int i = 0; i < 8; ++i ) {
+        QCOMPARE( first[i].first, i * 4 );
+    }
+    QVERIFY2( first[8].first >= 48, qPrintable( QString::number( first[8].first ) ) );
+
+    const ScanlineRenderScheduler::Statistics &statistics = scheduler.statistics();
+    QVERIFY( statistics.stealCount >= 1 );
+    QCOMPARE( statistics.blockCount, 16 );
+    QCOMPARE( statistics.blocksPerWorker[0] + statistics.blocksPerWorker[1], 16 );
+}
+
+}
+
+QTEST_MAIN( Marble::ScanlineRenderSchedulerTest )
+
+#include "ScanlineRenderSchedulerTest.moc"
@@ -0,0 +1,88 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ScreenPolygonCache.h"
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataLineString.h"
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+
+#include <QPolygonF>
+#include <QTest>
+#include <qmath.h>
+
+namespace Marble
+{
+
+class ScreenPolygonCacheBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkPan();
+    void benchmarkProjection();
+
+private:
+    void fill( ScreenPolygonCache &cache, const ViewportParams &viewport ) const;
+
+    GeoDataLineString m_lineString;
+};
+
+void ScreenPolygonCacheBenchmark::fill( ScreenPolygonCache &cache, const ViewportParams &viewport ) const
+{
+    viewport.screenCoordinates( m_lineString, cache.polygons() );
+    cache.setViewport( &viewport );
+}
+
+void ScreenPolygonCacheBenchmark::initTestCase()
+{
+    // a winding road of a few kilometers
+    m_lineString.setTessellate( true );
+    for ( int i = 0; i < 1000; ++i ) {
+        const qreal lon = 13.35 + 0.0001 * i;
+        const qreal lat = 52.5 + 0.002 * qSin( i / 50.0 );
+        m_lineString << GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
+    }
+}
+
+void ScreenPolygonCacheBenchmark::benchmarkPan()
+{
+    ViewportParams viewport( Mercator, 13.4 * DEG2RAD, 52.5 * DEG2RAD, 100000, QSize( 800, 600 ) );
+    ScreenPolygonCache cache;
+    fill( cache, viewport );
+
+    int i = 0;
+    QBENCHMARK {
+        viewport.centerOn( ( 13.4 + 0.00001 * ( ++i % 100 ) ) * DEG2RAD, 52.5 * DEG2RAD );
+        if ( !cache.update( &viewport ) ) {
+            fill( cache, viewport );
+        }
+    }
+}
+
+void ScreenPolygonCacheBenchmark::benchmarkProjection()
+{
+    // What panning did before: project the line string in every frame
+    ViewportParams viewport( Mercator, 13.4 * DEG2RAD, 52.5 * DEG2RAD, 100000, QSize( 800, 600 ) );
+
+    int i = 0;
+    QBENCHMARK {
+        viewport.centerOn( ( 13.4 + 0.00001 * ( ++i % 100 ) ) * DEG2RAD, 52.5 * DEG2RAD );
+        QVector<QPolygonF *> polygons;
+        viewport.screenCoordinates( m_lineString, polygons );
+        qDeleteAll( polygons );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::ScreenPolygonCacheBenchmark )
+
+#include "ScreenPolygonCacheBenchmark.moc"
@@ -0,0 +1,152 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ScreenPolygonCache.h"
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataLineString.h"
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+
+#include <QPolygonF>
+#include <QTest>
+#include <qmath.h>
+
+Q_DECLARE_METATYPE( Marble::Projection )
+
+namespace Marble
+{
+
+class ScreenPolygonCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testUnchangedViewport();
+    void testPan_data();
+    void testPan();
+    void testRepeatedMap();
+    void testZoom();
+
+private:
+    static void fill( ScreenPolygonCache &cache, const GeoDataLineString &lineString, const ViewportParams &viewport );
+
+    GeoDataLineString m_lineString;
+};
+
+void ScreenPolygonCacheTest::fill( ScreenPolygonCache &cache, const GeoDataLineString &lineString, const ViewportParams &viewport )
+{
+    viewport.screenCoordinates( lineString, cache.polygons() );
+    cache.setViewport( &viewport );
+}
+
+void ScreenPolygonCacheTest::initTestCase()
+{
+    // a winding road of a few kilometers
+    m_lineString.setTessellate( true );
+    for ( int i = 0; i < 1000; ++i ) {
+        const qreal lon = 13.35 + 0.0001 * i;
+        const qreal lat = 52.5 + 0.002 * qSin( i / 50.0 );
+        m_lineString << GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
+    }
+}
+
+void ScreenPolygonCacheTest::testUnchangedViewport()
+{
+    ViewportParams viewport( Spherical, 13.4 * DEG2RAD, 52.5 * DEG2RAD, 100000, QSize( 800, 600 ) );
+
+    ScreenPolygonCache cache;
+    QVERIFY( !cache.update( &viewport ) );
+    fill( cache, m_lineString, viewport );
+    QVERIFY( !cache.polygons().isEmpty() );
+    const QPolygonF first = *cache.polygons().first();
+
+    bool moved = true;
+    QVERIFY( cache.update( &viewport, &moved ) );
+    QVERIFY( !moved );
+    QCOMPARE( *cache.polygons().first(), first );
+
+    // panning the globe rotates it, which polygons cannot follow
+    viewport.centerOn( 13.41 * DEG2RAD, 52.5 * DEG2RAD );
+    QVERIFY( !cache.update( &viewport ) );
+    QVERIFY( cache.polygons().isEmpty() );
+}
+
+void ScreenPolygonCacheTest::testPan_data()
+{
+    QTest::addColumn<Marble::Projection>( "projection" );
+
+    QTest::newRow( "Equirectangular" ) << Equirectangular;
+    QTest::newRow( "Mercator" ) << Mercator;
+}
+
+void ScreenPolygonCacheTest::testPan()
+{
+    QFETCH( Marble::Projection, projection );
+
+    ViewportParams viewport( projection, 13.4 * DEG2RAD, 52.5 * DEG2RAD, 100000, QSize( 800, 600 ) );
+    ScreenPolygonCache cache;
+    fill( cache, m_lineString, viewport );
+
+    for ( int i = 1; i <= 10; ++i ) {
+        viewport.centerOn( ( 13.4 + 0.001 * i ) * DEG2RAD, ( 52.5 - 0.0005 * i ) * DEG2RAD );
+
+        bool moved = false;
+        QVERIFY( cache.update( &viewport, &moved ) );
+        QVERIFY( moved );
+
+        QVector<QPolygonF *> expected;
+        viewport.screenCoordinates( m_lineString, expected );
+        QCOMPARE( cache.polygons().size(), expected.size() );
+        for ( int j = 0; j < expected.size(); ++j ) {
+            const QPolygonF &polygon = *cache.polygons()[j];
+            QCOMPARE( polygon.size(), expected[j]->size() );
+            for ( int k = 0; k < polygon.size(); ++k ) {
+                QVERIFY( qAbs( polygon[k].x() - expected[j]->at( k ).x() ) < 1e-6 );
+                QVERIFY( qAbs( polygon[k].y() - expected[j]->at( k ).y() ) < 1e-6 );
+            }
+        }
+        qDeleteAll( expected );
+    }
+}
+
+void ScreenPolygonCacheTest::testRepeatedMap()
+{
+    // The whole world fits into the viewport several times
+    ViewportParams viewport( Equirectangular, 0, 0, 50, QSize( 800, 600 ) );
+    ScreenPolygonCache cache;
+    fill( cache, m_lineString, viewport );
+
+    viewport.centerOn( 10 * DEG2RAD, 0 );
+    QVERIFY( !cache.update( &viewport ) );
+}
+
+void ScreenPolygonCacheTest::testZoom()
+{
+    ViewportParams viewport( Mercator, 13.4 * DEG2RAD, 52.5 * DEG2RAD, 100000, QSize( 800, 600 ) );
+    ScreenPolygonCache cache;
+    fill( cache, m_lineString, viewport );
+
+    viewport.setRadius( 120000 );
+    QVERIFY( !cache.update( &viewport ) );
+
+    fill( cache, m_lineString, viewport );
+    viewport.setSize( QSize( 1024, 768 ) );
+    QVERIFY( !cache.update( &viewport ) );
+
+    fill( cache, m_lineString, viewport );
+    cache.clear();
+    QVERIFY( !cache.update( &viewport ) );
+}
+
+}
+
+QTEST_MAIN( Marble::ScreenPolygonCacheTest )
+
+#include "ScreenPolygonCacheTest.moc"
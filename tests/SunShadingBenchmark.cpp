@@ -0,0 +1,82 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "SunShading.h"
+
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+
+#include <QImage>
+#include <QTest>
+
+namespace Marble
+{
+
+class SunShadingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkSunMove();
+    void benchmarkPan();
+
+private:
+    static QImage canvas( const QSize &size );
+};
+
+static const qreal SunLon = 30 * DEG2RAD;
+static const qreal SunLat = 10 * DEG2RAD;
+static const qreal TwilightZone = 0.1;
+
+QImage SunShadingBenchmark::canvas( const QSize &size )
+{
+    QImage result( size, QImage::Format_ARGB32_Premultiplied );
+    result.fill( qRgb( 200, 150, 100 ) );
+    return result;
+}
+
+void SunShadingBenchmark::benchmarkSunMove()
+{
+    const ViewportParams viewport( Spherical, 80 * DEG2RAD, 20 * DEG2RAD, 500, QSize( 1920, 1080 ) );
+    const QImage image = canvas( viewport.size() );
+
+    SunShading shading;
+    shading.setTwilightZone( TwilightZone );
+    QImage shaded = image;
+    shading.shade( &shaded, 0, &viewport );
+
+    int i = 0;
+    QBENCHMARK {
+        shaded = image;
+        shading.setSunPosition( SunLon + 0.001 * ( ++i % 100 ), SunLat );
+        shading.shade( &shaded, 0, &viewport );
+    }
+}
+
+void SunShadingBenchmark::benchmarkPan()
+{
+    ViewportParams viewport( Spherical, 80 * DEG2RAD, 20 * DEG2RAD, 500, QSize( 1920, 1080 ) );
+    const QImage image = canvas( viewport.size() );
+
+    SunShading shading;
+    shading.setTwilightZone( TwilightZone );
+    shading.setSunPosition( SunLon, SunLat );
+
+    int i = 0;
+    QBENCHMARK {
+        QImage shaded = image;
+        viewport.centerOn( ( 80 + 0.01 * ( ++i % 100 ) ) * DEG2RAD, 20 * DEG2RAD );
+        shading.shade( &shaded, 0, &viewport );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::SunShadingBenchmark )
+
+#include "SunShadingBenchmark.moc"
@@ -0,0 +1,170 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "SunShading.h"
+
+#include "GeoDataCoordinates.h"
+#include "MarbleGlobal.h"
+#include "ViewportParams.h"
+
+#include <QImage>
+#include <QTest>
+#include <qmath.h>
+
+Q_DECLARE_METATYPE( Marble::Projection )
+
+namespace Marble
+{
+
+class SunShadingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testShading_data();
+    void testShading();
+    void testNightCanvas();
+    void testSunMove();
+
+private:
+    static QImage canvas( const QSize &size, QRgb color );
+
+    // SunLocator::shading() for a pixel, scaled to 0..256
+    static int weight( const ViewportParams &viewport, int x, int y, qreal sunLon, qreal sunLat, qreal twilightZone );
+};
+
+static const qreal SunLon = 30 * DEG2RAD;
+static const qreal SunLat = 10 * DEG2RAD;
+static const qreal TwilightZone = 0.1;
+
+QImage SunShadingTest::canvas( const QSize &size, QRgb color )
+{
+    QImage result( size, QImage::Format_ARGB32_Premultiplied );
+    result.fill( color );
+    return result;
+}
+
+int SunShadingTest::weight( const ViewportParams &viewport, int x, int y, qreal sunLon, qreal sunLat, qreal twilightZone )
+{
+    qreal lon;
+    qreal lat;
+    if ( !viewport.geoCoordinates( x, y, lon, lat, GeoDataCoordinates::Radian ) ) {
+        return 256;
+    }
+
+    const qreal a = qSin( ( lat - sunLat ) / 2.0 );
+    const qreal b = qSin( ( lon - sunLon ) / 2.0 );
+    const qreal h = a * a + qCos( lat ) * qCos( sunLat ) * b * b;
+    const qreal brightness = qBound( 0.0, ( 0.5 + twilightZone / 2.0 - h ) / twilightZone, 1.0 );
+    return int( brightness * 256 );
+}
+
+void SunShadingTest::testShading_data()
+{
+    QTest::addColumn<Marble::Projection>( "projection" );
+
+    QTest::newRow( "Spherical" ) << Spherical;
+    QTest::newRow( "Equirectangular" ) << Equirectangular;
+    QTest::newRow( "Mercator" ) << Mercator;
+    QTest::newRow( "Gnomonic" ) << Gnomonic;
+}
+
+void SunShadingTest::testShading()
+{
+    QFETCH( Marble::Projection, projection );
+
+    const ViewportParams viewport( projection, 80 * DEG2RAD, 20 * DEG2RAD, 120, QSize( 403, 301 ) );
+    const QRgb color = qRgb( 200, 150, 100 );
+    QImage image = canvas( viewport.size(), color );
+
+    SunShading shading;
+    shading.setSunPosition( SunLon, SunLat );
+    shading.setTwilightZone( TwilightZone );
+    shading.shade( &image, 0, &viewport );
+
+    int night = 0;
+    int twilight = 0;
+    for ( int y = 0; y < image.height(); ++y ) {
+        for ( int x = 0; x < image.width(); ++x ) {
+            const int expectedWeight = weight( viewport, x, y, SunLon, SunLat, TwilightZone );
+            QVERIFY( qAbs( shading.brightness( x, y ) * 256 - expectedWeight ) <= 1 );
+
+            const QRgb pixel = image.pixel( x, y );
+            QCOMPARE( qAlpha( pixel ), 255 );
+            const qreal factor = 0.35 + 0.65 * expectedWeight / 256.0;
+            QVERIFY( qAbs( qRed( pixel ) - 200 * factor ) <= 4 );
+            QVERIFY( qAbs( qGreen( pixel ) - 150 * factor ) <= 4 );
+            QVERIFY( qAbs( qBlue( pixel ) - 100 * factor ) <= 4 );
+
+            night += expectedWeight == 0;
+            twilight += expectedWeight > 0 && expectedWeight < 256;
+        }
+    }
+
+    // the terminator is in sight
+    QVERIFY( night > 0 );
+    QVERIFY( twilight > 0 );
+}
+
+void SunShadingTest::testNightCanvas()
+{
+    const ViewportParams viewport( Spherical, 80 * DEG2RAD, 20 * DEG2RAD, 120, QSize( 400, 300 ) );
+    const QRgb day = qRgb( 200, 150, 100 );
+    const QRgb night = qRgb( 10, 20, 250 );
+    QImage image = canvas( viewport.size(), day );
+    const QImage nightImage = canvas( viewport.size(), night );
+
+    SunShading shading;
+    shading.setSunPosition( SunLon, SunLat );
+    shading.setTwilightZone( TwilightZone );
+    shading.shade( &image, &nightImage, &viewport );
+
+    for ( int y = 0; y < image.height(); ++y ) {
+        for ( int x = 0; x < image.width(); ++x ) {
+            const qreal brightness = shading.brightness( x, y );
+            if ( brightness == 1.0 ) {
+                QCOMPARE( image.pixel( x, y ), day );
+            } else if ( brightness == 0.0 ) {
+                QCOMPARE( image.pixel( x, y ), night );
+            } else {
+                QVERIFY( qAbs( qRed( image.pixel( x, y ) ) - ( 200 * brightness + 10 * ( 1 - brightness ) ) ) <= 2 );
+            }
+        }
+    }
+}
+
+void SunShadingTest::testSunMove()
+{
+    const ViewportParams viewport( Equirectangular, 0, 0, 200, QSize( 800, 600 ) );
+    const QRgb color = qRgb( 200, 150, 100 );
+
+    SunShading shading;
+    shading.setTwilightZone( TwilightZone );
+    QImage image = canvas( viewport.size(), color );
+    shading.setSunPosition( SunLon, SunLat );
+    shading.shade( &image, 0, &viewport );
+
+    // moving the sun reuses the pixel positions
+    image = canvas( viewport.size(), color );
+    shading.setSunPosition( SunLon + 0.1, SunLat - 0.05 );
+    shading.shade( &image, 0, &viewport );
+
+    SunShading fresh;
+    fresh.setTwilightZone( TwilightZone );
+    QImage expected = canvas( viewport.size(), color );
+    fresh.setSunPosition( SunLon + 0.1, SunLat - 0.05 );
+    fresh.shade( &expected, 0, &viewport );
+
+    QCOMPARE( image, expected );
+}
+
+}
+
+QTEST_MAIN( Marble::SunShadingTest )
+
+#include "SunShadingTest.moc"
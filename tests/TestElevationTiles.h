@@ -0,0 +1,132 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TESTELEVATIONTILES_H
+#define MARBLE_TESTELEVATIONTILES_H
+
+#include "GeoDataCoordinates.h"
+#include "MarbleDirs.h"
+#include "MarbleGlobal.h"
+#include "MarbleMath.h"
+
+#include <QDir>
+#include <QImage>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+
+#include <qmath.h>
+
+namespace Marble
+{
+
+/**
+ * Synthetic srtm2 tiles in the local Marble directory, so the elevation
+ * model finds its data without downloading anything.
+ */
+class TestElevationTiles
+{
+public:
+    // the srtm2 theme stores its data at level 9, with 2x1 tiles at level zero
+    enum { TileLevel = 9, NumTilesX = 2 << TileLevel, NumTilesY = 1 << TileLevel };
+
+    TestElevationTiles() :
+        m_tileWidth( 0 ),
+        m_tileHeight( 0 )
+    {}
+
+    /// takes the tile size from the level zero tile in the data path
+    bool init()
+    {
+        const QImage levelZeroTile( MarbleDirs::path( "maps/earth/srtm2/0/000000/000000_000000.png" ) );
+        m_tileWidth = levelZeroTile.width();
+        m_tileHeight = levelZeroTile.height();
+        return !levelZeroTile.isNull();
+    }
+
+    static qint16 elevation( int x, int y )
+    {
+        // blocks of 2x2 pixels without data, everything else is a slope with some negative heights
+        if ( x % 101 < 2 && y % 103 < 2 ) {
+            return qint16( invalidElevationData );
+        }
+        return qint16( ( x * 7 + y * 13 ) % 5000 - 400 );
+    }
+
+    GeoDataCoordinates coordinates( qreal textureX, qreal textureY ) const
+    {
+        const qreal lon = textureX * 360 / ( NumTilesX * m_tileWidth ) - 180;
+        const qreal lat = 90 - textureY * 180 / ( NumTilesY * m_tileHeight );
+        return GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
+    }
+
+    void textureCoordinates( const GeoDataCoordinates &coordinates, qreal &textureX, qreal &textureY ) const
+    {
+        textureX = ( 180 + coordinates.longitude( GeoDataCoordinates::Degree ) ) * NumTilesX * m_tileWidth / 360;
+        textureY = ( 90 - coordinates.latitude( GeoDataCoordinates::Degree ) ) * NumTilesY * m_tileHeight / 180;
+    }
+
+    /// a route of @p count points heading east through the Alps for 1000 km, wiggling across several rows of tiles
+    static QVector<GeoDataCoordinates> route( int count )
+    {
+        const qreal startLon = 5.0;
+        const qreal startLat = 47.2;
+        const qreal spanLon = 1000 / ( EARTH_RADIUS / 1000 * DEG2RAD * qCos( startLat * DEG2RAD ) );
+        QVector<GeoDataCoordinates> result;
+        result.reserve( count );
+        for ( int i = 0; i < count; ++i ) {
+            const qreal t = qreal( i ) / ( count - 1 );
+            result << GeoDataCoordinates( startLon + t * spanLon, startLat + 0.4 * qSin( 20 * t ), 0, GeoDataCoordinates::Degree );
+        }
+        return result;
+    }
+
+    /// writes every tile any of the four pixels around the @p coordinates falls into
+    bool write( const QVector<GeoDataCoordinates> &coordinates ) const
+    {
+        QSet<QPair<int, int> > tiles;
+        for ( const GeoDataCoordinates &point: coordinates ) {
+            qreal textureX;
+            qreal textureY;
+            textureCoordinates( point, textureX, textureY );
+            for ( int i = 0; i < 4; ++i ) {
+                const int x = static_cast<int>( textureX + ( i % 2 ) );
+                const int y = static_cast<int>( textureY + ( i / 2 ) );
+                tiles << qMakePair( x / m_tileWidth, y / m_tileHeight );
+            }
+        }
+
+        for ( const QPair<int, int> &tile: tiles ) {
+            QImage image( m_tileWidth, m_tileHeight, QImage::Format_RGB32 );
+            for ( int y = 0; y < m_tileHeight; ++y ) {
+                QRgb *line = reinterpret_cast<QRgb *>( image.scanLine( y ) );
+                for ( int x = 0; x < m_tileWidth; ++x ) {
+                    const qint16 value = elevation( tile.first * m_tileWidth + x, tile.second * m_tileHeight + y );
+                    line[x] = 0xff000000 | quint16( value );
+                }
+            }
+
+            const QString row = QString( "%1" ).arg( tile.second, 6, 10, QLatin1Char( '0' ) );
+            const QString column = QString( "%1" ).arg( tile.first, 6, 10, QLatin1Char( '0' ) );
+            const QString directory = MarbleDirs::localPath() + QString( "/maps/earth/srtm2/%1/%2" ).arg( TileLevel ).arg( row );
+            if ( !QDir().mkpath( directory ) || !image.save( QString( "%1/%2_%3.png" ).arg( directory ).arg( row ).arg( column ) ) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    int m_tileWidth;
+    int m_tileHeight;
+};
+
+}
+
+#endif
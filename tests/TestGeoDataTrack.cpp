@@ -38,6 +38,7 @@ private Q_SLOTS:
     void removeAfterTest();
     void extendedDataParseTest();
     void withoutTimeTest();
+    void unorderedTest();
 };
 
 void TestGeoDataTrack::initTestCase()
@@ -357,6 +358,50 @@ void TestGeoDataTrack::withoutTimeTest()
     delete dataDocument;
 }
 
+void TestGeoDataTrack::unorderedTest()
+{
+    const QDateTime start( QDate( 2017, 1, 1 ), QTime( 0, 0 ), Qt::UTC );
+    const GeoDataCoordinates coordinates1( 10.0, 50.0, 100.0, GeoDataCoordinates::Degree );
+    const GeoDataCoordinates coordinates2( 10.0, 51.0, 200.0, GeoDataCoordinates::Degree );
+    const GeoDataCoordinates coordinates3( 10.0, 52.0, 300.0, GeoDataCoordinates::Degree );
+
+    // KML tracks are taken as they come
+    GeoDataTrack track;
+    track.setInterpolate( true );
+    track.appendWhen( start.addSecs( 200 ) );
+    track.appendWhen( start );
+    track.appendWhen( start.addSecs( 100 ) );
+    track.appendCoordinates( coordinates3 );
+    track.appendCoordinates( coordinates1 );
+    track.appendCoordinates( coordinates2 );
+
+    QCOMPARE( track.coordinatesAt( start.addSecs( 100 ) ), coordinates2 );
+    QCOMPARE( track.coordinatesAt( start.addSecs( 50 ) ).altitude(), 150.0 );
+    QCOMPARE( track.coordinatesAt( start.addSecs( 150 ) ).latitude( GeoDataCoordinates::Degree ), 51.5 );
+    QCOMPARE( track.coordinatesAt( start.addSecs( 250 ) ), GeoDataCoordinates() );
+
+    // the same segment again, then one inserted into it
+    QCOMPARE( track.coordinatesAt( start.addSecs( 175 ) ).altitude(), 275.0 );
+    track.addPoint( start.addSecs( 180 ), coordinates1 );
+    QCOMPARE( track.coordinatesAt( start.addSecs( 175 ) ).altitude(), 200.0 - 100.0 * 75 / 80 );
+    QCOMPARE( track.size(), 4 );
+    QCOMPARE( track.whenList().at( 0 ), start.addSecs( 180 ) );
+    QCOMPARE( track.lineString()->size(), 4 );
+
+    // in-order points are appended
+    GeoDataTrack ordered;
+    ordered.addPoint( start.addSecs( 100 ), coordinates2 );
+    ordered.addPoint( start, coordinates1 );
+    QCOMPARE( ordered.lineString()->size(), 2 );
+    ordered.addPoint( start.addSecs( 200 ), coordinates3 );
+    ordered.addPoint( start.addSecs( 100 ), coordinates3 );
+    QCOMPARE( ordered.whenList(), QVector<QDateTime>() << start << start.addSecs( 100 ) << start.addSecs( 100 ) << start.addSecs( 200 ) );
+    QCOMPARE( ordered.coordinatesList(), QVector<GeoDataCoordinates>() << coordinates1 << coordinates2 << coordinates3 << coordinates3 );
+    QCOMPARE( ordered.lineString()->size(), 4 );
+    QCOMPARE( ordered.coordinatesAt( start.addSecs( 100 ) ), coordinates2 );
+    QCOMPARE( ordered.coordinatesAt( start.addSecs( 150 ) ), GeoDataCoordinates() );
+}
+
 QTEST_MAIN( TestGeoDataTrack )
 
 #include "TestGeoDataTrack.moc"
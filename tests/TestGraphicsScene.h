@@ -0,0 +1,198 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TESTGRAPHICSSCENE_H
+#define MARBLE_TESTGRAPHICSSCENE_H
+
+#include "GeoDataLatLonAltBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoGraphicsItem.h"
+#include "GeoGraphicsScene.h"
+#include "MarbleGlobal.h"
+#include "TileCoordsPyramid.h"
+#include "TileId.h"
+
+#include <QHash>
+#include <QRect>
+#include <QVector>
+
+#include <cstdlib>
+
+namespace Marble
+{
+
+class BoxGraphicsItem : public GeoGraphicsItem
+{
+public:
+    BoxGraphicsItem( const GeoDataFeature *feature, const GeoDataLatLonAltBox &box ) :
+        GeoGraphicsItem( feature ),
+        m_box( box )
+    {
+    }
+
+    const GeoDataLatLonAltBox &latLonAltBox() const override
+    {
+        return m_box;
+    }
+
+    void setLatLonAltBox( const GeoDataLatLonAltBox &box )
+    {
+        m_box = box;
+    }
+
+    void paint( GeoPainter *, const ViewportParams *, const QString &, int ) override
+    {
+    }
+
+private:
+    GeoDataLatLonAltBox m_box;
+};
+
+/**
+ * The hash of tiles GeoGraphicsScene used to store its items in, to compare
+ * the results and speed with.  The items are not owned.
+ */
+class TileHashScene
+{
+public:
+    void addItem( GeoGraphicsItem *item )
+    {
+        int zoomLevel;
+        qreal north, south, east, west;
+        item->latLonAltBox().boundaries( north, south, east, west );
+        for ( zoomLevel = item->minZoomLevel(); zoomLevel >= 0; zoomLevel-- ) {
+            if ( TileId::fromCoordinates( GeoDataCoordinates( west, north, 0 ), zoomLevel ) ==
+                 TileId::fromCoordinates( GeoDataCoordinates( east, south, 0 ), zoomLevel ) )
+                break;
+        }
+
+        const TileId key = TileId::fromCoordinates( GeoDataCoordinates( west, north, 0 ), zoomLevel );
+        m_tiledItems[key].insert( item->feature(), item );
+    }
+
+    QList<GeoGraphicsItem *> items( const GeoDataLatLonBox &box, int zoomLevel ) const
+    {
+        QList<GeoGraphicsItem *> result;
+        QRect rect;
+        qreal north, south, east, west;
+        box.boundaries( north, south, east, west );
+        TileId key;
+
+        key = TileId::fromCoordinates( GeoDataCoordinates( west, north, 0 ), zoomLevel );
+        rect.setLeft( key.x() );
+        rect.setTop( key.y() );
+
+        key = TileId::fromCoordinates( GeoDataCoordinates( east, south, 0 ), zoomLevel );
+        rect.setRight( key.x() );
+        rect.setBottom( key.y() );
+
+        TileCoordsPyramid pyramid( 0, zoomLevel );
+        pyramid.setBottomLevelCoords( rect );
+
+        for ( int level = pyramid.topLevel(); level <= pyramid.bottomLevel(); ++level ) {
+            QRect const coords = pyramid.coords( level );
+            int x1, y1, x2, y2;
+            coords.getCoords( &x1, &y1, &x2, &y2 );
+            for ( int x = x1; x <= x2; ++x ) {
+                bool const isBorderX = x == x1 || x == x2;
+                for ( int y = y1; y <= y2; ++y ) {
+                    bool const isBorder = isBorderX || y == y1 || y == y2;
+                    const TileId tileId = TileId( 0, level, x, y );
+                    for ( GeoGraphicsItem *object: m_tiledItems.value( tileId ) ) {
+                        if ( object->minZoomLevel() <= zoomLevel && object->visible() ) {
+                            if ( !isBorder || object->latLonAltBox().intersects( box ) ) {
+                                result.push_back( object );
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+private:
+    QHash<TileId, QHash<const GeoDataFeature *, GeoGraphicsItem *> > m_tiledItems;
+};
+
+/**
+ * 100,000 buildings, roads and areas in a city, as loaded from vector tiles,
+ * in a scene and in a hash of tiles, and views of a desktop window on them.
+ */
+class TestCity
+{
+public:
+    TestCity() :
+        m_scene( new GeoGraphicsScene )
+    {
+        qsrand( 42 );
+
+        const GeoDataLatLonBox city( 52.6, 52.4, 13.6, 13.2, GeoDataCoordinates::Degree );
+        for ( int i = 0; i < 100000; ++i ) {
+            const int kind = i % 10;
+            const qreal size = ( kind < 7 ? 0.0002 : kind < 9 ? 0.002 : 0.02 ) * DEG2RAD;
+            const qreal west = random( city.west(), city.east() );
+            const qreal south = random( city.south(), city.north() );
+            const GeoDataLatLonAltBox box( GeoDataLatLonBox( south + random( 0, size ), south,
+                                                             west + random( 0, size ), west ), 0, 0 );
+
+            GeoDataPlacemark *placemark = new GeoDataPlacemark;
+            GeoGraphicsItem *item = new BoxGraphicsItem( placemark, box );
+            item->setMinZoomLevel( kind < 7 ? 17 : kind < 9 ? 13 : 11 );
+            m_placemarks << placemark;
+            m_scene->addItem( item );
+            m_tileHashScene.addItem( item );
+        }
+
+        // at zoom level 17
+        for ( int i = 0; i < 100; ++i ) {
+            const qreal west = random( city.west(), city.east() - 0.02 * DEG2RAD );
+            const qreal south = random( city.south(), city.north() - 0.01 * DEG2RAD );
+            m_views << GeoDataLatLonBox( south + 0.01 * DEG2RAD, south, west + 0.02 * DEG2RAD, west );
+        }
+    }
+
+    ~TestCity()
+    {
+        delete m_scene;
+        qDeleteAll( m_placemarks );
+    }
+
+    GeoGraphicsScene *scene() const
+    {
+        return m_scene;
+    }
+
+    const TileHashScene &tileHashScene() const
+    {
+        return m_tileHashScene;
+    }
+
+    const QVector<GeoDataLatLonBox> &views() const
+    {
+        return m_views;
+    }
+
+private:
+    Q_DISABLE_COPY( TestCity )
+
+    static qreal random( qreal from, qreal to )
+    {
+        return from + ( to - from ) * qrand() / RAND_MAX;
+    }
+
+    QVector<GeoDataPlacemark *> m_placemarks;
+    GeoGraphicsScene *m_scene;
+    TileHashScene m_tileHashScene;
+    QVector<GeoDataLatLonBox> m_views;
+};
+
+}
+
+#endif
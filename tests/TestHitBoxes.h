@@ -0,0 +1,98 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TESTHITBOXES_H
+#define MARBLE_TESTHITBOXES_H
+
+#include "GeoDataLatLonBox.h"
+#include "MarbleGlobal.h"
+
+#include <QVector>
+
+#include <cstdlib>
+
+namespace Marble
+{
+
+/**
+ * 100,000 items in a city sized view, as seen when zoomed in on vector
+ * tiles, and small boxes around the mouse to pick them with.
+ */
+class TestHitBoxes
+{
+public:
+    TestHitBoxes()
+    {
+        qsrand( 42 );
+
+        m_view = GeoDataLatLonBox( 52.55, 52.45, 13.50, 13.30, GeoDataCoordinates::Degree );
+        const qreal itemSize = 0.0005 * DEG2RAD;
+        for ( int i = 0; i < 100000; ++i ) {
+            m_items << randomBox( m_view, itemSize );
+        }
+        // some large areas like parks and districts
+        for ( int i = 0; i < 50; ++i ) {
+            m_items << randomBox( m_view, 0.1 * DEG2RAD );
+        }
+
+        const qreal pickSize = 0.0003 * DEG2RAD;
+        for ( int i = 0; i < 1000; ++i ) {
+            m_picks << randomBox( m_view, pickSize );
+        }
+    }
+
+    const GeoDataLatLonBox &view() const
+    {
+        return m_view;
+    }
+
+    const QVector<GeoDataLatLonBox> &items() const
+    {
+        return m_items;
+    }
+
+    const QVector<GeoDataLatLonBox> &picks() const
+    {
+        return m_picks;
+    }
+
+    /// the indexes of all @p boxes intersecting @p area
+    static QVector<int> linearScan( const QVector<GeoDataLatLonBox> &boxes, const GeoDataLatLonBox &area )
+    {
+        QVector<int> result;
+        for ( int i = 0; i < boxes.size(); ++i ) {
+            if ( boxes[i].intersects( area ) ) {
+                result << i;
+            }
+        }
+        return result;
+    }
+
+private:
+    static qreal random( qreal from, qreal to )
+    {
+        return from + ( to - from ) * qrand() / RAND_MAX;
+    }
+
+    static GeoDataLatLonBox randomBox( const GeoDataLatLonBox &bounds, qreal maximumSize )
+    {
+        const qreal west = random( bounds.west(), bounds.east() );
+        const qreal south = random( bounds.south(), bounds.north() );
+        const qreal east = qMin( west + random( 0, maximumSize ), bounds.east() );
+        const qreal north = qMin( south + random( 0, maximumSize ), bounds.north() );
+        return GeoDataLatLonBox( north, south, east, west );
+    }
+
+    GeoDataLatLonBox m_view;
+    QVector<GeoDataLatLonBox> m_items;
+    QVector<GeoDataLatLonBox> m_picks;
+};
+
+}
+
+#endif
@@ -0,0 +1,320 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TESTOSMGRID_H
+#define MARBLE_TESTOSMGRID_H
+
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+#include <QtEndian>
+#include <QXmlStreamWriter>
+
+namespace Marble
+{
+
+// Minimal protobuf encoder for writing .osm.pbf test files
+class ProtobufWriter
+{
+public:
+    void varint( int field, quint64 value )
+    {
+        key( field, 0 );
+        appendVarint( value );
+    }
+
+    void sint( int field, qint64 value )
+    {
+        varint( field, zigzag( value ) );
+    }
+
+    void bytes( int field, const QByteArray &value )
+    {
+        key( field, 2 );
+        appendVarint( value.size() );
+        m_data += value;
+    }
+
+    void packed( int field, const QVector<qint64> &values, bool zigzagged )
+    {
+        ProtobufWriter content;
+        for ( qint64 value: values ) {
+            content.appendVarint( zigzagged ? zigzag( value ) : quint64( value ) );
+        }
+        bytes( field, content.data() );
+    }
+
+    QByteArray data() const { return m_data; }
+
+private:
+    static quint64 zigzag( qint64 value )
+    {
+        return ( quint64( value ) << 1 ) ^ quint64( value >> 63 );
+    }
+
+    void key( int field, int wireType )
+    {
+        appendVarint( ( quint64( field ) << 3 ) | wireType );
+    }
+
+    void appendVarint( quint64 value )
+    {
+        while ( value >= 0x80 ) {
+            m_data += char( ( value & 0x7f ) | 0x80 );
+            value >>= 7;
+        }
+        m_data += char( value );
+    }
+
+    QByteArray m_data;
+};
+
+/**
+ * A grid of nodes with some restaurants, a street along each row and a forest
+ * around all of them, written as .osm and .osm.pbf file.
+ */
+class OsmGrid
+{
+public:
+    static const int gridSize = 150;
+
+    static qint64 nodeId( int x, int y ) { return 1 + y * gridSize + x; }
+    static qint64 longitude( int x ) { return 130000000 + x * 1000; }
+    static qint64 latitude( int y ) { return 525000000 + y * 1000; }
+
+    static bool writeOsm( const QString &fileName );
+    static bool writePbf( const QString &fileName );
+
+private:
+    static void writeBlob( QFile &file, const QByteArray &type, const QByteArray &data, bool compressed );
+    static QByteArray stringTable( const QStringList &strings );
+};
+
+inline bool OsmGrid::writeOsm( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QFile::WriteOnly ) ) {
+        return false;
+    }
+
+    QXmlStreamWriter writer( &file );
+    writer.writeStartDocument();
+    writer.writeStartElement( "osm" );
+    writer.writeAttribute( "version", "0.6" );
+
+    for ( int y = 0; y < gridSize; ++y ) {
+        for ( int x = 0; x < gridSize; ++x ) {
+            const qint64 id = nodeId( x, y );
+            writer.writeStartElement( "node" );
+            writer.writeAttribute( "id", QString::number( id ) );
+            writer.writeAttribute( "lat", QString::number( latitude( y ) * 1.0e-7, 'f', 7 ) );
+            writer.writeAttribute( "lon", QString::number( longitude( x ) * 1.0e-7, 'f', 7 ) );
+            if ( id % 50 == 0 ) {
+                writer.writeStartElement( "tag" );
+                writer.writeAttribute( "k", "amenity" );
+                writer.writeAttribute( "v", "restaurant" );
+                writer.writeEndElement();
+                writer.writeStartElement( "tag" );
+                writer.writeAttribute( "k", "name" );
+                writer.writeAttribute( "v", QString( "Restaurant %1" ).arg( id ) );
+                writer.writeEndElement();
+            }
+            writer.writeEndElement();
+        }
+    }
+
+    for ( int y = 0; y < gridSize; ++y ) {
+        writer.writeStartElement( "way" );
+        writer.writeAttribute( "id", QString::number( y + 1 ) );
+        for ( int x = 0; x < gridSize; ++x ) {
+            writer.writeStartElement( "nd" );
+            writer.writeAttribute( "ref", QString::number( nodeId( x, y ) ) );
+            writer.writeEndElement();
+        }
+        writer.writeStartElement( "tag" );
+        writer.writeAttribute( "k", "highway" );
+        writer.writeAttribute( "v", "residential" );
+        writer.writeEndElement();
+        writer.writeStartElement( "tag" );
+        writer.writeAttribute( "k", "name" );
+        writer.writeAttribute( "v", QString( "Street %1" ).arg( y ) );
+        writer.writeEndElement();
+        writer.writeEndElement();
+    }
+
+    // the closed border of the grid, the outer ring of the forest
+    writer.writeStartElement( "way" );
+    writer.writeAttribute( "id", QString::number( gridSize + 1 ) );
+    const QList<qint64> border = QList<qint64>() << nodeId( 0, 0 ) << nodeId( gridSize - 1, 0 )
+                                                 << nodeId( gridSize - 1, gridSize - 1 ) << nodeId( 0, gridSize - 1 )
+                                                 << nodeId( 0, 0 );
+    for ( qint64 ref: border ) {
+        writer.writeStartElement( "nd" );
+        writer.writeAttribute( "ref", QString::number( ref ) );
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+
+    writer.writeStartElement( "relation" );
+    writer.writeAttribute( "id", "1" );
+    writer.writeStartElement( "member" );
+    writer.writeAttribute( "type", "way" );
+    writer.writeAttribute( "ref", QString::number( gridSize + 1 ) );
+    writer.writeAttribute( "role", "outer" );
+    writer.writeEndElement();
+    writer.writeStartElement( "tag" );
+    writer.writeAttribute( "k", "type" );
+    writer.writeAttribute( "v", "multipolygon" );
+    writer.writeEndElement();
+    writer.writeStartElement( "tag" );
+    writer.writeAttribute( "k", "landuse" );
+    writer.writeAttribute( "v", "forest" );
+    writer.writeEndElement();
+    writer.writeEndElement();
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+    return true;
+}
+
+inline QByteArray OsmGrid::stringTable( const QStringList &strings )
+{
+    ProtobufWriter table;
+    table.bytes( 1, QByteArray() ); // index 0 delimits the dense node tags
+    for ( const QString &string: strings ) {
+        table.bytes( 1, string.toUtf8() );
+    }
+    return table.data();
+}
+
+inline void OsmGrid::writeBlob( QFile &file, const QByteArray &type, const QByteArray &data, bool compressed )
+{
+    ProtobufWriter blob;
+    if ( compressed ) {
+        blob.varint( 2, data.size() );
+        blob.bytes( 3, qCompress( data ).mid( 4 ) ); // without the size prefix of qCompress()
+    } else {
+        blob.bytes( 1, data );
+    }
+
+    ProtobufWriter header;
+    header.bytes( 1, type );
+    header.varint( 3, blob.data().size() );
+
+    uchar size[4];
+    qToBigEndian<quint32>( header.data().size(), size );
+    file.write( reinterpret_cast<const char *>( size ), 4 );
+    file.write( header.data() );
+    file.write( blob.data().data(), blob.data().size() );
+}
+
+inline bool OsmGrid::writePbf( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QFile::WriteOnly ) ) {
+        return false;
+    }
+
+    ProtobufWriter osmHeader;
+    osmHeader.bytes( 4, "OsmSchema-V0.6" );
+    osmHeader.bytes( 4, "DenseNodes" );
+    writeBlob( file, "OSMHeader", osmHeader.data(), true );
+
+    // one block of dense nodes per row, every other one stored uncompressed,
+    // with a granularity of 100 nanodegrees and an offset
+    const qint64 granularity = 100;
+    const qint64 lonOffset = 1000;
+    for ( int y = 0; y < gridSize; ++y ) {
+        QVector<qint64> ids, lats, lons, keysValues;
+        QStringList strings = QStringList() << "amenity" << "restaurant" << "name";
+        qint64 lastId = 0, lastLat = 0, lastLon = 0;
+        for ( int x = 0; x < gridSize; ++x ) {
+            const qint64 id = nodeId( x, y );
+            const qint64 lat = latitude( y ) * 100 / granularity;
+            const qint64 lon = ( longitude( x ) * 100 - lonOffset ) / granularity;
+            ids << id - lastId;
+            lats << lat - lastLat;
+            lons << lon - lastLon;
+            lastId = id;
+            lastLat = lat;
+            lastLon = lon;
+            if ( id % 50 == 0 ) {
+                strings << QString( "Restaurant %1" ).arg( id );
+                keysValues << 1 << 2 << 3 << strings.size();
+            }
+            keysValues << 0;
+        }
+
+        ProtobufWriter dense;
+        dense.packed( 1, ids, true );
+        dense.packed( 8, lats, true );
+        dense.packed( 9, lons, true );
+        dense.packed( 10, keysValues, false );
+        ProtobufWriter group;
+        group.bytes( 2, dense.data() );
+        ProtobufWriter block;
+        block.bytes( 1, stringTable( strings ) );
+        block.bytes( 2, group.data() );
+        block.varint( 17, granularity );
+        block.varint( 20, lonOffset );
+        writeBlob( file, "OSMData", block.data(), y % 2 == 0 );
+    }
+
+    // ways and the relation in a single block
+    QStringList strings = QStringList() << "highway" << "residential" << "name" << "type" << "multipolygon"
+                                        << "landuse" << "forest" << "outer";
+    ProtobufWriter group;
+    for ( int y = 0; y < gridSize; ++y ) {
+        strings << QString( "Street %1" ).arg( y );
+        QVector<qint64> refs;
+        qint64 last = 0;
+        for ( int x = 0; x < gridSize; ++x ) {
+            refs << nodeId( x, y ) - last;
+            last = nodeId( x, y );
+        }
+        ProtobufWriter way;
+        way.varint( 1, y + 1 );
+        way.packed( 2, QVector<qint64>() << 1 << 3, false );
+        way.packed( 3, QVector<qint64>() << 2 << strings.size(), false );
+        way.packed( 8, refs, true );
+        group.bytes( 3, way.data() );
+    }
+
+    const QVector<qint64> border = QVector<qint64>() << nodeId( 0, 0 ) << nodeId( gridSize - 1, 0 )
+                                                     << nodeId( gridSize - 1, gridSize - 1 ) << nodeId( 0, gridSize - 1 )
+                                                     << nodeId( 0, 0 );
+    QVector<qint64> refs;
+    qint64 last = 0;
+    for ( qint64 ref: border ) {
+        refs << ref - last;
+        last = ref;
+    }
+    ProtobufWriter way;
+    way.varint( 1, gridSize + 1 );
+    way.packed( 8, refs, true );
+    group.bytes( 3, way.data() );
+
+    ProtobufWriter relation;
+    relation.varint( 1, 1 );
+    relation.packed( 2, QVector<qint64>() << 4 << 6, false );
+    relation.packed( 3, QVector<qint64>() << 5 << 7, false );
+    relation.packed( 8, QVector<qint64>() << 8, false );
+    relation.packed( 9, QVector<qint64>() << gridSize + 1, true );
+    relation.packed( 10, QVector<qint64>() << 1, false ); // way
+    group.bytes( 4, relation.data() );
+
+    ProtobufWriter block;
+    block.bytes( 1, stringTable( strings ) );
+    block.bytes( 2, group.data() );
+    writeBlob( file, "OSMData", block.data(), true );
+    return true;
+}
+
+}
+
+#endif
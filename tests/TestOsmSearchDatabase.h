@@ -0,0 +1,172 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TESTOSMSEARCHDATABASE_H
+#define MARBLE_TESTOSMSEARCHDATABASE_H
+
+#include "GeoDataCoordinates.h"
+
+#include <QDebug>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+namespace Marble
+{
+
+/**
+ * An address database like the ones written by osm-addresses, with a few
+ * known names and 200000 generated placemarks all over Germany.
+ */
+class TestOsmSearchDatabase
+{
+public:
+    // values of OsmPlacemark::OsmCategory, which is internal to the plugin
+    enum Category { Street = 0, Address = 6, Restaurant = 16 };
+
+    TestOsmSearchDatabase() :
+        m_hasIndexes( false )
+    {}
+
+    /// writes the database to @p fileName, keeping it open as @p connectionName
+    bool write( const QString &fileName, const QString &connectionName )
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase( "QSQLITE", connectionName );
+        database.setDatabaseName( fileName );
+        if ( !database.open() ) {
+            return false;
+        }
+
+        // same schema as written by osm-addresses
+        QSqlQuery query( database );
+        bool ok = query.exec( "CREATE TABLE placemarks ( regionId INTEGER, nameId INTEGER, number VARCHAR(8),"
+                              " category INTEGER, lon FLOAT(8), lat FLOAT(8) )" );
+        ok &= query.exec( "CREATE TABLE names ( id INTEGER PRIMARY KEY, name VARCHAR(50) )" );
+        ok &= query.exec( "CREATE TABLE regions ( id INTEGER PRIMARY KEY, parent INTEGER NOT NULL,"
+                          " lft INTEGER NOT NULL, rgt INTEGER NOT NULL, name VARCHAR(50), lon FLOAT(8), lat FLOAT(8) )" );
+        ok &= query.exec( "CREATE VIEW places AS SELECT placemarks.regionId AS region, names.name AS name,"
+                          " placemarks.number AS number, placemarks.category AS category, placemarks.lon AS lon,"
+                          " placemarks.lat AS lat FROM names INNER JOIN placemarks ON names.id=placemarks.nameId" );
+        ok &= query.exec( "BEGIN TRANSACTION" );
+
+        // Germany with two of its states as a nested set
+        ok &= query.exec( "INSERT INTO regions VALUES (1, 0, 1, 6, 'Deutschland', 10.4, 51.1)" );
+        ok &= query.exec( "INSERT INTO regions VALUES (2, 1, 2, 3, 'Bayern', 11.5, 48.1)" );
+        ok &= query.exec( "INSERT INTO regions VALUES (3, 1, 4, 5, 'Berlin', 13.4, 52.5)" );
+
+        // ids 1 to 3 are the names the tests look for, followed by street names like "Lindenbergweg"
+        QStringList names = QStringList() << "Hauptstraße" << "Hauptplatz" << "Ristorante Roma";
+        const QStringList first = QStringList() << "Linden" << "Birken" << "Eichen" << "Ahorn" << "Tannen"
+                                                << "Buchen" << "Rosen" << "Wald" << "See" << "Mühl"
+                                                << "Kirch" << "Schul" << "Garten" << "Wiesen" << "Feld"
+                                                << "Brunnen" << "Burg" << "Markt" << "Sonnen" << "Lerchen";
+        const QStringList second = QStringList() << "berg" << "tal" << "feld" << "hof" << "bach"
+                                                 << "au" << "heim" << "dorf" << "brück" << "stein";
+        const QStringList third = QStringList() << "straße" << "weg" << "gasse" << "allee" << "ring"
+                                                << "platz" << "pfad" << "damm" << "ufer" << "steig";
+        for ( const QString &a: first ) {
+            for ( const QString &b: second ) {
+                for ( const QString &c: third ) {
+                    names << a + b + c;
+                }
+            }
+        }
+
+        QSqlQuery insertName( database );
+        ok &= insertName.prepare( "INSERT INTO names (id, name) VALUES (?, ?)" );
+        for ( int i = 0; i < names.size(); ++i ) {
+            insertName.addBindValue( i + 1 );
+            insertName.addBindValue( names.at( i ) );
+            ok &= insertName.exec();
+        }
+        const int streetNames = names.size() - 3;
+
+        QSqlQuery insertPlacemark( database );
+        ok &= insertPlacemark.prepare( "INSERT INTO placemarks (regionId, nameId, number, category, lon, lat) VALUES (?, ?, ?, ?, ?, ?)" );
+        const auto insert = [&]( int region, int nameId, const QVariant &number, int category, qreal lon, qreal lat ) {
+            insertPlacemark.addBindValue( region );
+            insertPlacemark.addBindValue( nameId );
+            insertPlacemark.addBindValue( number );
+            insertPlacemark.addBindValue( category );
+            insertPlacemark.addBindValue( lon );
+            insertPlacemark.addBindValue( lat );
+            return insertPlacemark.exec();
+        };
+
+        const QVariant noNumber( QVariant::String );
+        ok &= insert( 3, 1, noNumber, Street, 13.3777, 52.5163 );
+        ok &= insert( 3, 1, "12", Address, 13.3781, 52.5165 );
+        ok &= insert( 2, 1, noNumber, Street, 11.5755, 48.1374 );
+        ok &= insert( 2, 2, noNumber, Street, 11.5820, 48.1351 );
+
+        // streets, addresses and restaurants all over the country in a reproducible order
+        quint32 random = 42;
+        const auto next = [&random]() {
+            random = random * 1664525 + 1013904223;
+            return ( random >> 8 ) / qreal( 1 << 24 );
+        };
+        for ( int i = 0; i < 200000; ++i ) {
+            const qreal lon = 6.0 + 9.0 * next();
+            const qreal lat = 47.5 + 7.0 * next();
+            const int region = lon > 13.0 && lon < 13.8 && lat > 52.3 && lat < 52.7 ? 3 : ( lat < 50.0 ? 2 : 1 );
+            const int nameId = 4 + i % streetNames;
+            switch ( i % 4 ) {
+            case 0:
+                ok &= insert( region, nameId, noNumber, Street, lon, lat );
+                break;
+            case 1:
+            case 2:
+                ok &= insert( region, nameId, QString::number( 1 + i % 150 ), Address, lon, lat );
+                break;
+            default:
+                ok &= insert( region, 3, noNumber, Restaurant, lon, lat );
+                m_restaurants << GeoDataCoordinates( lon, lat, 0.0, GeoDataCoordinates::Degree );
+            }
+        }
+
+        ok &= query.exec( "END TRANSACTION" );
+        ok &= query.exec( "CREATE INDEX namesIndex ON names(name)" );
+        ok &= query.exec( "CREATE INDEX placemarksIndex ON placemarks(regionId,nameId,category)" );
+        ok &= query.exec( "CREATE INDEX regionsIndex ON regions(name,parent,lft,rgt)" );
+        ok &= query.exec( "CREATE INDEX placemarksNameIndex ON placemarks(nameId)" );
+
+        // optional, like in osm-addresses
+        m_hasIndexes = query.exec( "CREATE VIRTUAL TABLE namesFts USING fts5(name, content='names', content_rowid='id', tokenize='trigram')" ) &&
+                       query.exec( "INSERT INTO namesFts(rowid, name) SELECT id, name FROM names" ) &&
+                       query.exec( "CREATE VIRTUAL TABLE placemarksRtree USING rtree(id, minLon, maxLon, minLat, maxLat)" ) &&
+                       query.exec( "INSERT INTO placemarksRtree SELECT rowid, lon, lon, lat, lat FROM placemarks" );
+        if ( !m_hasIndexes ) {
+            qWarning() << "SQLite lacks FTS5 trigram or R*-tree support, testing without indexes:" << query.lastError().text();
+        }
+
+        return ok;
+    }
+
+    /// whether SQLite could create the full text and R*-tree indexes
+    bool hasIndexes() const
+    {
+        return m_hasIndexes;
+    }
+
+    /// all restaurants in the database
+    const QVector<GeoDataCoordinates> &restaurants() const
+    {
+        return m_restaurants;
+    }
+
+private:
+    bool m_hasIndexes;
+    QVector<GeoDataCoordinates> m_restaurants;
+};
+
+}
+
+#endif
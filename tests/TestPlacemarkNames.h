@@ -0,0 +1,77 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TESTPLACEMARKNAMES_H
+#define MARBLE_TESTPLACEMARKNAMES_H
+
+#include "GeoDataDocument.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleModel.h"
+
+#include <QAbstractItemModel>
+#include <QStringList>
+
+namespace Marble
+{
+
+/**
+ * Placemarks for looking up names in a model, and the model scan the
+ * placemark name index replaced.
+ */
+class TestPlacemarkNames
+{
+public:
+    static GeoDataPlacemark *placemark( const QString &name, qreal lon, qreal lat )
+    {
+        GeoDataPlacemark *placemark = new GeoDataPlacemark( name );
+        placemark->setCoordinate( lon, lat, 0.0, GeoDataCoordinates::Degree );
+        return placemark;
+    }
+
+    /// 200000 names like "Sankt Laberg 17" all over the world in a reproducible order
+    static GeoDataDocument *largeDocument()
+    {
+        const QStringList first = QStringList() << "Sankt" << "Alt" << "Neu" << "Ober" << "Unter" << "Klein" << "Groß" << "Bad";
+        const QStringList syllables = QStringList() << "la" << "ber" << "san" << "to" << "mi" << "ro" << "ka" << "sel"
+                                                    << "dor" << "fen" << "wa" << "li" << "nu" << "ha" << "gen" << "stein";
+        quint32 random = 42;
+        const auto next = [&random]( int range ) {
+            random = random * 1664525 + 1013904223;
+            return int( ( random >> 8 ) % range );
+        };
+
+        GeoDataDocument *document = new GeoDataDocument;
+        for ( int i = 0; i < 200000; ++i ) {
+            QString name = first.at( next( first.size() ) ) + QLatin1Char( ' ' );
+            const int length = 2 + next( 3 );
+            for ( int j = 0; j < length; ++j ) {
+                name += syllables.at( next( syllables.size() ) );
+            }
+            name[name.indexOf( QLatin1Char( ' ' ) ) + 1] = name[name.indexOf( QLatin1Char( ' ' ) ) + 1].toUpper();
+            name += QLatin1Char( ' ' ) + QString::number( next( 100 ) );
+            document->append( placemark( name, -180.0 + 360.0 * next( 100000 ) / 100000, -80.0 + 160.0 * next( 100000 ) / 100000 ) );
+        }
+        return document;
+    }
+
+    /// what LocalDatabaseRunner did before the index existed
+    static QStringList scan( const MarbleModel &model, const QString &term )
+    {
+        const QAbstractItemModel *placemarkModel = model.placemarkModel();
+        const QModelIndexList indexes = placemarkModel->match( placemarkModel->index( 0, 0 ), Qt::DisplayRole, term, -1, Qt::MatchStartsWith );
+        QStringList result;
+        for ( const QModelIndex &index: indexes ) {
+            result << index.data( Qt::DisplayRole ).toString();
+        }
+        return result;
+    }
+};
+
+}
+
+#endif
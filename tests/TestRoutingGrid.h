@@ -0,0 +1,187 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TESTROUTINGGRID_H
+#define MARBLE_TESTROUTINGGRID_H
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataDocument.h"
+#include "RoutingGraph.h"
+#include "RoutingGraphBuilder.h"
+#include "RoutingRunner.h"
+#include "RoutingRunnerPlugin.h"
+#include "routing/RouteRequest.h"
+
+#include <QFile>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QVector>
+#include <QXmlStreamWriter>
+#include <qmath.h>
+
+namespace Marble
+{
+
+/**
+ * A grid of residential streets with a motorway south of it and a roundabout
+ * east of it, and the routing graphs of the local-osm-routing plugin for it.
+ */
+class TestRoutingGrid
+{
+public:
+    enum { Rows = 20, Columns = 20 };
+
+    static GeoDataCoordinates node( int row, int column )
+    {
+        return GeoDataCoordinates( 11.0 + column * 0.0015, 48.0 + row * 0.001, 0.0, GeoDataCoordinates::Degree );
+    }
+
+    static bool writeOsm( const QString &fileName )
+    {
+        QFile file( fileName );
+        if ( !file.open( QIODevice::WriteOnly ) ) {
+            return false;
+        }
+
+        QXmlStreamWriter writer( &file );
+        writer.writeStartDocument();
+        writer.writeStartElement( "osm" );
+        writer.writeAttribute( "version", "0.6" );
+
+        const auto writeNode = [&writer]( qint64 id, const GeoDataCoordinates &coordinates ) {
+            writer.writeStartElement( "node" );
+            writer.writeAttribute( "id", QString::number( id ) );
+            writer.writeAttribute( "lat", QString::number( coordinates.latitude( GeoDataCoordinates::Degree ), 'f', 7 ) );
+            writer.writeAttribute( "lon", QString::number( coordinates.longitude( GeoDataCoordinates::Degree ), 'f', 7 ) );
+            writer.writeEndElement();
+        };
+        const auto writeWay = [&writer]( qint64 id, const QVector<qint64> &nodes, const QStringList &tags ) {
+            writer.writeStartElement( "way" );
+            writer.writeAttribute( "id", QString::number( id ) );
+            for ( qint64 node: nodes ) {
+                writer.writeStartElement( "nd" );
+                writer.writeAttribute( "ref", QString::number( node ) );
+                writer.writeEndElement();
+            }
+            for ( int i = 0; i + 1 < tags.size(); i += 2 ) {
+                writer.writeStartElement( "tag" );
+                writer.writeAttribute( "k", tags[i] );
+                writer.writeAttribute( "v", tags[i + 1] );
+                writer.writeEndElement();
+            }
+            writer.writeEndElement();
+        };
+        const auto gridId = []( int row, int column ) {
+            return qint64( 1 + row * Columns + column );
+        };
+
+        for ( int row = 0; row < Rows; ++row ) {
+            for ( int column = 0; column < Columns; ++column ) {
+                writeNode( gridId( row, column ), node( row, column ) );
+            }
+        }
+
+        // a motorway south of the grid from its south west to its south east corner
+        writeNode( 1001, GeoDataCoordinates( 11.0, 47.995, 0.0, GeoDataCoordinates::Degree ) );
+        writeNode( 1002, GeoDataCoordinates( 11.0 + ( Columns - 1 ) * 0.0015, 47.995, 0.0, GeoDataCoordinates::Degree ) );
+
+        // a roundabout east of the grid, its nodes counterclockwise from the east, and its arms
+        const GeoDataCoordinates east = node( Rows / 2, Columns - 1 );
+        const qreal centerLon = east.longitude( GeoDataCoordinates::Degree ) + 0.003;
+        const qreal centerLat = east.latitude( GeoDataCoordinates::Degree );
+        for ( int i = 0; i < 8; ++i ) {
+            const qreal angle = i * M_PI / 4;
+            writeNode( 2001 + i, GeoDataCoordinates( centerLon + 0.00075 * qCos( angle ), centerLat + 0.0005 * qSin( angle ),
+                                                     0.0, GeoDataCoordinates::Degree ) );
+        }
+        for ( int i = 1; i < 4; ++i ) {
+            // south, east and north, the west arm leads to the grid
+            const qreal angle = ( i + 2 ) * M_PI / 2;
+            writeNode( 2100 + i, GeoDataCoordinates( centerLon + 0.0025 * qCos( angle ), centerLat + 0.0015 * qSin( angle ),
+                                                     0.0, GeoDataCoordinates::Degree ) );
+        }
+
+        qint64 wayId = 1;
+        for ( int row = 0; row < Rows; ++row ) {
+            QVector<qint64> nodes;
+            for ( int column = 0; column < Columns; ++column ) {
+                nodes << gridId( row, column );
+            }
+            QStringList tags = QStringList() << "highway" << "residential" << "name" << QString( "Row %1" ).arg( row );
+            if ( row == 5 ) {
+                tags << "oneway" << "yes";
+            }
+            writeWay( wayId++, nodes, tags );
+        }
+        for ( int column = 0; column < Columns; ++column ) {
+            QVector<qint64> nodes;
+            for ( int row = 0; row < Rows; ++row ) {
+                nodes << gridId( row, column );
+            }
+            writeWay( wayId++, nodes, QStringList() << "highway" << "residential" << "name" << QString( "Column %1" ).arg( column ) );
+        }
+
+        writeWay( wayId++, QVector<qint64>() << gridId( 0, 0 ) << 1001 << 1002 << gridId( 0, Columns - 1 ),
+                  QStringList() << "highway" << "motorway" << "ref" << "A 1" );
+        writeWay( wayId++, QVector<qint64>() << 2001 << 2002 << 2003 << 2004 << 2005 << 2006 << 2007 << 2008 << 2001,
+                  QStringList() << "highway" << "primary" << "junction" << "roundabout" );
+        writeWay( wayId++, QVector<qint64>() << gridId( Rows / 2, Columns - 1 ) << 2005,
+                  QStringList() << "highway" << "residential" << "name" << "West Street" );
+        writeWay( wayId++, QVector<qint64>() << 2007 << 2101,
+                  QStringList() << "highway" << "residential" << "name" << "South Street" );
+        writeWay( wayId++, QVector<qint64>() << 2001 << 2102,
+                  QStringList() << "highway" << "residential" << "name" << "East Street" );
+        writeWay( wayId++, QVector<qint64>() << 2003 << 2103,
+                  QStringList() << "highway" << "residential" << "name" << "North Street" );
+
+        writer.writeEndElement();
+        writer.writeEndDocument();
+        return !writer.hasError();
+    }
+
+    /// builds the graphs of all transport types from @p document like the osm-routing-graph tool does
+    static bool writeGraphs( const GeoDataDocument *document, const QString &graphDirectory )
+    {
+        for ( int i = RoutingProfile::Motorcar; i <= RoutingProfile::Pedestrian; ++i ) {
+            const RoutingProfile::TransportType transportType = RoutingProfile::TransportType( i );
+            RoutingGraphBuilder builder( transportType );
+            builder.addDocument( document );
+            const QString fileName = QString( "%1/grid-%2.ch" ).arg( graphDirectory, RoutingGraph::transportName( transportType ) );
+            if ( builder.nodeCount() < Rows * Columns || !builder.write( fileName ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static GeoDataDocument *route( const RoutingRunnerPlugin *plugin, RoutingProfile::TransportType transportType,
+                                   const GeoDataCoordinates &from, const GeoDataCoordinates &to )
+    {
+        RouteRequest request;
+        request.append( from );
+        request.append( to );
+        RoutingProfile profile;
+        profile.setTransportType( transportType );
+        profile.pluginSettings()[plugin->nameId()] = plugin->templateSettings( transportType == RoutingProfile::Motorcar ? RoutingProfilesModel::CarFastestTemplate :
+                                                                               transportType == RoutingProfile::Bicycle ? RoutingProfilesModel::BicycleTemplate :
+                                                                                                                          RoutingProfilesModel::PedestrianTemplate );
+        request.setRoutingProfile( profile );
+
+        QScopedPointer<RoutingRunner> runner( plugin->newRunner() );
+        GeoDataDocument *result = 0;
+        QObject::connect( runner.data(), &RoutingRunner::routeCalculated, [&result]( GeoDataDocument *document ) {
+            result = document;
+        } );
+        runner->retrieveRoute( &request );
+        return result;
+    }
+};
+
+}
+
+#endif
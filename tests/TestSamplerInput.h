@@ -0,0 +1,66 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TESTSAMPLERINPUT_H
+#define MARBLE_TESTSAMPLERINPUT_H
+
+#include <QImage>
+#include <QVector>
+
+#include <cstdlib>
+
+namespace Marble
+{
+
+/**
+ * Random textures and sample positions for BilinearSampler, reproducible
+ * through qsrand().
+ */
+class TestSamplerInput
+{
+public:
+    static QImage randomImage( int width, int height, QImage::Format format )
+    {
+        QImage image( width, height, format );
+        for ( int y = 0; y < height; ++y ) {
+            QRgb *const line = reinterpret_cast<QRgb *>( image.scanLine( y ) );
+            for ( int x = 0; x < width; ++x ) {
+                line[x] = ( uint( qrand() ) << 16 ) ^ uint( qrand() );
+            }
+        }
+
+        return image;
+    }
+
+    static void randomPositions( const QImage &image, int count, QVector<qreal> &x, QVector<qreal> &y )
+    {
+        x.resize( count );
+        y.resize( count );
+
+        for ( int i = 0; i < count; ++i ) {
+            x[i] = ( image.width()  - 1 ) * ( qrand() / qreal( RAND_MAX ) );
+            y[i] = ( image.height() - 1 ) * ( qrand() / qreal( RAND_MAX ) );
+
+            // Mix in positions on pixel centers and at the right and bottom
+            // border, which take the special paths of the scalar code.
+            if ( i % 7 == 0 ) {
+                x[i] = int( x[i] );
+            }
+            if ( i % 13 == 0 ) {
+                x[i] = image.width() - 1 + 0.25;
+            }
+            if ( i % 17 == 0 ) {
+                y[i] = image.height() - 1 + 0.75;
+            }
+        }
+    }
+};
+
+}
+
+#endif
@@ -28,6 +28,8 @@ SqlWriter::SqlWriter( const QString &filename, QObject* parent ) :
         return;
     }
 
+    execQuery( "DROP TABLE IF EXISTS namesFts" );
+    execQuery( "DROP TABLE IF EXISTS placemarksRtree" );
     execQuery( "DROP TABLE IF EXISTS placemarks;" );
     execQuery( "CREATE TABLE placemarks ("
                " regionId INTEGER,"
@@ -70,6 +72,17 @@ SqlWriter::~SqlWriter()
     execQuery( "CREATE INDEX namesIndex ON names(name)" );
     execQuery( "CREATE INDEX placemarksIndex ON placemarks(regionId,nameId,category)" );
     execQuery( "CREATE INDEX regionsIndex ON regions(name,parent,lft,rgt)" );
+    execQuery( "CREATE INDEX placemarksNameIndex ON placemarks(nameId)" );
+
+    // Trigram index for wildcard searches, which would scan all names otherwise
+    if ( execOptionalQuery( "CREATE VIRTUAL TABLE namesFts USING fts5(name, content='names', content_rowid='id', tokenize='trigram')" ) ) {
+        execOptionalQuery( "INSERT INTO namesFts(rowid, name) SELECT id, name FROM names" );
+    }
+
+    // Spatial index for searches near the current position
+    if ( execOptionalQuery( "CREATE VIRTUAL TABLE placemarksRtree USING rtree(id, minLon, maxLon, minLat, maxLat)" ) ) {
+        execOptionalQuery( "INSERT INTO placemarksRtree SELECT rowid, lon, lon, lat, lat FROM placemarks" );
+    }
 }
 
 void SqlWriter::addOsmRegion( const OsmRegion &region )
@@ -128,6 +141,17 @@ void SqlWriter::execQuery( const QString &query ) const
     }
 }
 
+bool SqlWriter::execOptionalQuery( const QString &query ) const
+{
+    QSqlQuery sqlQuery( query );
+    if ( sqlQuery.lastError().isValid() ) {
+        qWarning() << "Skipping optional index, the SQLite library does not support the query" << query;
+        qWarning() << "SQL error: " << sqlQuery.lastError();
+        return false;
+    }
+    return true;
+}
+
 void SqlWriter::execQuery( QSqlQuery &query ) const
 {
     query.exec();
@@ -38,6 +38,9 @@ private:
 
     void execQuery( const QString &query ) const;
 
+    /** Like execQuery(), but a failure is not an error. Returns whether the query succeeded. */
+    bool execOptionalQuery( const QString &query ) const;
+
     QHash<QString, int> m_placemarks;
 
     QPair<int, QString> m_lastPlacemark;
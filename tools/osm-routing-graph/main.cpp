@@ -0,0 +1,116 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+// Creates the routing graphs of the local-osm-routing plugin from OSM files
+
+#include "RoutingGraph.h"
+#include "RoutingGraphBuilder.h"
+
+#include <GeoDataDocument.h>
+#include <MarbleDirs.h>
+#include <MarbleModel.h>
+#include <ParsingRunnerManager.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+using namespace Marble;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setApplicationName("osm-routing-graph");
+    QCoreApplication::setApplicationVersion("0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Create offline routing graphs from OpenStreetMap files");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("input", "The .osm, .o5m or .osm.pbf files to read the roads from");
+
+    QString const graphDirectory = MarbleDirs::localPath() + QLatin1String("/maps/earth/local-osm-routing");
+    parser.addOptions({
+                      {{"o", "output"}, "Directory to write the graphs to.", "directory", graphDirectory},
+                      {{"n", "name"}, "Base name of the graphs, the first input file name by default.", "name"},
+                      {{"t", "transport"}, "Transport types to create graphs for, comma separated. One of motorcar, bicycle and pedestrian or all of them by default.", "transport", "motorcar,bicycle,pedestrian"}
+                      });
+    parser.process(app);
+
+    const QStringList inputs = parser.positionalArguments();
+    if (inputs.isEmpty()) {
+        parser.showHelp();
+        return 0;
+    }
+
+    QList<RoutingProfile::TransportType> transportTypes;
+    for (const QString &transport: parser.value("transport").split(',', QString::SkipEmptyParts)) {
+        bool found = false;
+        for (int i = RoutingProfile::Motorcar; i <= RoutingProfile::Pedestrian; ++i) {
+            if (transport.trimmed() == RoutingGraph::transportName(RoutingProfile::TransportType(i))) {
+                transportTypes << RoutingProfile::TransportType(i);
+                found = true;
+            }
+        }
+        if (!found) {
+            qWarning() << "Unknown transport type" << transport;
+            parser.showHelp(1);
+        }
+    }
+
+    QString const outputDirectory = parser.value("output");
+    QDir().mkpath(outputDirectory);
+    if (!QFileInfo(outputDirectory).isWritable()) {
+        qWarning() << "Cannot write to output directory" << outputDirectory;
+        parser.showHelp(1);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // the input files are parsed once for all transport types
+    MarbleModel model;
+    ParsingRunnerManager manager(model.pluginManager());
+    QList<QSharedPointer<GeoDataDocument> > documents;
+    for (const QString &input: inputs) {
+        GeoDataDocument *document = manager.openFile(input, DocumentRole::MapDocument, 24 * 60 * 60 * 1000);
+        if (!document) {
+            qWarning() << "Cannot parse" << input;
+            return 1;
+        }
+        documents << QSharedPointer<GeoDataDocument>(document);
+    }
+    qDebug() << "Parsed" << inputs.size() << "files in" << timer.elapsed() << "ms";
+
+    QString name = parser.value("name");
+    if (name.isEmpty()) {
+        name = QFileInfo(inputs.first()).fileName().section('.', 0, 0);
+    }
+
+    for (RoutingProfile::TransportType transportType: transportTypes) {
+        RoutingGraphBuilder builder(transportType);
+        for (const QSharedPointer<GeoDataDocument> &document: documents) {
+            builder.addDocument(document.data());
+        }
+
+        QString const transport = RoutingGraph::transportName(transportType);
+        QString const fileName = QDir(outputDirectory).filePath(QString("%1-%2.ch").arg(name, transport));
+        if (!builder.write(fileName)) {
+            qWarning() << "Cannot write" << fileName;
+            return 1;
+        }
+        qDebug() << "Wrote" << fileName << "with" << builder.nodeCount() << "nodes and"
+                 << builder.edgeCount() << "edges after" << timer.elapsed() << "ms";
+    }
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "OsmTileSplitter.h"
+
+#include <GeoDataDocument.h>
+#include <GeoDataLatLonAltBox.h>
+#include <GeoDataLinearRing.h>
+#include <GeoDataPlacemark.h>
+#include <GeoDataPoint.h>
+#include <GeoDataPolygon.h>
+#include <GeoDataRelation.h>
+#include <GeoDataTypes.h>
+
+namespace Marble {
+
+OsmTileSplitter::OsmTileSplitter(const GeoDataDocument* document, int zoomLevel) :
+    m_zoomLevel(zoomLevel)
+{
+    QVector<const GeoDataRelation*> relations;
+    RelationParents parents;
+    for (auto feature: document->featureList()) {
+        if (feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType) {
+            for (auto tile: tilesOf(static_cast<const GeoDataPlacemark*>(feature))) {
+                m_tiles[tile] << feature;
+            }
+        } else if (feature->nodeType() == GeoDataTypes::GeoDataRelationType) {
+            auto const relation = static_cast<const GeoDataRelation*>(feature);
+            relations << relation;
+            for (auto member: relation->members()) {
+                if (member->nodeType() == GeoDataTypes::GeoDataRelationType) {
+                    parents[static_cast<const GeoDataRelation*>(member)] << relation;
+                }
+            }
+        }
+    }
+
+    RelationTiles relationTiles;
+    for (auto relation: relations) {
+        tilesOf(relation, relationTiles);
+    }
+
+    for (auto relation: relations) {
+        TileSet tiles = relationTiles.value(relation);
+        if (tiles.isEmpty()) {
+            QSet<const GeoDataRelation*> visited;
+            tiles = parentTilesOf(relation, parents, relationTiles, visited);
+        }
+        for (auto tile: tiles) {
+            m_tiles[tile] << relation;
+        }
+    }
+}
+
+GeoDataDocument *OsmTileSplitter::tile(int x, int y) const
+{
+    GeoDataDocument* document = new GeoDataDocument;
+    document->setName(QString("%1/%2/%3").arg(m_zoomLevel).arg(x).arg(y));
+    for (auto feature: m_tiles.value(key(x, y))) {
+        document->append(feature->clone());
+    }
+    return document;
+}
+
+quint64 OsmTileSplitter::key(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+void OsmTileSplitter::addTiles(const GeoDataLatLonBox &box, TileSet &tiles) const
+{
+    QRect const rect = m_tileProjection.tileIndexes(box, m_zoomLevel);
+    for (int x = rect.left(); x <= rect.right(); ++x) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            tiles << key(x, y);
+        }
+    }
+}
+
+void OsmTileSplitter::addTiles(const GeoDataLineString &lineString, TileSet &tiles) const
+{
+    // The tiles of each segment's bounding box, which is close to the tiles the way
+    // passes through. The bounding box of the whole way is far too large for long
+    // diagonal ways like motorways or rivers.
+    if (lineString.size() == 1) {
+        addTiles(lineString.first(), lineString.first(), tiles);
+        return;
+    }
+
+    for (int i = 1, n = lineString.size(); i < n; ++i) {
+        addTiles(lineString.at(i-1), lineString.at(i), tiles);
+    }
+
+    if (lineString.isClosed() && lineString.size() > 2) {
+        addTiles(lineString.last(), lineString.first(), tiles);
+    }
+}
+
+void OsmTileSplitter::addTiles(const GeoDataCoordinates &a, const GeoDataCoordinates &b, TileSet &tiles) const
+{
+    GeoDataLatLonBox const box(qMax(a.latitude(), b.latitude()), qMin(a.latitude(), b.latitude()),
+                               qMax(a.longitude(), b.longitude()), qMin(a.longitude(), b.longitude()));
+    addTiles(box, tiles);
+}
+
+OsmTileSplitter::TileSet OsmTileSplitter::tilesOf(const GeoDataPlacemark* placemark) const
+{
+    TileSet tiles;
+    auto const geometry = placemark->geometry();
+    if (!geometry) {
+        return tiles;
+    }
+
+    if (geometry->nodeType() == GeoDataTypes::GeoDataLineStringType ||
+        geometry->nodeType() == GeoDataTypes::GeoDataLinearRingType) {
+        addTiles(*static_cast<const GeoDataLineString*>(geometry), tiles);
+    } else if (geometry->nodeType() == GeoDataTypes::GeoDataPolygonType) {
+        // Areas cover the tiles inside them as well, even if no node lies within
+        auto const polygon = static_cast<const GeoDataPolygon*>(geometry);
+        addTiles(polygon->outerBoundary().latLonAltBox(), tiles);
+    } else if (geometry->nodeType() == GeoDataTypes::GeoDataPointType) {
+        // Nodes, which are the only placed members of some relations
+        auto const &coordinates = static_cast<const GeoDataPoint*>(geometry)->coordinates();
+        addTiles(coordinates, coordinates, tiles);
+    } else {
+        addTiles(geometry->latLonAltBox(), tiles);
+    }
+    return tiles;
+}
+
+OsmTileSplitter::TileSet OsmTileSplitter::tilesOf(const GeoDataRelation* relation, RelationTiles &relationTiles) const
+{
+    auto const iter = relationTiles.constFind(relation);
+    if (iter != relationTiles.constEnd()) {
+        return *iter;
+    }
+
+    // Relations may contain each other, the entry ends the recursion on cycles
+    relationTiles[relation] = TileSet();
+    TileSet tiles;
+    for (auto member: relation->members()) {
+        if (member->nodeType() == GeoDataTypes::GeoDataPlacemarkType) {
+            tiles |= tilesOf(static_cast<const GeoDataPlacemark*>(member));
+        } else if (member->nodeType() == GeoDataTypes::GeoDataRelationType) {
+            tiles |= tilesOf(static_cast<const GeoDataRelation*>(member), relationTiles);
+        }
+    }
+    relationTiles[relation] = tiles;
+    return tiles;
+}
+
+OsmTileSplitter::TileSet OsmTileSplitter::parentTilesOf(const GeoDataRelation* relation, const RelationParents &parents,
+                                                        const RelationTiles &relationTiles, QSet<const GeoDataRelation*> &visited)
+{
+    TileSet tiles;
+    for (auto parent: parents.value(relation)) {
+        if (visited.contains(parent)) {
+            continue;
+        }
+        visited << parent;
+
+        TileSet const parentTiles = relationTiles.value(parent);
+        tiles |= parentTiles.isEmpty() ? parentTilesOf(parent, parents, relationTiles, visited) : parentTiles;
+    }
+    return tiles;
+}
+
+}
@@ -0,0 +1,70 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_OSMTILESPLITTER_H
+#define MARBLE_OSMTILESPLITTER_H
+
+#include <GeoSceneMercatorTileProjection.h>
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+namespace Marble {
+
+class GeoDataCoordinates;
+class GeoDataDocument;
+class GeoDataFeature;
+class GeoDataLatLonBox;
+class GeoDataLineString;
+class GeoDataPlacemark;
+class GeoDataRelation;
+
+/**
+ * Distributes the OSM features of a document to all tiles of a zoom level in one pass.
+ *
+ * Unlike the VectorClipper, features are not cut at the tile border: a way goes to each
+ * tile one of its segments touches, an area to each tile its outer boundary overlaps and
+ * a relation to each tile one of its members went to. Member relations pass on their
+ * tiles, relations without any placed member (e.g. of nodes dropped by the parser) go to
+ * the tiles of the relations containing them. Each tile thereby holds complete ways, like
+ * the tiles created by osmconvert --complete-ways --complex-ways did.
+ */
+class OsmTileSplitter
+{
+public:
+    OsmTileSplitter(const GeoDataDocument* document, int zoomLevel);
+
+    /**
+     * Returns a new document with copies of all features of the tile, which is empty
+     * for tiles without features. The caller takes ownership.
+     */
+    GeoDataDocument* tile(int x, int y) const;
+
+private:
+    typedef QSet<quint64> TileSet;
+    typedef QHash<const GeoDataRelation*, TileSet> RelationTiles;
+    typedef QHash<const GeoDataRelation*, QVector<const GeoDataRelation*> > RelationParents;
+
+    static quint64 key(int x, int y);
+    void addTiles(const GeoDataLatLonBox &box, TileSet &tiles) const;
+    void addTiles(const GeoDataLineString &lineString, TileSet &tiles) const;
+    void addTiles(const GeoDataCoordinates &a, const GeoDataCoordinates &b, TileSet &tiles) const;
+    TileSet tilesOf(const GeoDataPlacemark* placemark) const;
+    TileSet tilesOf(const GeoDataRelation* relation, RelationTiles &relationTiles) const;
+    static TileSet parentTilesOf(const GeoDataRelation* relation, const RelationParents &parents,
+                                 const RelationTiles &relationTiles, QSet<const GeoDataRelation*> &visited);
+
+    int const m_zoomLevel;
+    GeoSceneMercatorTileProjection const m_tileProjection;
+    QHash<quint64, QVector<const GeoDataFeature*> > m_tiles;
+};
+
+}
+
+#endif
@@ -16,11 +16,14 @@
 #include "PeakAnalyzer.h"
 #include "TileCoordsPyramid.h"
 #include "StyleBuilder.h"
+#include "OsmTileSplitter.h"
 
 #include <QFileInfo>
 #include <QDebug>
 #include <QProcess>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QScopedPointer>
 #include <QUrl>
 #include <QNetworkRequest>
 #include <QNetworkReply>
@@ -33,8 +36,6 @@ using namespace std;
 
 namespace Marble {
 
-QMap<int, TagsFilter::Tags> TileDirectory::m_tags;
-
 TileDirectory::TileDirectory(TileType tileType, const QString &cacheDir, ParsingRunnerManager &manager, QString const &extension, int maxZoomLevel) :
     m_cacheDir(cacheDir),
     m_baseDir(),
@@ -46,7 +47,8 @@ TileDirectory::TileDirectory(TileType tileType, const QString &cacheDir, Parsing
     m_extension(extension),
     m_tileType(tileType),
     m_landmassFile("land-polygons-split-4326.zip"),
-    m_maxZoomLevel(maxZoomLevel)
+    m_maxZoomLevel(maxZoomLevel),
+    m_useOsmconvert(false)
 {
     if (m_tileType == Landmass) {
         m_zoomLevel = 7;
@@ -128,6 +130,11 @@ void TileDirectory::setInputFile(const QString &filename)
     }
 }
 
+void TileDirectory::setUseOsmconvert(bool useOsmconvert)
+{
+    m_useOsmconvert = useOsmconvert;
+}
+
 GeoDataDocument* TileDirectory::clip(int zoomLevel, int tileX, int tileY)
 {
     QSharedPointer<GeoDataDocument> oldMap = m_landmass;
@@ -158,29 +165,35 @@ QSharedPointer<GeoDataDocument> TileDirectory::open(const QString &filename, Par
     return result;
 }
 
-TagsFilter::Tags TileDirectory::tagsFilteredIn(int zoomLevel) const
+QMap<int, TagsFilter::Tags> TileDirectory::tagsByZoomLevel()
 {
-    if (m_tags.isEmpty()) {
-        QSet<GeoDataPlacemark::GeoDataVisualCategory> categories;
-        for (int i=GeoDataPlacemark::PlaceCity; i<GeoDataPlacemark::LastIndex; ++i) {
-            categories << GeoDataPlacemark::GeoDataVisualCategory(i);
-        }
+    QMap<int, TagsFilter::Tags> tags;
+    QSet<GeoDataPlacemark::GeoDataVisualCategory> categories;
+    for (int i=GeoDataPlacemark::PlaceCity; i<GeoDataPlacemark::LastIndex; ++i) {
+        categories << GeoDataPlacemark::GeoDataVisualCategory(i);
+    }
 
-        auto const tagMap = StyleBuilder::osmTagMapping();
-        for (auto category: categories) {
-            for (auto iter=tagMap.begin(), end=tagMap.end(); iter != end; ++iter) {
-                if (iter.value() == category) {
-                    int zoomLevel = StyleBuilder::minimumZoomLevel(category);
-                    if (zoomLevel < 17) {
-                        m_tags[zoomLevel] << iter.key();
-                    }
+    auto const tagMap = StyleBuilder::osmTagMapping();
+    for (auto category: categories) {
+        for (auto iter=tagMap.begin(), end=tagMap.end(); iter != end; ++iter) {
+            if (iter.value() == category) {
+                int zoomLevel = StyleBuilder::minimumZoomLevel(category);
+                if (zoomLevel < 17) {
+                    tags[zoomLevel] << iter.key();
                 }
             }
         }
     }
+    return tags;
+}
+
+TagsFilter::Tags TileDirectory::tagsFilteredIn(int zoomLevel) const
+{
+    // initialized once, also when several threads clip tiles at the same time
+    static QMap<int, TagsFilter::Tags> const tags = tagsByZoomLevel();
 
     TagsFilter::Tags result;
-    for (auto iter = m_tags.begin(), end = m_tags.end(); iter != end && iter.key() <= zoomLevel+1; ++iter) {
+    for (auto iter = tags.begin(), end = tags.end(); iter != end && iter.key() <= zoomLevel+1; ++iter) {
         result << iter.value();
     }
     return result;
@@ -328,6 +341,82 @@ void TileDirectory::createTiles() const
 }
 
 void TileDirectory::createOsmTiles() const
+{
+    QVector<TileId> tiles;
+    TileIterator iter(m_boundingBox, m_zoomLevel);
+    for(auto const &tileId: iter) {
+        tiles << TileId(0, m_zoomLevel, tileId.x(), tileId.y());
+    }
+
+    bool hasAllTiles = true;
+    for (auto const &tileId: tiles) {
+        auto const outputFile = osmFileFor(tileId);
+        if (!QFileInfo(outputFile).exists()) {
+            hasAllTiles = false;
+            break;
+        }
+    }
+
+    if (!hasAllTiles) {
+        QElapsedTimer timer;
+        timer.start();
+        qint64 bytesRead = 0;
+        qint64 bytesWritten = 0;
+        if (m_useOsmconvert) {
+            createOsmTilesWithOsmconvert(bytesRead, bytesWritten);
+        } else {
+            splitOsmTiles(tiles, bytesRead, bytesWritten);
+        }
+
+        printProgress(1.0);
+        cout << "  osm cache tiles complete." << string(20, ' ') << endl;
+        cout << "  " << tiles.size() << " osm cache tiles created in " << timer.elapsed() / 1000.0 << " s, ";
+        cout << std::fixed << std::setprecision(1) << bytesRead / 1000000.0 << " MB read, ";
+        cout << bytesWritten / 1000000.0 << " MB written." << endl;
+        return;
+    }
+
+    printProgress(1.0);
+    cout << "  osm cache tiles complete." << string(20, ' ') << endl;
+}
+
+void TileDirectory::splitOsmTiles(const QVector<TileId> &tiles, qint64 &bytesRead, qint64 &bytesWritten) const
+{
+    // The input is parsed once and its features are assigned to all tiles at the same time
+    cout << " Reading " << m_inputFile.toStdString() << string(20, ' ') << '\r';
+    cout.flush();
+    auto const map = open(m_inputFile, m_manager);
+    if (!map) {
+        qCritical() << "Failed to open" << m_inputFile << "to create the osm cache tiles.";
+        return;
+    }
+    bytesRead += QFileInfo(m_inputFile).size();
+
+    OsmTileSplitter const splitter(map.data(), m_zoomLevel);
+    qint64 count = 0;
+    for (auto const &tileId: tiles) {
+        ++count;
+        QString const outputFile = osmFileFor(tileId);
+        if (QFileInfo(outputFile).exists()) {
+            continue;
+        }
+
+        printProgress(count / double(tiles.size()));
+        cout << " Creating osm cache tile " << count << "/" << tiles.size() << " (";
+        cout << tileId.zoomLevel() << "/" << tileId.x() << "/" << tileId.y() << ')' << string(20, ' ') << '\r';
+        cout.flush();
+
+        QDir().mkpath(QFileInfo(outputFile).absolutePath());
+        QScopedPointer<GeoDataDocument> tile(splitter.tile(tileId.x(), tileId.y()));
+        if (GeoDataDocumentWriter::write(outputFile, *tile)) {
+            bytesWritten += QFileInfo(outputFile).size();
+        } else {
+            qWarning() << "Failed to write tile" << outputFile;
+        }
+    }
+}
+
+void TileDirectory::createOsmTilesWithOsmconvert(qint64 &bytesRead, qint64 &bytesWritten) const
 {
     const GeoSceneMercatorTileProjection tileProjection;
     const QRect rect = tileProjection.tileIndexes(m_boundingBox, m_zoomLevel);
@@ -348,54 +437,45 @@ void TileDirectory::createOsmTiles() const
         }
     }
 
-    bool hasAllTiles = true;
-    for (auto const &tileId: tileLevels[m_zoomLevel]) {
-        auto const outputFile = osmFileFor(tileId);
-        if (!QFileInfo(outputFile).exists()) {
-            hasAllTiles = false;
-            break;
-        }
-    }
-
     bool first = true;
-    if (!hasAllTiles) {
-        qint64 count = 0;
-        for (auto const &tiles: tileLevels) {
-            for (auto const &tileId: tiles) {
-                ++count;
-                QString const inputFile = first ? m_inputFile : QString("%1/osm/%2/%3/%4.o5m").
-                                                  arg(m_cacheDir).arg(tileId.zoomLevel()-1).arg(tileId.x()>>1).arg(tileId.y()>>1);
-                QString const outputFile = osmFileFor(tileId);
-                if (QFileInfo(outputFile).exists()) {
-                    continue;
-                }
+    qint64 count = 0;
+    for (auto const &tiles: tileLevels) {
+        for (auto const &tileId: tiles) {
+            ++count;
+            QString const inputFile = first ? m_inputFile : QString("%1/osm/%2/%3/%4.o5m").
+                                              arg(m_cacheDir).arg(tileId.zoomLevel()-1).arg(tileId.x()>>1).arg(tileId.y()>>1);
+            QString const outputFile = osmFileFor(tileId);
+            if (QFileInfo(outputFile).exists()) {
+                continue;
+            }
 
-                printProgress(count / double(maxCount));
-                cout << " Creating osm cache tile " << count << "/" << maxCount << " (";
-                cout << tileId.zoomLevel() << "/" << tileId.x() << "/" << tileId.y() << ')' << string(20, ' ') << '\r';
-                cout.flush();
-
-                QDir().mkpath(QFileInfo(outputFile).absolutePath());
-                QString const output = QString("-o=%1").arg(outputFile);
-
-                const GeoDataLatLonBox tileBoundary = m_tileProjection.geoCoordinates(tileId.zoomLevel(), tileId.x(), tileId.y());
-
-                double const minLon = tileBoundary.west(GeoDataCoordinates::Degree);
-                double const maxLon = tileBoundary.east(GeoDataCoordinates::Degree);
-                double const maxLat = tileBoundary.north(GeoDataCoordinates::Degree);
-                double const minLat = tileBoundary.south(GeoDataCoordinates::Degree);
-                QString const bbox = QString("-b=%1,%2,%3,%4").arg(minLon).arg(minLat).arg(maxLon).arg(maxLat);
-                QProcess osmconvert;
-                osmconvert.start("osmconvert", QStringList() << "--drop-author" << "--drop-version"
-                                 << "--complete-ways" << "--complex-ways" << bbox << output << inputFile);
-                osmconvert.waitForFinished(10*60*1000);
-                if (osmconvert.exitCode() != 0) {
-                    qWarning() << osmconvert.readAllStandardError();
-                    qWarning() << "osmconvert failed: " << osmconvert.errorString();
-                }
+            printProgress(count / double(maxCount));
+            cout << " Creating osm cache tile " << count << "/" << maxCount << " (";
+            cout << tileId.zoomLevel() << "/" << tileId.x() << "/" << tileId.y() << ')' << string(20, ' ') << '\r';
+            cout.flush();
+
+            QDir().mkpath(QFileInfo(outputFile).absolutePath());
+            QString const output = QString("-o=%1").arg(outputFile);
+
+            const GeoDataLatLonBox tileBoundary = m_tileProjection.geoCoordinates(tileId.zoomLevel(), tileId.x(), tileId.y());
+
+            double const minLon = tileBoundary.west(GeoDataCoordinates::Degree);
+            double const maxLon = tileBoundary.east(GeoDataCoordinates::Degree);
+            double const maxLat = tileBoundary.north(GeoDataCoordinates::Degree);
+            double const minLat = tileBoundary.south(GeoDataCoordinates::Degree);
+            QString const bbox = QString("-b=%1,%2,%3,%4").arg(minLon).arg(minLat).arg(maxLon).arg(maxLat);
+            QProcess osmconvert;
+            osmconvert.start("osmconvert", QStringList() << "--drop-author" << "--drop-version"
+                             << "--complete-ways" << "--complex-ways" << bbox << output << inputFile);
+            osmconvert.waitForFinished(10*60*1000);
+            if (osmconvert.exitCode() != 0) {
+                qWarning() << osmconvert.readAllStandardError();
+                qWarning() << "osmconvert failed: " << osmconvert.errorString();
             }
-            first = false;
+            bytesRead += QFileInfo(inputFile).size();
+            bytesWritten += QFileInfo(outputFile).size();
         }
+        first = false;
     }
 
     tileLevels.remove(m_zoomLevel);
@@ -404,10 +484,6 @@ void TileDirectory::createOsmTiles() const
             QFile::remove(osmFileFor(tileId));
         }
     }
-
-    printProgress(1.0);
-    cout << "  osm cache tiles complete." << string(20, ' ') << endl;
-
 }
 
 int TileDirectory::innerNodes(const TileId &tile) const
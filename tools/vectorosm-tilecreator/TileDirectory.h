@@ -61,6 +61,12 @@ public:
     QSharedPointer<GeoDataDocument> load(int zoomLevel, int tileX, int tileY);
     void setInputFile(const QString &filename);
 
+    /**
+     * Create the osm cache tiles by running osmconvert for each tile of each level,
+     * instead of splitting the input in one pass. Slower, kept for comparison.
+     */
+    void setUseOsmconvert(bool useOsmconvert);
+
     TileId tileFor(int zoomLevel, int tileX, int tileY) const;
     GeoDataDocument *clip(int zoomLevel, int tileX, int tileY);
     QString name() const;
@@ -81,10 +87,13 @@ private Q_SLOTS:
     void handleFinishedDownload(const QString &filename, const QString &id);
 
 private:
+    static QMap<int, TagsFilter::Tags> tagsByZoomLevel();
     TagsFilter::Tags tagsFilteredIn(int zoomLevel) const;
     void setTagZoomLevel(int zoomLevel);
     void download(const QString &url, const QString &target);
     QString osmFileFor(const TileId &tileId) const;
+    void splitOsmTiles(const QVector<TileId> &tiles, qint64 &bytesRead, qint64 &bytesWritten) const;
+    void createOsmTilesWithOsmconvert(qint64 &bytesRead, qint64 &bytesWritten) const;
 
     QString m_cacheDir;
     QString m_baseDir;
@@ -106,7 +115,7 @@ private:
     QString m_landmassFile;
     QSharedPointer<Download> m_download;
     int m_maxZoomLevel;
-    static QMap<int, TagsFilter::Tags> m_tags;
+    bool m_useOsmconvert;
 };
 
 }
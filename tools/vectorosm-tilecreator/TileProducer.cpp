@@ -0,0 +1,323 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "TileProducer.h"
+
+#include "NodeReducer.h"
+#include "TagsFilter.h"
+#include "WayConcatenator.h"
+
+#include <GeoDataDocumentWriter.h>
+#include <GeoDataPlacemark.h>
+#include <GeoDataTypes.h>
+#include <OsmObjectManager.h>
+#include <OsmPlacemarkData.h>
+
+#include <QBuffer>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace Marble {
+
+namespace {
+
+void registerIds(const OsmPlacemarkData &osmData)
+{
+    OsmObjectManager::registerId(osmData.id());
+    for (auto iter = osmData.nodeReferencesBegin(), end = osmData.nodeReferencesEnd(); iter != end; ++iter) {
+        registerIds(iter.value());
+    }
+    for (auto iter = osmData.memberReferencesBegin(), end = osmData.memberReferencesEnd(); iter != end; ++iter) {
+        registerIds(iter.value());
+    }
+}
+
+qint64 renumberedId(qint64 id, QHash<qint64, qint64> &ids)
+{
+    if (id >= 0) {
+        return id;
+    }
+    auto iter = ids.constFind(id);
+    if (iter == ids.constEnd()) {
+        iter = ids.insert(id, OsmObjectManager::nextId());
+    }
+    return iter.value();
+}
+
+void renumberIds(OsmPlacemarkData &osmData, QHash<qint64, qint64> &ids)
+{
+    osmData.setId(renumberedId(osmData.id(), ids));
+    for (auto &node: osmData.nodeReferences()) {
+        renumberIds(node, ids);
+    }
+    for (auto &member: osmData.memberReferences()) {
+        renumberIds(member, ids);
+    }
+
+    QHash<qint64, QString> relations;
+    for (auto iter = osmData.relationReferencesBegin(), end = osmData.relationReferencesEnd(); iter != end; ++iter) {
+        relations[iter.key()] = iter.value();
+    }
+    for (auto iter = relations.constBegin(), end = relations.constEnd(); iter != end; ++iter) {
+        osmData.removeRelation(iter.key());
+    }
+    for (auto iter = relations.constBegin(), end = relations.constEnd(); iter != end; ++iter) {
+        osmData.addRelation(renumberedId(iter.key(), ids), iter.value());
+    }
+}
+
+}
+
+TileProducer::TileProducer(const PluginManager *pluginManager, const Settings &settings) :
+    m_settings(settings),
+    m_manager(pluginManager),
+    m_mapTiles(TileDirectory::OpenStreetMap, settings.regionDirectory, m_manager, settings.extension, settings.maxZoomLevel),
+    m_landmass(TileDirectory::Landmass, settings.cacheDirectory, m_manager, settings.extension, settings.maxZoomLevel)
+{
+    // nothing to do
+}
+
+TileProducer::Tile TileProducer::produce(const TileId &tileId, bool boundaryTile)
+{
+    // ids of new objects start over in each tile, so they don't depend on the tiles before
+    OsmObjectManager::beginLocalIds();
+
+    Tile result;
+    result.tileId = tileId;
+    result.status = Tile::Sea;
+    result.nodeReduction = 0.0;
+    result.originalWays = 0;
+    result.mergedWays = 0;
+
+    int const zoomLevel = tileId.zoomLevel();
+    typedef QSharedPointer<GeoDataDocument> GeoDocPtr;
+    GeoDocPtr tile2 = GeoDocPtr(m_landmass.clip(zoomLevel, tileId.x(), tileId.y()));
+    if (tile2 && tile2->size() > 0) {
+        GeoDocPtr tile1 = GeoDocPtr(m_mapTiles.clip(zoomLevel, tileId.x(), tileId.y()));
+        if (!tile1) {
+            result.status = Tile::Failed;
+            result.name = tile2->name();
+        } else {
+            TagsFilter::removeAnnotationTags(tile1.data());
+            if (zoomLevel < 17) {
+                WayConcatenator concatenator(tile1.data());
+                result.originalWays = concatenator.originalWays();
+                result.mergedWays = concatenator.mergedWays();
+            }
+            NodeReducer nodeReducer(tile1.data(), tileId);
+            result.nodeReduction = nodeReducer.removedNodes() / qMax(1.0, double(nodeReducer.remainingNodes() + nodeReducer.removedNodes()));
+        }
+
+        if (tile1 && tile1->size() > 0) {
+            GeoDocPtr combined = GeoDocPtr(mergeDocuments(tile1.data(), tile2.data()));
+
+            if (m_settings.writeBoundaries && boundaryTile) {
+                writeBoundaryTile(tile1.data(), tileId);
+                if (m_settings.mergeTiles) {
+                    combined = mergeBoundaryTiles(tile2, tileId);
+                }
+            }
+
+            result.name = combined->name();
+            QBuffer buffer(&result.data);
+            buffer.open(QBuffer::WriteOnly);
+            result.status = GeoDataDocumentWriter::write(&buffer, *combined, m_settings.extension) ? Tile::Created : Tile::Failed;
+        } else if (tile1) {
+            result.status = Tile::Empty;
+            result.name = tile1->name();
+        }
+    } else if (tile2) {
+        result.name = tile2->name();
+    }
+
+    OsmObjectManager::endLocalIds();
+    return result;
+}
+
+GeoDataDocument* TileProducer::mergeDocuments(GeoDataDocument* map1, GeoDataDocument* map2)
+{
+    GeoDataDocument* mergedMap = new GeoDataDocument(*map1);
+
+    OsmPlacemarkData marbleLand;
+    marbleLand.addTag("marble_land","landmass");
+    for (auto placemark: map2->placemarkList()) {
+        GeoDataPlacemark* land = new GeoDataPlacemark(*placemark);
+        if(land->geometry()->nodeType() == GeoDataTypes::GeoDataPolygonType) {
+            land->setOsmData(marbleLand);
+        }
+        registerIds(land->osmData());
+        mergedMap->append(land);
+    }
+
+    return mergedMap;
+}
+
+void TileProducer::writeBoundaryTile(GeoDataDocument* tile, const TileId &tileId)
+{
+    QString const outputDir = QString("%1/boundaries/%2/%3/%4").arg(m_settings.cacheDirectory).arg(m_settings.region).arg(tileId.zoomLevel()).arg(tileId.x());
+    QString const outputFile = QString("%1/%2.%3").arg(outputDir).arg(tileId.y()).arg(m_settings.extension);
+    QDir().mkpath(outputDir);
+    GeoDataDocumentWriter::write(outputFile, *tile);
+}
+
+QSharedPointer<GeoDataDocument> TileProducer::mergeBoundaryTiles(const QSharedPointer<GeoDataDocument> &background, const TileId &tileId)
+{
+    GeoDataDocument* mergedMap = new GeoDataDocument;
+    OsmPlacemarkData marbleLand;
+    marbleLand.addTag("marble_land","landmass");
+    for (auto placemark: background->placemarkList()) {
+        GeoDataPlacemark* land = new GeoDataPlacemark(*placemark);
+        if(land->geometry()->nodeType() == GeoDataTypes::GeoDataPolygonType) {
+            land->setOsmData(marbleLand);
+        }
+        registerIds(land->osmData());
+        mergedMap->append(land);
+    }
+
+    // Each boundary tile numbers its new objects from -1 on. They get fresh ids below all
+    // ids of the merged tile, shared nodes of one boundary tile keep sharing their id
+
+    QString const boundaryDir = QString("%1/boundaries").arg(m_settings.cacheDirectory);
+    for(auto const &dir: QDir(boundaryDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QString const file = QString("%1/%2/%3/%4/%5.%6").arg(boundaryDir).arg(dir).arg(tileId.zoomLevel()).arg(tileId.x()).arg(tileId.y()).arg(m_settings.extension);
+        if (QFileInfo(file).exists()) {
+            auto tile = TileDirectory::open(file, m_manager);
+            if (tile) {
+                QHash<qint64, qint64> ids;
+                for (auto placemark: tile->placemarkList()) {
+                    GeoDataPlacemark* boundary = placemark->clone();
+                    renumberIds(boundary->osmData(), ids);
+                    mergedMap->append(boundary);
+                }
+            }
+        }
+    }
+
+    return QSharedPointer<GeoDataDocument>(mergedMap);
+}
+
+class TilePipeline::WorkerThread : public QThread
+{
+public:
+    explicit WorkerThread(TilePipeline *pipeline) :
+        m_pipeline(pipeline)
+    {
+        // nothing to do
+    }
+
+protected:
+    void run() override
+    {
+        m_pipeline->work();
+    }
+
+private:
+    TilePipeline *const m_pipeline;
+};
+
+TilePipeline::TilePipeline(const PluginManager *pluginManager, const TileProducer::Settings &settings, int threadCount) :
+    m_pluginManager(pluginManager),
+    m_settings(settings),
+    m_threadCount(qMax(1, threadCount)),
+    m_nextGroup(0),
+    m_remainingTiles(0),
+    m_canceled(false)
+{
+    // nothing to do
+}
+
+TilePipeline::~TilePipeline()
+{
+    cancel();
+}
+
+void TilePipeline::start(const QVector<Group> &groups)
+{
+    Q_ASSERT(m_threads.isEmpty());
+    m_groups = groups;
+    for (auto const &group: m_groups) {
+        m_remainingTiles += group.size();
+    }
+
+    for (int i = 0; i < m_threadCount; ++i) {
+        QThread* thread = new WorkerThread(this);
+        m_threads << thread;
+        thread->start();
+    }
+}
+
+bool TilePipeline::takeTile(TileProducer::Tile &tile)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_remainingTiles == 0 || m_canceled) {
+        return false;
+    }
+
+    while (m_tiles.isEmpty()) {
+        m_tileAvailable.wait(&m_mutex);
+    }
+    tile = m_tiles.dequeue();
+    --m_remainingTiles;
+    m_spaceAvailable.wakeOne();
+    return true;
+}
+
+void TilePipeline::cancel()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_canceled = true;
+        m_spaceAvailable.wakeAll();
+    }
+
+    for (auto thread: m_threads) {
+        thread->wait();
+    }
+    qDeleteAll(m_threads);
+    m_threads.clear();
+}
+
+int TilePipeline::threadCount() const
+{
+    return m_threadCount;
+}
+
+void TilePipeline::work()
+{
+    // created here, so that its objects live in this thread
+    TileProducer producer(m_pluginManager, m_settings);
+    for (int group = m_nextGroup.fetchAndAddOrdered(1); group < m_groups.size(); group = m_nextGroup.fetchAndAddOrdered(1)) {
+        for (auto const &job: m_groups[group]) {
+            if (!putTile(producer.produce(job.tileId, job.boundaryTile))) {
+                return;
+            }
+        }
+    }
+}
+
+bool TilePipeline::putTile(const TileProducer::Tile &tile)
+{
+    // a few tiles per thread are enough to keep the writer busy
+    int const capacity = 4 * m_threadCount;
+
+    QMutexLocker locker(&m_mutex);
+    while (m_tiles.size() >= capacity && !m_canceled) {
+        m_spaceAvailable.wait(&m_mutex);
+    }
+    if (m_canceled) {
+        return false;
+    }
+    m_tiles.enqueue(tile);
+    m_tileAvailable.wakeOne();
+    return true;
+}
+
+}
@@ -0,0 +1,148 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TILEPRODUCER_H
+#define MARBLE_TILEPRODUCER_H
+
+#include "TileDirectory.h"
+
+#include <TileId.h>
+#include <ParsingRunnerManager.h>
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
+
+class QThread;
+
+namespace Marble {
+
+class PluginManager;
+
+/**
+ * Creates the vector tiles of a region: the OSM data and the landmass are clipped to
+ * the tile, simplified, merged and serialized. Each producer owns its tile directories,
+ * clippers and parsing runners, so producers in different threads don't share any state.
+ */
+class TileProducer
+{
+public:
+    struct Settings
+    {
+        QString cacheDirectory;
+        QString regionDirectory;
+        QString region;
+        QString extension;
+        int maxZoomLevel;
+        bool writeBoundaries;
+        bool mergeTiles;
+    };
+
+    struct Tile
+    {
+        enum Status
+        {
+            Created,
+            Empty,
+            Sea,
+            Failed
+        };
+
+        TileId tileId;
+        Status status;
+        QString name;
+        QByteArray data;
+        double nodeReduction;
+        int originalWays;
+        int mergedWays;
+    };
+
+    TileProducer(const PluginManager *pluginManager, const Settings &settings);
+
+    /**
+     * Creates the tile @p tileId. Unless the tile is empty, its data holds the tile in
+     * the output format. The result only depends on the input data, not on the tiles
+     * produced before.
+     */
+    Tile produce(const TileId &tileId, bool boundaryTile);
+
+    static GeoDataDocument* mergeDocuments(GeoDataDocument* map1, GeoDataDocument* map2);
+
+private:
+    void writeBoundaryTile(GeoDataDocument* tile, const TileId &tileId);
+    QSharedPointer<GeoDataDocument> mergeBoundaryTiles(const QSharedPointer<GeoDataDocument> &background, const TileId &tileId);
+
+    Settings m_settings;
+    ParsingRunnerManager m_manager;
+    TileDirectory m_mapTiles;
+    TileDirectory m_landmass;
+};
+
+/**
+ * Runs TileProducers in several threads. Tiles are handed out in groups of tiles sharing
+ * their source tile, so each thread loads a source tile once. Produced tiles are kept
+ * in a bounded queue until the writer takes them.
+ */
+class TilePipeline
+{
+public:
+    struct Job
+    {
+        TileId tileId;
+        bool boundaryTile;
+    };
+
+    typedef QVector<Job> Group;
+
+    TilePipeline(const PluginManager *pluginManager, const TileProducer::Settings &settings, int threadCount);
+    ~TilePipeline();
+
+    void start(const QVector<Group> &groups);
+
+    /**
+     * Waits for the next tile. Tiles come in no particular order.
+     * @return false once all tiles have been taken
+     */
+    bool takeTile(TileProducer::Tile &tile);
+
+    /**
+     * Stops the threads after the tiles they are working on.
+     */
+    void cancel();
+
+    int threadCount() const;
+
+private:
+    class WorkerThread;
+
+    void work();
+    bool putTile(const TileProducer::Tile &tile);
+
+    Q_DISABLE_COPY(TilePipeline)
+
+    const PluginManager *const m_pluginManager;
+    TileProducer::Settings const m_settings;
+    int const m_threadCount;
+    QVector<Group> m_groups;
+    QAtomicInt m_nextGroup;
+    QMutex m_mutex;
+    QWaitCondition m_tileAvailable;
+    QWaitCondition m_spaceAvailable;
+    QQueue<TileProducer::Tile> m_tiles;
+    int m_remainingTiles;
+    bool m_canceled;
+    QVector<QThread*> m_threads;
+};
+
+}
+
+#endif
@@ -18,10 +18,13 @@
 #include "GeoDataLatLonAltBox.h"
 #include "TileId.h"
 #include "MarbleDirs.h"
+#include "PluginManager.h"
+#include "StyleBuilder.h"
 
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QDebug>
+#include <QFile>
 #include <QFileInfo>
 #include <QDir>
 #include <QString>
@@ -29,6 +32,8 @@
 #include <QSharedPointer>
 #include <QUrl>
 #include <QBuffer>
+#include <QSet>
+#include <QThread>
 
 #include <QMessageLogContext>
 #include <QProcess>
@@ -40,28 +45,12 @@
 #include "TileDirectory.h"
 #include "MbTileWriter.h"
 #include "SpellChecker.h"
+#include "TileProducer.h"
 
 #include <iostream>
 
 using namespace Marble;
 
-GeoDataDocument* mergeDocuments(GeoDataDocument* map1, GeoDataDocument* map2)
-{
-    GeoDataDocument* mergedMap = new GeoDataDocument(*map1);
-
-    OsmPlacemarkData marbleLand;
-    marbleLand.addTag("marble_land","landmass");
-    for (auto placemark: map2->placemarkList()) {
-        GeoDataPlacemark* land = new GeoDataPlacemark(*placemark);
-        if(land->geometry()->nodeType() == GeoDataTypes::GeoDataPolygonType) {
-            land->setOsmData(marbleLand);
-        }
-        mergedMap->append(land);
-    }
-
-    return mergedMap;
-}
-
 QString tileFileName(const QCommandLineParser &parser, int x, int y, int zoomLevel)
 {
     QString const extension = parser.value("extension");
@@ -71,49 +60,21 @@ QString tileFileName(const QCommandLineParser &parser, int x, int y, int zoomLev
     return outputFile;
 }
 
-void writeBoundaryTile(GeoDataDocument* tile, const QString &region, const QCommandLineParser &parser, int x, int y, int zoomLevel)
-{
-    QString const extension = parser.value("extension");
-    QString const outputDir = QString("%1/boundaries/%2/%3/%4").arg(parser.value("cache-directory")).arg(region).arg(zoomLevel).arg(x);
-    QString const outputFile = QString("%1/%2.%3").arg(outputDir).arg(y).arg(extension);
-    QDir().mkpath(outputDir);
-    GeoDataDocumentWriter::write(outputFile, *tile);
-}
-
-QSharedPointer<GeoDataDocument> mergeBoundaryTiles(const QSharedPointer<GeoDataDocument> &background, ParsingRunnerManager &manager, const QCommandLineParser &parser, int x, int y, int zoomLevel)
+bool writeTile(GeoDataDocument* tile, const QString &outputFile)
 {
-    GeoDataDocument* mergedMap = new GeoDataDocument;
-    OsmPlacemarkData marbleLand;
-    marbleLand.addTag("marble_land","landmass");
-    for (auto placemark: background->placemarkList()) {
-        GeoDataPlacemark* land = new GeoDataPlacemark(*placemark);
-        if(land->geometry()->nodeType() == GeoDataTypes::GeoDataPolygonType) {
-            land->setOsmData(marbleLand);
-        }
-        mergedMap->append(land);
-    }
-
-    QString const extension = parser.value("extension");
-    QString const boundaryDir = QString("%1/boundaries").arg(parser.value("cache-directory"));
-    for(auto const &dir: QDir(boundaryDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
-        QString const file = QString("%1/%2/%3/%4/%5.%6").arg(boundaryDir).arg(dir).arg(zoomLevel).arg(x).arg(y).arg(extension);
-        if (QFileInfo(file).exists()) {
-            auto tile = TileDirectory::open(file, manager);
-            if (tile) {
-                for (auto placemark: tile->placemarkList()) {
-                    mergedMap->append(placemark->clone());
-                }
-            }
-        }
+    QDir().mkpath(QFileInfo(outputFile).path());
+    if (!GeoDataDocumentWriter::write(outputFile, *tile)) {
+        qWarning() << "Could not write the file " << outputFile;
+        return false;
     }
-
-    return QSharedPointer<GeoDataDocument>(mergedMap);
+    return true;
 }
 
-bool writeTile(GeoDataDocument* tile, const QString &outputFile)
+bool writeTile(const QByteArray &data, const QString &outputFile)
 {
     QDir().mkpath(QFileInfo(outputFile).path());
-    if (!GeoDataDocumentWriter::write(outputFile, *tile)) {
+    QFile file(outputFile);
+    if (!file.open(QFile::WriteOnly) || file.write(data) != data.size()) {
         qWarning() << "Could not write the file " << outputFile;
         return false;
     }
@@ -134,7 +95,7 @@ int main(int argc, char *argv[])
     parser.addPositionalArgument("input", "The input .osm or .shp file.");
 
     parser.addOptions({
-                          {{"t", "osmconvert"}, "Tile data using osmconvert."},
+                          {{"t", "osmconvert"}, "Tile data using osmconvert instead of the built-in single pass splitter."},
                           {"conflict-resolution", "How to deal with existing tiles: overwrite, skip or merge", "mode", "overwrite"},
                           {{"c", "cache-directory"}, "Directory for temporary data.", "cache", "cache"},
                           {{"m", "mbtile"}, "Store tiles at level 15 onwards in a mbtile database.", "mbtile"},
@@ -144,7 +105,8 @@ int main(int argc, char *argv[])
                           {{"d", "development"}, "Use local development vector osm map theme as output storage"},
                           {{"z", "zoom-level"}, "Zoom level according to which OSM information has to be processed.", "levels", "11,13,15,17"},
                           {{"o", "output"}, "Output file or directory", "output", QString("%1/maps/earth/vectorosm").arg(MarbleDirs::localPath())},
-                          {{"e", "extension"}, "Output file type: o5m (default), osm or kml", "file extension", "o5m"}
+                          {{"e", "extension"}, "Output file type: o5m (default), osm or kml", "file extension", "o5m"},
+                          {{"j", "threads"}, "Number of threads creating tiles, defaults to the number of processor cores", "threads", QString::number(QThread::idealThreadCount())}
                       });
 
     // Process the actual command line arguments given by the user
@@ -236,6 +198,7 @@ int main(int argc, char *argv[])
         QString const regionDir = QString("%1/%2").arg(cacheDirectory).arg(QFileInfo(inputFileName).baseName());
         TileDirectory mapTiles(TileDirectory::OpenStreetMap, regionDir, manager, extension, maxZoomLevel);
         mapTiles.setInputFile(inputFileName);
+        mapTiles.setUseOsmconvert(parser.isSet("osmconvert"));
         mapTiles.createTiles();
         auto const boundingBox = mapTiles.boundingBox();
 
@@ -267,81 +230,96 @@ int main(int argc, char *argv[])
             }
         }
 
+        // Existing tiles are skipped here already, so an interrupted run resumes where it stopped
         qint64 count = 0;
-        for (auto iter = tiles.begin(), end = tiles.end(); iter != end; ++iter) {
+        QVector<TilePipeline::Group> groups;
+        for (auto iter = tiles.cbegin(), end = tiles.cend(); iter != end; ++iter) {
+            TilePipeline::Group group;
             for(auto const &tileId: iter.value()) {
-                ++count;
                 int const zoomLevel = tileId.zoomLevel();
-                QString const filename = tileFileName(parser, tileId.x(), tileId.y(), zoomLevel);
                 if (!overwriteTiles) {
                     if (zoomLevel > 13 && mbtileWriter && mbtileWriter->hasTile(tileId.x(), tileId.y(), zoomLevel)) {
+                        ++count;
                         continue;
-                    } else if (QFileInfo(filename).exists()) {
+                    } else if (QFileInfo(tileFileName(parser, tileId.x(), tileId.y(), zoomLevel)).exists()) {
+                        ++count;
                         continue;
                     }
                 }
+                group << TilePipeline::Job{tileId, boundaryTiles.contains(iter.key())};
+            }
+            if (!group.isEmpty()) {
+                groups << group;
+            }
+        }
 
-                typedef QSharedPointer<GeoDataDocument> GeoDocPtr;
-                GeoDocPtr tile2 = GeoDocPtr(loader.clip(zoomLevel, tileId.x(), tileId.y()));
-                if (tile2->size() > 0) {
-                    GeoDocPtr tile1 = GeoDocPtr(mapTiles.clip(zoomLevel, tileId.x(), tileId.y()));
-                    TagsFilter::removeAnnotationTags(tile1.data());
-                    int originalWays = 0;
-                    int mergedWays = 0;
-                    if (zoomLevel < 17) {
-                        WayConcatenator concatenator(tile1.data());
-                        originalWays = concatenator.originalWays();
-                        mergedWays = concatenator.mergedWays();
-                    }
-                    NodeReducer nodeReducer(tile1.data(), tileId);
-                    if (tile1->size() > 0 && tile2->size() > 0) {
-                        GeoDocPtr combined = GeoDocPtr(mergeDocuments(tile1.data(), tile2.data()));
-
-                        if (writeBoundaries && boundaryTiles.contains(iter.key())) {
-                            writeBoundaryTile(tile1.data(), region, parser, tileId.x(), tileId.y(), zoomLevel);
-                            if (mergeTiles) {
-                                combined = mergeBoundaryTiles(tile2, manager, parser, tileId.x(), tileId.y(), zoomLevel);
-                            }
-                        }
-
-                        if (zoomLevel > 13 && mbtileWriter) {
-                            QBuffer buffer;
-                            buffer.open(QBuffer::ReadWrite);
-                            if (GeoDataDocumentWriter::write(&buffer, *combined, extension)) {
-                                buffer.seek(0);
-                                mbtileWriter->addTile(&buffer, tileId.x(), tileId.y(), zoomLevel);
-                            } else {
-                                qWarning() << "Could not write the tile " << combined->name();
-                            }
-                        } else {
-                            if (!writeTile(combined.data(), filename)) {
-                                return 4;
-                            }
-                        }
-
-                        TileDirectory::printProgress(count / double(total));
-                        std::cout << "  Tile " << count << "/" << total << " (";
-                        std::cout << combined->name().toStdString() << ").";
-                        double const reduction = nodeReducer.removedNodes() / qMax(1.0, double(nodeReducer.remainingNodes() + nodeReducer.removedNodes()));
-                        std::cout << " Node reduction: " << qRound(reduction * 100.0) << "%";
-                        if (originalWays > 0) {
-                            std::cout << " , " << originalWays << " ways merged to " << mergedWays;
-                        }
-                    } else {
-                        TileDirectory::printProgress(count / double(total));
-                        std::cout << "  Skipping empty tile " << count << "/" << total << " (" << tile1->name().toStdString() << ").";
-                    }
-                } else {
-                    TileDirectory::printProgress(count / double(total));
-                    std::cout << "  Skipping sea tile " << count << "/" << total << " (" << tile2->name().toStdString() << ").";
+        // Lazily initialized statics must not be set up concurrently by the worker threads
+        StyleBuilder::osmTagMapping();
+        StyleBuilder::minimumZoomLevel(GeoDataPlacemark::Default);
+        GeoDataPlacemark placemark;
+        StyleBuilder::popularity(&placemark);
+        model.pluginManager()->parsingRunnerPlugins();
+
+        TileProducer::Settings settings;
+        settings.cacheDirectory = cacheDirectory;
+        settings.regionDirectory = regionDir;
+        settings.region = region;
+        settings.extension = extension;
+        settings.maxZoomLevel = maxZoomLevel;
+        settings.writeBoundaries = writeBoundaries;
+        settings.mergeTiles = mergeTiles;
+
+        int const threads = parser.value("threads").toInt();
+        TilePipeline pipeline(model.pluginManager(), settings, threads > 0 ? threads : QThread::idealThreadCount());
+        QElapsedTimer timer;
+        timer.start();
+        pipeline.start(groups);
+
+        qint64 written = 0;
+        TileProducer::Tile tile;
+        while (pipeline.takeTile(tile)) {
+            ++count;
+            TileId const &tileId = tile.tileId;
+            int const zoomLevel = tileId.zoomLevel();
+            TileDirectory::printProgress(count / double(total));
+            switch (tile.status) {
+            case TileProducer::Tile::Created:
+                if (zoomLevel > 13 && mbtileWriter) {
+                    QBuffer buffer(&tile.data);
+                    buffer.open(QBuffer::ReadOnly);
+                    mbtileWriter->addTile(&buffer, tileId.x(), tileId.y(), zoomLevel);
+                } else if (!writeTile(tile.data, tileFileName(parser, tileId.x(), tileId.y(), zoomLevel))) {
+                    pipeline.cancel();
+                    return 4;
                 }
+                ++written;
 
-                std::cout << std::string(20, ' ') << '\r';
-                std::cout.flush();
+                std::cout << "  Tile " << count << "/" << total << " (";
+                std::cout << tile.name.toStdString() << ").";
+                std::cout << " Node reduction: " << qRound(tile.nodeReduction * 100.0) << "%";
+                if (tile.originalWays > 0) {
+                    std::cout << " , " << tile.originalWays << " ways merged to " << tile.mergedWays;
+                }
+                break;
+            case TileProducer::Tile::Empty:
+                std::cout << "  Skipping empty tile " << count << "/" << total << " (" << tile.name.toStdString() << ").";
+                break;
+            case TileProducer::Tile::Sea:
+                std::cout << "  Skipping sea tile " << count << "/" << total << " (" << tile.name.toStdString() << ").";
+                break;
+            case TileProducer::Tile::Failed:
+                qWarning() << "Could not create the tile " << tile.name;
+                break;
             }
+
+            std::cout << std::string(20, ' ') << '\r';
+            std::cout.flush();
         }
         TileDirectory::printProgress(1.0);
         std::cout << "  Vector OSM tiles complete." << std::string(30, ' ') << std::endl;
+        double const seconds = qMax<qint64>(1, timer.elapsed()) / 1000.0;
+        std::cout << written << " tiles written in " << seconds << " s using " << pipeline.threadCount();
+        std::cout << " threads (" << written / seconds << " tiles/s)." << std::endl;
     }
 
     return 0;